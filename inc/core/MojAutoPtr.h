@@ -220,6 +220,7 @@ public:
 	template<class P>
 	MojSharedPtr(const MojSharedPtr<P>& sp) : Base(reinterpret_cast<const MojSharedPtr<T>&>(sp)) { testAssignable((P*) NULL); }
 
+	MojSharedPtr& operator=(const MojSharedPtr& rhs) { Base::operator=(rhs); return *this; }
 	template<class P>
 	MojSharedPtr& operator=(const MojSharedPtr<P>& rhs) { testAssignable((P*) NULL); return operator=(reinterpret_cast<const MojSharedPtr&>(rhs)); }
 private:
@@ -234,6 +235,8 @@ public:
 	MojSharedArrayPtr() : Base() {}
 	MojSharedArrayPtr(const MojSharedArrayPtr& sp) : Base(sp) {}
 	MojSharedArrayPtr(MojSharedPtrRef<T, MojArrayDeleteDtor<T> > ref) : Base(ref) {}
+
+	MojSharedArrayPtr& operator=(const MojSharedArrayPtr& rhs) { Base::operator=(rhs); return *this; }
 };
 
 template<class T>
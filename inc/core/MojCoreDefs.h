@@ -126,6 +126,7 @@ class MojLogEngine;
 class MojMessage;
 class MojMessageDispatcher;
 class MojObject;
+class MojObjectArena;
 class MojObjectBuilder;
 class MojObjectEater;
 class MojObjectReader;
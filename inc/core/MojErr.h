@@ -39,6 +39,7 @@ typedef enum {
 	MojErrNoMem = ENOMEM,
 	MojErrNotFound = ENOENT,
 	MojErrNotImplemented = ENOSYS,
+	MojErrTimedOut = ETIMEDOUT,
 	MojErrWouldBlock = EWOULDBLOCK,
 
 	// INTERNAL ERRORS
@@ -0,0 +1,137 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJFLATHASHMAP_H_
+#define MOJFLATHASHMAP_H_
+
+#include "core/MojCoreDefs.h"
+#include "core/MojComp.h"
+#include "core/MojHasher.h"
+#include "core/MojNoCopy.h"
+
+/**
+ * Open addressing hash map. Entries live inline in a single power-of-two slot
+ * array and collisions probe linearly, so a lookup reads adjacent slots and a
+ * put only allocates when the table grows. Deletes shift the rest of the probe
+ * run back instead of leaving tombstones. Unlike MojHashMap the table is not
+ * shared between copies, iteration order is unspecified and iterators are
+ * invalidated by any put or del. KEY and VAL must be default constructible,
+ * vacant slots hold default values.
+ */
+template <class KEY, class VAL, class LKEY = KEY,
+		  class HASH = MojHasher<LKEY>, class KEQ = MojEq<LKEY> >
+class MojFlatHashMap : private MojNoCopy
+{
+	struct Slot
+	{
+		Slot() : m_hash(0) {}
+
+		MojUInt32 m_hash; // zero when vacant
+		KEY m_key;
+		VAL m_val;
+	};
+public:
+	class Iterator;
+	typedef KEY KeyType;
+	typedef VAL ValueType;
+	typedef LKEY LookupType;
+
+	class ConstIterator
+	{
+		friend class MojFlatHashMap;
+		friend class Iterator;
+	public:
+		ConstIterator() : m_slot(NULL), m_end(NULL) {}
+
+		const KeyType& key() const { MojAssert(m_slot != m_end); return m_slot->m_key; }
+		const ValueType& value() const { MojAssert(m_slot != m_end); return m_slot->m_val; }
+
+		void operator++() { MojAssert(m_slot != m_end); m_slot = skip(m_slot + 1, m_end); }
+		const ConstIterator operator++(int) { return MojPostIncrement(*this); }
+		bool operator==(const ConstIterator& rhs) const { return m_slot == rhs.m_slot; }
+		bool operator!=(const ConstIterator& rhs) const { return m_slot != rhs.m_slot; }
+		const ValueType& operator*() const { return value(); }
+		const ValueType* operator->() const { return &value(); }
+
+	private:
+		ConstIterator(const Slot* slot, const Slot* end) : m_slot(skip(slot, end)), m_end(end) {}
+
+		const Slot* m_slot;
+		const Slot* m_end;
+	};
+
+	class Iterator : public ConstIterator
+	{
+		friend class MojFlatHashMap;
+	public:
+		Iterator() {}
+
+		ValueType& value() const { return const_cast<ValueType&>(ConstIterator::value()); }
+
+		void operator++() { ConstIterator::operator++(); }
+		const Iterator operator++(int) { return MojPostIncrement(*this); }
+		ValueType& operator*() const { return value(); }
+		ValueType* operator->() const { return &value(); }
+
+	private:
+		Iterator(const Slot* slot, const Slot* end) : ConstIterator(slot, end) {}
+	};
+
+	MojFlatHashMap() : m_slots(NULL), m_capacity(0), m_size(0) {}
+	~MojFlatHashMap() { release(); }
+
+	MojSize size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	ConstIterator begin() const { return ConstIterator(m_slots, m_slots + m_capacity); }
+	ConstIterator end() const { return ConstIterator(m_slots + m_capacity, m_slots + m_capacity); }
+
+	MojErr begin(Iterator& iter) { iter = Iterator(m_slots, m_slots + m_capacity); return MojErrNone; }
+	MojErr end(Iterator& iter) { iter = Iterator(m_slots + m_capacity, m_slots + m_capacity); return MojErrNone; }
+
+	void clear() { release(); }
+	void swap(MojFlatHashMap& map);
+	MojErr assign(const MojFlatHashMap& map);
+	MojErr reserve(MojSize numElems);
+
+	bool contains(const LookupType& key) const { return find(key) != end(); }
+	bool get(const LookupType& key, ValueType& valOut) const;
+	MojErr del(const LookupType& key, bool& foundOut);
+	MojErr put(const KeyType& key, const ValueType& val);
+
+	ConstIterator find(const LookupType& key) const;
+	MojErr find(const LookupType& key, Iterator& iter);
+
+private:
+	static const MojSize InitialSize;
+
+	static const Slot* skip(const Slot* slot, const Slot* end) { while (slot != end && !slot->m_hash) ++slot; return slot; }
+	static MojUInt32 hash(const LookupType& key);
+
+	Slot* findSlot(const LookupType& key, MojUInt32 hash) const;
+	Slot* vacantSlot(MojUInt32 hash) const;
+	MojErr rehash(MojSize capacity);
+	void release();
+
+	Slot* m_slots;
+	MojSize m_capacity;
+	MojSize m_size;
+};
+
+#include "core/internal/MojFlatHashMapInternal.h"
+
+#endif /* MOJFLATHASHMAP_H_ */
@@ -0,0 +1,91 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJFLATSET_H_
+#define MOJFLATSET_H_
+
+#include "core/MojCoreDefs.h"
+#include "core/MojComp.h"
+#include "core/MojVector.h"
+
+/**
+ * Ordered set kept as one sorted array. Lookups binary search adjacent memory
+ * and a set costs one allocation rather than a tree node per value, which
+ * suits the small sets built in order on the key paths. Inserting in the
+ * middle moves the tail, so a large set filled in random order should be
+ * built with the range put, which sorts once. Copies share the array until
+ * written, like MojVector. Iterators are invalidated by any put or del.
+ */
+template<class T, class COMP = MojComp<T> >
+class MojFlatSet
+{
+	typedef MojVector<T, MojEq<T>, COMP> Vec;
+public:
+	typedef T ValueType;
+	typedef typename Vec::ConstIterator ConstIterator;
+
+	MojFlatSet() {}
+	MojFlatSet(const MojFlatSet& set) : m_vec(set.m_vec) {}
+
+	MojSize size() const { return m_vec.size(); }
+	bool empty() const { return m_vec.empty(); }
+
+	ConstIterator begin() const { return m_vec.begin(); }
+	ConstIterator end() const { return m_vec.end(); }
+	const ValueType& at(MojSize idx) const { return m_vec.at(idx); }
+
+	void clear() { m_vec.clear(); }
+	void swap(MojFlatSet& set) { m_vec.swap(set.m_vec); }
+	void assign(const MojFlatSet& set) { m_vec.assign(set.m_vec); }
+	int compare(const MojFlatSet& set) const { return m_vec.compare(set.m_vec); }
+	MojErr reserve(MojSize numElems) { return m_vec.reserve(numElems); }
+
+	bool contains(const ValueType& val) const { return find(val) != end(); }
+	MojErr del(const ValueType& val, bool& foundOut);
+	MojErr del(const MojFlatSet& set);
+	MojErr put(const ValueType& val);
+	MojErr put(const MojFlatSet& set);
+	MojErr put(ConstIterator rangeBegin, ConstIterator rangeEnd);
+	MojErr intersect(const MojFlatSet& set);
+
+	ConstIterator find(const ValueType& val) const;
+	ConstIterator lowerBound(const ValueType& val) const;
+
+	MojFlatSet& operator=(const MojFlatSet& rhs) { assign(rhs); return *this; }
+	bool operator==(const MojFlatSet& rhs) const { return size() == rhs.size() && compare(rhs) == 0; }
+	bool operator!=(const MojFlatSet& rhs) const { return !operator==(rhs); }
+	bool operator<(const MojFlatSet& rhs) const { return compare(rhs) < 0; }
+	bool operator<=(const MojFlatSet& rhs) const { return compare(rhs) <= 0; }
+	bool operator>(const MojFlatSet& rhs) const { return compare(rhs) > 0; }
+	bool operator>=(const MojFlatSet& rhs) const { return compare(rhs) >= 0; }
+
+private:
+	enum MergeOp {
+		MergeUnion,
+		MergeDiff,
+		MergeIntersect
+	};
+
+	MojErr merge(const MojFlatSet& set, MergeOp op);
+	MojErr unique();
+
+	Vec m_vec;
+};
+
+#include "core/internal/MojFlatSetInternal.h"
+
+#endif /* MOJFLATSET_H_ */
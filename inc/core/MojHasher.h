@@ -63,8 +63,8 @@ template<>
 struct MojHasher<MojInt64> : public MojIntHasher<MojInt64> {};
 template<>
 struct MojHasher<MojUInt64> : public MojIntHasher<MojUInt64> {};
-template<>
-struct MojHasher<class T*> : public MojIntHasher<T*> {};
+template<class T>
+struct MojHasher<T*> : public MojIntHasher<T*> {};
 template<>
 struct MojHasher<long unsigned int> : public MojIntHasher<long unsigned int> {};
 
@@ -19,6 +19,7 @@
 #define MOJJSONPARSER_H_
 
 #include "core/MojCoreDefs.h"
+#include "core/MojBuffer.h"
 #include "core/MojObject.h"
 
 class MojJsonWriter : public MojObjectVisitor
@@ -52,9 +53,61 @@ private:
 	MojString m_str;
 };
 
+/**
+ * Writes json into a chain of MojBuffer chunks instead of one growing string,
+ * so large replies are never reallocated. Transports that take an iovec can
+ * send buffer() as is; data() makes it one nul-terminated string for the rest.
+ */
+class MojJsonBufferWriter : public MojObjectVisitor
+{
+public:
+	using MojObjectVisitor::propName;
+
+	MojJsonBufferWriter();
+
+	virtual MojErr reset();
+	virtual MojErr beginObject();
+	virtual MojErr endObject();
+	virtual MojErr beginArray();
+	virtual MojErr endArray();
+	virtual MojErr propName(const MojChar* name, MojSize len);
+	virtual MojErr nullValue();
+	virtual MojErr boolValue(bool val);
+	virtual MojErr intValue(MojInt64 val);
+	virtual MojErr decimalValue(const MojDecimal& val);
+	virtual MojErr stringValue(const MojChar* val, MojSize len);
+
+	bool empty() const { return m_buf.empty(); }
+	const MojBuffer& buffer() const { return m_buf; }
+	MojErr json(MojString& strOut) const;
+	// the buffer can't be written to afterwards, until reset
+	MojErr data(const MojChar*& jsonOut);
+
+private:
+	static const MojSize MaxVecs = 64;
+
+	MojErr writeComma();
+
+	bool m_writeComma;
+	MojBuffer m_buf;
+};
+
 class MojJsonParser
 {
 public:
+	// how runs of plain string chars are found; ScanAuto picks the best one the cpu has
+	typedef enum {
+		ScanAuto,
+		ScanScalar,
+		ScanSse2,
+		ScanAvx2
+	} Scan;
+
+	static const MojChar* const ScanAutoName;
+	static const MojChar* const ScanScalarName;
+	static const MojChar* const ScanSse2Name;
+	static const MojChar* const ScanAvx2Name;
+
 	MojJsonParser();
 	~MojJsonParser();
 
@@ -68,6 +121,12 @@ public:
 	MojUInt32 line() { return m_line; }
 	MojUInt32 column() { return m_col; }
 
+	// process-wide, not meant to be switched while other threads parse
+	static MojErr scan(Scan scan);
+	static MojErr scan(const MojChar* name);
+	static Scan scan();
+	static bool supported(Scan scan);
+
 private:
 	static const MojSize MaxDepth = 32;
 
@@ -103,6 +162,7 @@ private:
 	State& state() { return m_stack[m_depth].m_state; }
 	State& savedState() { return m_stack[m_depth].m_savedState; }
 	int hexDigit(MojChar c) { return (c <= _T('9')) ? c - _T('0') : (c & 7) + 9; }
+	MojErr appendRun(const MojChar*& chars, const MojChar* end);
 	MojErr push();
 	void resetRec();
 
@@ -20,18 +20,34 @@
 
 #include "core/MojCoreDefs.h"
 #include "core/MojSignal.h"
+#include "core/MojTime.h"
 
 class MojMessage : public MojSignalHandler
 {
 public:
+	// scheduling class, lower values are more urgent
+	enum Priority {
+		PriorityRead,
+		PriorityWrite,
+		PriorityAdmin,
+		NumPriorities
+	};
+
 	virtual ~MojMessage() {}
 	virtual MojErr dispatch() = 0;
 	virtual const MojChar* queue() const = 0;
 
+	Priority priority() const { return m_priority; }
+	void priority(Priority pri) { m_priority = pri; }
+
 protected:
 	friend class MojMessageDispatcher;
 
+	MojMessage() : m_priority(PriorityWrite) {}
+
 	MojListEntry m_queueEntry;
+	Priority m_priority;
+	MojTime m_scheduleTime;
 };
 
 #endif /* MOJMESSAGE_H_ */
@@ -19,29 +19,66 @@
 #define MOJMESSAGEDISPATCHER_H_
 
 #include "core/MojCoreDefs.h"
+#include "core/MojHashMap.h"
 #include "core/MojMessage.h"
+#include "core/MojObject.h"
 #include "core/MojString.h"
 #include "core/MojThread.h"
 
+/**
+ * Runs messages on a pool of threads.
+ *
+ * Messages with the same queue name (the caller) run one at a time, in order.
+ * Across queues the dispatcher does weighted fair queuing: every queue carries
+ * a virtual time that advances by the time its messages took to run divided by
+ * the weight of their priority class, and the ready queue with the lowest
+ * virtual time goes next. A caller running big finds or dumps therefore falls
+ * behind callers doing quick gets. Idle queues keep their virtual time until
+ * the rest catch up, so sending one request at a time doesn't reset the debt.
+ * Admin messages are also capped to fewer threads than the pool has.
+ *
+ * All threads take work from the same ready list, so there is nothing to steal.
+ */
 class MojMessageDispatcher : private MojNoCopy
 {
 public:
+	static const MojInt32 NumThreadsDefault = 3;
+	static const MojInt32 ReadWeightDefault = 8;
+	static const MojInt32 WriteWeightDefault = 4;
+	static const MojInt32 AdminWeightDefault = 1;
+
+	static const MojChar* const ThreadsKey;
+	static const MojChar* const WeightsKey;
+	static const MojChar* const MaxAdminThreadsKey;
+	static const MojChar* const PriorityNames[MojMessage::NumPriorities];
+
 	MojMessageDispatcher();
 	~MojMessageDispatcher();
 
+	MojErr configure(const MojObject& conf);
+	MojErr classify(const MojChar* method, MojMessage::Priority pri);
+	MojMessage::Priority priority(const MojChar* method) const;
+
 	MojErr schedule(MojMessage* msg);
+	MojErr start() { return start(m_numThreads); }
 	MojErr start(MojInt32 numThreads);
 	MojErr stop();
 	MojErr wait();
 
+	// queue depth, wait and run times per priority class
+	MojErr stats(MojObject& objOut) const;
+
 private:
 	class Queue
 	{
 	public:
 		typedef MojList<MojMessage, &MojMessage::m_queueEntry> MessageList;
 
+		Queue() : m_vtime(0) {}
+
 		bool empty() const { return m_messageList.empty(); }
 		const MojString& name() const { return m_name; }
+		MojMessage::Priority priority() const { return m_messageList.front()->priority(); }
 
 		MojErr init(const MojChar* name) { return m_name.assign(name); }
 		MojRefCountedPtr<MojMessage> pop();
@@ -50,21 +87,45 @@ private:
 		MojString m_name;
 		MojListEntry m_entry;
 		MessageList m_messageList;
+		MojInt64 m_vtime;
+	};
+
+	struct Stats
+	{
+		Stats() : m_depth(0), m_running(0), m_dispatched(0), m_waitTotal(0), m_waitMax(0), m_runTotal(0) {}
+
+		MojSize m_depth;
+		MojSize m_running;
+		MojUInt64 m_dispatched;
+		MojInt64 m_waitTotal;
+		MojInt64 m_waitMax;
+		MojInt64 m_runTotal;
 	};
 
 	typedef MojList<Queue, &Queue::m_entry> QueueList;
 	typedef MojVector<MojThreadT> ThreadVec;
+	typedef MojHashMap<MojString, MojMessage::Priority, const MojChar*> PriorityMap;
 
 	MojErr dispatch(bool& stoppedOut);
+	Queue* next();
+	void finished(Queue* queue, MojMessage::Priority pri, MojInt64 runTime);
+	void pruneIdle();
 
 	static Queue* findQueue(const MojChar* name, QueueList& list);
 	static MojErr threadMain(void* arg);
 
-	MojThreadMutex m_mutex;
+	mutable MojThreadMutex m_mutex;
 	MojThreadCond m_cond;
 	ThreadVec m_threads;
 	QueueList m_scheduledList;
 	QueueList m_pendingList;
+	QueueList m_idleList;
+	PriorityMap m_priorities;
+	MojInt32 m_numThreads;
+	MojInt32 m_maxAdminThreads;
+	MojInt32 m_weights[MojMessage::NumPriorities];
+	MojInt64 m_vclock;
+	Stats m_stats[MojMessage::NumPriorities];
 	bool m_stop;
 };
 
@@ -24,6 +24,11 @@
 #include "core/MojString.h"
 #include "core/MojVector.h"
 
+/**
+ * JSON-like value. Scalars and strings of up to InlineStringMax chars are
+ * stored inline, so only objects, arrays and long strings allocate. Object
+ * and array nodes can come from a MojObjectArena (see there for lifetime rules).
+ */
 class MojObject
 {
 public:
@@ -49,24 +54,26 @@ public:
 	typedef PropMap::ConstIterator ConstIterator;
 	typedef PropMap::Iterator Iterator;
 
-	MojObject() { m_implementation = new UndefinedImpl(); }
-	MojObject(const MojObject& obj) { m_implementation = 0; init(obj); }
-	MojObject(bool val) { m_implementation = new BoolImpl(val); }
-	MojObject(MojInt64 val) { m_implementation = new IntImpl(val); }
-	MojObject(MojInt32 val) { m_implementation = new IntImpl(val); }
-	MojObject(MojUInt32 val) { m_implementation = new IntImpl(val); } //mapped to IntImpl
-	MojObject(const MojDecimal& val) { m_implementation = new DecimalImpl(val); }
-	MojObject(const MojString& val) { m_implementation = new StringImpl(val); }
-	explicit MojObject(Type type) { m_implementation = 0; init(type); }
+	MojObject() : m_type(TypeUndefined), m_len(0) {}
+	MojObject(const MojObject& obj) : m_type(TypeUndefined), m_len(0) { init(obj); }
+	MojObject(bool val) : m_type(TypeBool), m_len(0) { m_val.m_bool = val; }
+	MojObject(MojInt64 val) : m_type(TypeInt), m_len(0) { m_val.m_int = val; }
+	MojObject(MojInt32 val) : m_type(TypeInt), m_len(0) { m_val.m_int = val; }
+	MojObject(MojUInt32 val) : m_type(TypeInt), m_len(0) { m_val.m_int = val; } //mapped to TypeInt
+	MojObject(const MojDecimal& val) : m_type(TypeDecimal), m_len(0) { m_val.m_int = val.rep(); }
+	MojObject(const MojString& val) : m_type(TypeUndefined), m_len(0) { initString(val); }
+	explicit MojObject(Type type) : m_type(TypeUndefined), m_len(0) { init(type, NULL); }
+	// object and array nodes of this value and of values put into it are placed in the arena
+	MojObject(Type type, MojObjectArena* arena) : m_type(TypeUndefined), m_len(0) { init(type, arena); }
 	~MojObject() { release(); }
 
-	inline Type type() const { return impl()->type(); }
+	inline Type type() const { return (Type) m_type; }
 
 	/**
 	 * If object is container, return count of elements in container
 	 * @return how many elements in container
 	 */
-	MojSize size() const { return impl()->containerSize(); }
+	MojSize size() const;
 
 	/**
 	 * If object is container, return if container is null
@@ -74,13 +81,13 @@ public:
 	bool empty() const { return size() == 0; }
 	bool null() const { return type() == TypeNull; }
 	bool undefined() const { return type() == TypeUndefined; }
-	MojSize hashCode() const { return impl()->hashCode(); }
-	MojErr visit(MojObjectVisitor& visitor) const { return impl()->visit(visitor); }
+	MojSize hashCode() const;
+	MojErr visit(MojObjectVisitor& visitor) const;
 
-	bool boolValue() const { return impl()->boolValue(); }
-	MojInt64 intValue() const { return impl()->intValue(); }
-	MojDecimal decimalValue() const { return impl()->decimalValue(); }
-	MojErr stringValue(MojString& valOut) const { return impl()->stringValue(valOut); }
+	bool boolValue() const;
+	MojInt64 intValue() const;
+	MojDecimal decimalValue() const;
+	MojErr stringValue(MojString& valOut) const;
 
 	void clear(Type type = TypeUndefined);
 	MojErr coerce(Type toType);
@@ -94,6 +101,8 @@ public:
 	MojErr toBase64(MojString& strOut) const;
 
 	void assign(const MojObject& val);
+	// copies val with its object and array nodes in arena (heap if NULL)
+	void assign(const MojObject& val, MojObjectArena* arena);
 	int compare(const MojObject& val) const;
 
 	// object-property methods
@@ -107,11 +116,11 @@ public:
 	MojErr putBool(const MojChar* key, bool val) { return put(key, MojObject(val)); }
 	MojErr putInt(const MojChar* key, MojInt64 val) { return put(key, MojObject(val)); }
 	MojErr putDecimal(const MojChar* key, const MojDecimal& val) { return put(key, MojObject(val)); }
-	MojErr del(const MojChar* key, bool& foundOut) { return impl()->del(key, foundOut); }
+	MojErr del(const MojChar* key, bool& foundOut);
 	MojErr find(const MojChar* key, Iterator& iter);
 	ConstIterator find(const MojChar* key) const;
 	bool contains(const MojChar* key) const { return find(key) != end(); }
-	bool get(const MojChar* key, MojObject& valOut) const { return impl()->get(key, valOut); }
+	bool get(const MojChar* key, MojObject& valOut) const;
 	bool get(const MojChar* key, bool& valOut) const;
 	bool get(const MojChar* key, MojInt64& valOut) const;
 	bool get(const MojChar* key, MojDecimal& valOut) const;
@@ -129,14 +138,14 @@ public:
 	MojErr getRequired(const MojChar* key, MojString& valOut) const;
 
 	// array methods
-	MojErr arrayBegin(ArrayIterator& iter) { return impl()->arrayBegin(iter); }
-	ConstArrayIterator arrayBegin() const { return impl()->arrayBegin(); }
-	ConstArrayIterator arrayEnd() const { return impl()->arrayEnd(); }
+	MojErr arrayBegin(ArrayIterator& iter);
+	ConstArrayIterator arrayBegin() const { return (m_type == TypeArray) ? m_val.m_arr->m_vec.begin() : NULL; }
+	ConstArrayIterator arrayEnd() const { return (m_type == TypeArray) ? m_val.m_arr->m_vec.end() : NULL; }
 	MojErr push(const MojObject& val);
 	MojErr pushString(const MojChar* val);
     MojErr delString(MojSize idx);
 	MojErr setAt(MojSize idx, const MojObject& val);
-	bool at(MojSize idx, MojObject& objOut) const { return impl()->at(idx, objOut); }
+	bool at(MojSize idx, MojObject& objOut) const;
 	bool at(MojSize idx, bool& valOut) const;
 	bool at(MojSize idx, MojInt64& valOut) const;
 	bool at(MojSize idx, MojDecimal& valOut) const;
@@ -151,176 +160,65 @@ public:
 	bool operator>=(const MojObject& rhs) const { return compare(rhs) >= 0; }
 
 private:
-	class Impl
-	{
-	public:
-		virtual ~Impl() {}
-		virtual Type type() const = 0;
-		virtual Impl* clone() const = 0;
-		virtual int compare (const Impl& rhs) const = 0;
-		virtual bool equals(const Impl& rhs) const = 0;
-		virtual MojSize hashCode() const = 0;
-		virtual MojSize objectSize() const = 0;
-		virtual MojSize containerSize() const { return 0; }
-		virtual bool boolValue() const { return false; }
-		virtual MojInt64 intValue() const { return 0; }
-		virtual MojDecimal decimalValue() const { return MojDecimal(); }
-		virtual MojErr stringValue(MojString& valOut) const;
-		virtual MojErr visit(MojObjectVisitor& visitor) const = 0;
-		virtual const PropMap* map() const { return NULL; }
-		virtual bool get(const MojChar* key, MojObject& valOut) const;
-		virtual MojErr del(const MojChar* key, bool& foundOut);
-		virtual MojErr arrayBegin(ArrayIterator& iter) { iter = NULL; return MojErrNone; }
-		virtual ConstArrayIterator arrayBegin() const { return NULL; }
-		virtual ConstArrayIterator arrayEnd() const { return NULL; }
-		virtual bool at(MojSize idx, MojObject& objOut) const { objOut.clear(); return false; }
-	};
-	class NullImpl : public Impl
-	{
-	public:
-		virtual Type type() const { return TypeNull; }
-		virtual Impl* clone() const { return new NullImpl(); }
-		virtual int compare (const Impl& rhs) const;
-		virtual bool equals(const Impl& rhs) const;
-		virtual MojSize hashCode() const;
-		virtual MojErr visit(MojObjectVisitor& visitor) const;
-		virtual MojSize objectSize() const { return sizeof(NullImpl); }
-		inline virtual ~NullImpl(){}
-	};
-	class UndefinedImpl : public NullImpl
+	// strings up to this length are stored in the object itself
+	static const MojSize InlineStringMax = 16;
+	static const MojByte HeapString = 0xFF;
+
+	// object and array values live in a node, owned by the value (no sharing)
+	struct Node
 	{
-	public:
-		virtual Type type() const { return TypeUndefined; }
-		virtual Impl* clone() const { return new UndefinedImpl(); }
-		virtual MojSize hashCode() const;
-		virtual MojSize objectSize() const  { return sizeof(UndefinedImpl); }
+		Node(MojObjectArena* arena) : m_arena(arena) {}
+		MojObjectArena* m_arena;
 	};
-	class ObjectImpl : public Impl
+	struct ObjectNode : public Node
 	{
-	public:
-		virtual Type type() const { return TypeObject; }
-		virtual Impl* clone() const { return new  ObjectImpl(*this); }
-		virtual int compare (const Impl& rhs) const;
-		virtual bool equals(const Impl& rhs) const;
-		virtual MojSize hashCode() const;
-		virtual MojSize containerSize() const;
-		virtual bool boolValue() const;
-		virtual MojErr visit(MojObjectVisitor& visitor) const;
-		virtual const PropMap* map() const;
-		virtual bool get(const MojChar* key, MojObject& valOut) const;
-		virtual MojErr del(const MojChar* key, bool& foundOut);
-		virtual MojSize objectSize() const  { return sizeof(ObjectImpl); }
-
+		ObjectNode(MojObjectArena* arena) : Node(arena) {}
 		PropMap m_props;
 	};
-	class ArrayImpl : public Impl
+	struct ArrayNode : public Node
 	{
-	public:
-		virtual Type type() const { return TypeArray; }
-		virtual Impl* clone() const { return new ArrayImpl(*this); }
-		virtual int compare (const Impl& rhs) const;
-		virtual bool equals(const Impl& rhs) const;
-		virtual MojSize hashCode() const;
-		virtual MojSize containerSize() const;
-		virtual bool boolValue() const;
-		virtual MojErr visit(MojObjectVisitor& visitor) const;
-		virtual MojErr arrayBegin(ArrayIterator& iter);
-		virtual ConstArrayIterator arrayBegin() const;
-		virtual ConstArrayIterator arrayEnd() const;
-		virtual bool at(MojSize idx, MojObject& objOut) const;
-		virtual MojSize objectSize() const  { return sizeof(ArrayImpl); }
-
+		ArrayNode(MojObjectArena* arena) : Node(arena) {}
 		ObjectVec m_vec;
 	};
-	class StringImpl : public Impl
-	{
-	public:
-		StringImpl() {}
-		StringImpl(const MojString& str) : m_val(str) {}
-		virtual Type type() const { return TypeString; }
-		virtual Impl* clone() const { return new StringImpl(*this); }
-		virtual int compare (const Impl& rhs) const;
-		virtual bool equals(const Impl& rhs) const;
-		virtual MojSize hashCode() const;
-		virtual bool boolValue() const;
-		virtual MojInt64 intValue() const;
-		virtual MojDecimal decimalValue() const;
-		virtual MojErr stringValue(MojString& valOut) const;
-		virtual MojErr visit(MojObjectVisitor& visitor) const;
-		virtual MojSize objectSize() const  { return sizeof(StringImpl); }
-
-		MojString m_val;
-	};
-	class BoolImpl : public Impl
+	union Value
 	{
-	public:
-		BoolImpl() : m_val(false) {}
-		BoolImpl(bool val) : m_val(val) {}
-		virtual Type type() const { return TypeBool; }
-		virtual Impl* clone() const { return new BoolImpl(*this); }
-		virtual int compare (const Impl& rhs) const;
-		virtual bool equals(const Impl& rhs) const;
-		virtual MojSize hashCode() const;
-		virtual bool boolValue() const { return m_val; }
-		virtual MojInt64 intValue() const { return m_val; }
-		virtual MojDecimal decimalValue() const { return MojDecimal(m_val, 0); }
-		virtual MojErr visit(MojObjectVisitor& visitor) const;
-		virtual MojSize objectSize() const  { return sizeof(BoolImpl); }
-
-		bool m_val;
-	};
-	class DecimalImpl : public Impl
-	{
-	public:
-		DecimalImpl() {}
-		DecimalImpl(const MojDecimal& val) : m_val(val) {}
-		virtual Type type() const { return TypeDecimal; }
-		virtual Impl* clone() const { return new DecimalImpl(*this); }
-		virtual int compare (const Impl& rhs) const;
-		virtual bool equals(const Impl& rhs) const;
-		virtual MojSize hashCode() const;
-		virtual bool boolValue() const { return m_val.rep() != 0; }
-		virtual MojInt64 intValue() const { return m_val.magnitude(); }
-		virtual MojDecimal decimalValue() const { return m_val; }
-		virtual MojErr visit(MojObjectVisitor& visitor) const;
-		virtual MojSize objectSize() const  { return sizeof(DecimalImpl); }
-
-		MojDecimal m_val;
-	};
-	class IntImpl : public Impl
-	{
-	public:
-		IntImpl() : m_val(0) {}
-		IntImpl(MojInt64 val) : m_val(val) {}
-		virtual Type type() const { return TypeInt; }
-		virtual Impl* clone() const { return new IntImpl(*this); }
-		virtual int compare (const Impl& rhs) const;
-		virtual bool equals(const Impl& rhs) const;
-		virtual MojSize hashCode() const;
-		virtual bool boolValue() const { return m_val != 0; }
-		virtual MojInt64 intValue() const { return m_val; }
-		virtual MojDecimal decimalValue() const { return MojDecimal(m_val); }
-		virtual MojErr visit(MojObjectVisitor& visitor) const;
-		virtual MojSize objectSize() const  { return sizeof(IntImpl); }
-
-		MojInt64 m_val;
+		bool m_bool;
+		MojInt64 m_int; // also the rep of decimals
+		MojString* m_str;
+		ObjectNode* m_obj;
+		ArrayNode* m_arr;
+		MojChar m_chars[InlineStringMax];
 	};
 
-    MojObject(const MojChar*); // avoid coercion for illegal assignment
-	void init(Type type);
-	void init(const MojObject& obj);
+	MojObject(const MojChar*); // avoid coercion for illegal assignment
+	void init(Type type, MojObjectArena* arena);
+	void init(const MojObject& obj) { init(obj, NULL); }
+	void init(const MojObject& obj, MojObjectArena* arena);
+	void take(MojObject& obj);
+	void initString(const MojString& str);
 	void release();
-	ObjectImpl& ensureObject();
-	ArrayImpl& ensureArray();
-	Impl* impl() { return m_implementation; }
-	const Impl* impl() const { return m_implementation; }
+	ObjectNode& ensureObject();
+	ArrayNode& ensureArray();
+	const MojChar* chars() const { return (m_len == HeapString) ? m_val.m_str->data() : m_val.m_chars; }
+	MojSize length() const { return (m_len == HeapString) ? m_val.m_str->length() : m_len; }
+
+	static MojErr putProp(ObjectNode& node, const MojString& key, const MojObject& val);
+	static MojErr setElem(ArrayNode& node, MojSize idx, const MojObject& val);
+	static MojErr copyNode(const ObjectNode& src, ObjectNode& dest);
+	static MojErr copyNode(const ArrayNode& src, ArrayNode& dest);
 
+	template<class T>
+	static T* allocNode(MojObjectArena* arena);
+	template<class T>
+	static void freeNode(T* node);
 	template<class T>
 	MojErr getRequiredT(const MojChar* key, T& valOut) const;
 	template<class T>
 	MojErr getRequiredErrT(const MojChar* key, T& valOut) const;
 
-	Impl* m_implementation;
+	Value m_val;
+	MojByte m_type;
+	MojByte m_len; // inline string length, or HeapString
 };
 
 class MojObjectVisitor : private MojNoCopy
@@ -370,7 +268,7 @@ public:
 template<>
 struct MojComp<const MojObject>
 {
-	int operator()(const MojObject& val1, const MojObject& val2)
+	int operator()(const MojObject& val1, const MojObject& val2) const
 	{
 		return val1.compare(val2);
 	}
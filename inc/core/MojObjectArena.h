@@ -0,0 +1,68 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJOBJECTARENA_H_
+#define MOJOBJECTARENA_H_
+
+#include "core/MojCoreDefs.h"
+
+/**
+ * Bump allocator for the object and array nodes of MojObjects that are built
+ * and thrown away together (e.g. everything that goes into one response).
+ *
+ * Nodes are never freed one by one; the memory goes away with clear() or the
+ * arena itself, and is reused once every node taken from the arena is gone,
+ * so no object built in the arena may outlive it. Plain copies of such an
+ * object are deep copies on the heap and stay valid after clear(); values
+ * put into an arena-backed object are copied into its arena. Not thread-safe.
+ */
+class MojObjectArena : private MojNoCopy
+{
+public:
+	static const MojSize ChunkSize = 8 * 1024;
+
+	MojObjectArena();
+	~MojObjectArena();
+
+	void* alloc(MojSize size);
+	void clear();
+
+	void nodeCreated() { ++m_nodes; }
+	void nodeDestroyed() { MojAssert(m_nodes > 0); --m_nodes; }
+	MojSize nodes() const { return m_nodes; }
+	MojSize used() const { return m_used; }
+	MojSize reserved() const { return m_reserved; }
+
+private:
+	struct Chunk
+	{
+		Chunk* m_next;
+		MojSize m_size;
+	};
+	static const MojSize HeaderSize = (sizeof(Chunk) + 7) & ~((MojSize) 7);
+
+	void rewind();
+
+	Chunk* m_chunks;
+	MojByte* m_pos;
+	MojByte* m_end;
+	MojSize m_nodes;
+	MojSize m_used;
+	MojSize m_reserved;
+};
+
+#endif /* MOJOBJECTARENA_H_ */
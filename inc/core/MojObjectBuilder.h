@@ -25,7 +25,7 @@
 class MojObjectBuilder : public MojObjectVisitor
 {
 public:
-	MojObjectBuilder();
+	MojObjectBuilder(MojObjectArena* arena = NULL);
 
 	virtual MojErr reset();
 	virtual MojErr beginObject();
@@ -41,11 +41,13 @@ public:
 
 	const MojObject& object() const { return m_obj; }
 	MojObject& object() { return m_obj; }
+	// objects and arrays built from now on take their nodes from the arena
+	void arena(MojObjectArena* arena) { m_arena = arena; }
 
 private:
 	struct Rec
 	{
-		Rec(MojObject::Type type, MojString& propName) : m_obj(type), m_propName(propName) {}
+		Rec(MojObject::Type type, MojObjectArena* arena, MojString& propName) : m_obj(type, arena), m_propName(propName) {}
 		MojObject m_obj;
 		MojString m_propName;
 	};
@@ -57,6 +59,7 @@ private:
 	MojObject& back() { return m_stack.top().m_obj; }
 
 	ObjStack m_stack;
+	MojObjectArena* m_arena;
 	MojObject m_obj;
 	MojString m_propName;
 };
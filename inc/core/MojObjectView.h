@@ -0,0 +1,100 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJOBJECTVIEW_H_
+#define MOJOBJECTVIEW_H_
+
+#include "core/MojCoreDefs.h"
+#include "core/MojObject.h"
+#include "core/MojObjectSerialization.h"
+
+/**
+ * Read-only view of an object that is either a MojObject tree or a buffer in
+ * MojObjectWriter format.
+ *
+ * A serialized view walks the buffer in place and only decodes the props that
+ * are asked for, resolving tokenized names through the token set. Nothing is
+ * copied, so the buffer (and token set) must outlive the view and every view
+ * derived from it. An optional header object overlays props that live outside
+ * the body (e.g. _id and _rev on stored records).
+ */
+class MojObjectView
+{
+public:
+	class ConstIterator;
+
+	MojObjectView();
+	MojObjectView(const MojObject& obj);
+	MojObjectView(const MojByte* data, MojSize size, MojTokenSet* tokenSet = NULL, const MojObject* header = NULL);
+
+	MojObject::Type type() const;
+	bool null() const { return type() == MojObject::TypeNull; }
+	bool undefined() const { return type() == MojObject::TypeUndefined; }
+	bool serialized() const { return m_begin != NULL; }
+	const MojObject* object() const { return m_obj; }
+
+	MojErr boolValue(bool& valOut) const;
+	MojErr intValue(MojInt64& valOut) const;
+	MojErr decimalValue(MojDecimal& valOut) const;
+	MojErr stringValue(MojString& valOut) const;
+
+	MojErr get(const MojChar* key, MojObjectView& valOut, bool& foundOut) const;
+	MojErr begin(ConstIterator& iterOut) const;
+	MojErr visit(MojObjectVisitor& visitor) const;
+	MojErr toObject(MojObject& objOut) const;
+
+	static MojErr skipValue(MojDataReader& reader);
+
+private:
+	friend class ConstIterator;
+
+	static MojErr readName(MojDataReader& reader, const MojTokenSet* tokenSet, MojString& nameOut);
+	MojByte marker() const { return *m_begin; }
+
+	const MojObject* m_obj;
+	const MojByte* m_begin;
+	const MojByte* m_end;
+	MojTokenSet* m_tokenSet;
+	const MojObject* m_header;
+};
+
+/**
+ * Iterates props of an object view (key is set) or elements of an array
+ * view (key is empty).
+ */
+class MojObjectView::ConstIterator
+{
+public:
+	ConstIterator() : m_arrayIter(NULL), m_pos(NULL) {}
+
+	MojErr next(bool& foundOut);
+	const MojString& key() const { return m_key; }
+	const MojObjectView& value() const { return m_val; }
+
+private:
+	friend class MojObjectView;
+
+	MojObjectView m_view;
+	MojObject::ConstIterator m_propIter;
+	MojObject::ConstArrayIterator m_arrayIter;
+	MojObject::ConstIterator m_headerIter;
+	const MojByte* m_pos;
+	MojString m_key;
+	MojObjectView m_val;
+};
+
+#endif /* MOJOBJECTVIEW_H_ */
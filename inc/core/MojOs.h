@@ -363,6 +363,7 @@ MojErr MojThreadCondDestroy(MojThreadCondT* cond);
 MojErr MojThreadCondSignal(MojThreadCondT* cond);
 MojErr MojThreadCondBroadcast(MojThreadCondT* cond);
 MojErr MojThreadCondWait(MojThreadCondT* cond, MojThreadMutexT* mutex);
+MojErr MojThreadCondTimedWait(MojThreadCondT* cond, MojThreadMutexT* mutex, const MojTimespecT* deadline);
 
 MojErr MojThreadRwLockInit(MojThreadRwLockT* lock);
 MojErr MojThreadRwLockDestroy(MojThreadRwLockT* lock);
@@ -69,7 +69,7 @@ public:
 	MojSchema();
 	~MojSchema();
 
-	void clear() { m_rule.reset(); }
+	void clear() { m_program.reset(); }
 	MojErr fromObject(const MojObject& obj);
 	MojErr validate(const MojObject& obj, Result& resOut) const;
 
@@ -78,216 +78,116 @@ public:
 private:
 	static const MojChar* const InvalidSchemaPrefix;
 
-	class Rule : public MojRefCounted
-	{
-	public:
-		Rule(MojSchema* schema) : m_schema(schema) {}
-		virtual ~Rule() {}
-		virtual MojErr fromObject(const MojObject& obj) { return MojErrNone; }
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const = 0;
-
-	protected:
-		MojSchema* m_schema;
-	};
-
-	class SchemaRule : public Rule
-	{
-	public:
-		SchemaRule(MojSchema* schema);
-
-		bool optional() const { return m_optional; }
-
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	protected:
-		typedef MojVector<MojRefCountedPtr<Rule> > RuleVec;
-
-		MojErr addRule(MojRefCountedPtr<Rule> rule, const MojObject& obj);
-
-		RuleVec m_rules;
-		bool m_optional;
-	};
-
-	class SimpleTypeRule : public Rule
-	{
-	public:
-		SimpleTypeRule(MojSchema* schema) : Rule(schema) {}
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		typedef MojVector<MojObject::Type> TypeVec;
-
-		TypeVec m_types;
-	};
-
-	class UnionTypeRule : public SchemaRule
-	{
-	public:
-		UnionTypeRule(MojSchema* schema) : SchemaRule(schema) {}
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		bool valid(const MojObject& val) const;
-	};
-
-	class SimpleDisallowRule : public SimpleTypeRule
-	{
-	public:
-		SimpleDisallowRule(MojSchema* schema) : SimpleTypeRule(schema) {}
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-	};
-
-	class UnionDisallowRule : public UnionTypeRule
-	{
-	public:
-		UnionDisallowRule(MojSchema* schema) : UnionTypeRule(schema) {}
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-	};
-
-	class AdditionalPropertiesRule : public Rule
-	{
-	public:
-		AdditionalPropertiesRule(MojSchema* schema);
-
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		MojRefCountedPtr<SchemaRule> m_schemaRule;
-		bool m_allowAdditional;
-	};
-
-	class PropertiesRule : public Rule
-	{
-	public:
-		PropertiesRule(MojSchema* schema) : Rule(schema) {}
-		void additionalProperties(AdditionalPropertiesRule* rule) { m_additionalRule.reset(rule); }
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		typedef MojMap<MojString, MojRefCountedPtr<SchemaRule> > PropMap;
+	class Pattern;
 
-		PropMap m_props;
-		MojRefCountedPtr<AdditionalPropertiesRule> m_additionalRule;
-	};
-
-	class SimpleItemsRule : public Rule
-	{
-	public:
-		SimpleItemsRule(MojSchema* schema) : Rule(schema) {}
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		MojRefCountedPtr<SchemaRule> m_schemaRule;
-	};
-
-	class TupleItemsRule : public UnionTypeRule
-	{
-	public:
-		TupleItemsRule(MojSchema* schema) : UnionTypeRule(schema) {}
-		void additionalProperties(AdditionalPropertiesRule* rule) { m_additionalRule.reset(rule); }
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		MojRefCountedPtr<AdditionalPropertiesRule> m_additionalRule;
-	};
-
-	class RequiresRule : public Rule
+	/**
+	 * A schema compiled into flat instructions.
+	 *
+	 * Every (sub)schema is a block, a contiguous run of ops checked in order
+	 * until one fails. Property names, nested schemas, enum sets and regexes
+	 * are resolved once at compile time into the side tables the ops index, so
+	 * validation is a switch over the ops of a block and only descends into
+	 * another block for a nested value or a union alternative.
+	 */
+	class Program : public MojRefCounted
 	{
 	public:
-		RequiresRule(MojSchema* schema) : Rule(schema) {}
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		MojString m_requiredProp;
-	};
+		static const MojUInt32 NoBlock = 0xFFFFFFFF;
 
-        class PatternRule;
+		Program(MojSchema* schema);
+		~Program();
 
-	template<class COMP1, class COMP2>
-	class CompRule : public Rule
-	{
-	public:
-		CompRule(MojSchema* schema);
-		void canEqual(bool val) { m_canEqual = val; }
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		MojDecimal m_val;
-		bool m_canEqual;
-	};
-	typedef CompRule<MojLessThanEq<MojDecimal>, MojLessThan<MojDecimal> > MaxRule;
-	typedef CompRule<MojGreaterThanEq<MojDecimal>, MojGreaterThan<MojDecimal> > MinRule;
-
-	template<class COMP>
-	class ArrayLenRule : public Rule
-	{
-	public:
-		ArrayLenRule(MojSchema* schema) : Rule(schema), m_val(0) {}
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		MojInt64 m_val;
-	};
-	typedef ArrayLenRule<MojLessThanEq<MojInt64> > MaxItemsRule;
-	typedef ArrayLenRule<MojGreaterThanEq<MojInt64> > MinItemsRule;
-
-	class UniqueItemsRule : public Rule
-	{
-	public:
-		UniqueItemsRule(MojSchema* schema) : Rule(schema) {}
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-	};
-
-	template<class COMP>
-	class StringLenRule : public Rule
-	{
-	public:
-		StringLenRule(MojSchema* schema) : Rule(schema), m_val(0) {}
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
-
-	private:
-		MojInt64 m_val;
-	};
-	typedef StringLenRule<MojLessThanEq<MojInt64> > MaxLenRule;
-	typedef StringLenRule<MojGreaterThanEq<MojInt64> > MinLenRule;
-
-	class EnumRule : public Rule
-	{
-	public:
-		EnumRule(MojSchema* schema);
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
+		MojErr compile(const MojObject& obj, MojUInt32& blockOut);
+		MojErr validate(MojUInt32 block, const MojObject& val, const MojObject& parent, Result& resOut) const;
 
 	private:
+		enum OpCode {
+			OpType,          // m_int: mask of allowed types
+			OpDisallowType,  // m_int: mask of disallowed types
+			OpUnion,         // m_begin, m_count: alternative blocks in m_children
+			OpDisallowUnion, // m_begin, m_count: alternative blocks in m_children
+			OpProperties,    // m_begin, m_count: m_props, m_allow/m_block: additional props
+			OpItems,         // m_block: item schema
+			OpTuple,         // m_begin, m_count: item blocks in m_children, m_allow/m_block: additional items
+			OpPattern,       // m_begin: m_patterns
+			OpRequires,      // m_begin: m_names
+			OpMinimum,       // m_dec, m_canEqual
+			OpMaximum,       // m_dec, m_canEqual
+			OpMinItems,      // m_int
+			OpMaxItems,      // m_int
+			OpUniqueItems,
+			OpMinLength,     // m_int
+			OpMaxLength,     // m_int
+			OpEnum,          // m_begin: m_enums
+			OpDivisibleBy    // m_int
+		};
+
+		struct Op
+		{
+			Op(OpCode code = OpType)
+			: m_code(code), m_begin(0), m_count(0), m_block(NoBlock), m_int(0), m_allow(true), m_canEqual(true) {}
+
+			OpCode m_code;
+			MojUInt32 m_begin;
+			MojUInt32 m_count;
+			MojUInt32 m_block;
+			MojInt64 m_int;
+			MojDecimal m_dec;
+			bool m_allow;
+			bool m_canEqual;
+		};
+
+		struct Block
+		{
+			Block() : m_begin(0), m_end(0), m_optional(true) {}
+
+			MojUInt32 m_begin;
+			MojUInt32 m_end;
+			bool m_optional;
+		};
+
+		struct Prop
+		{
+			Prop() : m_block(NoBlock) {}
+
+			MojString m_name;
+			MojUInt32 m_block;
+		};
+
+		typedef MojVector<Op> OpVec;
+		typedef MojVector<Block> BlockVec;
+		typedef MojVector<Prop> PropVec;
+		typedef MojVector<MojUInt32> IndexVec;
+		typedef MojVector<MojString> StringVec;
 		typedef MojSet<MojObject> ObjectSet;
+		typedef MojVector<ObjectSet> EnumVec;
+		typedef MojVector<MojRefCountedPtr<Pattern> > PatternVec;
 
-		ObjectSet m_vals;
-	};
+		static MojErr typeMask(const MojObject& obj, MojInt64& maskOut);
 
-	class DivisibleRule : public Rule
-	{
-	public:
-		DivisibleRule(MojSchema* schema) : Rule(schema), m_val(0) {}
-		virtual MojErr fromObject(const MojObject& obj);
-		virtual MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const;
+		MojErr compileType(const MojObject& obj, OpCode code, OpVec& ops);
+		MojErr compileAlternatives(const MojObject& obj, Op& op);
+		MojErr compileAdditional(const MojObject& obj, Op& op);
+		MojErr compileProperties(const MojObject& obj, Op& op);
+		MojErr compileEnum(const MojObject& obj, Op& op);
 
-	private:
-		typedef MojSet<MojObject> ObjectSet;
+		MojErr validateUnion(const Op& op, const MojObject& val, const MojObject& parent, Result& resOut) const;
+		MojErr validateAdditional(const Op& op, const MojObject& val, const MojObject& parent, Result& resOut) const;
+		MojErr validateProperties(const Op& op, const MojObject& val, Result& resOut) const;
+		MojErr validateTuple(const Op& op, const MojObject& val, Result& resOut) const;
 
-		MojInt64 m_val;
+		MojSchema* m_schema;
+		OpVec m_ops;
+		BlockVec m_blocks;
+		PropVec m_props;
+		IndexVec m_children;
+		StringVec m_names;
+		EnumVec m_enums;
+		PatternVec m_patterns;
 	};
 
-	MojRefCountedPtr<Rule> m_rule;
+	MojRefCountedPtr<Program> m_program;
+	MojUInt32 m_root;
 	StringSet m_strings;
 };
 
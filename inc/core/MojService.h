@@ -111,6 +111,8 @@ public:
 	virtual MojErr createRequest(MojRefCountedPtr<MojServiceRequest>& reqOut) = 0;
 	virtual MojErr dispatch() = 0; // for test purposes only
 
+	MojMessageDispatcher* dispatcher() const { return m_dispatcher; }
+
 protected:
 	friend class MojServiceMessage;
 	friend class MojServiceRequest;
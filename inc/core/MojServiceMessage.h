@@ -36,6 +36,7 @@ public:
 
 	MojSize numReplies() const { return m_numReplies; }
 	MojService::Category* serviceCategory() const { return m_category; }
+	MojService* service() const { return m_service; }
 	bool subscribed() const { return m_subscribed; }
 	bool fixmode() const { return m_fixmode; }
 	void fixmode(bool bVal) { m_fixmode = bVal; }
@@ -52,6 +53,8 @@ public:
 	virtual MojErr payload(MojObject& objOut) const = 0;
 	virtual Token token() const = 0;
 	virtual bool hasData() const = 0;
+	// reply written so far, for logging
+	virtual MojString replyJson() const { return MojString(); }
 
 	void notifyCancel(CancelSignal::SlotRef cancelHandler);
 
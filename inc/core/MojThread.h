@@ -20,6 +20,9 @@
 
 #include "core/MojCoreDefs.h"
 #include "core/MojAtomicInt.h"
+#include "core/MojTime.h"
+
+#include <atomic>
 
 class MojThreadMutex : private MojNoCopy
 {
@@ -77,11 +80,75 @@ public:
 	MojErr signal() { return MojThreadCondSignal(&m_cond); }
 	MojErr broadcast() { return MojThreadCondBroadcast(&m_cond); }
 	MojErr wait(MojThreadMutex& mutex);
+	// deadline is absolute wall-clock time, returns MojErrTimedOut when it passes
+	MojErr timedWait(MojThreadMutex& mutex, const MojTime& deadline);
 
 private:
 	MojThreadCondT m_cond;
 };
 
+/**
+ * Reader/writer lock for state that is read by every request and changed
+ * rarely, like the kind catalog behind the db schema lock.
+ *
+ * A reader announces itself in one of a fixed set of counters, picked per
+ * thread and each on cache lines of its own, so readers on different threads
+ * never write shared memory. A writer marks the lock pending, blocks until the
+ * counters drain and then marks it held, readers arriving while it is held
+ * step back out of their counter and wait, so all of the coordination cost is
+ * paid by the writer. Readers only touch the mutex when they leave while a
+ * writer waits, to wake it. As with the default pthread rwlock, readers are
+ * preferred: a reader never waits for a merely pending writer, so nested read
+ * locks on one thread can't deadlock against one.
+ *
+ * Taking a read lock on the thread that holds the write lock deadlocks, the
+ * reader waits for the held state to clear.
+ */
+class MojThreadEpochLock : private MojNoCopy
+{
+public:
+	MojThreadEpochLock();
+	~MojThreadEpochLock();
+
+	void readLock();
+	void writeLock();
+	void unlock();
+
+#ifdef MOJ_DEBUG
+	MojThreadIdT writer() const { return m_writer; }
+#endif
+
+private:
+	static const MojSize NumSlots = 32;
+	// counters two cache lines apart share neither a line nor an adjacent-line prefetch
+	static const MojSize SlotSize = 128;
+
+	enum State {
+		StateFree,
+		StatePending,
+		StateHeld
+	};
+
+	struct Slot
+	{
+		std::atomic<MojInt32> m_readers;
+		MojByte m_pad[SlotSize - sizeof(std::atomic<MojInt32>)];
+	};
+
+	static MojSize slotIndex();
+	MojInt64 readers() const;
+	void leave(std::atomic<MojInt32>& readers);
+	void setState(State state);
+
+	Slot m_slots[NumSlots];
+	std::atomic<MojInt32> m_state;
+	MojThreadIdT m_writer;
+	MojThreadMutex m_writeMutex;
+	MojThreadMutex m_mutex;
+	MojThreadCond m_cond;
+	MojThreadCond m_writerCond;
+};
+
 class MojThreadGuard : private MojNoCopy
 {
 public:
@@ -130,6 +197,16 @@ private:
 	bool m_locked;
 };
 
+class MojThreadEpochWriteGuard : private MojNoCopy
+{
+public:
+	MojThreadEpochWriteGuard(MojThreadEpochLock& lock) : m_lock(lock) { lock.writeLock(); }
+	~MojThreadEpochWriteGuard() { m_lock.unlock(); }
+
+private:
+	MojThreadEpochLock& m_lock;
+};
+
 template <class T>
 struct MojThreadLocalValueDefaultCtor
 {
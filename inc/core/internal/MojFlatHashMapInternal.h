@@ -0,0 +1,211 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJFLATHASHMAPINTERNAL_H_
+#define MOJFLATHASHMAPINTERNAL_H_
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+const MojSize MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::InitialSize = 8;
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+void MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::swap(MojFlatHashMap& map)
+{
+	MojSwap(m_slots, map.m_slots);
+	MojSwap(m_capacity, map.m_capacity);
+	MojSwap(m_size, map.m_size);
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+MojErr MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::assign(const MojFlatHashMap& map)
+{
+	if (&map == this)
+		return MojErrNone;
+	release();
+	if (map.empty())
+		return MojErrNone;
+
+	// same capacity means every entry keeps its slot
+	Slot* slots = new Slot[map.m_capacity];
+	MojAllocCheck(slots);
+	for (MojSize i = 0; i < map.m_capacity; ++i) {
+		if (map.m_slots[i].m_hash)
+			slots[i] = map.m_slots[i];
+	}
+	m_slots = slots;
+	m_capacity = map.m_capacity;
+	m_size = map.m_size;
+
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+MojErr MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::reserve(MojSize numElems)
+{
+	MojSize capacity = m_capacity ? m_capacity : InitialSize;
+	while (numElems * 4 > capacity * 3)
+		capacity *= 2;
+	if (capacity > m_capacity) {
+		MojErr err = rehash(capacity);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+bool MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::get(const LookupType& key, ValueType& valOut) const
+{
+	Slot* slot = findSlot(key, hash(key));
+	if (slot == NULL)
+		return false;
+	valOut = slot->m_val;
+	return true;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+MojErr MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::del(const LookupType& key, bool& foundOut)
+{
+	foundOut = false;
+	Slot* slot = findSlot(key, hash(key));
+	if (slot == NULL)
+		return MojErrNone;
+
+	// pull later entries of the probe run into the hole, so no lookup can stop
+	// at it before reaching its key
+	MojSize mask = m_capacity - 1;
+	MojSize hole = slot - m_slots;
+	for (MojSize i = (hole + 1) & mask; m_slots[i].m_hash; i = (i + 1) & mask) {
+		MojSize home = m_slots[i].m_hash & mask;
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			m_slots[hole] = m_slots[i];
+			hole = i;
+		}
+	}
+	m_slots[hole] = Slot();
+	--m_size;
+	foundOut = true;
+
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+MojErr MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::put(const KeyType& key, const ValueType& val)
+{
+	MojUInt32 keyHash = hash(key);
+	Slot* slot = findSlot(key, keyHash);
+	if (slot) {
+		slot->m_val = val;
+		return MojErrNone;
+	}
+	// keep a quarter of the slots vacant so probe runs stay short
+	if ((m_size + 1) * 4 > m_capacity * 3) {
+		MojErr err = rehash(m_capacity ? m_capacity * 2 : InitialSize);
+		MojErrCheck(err);
+	}
+	slot = vacantSlot(keyHash);
+	slot->m_hash = keyHash;
+	slot->m_key = key;
+	slot->m_val = val;
+	++m_size;
+
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+typename MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::ConstIterator
+MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::find(const LookupType& key) const
+{
+	Slot* slot = findSlot(key, hash(key));
+	if (slot == NULL)
+		return end();
+	return ConstIterator(slot, m_slots + m_capacity);
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+MojErr MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::find(const LookupType& key, Iterator& iter)
+{
+	Slot* slot = findSlot(key, hash(key));
+	iter = Iterator(slot ? slot : m_slots + m_capacity, m_slots + m_capacity);
+
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+MojUInt32 MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::hash(const LookupType& key)
+{
+	// zero marks a vacant slot
+	MojUInt32 keyHash = HASH()(key);
+	return keyHash ? keyHash : 1;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+typename MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::Slot*
+MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::findSlot(const LookupType& key, MojUInt32 keyHash) const
+{
+	if (m_slots == NULL)
+		return NULL;
+	MojSize mask = m_capacity - 1;
+	for (MojSize i = keyHash & mask; m_slots[i].m_hash; i = (i + 1) & mask) {
+		if (m_slots[i].m_hash == keyHash && KEQ()(m_slots[i].m_key, key))
+			return m_slots + i;
+	}
+	return NULL;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+typename MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::Slot*
+MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::vacantSlot(MojUInt32 keyHash) const
+{
+	MojAssert(m_slots && m_size < m_capacity);
+	MojSize mask = m_capacity - 1;
+	MojSize i = keyHash & mask;
+	while (m_slots[i].m_hash)
+		i = (i + 1) & mask;
+	return m_slots + i;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+MojErr MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::rehash(MojSize capacity)
+{
+	MojAssert(capacity >= InitialSize && (capacity & (capacity - 1)) == 0);
+
+	Slot* slots = new Slot[capacity];
+	MojAllocCheck(slots);
+	Slot* oldSlots = m_slots;
+	MojSize oldCapacity = m_capacity;
+	m_slots = slots;
+	m_capacity = capacity;
+	for (MojSize i = 0; i < oldCapacity; ++i) {
+		if (oldSlots[i].m_hash) {
+			Slot* slot = vacantSlot(oldSlots[i].m_hash);
+			MojSwap(*slot, oldSlots[i]);
+		}
+	}
+	delete[] oldSlots;
+
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class HASH, class KEQ>
+void MojFlatHashMap<KEY, VAL, LKEY, HASH, KEQ>::release()
+{
+	delete[] m_slots;
+	m_slots = NULL;
+	m_capacity = 0;
+	m_size = 0;
+}
+
+#endif /* MOJFLATHASHMAPINTERNAL_H_ */
@@ -0,0 +1,204 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJFLATSETINTERNAL_H_
+#define MOJFLATSETINTERNAL_H_
+
+template<class T, class COMP>
+MojErr MojFlatSet<T, COMP>::del(const ValueType& val, bool& foundOut)
+{
+	foundOut = false;
+	ConstIterator i = find(val);
+	if (i != end()) {
+		MojErr err = m_vec.erase(i - begin());
+		MojErrCheck(err);
+		foundOut = true;
+	}
+	return MojErrNone;
+}
+
+template<class T, class COMP>
+MojErr MojFlatSet<T, COMP>::del(const MojFlatSet& set)
+{
+	MojErr err = merge(set, MergeDiff);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class T, class COMP>
+MojErr MojFlatSet<T, COMP>::put(const ValueType& val)
+{
+	// values mostly arrive in order, so try the back before searching
+	if (empty() || COMP()(m_vec.back(), val) < 0) {
+		MojErr err = m_vec.push(val);
+		MojErrCheck(err);
+	} else {
+		ConstIterator i = lowerBound(val);
+		MojAssert(i != end());
+		if (COMP()(*i, val) != 0) {
+			MojErr err = m_vec.insert(i - begin(), 1, val);
+			MojErrCheck(err);
+		}
+	}
+	return MojErrNone;
+}
+
+template<class T, class COMP>
+MojErr MojFlatSet<T, COMP>::put(const MojFlatSet& set)
+{
+	if (set.empty())
+		return MojErrNone;
+	if (empty()) {
+		assign(set);
+		return MojErrNone;
+	}
+	if (COMP()(m_vec.back(), set.m_vec.front()) < 0) {
+		MojErr err = m_vec.append(set.begin(), set.end());
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	MojErr err = merge(set, MergeUnion);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class T, class COMP>
+MojErr MojFlatSet<T, COMP>::put(ConstIterator rangeBegin, ConstIterator rangeEnd)
+{
+	if (rangeBegin == rangeEnd)
+		return MojErrNone;
+
+	MojSize oldSize = size();
+	MojErr err = m_vec.append(rangeBegin, rangeEnd);
+	MojErrCheck(err);
+	// only sort if the new values don't already extend the set in order
+	ConstIterator i = begin() + (oldSize ? oldSize - 1 : 0);
+	for (ConstIterator next = i + 1; next != end(); i = next++) {
+		if (COMP()(*i, *next) >= 0) {
+			err = m_vec.sort();
+			MojErrCheck(err);
+			err = unique();
+			MojErrCheck(err);
+			break;
+		}
+	}
+	return MojErrNone;
+}
+
+template<class T, class COMP>
+MojErr MojFlatSet<T, COMP>::intersect(const MojFlatSet& set)
+{
+	MojErr err = merge(set, MergeIntersect);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class T, class COMP>
+typename MojFlatSet<T, COMP>::ConstIterator MojFlatSet<T, COMP>::find(const ValueType& val) const
+{
+	ConstIterator i = lowerBound(val);
+	if (i != end() && COMP()(*i, val) == 0)
+		return i;
+	return end();
+}
+
+template<class T, class COMP>
+typename MojFlatSet<T, COMP>::ConstIterator MojFlatSet<T, COMP>::lowerBound(const ValueType& val) const
+{
+	ConstIterator first = begin();
+	MojSize count = size();
+	while (count > 0) {
+		MojSize half = count / 2;
+		ConstIterator mid = first + half;
+		if (COMP()(*mid, val) < 0) {
+			first = mid + 1;
+			count -= half + 1;
+		} else {
+			count = half;
+		}
+	}
+	return first;
+}
+
+template<class T, class COMP>
+MojErr MojFlatSet<T, COMP>::merge(const MojFlatSet& set, MergeOp op)
+{
+	Vec vec;
+	MojErr err = vec.reserve(op == MergeUnion ? size() + set.size() : size());
+	MojErrCheck(err);
+
+	ConstIterator i = begin();
+	ConstIterator j = set.begin();
+	while (i != end()) {
+		int comp = (j == set.end()) ? -1 : COMP()(*i, *j);
+		if (comp < 0) {
+			if (op != MergeIntersect) {
+				err = vec.push(*i);
+				MojErrCheck(err);
+			}
+			++i;
+		} else if (comp > 0) {
+			if (op == MergeUnion) {
+				err = vec.push(*j);
+				MojErrCheck(err);
+			}
+			++j;
+		} else {
+			if (op != MergeDiff) {
+				err = vec.push(*i);
+				MojErrCheck(err);
+			}
+			++i;
+			++j;
+		}
+	}
+	if (op == MergeUnion) {
+		err = vec.append(j, set.end());
+		MojErrCheck(err);
+	}
+	m_vec.swap(vec);
+
+	return MojErrNone;
+}
+
+template<class T, class COMP>
+MojErr MojFlatSet<T, COMP>::unique()
+{
+	if (size() < 2)
+		return MojErrNone;
+
+	typename Vec::Iterator first;
+	MojErr err = m_vec.begin(first);
+	MojErrCheck(err);
+	typename Vec::Iterator last = first + size();
+	typename Vec::Iterator out = first;
+	for (typename Vec::Iterator i = first + 1; i != last; ++i) {
+		if (COMP()(*out, *i) != 0 && ++out != i)
+			*out = *i;
+	}
+	MojSize newSize = (out - first) + 1;
+	if (newSize < size()) {
+		err = m_vec.erase(newSize, size() - newSize);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+#endif /* MOJFLATSETINTERNAL_H_ */
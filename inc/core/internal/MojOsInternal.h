@@ -419,6 +419,12 @@ inline MojErr MojThreadCondWait(MojThreadCondT* cond, MojThreadMutexT* mutex)
 	return (MojErr) pthread_cond_wait(cond, mutex);
 }
 
+inline MojErr MojThreadCondTimedWait(MojThreadCondT* cond, MojThreadMutexT* mutex, const MojTimespecT* deadline)
+{
+	MojAssert(cond && mutex && deadline);
+	return (MojErr) pthread_cond_timedwait(cond, mutex, deadline);
+}
+
 inline MojErr MojThreadRwLockInit(MojThreadRwLockT* lock)
 {
 	MojAssert(lock);
@@ -201,6 +201,22 @@ inline MojErr MojThreadCond::wait(MojThreadMutex& mutex)
 	return err;
 }
 
+inline MojErr MojThreadCond::timedWait(MojThreadMutex& mutex, const MojTime& deadline)
+{
+	MojTimespecT ts;
+	deadline.toTimespec(&ts);
+#ifdef MOJ_DEBUG
+	MojAssert(mutex.m_owner == MojThreadCurrentId());
+	mutex.m_owner = MojInvalidThreadId;
+#endif
+	MojErr err = MojThreadCondTimedWait(&m_cond, &mutex.m_mutex, &ts);
+#ifdef MOJ_DEBUG
+	MojAssert(mutex.m_owner == MojInvalidThreadId);
+	mutex.m_owner = MojThreadCurrentId();
+#endif
+	return err;
+}
+
 inline MojThreadGuard::MojThreadGuard(MojThreadMutex& mutex)
 : m_mutex(mutex),
   m_locked(true)
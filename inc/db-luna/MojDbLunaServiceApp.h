@@ -58,7 +58,6 @@ public:
     };
 private:
     static const MojChar* const VersionString;
-    static const MojInt32 NumThreads = 3;
 
     typedef MojReactorApp<MojGmainReactor> Base;
 
@@ -20,10 +20,13 @@
 
 #include "db/MojDbDefs.h"
 #include "db/MojDbCursor.h"
+#include "db/MojDbDumpFile.h"
 #include "db/MojDbIdGenerator.h"
+#include "db/MojDbIndexBuilder.h"
 #include "db/MojDbKindEngine.h"
 #include "db/MojDbProfileEngine.h"
 #include "db/MojDbPermissionEngine.h"
+#include "db/MojDbQueryExecutor.h"
 #include "db/MojDbQuotaEngine.h"
 #include "db/MojDbSpaceAlert.h"
 #include "db/MojDbStorageEngine.h"
@@ -31,6 +34,9 @@
 #include "db/MojDbShardEngine.h"
 #include "db/MojDbWatcher.h"
 #include "db/MojDbReq.h"
+#ifdef WITH_SEARCH_QUERY_CACHE
+#include "db/MojDbSearchCache.h"
+#endif
 #include "core/MojHashMap.h"
 #include "core/MojSignal.h"
 #include "core/MojString.h"
@@ -76,6 +82,7 @@ public:
 	MojErr purgeStatus(MojObject& revOut, MojDbReqRef req = MojDbReq());
 	MojErr dump(const MojChar* path, MojUInt32& countOut, bool incDel = true, MojDbReqRef req = MojDbReq(), bool backup = false,
 			MojUInt32 maxBytes = 0, const MojObject* incrementalKey = NULL, MojObject* backupResponse = NULL);
+	MojErr dumpBinary(const MojChar* path, MojUInt32& countOut, bool incDel = true, bool compress = true, MojDbReqRef req = MojDbReq());
 	MojErr load(const MojChar* path, MojUInt32& countOut, MojUInt32 flags = MojDbFlagNone, MojDbReqRef req = MojDbReq());
 
 	MojErr del(const MojObject& id, bool& foundOut, MojUInt32 flags = MojDbFlagNone, MojDbReqRef req = MojDbReq());
@@ -99,11 +106,16 @@ public:
 	MojErr watch(const MojDbQuery& query, MojDbCursor& cursor, WatchSignal::SlotRef watchHandler, bool& firedOut, MojDbReqRef req = MojDbReq());
 	MojErr removePrivateDataByOwner(const MojString& owner, MojDbReqRef req = MojDbReq());
 
-	const MojThreadRwLock& schemaLock() { return m_schemaLock; }
+	const MojThreadEpochLock& schemaLock() { return m_schemaLock; }
 	MojDbKindEngine* kindEngine() { return &m_kindEngine; }
 	MojDbProfileEngine* profileEngine() { return &m_profileEngine; }
 	MojDbPermissionEngine* permissionEngine() { return &m_permissionEngine; }
 	MojDbQuotaEngine* quotaEngine() { return &m_quotaEngine; }
+	MojDbIndexBuilder* indexBuilder() { return &m_indexBuilder; }
+	MojDbQueryExecutor* queryExecutor() { return &m_queryExecutor; }
+#ifdef WITH_SEARCH_QUERY_CACHE
+	MojDbSearchCache* searchCache() { return m_searchCache.get(); }
+#endif
 	MojDbStorageEngine* storageEngine() { return m_storageEngine.get(); }
 	MojDbStorageExtDatabase* storageDatabase() { return m_objDb.get(); }
     MojDbShardEngine* shardEngine () { return &m_shardEngine; }
@@ -131,6 +143,11 @@ public:
 private:
 	friend class MojDbKindEngine;
 	friend class MojDbReq;
+	class DumpJob;
+	class DecodeJob;
+
+	// blocks of a binary dump decoded per load transaction, for each executor slot
+	static const MojSize LoadBlocksPerSlot = 4;
 
 	static const MojChar* const AdminRole;
 	static const MojChar* const DbStateObjId;
@@ -170,6 +187,10 @@ private:
 	MojErr delObj(const MojObject& id, const MojObject& obj, MojDbStorageItem* item, MojObject& foundObjOut, MojDbReq& req, MojUInt32 flags);
 	MojErr delImpl(const MojObject& id, bool& foundOut, MojObject& foundObjOut, MojDbReq& req, MojUInt32 flags);
 	MojErr delImpl(const MojDbQuery& query, MojUInt32& countOut, MojDbReq& req, MojUInt32 flags = MojDbFlagNone);
+	MojErr delKindObjs(const MojString& kindId, MojUInt32& countOut, MojDbReq& req);
+	static MojErr delKindQuery(const MojString& kindId, bool deleted, const MojObject& lastId, MojDbQuery& queryOut);
+	MojErr readBatch(const MojDbQuery& query, MojVector<MojObject>& objsOut, MojVector<MojSize>& sizesOut, MojDbIndex*& indexOut, MojDbReq& req);
+	MojErr purgeBatch(const MojVector<MojObject>& objs, const MojVector<MojSize>& sizes, const MojDbIndex* rangeIndex, MojDbReq& req);
 
 	MojErr putImpl(MojObject& obj, MojUInt32 flags, MojDbReq& req, bool checkSchema = true,
 		MojString shardId = MojString(), bool reverseTransaction = true);
@@ -183,12 +204,17 @@ private:
     MojErr dumpImpl(MojFile& file, bool backup, bool incDel, const MojObject& revParam, const MojObject& delRevParam, bool skipKinds, MojUInt32& countOut, MojDbReq& req,
             MojObject* response, const MojChar* keyName, MojSize& bytesWritten, MojSize& warns, MojUInt32 maxBytes = 0);
 	MojErr dumpObj(MojFile& file, MojObject obj, MojSize& bytesWrittenOut, MojUInt32 maxBytes = 0);
+	MojErr dumpKinds(MojVector<MojObject>& kindVec);
+	MojErr dumpKindObjs(MojDbDumpWriter& writer, const MojString& kindId, bool deleted, MojUInt32& countOut, MojSize& warnsOut, MojDbReq& req);
+	MojErr loadBinary(const MojChar* path, MojUInt32& countOut, MojUInt32 flags, MojDbReq& req);
 	MojErr findImpl(const MojDbQuery& query, MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req, MojDbOp op);
 	MojErr getImpl(const MojObject& id, MojObjectVisitor& visitor, MojDbOp op, MojDbReq& req);
 	MojErr handleBackupFull(const MojObject& revParam, const MojObject& delRevParam, MojObject& response, const MojChar* keyName);
 	MojErr insertIncrementalKey(MojObject& response, const MojChar* keyName, const MojObject& curRev);
 	MojErr loadImpl(MojObject& obj, MojUInt32 flags, MojDbReq& req);
 	MojErr purgeImpl(MojObject& obj, MojUInt32& countOut, MojDbReq& req);
+	MojErr purgeQuery(const MojObject& rev, bool sync, MojUInt32 limit, MojUInt32& countOut, MojDbReq& req);
+	MojErr purgeRange(const MojObject& rev, bool sync, MojUInt32 limit, MojUInt32& countOut, MojDbReq& req);
 
     MojErr attachShardId(MojString shardId, MojObject& id);
 #ifdef LMDB_ENGINE_SUPPORT
@@ -219,8 +245,14 @@ private:
 	MojDbPermissionEngine m_permissionEngine;
     MojDbQuotaEngine m_quotaEngine;
 	MojDbShardEngine m_shardEngine;
-	MojThreadRwLock m_schemaLock;
+	MojDbIndexBuilder m_indexBuilder;
+	MojDbQueryExecutor m_queryExecutor;
+#ifdef WITH_SEARCH_QUERY_CACHE
+	MojRefCountedPtr<MojDbSearchCache> m_searchCache;
+#endif
+	MojThreadEpochLock m_schemaLock;
 	MojString m_engineName;
+	MojString m_catalogDir;
 	MojObject m_conf;
 	MojInt64 m_purgeWindow;
 	MojInt64 m_loadStepSize;
@@ -50,7 +50,7 @@ private:
         MojObject m_last;
     };
 
-    typedef MojSet<MojDbKey> SortKey;
+    typedef MojDbExtractor::KeySet SortKey;
     typedef MojMap<MojString, AggregateInfo> AggregateInfoMap;
     typedef MojMap<MojObject, AggregateInfoMap> GroupAggregateMap;
 
@@ -0,0 +1,127 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJDBCOMPACTSCHEDULER_H_
+#define MOJDBCOMPACTSCHEDULER_H_
+
+#include <map>
+#include <string>
+
+#include "db/MojDbDefs.h"
+#include "core/MojObject.h"
+#include "core/MojThread.h"
+#include "core/MojTime.h"
+
+/**
+ * Background compaction in small steps for the LSM engines (sandwich, leveldb).
+ *
+ * After each commit the engine reports, per part of its key space (a sandwich
+ * part on one shard, a leveldb database), how many bytes were written and
+ * deleted and the smallest and largest key touched. That volume is the part's
+ * compaction debt. A worker thread wakes every interval and, once no commit has
+ * been reported for the idle period, compacts the touched key range of the part
+ * with the most debt, one part per step. Parts with less debt than the
+ * threshold are left for leveldb's own compactions.
+ *
+ * Steps are paid from an I/O budget that refills at budget bytes per second and
+ * holds at most one second's worth. A step costs the debt it retires and may
+ * overdraw the budget, the next step then waits until it has refilled, so over
+ * time compaction I/O stays near the budget. A step that fails costs nothing,
+ * its debt is dropped all the same. A budget of 0 turns the scheduler off.
+ */
+class MojDbCompactScheduler : private MojNoCopy
+{
+public:
+	static const MojChar* const IntervalKey;
+	static const MojChar* const IdleKey;
+	static const MojChar* const BudgetKey;
+	static const MojChar* const ThresholdKey;
+	static const MojInt64 IntervalDefault = 1000; // millisecs
+	static const MojInt64 IdleDefault = 500; // millisecs
+	static const MojInt64 BudgetDefault = 4 * 1024 * 1024; // bytes per sec
+	static const MojInt64 ThresholdDefault = 256 * 1024; // bytes
+
+	// bytes written and deleted in one part and the key range they fell in
+	struct Range
+	{
+		Range() : m_written(0), m_deleted(0) {}
+		MojSize debt() const { return m_written + m_deleted; }
+		void note(const char* key, MojSize keySize, MojSize written, MojSize deleted);
+		void merge(const Range& range);
+
+		std::string m_min;
+		std::string m_max;
+		MojSize m_written;
+		MojSize m_deleted;
+	};
+	typedef std::map<std::string, Range> RangeMap;
+
+	class Compactor
+	{
+	public:
+		virtual ~Compactor() {}
+		// compacts the keys in [from, to] of the given part, keys are part-local
+		virtual MojErr compactRange(const std::string& part, const std::string& from, const std::string& to) = 0;
+	};
+
+	explicit MojDbCompactScheduler(Compactor& compactor);
+	~MojDbCompactScheduler();
+
+	MojErr configure(const MojObject& conf);
+	MojErr start();
+	MojErr stop();
+
+	bool enabled() const;
+	// adds what a committed txn did to each part, keyed by part
+	void noteCommit(const RangeMap& ranges);
+	// drops the debt of a part that went away, of all parts under a prefix that
+	// were compacted together, or of everything after a full compaction
+	void forget(const std::string& part);
+	void forgetPrefix(const std::string& prefix);
+	void reset();
+
+	// runs at most one step, normally called by the worker thread
+	MojErr step(const MojTime& now, bool& ranOut);
+	MojErr stats(MojObject& objOut) const;
+
+private:
+	static MojErr threadMain(void* arg);
+	void refill(const MojTime& now);
+
+	Compactor& m_compactor;
+	mutable MojThreadMutex m_mutex;
+	MojThreadCond m_cond;
+	MojThreadT m_thread;
+	bool m_stop;
+
+	MojInt64 m_interval;
+	MojInt64 m_idle;
+	MojInt64 m_budget;
+	MojInt64 m_threshold;
+
+	RangeMap m_ranges;
+	MojTime m_lastCommit;
+	MojTime m_lastRefill;
+	MojInt64 m_tokens;
+
+	MojSize m_steps;
+	MojSize m_throttled;
+	MojSize m_errors;
+	MojUInt64 m_compacted;
+};
+
+#endif /* MOJDBCOMPACTSCHEDULER_H_ */
@@ -43,7 +43,9 @@ public:
 	MojDbStorageTxn* txn() { return m_txn.get(); }
 	void verifymode(bool bval) { m_vmode = bval;}
 	bool verifymode() const{ return m_vmode;}
+	const MojObject& plan() const { return m_plan; }
     void setIndex(MojDbIndex * ind) { m_dbIndex = ind; }
+	MojDbIndex* dbIndex() const { return m_dbIndex; }
 
 protected:
 	friend class MojDbIndex;
@@ -72,6 +74,7 @@ protected:
     MojAutoPtr<MojDbAggregateFilter> m_aggregateFilter;
 	MojRefCountedPtr<MojDbWatcher> m_watcher;
 	MojDbIndex* m_dbIndex;
+	MojObject m_plan;
 	bool m_vmode;
 };
 
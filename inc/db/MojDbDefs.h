@@ -30,6 +30,7 @@ class MojDbKey;
 class MojDbKeyRange;
 class MojDbKind;
 class MojDbKindEngine;
+class MojDbKindState;
 class MojDbObjectItem;
 class MojDbPermissionEngine;
 class MojDbPropExtractor;
@@ -0,0 +1,122 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJDBDUMPFILE_H_
+#define MOJDBDUMPFILE_H_
+
+#include "db/MojDbDefs.h"
+#include "core/MojFile.h"
+#include "core/MojObject.h"
+#include "core/MojThread.h"
+#include "core/MojVector.h"
+
+/**
+ * Binary dump files.
+ *
+ * A dump is a small header followed by blocks. A block holds the records of a
+ * single kind, each one the MojObjectWriter form of an object prefixed with its
+ * length, and may be Snappy compressed on its own. Blocks are independent, so
+ * several threads can write them and load can decode them in parallel.
+ * Integers are little endian.
+ *
+ *   header: "DB8DUMP" '\0', u32 version
+ *   block:  u8 codec, u32 stored size, u32 raw size, u32 record count, data
+ *   record: u32 size, serialized object
+ */
+class MojDbDumpFile
+{
+public:
+	typedef MojVector<MojByte> ByteVec;
+	typedef MojVector<MojObject> ObjectVec;
+
+	static const MojSize BlockSize = 64 * 1024;
+	static const MojUInt32 Version = 1;
+
+	enum Codec {
+		CodecNone = 0,
+		CodecSnappy = 1
+	};
+
+	class Block
+	{
+	public:
+		Block() : m_codec(CodecNone), m_rawSize(0), m_count(0) {}
+
+		MojErr append(const MojObject& obj);
+		MojErr decode(ObjectVec& objsOut) const;
+		void clear();
+
+		bool empty() const { return m_count == 0; }
+		bool full() const { return m_data.size() >= BlockSize; }
+		MojUInt32 count() const { return m_count; }
+
+	private:
+		friend class MojDbDumpWriter;
+		friend class MojDbDumpReader;
+
+		MojUInt8 m_codec;
+		MojUInt32 m_rawSize;
+		MojUInt32 m_count;
+		ByteVec m_data;
+	};
+
+	static bool compressionSupported();
+	static MojErr isDump(const MojChar* path, bool& dumpOut);
+
+protected:
+	static const MojChar Magic[8];
+	static const MojSize HeaderSize = 12;
+	static const MojSize BlockHeaderSize = 13;
+};
+
+// appends blocks to a dump; write() may be called from several threads
+class MojDbDumpWriter : public MojDbDumpFile, private MojNoCopy
+{
+public:
+	MojDbDumpWriter();
+	~MojDbDumpWriter();
+
+	MojErr open(const MojChar* path, bool compress);
+	MojErr close();
+	MojErr write(Block& block);
+
+	MojSize bytesWritten() const;
+
+private:
+	MojErr writeBytes(const MojByte* data, MojSize size);
+
+	mutable MojThreadMutex m_mutex;
+	MojFile m_file;
+	bool m_compress;
+	MojSize m_bytesWritten;
+};
+
+// reads stored blocks in file order, decoding is left to Block::decode
+class MojDbDumpReader : public MojDbDumpFile, private MojNoCopy
+{
+public:
+	MojErr open(const MojChar* path);
+	MojErr close();
+	MojErr read(Block& blockOut, bool& foundOut);
+
+private:
+	MojErr readBytes(MojByte* data, MojSize size, MojSize& sizeOut);
+
+	MojFile m_file;
+};
+
+#endif /* MOJDBDUMPFILE_H_ */
@@ -23,7 +23,8 @@
 #include "db/MojDbTextCollator.h"
 #include "db/MojDbTextTokenizer.h"
 #include "core/MojObject.h"
-#include "core/MojSet.h"
+#include "core/MojObjectView.h"
+#include "core/MojFlatSet.h"
 
 class MojDbExtractor : public MojRefCounted
 {
@@ -31,13 +32,17 @@ public:
 	static const MojChar* const CollateKey;
 	static const MojChar* const NameKey;
 
-	typedef MojSet<MojDbKey> KeySet;
+	typedef MojFlatSet<MojDbKey> KeySet;
+	typedef MojVector<MojString> StringVec;
 
 	MojDbExtractor() : m_collation(MojDbCollationInvalid) {}
 	virtual ~MojDbExtractor() {}
 	virtual MojErr fromObject(const MojObject& obj, const MojChar* locale) = 0;
 	virtual MojErr updateLocale(const MojChar* locale) = 0;
-	virtual MojErr vals(const MojObject& obj, KeySet& valsOut) const = 0;
+	virtual MojErr vals(const MojObjectView& obj, KeySet& valsOut) const = 0;
+	MojErr vals(const MojObject& obj, KeySet& valsOut) const { return vals(MojObjectView(obj), valsOut); }
+	// true if vals may depend on any of the given top-level props
+	virtual bool touched(const StringVec& props) const = 0;
     void name(const MojString& name) { m_name = name; }
 
 	const MojString& name() const { return m_name; }
@@ -63,18 +68,19 @@ public:
 	MojErr prop(const MojString& name);
 	virtual MojErr fromObject(const MojObject& obj, const MojChar* locale);
 	virtual MojErr updateLocale(const MojChar* locale);
-	virtual MojErr vals(const MojObject& obj, KeySet& valsOut) const { return valsImpl(obj, valsOut, 0); }
+	virtual MojErr vals(const MojObjectView& obj, KeySet& valsOut) const { return valsImpl(obj, valsOut, 0); }
+	virtual bool touched(const StringVec& props) const;
+	using MojDbExtractor::vals;
 
 private:
 	friend class MojDbMultiExtractor;
-	typedef MojVector<MojString> StringVec;
 
 	static const MojChar PropComponentSeparator;
 	static const MojChar* const WildcardKey;
 
 	MojErr fromObjectImpl(const MojObject& obj, const MojDbPropExtractor& defaultConfig, const MojChar* locale);
-	MojErr valsImpl(const MojObject& obj, KeySet& valsOut, MojSize idx) const;
-	MojErr handleVal(const MojObject& val, KeySet& valsOut, MojSize idx) const;
+	MojErr valsImpl(const MojObjectView& obj, KeySet& valsOut, MojSize idx) const;
+	MojErr handleVal(const MojObjectView& val, KeySet& valsOut, MojSize idx) const;
 
 	KeySet m_default;
 	StringVec m_prop;
@@ -89,7 +95,9 @@ public:
 
 	virtual MojErr fromObject(const MojObject& obj, const MojChar* locale);
 	virtual MojErr updateLocale(const MojChar* locale);
-	virtual MojErr vals(const MojObject& obj, KeySet& valsOut) const;
+	virtual MojErr vals(const MojObjectView& obj, KeySet& valsOut) const;
+	virtual bool touched(const StringVec& props) const;
+	using MojDbExtractor::vals;
 
 private:
 	typedef MojVector<MojRefCountedPtr<MojDbExtractor> > ExtractorVec;
@@ -20,8 +20,12 @@
 
 #include "db/MojDbDefs.h"
 #include "db/MojDbExtractor.h"
+#include "db/MojDbIndexStats.h"
+#include "db/MojDbKeyRangeTree.h"
 #include "db/MojDbStorageEngine.h"
 #include "db/MojDbWatcher.h"
+#include "core/MojFlatHashMap.h"
+#include "core/MojFlatSet.h"
 #include "core/MojSet.h"
 #include "core/MojMap.h"
 #include "core/MojThread.h"
@@ -29,12 +33,15 @@
 class MojDbIndex : public MojSignalHandler, public MojDbStorageTxn::Monitor
 {
 public:
+	static const MojChar* const BuildingKey;
+	static const MojChar* const BuiltKey;
 	static const MojChar* const CountKey;
 	static const MojChar* const DelMissesKey;
 	static const MojChar* const DefaultKey;
 	static const MojChar* const IncludeDeletedKey;
 	static const MojChar* const MultiKey;
 	static const MojChar* const NameKey;
+	static const MojChar* const PlanStatsKey;
 	static const MojChar* const PropsKey;
 	static const MojChar* const SizeKey;
 	static const MojChar* const TypeKey;
@@ -55,13 +62,25 @@ public:
 	MojErr stats(MojObject& objOut, MojSize& usageOut, MojDbReq& req);
 	MojErr drop(MojDbReq& req);
 	MojErr updateLocale(const MojChar* locale, MojDbReq& req);
+	MojErr buildChunk(MojDbReq& req);
 
 	MojErr find(MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req);
-	MojErr update(const MojObject* newObj, const MojObject* oldObj, MojDbStorageTxn* txn, bool forcedel);
+	MojErr update(const MojObject* newObj, const MojObject* oldObj, MojDbStorageTxn* txn, bool forcedel,
+			const StringVec* changed = NULL);
+	MojErr delRange(const MojObject& lower, const MojObject& upper, MojDbStorageTxn* txn, MojSize& countOut);
+	MojErr keySize(const MojObject& obj, MojSize& sizeOut) const;
 	MojErr cancelWatch(MojDbWatcher* watcher);
 
 	bool canAnswer(const MojDbQuery& query) const;
+	bool building();
+	MojDouble scanCost(const MojDbQuery& query, MojDouble& rowsOut) const;
+	MojErr sampleStats(const MojObject& obj);
+	void resetStats() { m_stats.reset(); }
+	bool hasStats() const { return m_stats.seeded(); }
+	MojErr saveStats(MojObject& objOut) const { return m_stats.save(objOut); }
+	MojErr restoreStats(const MojObject& obj) { return m_stats.restore(obj); }
 	bool includeDeleted() const { return m_includeDeleted; }
+	bool isIdIndex() const;
 	MojSize idIndex() const { return m_idIndex; }
 	MojSize size() const { return m_props.size(); }
 	const MojObject& id() const { return m_id; }
@@ -72,34 +91,62 @@ public:
 	const MojString& name() const { return m_name; }
     MojDbCollationStrength collation(MojSize idx) const { return (m_props.at(idx)->collation()); }
 
+	// sorted names of the top-level props that differ between obj and prevObj
+	static MojErr changedProps(const MojObject& obj, const MojObject& prevObj, StringVec& propsOut);
+
 private:
 	static const MojSize WatchWarningThreshold = 20;
+	static const MojDouble RowCost;
+	static const MojDouble KeyByteCost;
+	static const MojDouble DefaultPropSize;
+	static const MojDouble DefaultEqSelectivity;
+	static const MojDouble RangeSelectivity;
 
 	typedef MojVector<MojDbKeyRange> RangeVec;
 	typedef MojVector<MojRefCountedPtr<MojDbExtractor> > PropVec;
 	typedef MojVector<MojByte> ByteVec;
-	typedef MojSet<MojDbKey> KeySet;
+	typedef MojFlatSet<MojDbKey> KeySet;
+	typedef MojDbKeyBuilder::KeyVec KeyVec;
 	typedef MojSet<MojObject> ObjectSet;
 	typedef MojVector<MojObject> ObjectVec;
 	typedef MojVector<MojRefCountedPtr<MojDbWatcher> > WatcherVec;
 	typedef MojMap<MojString, MojSize> WatcherMap;
 	typedef MojDbStorageTxn::CommitSignal::Slot<MojDbIndex> CommitSlot;
 
+	struct StatsDelta
+	{
+		StatsDelta() : m_reset(false), m_count(0), m_size(0) {}
+		bool m_reset; //!< index was emptied first, so the deltas are the new totals
+		MojInt64 m_count;
+		MojInt64 m_size;
+	};
+
 	bool isOpen() const { return m_collection != NULL; }
-	bool isIdIndex() const;
 	bool includeObj(const MojObject* obj) const;
 	MojErr createExtractor(const MojObject& propObj, MojRefCountedPtr<MojDbExtractor>& extractorOut);
 	MojErr addBuiltinProps();
 	MojErr addWatch(const MojDbQueryPlan& plan, MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req);
-	MojErr addPendingKeys(const KeySet& keys, MojDbStorageTxn& txn);
-	MojErr delKeys(MojDbShardId shardId, const KeySet& keys, MojDbStorageTxn* txn, bool forcedel);
-	MojErr insertKeys(MojDbShardId shardId, const KeySet& keys, MojDbStorageTxn* txn);
-	MojErr getKeys(const MojObject& obj, KeySet& keysOut) const;
+	bool touched(const StringVec& changed) const;
+	MojErr addPendingKeys(const KeyVec& keys, MojDbStorageTxn& txn);
+	MojErr addUnkeyed(MojDbStorageTxn& txn, bool& watchedOut);
+	MojErr addUnkeyedAll(MojDbStorageTxn& txn);
+	MojErr addPendingStats(MojDbStorageTxn& txn, MojInt64 count, MojInt64 size, bool reset = false);
+	MojErr delKeys(MojDbShardId shardId, const KeyVec& keys, MojDbStorageTxn* txn, bool forcedel);
+	MojErr insertKeys(MojDbShardId shardId, const KeyVec& keys, MojDbStorageTxn* txn);
+	MojErr getKeys(const MojObject& obj, KeyVec& keysOut, MojDbIndexStats* statsOut = NULL) const;
+	MojErr rangeKey(const MojObject& vals, MojDbKey& keyOut) const;
+	MojErr getKeys(const MojObject& obj, const MojObject& prevObj, const StringVec& changed,
+			KeyVec& keysOut, KeyVec& prevKeysOut, MojDbIndexStats* statsOut = NULL) const;
+	static MojErr diffKeys(const KeyVec& keys, const KeyVec& prevKeys, KeyVec& addedOut,
+			KeyVec& removedOut, KeyVec& unionOut);
 	MojErr handlePreCommit(MojDbStorageTxn* txn);
 	MojErr handlePostCommit(MojDbStorageTxn* txn);
 	MojErr committed(MojDbStorageTxn& txn);
 	MojErr destroy(MojDbStorageTxn& txn);
 	MojErr build(MojDbStorageTxn* txn);
+	MojErr backfill(MojDbReq& req);
+	MojErr updateImpl(const MojObject* newObj, const MojObject* oldObj, MojDbStorageTxn* txn, bool forcedel,
+			const StringVec* changed);
 	/// Abandon all active watchers under provided write guard
 	/// \note lock might be released during this call
 	MojErr abandonWatchers(MojThreadWriteGuard& guard);
@@ -115,11 +162,13 @@ private:
 	KeySet m_idSet;
 	WatcherVec m_watcherVec;
 	WatcherMap m_watcherMap;
+	MojDbKeyRangeTree m_watcherTree; //!< ranges of m_watcherVec, for matching committed keys
 	MojThreadRwLock m_lock;
 	CommitSlot m_preCommitSlot;
 	CommitSlot m_postCommitSlot;
-	// TODO: use MojHashMap?
-	MojMap<MojDbStorageTxn*, KeySet> m_pendingKeys; //!< kind of attached attribute for MojDbStorageTxn
+	MojFlatHashMap<MojDbStorageTxn*, KeySet> m_pendingKeys; //!< keys each open txn wrote, matched against watchers on commit
+	MojSet<MojDbStorageTxn*> m_unkeyedTxns; //!< txns that fire every watcher on commit, their keys weren't worked out
+	MojFlatHashMap<MojDbStorageTxn*, StatsDelta> m_pendingStats; //!< key count changes applied to m_stats on commit
 	MojRefCountedPtr<MojDbStorageExtIndex> m_index;
 	MojDbKind* m_kind;
 	MojDbKindEngine* m_kindEngine;
@@ -127,7 +176,18 @@ private:
 	MojSize m_idIndex;
 	bool m_includeDeleted;
 	bool m_ready;
+	// build progress is read by writers and stats while the builder moves it, guarded by m_lock
+	bool m_building; //!< backfilling in chunks, only objects up to m_buildKey are indexed
+	MojObject m_buildId; //!< id of the last backfilled object, null until the first chunk commits
+	MojDbKey m_buildKey;
+	MojInt64 m_built;
+	// result of the chunk in flight, applied once its txn commits
+	MojObject m_chunkId;
+	MojInt64 m_chunkCount;
+	bool m_chunkDone;
+	bool m_chunkPending;
 	MojUInt32 m_delMisses;
+	MojDbIndexStats m_stats;
 };
 
 #endif /* MOJDBINDEX_H_ */
@@ -0,0 +1,92 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJDBINDEXBUILDER_H_
+#define MOJDBINDEXBUILDER_H_
+
+#include "db/MojDbDefs.h"
+#include "core/MojMap.h"
+#include "core/MojObject.h"
+#include "core/MojThread.h"
+#include "core/MojVector.h"
+
+/**
+ * Backfills indexes added to existing kinds in the background.
+ *
+ * Each job is one index that still has objects to backfill. The worker thread
+ * takes a job, builds one chunk of it in its own transaction under the schema
+ * write lock and the index queues itself again from its post-commit handler
+ * until the kind is exhausted. Jobs are served round-robin, so a huge kind
+ * doesn't hold back smaller ones.
+ *
+ * Progress is persisted in the kind state with every chunk, so builds that are
+ * pending when the db is closed resume from where they stopped on next open.
+ * A chunk that fails is retried from the same watermark after a delay that
+ * doubles with every consecutive failure, the build is given up for the rest
+ * of the session after RetryMax of them.
+ */
+class MojDbIndexBuilder : private MojNoCopy
+{
+public:
+	static const MojChar* const ChunkSizeKey;
+	static const MojSize ChunkSizeDefault = 1000;
+	static const MojUInt32 RetryMax = 6;
+	static const MojInt64 RetryDelayMs = 100;
+
+	MojDbIndexBuilder();
+	~MojDbIndexBuilder();
+
+	MojErr configure(const MojObject& conf);
+	MojErr open(MojDb* db);
+	MojErr close();
+
+	MojErr add(MojDbIndex* index);
+	MojErr drain();
+
+	MojSize chunkSize() const { return m_chunkSize; }
+	MojSize pending() const;
+
+private:
+	typedef MojVector<MojRefCountedPtr<MojDbIndex> > IndexVec;
+	struct Retry
+	{
+		MojRefCountedPtr<MojDbIndex> m_index;
+		MojTime m_due;
+	};
+	typedef MojVector<Retry> RetryVec;
+	typedef MojMap<MojDbIndex*, MojUInt32> FailureMap;
+
+	static MojErr threadMain(void* arg);
+	bool next(MojRefCountedPtr<MojDbIndex>& indexOut, bool wait);
+	void done(MojDbIndex* index, MojErr buildErr);
+	MojErr retry(MojDbIndex* index, MojErr buildErr);
+	MojErr promote(bool all, MojTime& nextDueOut);
+	MojErr run(MojDbIndex* index);
+
+	MojDb* m_db;
+	MojThreadT m_thread;
+	mutable MojThreadMutex m_mutex;
+	MojThreadCond m_cond;
+	IndexVec m_queue;
+	RetryVec m_retries;
+	FailureMap m_failures;
+	MojSize m_running;
+	MojSize m_chunkSize;
+	bool m_stop;
+};
+
+#endif /* MOJDBINDEXBUILDER_H_ */
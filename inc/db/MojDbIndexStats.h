@@ -0,0 +1,81 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJDBINDEXSTATS_H_
+#define MOJDBINDEXSTATS_H_
+
+#include "db/MojDbDefs.h"
+#include "db/MojDbKey.h"
+#include "core/MojObject.h"
+#include <atomic>
+
+/**
+ * Statistics kept per index for the query planner.
+ *
+ * Key count and key bytes are adjusted as each txn that inserts or deletes keys
+ * commits and replaced with exact totals whenever index stats are collected. Distinct prefix counts are
+ * estimated with a small HyperLogLog sketch per prefix depth (1 = first prop,
+ * 2 = first two props, ...). Sketches can't forget values, so they are rebuilt
+ * from scratch by MojDbKind::stats.
+ *
+ * Every writer to the index updates these, so all fields are relaxed atomics
+ * and registers are raised with a compare-and-swap instead of under a lock.
+ * Stats are seeded once exact totals are known: when the index is created,
+ * restored from the kind catalog or collected by MojDbKind::stats. Until then
+ * the planner doesn't trust them.
+ */
+class MojDbIndexStats : private MojNoCopy
+{
+public:
+	static const MojChar* const KeysKey;
+	static const MojChar* const AvgKeySizeKey;
+	static const MojChar* const DistinctKey;
+	static const MojChar* const BytesKey;
+	static const MojChar* const RegistersKey;
+	static const MojSize MaxDepth = 4;
+
+	MojDbIndexStats();
+
+	void reset();
+	void totals(MojSize count, MojSize size);
+	void adjust(MojInt64 count, MojInt64 size);
+	void prefix(MojSize depth, MojUInt32 hash);
+
+	bool seeded() const { return m_seeded.load(std::memory_order_acquire); }
+	MojSize keyCount() const;
+	MojDouble avgKeySize() const;
+	MojDouble distinct(MojSize depth) const;
+	MojErr toObject(MojObject& objOut) const;
+	MojErr save(MojObject& objOut) const;
+	MojErr restore(const MojObject& obj);
+
+	static MojUInt32 combine(MojUInt32 prefixHash, const MojDbKey& val);
+
+private:
+	static const MojSize RegisterBits = 6;
+	static const MojSize NumRegisters = 1 << RegisterBits;
+
+	MojDouble estimate(MojSize depth) const;
+	static void add(std::atomic<MojInt64>& val, MojInt64 delta);
+
+	std::atomic<bool> m_seeded;
+	std::atomic<MojInt64> m_keyCount;
+	std::atomic<MojInt64> m_keyBytes;
+	std::atomic<MojByte> m_registers[MaxDepth][NumRegisters];
+};
+
+#endif /* MOJDBINDEXSTATS_H_ */
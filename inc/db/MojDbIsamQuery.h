@@ -57,6 +57,7 @@ protected:
 	MojErr getImpl(MojDbStorageItem*& itemOut, bool& foundOut, bool getItem);
 	void init();
 	bool match();
+	bool inRange(const MojByte* keyData, MojSize keySize);
 	bool limitEnforced() { return m_count >= m_plan->limit(); }
 	int compareKey(const ByteVec& key);
 	MojErr incrementCount();
@@ -64,6 +65,7 @@ protected:
 	MojErr getKey(MojUInt32& groupOut, bool& foundOut);
 	MojErr saveEndKey();
 	MojErr parseId(MojObject& idOut);
+	MojErr parseId(const MojByte* keyData, MojSize keySize, MojObject& idOut);
 	MojErr checkExclude(MojDbStorageItem* item, bool& excludeOut);
     MojErr checkShard(bool &excludeOut);
 
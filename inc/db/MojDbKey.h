@@ -21,7 +21,7 @@
 #include "db/MojDbDefs.h"
 #include "core/MojBuffer.h"
 #include "core/MojObject.h"
-#include "core/MojSet.h"
+#include "core/MojFlatSet.h"
 #include "core/MojVector.h"
 
 class MojDbKey
@@ -90,13 +90,15 @@ private:
 class MojDbKeyBuilder : private MojNoCopy
 {
 public:
-	typedef MojSet<MojDbKey> KeySet;
+	typedef MojFlatSet<MojDbKey> KeySet;
+	typedef MojVector<MojDbKey> KeyVec;
 
 	MojDbKeyBuilder() {}
 
 	void clear() { m_stack.clear(); }
 	MojErr push(const KeySet& vals);
 	MojErr keys(KeySet& keysOut);
+	MojErr keys(KeyVec& keysOut); //!< sorted, without duplicates
 
 private:
 	struct PropRec {
@@ -113,7 +115,7 @@ private:
 template<>
 struct MojComp<MojDbKey>
 {
-	int operator()(const MojDbKey& val1, const MojDbKey& val2)
+	int operator()(const MojDbKey& val1, const MojDbKey& val2) const
 	{
 		return val1.compare(val2);
 	}
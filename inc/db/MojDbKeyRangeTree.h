@@ -0,0 +1,74 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJDBKEYRANGETREE_H_
+#define MOJDBKEYRANGETREE_H_
+
+#include "db/MojDbDefs.h"
+#include "db/MojDbKey.h"
+#include "core/MojVector.h"
+
+/**
+ * Interval tree over watcher key ranges.
+ *
+ * Ranges are kept in a treap ordered by lower key, each node tracking the
+ * greatest upper key in its subtree, so the watchers whose range contains a
+ * given key are found in O(log n + matches). An empty lower key is unbounded
+ * below and an empty upper key is unbounded above, as in MojDbKeyRange.
+ */
+class MojDbKeyRangeTree : private MojNoCopy
+{
+public:
+	struct Entry
+	{
+		MojDbWatcher* watcher;
+		bool desc;
+	};
+	typedef MojVector<Entry> EntryVec;
+
+	MojDbKeyRangeTree();
+	~MojDbKeyRangeTree();
+
+	MojSize size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	void clear();
+
+	MojErr put(const MojDbKeyRange& range, MojDbWatcher* watcher, bool desc);
+	bool del(const MojDbKeyRange& range, MojDbWatcher* watcher);
+	/// append all entries whose range contains key
+	MojErr find(const MojDbKey& key, EntryVec& entriesOut) const;
+
+private:
+	struct Node;
+
+	MojUInt32 nextPriority();
+	static int compare(const Node* node, const MojDbKeyRange& range, const MojDbWatcher* watcher);
+	static void update(Node* node);
+	static Node* rotateLeft(Node* node);
+	static Node* rotateRight(Node* node);
+	static Node* insert(Node* root, Node* node);
+	static Node* merge(Node* left, Node* right);
+	static Node* remove(Node* root, const MojDbKeyRange& range, const MojDbWatcher* watcher, Node*& removedOut);
+	static MojErr find(const Node* node, const MojDbKey& key, EntryVec& entriesOut);
+	static void destroy(Node* node);
+
+	Node* m_root;
+	MojSize m_size;
+	MojUInt32 m_seed;
+};
+
+#endif /* MOJDBKEYRANGETREE_H_ */
@@ -58,6 +58,10 @@ public:
 	static const MojChar* const NameKey;
 	static const MojChar* const ObjectsKey;
 	static const MojChar* const OwnerKey;
+	static const MojChar* const PlanCandidatesKey;
+	static const MojChar* const PlanCostKey;
+	static const MojChar* const PlanIndexKey;
+	static const MojChar* const PlanRowsKey;
     static const MojChar* const HashKey;
 	static const MojChar* const PrivateKey;
 	static const MojChar* const PermissionType;
@@ -81,12 +85,15 @@ public:
 	const MojString& owner() const { return m_owner; }
     bool assignId() const { return m_assignId; }
 	const MojObject& object() const { return m_obj; }
+	// the object as stored in Kind:1, object() may have a generated hash added
+	const MojObject& definition() const { return m_def; }
 	const StringVec& superIds() const { return m_superIds; }
 	const KindVec& supers() const { return m_supers; }
 	bool hasPrivateData() const { return m_privateData; }
     bool isBuiltin() const { return m_builtin; }
 	MojDbKindEngine* kindEngine() const { return m_kindEngine; }
 	MojInt64 token() const { return m_state->token(); }
+	MojDbKindState* state() const { return m_state.get(); }
 	MojUInt32 version() const { return m_version; }
 	MojUInt32 nsubkinds() const { return (MojUInt32)m_subs.size(); }
 	MojSize hash() const { return m_hash; }
@@ -114,6 +121,7 @@ public:
 	MojErr checkOwnerPermission(MojDbReq& req);
 	MojErr checkExtendPermission(const MojChar* superId, MojDbReq& req);
     MojDbIndex* indexForCollation(const MojDbQuery& query) { return indexForQuery(query); }
+	MojDbIndex* indexForQuery(const MojDbQuery& query) const;
 #ifdef LMDB_ENGINE_SUPPORT
 	void setTxn(MojDbStorageTxn* txn)
 	{
@@ -136,11 +144,13 @@ private:
 	static const MojSize KindIdLenMax = 256;
 
 	bool hasOwnerPermission(MojDbReq& req);
-	MojDbIndex* indexForQuery(const MojDbQuery& query) const;
+	MojErr planQuery(const MojDbQuery& query, MojDbIndex*& indexOut, MojObject* planOut) const;
 	MojDbPermissionEngine::Value objectPermission(const MojChar* op, MojDbReq& req);
 	MojErr deny(MojDbReq& req);
-	MojErr updateIndexes(const MojObject* newObj, const MojObject* oldObj, const MojDbReq& req, MojDbOp op, MojVector<MojDbKind*>& kindVec, MojInt32& idxcount);
-	MojErr updateOwnIndexes(const MojObject* newObj, const MojObject* oldObj, const MojDbReq& req, MojInt32& idxcount);
+	MojErr updateIndexes(const MojObject* newObj, const MojObject* oldObj, const MojDbReq& req, MojDbOp op, MojVector<MojDbKind*>& kindVec, MojInt32& idxcount,
+			const StringVec* changed = NULL);
+	MojErr updateOwnIndexes(const MojObject* newObj, const MojObject* oldObj, const MojDbReq& req, MojInt32& idxcount,
+			const StringVec* changed);
 	MojErr preUpdate(MojObject* newObj, const MojObject* oldObj, MojDbReq& req);
 	MojErr configureIndexes(const MojObject& obj, const MojString& locale, MojDbReq& req);
 	MojErr configureRevSets(const MojObject& obj);
@@ -157,6 +167,7 @@ private:
     MojErr generateHash();
 
 	MojObject m_obj;
+	MojObject m_def;
 	MojString m_id;
 	MojString m_name;
 	MojString m_owner;
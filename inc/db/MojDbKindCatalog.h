@@ -0,0 +1,65 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJDBKINDCATALOG_H_
+#define MOJDBKINDCATALOG_H_
+
+#include "db/MojDbDefs.h"
+#include "core/MojObject.h"
+
+/**
+ * Snapshot of the kind engine, kept in the db directory between a clean close
+ * and the next open.
+ *
+ * The payload is one serialized object: the stored objects of the Kind:1 kinds
+ * in _id order, and for every kind the records it keeps in kinds.db (token set)
+ * and indexIds.db (kind token, index ids, index builds), null if it has none,
+ * along with the planner stats of its indexes that had any.
+ * Open reads the snapshot instead of querying Kind:1 and point-reading the
+ * state of each kind, then deletes it, so a db that was not closed cleanly
+ * since never has one. The header carries the db revision taken at close;
+ * if the db comes back at another revision (e.g. a lazily synced engine lost
+ * writes the snapshot already has) the kinds are loaded from the db. A
+ * snapshot with a bad header, size or checksum is ignored too. Integers are
+ * little endian.
+ *
+ *   header:  "DB8KIND" '\0', u32 version, u64 db revision, u32 payload size,
+ *            u32 payload crc32
+ *   payload: {kinds: [kind], states: {kindId: {tokens: record, ids: record,
+ *             indexStats: {indexName: stats}}}}
+ */
+class MojDbKindCatalog
+{
+public:
+	static const MojChar* const FileName;
+	static const MojChar* const KindsKey;
+	static const MojChar* const StatesKey;
+	static const MojChar* const TokensKey;
+	static const MojChar* const IdsKey;
+	static const MojChar* const IndexStatsKey;
+	static const MojUInt32 Version = 2;
+
+	static MojErr read(const MojChar* dir, MojObject& catalogOut, MojInt64& revOut, bool& foundOut);
+	static MojErr write(const MojChar* dir, const MojObject& catalog, MojInt64 rev);
+	static MojErr remove(const MojChar* dir);
+
+private:
+	static const MojChar Magic[8];
+	static const MojSize HeaderSize = 28;
+};
+
+#endif /* MOJDBKINDCATALOG_H_ */
@@ -46,8 +46,9 @@ public:
 	MojDbKindEngine();
 	~MojDbKindEngine();
 
-	MojErr open(MojDb* db, MojDbReq& req);
+	MojErr open(MojDb* db, MojDbReq& req, const MojChar* catalogDir = NULL);
 	MojErr close();
+	MojErr saveCatalog(const MojChar* dir);
 	MojErr stats(MojObject& objOut, MojDbReq& req, bool verify, MojString *pKind);
 	MojErr updateLocale(const MojChar* locale, MojDbReq& req);
 
@@ -79,11 +80,13 @@ public:
 	MojErr getKind(const MojObject& obj, MojDbKind*& kind);
 	MojErr getKind(const MojChar* kindName, MojDbKind*& kind);
 	MojErr getByOwner (const MojString& owner, MojVector<MojDbKind*>& vect);
+	void preloadState(const MojString& id, MojDbKindState& state);
 
     static MojErr formatKindId(const MojChar* id, MojString& dbIdOut);
 
 private:
 	typedef MojHashMap<MojInt64, MojString> TokMap;
+	typedef MojHashMap<MojString, MojObject, const MojChar*> StateMap;
 	typedef MojErr (MojDbKind::* ConfigUpdateHandler)(const MojObject& obj, const KindMap& map, MojDbStorageTxn* txn);
 	typedef MojErr (MojDbKind::* ConfigDeleteHandler)(const KindMap& map, MojDbStorageTxn* txn);
 
@@ -102,8 +105,12 @@ private:
 	MojErr setupRootKind();
 	MojErr addBuiltin(const MojChar* json, MojDbReq& req);
 	MojErr createKind(const MojString& id, const MojObject& obj, MojDbReq& req, bool builtIn = false);
-	MojErr loadKinds(MojDbReq& req);
+	MojErr loadKinds(MojDbReq& req, const MojObject* catalogKinds);
+	MojErr readCatalog(const MojChar* dir, MojObject& kindsOut, bool& foundOut, MojDbReq& req);
+	MojErr prefetchStates(const MojVector<MojObject>& kinds, MojDbReq& req);
+	void restoreIndexStats();
 
+	class PrefetchJob;
 
 	MojDb* m_db;
 	MojRefCountedPtr<MojDbStorageDatabase> m_kindDb;
@@ -111,7 +118,10 @@ private:
 	MojRefCountedPtr<MojDbStorageSeq> m_indexIdSeq;
 	KindMap m_kinds;
 	TokMap m_tokens;
+	StateMap m_states;
+	MojObject m_indexStats;
 	MojString m_locale;
+	bool m_loadFailed;
 };
 
 #endif /* MOJDBKINDENGINE_H_ */
@@ -25,6 +25,7 @@
 class MojDbKindState : public MojSharedTokenSet
 {
 public:
+	static const MojChar* const IndexBuildsKey;
 	static const MojChar* const IndexIdsKey;
 	static const MojChar* const KindTokensKey;
 	static const MojChar* const TokensKey;
@@ -37,10 +38,20 @@ public:
 	MojErr init(const StringSet& strings, MojDbReq& req);
 	MojErr indexId(const MojChar* indexName, MojDbReq& req, MojObject& idOut, bool& createdOut);
 	MojErr delIndex(const MojChar* indexName, MojDbReq& req);
+	MojErr indexBuild(const MojChar* indexName, MojDbReq& req, MojObject& lastIdOut, bool& foundOut);
+	MojErr updateIndexBuild(const MojChar* indexName, const MojObject& lastId, MojDbReq& req);
+	MojErr delIndexBuild(const MojChar* indexName, MojDbReq& req);
 
 	MojInt64 token() const { return m_kindToken; }
 	virtual MojErr tokenSet(TokenVec& vecOut, MojObject& tokensObjOut) const;
 	virtual MojErr addToken(const MojChar* propName, MojUInt8& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut);
+
+	// serves the kinds.db and indexIds.db records from memory until the first write,
+	// a null record stands for one that doesn't exist
+	void preload(const MojObject& tokensRec, const MojObject& idsRec);
+	MojErr records(MojDbStorageTxn* txn, MojObject& tokensRecOut, MojObject& idsRecOut);
+	static MojErr readRecord(const MojString& kindId, MojDbStorageDatabase* db, MojDbStorageTxn* txn,
+			MojDbKindEngine& kindEngine, MojObject& recOut);
 #ifdef LMDB_ENGINE_SUPPORT
 	void setTxn(MojDbStorageTxn *txn)
 	{
@@ -57,6 +68,7 @@ private:
 #endif
 	MojErr initKindToken(MojDbReq& req);
 	MojErr initTokens(MojDbReq& req, const StringSet& strings);
+	MojErr delBuild(const MojChar* indexName, MojDbReq& req);
 	MojErr id(const MojChar* name, const MojChar* objKey, MojDbReq& req, MojObject& idOut, bool& createdOut);
 	MojErr readIds(const MojChar* key, MojDbReq& req, MojObject& objOut, MojRefCountedPtr<MojDbStorageItem>& itemOut);
 	MojErr writeIds(const MojChar* key, const MojObject& obj, MojDbReq& req, MojRefCountedPtr<MojDbStorageItem>& oldItem);
@@ -64,11 +76,14 @@ private:
 			MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageItem>& oldItem);
 	MojErr readObj(const MojChar* key, MojObject& val, MojDbStorageDatabase* db,
 			MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageItem>& oldItem);
+	MojObject& preloaded(MojDbStorageDatabase* db);
 
 	mutable MojThreadMutex m_lock;
 	MojRefCountedPtr<MojDbStorageItem> m_oldTokensItem;
 	MojString m_kindId;
 	MojObject m_tokensObj;
+	MojObject m_preloadedTokens;
+	MojObject m_preloadedIds;
 	TokenVec m_tokenVec;
 	MojInt64 m_kindToken;
 	MojUInt8 m_nextToken;
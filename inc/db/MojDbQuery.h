@@ -152,6 +152,7 @@ public:
 	MojErr includeDeleted(bool val = true);
 	void desc(bool val) { m_desc = val; }
 	void immediateReturn(bool val) { m_immediateReturn = val; }
+	void explain(bool val) { m_explain = val; }
     void setIgnoreInactiveShards(bool val = true) { m_ignoreInactiveShards = val; }
 	void limit(MojUInt32 numResults) { m_limit = numResults; }
 	void page(const Page& page) { m_page = page; }
@@ -171,6 +172,7 @@ public:
 	const Page& page() const { return m_page; }
 	bool desc() const { return m_desc; }
 	bool immediateReturn() { return m_immediateReturn; }
+	bool explain() const { return m_explain; }
 	MojUInt32 limit() const { return m_limit; }
     bool ignoreInactiveShards() const {return m_ignoreInactiveShards;}
 	bool operator==(const MojDbQuery& rhs) const;
@@ -213,6 +215,7 @@ private:
         bool m_immediateReturn;
 	bool m_desc;
     bool m_ignoreInactiveShards;
+	bool m_explain;			// report the chosen index and its estimate on the cursor
     AggregateMap m_aggregateMap;
     StringSet m_groupByProps;
     MojDbKindEngine* m_kindEngine;
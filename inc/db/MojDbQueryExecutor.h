@@ -0,0 +1,101 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJDBQUERYEXECUTOR_H_
+#define MOJDBQUERYEXECUTOR_H_
+
+#include "db/MojDbDefs.h"
+#include "core/MojAtomicInt.h"
+#include "core/MojObject.h"
+#include "core/MojThread.h"
+#include "core/MojVector.h"
+
+/**
+ * Worker threads shared by all queries on a db for fanning out per-item work
+ * such as loading search results.
+ *
+ * A job covers the items [0, count) and is cut into batches. The workers and
+ * the thread that submitted the job claim batches from it with an atomic
+ * counter, so whoever is free picks up what is left and the submitter never
+ * waits on a queue behind other queries. Every participant of a job gets its
+ * own slot number (0 for the submitter, 1..threads() for workers), which lets
+ * jobs keep results in preallocated per-item or per-slot storage instead of
+ * sharing a locked container.
+ *
+ * Threads are started on first use. When the executor is closed or has no
+ * threads, jobs run entirely on the calling thread.
+ */
+class MojDbQueryExecutor : private MojNoCopy
+{
+public:
+	static const MojChar* const ThreadsKey;
+	static const MojSize ThreadsDefault = N_SEARCH_THREAD;
+	static const MojSize BatchSizeDefault = 8;
+
+	class Job
+	{
+	public:
+		virtual ~Job() {}
+		virtual MojErr run(MojSize begin, MojSize end, MojSize slot) = 0;
+	};
+
+	MojDbQueryExecutor();
+	~MojDbQueryExecutor();
+
+	MojErr configure(const MojObject& conf);
+	MojErr open();
+	MojErr close();
+
+	MojErr run(Job& job, MojSize count, MojSize batchSize = BatchSizeDefault);
+
+	MojSize threads() const { return m_numThreads; }
+	MojSize slots() const { return m_numThreads + 1; }
+
+private:
+	struct Task
+	{
+		Task(Job& job, MojSize count, MojSize batchSize);
+		MojErr runBatches(MojSize slot);
+
+		Job& m_job;
+		MojSize m_count;
+		MojSize m_batchSize;
+		MojInt32 m_numBatches;
+		MojAtomicInt m_next;
+		MojAtomicInt m_failed;
+		MojSize m_active;
+		MojErr m_err;
+	};
+	typedef MojVector<Task*> TaskVec;
+	typedef MojVector<MojThreadT> ThreadVec;
+
+	static MojErr threadMain(void* arg);
+	MojErr start();
+	Task* next();
+	void done(Task* task, MojErr err);
+	void remove(Task* task);
+
+	mutable MojThreadMutex m_mutex;
+	MojThreadCond m_cond;
+	TaskVec m_tasks;
+	ThreadVec m_threads;
+	MojSize m_numThreads;
+	MojSize m_slots;
+	bool m_stop;
+};
+
+#endif /* MOJDBQUERYEXECUTOR_H_ */
@@ -20,6 +20,7 @@
 
 #include "db/MojDbDefs.h"
 #include "db/MojDbQuery.h"
+#include "core/MojObjectView.h"
 
 class MojDbQueryFilter
 {
@@ -28,8 +29,9 @@ public:
 	~MojDbQueryFilter();
 
 	MojErr init(const MojDbQuery& query);
-    MojErr test(const MojObject& obj, bool & ret) const;
-    MojErr findValue(const MojObject obj, const MojString* begin, const MojString* end, MojObject& valOut, bool & ret) const;
+    MojErr test(const MojObject& obj, bool & ret) const { return test(MojObjectView(obj), ret); }
+    MojErr test(const MojObjectView& obj, bool & ret) const;
+    MojErr findValue(const MojObjectView& obj, const MojString* begin, const MojString* end, MojObject& valOut, bool & ret) const;
 
 private:
     class FindSubStringResult
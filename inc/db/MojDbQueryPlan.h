@@ -45,7 +45,7 @@ public:
 	MojDbKindEngine& kindEngine() const { return m_kindEngine; }
 
 private:
-	typedef MojSet<MojDbKey> KeySet;
+	typedef MojFlatSet<MojDbKey> KeySet;
 	typedef MojVector<MojByte> ByteVec;
 
 	MojErr buildRanges(const MojDbIndex& index);
@@ -18,15 +18,37 @@
 #ifndef MOJDBQUOTAENGINE_H_
 #define MOJDBQUOTAENGINE_H_
 
+#include <atomic>
+
 #include "db/MojDbDefs.h"
 #include "db/MojDbPutHandler.h"
+#include "core/MojFlatHashMap.h"
 #include "core/MojMap.h"
+#include "core/MojSet.h"
 #include "core/MojSignal.h"
 #include "core/MojString.h"
-
+#include "core/MojThread.h"
+
+/**
+ * Kind usage is kept in memory, one atomic counter per kind, and quotas are
+ * enforced against the per-owner totals. Committing a txn only adds its
+ * offsets to the counters and to the pending deltas of the current epoch.
+ *
+ * A flush thread closes the epoch every flush interval and folds its deltas
+ * into the usage records in a txn of its own. Before the first commit that
+ * changes a kind in an epoch, the committing txn writes a dirty marker for
+ * the kind; the flush that persists the kind's deltas deletes the marker
+ * again. Markers are keyed by epoch parity, so commits in the next epoch never
+ * write the markers the flush of the previous one deletes. On open, records
+ * of kinds without a marker are exact, kinds with a marker were written after
+ * their last checkpoint and are rescanned.
+ */
 class MojDbQuotaEngine : public MojDbPutHandler
 {
 public:
+	static const MojChar* const FlushIntervalKey;
+	static const MojInt64 FlushIntervalDefault = 1000; // millisecs
+
 	class Quota : public MojRefCounted
 	{
 	public:
@@ -39,9 +61,19 @@ public:
 		void offset(MojInt64 off);
 
 	private:
-		MojInt64 m_size;
-		MojInt64 m_usage;
-		mutable MojThreadMutex m_mutex;
+		std::atomic<MojInt64> m_size;
+		std::atomic<MojInt64> m_usage;
+	};
+
+	class Usage : public MojRefCounted
+	{
+	public:
+		Usage(MojInt64 usage) : m_usage(usage) {}
+		MojInt64 usage() const { return m_usage.load(); }
+		void offset(MojInt64 off) { m_usage.fetch_add(off); }
+
+	private:
+		std::atomic<MojInt64> m_usage;
 	};
 
 	class Offset : public MojSignalHandler
@@ -57,9 +89,10 @@ public:
 		MojString m_kindId;
 		MojInt64 m_offset;
 		MojRefCountedPtr<Quota> m_quota;
+		MojRefCountedPtr<Usage> m_usage;
 	};
 
-	typedef MojMap<MojString, MojRefCountedPtr<Offset>, const MojChar* > OffsetMap;
+	typedef MojFlatHashMap<MojString, MojRefCountedPtr<Offset>, const MojChar* > OffsetMap;
 
 	MojDbQuotaEngine();
 	~MojDbQuotaEngine();
@@ -71,10 +104,12 @@ public:
 	MojErr quotaForOwner(const MojString& owner, MojDbStorageTxn* txn);
 	MojErr curKind(const MojDbKind* kind, MojDbStorageTxn* txn);
 	MojErr applyUsage(MojDbStorageTxn* txn);
+	MojErr commitUsage(MojDbStorageTxn* txn, bool committed);
 	MojErr applyQuota(MojDbStorageTxn* txn);
 	MojErr kindUsage(const MojChar* kindId, MojInt64& usageOut, MojDbStorageTxn* txn);
 	MojErr quotaUsage(const MojChar* owner, MojInt64& sizeOut, MojInt64& usageOut);
 	MojErr refresh();
+	MojErr flush();
 	MojErr stats(MojObject& objOut, MojDbReq& req);
 
 private:
@@ -84,18 +119,54 @@ private:
 	static const MojChar* const UsageDbName;
 
 	typedef MojMap<MojString, MojRefCountedPtr<Quota>, const MojChar*, LengthComp> QuotaMap;
+	typedef MojMap<MojString, MojRefCountedPtr<Usage>, const MojChar*> UsageMap;
+	typedef MojMap<MojString, MojInt64, const MojChar*> DeltaMap;
+	typedef MojSet<MojString> KindSet;
+
+	// what the commits of one epoch did, not yet in the usage records
+	struct Epoch
+	{
+		Epoch() : m_inflight(0) {}
+		MojErr merge(const Epoch& epoch);
 
+		MojSize m_inflight; // txns between applyUsage and commitUsage
+		DeltaMap m_deltas;
+		KindSet m_marked; // kinds whose marker is committed
+		KindSet m_touched; // kinds whose marker any txn wrote, committed or not
+	};
+
+	static MojErr threadMain(void* arg);
+	static MojErr markerKey(const MojString& kindId, MojUInt64 epoch, MojObject& keyOut);
+
+	MojErr startFlush();
+	MojErr stopFlush();
+	MojErr flushImpl(const Epoch& epoch, MojUInt64 epochNum, MojRefCountedPtr<MojDbStorageTxn>& txnOut);
+	MojErr usageForKind(const MojString& kindId, MojDbStorageTxn* txn, MojRefCountedPtr<Usage>& usageOut);
+	MojErr writeMarker(const MojString& kindId, MojUInt64 epoch, MojDbStorageTxn* txn);
+	MojErr insertMarker(const MojObject& key, MojDbStorageTxn* txn);
 	MojErr refreshImpl(MojDbStorageTxn* txn);
 	MojErr quotaForKind(const MojDbKind* kind, MojRefCountedPtr<Quota>& quotaOut);
 	MojErr applyOffset(const MojString& kindId, MojInt64 offset, MojDbStorageTxn* txn);
 	MojErr getUsage(const MojString& kindId, MojDbStorageTxn* txn, bool forUpdate, MojInt64& usageOut, MojRefCountedPtr<MojDbStorageItem>& itemOut);
 	MojErr initUsage(MojDbKind* kind, MojDbReq& req);
 	MojErr insertUsage(const MojString& kindId, MojInt64 usage, MojDbStorageTxn* txn);
+	MojErr updateUsage(const MojString& kindId, MojInt64 usage, MojDbStorageItem* item, MojDbStorageTxn* txn);
 	MojErr commitQuota(const MojString& owner, MojInt64 size);
 
 	bool m_isOpen;
 	QuotaMap m_quotas;
 	MojRefCountedPtr<MojDbStorageDatabase> m_usageDb;
+
+	MojThreadMutex m_flushMutex;
+	MojThreadMutex m_mutex;
+	MojThreadCond m_cond;
+	MojThreadCond m_drained;
+	MojThreadT m_thread;
+	bool m_stop;
+	MojInt64 m_flushInterval;
+	UsageMap m_usages;
+	MojUInt64 m_epoch;
+	Epoch m_epochs[2]; // the open epoch and the one being flushed
 };
 
 #endif /* MOJDBQUOTAENGINE_H_ */
@@ -19,7 +19,9 @@
 #define MOJDBREQ_H_
 
 #include "db/MojDbDefs.h"
+#include "core/MojObjectArena.h"
 #include "core/MojString.h"
+#include "core/MojVector.h"
 
 struct MojDbReqRef
 {
@@ -65,6 +67,12 @@ public:
 	MojInt32 batchsize() {return m_batchSize;}
 	operator MojDbReqRef() { return MojDbReqRef(*this); }	
 	bool schemaLocked() const { return m_schemaLocked; }
+	// indexes the caller empties with a range delete, object updates leave their keys alone
+	MojErr skipIndex(const MojDbIndex* index) { return m_skipIndexes.push(index); }
+	void clearSkipIndexes() { m_skipIndexes.clear(); }
+	bool skipsIndex(const MojDbIndex* index) const { return !m_skipIndexes.empty() && m_skipIndexes.find(index) != MojInvalidIndex; }
+	// scratch space for objects that are gone before the request is
+	MojObjectArena& arena() { return m_arena; }
 
 
 private:
@@ -83,6 +91,8 @@ private:
 	bool m_fixmode;
 	MojInt32 m_batchSize;
 	bool m_autobatch;
+	MojObjectArena m_arena;
+	MojVector<const MojDbIndex*> m_skipIndexes;
 };
 
 class MojDbAdminGuard : private MojNoCopy
@@ -36,7 +36,7 @@ public:
 	MojErr update(MojObject* newObj, const MojObject* oldObj) const;
 
 private:
-	typedef MojSet<MojDbKey> KeySet;
+	typedef MojDbExtractor::KeySet KeySet;
 	typedef MojVector<MojRefCountedPtr<MojDbPropExtractor> > PropVec;
 
 	MojErr diff(MojObject& newObj, const MojObject& oldObj) const;
@@ -22,11 +22,36 @@
 #include "db/MojDbCursor.h"
 #include "core/MojVector.h"
 #include "core/MojThread.h"
-#include <map>
-
+#include <list>
+#include <unordered_map>
+
+/**
+ * Ordered ids of search results, kept so that later pages of a query don't
+ * have to rank all matches again.
+ *
+ * One cache is shared by all kinds of a db. Entries are looked up by the kind
+ * and the query without page and limit, through a hash computed when the key
+ * is built. Each entry remembers the update revision of its kind; a lookup
+ * with a newer revision drops the entry instead of returning it, so writes
+ * invalidate cached queries without walking the cache.
+ *
+ * Entries are charged for the ids they hold and evicted least recently used
+ * first once the cache goes over its byte budget.
+ */
 class MojDbSearchCache : public MojRefCounted
 {
 public :
+    static const MojChar* const SizeKey;
+    static const MojSize SizeDefault = 2 * 1024 * 1024;
+
+    static const MojChar* const EntriesKey;
+    static const MojChar* const BytesKey;
+    static const MojChar* const BudgetKey;
+    static const MojChar* const HitsKey;
+    static const MojChar* const MissesKey;
+    static const MojChar* const EvictionsKey;
+    static const MojChar* const InvalidationsKey;
+
     class QueryKey{
         friend class MojDbSearchCache;
 
@@ -35,47 +60,86 @@ public :
         void setRev(MojUInt32 rev) { m_rev = rev; }
 
         const MojString& getQuery() const { return m_query; }
-        void setQuery(const MojString& a_query) { m_query = a_query; }
+        void setQuery(const MojString& a_query) { m_query = a_query; rehash(); }
         MojErr setQuery(const MojDbQuery& query);
 
         const MojString& getKind() const { return m_kind; }
-        void setKind(const MojString& a_kind) { m_kind = a_kind; }
+        void setKind(const MojString& a_kind) { m_kind = a_kind; rehash(); }
 
+        MojSize hash() const { return m_hash; }
+        bool sameQuery(const QueryKey& rhsKey) const;
         bool operator<(const QueryKey& rhsKey) const;
         bool operator==(const QueryKey& rhsKey) const;
 
         MojErr fromQuery(const MojDbQuery& a_query, MojUInt32 a_revision);
 
     private:
+        void rehash();
+
         MojString m_kind;
         MojUInt32 m_rev = 0U;
         MojString m_query;
+        MojSize m_hash = 0U;
     };
 
     friend class QueryKey;
 
     typedef MojVector<MojObject> IdSet;
-    typedef std::map<QueryKey, IdSet> Container;
 
     MojDbSearchCache() :
         shardStatusChanged([this] (const MojDbShardInfo &) { return wipeWholeCache(); })
     {}
 
-    const Container& container() const { return m_container; }
+    MojErr configure(const MojObject& conf);
+
     MojErr createCache(const QueryKey& a_key, const IdSet& a_ids);
     MojErr destroyCache(const QueryKey& a_key);
     MojErr destroyCache(const MojString& a_kind);
     MojErr wipeWholeCache();
     MojErr updateCache(const QueryKey& key, const IdSet& ids);
     MojErr getIdSet(const QueryKey& a_key, IdSet& a_ids) const;
+    MojErr find(const QueryKey& a_key, IdSet& a_ids, bool& foundOut);
 
     bool contain(const QueryKey& a_key) const;
+    MojSize size() const;
+    MojSize bytes() const;
+    MojSize budget() const;
+    MojErr stats(MojObject& objOut) const;
 
     MojDbShardInfo::Signal::EasySlot shardStatusChanged;
 
 private :
-    Container m_container;
-    mutable MojThreadRwLock m_lock;
+    struct Entry
+    {
+        QueryKey m_key;
+        IdSet m_ids;
+        MojSize m_bytes;
+    };
+    typedef std::list<Entry> EntryList;
+    struct KeyHash
+    {
+        size_t operator()(const QueryKey& key) const { return key.hash(); }
+    };
+    struct KeyEq
+    {
+        bool operator()(const QueryKey& key1, const QueryKey& key2) const { return key1.sameQuery(key2); }
+    };
+    typedef std::unordered_map<QueryKey, EntryList::iterator, KeyHash, KeyEq> Index;
+
+    static MojSize entryBytes(const QueryKey& key, const IdSet& ids);
+    void erase(Index::iterator iter);
+    void evict();
+
+    // most recently used entry first
+    EntryList m_entries;
+    Index m_index;
+    MojSize m_bytes = 0U;
+    MojSize m_budget = SizeDefault;
+    MojInt64 m_hits = 0;
+    MojInt64 m_misses = 0;
+    MojInt64 m_evictions = 0;
+    MojInt64 m_invalidations = 0;
+    mutable MojThreadMutex m_mutex;
 };
 
 #endif /* MOJDBSEARCHCACHE_H_ */
@@ -22,7 +22,10 @@
 #include "db/MojDbObjectItem.h"
 #include "db/MojDbSearchCache.h"
 #include "db/MojDbQuery.h"
+#include "core/MojFlatHashMap.h"
+#include "core/MojFlatSet.h"
 #include <map>
+#include <vector>
 
 class MojDbSearchCursor : public MojDbCursor
 {
@@ -45,34 +48,60 @@ private:
 			return i1->sortKeys().compare(i2->sortKeys());
 		}
 	};
-	struct ObjectInfo {
+	class LoadJob;
+	class KeyJob;
+	typedef MojFlatSet<MojDbKey> KeySet;
+	typedef MojFlatSet<MojObject> ObjectSet;
+	typedef MojVector<MojObject> ObjectVec;
+	typedef MojFlatHashMap<MojUInt32, MojSharedPtr<ObjectVec> > GroupMap;
+	typedef MojVector<MojRefCountedPtr<MojDbObjectItem>, MojEq<MojRefCountedPtr<MojDbObjectItem> >, ItemComp > ItemVec;
+	typedef MojVector<MojRefCountedPtr<MojDbPropExtractor> > ExtractorVec;
+	typedef std::vector<const MojObject*> IdVec;
+
+	// a matching id and the sort key of its order prop, ranked before any object is loaded
+	struct SortEntry
+	{
+		SortEntry() : id(NULL), found(false) {}
 		const MojObject* id;
-		MojUInt32 seqNum;
+		KeySet keys;
+		bool found;
+	};
+	typedef std::vector<SortEntry> EntryVec;
+	typedef std::vector<const SortEntry*> EntryPtrVec;
+	struct EntryComp
+	{
+		EntryComp(bool desc) : m_desc(desc) {}
+		bool operator()(const SortEntry* e1, const SortEntry* e2) const
+		{
+			// ids break ties so pages are stable however the entries were ranked
+			int c = e1->keys.compare(e2->keys);
+			if (c == 0)
+				c = e1->id->compare(*e2->id);
+			return m_desc ? c > 0 : c < 0;
+		}
+		bool m_desc;
 	};
-	typedef MojSet<MojDbKey> KeySet;
-	typedef MojSet<MojObject> ObjectSet;
-	typedef MojMap<MojUInt32, MojSharedPtr<ObjectSet> > GroupMap;
-	typedef MojMap<MojUInt32, MojRefCountedPtr<MojDbObjectItem> > SequencedItems;
-	typedef MojVector<MojRefCountedPtr<MojDbObjectItem>, MojEq<MojRefCountedPtr<MojDbObjectItem> >, ItemComp > ItemVec;
 
 	static const MojUInt32 MaxResults = 10000;
 
 	virtual MojErr setPagePosition();
 	virtual MojErr getIds(MojDbSearchCache::IdSet& sortedId);
-	virtual MojErr loadFromCache(const MojDbSearchCache* cache);
+	virtual MojErr loadFromCache(const MojDbSearchCache::IdSet& ids);
 	virtual MojErr init(const MojDbQuery& query);
 
     MojErr retrieveCollation(const MojDbQuery& query);
 	bool loaded() const { return m_pos != NULL; }
 	MojErr begin();
-	MojErr load(MojDbSearchCache* a_cache, bool fromCache);
+	MojErr load(MojDbSearchCache* a_cache, bool fromCache, const MojDbSearchCache::IdSet& cachedIds);
 	MojErr loadIds(ObjectSet& idsOut);
-	MojErr loadObjects(const ObjectSet& ids);
-	static void searchThread_caller(void *arg, void *user_data);
-	MojErr searchThread_callee(const ObjectInfo *a_info);
+	MojErr loadRanked(MojDbSearchCache* a_cache);
+	MojErr loadKeys(const ObjectSet& ids, EntryVec& entriesOut);
+	MojErr loadKey(const MojObject& id, MojDbPropExtractor* extractor, SortEntry& entryOut);
+	MojErr rank(EntryPtrVec& entries, MojSize& startOut, bool fullOrder);
+	MojErr createExtractor(MojRefCountedPtr<MojDbPropExtractor>& extractorOut);
+	MojErr loadObjects(const IdVec& ids);
+	MojErr loadObject(const MojObject& id, MojRefCountedPtr<MojDbObjectItem>& itemOut);
         MojErr loadWithImmediateReturn();
-	MojErr sort();
-	MojErr distinct();
     const MojDbQuery::Page& page() const { return m_page; }
 
 	ItemVec m_items;
@@ -83,12 +112,10 @@ private:
 	ItemVec::ConstIterator m_pos;
 	ItemVec::ConstIterator m_limitPos;
 	MojString m_locale;
-	SequencedItems m_sequencedItems;
     MojDbCollationStrength m_collation;
     MojDbQuery::Page m_page;
     MojObject m_pageObject;
     MojUInt32 m_count;
     MojDbSearchCache::QueryKey m_queryKey;
     MojDbQuery m_cacheQuery;
-    MojThreadMutex m_items_mutex;
 };
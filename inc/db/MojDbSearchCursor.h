@@ -21,6 +21,8 @@
 #include "db/MojDbDefs.h"
 #include "db/MojDbCursor.h"
 #include "db/MojDbObjectItem.h"
+#include "core/MojFlatHashMap.h"
+#include "core/MojFlatSet.h"
 
 #ifdef WITH_SEARCH_QUERY_CACHE
 #include "db/MojDbSearchCacheCursor.h"
@@ -47,14 +49,11 @@ private:
 			return i1->sortKeys().compare(i2->sortKeys());
 		}
 	};
-	struct ObjectInfo {
-		const MojObject* id;
-		MojUInt32 seqNum;
-	};
-	typedef MojMap<MojUInt32, MojRefCountedPtr<MojDbObjectItem> > SequencedItems;
-	typedef MojSet<MojDbKey> KeySet;
-	typedef MojSet<MojObject> ObjectSet;
-	typedef MojMap<MojUInt32, MojSharedPtr<ObjectSet> > GroupMap;
+	class LoadJob;
+	typedef MojFlatSet<MojDbKey> KeySet;
+	typedef MojFlatSet<MojObject> ObjectSet;
+	typedef MojVector<MojObject> ObjectVec;
+	typedef MojFlatHashMap<MojUInt32, MojSharedPtr<ObjectVec> > GroupMap;
 	typedef MojVector<MojRefCountedPtr<MojDbObjectItem>, MojEq<MojRefCountedPtr<MojDbObjectItem> >, ItemComp > ItemVec;
 
 	static const MojUInt32 MaxResults = 10000;
@@ -66,8 +65,7 @@ private:
 	MojErr load();
 	MojErr loadIds(ObjectSet& idsOut);
 	MojErr loadObjects(const ObjectSet& ids);
-	static void searchThread_caller(void *arg, void *user_data);
-	MojErr searchThread_callee(const ObjectInfo* a_info);
+	MojErr loadObject(const MojObject& id, MojRefCountedPtr<MojDbObjectItem>& itemOut);
         MojErr loadWithImmediateReturn();
 	MojErr sort();
 	MojErr distinct();
@@ -81,11 +79,9 @@ private:
 	ItemVec::ConstIterator m_pos;
 	ItemVec::ConstIterator m_limitPos;
 	MojString m_locale;
-	SequencedItems m_sequencedItems;
     MojDbCollationStrength m_collation;
     MojDbQuery::Page m_page;
     MojUInt32 m_count;
-    MojThreadMutex m_items_mutex;
 };
 
 #endif // WITH_SEARCH_QUERY_CACHE
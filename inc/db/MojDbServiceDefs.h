@@ -27,15 +27,20 @@ public:
 	static const MojChar* const BytesKey;
 	static const MojChar* const CallerKey;
 	static const MojChar* const CountKey;
+	static const MojChar* const CollationCacheKey;
+	static const MojChar* const CompactionKey;
 	static const MojChar* const CountryCodeKey;
 	static const MojChar* const CreateKey;
 	static const MojChar* const DeleteKey;
 	static const MojChar* const DeletedRevKey;
 	static const MojChar* const DescriptionKey;
 	static const MojChar* const DirKey;
+	static const MojChar* const DispatcherKey;
+	static const MojChar* const ExplainKey;
 	static const MojChar* const ExtendKey;
 	static const MojChar* const FilesKey;
 	static const MojChar* const FiredKey;
+	static const MojChar* const FormatKey;
 	static const MojChar* const FullKey;
 	static const MojChar* const HasMoreKey;
 	static const MojChar* const IdKey;
@@ -73,6 +78,7 @@ public:
 	static const MojChar* const RevKey;
     static const MojChar* const ShardIdKey;
 	static const MojChar* const SizeKey;
+	static const MojChar* const SearchCacheKey;
 	static const MojChar* const ServiceKey;
 	static const MojChar* const SubscribeKey;
 	static const MojChar* const TypeKey;
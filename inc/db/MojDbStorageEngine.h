@@ -26,6 +26,7 @@
 #include "db/MojDbIdGenerator.h"
 #include "core/MojAutoPtr.h"
 #include "core/MojObject.h"
+#include "core/MojObjectView.h"
 #include "core/MojVector.h"
 #include "core/MojHashMap.h"
 #include "core/MojSet.h"
@@ -39,6 +40,7 @@ class MojDbEnv : public MojRefCounted
     virtual MojErr open(const MojChar* path) = 0;
 };
 
+class MojDbItemView;
 class MojDbStorageItem : public MojRefCounted
 {
 public:
@@ -49,13 +51,41 @@ public:
 	virtual const MojObject& id() const = 0;
 	virtual MojSize size() const = 0;
 
-	MojErr toObject(MojObject& objOut, MojDbKindEngine& kindEngine, bool headerExpected = true) const;
+	MojErr toObject(MojObject& objOut, MojDbKindEngine& kindEngine, bool headerExpected = true, MojObjectArena* arena = NULL) const;
 	MojErr toJson(MojString& strOut, MojDbKindEngine& kindEngine) const;
+	// engines that store records in MojObjectWriter format override this to view them in place
+	virtual MojErr view(MojDbItemView& viewOut, MojDbKindEngine& kindEngine) const;
 
 protected:
 	MojObject m_id;
 };
 
+/**
+ * Owns whatever backs a MojObjectView of a stored object: either the storage
+ * item itself plus the kind's token set and the record header, or an object
+ * materialized by engines that can't be viewed in place.
+ */
+class MojDbItemView : private MojNoCopy
+{
+public:
+	const MojObjectView& view() const { return m_view; }
+	MojErr toObject(MojObject& objOut) const { return m_view.toObject(objOut); }
+
+	void assign(const MojObject& obj);
+	void assign(const MojDbStorageItem* item, const MojByte* data, MojSize size);
+	void release();
+	MojObject& header() { return m_header; }
+	MojErr tokenSet(const MojString& kindId, MojDbKindEngine& kindEngine);
+
+private:
+	MojRefCountedPtr<MojDbStorageItem> m_item;
+	MojTokenSet m_tokenSet;
+	MojString m_tokenKind; //!< kind m_tokenSet was taken from, a view reused across records keeps it
+	MojObject m_header;
+	MojObject m_obj;
+	MojObjectView m_view;
+};
+
 class MojDbKindEngine;
 class MojDbStorageQuery : public MojRefCounted
 {
@@ -70,6 +100,8 @@ public:
 	virtual MojErr getId(MojObject& idOut, MojUInt32& groupOut, bool& foundOut) = 0;
 	virtual MojErr getById(const MojObject& id, MojDbStorageItem*& itemOut, bool& foundOut) = 0;
 	virtual MojErr getById(const MojObject& id, MojObject& itemOut, bool& foundOut, MojDbKindEngine* kindEngine) { return MojErrNotImplemented; }
+	// same as getById, but lets callers test the object before paying for a MojObject
+	virtual MojErr getViewById(const MojObject& id, MojDbItemView& viewOut, bool& foundOut, MojDbKindEngine* kindEngine);
 	virtual MojErr count(MojUInt32& countOut) = 0;
 	virtual MojErr nextPage(MojDbQuery::Page& pageOut) = 0;
 	virtual void excludeKinds(const StringSet& toExclude) { m_excludeKinds = toExclude; }
@@ -78,11 +110,15 @@ public:
 	StringSet& excludeKinds() { return m_excludeKinds; }
 	bool verify() { return m_verify; }
 	void verify(bool bVal) { m_verify = bVal; }
+	// engines may prefetch primary records ahead of the cursor when the txn is read-only
+	bool batchJoin() { return m_batchJoin; }
+	void batchJoin(bool bVal) { m_batchJoin = bVal; }
 
 protected:
 	MojDbKey m_endKey;
 	StringSet m_excludeKinds;
 	bool m_verify = false;
+	bool m_batchJoin = false;
 
 };
 
@@ -142,6 +178,8 @@ private:
 	bool m_refreshQuotas;
 	MojDbQuotaEngine* m_quotaEngine;
 	MojDbQuotaEngine::OffsetMap m_offsetMap;
+	MojUInt64 m_usageEpoch;
+	bool m_usageApplied;
 	MojRefCountedPtr<MojDbQuotaEngine::Offset> m_curQuotaOffset;
 	MojSet<Monitor*> m_monitors;
 	CommitSignal m_preCommit;
@@ -174,6 +212,9 @@ public:
 	virtual ~MojDbStorageIndex() {}
 	virtual MojErr insert(const MojDbKey& key, MojDbStorageTxn* txn) = 0;
 	virtual MojErr del(const MojDbKey& key, MojDbStorageTxn* txn) = 0;
+	// deletes every key in [from, to) in one ordered pass, quota is offset as for del
+	virtual MojErr delRange(const MojDbKey& from, const MojDbKey& to, MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut)
+	{ return MojErrNotImplemented; }
 };
 
 class MojDbStorageDatabase : public MojDbStorageCollection
@@ -232,6 +273,8 @@ public:
     { return m_index->insert(key, txn); }
     MojErr del(MojDbShardId /* shardId */, const MojDbKey& key, MojDbStorageTxn* txn) override
     { return m_index->del(key, txn); }
+    MojErr delRange(const MojDbKey& from, const MojDbKey& to, MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut) override
+    { return m_index->delRange(from, to, txn, countOut, sizeOut); }
 };
 
 class MojDbStorageExtDatabase : public MojDbStorageDatabase
@@ -326,6 +369,8 @@ public:
     virtual MojErr open(const MojChar* path, MojDbEnv * env) = 0;
     virtual MojErr close() = 0;
     virtual MojErr compact() = 0;
+    // progress and debt of background compaction, left empty by engines without it
+    virtual MojErr compactionStats(MojObject& objOut) { return MojErrNone; }
 #ifdef LMDB_ENGINE_SUPPORT
     virtual MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut, bool isWriteOp = false) = 0;
     virtual MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnParent, MojRefCountedPtr<MojDbStorageTxn>& txnOut) {
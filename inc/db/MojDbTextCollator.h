@@ -19,13 +19,85 @@
 #define MOJDBTEXTCOLLATOR_H_
 
 #include "db/MojDbDefs.h"
+#include "db/MojDbKey.h"
 #include "db/MojDbTextUtils.h"
 #include "core/MojHashMap.h"
 #include "core/MojRefCount.h"
+#include "core/MojString.h"
 #include "core/MojThread.h"
+#include "core/MojUtil.h"
+#include <list>
+#include <unordered_map>
 
 struct UCollator;
 
+/**
+ * Process-wide cache of collation sort keys.
+ *
+ * Keys are computed by ICU and stored in index entries, so the same string
+ * collated with the same locale and strength always yields the same key and
+ * entries never go stale. The cache is split into shards, each with its own
+ * lock and LRU list, so concurrent puts and queries rarely contend. Size is
+ * bounded by "collationCacheSize" bytes in the db configuration.
+ */
+class MojDbSortKeyCache : private MojNoCopy
+{
+public:
+	static const MojChar* const SizeKey;
+	static const MojChar* const EntriesKey;
+	static const MojChar* const BytesKey;
+	static const MojChar* const HitsKey;
+	static const MojChar* const MissesKey;
+	static const MojSize SizeDefault = 1024 * 1024;
+	static const MojSize MaxStringLen = 128; // longer strings are not cached
+
+	MojDbSortKeyCache();
+
+	MojErr configure(const MojObject& conf);
+	bool get(const MojString& key, MojDbKey& valOut);
+	void put(const MojString& key, const MojDbKey& val);
+	void clear();
+	MojErr stats(MojObject& objOut) const;
+
+	MojSize size() const;
+	MojInt64 hits() const;
+	MojInt64 misses() const;
+
+private:
+	static const MojSize NumShards = 16;
+
+	struct Entry
+	{
+		MojString m_key;
+		MojDbKey m_val;
+		MojSize m_bytes;
+	};
+	struct KeyHash
+	{
+		MojSize operator()(const MojString& key) const { return MojHash(key.data(), key.length()); }
+	};
+	typedef std::list<Entry> EntryList;
+	typedef std::unordered_map<MojString, EntryList::iterator, KeyHash> Index;
+
+	struct Shard
+	{
+		Shard() : m_bytes(0), m_hits(0), m_misses(0) {}
+
+		mutable MojThreadMutex m_mutex;
+		EntryList m_entries; // most recently used first
+		Index m_index;
+		MojSize m_bytes;
+		MojInt64 m_hits;
+		MojInt64 m_misses;
+	};
+
+	Shard& shard(const MojString& key);
+	void evict(Shard& shard, MojSize budget);
+
+	Shard m_shards[NumShards];
+	MojAtomicInt m_budget; // per shard
+};
+
 class MojDbTextCollator : public MojRefCounted
 {
 public:
@@ -36,8 +108,15 @@ public:
 	MojErr sortKey(const MojString& str, MojDbKey& keyOut) const;
 	MojErr sortKey(const UChar* chars, MojSize size, MojDbKey& keyOut) const;
 
+	static MojDbSortKeyCache& keyCache();
+
 private:
+	static const MojSize AsciiMax = MojDbSortKeyCache::MaxStringLen;
+
+	MojErr sortKeyUncached(const MojString& str, MojDbKey& keyOut) const;
+
 	UCollator* m_ucol;
+	MojString m_cacheTag; // locale and strength, prefixes cache keys
 };
 
 #endif /* MOJDBTEXTCOLLATOR_H_ */
@@ -20,31 +20,39 @@
 
 #include "db/MojDbDefs.h"
 #include "core/MojRefCount.h"
-#include "core/MojSet.h"
+#include "core/MojFlatSet.h"
+#include "core/MojString.h"
+#include "core/MojVector.h"
 #include "unicode/ubrk.h"
 
+/**
+ * Splits text into word tokens and turns each token into an index key.
+ *
+ * Break iterators are expensive to open, so every thread keeps one per locale
+ * and re-targets it for each text. Tokens are collected in a flat vector and
+ * deduplicated by sorting instead of going through a MojSet node per token.
+ */
 class MojDbTextTokenizer : public MojRefCounted
 {
 public:
-	typedef MojSet<MojDbKey> KeySet;
+	typedef MojFlatSet<MojDbKey> KeySet;
+	typedef MojVector<MojDbKey> KeyVec;
 
 	MojDbTextTokenizer();
 	~MojDbTextTokenizer();
 
 	MojErr init(const MojChar* locale);
 	MojErr tokenize(const MojString& text, MojDbTextCollator* collator, KeySet& keysOut) const;
+	// keysOut is sorted and has no duplicates
+	MojErr tokenize(const MojString& text, MojDbTextCollator* collator, KeyVec& keysOut) const;
+	// tokens of newText missing from oldText go to addedOut, the reverse to removedOut
+	MojErr diff(const MojString& oldText, const MojString& newText, MojDbTextCollator* collator,
+			KeyVec& addedOut, KeyVec& removedOut) const;
 
 private:
-	struct IterCloser
-	{
-		void operator()(UBreakIterator* ubrk)
-		{
-			ubrk_close(ubrk);
-		}
-	};
-	typedef MojAutoPtrBase<UBreakIterator, IterCloser> IterPtr;
-
-	IterPtr m_ubrk;
+	MojErr breakIter(UBreakIterator*& iterOut) const;
+
+	MojString m_locale;
 };
 
 #endif /* MOJDBTEXTTOKENIZER_H_ */
@@ -49,6 +49,7 @@ public:
 	MojErr close();
 	MojErr del();
 	MojErr delPrefix(const MojDbKey& prefix);
+	MojErr delRange(const MojDbKey& from, const MojDbKey& to, MojSize& countOut, MojSize& sizeOut);
 	MojErr get(MojDbBerkeleyItem& key, MojDbBerkeleyItem& val, bool& foundOut, MojUInt32 flags);
 	MojErr stats(MojSize& countOut, MojSize& sizeOut);
 	MojErr statsPrefix(const MojDbKey& prefix, MojSize& countOut, MojSize& sizeOut);
@@ -203,6 +204,7 @@ public:
 	virtual MojErr stats(MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut);
 	virtual MojErr insert(const MojDbKey& key, MojDbStorageTxn* txn);
 	virtual MojErr del(const MojDbKey& key, MojDbStorageTxn* txn);
+	virtual MojErr delRange(const MojDbKey& from, const MojDbKey& to, MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut);
 	virtual MojErr find(MojAutoPtr<MojDbQueryPlan> plan, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageQuery>& queryOut);
 	virtual MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut);
 
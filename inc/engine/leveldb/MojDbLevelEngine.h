@@ -20,13 +20,14 @@
 #include <leveldb/db.h>
 #include "db/MojDbDefs.h"
 #include "db/MojDbStorageEngine.h"
+#include "db/MojDbCompactScheduler.h"
 #include "core/MojLogDb8.h"
 
 class MojDbLevelDatabase;
 class MojDbLevelEnv;
 class MojDbLevelSeq;
 
-class MojDbLevelEngine : public MojDbStorageEngine
+class MojDbLevelEngine : public MojDbStorageEngine, private MojDbCompactScheduler::Compactor
 {
 public:
     MojDbLevelEngine();
@@ -38,6 +39,7 @@ public:
     virtual MojErr open(const MojChar* path, MojDbEnv* env);
     virtual MojErr close();
     virtual MojErr compact();
+    virtual MojErr compactionStats(MojObject& objOut);
 #ifdef LMDB_ENGINE_SUPPORT
     virtual MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut, bool isWriteOp = false);
 #else
@@ -55,6 +57,10 @@ public:
 
     MojDbLevelDatabase* indexDb() { return m_indexDb.get(); }
 
+    MojDbCompactScheduler& compactScheduler() { return m_compactScheduler; }
+    // scheduler part of a database: its leveldb handle
+    static void partId(const leveldb::DB* db, std::string& partOut);
+
     static const leveldb::WriteOptions& getWriteOptions() { return WriteOptions; }
     static const leveldb::ReadOptions& getReadOptions() { return ReadOptions; }
     static const leveldb::Options& getOpenOptions() { return OpenOptions; }
@@ -62,6 +68,8 @@ private:
     typedef MojVector<MojRefCountedPtr<MojDbLevelDatabase> > DatabaseVec;
     typedef MojVector<MojRefCountedPtr<MojDbLevelSeq> > SequenceVec;
 
+    virtual MojErr compactRange(const std::string& part, const std::string& from, const std::string& to);
+
     MojRefCountedPtr<MojDbLevelEnv> m_env;
     MojThreadMutex m_dbMutex;
     MojRefCountedPtr<MojDbLevelDatabase> m_indexDb;
@@ -74,6 +82,8 @@ private:
     static leveldb::ReadOptions ReadOptions;
     static leveldb::WriteOptions WriteOptions;
     static leveldb::Options OpenOptions;
+
+    MojDbCompactScheduler m_compactScheduler;
 };
 
 #endif /* MOJDBLEVELENGINE_H_ */
@@ -28,6 +28,7 @@
 #include <core/MojString.h>
 #include <core/MojErr.h>
 #include <db/MojDbStorageEngine.h>
+#include <db/MojDbCompactScheduler.h>
 
 namespace leveldb
 {
@@ -64,6 +65,8 @@ public:
     void detach(MojDbLevelTxnIterator *it);
 
     MojErr commitImpl();
+    // key range and volume of the pending writes
+    void touched(MojDbCompactScheduler::Range& rangeOut) const;
 
 private:
     void cleanup();
@@ -99,6 +102,7 @@ private:
 
     typedef std::list<MojSharedPtr<MojDbLevelTableTxn> > TableTxns;
     TableTxns m_tableTxns;
+    MojDbLevelEngine* m_engine = nullptr;
 };
 
 // Note: Current workaround uses EnvTxn not only for Env transaction but for
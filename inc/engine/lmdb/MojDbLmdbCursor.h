@@ -33,6 +33,7 @@ public:
 	void close();
 	MojErr del();
 	MojErr delPrefix(const MojDbKey& prefix);
+	MojErr delRange(const MojDbKey& from, const MojDbKey& to, MojSize& countOut, MojSize& sizeOut);
 	MojErr get(MojDbLmdbItem& key, MojDbLmdbItem& val, bool& foundOut, MDB_cursor_op flags);
 	MojErr stats(MojSize& countOut, MojSize& sizeOut);
 	MojErr statsPrefix(const MojDbKey& prefix, MojSize& countOut, MojSize& sizeOut);
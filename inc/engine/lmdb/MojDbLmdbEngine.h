@@ -57,6 +57,7 @@ private:
 	MojRefCountedPtr<MojDbLmdbDatabase> m_indexDb;
 	MojRefCountedPtr<MojDbLmdbDatabase> m_seqDb;
 	MojString m_path;
+	MojObject m_conf;
 	MojThreadMutex m_dbMutex;
 	DatabaseVec m_dbs;
 	SequenceVec m_seqs;
@@ -37,6 +37,11 @@ public:
 	{
 		return m_env;
 	}
+	// read-only txns hand out items that point straight into the map
+	bool zeroCopyReads() const
+	{
+		return m_zeroCopyReads;
+	}
 
 private:
 	static const MojChar* const LockFileName;
@@ -48,6 +53,7 @@ private:
 	MojFile m_lockFile;
 	MDB_env* m_env;
 	MojObject m_conf;
+	bool m_zeroCopyReads;
 };
 
 #endif /* MOJDBLMDBENV_H_ */
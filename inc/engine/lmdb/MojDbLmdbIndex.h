@@ -32,6 +32,7 @@ public:
 	MojErr stats(MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut);
 	MojErr insert(const MojDbKey& key, MojDbStorageTxn* txn);
 	MojErr del(const MojDbKey& key, MojDbStorageTxn* txn);
+	MojErr delRange(const MojDbKey& from, const MojDbKey& to, MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut);
 	MojErr find(MojAutoPtr<MojDbQueryPlan> plan, MojDbStorageTxn* txn,
 			MojRefCountedPtr<MojDbStorageQuery>& queryOut);
 	MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut, bool isWriteOp = false);
@@ -55,12 +55,19 @@ public:
 	MojErr fromObject(const MojObject& obj);
 	void setHeader(const MojObject& id);
         void fromBytesNoCopy(const MojByte* bytes, MojSize size);
+	void fromMap(const MojByte* bytes, MojSize size);
+	bool borrowed() const
+	{
+		return m_borrowed;
+	}
+	MojErr detach();
 	void clear();
 private:
 	void freeData();
 	void setData(MojByte* bytes, MojSize size, void (*free)(void*));
 
 	void (*m_free)(void*);
+	bool m_borrowed;
 	MDB_val m_dbt;
 	MojAutoPtr<MojBuffer::Chunk> m_chunk;
 	mutable MojDbObjectHeader m_header;
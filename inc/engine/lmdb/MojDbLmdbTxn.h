@@ -20,6 +20,8 @@
 #include <lmdb.h>
 #include <db/MojDbStorageEngine.h>
 #include <engine/lmdb/MojDbLmdbEngine.h>
+#include <engine/lmdb/MojDbLmdbItem.h>
+#include "core/MojVector.h"
 class MojDbLmdbEngine;
 class MojDbLmdbTxn: public MojDbStorageTxn
 {
@@ -40,11 +42,22 @@ public:
 	}
 	MojErr reset();
 	MojErr renew();
+	// true if reads in this txn may point items into the map instead of copying
+	bool zeroCopy() const
+	{
+		return m_zeroCopy;
+	}
+	MojErr lend(MojDbLmdbItem* item);
 private:
+	typedef MojVector<MojRefCountedPtr<MojDbLmdbItem> > ItemVec;
+
 	virtual MojErr commitImpl();
+	MojErr detachLent();
 
 	MojDbLmdbEngine* m_engine;
 	MDB_txn* m_txn;
+	bool m_zeroCopy;
+	ItemVec m_lent;
 };
 
 #endif /* MOJDBLMDBTXN_H_ */
@@ -18,6 +18,10 @@
 #define MOJDBLEVELDATABASE_H
 
 #include <leveldb/db.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "db/MojDbDefs.h"
 #include "db/MojDbStorageEngine.h"
 #include "MojDbSandwichEngine.h"
@@ -57,9 +61,12 @@ public:
     MojErr put(MojDbShardId shardId, MojDbSandwichItem& key, MojDbSandwichItem& val, MojDbStorageTxn* txn, bool updateIdQuota);
     MojErr del(MojDbShardId shardId, MojDbSandwichItem& key, bool& foundOut, MojDbStorageTxn* txn);
     MojErr get(MojDbShardId shardId, MojDbSandwichItem& key, MojDbStorageTxn* txn, bool forUpdate, MojDbSandwichItem& valOut, bool& foundOut);
+    MojErr multiGet(MojDbShardId shardId, std::vector<std::string>& keys, MojDbSandwichEnvTxn& txn,
+                    std::unordered_map<std::string, std::string>& valsOut, std::unordered_set<std::string>& missesOut);
     void   compact();
 
     MojErr delPrefix(MojDbSandwichEnvTxn &txn, leveldb::Slice prefix = {});
+    MojErr delRange(MojDbSandwichEnvTxn &txn, leveldb::Slice from, leveldb::Slice to, MojSize& countOut, MojSize& sizeOut);
     MojErr stats(MojDbSandwichEnvTxn* txn, MojSize &countOut, MojSize &sizeOut, leveldb::Slice prefix);
 
     bool valid() const { return m_name; }
@@ -20,6 +20,7 @@
 #include <leveldb/db.h>
 #include "db/MojDbDefs.h"
 #include "db/MojDbStorageEngine.h"
+#include "db/MojDbCompactScheduler.h"
 #include "core/MojLogDb8.h"
 
 #include "leveldb/sandwich_db.hpp"
@@ -28,6 +29,7 @@
 #include "leveldb/txn_db.hpp"
 
 #include "pool.hpp"
+#include "engine/sandwich/MojDbSandwichGroupCommit.h"
 
 class MojDbSandwichDatabase;
 class MojDbSandwichEnv;
@@ -72,11 +74,13 @@ namespace mojo {
     { return {p, [&c](SandwichTxn &s) { return use(s, c); }}; }
 } // namespace mojo
 
-class MojDbSandwichEngine final : public MojDbStorageEngine
+class MojDbSandwichEngine final : public MojDbStorageEngine, private MojDbCompactScheduler::Compactor
 {
 public:
     typedef mojo::Sandwich BackendDb;
 
+    static const MojSize JoinWindowDefault = 64;
+
     MojDbSandwichEngine();
     ~MojDbSandwichEngine();
 
@@ -90,6 +94,7 @@ public:
     virtual MojErr open(const MojChar* path, MojDbEnv* env);
     virtual MojErr close();
     virtual MojErr compact();
+    MojErr compactionStats(MojObject& objOut) override;
 #ifdef LMDB_ENGINE_SUPPORT
     virtual MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut, bool isWriteOp = false);
 #else
@@ -125,14 +130,25 @@ public:
     static const leveldb::WriteOptions& getWriteOptions() { return WriteOptions; }
     static const leveldb::ReadOptions& getReadOptions() { return ReadOptions; }
     static const leveldb::Options& getOpenOptions() { return OpenOptions; }
+    static MojSize getJoinWindow() { return JoinWindow; }
 
     MojDbSandwichLazyUpdater* getUpdater() const { return m_updater; }
     bool lazySync() const { return m_lazySync; }
+    MojDbSandwichGroupCommit& groupCommit() { return m_groupCommit; }
+    // makes writes done outside of a txn durable when the bottoms don't sync
+    MojErr syncShard(MojDbShardId shardId);
+
+    MojDbCompactScheduler& compactScheduler() { return m_compactScheduler; }
+    // scheduler part of a sandwich part: shard id followed by the cookie
+    static void partId(MojDbShardId shardId, const mojo::Sandwich::Cookie &cookie, std::string &partOut);
 
 private:
     typedef MojVector<MojRefCountedPtr<MojDbSandwichDatabase> > DatabaseVec;
     typedef MojVector<MojRefCountedPtr<MojDbSandwichSeq> > SequenceVec;
 
+    leveldb::WriteOptions bottomWriteOptions() const;
+    MojErr compactRange(const std::string& part, const std::string& from, const std::string& to) override;
+
     mojo::Sandwiches m_sandwiches = {
         // pre-defined main shard
         { MojDbIdGenerator::MainShardId, std::make_shared<mojo::Sandwich>() }
@@ -151,9 +167,12 @@ private:
     static leveldb::ReadOptions ReadOptions;
     static leveldb::WriteOptions WriteOptions;
     static leveldb::Options OpenOptions;
+    static MojSize JoinWindow;
 
     bool m_lazySync;
     MojDbSandwichLazyUpdater* m_updater;
+    MojDbSandwichGroupCommit m_groupCommit;
+    MojDbCompactScheduler m_compactScheduler;
 };
 
 #endif /* MOJDBLEVELENGINE_H_ */
@@ -0,0 +1,79 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef MOJDBSANDWICHGROUPCOMMIT_H
+#define MOJDBSANDWICHGROUPCOMMIT_H
+
+#include <set>
+#include <vector>
+
+#include <leveldb/db.h>
+#include "db/MojDbDefs.h"
+#include "core/MojThread.h"
+
+/**
+ * Shares one fsync between transactions that commit at about the same time.
+ *
+ * With group commit enabled the bottoms are opened with sync off, so a
+ * transaction commit only appends its batch to the leveldb log. The committer
+ * then calls sync(), which returns once a synced write issued after its batch
+ * has completed. The first waiter becomes the leader: if other transactions are
+ * still between begin() and end() it waits for them (up to maxBatch writers or
+ * maxDelay microsecs), then issues a single synced write per database for the
+ * whole group. Followers just wait for the leader.
+ */
+class MojDbSandwichGroupCommit : private MojNoCopy
+{
+public:
+    typedef std::vector<leveldb::DB*> DbVec;
+
+    static const MojSize MaxBatchDefault = 32;
+    static const MojInt64 MaxDelayDefault = 1000; // microsecs
+
+    MojDbSandwichGroupCommit();
+
+    void configure(MojSize maxBatch, MojInt64 maxDelay);
+    bool enabled() const { return m_maxBatch > 1; }
+
+    // bracket writing an unsynced batch, lets the leader wait for it
+    void begin();
+    void end();
+    // blocks until everything written to dbs before the call is durable
+    MojErr sync(const DbVec& dbs);
+
+    MojSize commits() const;
+    MojSize syncs() const;
+
+private:
+    typedef std::set<leveldb::DB*> DbSet;
+
+    MojErr collect();
+    static leveldb::Status syncDbs(const DbSet& dbs);
+
+    mutable MojThreadMutex m_mutex;
+    MojThreadCond m_cond;
+    MojSize m_maxBatch;
+    MojInt64 m_maxDelay;
+    MojSize m_writing;
+    MojUInt64 m_written;
+    MojUInt64 m_synced;
+    bool m_leader;
+    DbSet m_pending;
+    MojSize m_commits;
+    MojSize m_syncs;
+};
+
+#endif
@@ -32,6 +32,7 @@ public:
     virtual MojErr stats(MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut);
     virtual MojErr insert(MojDbShardId shardId, const MojDbKey& key, MojDbStorageTxn* txn);
     virtual MojErr del(MojDbShardId shardId, const MojDbKey& key, MojDbStorageTxn* txn);
+    virtual MojErr delRange(const MojDbKey& from, const MojDbKey& to, MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut);
     virtual MojErr find(MojAutoPtr<MojDbQueryPlan> plan, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageQuery>& queryOut);
 #ifdef LMDB_ENGINE_SUPPORT
     virtual MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut, bool isWriteOp = false);
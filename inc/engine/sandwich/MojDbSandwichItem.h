@@ -29,6 +29,7 @@ public:
     virtual MojErr close() { return MojErrNone; }
     virtual MojErr kindId(MojString& kindIdOut, MojDbKindEngine& kindEngine);
     virtual MojErr visit(MojObjectVisitor& visitor, MojDbKindEngine& kindEngine, bool headerExpected = true) const;
+    virtual MojErr view(MojDbItemView& viewOut, MojDbKindEngine& kindEngine) const;
     virtual const MojObject& id() const { return m_header.id(); }
     virtual MojSize size() const { return m_slice.size(); }
 
@@ -56,6 +57,7 @@ private:
     leveldb::Slice m_slice;
     MojAutoPtr<MojBuffer::Chunk> m_chunk;
     MojByte *m_data;
+    MojSize m_capacity; //!< bytes allocated at m_data when we own it, kept for the next fromBytes
     mutable MojDbObjectHeader m_header;
     void (*m_free)(void*);
 };
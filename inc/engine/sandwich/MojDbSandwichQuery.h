@@ -17,6 +17,9 @@
 #ifndef MOJDBLEVELQUERY_H_
 #define MOJDBLEVELQUERY_H_
 
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include "db/MojDbDefs.h"
 #include "MojDbSandwichEngine.h"
 #include "MojDbSandwichItem.h"
@@ -32,6 +35,7 @@ public:
 			MojAutoPtr<MojDbQueryPlan> plan, MojDbStorageTxn* txn);
 	MojErr getById(const MojObject& id, MojDbStorageItem*& itemOut, bool& foundOut) override;
 	virtual MojErr getById(const MojObject& id, MojObject& itemOut, bool& foundOut, MojDbKindEngine* kindEngine) override;
+	virtual MojErr getViewById(const MojObject& id, MojDbItemView& viewOut, bool& foundOut, MojDbKindEngine* kindEngine) override;
 
 	MojErr close() override;
 
@@ -40,12 +44,23 @@ private:
 	MojErr next(bool& foundOut) override;
 	MojErr getVal(MojDbStorageItem*& itemOut, bool& foundOut) override;
 	MojErr readEntry(bool &foundOut);;
+	MojErr getByIdImpl(const MojObject& id, MojDbStorageItem*& itemOut, bool& foundOut, bool useWindow);
+	MojErr lookupById(const MojObject& id, MojDbSandwichItem& valOut, bool& foundOut);
+	MojErr getPrimary(MojDbShardId shardId, MojDbSandwichItem& key, bool useWindow, bool& foundOut);
+	MojErr fillJoinWindow();
 
 	std::unique_ptr<leveldb::Iterator> m_it;
 	MojDbSandwichItem m_key;
 	MojDbSandwichItem m_val;
 	MojDbSandwichItem m_primaryVal;
+	MojRefCountedPtr<MojDbSandwichItem> m_viewVal; //!< backs the views getViewById hands out
 	MojDbSandwichDatabase* m_db;
+
+	// primary records prefetched for the index entries ahead of m_it
+	std::unique_ptr<leveldb::Iterator> m_joinIt;
+	MojDbSandwichDatabase* m_indexDb;
+	std::unordered_map<std::string, std::string> m_joinVals;
+	std::unordered_set<std::string> m_joinMisses;
 };
 
 #endif /* MOJDBLEVELQUERY_H_ */
@@ -67,6 +67,14 @@ public:
     mojo::PoolTxnPart use(const mojo::Sandwich::Cookie &cookie)
     { return mojo::use(m_txn, cookie); }
 
+    // remember shards with writes, only those need a sync on commit
+    void dirty(MojDbShardId shardId)
+    { m_dirty.insert(shardId); }
+
+    // write volume per part, handed to the compaction scheduler on commit
+    void touched(MojDbShardId shardId, const mojo::Sandwich::Cookie &cookie, const leveldb::Slice &key,
+                 MojSize written, MojSize deleted);
+
 private:
     MojErr commitImpl() override;
 
@@ -76,6 +84,8 @@ private:
     mojo::SandwichesTxn m_txn;
     mojo::SandwichTxn &m_txnMain;
     MojDbSandwichEngine& m_engine;
+    std::set<MojDbShardId> m_dirty;
+    MojDbCompactScheduler::RangeMap m_touched;
 };
 
 #endif
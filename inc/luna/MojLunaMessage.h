@@ -31,7 +31,8 @@ public:
 	~MojLunaMessage();
 
 	virtual MojObjectVisitor& writer() { return m_writer; }
-	virtual bool hasData() const { return (!m_writer.json().empty()); }
+	virtual bool hasData() const { return !m_writer.empty(); }
+	virtual MojString replyJson() const;
 	virtual const MojChar* appId() const { return LSMessageGetApplicationID(m_msg); }
 	virtual const MojChar* category() const { return LSMessageGetCategory(m_msg); }
 	virtual const MojChar* method() const { return LSMessageGetMethod(m_msg); }
@@ -61,7 +62,7 @@ private:
 	LSMessage* m_msg;
 	bool m_response;
 	Token m_token;
-	MojJsonWriter m_writer;
+	MojJsonBufferWriter m_writer;
 };
 
 #endif /* MOJLUNAMESSAGE_H_ */
@@ -16,6 +16,7 @@
 
 
 #include "core/MojApp.h"
+#include "core/MojJson.h"
 #include "core/MojLogDb8.h"
 
 //this line is required for compatibility with mojomail-pop
@@ -130,6 +131,19 @@ MojErr MojApp::configure(const MojObject& conf)
 	//MojErr err = MojLogEngine::instance()->configure(conf, m_name);
 	//MojErrCheck(err);
 
+	// "json": {"scanner": "auto" | "scalar" | "sse2" | "avx2"}
+	MojObject jsonConf;
+	if (conf.get(_T("json"), jsonConf)) {
+		MojString scanner;
+		bool found = false;
+		MojErr err = jsonConf.get(_T("scanner"), scanner, found);
+		MojErrCheck(err);
+		if (found) {
+			err = MojJsonParser::scan(scanner.data());
+			MojErrCheck(err);
+		}
+	}
+
 	return MojErrNone;
 }
 
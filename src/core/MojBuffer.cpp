@@ -215,9 +215,11 @@ MojErr MojBuffer::consolidate()
 		for (ChunkList::ConstIterator i = m_chunks.begin(); i != m_chunks.end(); ++i) {
 			chunk->write((*i)->data(), (*i)->dataSize());
 		}
-		// replace existing chunks with new one
+		// replace existing chunks with new one, keeping the read position
+		MojSize readOffset = m_readPos - m_chunks.front()->data();
 		clear();
 		m_chunks.pushBack(chunk);
+		m_readPos = chunk->data() + readOffset;
 	}
 	return MojErrNone;
 }
@@ -39,10 +39,210 @@
 
 #include "core/MojJson.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define MOJ_JSON_SIMD
+#include <immintrin.h>
+#endif
+
 static const MojChar* const MojJsonNullString = _T("null");
 static const MojChar* const MojJsonTrueString = _T("true");
 static const MojChar* const MojJsonFalseString = _T("false");
 
+const MojChar* const MojJsonParser::ScanAutoName = _T("auto");
+const MojChar* const MojJsonParser::ScanScalarName = _T("scalar");
+const MojChar* const MojJsonParser::ScanSse2Name = _T("sse2");
+const MojChar* const MojJsonParser::ScanAvx2Name = _T("avx2");
+
+// Span scanners return the first char at or after begin that ends a run of plain
+// string chars: a quote, a backslash, a newline (so line counting stays in the
+// state machine) or a nul. A NULL end means the input is nul-terminated.
+typedef const MojChar* (*MojJsonSpanFn)(const MojChar* begin, const MojChar* end);
+
+static const MojChar* MojJsonSpanScalar(const MojChar* begin, const MojChar* end)
+{
+	const MojChar* cur = begin;
+	while (cur != end) {
+		MojChar c = *cur;
+		if (c == _T('"') || c == _T('\\') || c == _T('\n') || c == _T('\0'))
+			break;
+		++cur;
+	}
+	return cur;
+}
+
+#ifdef MOJ_JSON_SIMD
+static const MojChar* MojJsonSpanSse2(const MojChar* begin, const MojChar* end)
+{
+	if (end == NULL)
+		return MojJsonSpanScalar(begin, end);
+
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i nul = _mm_setzero_si128();
+	const MojChar* cur = begin;
+	while (end - cur >= 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*) cur);
+		__m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+									_mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, nul)));
+		int mask = _mm_movemask_epi8(hits);
+		if (mask)
+			return cur + __builtin_ctz(mask);
+		cur += 16;
+	}
+	return MojJsonSpanScalar(cur, end);
+}
+
+__attribute__((target("avx2")))
+static const MojChar* MojJsonSpanAvx2(const MojChar* begin, const MojChar* end)
+{
+	if (end == NULL)
+		return MojJsonSpanScalar(begin, end);
+
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i newline = _mm256_set1_epi8('\n');
+	const __m256i nul = _mm256_setzero_si256();
+	const MojChar* cur = begin;
+	while (end - cur >= 32) {
+		__m256i chunk = _mm256_loadu_si256((const __m256i*) cur);
+		__m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+									   _mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline), _mm256_cmpeq_epi8(chunk, nul)));
+		MojUInt32 mask = (MojUInt32) _mm256_movemask_epi8(hits);
+		if (mask)
+			return cur + __builtin_ctz(mask);
+		cur += 32;
+	}
+	return MojJsonSpanSse2(cur, end);
+}
+#endif /* MOJ_JSON_SIMD */
+
+static MojJsonParser::Scan MojJsonBestScan()
+{
+#ifdef MOJ_JSON_SIMD
+	// may run from static init, before the cpu model is set up
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return MojJsonParser::ScanAvx2;
+	return MojJsonParser::ScanSse2;
+#else
+	return MojJsonParser::ScanScalar;
+#endif
+}
+
+static MojJsonSpanFn MojJsonSpanFor(MojJsonParser::Scan scan)
+{
+	switch (scan) {
+#ifdef MOJ_JSON_SIMD
+	case MojJsonParser::ScanSse2:
+		return MojJsonSpanSse2;
+	case MojJsonParser::ScanAvx2:
+		return MojJsonSpanAvx2;
+#endif
+	default:
+		return MojJsonSpanScalar;
+	}
+}
+
+static MojJsonParser::Scan s_scan = MojJsonBestScan();
+static MojJsonSpanFn s_span = MojJsonSpanFor(s_scan);
+
+// chars that must be escaped in strings: 1 means \uXXXX, anything else is the char after the backslash
+static const char MojJsonEscape[] = {
+	/*       0,  1   2   3   4   5   6   7   8   9   a   b   c   d   e   f */
+	/* 0 */  1,  1,  1,  1,  1,  1,  1,  1,'b','t','n',  1,'f','r',  1,  1,
+	/* 1 */  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+	/* 2 */  0,  0,'"',  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 3 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 4 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 5 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,'\\', 0,  0,  0
+};
+
+static const MojChar* MojJsonEscapeEnd(const MojChar* cur, const MojChar* end)
+{
+	// first char that needs escaping
+	while (cur < end) {
+		unsigned int c = (unsigned char) *cur;
+		if (c < sizeof(MojJsonEscape) && MojJsonEscape[c])
+			break;
+		++cur;
+	}
+	return cur;
+}
+
+static MojSize MojJsonEscapeChar(MojChar c, MojChar* buf)
+{
+	// buf must hold 6 chars
+	static const MojChar hex[] = _T("0123456789ABCDEF");
+	unsigned int code = (unsigned char) c;
+	buf[0] = _T('\\');
+	if (MojJsonEscape[code] != 1) {
+		buf[1] = MojJsonEscape[code];
+		return 2;
+	}
+	buf[1] = _T('u');
+	buf[2] = _T('0');
+	buf[3] = _T('0');
+	buf[4] = hex[code >> 4];
+	buf[5] = hex[code & 0xF];
+	return 6;
+}
+
+static MojSize MojJsonFormatInt(MojInt64 val, MojChar* buf)
+{
+	// buf must hold 20 chars; digits are produced backwards, then moved to the front
+	MojChar tmp[20];
+	MojChar* pos = tmp + sizeof(tmp);
+	MojUInt64 mag = (val < 0) ? (MojUInt64) 0 - (MojUInt64) val : (MojUInt64) val;
+	do {
+		*--pos = (MojChar) (_T('0') + mag % 10);
+		mag /= 10;
+	} while (mag);
+	if (val < 0)
+		*--pos = _T('-');
+	MojSize len = tmp + sizeof(tmp) - pos;
+	MojMemCpy(buf, pos, len);
+	return len;
+}
+
+// out needs append(const MojChar*, MojSize) and append(MojChar)
+template<class OUT>
+static MojErr MojJsonWriteString(OUT& out, const MojChar* val, MojSize len)
+{
+	MojAssert(val || len == 0);
+
+	MojErr err = out.append(_T('"'));
+	MojErrCheck(err);
+	const MojChar* end = val + len;
+	for (;;) {
+		const MojChar* runEnd = MojJsonEscapeEnd(val, end);
+		err = out.append(val, runEnd - val);
+		MojErrCheck(err);
+		if (runEnd == end)
+			break;
+		MojChar buf[6];
+		err = out.append(buf, MojJsonEscapeChar(*runEnd, buf));
+		MojErrCheck(err);
+		val = runEnd + 1;
+	}
+	err = out.append(_T('"'));
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+// lets the string helpers write to a MojBuffer
+class MojJsonBufferOut
+{
+public:
+	MojJsonBufferOut(MojBuffer& buf) : m_buf(buf) {}
+	MojErr append(MojChar c) { return m_buf.writeByte((MojByte) c); }
+	MojErr append(const MojChar* chars, MojSize len) { return m_buf.write(chars, len * sizeof(MojChar)); }
+
+private:
+	MojBuffer& m_buf;
+};
+
 MojJsonWriter::MojJsonWriter()
 : m_writeComma(false)
 {
@@ -129,7 +329,8 @@ MojErr MojJsonWriter::intValue(MojInt64 val)
 {
 	MojErr err = writeComma();
 	MojErrCheck(err);
-	err = m_str.appendFormat(_T("%lld"), val);
+	MojChar buf[20];
+	err = m_str.append(buf, MojJsonFormatInt(val, buf));
 	MojErrCheck(err);
 	return MojErrNone;
 }
@@ -157,52 +358,180 @@ MojErr MojJsonWriter::stringValue(const MojChar* val, MojSize len)
 
 MojErr MojJsonWriter::writeString(const MojChar* val, MojSize len)
 {
-	MojAssert(val || len == 0);
-	static const char escape[] = {
-		/*       0,  1   2   3   4   5   6   7   8   9   a   b   c   d   e   f */
-		/* 0 */  1,  1,  1,  1,  1,  1,  1,  1,'b','t','n',  1,'f','r',  1,  1,
-		/* 1 */  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
-		/* 2 */  0,  0,'"',  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-		/* 3 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-		/* 4 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-		/* 5 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,'\\', 0,  0,  0
-	};
+	MojErr err = MojJsonWriteString(m_str, val, len);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojJsonWriter::writeComma()
+{
+	if (m_writeComma) {
+		MojErr err = m_str.append(_T(','));
+		MojErrCheck(err);
+	} else {
+		m_writeComma = true;
+	}
+	return MojErrNone;
+}
+
+MojJsonBufferWriter::MojJsonBufferWriter()
+: m_writeComma(false)
+{
+}
+
+MojErr MojJsonBufferWriter::reset()
+{
+	m_buf.clear();
+	m_writeComma = false;
+	return MojErrNone;
+}
 
-	MojErr err = m_str.append(_T('"'));
+MojErr MojJsonBufferWriter::beginObject()
+{
+	MojErr err = writeComma();
+	MojErrCheck(err);
+	err = m_buf.writeByte(_T('{'));
 	MojErrCheck(err);
+	m_writeComma = false;
+	return MojErrNone;
+}
 
-	const MojChar* cur = val;
-	const MojChar* end = val + len;
-	while (cur < end) {
-		unsigned int c = (unsigned int) *cur;
-		if (c < (int) sizeof(escape) && escape[c]) {
-			err = m_str.append(val, cur - val);
-			MojErrCheck(err);
-			val = cur + 1;
-			if (escape[c] == 1) {
-				err = m_str.appendFormat(_T("\\u%04X"), c);
-				MojErrCheck(err);
-			} else {
-				err = m_str.append(_T('\\'));
-				MojErrCheck(err);
-				err = m_str.append(escape[c]);
-				MojErrCheck(err);
-			}
-		}
-		cur++;
+MojErr MojJsonBufferWriter::endObject()
+{
+	MojErr err = m_buf.writeByte(_T('}'));
+	MojErrCheck(err);
+	m_writeComma = true;
+	return MojErrNone;
+}
+
+MojErr MojJsonBufferWriter::beginArray()
+{
+	MojErr err = writeComma();
+	MojErrCheck(err);
+	err = m_buf.writeByte(_T('['));
+	MojErrCheck(err);
+	m_writeComma = false;
+	return MojErrNone;
+}
+
+MojErr MojJsonBufferWriter::endArray()
+{
+	MojErr err = m_buf.writeByte(_T(']'));
+	MojErrCheck(err);
+	m_writeComma = true;
+	return MojErrNone;
+}
+
+MojErr MojJsonBufferWriter::propName(const MojChar* name, MojSize len)
+{
+	MojAssert(name);
+
+	MojErr err = writeComma();
+	MojErrCheck(err);
+	MojJsonBufferOut out(m_buf);
+	err = MojJsonWriteString(out, name, len);
+	MojErrCheck(err);
+	err = m_buf.writeByte(_T(':'));
+	MojErrCheck(err);
+	m_writeComma = false;
+	return MojErrNone;
+}
+
+MojErr MojJsonBufferWriter::nullValue()
+{
+	MojErr err = writeComma();
+	MojErrCheck(err);
+	err = m_buf.write(MojJsonNullString, 4);
+	MojErrCheck(err);
+	return MojErrNone;
+}
+
+MojErr MojJsonBufferWriter::boolValue(bool val)
+{
+	MojErr err = writeComma();
+	MojErrCheck(err);
+	if (val) {
+		err = m_buf.write(MojJsonTrueString, 4);
+	} else {
+		err = m_buf.write(MojJsonFalseString, 5);
 	}
-	err = m_str.append(val, cur - val);
 	MojErrCheck(err);
-	err = m_str.append(_T('"'));
+	return MojErrNone;
+}
+
+MojErr MojJsonBufferWriter::intValue(MojInt64 val)
+{
+	MojErr err = writeComma();
+	MojErrCheck(err);
+	MojChar buf[20];
+	err = m_buf.write(buf, MojJsonFormatInt(val, buf));
 	MojErrCheck(err);
+	return MojErrNone;
+}
 
+MojErr MojJsonBufferWriter::decimalValue(const MojDecimal& val)
+{
+	MojErr err = writeComma();
+	MojErrCheck(err);
+	MojChar buf[MojDecimal::MaxStringSize];
+	err = val.stringValue(buf, MojDecimal::MaxStringSize);
+	MojErrCheck(err);
+	err = m_buf.write(buf, MojStrLen(buf));
+	MojErrCheck(err);
 	return MojErrNone;
 }
 
-MojErr MojJsonWriter::writeComma()
+MojErr MojJsonBufferWriter::stringValue(const MojChar* val, MojSize len)
+{
+	MojErr err = writeComma();
+	MojErrCheck(err);
+	MojJsonBufferOut out(m_buf);
+	err = MojJsonWriteString(out, val, len);
+	MojErrCheck(err);
+	return MojErrNone;
+}
+
+MojErr MojJsonBufferWriter::json(MojString& strOut) const
+{
+	strOut.clear();
+	MojIoVecT vec[MaxVecs];
+	MojSize vecSize = 0;
+	m_buf.iovec(vec, MaxVecs, vecSize);
+	if (vecSize == MaxVecs) {
+		// more chunks than we can see at once, go the slow way
+		MojBuffer::ByteVec bytes;
+		MojErr err = m_buf.toByteVec(bytes);
+		MojErrCheck(err);
+		err = strOut.assign((const MojChar*) bytes.begin(), bytes.size());
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	for (MojSize i = 0; i < vecSize; ++i) {
+		MojErr err = strOut.append((const MojChar*) vec[i].iov_base, vec[i].iov_len);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojJsonBufferWriter::data(const MojChar*& jsonOut)
+{
+	// terminate and make contiguous; only copies if the json spans several chunks
+	MojErr err = m_buf.writeByte(0);
+	MojErrCheck(err);
+	const MojByte* data = NULL;
+	MojSize size = 0;
+	err = m_buf.data(data, size);
+	MojErrCheck(err);
+	jsonOut = (const MojChar*) data;
+
+	return MojErrNone;
+}
+
+MojErr MojJsonBufferWriter::writeComma()
 {
 	if (m_writeComma) {
-		MojErr err = m_str.append(_T(','));
+		MojErr err = m_buf.writeByte(_T(','));
 		MojErrCheck(err);
 	} else {
 		m_writeComma = true;
@@ -248,6 +577,63 @@ bool MojJsonParser::finished()
 	return (state() == StateFinish && m_depth == 0);
 }
 
+MojErr MojJsonParser::scan(Scan scan)
+{
+	if (scan == ScanAuto)
+		scan = MojJsonBestScan();
+	if (!supported(scan))
+		MojErrThrowMsg(MojErrNotImplemented, _T("json: scanner %d not supported on this cpu"), (int) scan);
+
+	s_scan = scan;
+	s_span = MojJsonSpanFor(scan);
+
+	return MojErrNone;
+}
+
+MojErr MojJsonParser::scan(const MojChar* name)
+{
+	MojAssert(name);
+
+	Scan val;
+	if (MojStrCmp(name, ScanAutoName) == 0) {
+		val = ScanAuto;
+	} else if (MojStrCmp(name, ScanScalarName) == 0) {
+		val = ScanScalar;
+	} else if (MojStrCmp(name, ScanSse2Name) == 0) {
+		val = ScanSse2;
+	} else if (MojStrCmp(name, ScanAvx2Name) == 0) {
+		val = ScanAvx2;
+	} else {
+		MojErrThrowMsg(MojErrInvalidArg, _T("json: unknown scanner '%s'"), name);
+	}
+	MojErr err = scan(val);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojJsonParser::Scan MojJsonParser::scan()
+{
+	return s_scan;
+}
+
+bool MojJsonParser::supported(Scan scan)
+{
+	switch (scan) {
+	case ScanAuto:
+	case ScanScalar:
+		return true;
+#ifdef MOJ_JSON_SIMD
+	case ScanSse2:
+		return true;
+	case ScanAvx2:
+		return __builtin_cpu_supports("avx2");
+#endif
+	default:
+		return false;
+	}
+}
+
 MojErr MojJsonParser::parse(MojObjectVisitor& visitor, const MojChar* chars, MojSize len)
 {
 	MojAssert(chars || len == 0);
@@ -402,7 +788,7 @@ Redo:	switch (state()) {
 				savedState() = StateString;
 				state() = StateStringEscape;
 			} else {
-				err = m_str.append(c);
+				err = appendRun(chars, end);
 				MojErrCheck(err);
 			}
 			break;
@@ -582,7 +968,7 @@ Redo:	switch (state()) {
 				savedState() = StateObjField;
 				state() = StateStringEscape;
 			} else {
-				err = m_str.append(c);
+				err = appendRun(chars, end);
 				MojErrCheck(err);
 			}
 			break;
@@ -629,6 +1015,19 @@ Done:
 	return MojErrNone;
 }
 
+MojErr MojJsonParser::appendRun(const MojChar*& chars, const MojChar* end)
+{
+	// *chars is already accounted for, so the run starts after it. Leaves chars
+	// on the last char of the run, for the caller's loop to step past.
+	const MojChar* runEnd = s_span(chars + 1, end);
+	MojErr err = m_str.append(chars, runEnd - chars);
+	MojErrCheck(err);
+	m_col += (MojUInt32) (runEnd - chars - 1);
+	chars = runEnd - 1;
+
+	return MojErrNone;
+}
+
 MojErr MojJsonParser::push()
 {
 	if (m_depth >= MaxDepth - 1)
@@ -17,9 +17,27 @@
 
 #include "core/MojMessageDispatcher.h"
 
+const MojChar* const MojMessageDispatcher::ThreadsKey = _T("threads");
+const MojChar* const MojMessageDispatcher::WeightsKey = _T("weights");
+const MojChar* const MojMessageDispatcher::MaxAdminThreadsKey = _T("maxAdminThreads");
+const MojChar* const MojMessageDispatcher::PriorityNames[MojMessage::NumPriorities] = {
+	_T("read"),
+	_T("write"),
+	_T("admin")
+};
+
+// virtual time is run time in microsecs scaled by this over the class weight
+static const MojInt64 MojDispatcherVirtualScale = 64;
+
 MojMessageDispatcher::MojMessageDispatcher()
-: m_stop(false)
+: m_numThreads(NumThreadsDefault),
+  m_maxAdminThreads(0),
+  m_vclock(0),
+  m_stop(false)
 {
+	m_weights[MojMessage::PriorityRead] = ReadWeightDefault;
+	m_weights[MojMessage::PriorityWrite] = WriteWeightDefault;
+	m_weights[MojMessage::PriorityAdmin] = AdminWeightDefault;
 }
 
 MojMessageDispatcher::~MojMessageDispatcher()
@@ -28,11 +46,83 @@ MojMessageDispatcher::~MojMessageDispatcher()
 	MojErrCatchAll(err);
 	err = wait();
 	MojErrCatchAll(err);
+
+	while (!m_idleList.empty())
+		delete m_idleList.popFront();
+}
+
+MojErr MojMessageDispatcher::configure(const MojObject& conf)
+{
+	MojThreadGuard guard(m_mutex);
+
+	bool found = false;
+	MojInt32 threads = 0;
+	MojErr err = conf.get(ThreadsKey, threads, found);
+	MojErrCheck(err);
+	if (found) {
+		if (threads < 1)
+			MojErrThrowMsg(MojErrInvalidArg, _T("dispatcher: invalid thread count %d"), threads);
+		m_numThreads = threads;
+	}
+
+	MojInt32 maxAdmin = 0;
+	err = conf.get(MaxAdminThreadsKey, maxAdmin, found);
+	MojErrCheck(err);
+	if (found) {
+		if (maxAdmin < 1)
+			MojErrThrowMsg(MojErrInvalidArg, _T("dispatcher: invalid admin thread count %d"), maxAdmin);
+		m_maxAdminThreads = maxAdmin;
+	}
+
+	MojObject weights;
+	if (conf.get(WeightsKey, weights)) {
+		for (int i = 0; i < MojMessage::NumPriorities; ++i) {
+			MojInt32 weight = 0;
+			err = weights.get(PriorityNames[i], weight, found);
+			MojErrCheck(err);
+			if (!found)
+				continue;
+			if (weight < 1)
+				MojErrThrowMsg(MojErrInvalidArg, _T("dispatcher: invalid %s weight %d"), PriorityNames[i], weight);
+			m_weights[i] = weight;
+		}
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojMessageDispatcher::classify(const MojChar* method, MojMessage::Priority pri)
+{
+	MojAssert(method && pri < MojMessage::NumPriorities);
+	MojThreadGuard guard(m_mutex);
+
+	MojString name;
+	MojErr err = name.assign(method);
+	MojErrCheck(err);
+	err = m_priorities.put(name, pri);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojMessage::Priority MojMessageDispatcher::priority(const MojChar* method) const
+{
+	if (!method)
+		return MojMessage::PriorityWrite;
+
+	MojThreadGuard guard(m_mutex);
+	PriorityMap::ConstIterator i = m_priorities.find(method);
+	if (i == m_priorities.end())
+		return MojMessage::PriorityWrite;
+	return *i;
 }
 
 MojErr MojMessageDispatcher::schedule(MojMessage* msg)
 {
 	MojAssert(msg);
+	MojErr err = MojGetCurrentTime(msg->m_scheduleTime);
+	MojErrCheck(err);
+
 	MojThreadGuard guard(m_mutex);
 
 	const MojChar* queueName = msg->queue();
@@ -41,28 +131,46 @@ MojErr MojMessageDispatcher::schedule(MojMessage* msg)
 	if (!queue) {
 		// then look for a pending queue
 		queue = findQueue(queueName, m_pendingList);
-
-		// then create a new queue if we didn't find one
-		if (!queue) {
+	}
+	if (!queue) {
+		// then for an idle queue that still owes time
+		queue = findQueue(queueName, m_idleList);
+		if (queue) {
+			m_idleList.erase(queue);
+			if (queue->m_vtime < m_vclock)
+				queue->m_vtime = m_vclock;
+		} else {
+			// create a new queue if we didn't find one
 			MojAutoPtr<Queue> newQueue(new Queue);
 			MojAllocCheck(newQueue.get());
-			queue = newQueue.get();
-			MojErr err = queue->init(queueName);
-			MojErrCheck(err);
-
-			// add it to scheduled list and wake up a thread
-			m_scheduledList.pushBack(newQueue.release());
-			err = m_cond.signal();
+			err = newQueue->init(queueName);
 			MojErrCheck(err);
+			newQueue->m_vtime = m_vclock;
+			queue = newQueue.release();
 		}
+
+		// add it to scheduled list and wake up a thread
+		m_scheduledList.pushBack(queue);
+		err = m_cond.signal();
+		MojErrCheck(err);
 	}
 	queue->push(msg);
+	++m_stats[msg->priority()].m_depth;
 
 	return MojErrNone;
 }
 
 MojErr MojMessageDispatcher::start(MojInt32 numThreads)
 {
+	MojAssert(numThreads > 0);
+	{
+		MojThreadGuard guard(m_mutex);
+		m_numThreads = numThreads;
+		// keep a thread free for interactive calls unless told otherwise
+		if (m_maxAdminThreads == 0)
+			m_maxAdminThreads = (numThreads > 1) ? numThreads - 1 : 1;
+	}
+
 	for (MojInt32 i = 0; i < numThreads; ++i) {
 		MojThreadT thread = MojInvalidThread;
 		MojErr err = MojThreadCreate(thread, threadMain, this);
@@ -101,45 +209,151 @@ MojErr MojMessageDispatcher::wait()
 	return err;
 }
 
+MojErr MojMessageDispatcher::stats(MojObject& objOut) const
+{
+	MojThreadGuard guard(m_mutex);
+
+	MojErr err = objOut.put(ThreadsKey, (MojInt64) m_numThreads);
+	MojErrCheck(err);
+	err = objOut.put(_T("queues"), (MojInt64) (m_scheduledList.size() + m_pendingList.size()));
+	MojErrCheck(err);
+	for (int i = 0; i < MojMessage::NumPriorities; ++i) {
+		const Stats& stats = m_stats[i];
+		MojObject obj;
+		err = obj.put(_T("depth"), (MojInt64) stats.m_depth);
+		MojErrCheck(err);
+		err = obj.put(_T("running"), (MojInt64) stats.m_running);
+		MojErrCheck(err);
+		err = obj.put(_T("dispatched"), (MojInt64) stats.m_dispatched);
+		MojErrCheck(err);
+		MojInt64 done = (MojInt64) stats.m_dispatched;
+		err = obj.put(_T("avgWaitUs"), done ? stats.m_waitTotal / done : 0);
+		MojErrCheck(err);
+		err = obj.put(_T("maxWaitUs"), stats.m_waitMax);
+		MojErrCheck(err);
+		err = obj.put(_T("avgRunUs"), done ? stats.m_runTotal / done : 0);
+		MojErrCheck(err);
+		err = objOut.put(PriorityNames[i], obj);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
 MojErr MojMessageDispatcher::dispatch(bool& stoppedOut)
 {
 	MojThreadGuard guard(m_mutex);
 
-	// wait for a message
+	// wait for a message we are allowed to run
 	stoppedOut = false;
-	while (m_scheduledList.empty() && !m_stop) {
+	Queue* queue = NULL;
+	while ((queue = next()) == NULL && !(m_stop && m_scheduledList.empty())) {
 		MojErr err = m_cond.wait(m_mutex);
 		MojErrCheck(err);
 	}
 
-	if (m_scheduledList.empty()) {
-		// stop if we didn't get a message
+	if (!queue) {
+		// stop if we didn't get a message, and let the other threads see it too
 		MojAssert(m_stop);
 		stoppedOut = true;
+		MojErr err = m_cond.broadcast();
+		MojErrCheck(err);
 	} else {
 		// move queue from scheduled list to pending list and pop a message
-		Queue* queue = m_scheduledList.popFront();
+		m_scheduledList.erase(queue);
 		m_pendingList.pushBack(queue);
+		if (queue->m_vtime > m_vclock)
+			m_vclock = queue->m_vtime;
 		MojRefCountedPtr<MojMessage> msg = queue->pop();
+		MojMessage::Priority pri = msg->priority();
+
+		MojTime startTime;
+		MojErr err = MojGetCurrentTime(startTime);
+		MojErrCatchAll(err);
+		MojInt64 waitTime = (startTime - msg->m_scheduleTime).microsecs();
+		Stats& stats = m_stats[pri];
+		--stats.m_depth;
+		++stats.m_running;
+		++stats.m_dispatched;
+		stats.m_waitTotal += waitTime;
+		if (waitTime > stats.m_waitMax)
+			stats.m_waitMax = waitTime;
 
 		// unlock and dispatch
 		guard.unlock();
-		MojErr err = msg->dispatch();
+		err = msg->dispatch();
+		MojErrCatchAll(err);
+		MojTime endTime;
+		err = MojGetCurrentTime(endTime);
 		MojErrCatchAll(err);
 		guard.lock();
 
-		// remove from pending list
-		m_pendingList.erase(queue);
-		if (queue->empty()) {
-			// we're done with this queue
+		finished(queue, pri, (endTime - startTime).microsecs());
+	}
+	return MojErrNone;
+}
+
+MojMessageDispatcher::Queue* MojMessageDispatcher::next()
+{
+	// lowest virtual time wins, ties go to the more urgent class
+	Queue* best = NULL;
+	MojMessage::Priority bestPri = MojMessage::NumPriorities;
+	bool adminFull = m_stats[MojMessage::PriorityAdmin].m_running >= (MojSize) m_maxAdminThreads;
+	for (QueueList::Iterator i = m_scheduledList.begin(); i != m_scheduledList.end(); ++i) {
+		Queue* queue = *i;
+		MojMessage::Priority pri = queue->priority();
+		if (pri == MojMessage::PriorityAdmin && adminFull)
+			continue;
+		if (!best || queue->m_vtime < best->m_vtime ||
+			(queue->m_vtime == best->m_vtime && pri < bestPri)) {
+			best = queue;
+			bestPri = pri;
+		}
+	}
+	return best;
+}
+
+void MojMessageDispatcher::finished(Queue* queue, MojMessage::Priority pri, MojInt64 runTime)
+{
+	Stats& stats = m_stats[pri];
+	--stats.m_running;
+	if (runTime < 0)
+		runTime = 0;
+	stats.m_runTotal += runTime;
+	queue->m_vtime += (runTime + 1) * MojDispatcherVirtualScale / m_weights[pri];
+
+	// remove from pending list
+	m_pendingList.erase(queue);
+	if (!queue->empty()) {
+		// if queue has more messages, add it back to scheduled list
+		// no need to signal since this thread will loop back around and pick it up
+		m_scheduledList.pushBack(queue);
+	} else if (queue->m_vtime > m_vclock) {
+		// remember what the caller used until the others catch up
+		m_idleList.pushBack(queue);
+	} else {
+		// we're done with this queue
+		delete queue;
+	}
+	pruneIdle();
+
+	// an admin slot opened up, a waiting thread may now take an admin queue
+	if (pri == MojMessage::PriorityAdmin && !m_scheduledList.empty()) {
+		MojErr err = m_cond.signal();
+		MojErrCatchAll(err);
+	}
+}
+
+void MojMessageDispatcher::pruneIdle()
+{
+	for (QueueList::Iterator i = m_idleList.begin(); i != m_idleList.end(); ) {
+		Queue* queue = *i;
+		++i;
+		if (queue->m_vtime <= m_vclock) {
+			m_idleList.erase(queue);
 			delete queue;
-		} else {
-			// if queue has more messages, add it back to scheduled list
-			// no need to signal since this thread will loop back around and pick it up
-			m_scheduledList.pushBack(queue);
 		}
 	}
-	return MojErrNone;
 }
 
 MojMessageDispatcher::Queue* MojMessageDispatcher::findQueue(const MojChar* name, QueueList& list)
@@ -16,6 +16,7 @@
 
 
 #include "core/MojObject.h"
+#include "core/MojObjectArena.h"
 #include "core/MojObjectBuilder.h"
 #include "core/MojObjectSerialization.h"
 #include "core/MojHashMap.h"
@@ -23,13 +24,14 @@
 
 
 #include <string.h>
+#include <new>
 
 const MojObject MojObject::Undefined(TypeUndefined);
 const MojObject MojObject::Null(TypeNull);
 
 void MojObject::clear(Type type)
 {
-	init(type);
+	init(type, NULL);
 }
 
 MojErr MojObject::coerce(Type toType)
@@ -131,20 +133,241 @@ void MojObject::assign(const MojObject& val)
   init(val);
 }
 
+void MojObject::assign(const MojObject& val, MojObjectArena* arena)
+{
+	init(val, arena);
+}
+
+static int MojCompareChars(const MojChar* chars1, MojSize len1, const MojChar* chars2, MojSize len2)
+{
+	MojSize len = (len1 < len2) ? len1 : len2;
+	int res = memcmp(chars1, chars2, len * sizeof(MojChar));
+	if (res != 0)
+		return res;
+	return (len1 < len2) ? -1 : (len1 > len2);
+}
+
 int MojObject::compare(const MojObject& val) const
 {
 	Type thisType = type();
 	Type valType = val.type();
 	if (thisType != valType)
 		return thisType - valType;
-	return impl()->compare(*val.impl());
+
+	switch (thisType) {
+	case TypeObject:
+		return m_val.m_obj->m_props.compare(val.m_val.m_obj->m_props);
+	case TypeArray:
+		return m_val.m_arr->m_vec.compare(val.m_val.m_arr->m_vec);
+	case TypeString:
+		return MojCompareChars(chars(), length(), val.chars(), val.length());
+	case TypeBool:
+		return m_val.m_bool - val.m_val.m_bool;
+	case TypeDecimal:
+	case TypeInt:
+		// decimals compare by rep
+		return MojComp<MojInt64>()(m_val.m_int, val.m_val.m_int);
+	default:
+		return 0;
+	}
+}
+
+MojSize MojObject::size() const
+{
+	switch (m_type) {
+	case TypeObject:
+		return m_val.m_obj->m_props.size();
+	case TypeArray:
+		return m_val.m_arr->m_vec.size();
+	default:
+		return 0;
+	}
+}
+
+MojSize MojObject::hashCode() const
+{
+	switch (m_type) {
+	case TypeObject: {
+		MojSize hash = TypeObject;
+		const PropMap& props = m_val.m_obj->m_props;
+		for (ConstIterator i = props.begin(); i != props.end(); ++i) {
+			hash ^= MojHash(i.key());
+			hash ^= i.value().hashCode();
+		}
+		return hash;
+	}
+	case TypeArray: {
+		MojSize hash = TypeArray;
+		const ObjectVec& vec = m_val.m_arr->m_vec;
+		for (ConstArrayIterator i = vec.begin(); i != vec.end(); ++i) {
+			hash ^= i->hashCode();
+		}
+		return hash;
+	}
+	case TypeString:
+		return MojHash(chars(), length() * sizeof(MojChar));
+	case TypeBool:
+		return TypeBool + m_val.m_bool;
+	case TypeDecimal: {
+		MojDecimal dec;
+		dec.assignRep(m_val.m_int);
+		return MojHasher<MojDecimal>()(dec);
+	}
+	case TypeInt:
+		return MojHasher<MojInt64>()(m_val.m_int);
+	default:
+		return m_type;
+	}
+}
+
+MojErr MojObject::visit(MojObjectVisitor& visitor) const
+{
+	MojErr err = MojErrNone;
+	switch (m_type) {
+	case TypeObject: {
+		err = visitor.beginObject();
+		MojErrCheck(err);
+		const PropMap& props = m_val.m_obj->m_props;
+		for (PropMap::ConstIterator i = props.begin(); i != props.end(); ++i) {
+			const MojString& propName = i.key();
+			err = visitor.propName(propName, propName.length());
+			MojErrCheck(err);
+			err = i.value().visit(visitor);
+			MojErrCheck(err);
+		}
+		err = visitor.endObject();
+		MojErrCheck(err);
+		break;
+	}
+	case TypeArray: {
+		err = visitor.beginArray();
+		MojErrCheck(err);
+		const ObjectVec& vec = m_val.m_arr->m_vec;
+		for (ObjectVec::ConstIterator i = vec.begin(); i != vec.end(); ++i) {
+			err = i->visit(visitor);
+			MojErrCheck(err);
+		}
+		err = visitor.endArray();
+		MojErrCheck(err);
+		break;
+	}
+	case TypeString:
+		err = visitor.stringValue(chars(), length());
+		MojErrCheck(err);
+		break;
+	case TypeBool:
+		err = visitor.boolValue(m_val.m_bool);
+		MojErrCheck(err);
+		break;
+	case TypeDecimal: {
+		MojDecimal dec;
+		dec.assignRep(m_val.m_int);
+		err = visitor.decimalValue(dec);
+		MojErrCheck(err);
+		break;
+	}
+	case TypeInt:
+		err = visitor.intValue(m_val.m_int);
+		MojErrCheck(err);
+		break;
+	default:
+		// null and undefined
+		err = visitor.nullValue();
+		MojErrCheck(err);
+		break;
+	}
+	return MojErrNone;
+}
+
+bool MojObject::boolValue() const
+{
+	switch (m_type) {
+	case TypeObject:
+	case TypeArray:
+		return size() != 0;
+	case TypeString:
+		return length() != 0;
+	case TypeBool:
+		return m_val.m_bool;
+	case TypeDecimal:
+	case TypeInt:
+		return m_val.m_int != 0;
+	default:
+		return false;
+	}
+}
+
+MojInt64 MojObject::intValue() const
+{
+	switch (m_type) {
+	case TypeString: {
+		if (m_len == HeapString)
+			return MojStrToInt64(*m_val.m_str, NULL, 0);
+		MojChar buf[InlineStringMax + 1];
+		memcpy(buf, m_val.m_chars, m_len * sizeof(MojChar));
+		buf[m_len] = 0;
+		return MojStrToInt64(buf, NULL, 0);
+	}
+	case TypeBool:
+		return m_val.m_bool;
+	case TypeDecimal:
+		return decimalValue().magnitude();
+	case TypeInt:
+		return m_val.m_int;
+	default:
+		return 0;
+	}
+}
+
+MojDecimal MojObject::decimalValue() const
+{
+	switch (m_type) {
+	case TypeString: {
+		// TODO: skip double conversion
+		if (m_len == HeapString)
+			return MojDecimal(MojStrToDouble(*m_val.m_str, NULL));
+		MojChar buf[InlineStringMax + 1];
+		memcpy(buf, m_val.m_chars, m_len * sizeof(MojChar));
+		buf[m_len] = 0;
+		return MojDecimal(MojStrToDouble(buf, NULL));
+	}
+	case TypeBool:
+		return MojDecimal(m_val.m_bool, 0);
+	case TypeDecimal: {
+		MojDecimal dec;
+		dec.assignRep(m_val.m_int);
+		return dec;
+	}
+	case TypeInt:
+		return MojDecimal(m_val.m_int);
+	default:
+		return MojDecimal();
+	}
+}
+
+MojErr MojObject::stringValue(MojString& valOut) const
+{
+	if (m_type == TypeString) {
+		if (m_len == HeapString) {
+			valOut = *m_val.m_str;
+		} else {
+			MojErr err = valOut.assign(m_val.m_chars, m_len);
+			MojErrCheck(err);
+		}
+		return MojErrNone;
+	}
+	valOut.clear();
+	MojJsonWriter writer;
+	MojErr err = visit(writer);
+	MojErrCheck(err);
+	valOut = writer.json();
+	return MojErrNone;
 }
 
 MojErr MojObject::begin(Iterator& iter)
 {
-	PropMap* map = const_cast<PropMap*> (impl()->map());
-	if (map) {
-		MojErr err = map->begin(iter);
+	if (m_type == TypeObject) {
+		MojErr err = m_val.m_obj->m_props.begin(iter);
 		MojErrCheck(err);
 	} else {
 		iter = Iterator();
@@ -154,9 +377,8 @@ MojErr MojObject::begin(Iterator& iter)
 
 MojObject::ConstIterator MojObject::begin() const
 {
-	const PropMap* map = impl()->map();
-	if (map)
-		return map->begin();
+	if (m_type == TypeObject)
+		return m_val.m_obj->m_props.begin();
 	return ConstIterator();
 }
 
@@ -176,8 +398,8 @@ MojErr MojObject::put(const MojString& key, const MojObject& val)
 {
 	MojAssert(key);
 
-	ObjectImpl& obj = ensureObject();
-	MojErr err = obj.m_props.put(key, val);
+	ObjectNode& obj = ensureObject();
+	MojErr err = putProp(obj, key, val);
 	MojErrCheck(err);
 	return MojErrNone;
 }
@@ -196,10 +418,8 @@ MojErr MojObject::putString(const MojChar* key, const MojChar* val)
 
 MojErr MojObject::find(const MojChar* key, Iterator& iter)
 {
-    // TODO:  remove const_cast, use mutable
-	PropMap* map = const_cast<PropMap*> (impl()->map());
-	if (map) {
-		MojErr err = map->find(key, iter);
+	if (m_type == TypeObject) {
+		MojErr err = m_val.m_obj->m_props.find(key, iter);
 		MojErrCheck(err);
 	} else {
 		iter = Iterator();
@@ -209,12 +429,33 @@ MojErr MojObject::find(const MojChar* key, Iterator& iter)
 
 MojObject::ConstIterator MojObject::find(const MojChar* key) const
 {
-	const PropMap* map = impl()->map();
-	if (map)
-		return map->find(key);
+	if (m_type == TypeObject)
+		return m_val.m_obj->m_props.find(key);
 	return ConstIterator();
 }
 
+bool MojObject::get(const MojChar* key, MojObject& valOut) const
+{
+	MojAssert(key);
+	if (m_type == TypeObject) {
+		bool found = m_val.m_obj->m_props.get(key, valOut);
+		if (!found)
+			valOut.clear();
+		return found;
+	}
+	valOut.clear();
+	return false;
+}
+
+MojErr MojObject::del(const MojChar* key, bool& foundOut)
+{
+	MojAssert(key);
+	if (m_type == TypeObject)
+		return m_val.m_obj->m_props.del(key, foundOut);
+	foundOut = false;
+	return MojErrNone;
+}
+
 bool MojObject::get(const MojChar* key, bool& valOut) const
 {
 	MojObject obj;
@@ -365,10 +606,15 @@ MojErr MojObject::getRequired(const MojChar* key, MojString& valOut) const
 
 MojErr MojObject::push(const MojObject& val)
 {
-	ArrayImpl& array = ensureArray();
+	ArrayNode& array = ensureArray();
 
-	MojErr err = array.m_vec.push(val);
-	MojErrCheck(err);
+	if (array.m_arena) {
+		MojErr err = setElem(array, array.m_vec.size(), val);
+		MojErrCheck(err);
+	} else {
+		MojErr err = array.m_vec.push(val);
+		MojErrCheck(err);
+	}
 	return MojErrNone;
 }
 
@@ -384,7 +630,7 @@ MojErr MojObject::pushString(const MojChar* val)
 
 MojErr MojObject::delString(MojSize idx)
 {
-    ArrayImpl& array = ensureArray();
+    ArrayNode& array = ensureArray();
 
     if (idx <= array.m_vec.size())
     {
@@ -396,13 +642,9 @@ MojErr MojObject::delString(MojSize idx)
 
 MojErr MojObject::setAt(MojSize idx, const MojObject& val)
 {
-	ArrayImpl& array = ensureArray();
+	ArrayNode& array = ensureArray();
 
-	if (array.m_vec.size() <= idx) {
-		MojErr err = array.m_vec.resize(idx + 1);
-		MojErrCheck(err);
-	}
-	MojErr err = array.m_vec.setAt(idx, val);
+	MojErr err = setElem(array, idx, val);
 	MojErrCheck(err);
 	return MojErrNone;
 }
@@ -456,409 +698,281 @@ MojErr MojObject::at(MojSize idx, MojString& valOut, bool& foundOut) const
 	return MojErrNone;
 }
 
-bool MojObject::operator==(const MojObject& rhs) const
+MojErr MojObject::arrayBegin(ArrayIterator& iter)
 {
-	if (type() != rhs.type())
-		return false;
-	return impl()->equals(*rhs.impl());
+	if (m_type == TypeArray) {
+		MojErr err = m_val.m_arr->m_vec.begin(iter);
+		MojErrCheck(err);
+	} else {
+		iter = NULL;
+	}
+	return MojErrNone;
 }
 
-void MojObject::init(const MojObject& obj)
+bool MojObject::at(MojSize idx, MojObject& objOut) const
 {
-    release();
-
-    if (obj.impl())
-        m_implementation = obj.impl()->clone();
-    else
-        m_implementation = new UndefinedImpl();
+	if (m_type != TypeArray) {
+		objOut.clear();
+		return false;
+	}
+	const ObjectVec& vec = m_val.m_arr->m_vec;
+	if (idx >= vec.size())
+		return false;
+	objOut = vec.at(idx);
+	return true;
 }
 
-void MojObject::init(Type type)
+bool MojObject::operator==(const MojObject& rhs) const
 {
-    release();
+	if (type() != rhs.type())
+		return false;
 
-    switch(type) {
+	switch (m_type) {
 	case TypeObject:
-		m_implementation = new ObjectImpl();
-		break;
+		return m_val.m_obj->m_props == rhs.m_val.m_obj->m_props;
 	case TypeArray:
-		m_implementation = new ArrayImpl();
-		break;
+		return m_val.m_arr->m_vec == rhs.m_val.m_arr->m_vec;
 	case TypeString:
-		m_implementation = new StringImpl();
-		break;
+		return length() == rhs.length() && memcmp(chars(), rhs.chars(), length() * sizeof(MojChar)) == 0;
 	case TypeBool:
-		m_implementation = new BoolImpl();
-		break;
+		return m_val.m_bool == rhs.m_val.m_bool;
 	case TypeDecimal:
-		m_implementation = new DecimalImpl();
-		break;
 	case TypeInt:
-		m_implementation = new IntImpl();
-		break;
-	case TypeNull:
-		m_implementation = new NullImpl();
-		break;
-	case TypeUndefined:
-		m_implementation = new UndefinedImpl();
-		break;
+		return m_val.m_int == rhs.m_val.m_int;
 	default:
-        m_implementation = new UndefinedImpl();
-        MojAssertNotReached(); 	// fall through to undefined
+		return true;
 	}
 }
 
-void MojObject::release()
-{
-    if (m_implementation)  {
-        delete m_implementation;  m_implementation = 0;
-    }
-
-}
-
-MojObject::ObjectImpl& MojObject::ensureObject()
-{
-    ObjectImpl* myImpl;
-    if (type() != TypeObject) {
-        release();
-        myImpl = new ObjectImpl();
-        m_implementation = myImpl;
-    } else {
-        myImpl = dynamic_cast<ObjectImpl*>(m_implementation);
-    }
-    return *myImpl;
-}
-
-MojObject::ArrayImpl& MojObject::ensureArray()
-{
-    ArrayImpl* myImpl;
-    if (type() != TypeArray) {
-        release();
-        myImpl = new ArrayImpl();
-        m_implementation = myImpl;
-    } else {
-        myImpl = dynamic_cast<ArrayImpl*>(m_implementation);
-    }
-    return *myImpl;
-}
-
-MojErr MojObject::Impl::stringValue(MojString& valOut) const
-{
-	valOut.clear();
-	MojJsonWriter writer;
-	MojErr err = visit(writer);
-	MojErrCheck(err);
-	valOut = writer.json();
-	return MojErrNone;
-}
-
-bool MojObject::Impl::get(const MojChar* key, MojObject& valOut) const
-{
-	valOut.clear();
-	return false;
-}
-
-MojErr MojObject::Impl::del(const MojChar* key, bool& foundOut)
-{
-	foundOut = false;
-	return MojErrNone;
-}
-
-int MojObject::NullImpl::compare(const MojObject::Impl& rhs) const
-{
-	MojAssert(rhs.type() == type());
-	return 0;
-}
-
-bool MojObject::NullImpl::equals(const MojObject::Impl& rhs) const
-{
-	MojAssert(rhs.type() == type());
-	return true;
-}
-
-MojSize MojObject::NullImpl::hashCode() const
-{
-	return TypeNull;
-}
-
-MojErr MojObject::NullImpl::visit(MojObjectVisitor& visitor) const
-{
-	MojErr err = visitor.nullValue();
-	MojErrCheck(err);
-	return MojErrNone;
-}
-
-MojSize MojObject::UndefinedImpl::hashCode() const
-{
-	return TypeUndefined;
-}
-
-int MojObject::ObjectImpl::compare(const MojObject::Impl& rhs) const
+template<class T>
+T* MojObject::allocNode(MojObjectArena* arena)
 {
-	MojAssert(rhs.type() == type());
-	const ObjectImpl& rhsImpl = static_cast<const ObjectImpl&>(rhs);
-	return m_props.compare(rhsImpl.m_props);
+	if (arena) {
+		void* p = arena->alloc(sizeof(T));
+		if (p) {
+			arena->nodeCreated();
+			return new (p) T(arena);
+		}
+	}
+	return new T(NULL);
 }
 
-bool MojObject::ObjectImpl::equals(const MojObject::Impl& rhs) const
+template<class T>
+void MojObject::freeNode(T* node)
 {
-	MojAssert(rhs.type() == type());
-	const ObjectImpl& rhsImpl = static_cast<const ObjectImpl&>(rhs);
-	return m_props == rhsImpl.m_props;
+	MojObjectArena* arena = node->m_arena;
+	if (arena) {
+		// memory goes back with the arena
+		node->~T();
+		arena->nodeDestroyed();
+	} else {
+		delete node;
+	}
 }
 
-MojSize MojObject::ObjectImpl::hashCode() const
-{
-	MojSize hash = TypeObject;
-	for (ConstIterator i = m_props.begin(); i != m_props.end(); ++i) {
-		hash ^= MojHash(i.key());
-		hash ^= i.value().hashCode();
+void MojObject::init(const MojObject& obj, MojObjectArena* arena)
+{
+	if (&obj == this)
+		return;
+
+	// copy before releasing, obj may be part of this value
+	Value val = obj.m_val;
+	MojByte type = obj.m_type;
+	MojByte len = obj.m_len;
+	MojErr err = MojErrNone;
+	switch (type) {
+	case TypeObject: {
+		const ObjectNode* src = obj.m_val.m_obj;
+		ObjectNode* node = allocNode<ObjectNode>(arena);
+		// children of a heap node are on the heap too, so they can be shared.
+		// children of an arena node must not end up outside of that arena.
+		if (src->m_arena == NULL || src->m_arena == node->m_arena) {
+			node->m_props = src->m_props;
+		} else {
+			err = copyNode(*src, *node);
+		}
+		val.m_obj = node;
+		break;
 	}
-	return hash;
+	case TypeArray: {
+		const ArrayNode* src = obj.m_val.m_arr;
+		ArrayNode* node = allocNode<ArrayNode>(arena);
+		if (src->m_arena == NULL || src->m_arena == node->m_arena) {
+			node->m_vec = src->m_vec;
+		} else {
+			err = copyNode(*src, *node);
+		}
+		val.m_arr = node;
+		break;
+	}
+	case TypeString:
+		if (len == HeapString)
+			val.m_str = new MojString(*obj.m_val.m_str);
+		break;
+	default:
+		break;
+	}
+	MojErrCatchAll(err);
+	release();
+	m_val = val;
+	m_type = type;
+	m_len = len;
 }
 
-MojSize MojObject::ObjectImpl::containerSize() const
+void MojObject::take(MojObject& obj)
 {
-	return m_props.size();
-}
+	MojAssert(&obj != this);
 
-bool MojObject::ObjectImpl::boolValue() const
-{
-	return !m_props.empty();
+	release();
+	m_val = obj.m_val;
+	m_type = obj.m_type;
+	m_len = obj.m_len;
+	obj.m_type = TypeUndefined;
+	obj.m_len = 0;
 }
 
-MojErr MojObject::ObjectImpl::visit(MojObjectVisitor& visitor) const
+MojErr MojObject::putProp(ObjectNode& node, const MojString& key, const MojObject& val)
 {
-	MojErr err = visitor.beginObject();
-	MojErrCheck(err);
-	for (PropMap::ConstIterator i = m_props.begin(); i != m_props.end(); ++i) {
-		const MojString& propName = i.key();
-		err = visitor.propName(propName, propName.length());
-		MojErrCheck(err);
-		err = i.value().impl()->visit(visitor);
+	if (!node.m_arena) {
+		MojErr err = node.m_props.put(key, val);
 		MojErrCheck(err);
+		return MojErrNone;
 	}
-	err = visitor.endObject();
+	// copy into the node's arena first, val may live in node itself
+	MojObject copy;
+	copy.init(val, node.m_arena);
+	MojErr err = node.m_props.put(key, Undefined);
 	MojErrCheck(err);
-	return MojErrNone;
-}
-
-const MojObject::PropMap* MojObject::ObjectImpl::map() const
-{
-	return &m_props;
-}
-
-bool MojObject::ObjectImpl::get(const MojChar* key, MojObject& valOut) const
-{
-	MojAssert(key);
-	bool found = m_props.get(key, valOut);
-	if (!found)
-		valOut.clear();
-	return found;
-}
-
-MojErr MojObject::ObjectImpl::del(const MojChar* key, bool& foundOut)
-{
-	MojAssert(key);
-	return m_props.del(key, foundOut);
-}
-
-int MojObject::ArrayImpl::compare(const MojObject::Impl& rhs) const
-{
-	MojAssert(rhs.type() == type());
-	const ArrayImpl& rhsImpl = static_cast<const ArrayImpl&>(rhs);
-	return m_vec.compare(rhsImpl.m_vec);
-}
-
-bool MojObject::ArrayImpl::equals(const MojObject::Impl& rhs) const
-{
-	MojAssert(rhs.type() == type());
-	const ArrayImpl& rhsImpl = static_cast<const ArrayImpl&>(rhs);
-	return m_vec == rhsImpl.m_vec;
-}
-
-MojSize MojObject::ArrayImpl::hashCode() const
-{
-	MojSize hash = TypeArray;
-	for (ConstArrayIterator i = m_vec.begin(); i != m_vec.end(); ++i) {
-		hash ^= i->hashCode();
-	}
-	return hash;
-}
-
-MojSize MojObject::ArrayImpl::containerSize() const
-{
-	return m_vec.size();
-}
+	Iterator iter;
+	err = node.m_props.find(key.data(), iter);
+	MojErrCheck(err);
+	MojAssert(iter != node.m_props.end());
+	iter->take(copy);
 
-bool MojObject::ArrayImpl::boolValue() const
-{
-	return !m_vec.empty();
+	return MojErrNone;
 }
 
-MojErr MojObject::ArrayImpl::visit(MojObjectVisitor& visitor) const
+MojErr MojObject::setElem(ArrayNode& node, MojSize idx, const MojObject& val)
 {
-	MojErr err = visitor.beginArray();
-	MojErrCheck(err);
-	for (ObjectVec::ConstIterator i = m_vec.begin(); i != m_vec.end(); ++i) {
-		err = i->impl()->visit(visitor);
+	// copy before resizing, val may be an element of node
+	MojObject copy;
+	copy.init(val, node.m_arena);
+	if (node.m_vec.size() <= idx) {
+		MojErr err = node.m_vec.resize(idx + 1);
 		MojErrCheck(err);
 	}
-	err = visitor.endArray();
+	ArrayIterator iter;
+	MojErr err = node.m_vec.begin(iter);
 	MojErrCheck(err);
-	return MojErrNone;
-}
+	iter[idx].take(copy);
 
-MojErr MojObject::ArrayImpl::arrayBegin(ArrayIterator& iter)
-{
-	MojErr err = m_vec.begin(iter);
-	MojErrCheck(err);
 	return MojErrNone;
 }
 
-MojObject::ConstArrayIterator MojObject::ArrayImpl::arrayBegin() const
-{
-	return m_vec.begin();
-}
-
-MojObject::ConstArrayIterator MojObject::ArrayImpl::arrayEnd() const
-{
-	return m_vec.end();
-}
-
-bool MojObject::ArrayImpl::at(MojSize idx, MojObject& objOut) const
-{
-	if (idx >= m_vec.size())
-		return false;
-	objOut = m_vec.at(idx);
-	return true;
-}
-
-int MojObject::StringImpl::compare(const MojObject::Impl& rhs) const
-{
-	MojAssert(rhs.type() == type());
-	const StringImpl& rhsImpl = static_cast<const StringImpl&>(rhs);
-	return m_val.compare(rhsImpl.m_val);
-}
-
-bool MojObject::StringImpl::equals(const MojObject::Impl& rhs) const
-{
-	MojAssert(rhs.type() == type());
-	const StringImpl& rhsImpl = static_cast<const StringImpl&>(rhs);
-	return m_val == rhsImpl.m_val;
-}
-
-MojSize MojObject::StringImpl::hashCode() const
-{
-	return MojHasher<MojString>()(m_val);
-}
-
-bool MojObject::StringImpl::boolValue() const
-{
-	return !m_val.empty();
-}
-
-MojInt64 MojObject::StringImpl::intValue() const
-{
-	return MojStrToInt64(m_val, NULL, 0);
-}
-
-MojDecimal MojObject::StringImpl::decimalValue() const
+MojErr MojObject::copyNode(const ObjectNode& src, ObjectNode& dest)
 {
-	// TODO: skip double conversion
-	MojDouble d = MojStrToDouble(m_val, NULL);
-	return MojDecimal(d);
-}
-
-MojErr MojObject::StringImpl::stringValue(MojString& valOut) const
-{
-	valOut = m_val;
+	for (ConstIterator i = src.m_props.begin(); i != src.m_props.end(); ++i) {
+		MojErr err = putProp(dest, i.key(), i.value());
+		MojErrCheck(err);
+	}
 	return MojErrNone;
 }
 
-MojErr MojObject::StringImpl::visit(MojObjectVisitor& visitor) const
+MojErr MojObject::copyNode(const ArrayNode& src, ArrayNode& dest)
 {
-	MojErr err = visitor.stringValue(m_val, m_val.length());
+	MojErr err = dest.m_vec.resize(src.m_vec.size());
 	MojErrCheck(err);
-	return MojErrNone;
-}
-
-int MojObject::BoolImpl::compare(const MojObject::Impl& rhs) const
-{
-	MojAssert(rhs.type() == type());
-	const BoolImpl& rhsImpl = static_cast<const BoolImpl&>(rhs);
-	return m_val - rhsImpl.m_val;
-}
-
-bool MojObject::BoolImpl::equals(const MojObject::Impl& rhs) const
-{
-	MojAssert(rhs.type() == type());
-	const BoolImpl& rhsImpl = static_cast<const BoolImpl&>(rhs);
-	return m_val == rhsImpl.m_val;
-}
-
-MojSize MojObject::BoolImpl::hashCode() const
-{
-	return TypeBool + m_val;
-}
-
-MojErr MojObject::BoolImpl::visit(MojObjectVisitor& visitor) const
-{
-	MojErr err = visitor.boolValue(m_val);
+	ArrayIterator iter;
+	err = dest.m_vec.begin(iter);
 	MojErrCheck(err);
+	for (ConstArrayIterator i = src.m_vec.begin(); i != src.m_vec.end(); ++i, ++iter) {
+		iter->init(*i, dest.m_arena);
+	}
 	return MojErrNone;
 }
 
-int MojObject::DecimalImpl::compare(const MojObject::Impl& rhs) const
-{
-	MojAssert(rhs.type() == type());
-	const DecimalImpl& rhsImpl = static_cast<const DecimalImpl&>(rhs);
-	return MojComp<MojDecimal>()(m_val, rhsImpl.m_val);
-}
-
-bool MojObject::DecimalImpl::equals(const MojObject::Impl& rhs) const
+void MojObject::init(Type type, MojObjectArena* arena)
 {
-	MojAssert(rhs.type() == type());
-	const DecimalImpl& rhsImpl = static_cast<const DecimalImpl&>(rhs);
-	return m_val == rhsImpl.m_val;
-}
+	release();
 
-MojSize MojObject::DecimalImpl::hashCode() const
-{
-	return MojHasher<MojDecimal>()(m_val);
-}
-
-MojErr MojObject::DecimalImpl::visit(MojObjectVisitor& visitor) const
-{
-	MojErr err = visitor.decimalValue(m_val);
-	MojErrCheck(err);
-	return MojErrNone;
+	switch (type) {
+	case TypeObject:
+		m_val.m_obj = allocNode<ObjectNode>(arena);
+		break;
+	case TypeArray:
+		m_val.m_arr = allocNode<ArrayNode>(arena);
+		break;
+	case TypeString:
+		m_len = 0;
+		break;
+	case TypeBool:
+		m_val.m_bool = false;
+		break;
+	case TypeDecimal:
+	case TypeInt:
+		m_val.m_int = 0;
+		break;
+	case TypeNull:
+	case TypeUndefined:
+		break;
+	default:
+		MojAssertNotReached(); 	// fall through to undefined
+		type = TypeUndefined;
+	}
+	m_type = (MojByte) type;
 }
 
-int MojObject::IntImpl::compare(const MojObject::Impl& rhs) const
+void MojObject::initString(const MojString& str)
 {
-	MojAssert(rhs.type() == type());
-	const IntImpl& rhsImpl = static_cast<const IntImpl&>(rhs);
-	return MojComp<MojInt64>()(m_val, rhsImpl.m_val);
+	MojSize len = str.length();
+	MojAssert(m_type == TypeUndefined);
+	if (len <= InlineStringMax) {
+		memcpy(m_val.m_chars, str.data(), len * sizeof(MojChar));
+		m_len = (MojByte) len;
+	} else {
+		m_val.m_str = new MojString(str);
+		m_len = HeapString;
+	}
+	m_type = TypeString;
 }
 
-bool MojObject::IntImpl::equals(const MojObject::Impl& rhs) const
+void MojObject::release()
 {
-	MojAssert(rhs.type() == type());
-	const IntImpl& rhsImpl = static_cast<const IntImpl&>(rhs);
-	return m_val == rhsImpl.m_val;
+	switch (m_type) {
+	case TypeObject:
+		freeNode(m_val.m_obj);
+		break;
+	case TypeArray:
+		freeNode(m_val.m_arr);
+		break;
+	case TypeString:
+		if (m_len == HeapString)
+			delete m_val.m_str;
+		break;
+	default:
+		break;
+	}
+	m_type = TypeUndefined;
+	m_len = 0;
 }
 
-MojSize MojObject::IntImpl::hashCode() const
+MojObject::ObjectNode& MojObject::ensureObject()
 {
-	return MojHasher<MojInt64>()(m_val);
+	if (m_type != TypeObject) {
+		// an array turning into an object stays in its arena
+		MojObjectArena* arena = (m_type == TypeArray) ? m_val.m_arr->m_arena : NULL;
+		init(TypeObject, arena);
+	}
+	return *m_val.m_obj;
 }
 
-MojErr MojObject::IntImpl::visit(MojObjectVisitor& visitor) const
+MojObject::ArrayNode& MojObject::ensureArray()
 {
-	MojErr err = visitor.intValue(m_val);
-	MojErrCheck(err);
-	return MojErrNone;
+	if (m_type != TypeArray) {
+		MojObjectArena* arena = (m_type == TypeObject) ? m_val.m_obj->m_arena : NULL;
+		init(TypeArray, arena);
+	}
+	return *m_val.m_arr;
 }
 
 MojErr MojObjectVisitor::boolProp(const MojChar* name, bool val)
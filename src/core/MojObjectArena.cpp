@@ -0,0 +1,97 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "core/MojObjectArena.h"
+
+MojObjectArena::MojObjectArena()
+: m_chunks(NULL),
+  m_pos(NULL),
+  m_end(NULL),
+  m_nodes(0),
+  m_used(0),
+  m_reserved(0)
+{
+}
+
+MojObjectArena::~MojObjectArena()
+{
+	clear();
+}
+
+void* MojObjectArena::alloc(MojSize size)
+{
+	// keep everything 8-byte aligned
+	size = (size + 7) & ~((MojSize) 7);
+
+	// nothing in the arena is alive, so start over in the newest chunk
+	if (m_nodes == 0 && m_used > 0)
+		rewind();
+
+	if (m_pos == NULL || (MojSize) (m_end - m_pos) < size) {
+		MojSize chunkSize = HeaderSize + size;
+		if (chunkSize < ChunkSize)
+			chunkSize = ChunkSize;
+		MojByte* bytes = (MojByte*) MojMalloc(chunkSize);
+		if (bytes == NULL)
+			return NULL;
+		Chunk* chunk = (Chunk*) bytes;
+		chunk->m_next = m_chunks;
+		chunk->m_size = chunkSize;
+		m_chunks = chunk;
+		m_pos = bytes + HeaderSize;
+		m_end = bytes + chunkSize;
+		m_reserved += chunkSize;
+	}
+	void* p = m_pos;
+	m_pos += size;
+	m_used += size;
+
+	return p;
+}
+
+void MojObjectArena::clear()
+{
+	// every MojObject that used the arena must be gone by now
+	MojAssert(m_nodes == 0);
+
+	while (m_chunks) {
+		Chunk* next = m_chunks->m_next;
+		MojFree(m_chunks);
+		m_chunks = next;
+	}
+	m_pos = NULL;
+	m_end = NULL;
+	m_used = 0;
+	m_reserved = 0;
+}
+
+void MojObjectArena::rewind()
+{
+	MojAssert(m_chunks && m_nodes == 0);
+
+	Chunk* next = m_chunks->m_next;
+	m_chunks->m_next = NULL;
+	while (next) {
+		Chunk* chunk = next;
+		next = chunk->m_next;
+		MojFree(chunk);
+	}
+	m_pos = (MojByte*) m_chunks + HeaderSize;
+	m_end = (MojByte*) m_chunks + m_chunks->m_size;
+	m_used = 0;
+	m_reserved = m_chunks->m_size;
+}
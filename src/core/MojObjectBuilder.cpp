@@ -17,7 +17,8 @@
 
 #include "core/MojObjectBuilder.h"
 
-MojObjectBuilder::MojObjectBuilder()
+MojObjectBuilder::MojObjectBuilder(MojObjectArena* arena)
+: m_arena(arena)
 {
 }
 
@@ -111,7 +112,7 @@ MojErr MojObjectBuilder::stringValue(const MojChar* val, MojSize len)
 
 MojErr MojObjectBuilder::push(MojObject::Type type)
 {
-	m_stack.push(Rec(type, m_propName));
+	m_stack.emplace(type, m_arena, m_propName);
 
 	return MojErrNone;
 }
@@ -120,8 +121,10 @@ MojErr MojObjectBuilder::pop()
 {
 	MojAssert(!m_stack.empty());
 
+	// a plain copy would move the value out of the arena
 	const Rec& rec = m_stack.top();
-	MojObject obj = rec.m_obj;
+	MojObject obj;
+	obj.assign(rec.m_obj, m_arena);
 	m_propName = rec.m_propName;
 	m_stack.pop();
 	MojErr err = value(obj);
@@ -133,7 +136,7 @@ MojErr MojObjectBuilder::pop()
 MojErr MojObjectBuilder::value(const MojObject& val)
 {
 	if (m_stack.empty()) {
-		m_obj = val;
+		m_obj.assign(val, m_arena);
 	} else {
 		MojObject& obj = back();
 		if (obj.type() == MojObject::TypeObject) {
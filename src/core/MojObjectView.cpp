@@ -0,0 +1,463 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "core/MojObjectView.h"
+#include "core/MojObjectBuilder.h"
+
+MojObjectView::MojObjectView()
+: m_obj(&MojObject::Undefined),
+  m_begin(NULL),
+  m_end(NULL),
+  m_tokenSet(NULL),
+  m_header(NULL)
+{
+}
+
+MojObjectView::MojObjectView(const MojObject& obj)
+: m_obj(&obj),
+  m_begin(NULL),
+  m_end(NULL),
+  m_tokenSet(NULL),
+  m_header(NULL)
+{
+}
+
+MojObjectView::MojObjectView(const MojByte* data, MojSize size, MojTokenSet* tokenSet, const MojObject* header)
+: m_obj(NULL),
+  m_begin(data),
+  m_end(data + size),
+  m_tokenSet(tokenSet),
+  m_header(header)
+{
+	MojAssert(data && size > 0);
+}
+
+MojObject::Type MojObjectView::type() const
+{
+	if (m_obj)
+		return m_obj->type();
+
+	switch (marker()) {
+	case MojObjectWriter::MarkerNullValue:
+		return MojObject::TypeNull;
+	case MojObjectWriter::MarkerObjectBegin:
+		return MojObject::TypeObject;
+	case MojObjectWriter::MarkerArrayBegin:
+		return MojObject::TypeArray;
+	case MojObjectWriter::MarkerStringValue:
+		return MojObject::TypeString;
+	case MojObjectWriter::MarkerFalseValue:
+	case MojObjectWriter::MarkerTrueValue:
+		return MojObject::TypeBool;
+	case MojObjectWriter::MarkerNegativeDecimalValue:
+	case MojObjectWriter::MarkerPositiveDecimalValue:
+		return MojObject::TypeDecimal;
+	case MojObjectWriter::MarkerZeroIntValue:
+	case MojObjectWriter::MarkerUInt8Value:
+	case MojObjectWriter::MarkerUInt16Value:
+	case MojObjectWriter::MarkerUInt32Value:
+	case MojObjectWriter::MarkerNegativeIntValue:
+	case MojObjectWriter::MarkerInt64Value:
+		return MojObject::TypeInt;
+	default:
+		if (marker() >= MojObjectWriter::TokenStartMarker)
+			return MojObject::TypeString;
+		return MojObject::TypeUndefined;
+	}
+}
+
+MojErr MojObjectView::boolValue(bool& valOut) const
+{
+	if (m_obj) {
+		valOut = m_obj->boolValue();
+		return MojErrNone;
+	}
+	if (marker() == MojObjectWriter::MarkerTrueValue || marker() == MojObjectWriter::MarkerFalseValue) {
+		valOut = (marker() == MojObjectWriter::MarkerTrueValue);
+		return MojErrNone;
+	}
+	// conversions follow MojObject
+	MojObject obj;
+	MojErr err = toObject(obj);
+	MojErrCheck(err);
+	valOut = obj.boolValue();
+
+	return MojErrNone;
+}
+
+MojErr MojObjectView::intValue(MojInt64& valOut) const
+{
+	if (m_obj) {
+		valOut = m_obj->intValue();
+		return MojErrNone;
+	}
+	if (type() == MojObject::TypeInt) {
+		MojDataReader reader(m_begin + 1, m_end - m_begin - 1);
+		MojErr err = MojObjectReader::readInt(reader, marker(), valOut);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	MojObject obj;
+	MojErr err = toObject(obj);
+	MojErrCheck(err);
+	valOut = obj.intValue();
+
+	return MojErrNone;
+}
+
+MojErr MojObjectView::decimalValue(MojDecimal& valOut) const
+{
+	if (m_obj) {
+		valOut = m_obj->decimalValue();
+		return MojErrNone;
+	}
+	if (type() == MojObject::TypeDecimal) {
+		MojDataReader reader(m_begin + 1, m_end - m_begin - 1);
+		MojErr err = reader.readDecimal(valOut);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	MojObject obj;
+	MojErr err = toObject(obj);
+	MojErrCheck(err);
+	valOut = obj.decimalValue();
+
+	return MojErrNone;
+}
+
+MojErr MojObjectView::stringValue(MojString& valOut) const
+{
+	if (m_obj) {
+		MojErr err = m_obj->stringValue(valOut);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	if (marker() == MojObjectWriter::MarkerStringValue) {
+		MojDataReader reader(m_begin + 1, m_end - m_begin - 1);
+		const MojChar* str = NULL;
+		MojSize strLen = 0;
+		MojErr err = MojObjectReader::readString(reader, str, strLen);
+		MojErrCheck(err);
+		err = valOut.assign(str, strLen);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	if (marker() >= MojObjectWriter::TokenStartMarker && m_tokenSet) {
+		MojErr err = m_tokenSet->stringFromToken(marker(), valOut);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	MojObject obj;
+	MojErr err = toObject(obj);
+	MojErrCheck(err);
+	err = obj.stringValue(valOut);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectView::get(const MojChar* key, MojObjectView& valOut, bool& foundOut) const
+{
+	MojAssert(key);
+
+	foundOut = false;
+	if (m_obj) {
+		MojObject::ConstIterator iter = m_obj->find(key);
+		if (iter != m_obj->end()) {
+			valOut = MojObjectView(iter.value());
+			foundOut = true;
+		}
+		return MojErrNone;
+	}
+	if (marker() != MojObjectWriter::MarkerObjectBegin)
+		return MojErrNone;
+
+	if (m_header) {
+		MojObject::ConstIterator iter = m_header->find(key);
+		if (iter != m_header->end()) {
+			valOut = MojObjectView(iter.value());
+			foundOut = true;
+			return MojErrNone;
+		}
+	}
+
+	// compare names by token where we can, so tokenized props need no lookup
+	MojUInt8 token = MojTokenSet::InvalidToken;
+	if (m_tokenSet) {
+		MojErr err = m_tokenSet->tokenFromString(key, token, false);
+		MojErrCheck(err);
+	}
+	MojSize keyLen = MojStrLen(key);
+
+	MojDataReader reader(m_begin + 1, m_end - m_begin - 1);
+	for (;;) {
+		MojByte nameMarker;
+		MojErr err = reader.readUInt8(nameMarker);
+		MojErrCheck(err);
+		if (nameMarker == MojObjectWriter::MarkerObjectEnd)
+			break;
+
+		bool match = false;
+		if (nameMarker == MojObjectWriter::MarkerStringValue) {
+			const MojChar* name = NULL;
+			MojSize nameLen = 0;
+			err = MojObjectReader::readString(reader, name, nameLen);
+			MojErrCheck(err);
+			match = (nameLen == keyLen && MojStrNCmp(name, key, keyLen) == 0);
+		} else if (nameMarker >= MojObjectWriter::TokenStartMarker) {
+			match = (nameMarker == token);
+		} else {
+			MojErrThrow(MojErrObjectReaderUnexpectedMarker);
+		}
+
+		const MojByte* valBegin = reader.pos();
+		err = skipValue(reader);
+		MojErrCheck(err);
+		if (match) {
+			valOut = MojObjectView(valBegin, reader.pos() - valBegin, m_tokenSet);
+			foundOut = true;
+			break;
+		}
+	}
+	return MojErrNone;
+}
+
+MojErr MojObjectView::begin(ConstIterator& iterOut) const
+{
+	iterOut.m_view = *this;
+	iterOut.m_pos = NULL;
+	if (m_obj) {
+		if (m_obj->type() == MojObject::TypeObject) {
+			iterOut.m_propIter = m_obj->begin();
+		} else if (m_obj->type() == MojObject::TypeArray) {
+			iterOut.m_arrayIter = m_obj->arrayBegin();
+		}
+		return MojErrNone;
+	}
+	if (marker() == MojObjectWriter::MarkerObjectBegin || marker() == MojObjectWriter::MarkerArrayBegin) {
+		iterOut.m_pos = m_begin + 1;
+		if (m_header)
+			iterOut.m_headerIter = m_header->begin();
+	}
+	return MojErrNone;
+}
+
+MojErr MojObjectView::visit(MojObjectVisitor& visitor) const
+{
+	if (m_obj) {
+		MojErr err = m_obj->visit(visitor);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	MojErr err = MojErrNone;
+	MojObjectReader reader(m_begin, m_end - m_begin);
+	reader.tokenSet(m_tokenSet);
+	if (m_header && marker() == MojObjectWriter::MarkerObjectBegin) {
+		err = visitor.beginObject();
+		MojErrCheck(err);
+		for (MojObject::ConstIterator i = m_header->begin(); i != m_header->end(); ++i) {
+			err = visitor.propName(i.key().data(), i.key().length());
+			MojErrCheck(err);
+			err = i.value().visit(visitor);
+			MojErrCheck(err);
+		}
+		reader.skipBeginObj();
+	}
+	err = reader.nextObject(visitor);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectView::toObject(MojObject& objOut) const
+{
+	if (m_obj) {
+		objOut = *m_obj;
+		return MojErrNone;
+	}
+
+	MojObjectBuilder builder;
+	MojErr err = visit(builder);
+	MojErrCheck(err);
+	objOut = builder.object();
+
+	return MojErrNone;
+}
+
+MojErr MojObjectView::skipValue(MojDataReader& reader)
+{
+	MojByte marker;
+	MojErr err = reader.readUInt8(marker);
+	MojErrCheck(err);
+
+	switch (marker) {
+	case MojObjectWriter::MarkerObjectBegin:
+	case MojObjectWriter::MarkerArrayBegin: {
+		bool isObject = (marker == MojObjectWriter::MarkerObjectBegin);
+		for (;;) {
+			if (reader.available() == 0)
+				MojErrThrow(MojErrUnexpectedEof);
+			if (*reader.pos() == MojObjectWriter::MarkerObjectEnd) {
+				err = reader.skip(1);
+				MojErrCheck(err);
+				break;
+			}
+			if (isObject) {
+				MojByte nameMarker;
+				err = reader.readUInt8(nameMarker);
+				MojErrCheck(err);
+				if (nameMarker == MojObjectWriter::MarkerStringValue) {
+					const MojChar* name = NULL;
+					MojSize nameLen = 0;
+					err = MojObjectReader::readString(reader, name, nameLen);
+					MojErrCheck(err);
+				} else if (nameMarker < MojObjectWriter::TokenStartMarker) {
+					MojErrThrow(MojErrObjectReaderUnexpectedMarker);
+				}
+			}
+			err = skipValue(reader);
+			MojErrCheck(err);
+		}
+		break;
+	}
+	case MojObjectWriter::MarkerStringValue: {
+		const MojChar* str = NULL;
+		MojSize strLen = 0;
+		err = MojObjectReader::readString(reader, str, strLen);
+		MojErrCheck(err);
+		break;
+	}
+	case MojObjectWriter::MarkerNullValue:
+	case MojObjectWriter::MarkerFalseValue:
+	case MojObjectWriter::MarkerTrueValue:
+		break;
+	case MojObjectWriter::MarkerNegativeDecimalValue:
+	case MojObjectWriter::MarkerPositiveDecimalValue: {
+		MojDecimal dec;
+		err = reader.readDecimal(dec);
+		MojErrCheck(err);
+		break;
+	}
+	case MojObjectWriter::MarkerZeroIntValue:
+	case MojObjectWriter::MarkerUInt8Value:
+	case MojObjectWriter::MarkerUInt16Value:
+	case MojObjectWriter::MarkerUInt32Value:
+	case MojObjectWriter::MarkerNegativeIntValue:
+	case MojObjectWriter::MarkerInt64Value: {
+		MojInt64 val;
+		err = MojObjectReader::readInt(reader, marker, val);
+		MojErrCheck(err);
+		break;
+	}
+	case MojObjectWriter::MarkerExtensionValue: {
+		MojUInt32 extSize;
+		err = reader.readUInt32(extSize);
+		MojErrCheck(err);
+		err = reader.skip(extSize);
+		MojErrCheck(err);
+		break;
+	}
+	default:
+		if (marker < MojObjectWriter::TokenStartMarker)
+			MojErrThrow(MojErrObjectReaderUnexpectedMarker);
+		break;
+	}
+	return MojErrNone;
+}
+
+MojErr MojObjectView::readName(MojDataReader& reader, const MojTokenSet* tokenSet, MojString& nameOut)
+{
+	MojByte marker;
+	MojErr err = reader.readUInt8(marker);
+	MojErrCheck(err);
+
+	if (marker == MojObjectWriter::MarkerStringValue) {
+		const MojChar* str = NULL;
+		MojSize strLen = 0;
+		err = MojObjectReader::readString(reader, str, strLen);
+		MojErrCheck(err);
+		err = nameOut.assign(str, strLen);
+		MojErrCheck(err);
+	} else if (marker >= MojObjectWriter::TokenStartMarker && tokenSet) {
+		err = tokenSet->stringFromToken(marker, nameOut);
+		MojErrCheck(err);
+	} else {
+		MojErrThrow(MojErrObjectReaderUnexpectedMarker);
+	}
+	return MojErrNone;
+}
+
+MojErr MojObjectView::ConstIterator::next(bool& foundOut)
+{
+	foundOut = false;
+
+	const MojObject* obj = m_view.m_obj;
+	if (obj) {
+		if (obj->type() == MojObject::TypeObject) {
+			if (m_propIter == obj->end())
+				return MojErrNone;
+			m_key = m_propIter.key();
+			m_val = MojObjectView(m_propIter.value());
+			++m_propIter;
+			foundOut = true;
+		} else if (obj->type() == MojObject::TypeArray) {
+			if (m_arrayIter == obj->arrayEnd())
+				return MojErrNone;
+			m_key.clear();
+			m_val = MojObjectView(*m_arrayIter);
+			++m_arrayIter;
+			foundOut = true;
+		}
+		return MojErrNone;
+	}
+	if (m_pos == NULL)
+		return MojErrNone;
+
+	bool isObject = (m_view.marker() == MojObjectWriter::MarkerObjectBegin);
+	if (isObject && m_view.m_header && m_headerIter != m_view.m_header->end()) {
+		m_key = m_headerIter.key();
+		m_val = MojObjectView(m_headerIter.value());
+		++m_headerIter;
+		foundOut = true;
+		return MojErrNone;
+	}
+
+	MojDataReader reader(m_pos, m_view.m_end - m_pos);
+	if (reader.available() == 0)
+		MojErrThrow(MojErrUnexpectedEof);
+	if (*m_pos == MojObjectWriter::MarkerObjectEnd) {
+		m_pos = NULL;
+		return MojErrNone;
+	}
+
+	MojErr err = MojErrNone;
+	if (isObject) {
+		err = readName(reader, m_view.m_tokenSet, m_key);
+		MojErrCheck(err);
+	} else {
+		m_key.clear();
+	}
+	const MojByte* valBegin = reader.pos();
+	err = skipValue(reader);
+	MojErrCheck(err);
+	m_val = MojObjectView(valBegin, reader.pos() - valBegin, m_view.m_tokenSet);
+	m_pos = reader.pos();
+	foundOut = true;
+
+	return MojErrNone;
+}
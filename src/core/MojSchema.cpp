@@ -43,11 +43,9 @@ const MojChar* const MojSchema::PatternKey = _T("pattern");
 
 const MojChar* const MojSchema::InvalidSchemaPrefix = _T("invalid schema");
 
-class MojSchema::PatternRule : public MojSchema::Rule
+class MojSchema::Pattern : public MojRefCounted
 {
 public:
-        PatternRule(MojSchema* schema): Rule(schema) {}
-
         MojErr fromObject (const MojObject& obj)
         {
                 try {
@@ -61,7 +59,7 @@ public:
                 return MojErrNone;
         }
 
-        MojErr validate(const MojObject& val, const MojObject& parent, Result& resOut) const
+        MojErr validate(const MojObject& val, Result& resOut) const
         {
                 MojString string_val;
                 (void) val.stringValue(string_val);
@@ -80,6 +78,7 @@ private:
 };
 
 MojSchema::MojSchema()
+: m_root(Program::NoBlock)
 {
 }
 
@@ -89,12 +88,14 @@ MojSchema::~MojSchema()
 
 MojErr MojSchema::fromObject(const MojObject& obj)
 {
-	MojRefCountedPtr<SchemaRule> rule(new SchemaRule(this));
-	MojAllocCheck(rule.get());
-	MojErr err = rule->fromObject(obj);
+	MojRefCountedPtr<Program> program(new Program(this));
+	MojAllocCheck(program.get());
+	MojUInt32 root = Program::NoBlock;
+	MojErr err = program->compile(obj, root);
 	MojErrCheck(err);
 
-	m_rule = rule;
+	m_program = program;
+	m_root = root;
 
 	return MojErrNone;
 }
@@ -103,337 +104,530 @@ MojErr MojSchema::validate(const MojObject& obj, Result& resOut) const
 {
 	// result is valid until a rule fails
 	resOut.valid(true);
-	if (m_rule.get()) {
-		MojErr err = m_rule->validate(obj, MojObject::Undefined, resOut);
+	if (m_program.get()) {
+		MojErr err = m_program->validate(m_root, obj, MojObject::Undefined, resOut);
 		MojErrCheck(err);
 	}
 	return MojErrNone;
 }
 
-MojSchema::SchemaRule::SchemaRule(MojSchema* schema)
-: Rule(schema),
-  m_optional(true)
+MojSchema::Program::Program(MojSchema* schema)
+: m_schema(schema)
 {
 }
 
-MojErr MojSchema::SchemaRule::fromObject(const MojObject& obj)
+MojSchema::Program::~Program()
 {
-	// additionalProperties
+}
+
+MojErr MojSchema::Program::compile(const MojObject& obj, MojUInt32& blockOut)
+{
+	// nested schemas are compiled before the ops of this one are appended,
+	// so the ops of every block stay contiguous
+	OpVec ops;
+	Block block;
 	MojErr err = MojErrNone;
 	MojObject val;
-	MojRefCountedPtr<AdditionalPropertiesRule> additionalProperties;
+	// additionalProperties
+	bool hasAdditional = false;
+	Op additional;
 	if (obj.get(AdditionalPropertiesKey, val)) {
-		additionalProperties.reset(new AdditionalPropertiesRule(m_schema));
-		MojAllocCheck(additionalProperties.get());
-		err = additionalProperties->fromObject(val);
+		hasAdditional = true;
+		err = compileAdditional(val, additional);
 		MojErrCheck(err);
 	}
 	// properties
-	if (obj.get(PropertiesKey, val) || additionalProperties.get()) {
-		MojRefCountedPtr<PropertiesRule> rule(new PropertiesRule(m_schema));
-		err = addRule(rule, val);
+	if (obj.get(PropertiesKey, val) || hasAdditional) {
+		Op op(OpProperties);
+		err = compileProperties(val, op);
+		MojErrCheck(err);
+		op.m_allow = additional.m_allow;
+		op.m_block = additional.m_block;
+		err = ops.push(op);
 		MojErrCheck(err);
-		rule->additionalProperties(additionalProperties.get());
 	}
         // optional or required
         bool required = false;
-        if (obj.get(OptionalKey, m_optional)) {
+        if (obj.get(OptionalKey, block.m_optional)) {
                 if (obj.get(RequiredKey, required)) {
-                        if (m_optional == required) {
+                        if (block.m_optional == required) {
 
 				MojString kind;
 				(void) obj.stringValue(kind);
 
 				LOG_ERROR (MSGID_DB_KIND_ENGINE_ERROR, 3,
 					   PMLOGKFV("required key : ", "%d", required),
-					   PMLOGKFV("optional key : ", "%d", m_optional),
+					   PMLOGKFV("optional key : ", "%d", block.m_optional),
 					   PMLOGKS ("kind : ", kind.data()),
                                            "These keys should be opposite or should be specified only one key. The 'optional' key more essential.");
                         }
                 }
         }
         else if (obj.get(RequiredKey, required)) {
-                m_optional = !required;
+                block.m_optional = !required;
         }
 	// type
 	if (obj.get(TypeKey, val)) {
 		if (val.type() == MojObject::TypeArray) {
-			err = addRule(new UnionTypeRule(m_schema), val);
+			Op op(OpUnion);
+			err = compileAlternatives(val, op);
+			MojErrCheck(err);
+			err = ops.push(op);
 			MojErrCheck(err);
 		} else {
-			err = addRule(new SimpleTypeRule(m_schema), val);
+			err = compileType(val, OpType, ops);
 			MojErrCheck(err);
 		}
 	}
 	// disallow
 	if (obj.get(DisallowKey, val)) {
 		if (val.type() == MojObject::TypeArray) {
-			err = addRule(new UnionDisallowRule(m_schema), val);
+			Op op(OpDisallowUnion);
+			err = compileAlternatives(val, op);
+			MojErrCheck(err);
+			err = ops.push(op);
 			MojErrCheck(err);
 		} else {
-			err = addRule(new SimpleDisallowRule(m_schema), val);
+			err = compileType(val, OpDisallowType, ops);
 			MojErrCheck(err);
 		}
 	}
 	// items
 	if (obj.get(ItemsKey, val)) {
 		if (val.type() == MojObject::TypeArray) {
-			MojRefCountedPtr<TupleItemsRule> rule(new TupleItemsRule(m_schema));
-			err = addRule(rule, val);
+			Op op(OpTuple);
+			err = compileAlternatives(val, op);
+			MojErrCheck(err);
+			op.m_allow = additional.m_allow;
+			op.m_block = additional.m_block;
+			err = ops.push(op);
 			MojErrCheck(err);
-			rule->additionalProperties(additionalProperties.get());
 		} else {
-			err = addRule(new SimpleItemsRule(m_schema), val);
+			Op op(OpItems);
+			err = compile(val, op.m_block);
+			MojErrCheck(err);
+			err = ops.push(op);
 			MojErrCheck(err);
 		}
 	}
         // pattern
         if (obj.get(PatternKey, val)) {
-                err = addRule(new PatternRule(m_schema), val);
+                MojRefCountedPtr<Pattern> pattern(new Pattern);
+                MojAllocCheck(pattern.get());
+                err = pattern->fromObject(val);
+                MojErrCheck(err);
+                Op op(OpPattern);
+                op.m_begin = (MojUInt32) m_patterns.size();
+                err = m_patterns.push(pattern);
+                MojErrCheck(err);
+                err = ops.push(op);
                 MojErrCheck(err);
         }
 	// requires
 	if (obj.get(RequiresKey, val)) {
-		err = addRule(new RequiresRule(m_schema), val);
+		MojString name;
+		err = val.stringValue(name);
+		MojErrCheck(err);
+		Op op(OpRequires);
+		op.m_begin = (MojUInt32) m_names.size();
+		err = m_names.push(name);
+		MojErrCheck(err);
+		err = ops.push(op);
 		MojErrCheck(err);
 	}
 	// minimum
 	if (obj.get(MinimumKey, val)) {
-		MojRefCountedPtr<MinRule> rule(new MinRule(m_schema));
-		err = addRule(rule, val);
-		MojErrCheck(err);
+		Op op(OpMinimum);
+		op.m_dec = val.decimalValue();
 		bool canEqual = false;
 		if (obj.get(MinimumCanEqualKey, canEqual))
-			rule->canEqual(canEqual);
+			op.m_canEqual = canEqual;
+		err = ops.push(op);
+		MojErrCheck(err);
 	}
 	// maximum
 	if (obj.get(MaximumKey, val)) {
-		MojRefCountedPtr<MaxRule> rule(new MaxRule(m_schema));
-		err = addRule(rule, val);
-		MojErrCheck(err);
+		Op op(OpMaximum);
+		op.m_dec = val.decimalValue();
 		bool canEqual = false;
 		if (obj.get(MaximumCanEqualKey, canEqual))
-			rule->canEqual(canEqual);
+			op.m_canEqual = canEqual;
+		err = ops.push(op);
+		MojErrCheck(err);
 	}
 	// minItems
 	if (obj.get(MinItemsKey, val)) {
-		err = addRule(new MinItemsRule(m_schema), val);
+		Op op(OpMinItems);
+		op.m_int = val.intValue();
+		err = ops.push(op);
 		MojErrCheck(err);
 	}
 	// maxItems
 	if (obj.get(MaxItemsKey, val)) {
-		err = addRule(new MaxItemsRule(m_schema), val);
+		Op op(OpMaxItems);
+		op.m_int = val.intValue();
+		err = ops.push(op);
 		MojErrCheck(err);
 	}
 	// uniqueItems
 	bool boolVal;
 	if (obj.get(UniqueItemsKey, boolVal) && boolVal) {
-		err = addRule(new UniqueItemsRule(m_schema), boolVal);
+		err = ops.push(Op(OpUniqueItems));
 		MojErrCheck(err);
 	}
 	// minLength
 	if (obj.get(MinLengthKey, val)) {
-		err = addRule(new MinLenRule(m_schema), val);
+		Op op(OpMinLength);
+		op.m_int = val.intValue();
+		err = ops.push(op);
 		MojErrCheck(err);
 	}
 	// maxLength
 	if (obj.get(MaxLengthKey, val)) {
-		err = addRule(new MaxLenRule(m_schema), val);
+		Op op(OpMaxLength);
+		op.m_int = val.intValue();
+		err = ops.push(op);
 		MojErrCheck(err);
 	}
 	// enum
 	if (obj.get(EnumKey, val)) {
-		err = addRule(new EnumRule(m_schema), val);
+		Op op(OpEnum);
+		err = compileEnum(val, op);
+		MojErrCheck(err);
+		err = ops.push(op);
 		MojErrCheck(err);
 	}
 	// divisibleBy
 	if (obj.get(DivisibleByKey, val)) {
-		err = addRule(new DivisibleRule(m_schema), val);
+		Op op(OpDivisibleBy);
+		op.m_int = val.intValue();
+		err = ops.push(op);
 		MojErrCheck(err);
 	}
-	return MojErrNone;
-}
-
-MojErr MojSchema::SchemaRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
-{
-	for (RuleVec::ConstIterator i = m_rules.begin(); i != m_rules.end(); ++i) {
-		MojErr err = (*i)->validate(val, parent, resOut);
-		MojErrCheck(err);
-		if (!resOut.valid())
-			break;
-	}
-	return MojErrNone;
-}
 
-MojErr MojSchema::SchemaRule::addRule(MojRefCountedPtr<Rule> rule, const MojObject& obj)
-{
-	MojAllocCheck(rule.get());
-	MojErr err = rule->fromObject(obj);
+	block.m_begin = (MojUInt32) m_ops.size();
+	err = m_ops.append(ops.begin(), ops.end());
 	MojErrCheck(err);
-	err = m_rules.push(rule);
+	block.m_end = (MojUInt32) m_ops.size();
+	blockOut = (MojUInt32) m_blocks.size();
+	err = m_blocks.push(block);
 	MojErrCheck(err);
 
 	return MojErrNone;
 }
 
-MojErr MojSchema::SimpleTypeRule::fromObject(const MojObject& obj)
+MojErr MojSchema::Program::typeMask(const MojObject& obj, MojInt64& maskOut)
 {
 	MojString typeStr;
 	MojErr err = obj.stringValue(typeStr);
 	MojErrCheck(err);
-	MojObject::Type type = MojObject::TypeUndefined;
 	if (typeStr == _T("null")) {
-		type = MojObject::TypeNull;
+		maskOut = (MojInt64) 1 << MojObject::TypeNull;
 	} else if (typeStr == _T("object")) {
-		type = MojObject::TypeObject;
+		maskOut = (MojInt64) 1 << MojObject::TypeObject;
 	} else if (typeStr == _T("array")) {
-		type = MojObject::TypeArray;
+		maskOut = (MojInt64) 1 << MojObject::TypeArray;
 	} else if (typeStr == _T("string")) {
-		type = MojObject::TypeString;
+		maskOut = (MojInt64) 1 << MojObject::TypeString;
 	} else if (typeStr == _T("boolean")) {
-		type = MojObject::TypeBool;
+		maskOut = (MojInt64) 1 << MojObject::TypeBool;
 	} else if (typeStr == _T("integer")) {
-		type = MojObject::TypeInt;
+		maskOut = (MojInt64) 1 << MojObject::TypeInt;
 	} else if (typeStr == _T("number")) {
-		err = m_types.push(MojObject::TypeDecimal);
-		MojErrCheck(err);
-		type = MojObject::TypeInt;
+		maskOut = ((MojInt64) 1 << MojObject::TypeDecimal) | ((MojInt64) 1 << MojObject::TypeInt);
 	} else {
 		MojErrThrowMsg(MojErrInvalidSchema, _T("%s: invalid type '%s'"), InvalidSchemaPrefix, typeStr.data());
 	}
-	err = m_types.push(type);
-	MojErrCheck(err);
-
 	return MojErrNone;
 }
 
-MojErr MojSchema::SimpleTypeRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
+MojErr MojSchema::Program::compileType(const MojObject& obj, OpCode code, OpVec& ops)
 {
-	MojObject::Type type = val.type();
-	for (TypeVec::ConstIterator i = m_types.begin(); i != m_types.end(); ++i) {
-		if (*i == type)
-			return MojErrNone;
-	}
-
-	resOut.valid(false);
-	MojErr err = resOut.m_msg.assign(_T("invalid type"));
+	Op op(code);
+	MojErr err = typeMask(obj, op.m_int);
+	MojErrCheck(err);
+	err = ops.push(op);
 	MojErrCheck(err);
 
 	return MojErrNone;
 }
 
-MojErr MojSchema::UnionTypeRule::fromObject(const MojObject& obj)
+MojErr MojSchema::Program::compileAlternatives(const MojObject& obj, Op& op)
 {
+	// a type name becomes a block of its own, so every alternative is a block
+	IndexVec children;
 	MojObject::ConstArrayIterator end = obj.arrayEnd();
 	for (MojObject::ConstArrayIterator i = obj.arrayBegin(); i != end; ++i) {
+		MojUInt32 child = NoBlock;
 		if (i->type() == MojObject::TypeString) {
-			MojErr err = addRule(new SimpleTypeRule(m_schema), *i);
+			Op typeOp(OpType);
+			MojErr err = typeMask(*i, typeOp.m_int);
+			MojErrCheck(err);
+			Block block;
+			block.m_begin = (MojUInt32) m_ops.size();
+			err = m_ops.push(typeOp);
+			MojErrCheck(err);
+			block.m_end = (MojUInt32) m_ops.size();
+			child = (MojUInt32) m_blocks.size();
+			err = m_blocks.push(block);
 			MojErrCheck(err);
 		} else {
-			MojErr err = addRule(new SchemaRule(m_schema), *i);
+			MojErr err = compile(*i, child);
 			MojErrCheck(err);
 		}
+		MojErr err = children.push(child);
+		MojErrCheck(err);
 	}
+	op.m_begin = (MojUInt32) m_children.size();
+	op.m_count = (MojUInt32) children.size();
+	MojErr err = m_children.append(children.begin(), children.end());
+	MojErrCheck(err);
+
 	return MojErrNone;
 }
 
-MojErr MojSchema::UnionTypeRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
+MojErr MojSchema::Program::compileAdditional(const MojObject& obj, Op& op)
 {
-	for (RuleVec::ConstIterator i = m_rules.begin(); i != m_rules.end(); ++i) {
-		resOut.valid(true);
-		MojErr err = (*i)->validate(val, parent, resOut);
+	if (obj.type() == MojObject::TypeBool) {
+		op.m_allow = obj.boolValue();
+	} else {
+		MojErr err = compile(obj, op.m_block);
 		MojErrCheck(err);
-		if (resOut.valid())
-			return MojErrNone;
 	}
-	resOut.valid(false);
-
 	return MojErrNone;
 }
 
-MojErr MojSchema::SimpleDisallowRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
+MojErr MojSchema::Program::compileProperties(const MojObject& obj, Op& op)
 {
-	Result typeRes;
-	typeRes.valid(true);
-	MojErr err = SimpleTypeRule::validate(val, parent, typeRes);
-	MojErrCheck(err);
-	if (typeRes.valid()) {
-		resOut.valid(false);
-		err = resOut.m_msg.assign(_T("type disallowed"));
+	// object keys iterate in sorted order, so the props of a block stay sorted
+	PropVec props;
+	MojObject::ConstIterator end = obj.end();
+	for (MojObject::ConstIterator i = obj.begin(); i != end; ++i) {
+		Prop prop;
+		MojErr err = compile(*i, prop.m_block);
+		MojErrCheck(err);
+		prop.m_name = i.key();
+		err = props.push(prop);
+		MojErrCheck(err);
+		err = m_schema->m_strings.put(i.key());
 		MojErrCheck(err);
 	}
+	op.m_begin = (MojUInt32) m_props.size();
+	op.m_count = (MojUInt32) props.size();
+	MojErr err = m_props.append(props.begin(), props.end());
+	MojErrCheck(err);
+
 	return MojErrNone;
 }
 
-MojErr MojSchema::UnionDisallowRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
+MojErr MojSchema::Program::compileEnum(const MojObject& obj, Op& op)
 {
-	Result typeRes;
-	typeRes.valid(true);
-	MojErr err = UnionTypeRule::validate(val, parent, typeRes);
-	MojErrCheck(err);
-	if (typeRes.valid()) {
-		resOut.valid(false);
-		err = resOut.m_msg.assign(_T("type disallowed"));
+	ObjectSet vals;
+	MojObject::ConstArrayIterator end = obj.arrayEnd();
+	for (MojObject::ConstArrayIterator i = obj.arrayBegin(); i != end; ++i) {
+		MojErr err = vals.put(*i);
 		MojErrCheck(err);
+		if (i->type() == MojObject::TypeString) {
+			MojString str;
+			err = i->stringValue(str);
+			MojErrCheck(err);
+			err = m_schema->m_strings.put(str);
+			MojErrCheck(err);
+		}
 	}
+	op.m_begin = (MojUInt32) m_enums.size();
+	MojErr err = m_enums.push(vals);
+	MojErrCheck(err);
+
 	return MojErrNone;
 }
 
-MojSchema::AdditionalPropertiesRule::AdditionalPropertiesRule(MojSchema* schema)
-: Rule(schema),
-  m_allowAdditional(true)
+MojErr MojSchema::Program::validate(MojUInt32 blockIdx, const MojObject& val, const MojObject& parent, Result& resOut) const
 {
+	MojErr err = MojErrNone;
+	const Block& block = m_blocks.at(blockIdx);
+	OpVec::ConstIterator end = m_ops.begin() + block.m_end;
+	for (OpVec::ConstIterator op = m_ops.begin() + block.m_begin; op != end; ++op) {
+		MojObject::Type type = val.type();
+		switch (op->m_code) {
+		case OpType:
+			if (!(op->m_int & ((MojInt64) 1 << type))) {
+				resOut.valid(false);
+				err = resOut.m_msg.assign(_T("invalid type"));
+				MojErrCheck(err);
+			}
+			break;
+		case OpDisallowType:
+			if (op->m_int & ((MojInt64) 1 << type)) {
+				resOut.valid(false);
+				err = resOut.m_msg.assign(_T("type disallowed"));
+				MojErrCheck(err);
+			}
+			break;
+		case OpUnion:
+			err = validateUnion(*op, val, parent, resOut);
+			MojErrCheck(err);
+			break;
+		case OpDisallowUnion: {
+			Result typeRes;
+			typeRes.valid(true);
+			err = validateUnion(*op, val, parent, typeRes);
+			MojErrCheck(err);
+			if (typeRes.valid()) {
+				resOut.valid(false);
+				err = resOut.m_msg.assign(_T("type disallowed"));
+				MojErrCheck(err);
+			}
+			break;
+		}
+		case OpProperties:
+			err = validateProperties(*op, val, resOut);
+			MojErrCheck(err);
+			break;
+		case OpItems: {
+			MojObject::ConstArrayIterator itemsEnd = val.arrayEnd();
+			for (MojObject::ConstArrayIterator i = val.arrayBegin(); i != itemsEnd; ++i) {
+				err = validate(op->m_block, *i, val, resOut);
+				MojErrCheck(err);
+				if (!resOut.valid())
+					break;
+			}
+			break;
+		}
+		case OpTuple:
+			err = validateTuple(*op, val, resOut);
+			MojErrCheck(err);
+			break;
+		case OpPattern:
+			err = m_patterns.at(op->m_begin)->validate(val, resOut);
+			MojErrCheck(err);
+			break;
+		case OpRequires: {
+			const MojString& name = m_names.at(op->m_begin);
+			if (!parent.contains(name)) {
+				resOut.valid(false);
+				err = resOut.m_msg.format(_T("required prop not found - '%s'"), name.data());
+				MojErrCheck(err);
+			}
+			break;
+		}
+		case OpMinimum:
+		case OpMaximum:
+			if (type == MojObject::TypeInt || type == MojObject::TypeDecimal) {
+				MojDecimal decVal = val.decimalValue();
+				bool valid = false;
+				if (op->m_code == OpMinimum) {
+					valid = op->m_canEqual ? decVal >= op->m_dec : decVal > op->m_dec;
+				} else {
+					valid = op->m_canEqual ? decVal <= op->m_dec : decVal < op->m_dec;
+				}
+				if (!valid) {
+					resOut.valid(false);
+					err = resOut.m_msg.assign(_T("value out of range"));
+					MojErrCheck(err);
+				}
+			}
+			break;
+		case OpMinItems:
+		case OpMaxItems:
+			if (type == MojObject::TypeArray) {
+				MojInt64 size = (MojInt64) val.size();
+				if (op->m_code == OpMinItems ? size < op->m_int : size > op->m_int) {
+					resOut.valid(false);
+					err = resOut.m_msg.assign(_T("array length out of range"));
+					MojErrCheck(err);
+				}
+			}
+			break;
+		case OpUniqueItems:
+			if (type == MojObject::TypeArray) {
+				MojObject::ConstArrayIterator itemsEnd = val.arrayEnd();
+				for (MojObject::ConstArrayIterator i = val.arrayBegin(); i != itemsEnd && resOut.valid(); ++i) {
+					for (MojObject::ConstArrayIterator j = i + 1; j != itemsEnd; ++j) {
+						if (*i == *j) {
+							resOut.valid(false);
+							err = resOut.m_msg.assign(_T("duplicate items"));
+							MojErrCheck(err);
+							break;
+						}
+					}
+				}
+			}
+			break;
+		case OpMinLength:
+		case OpMaxLength:
+			if (type == MojObject::TypeString) {
+				MojString str;
+				err = val.stringValue(str);
+				MojErrCheck(err);
+				MojInt64 len = (MojInt64) str.length();
+				if (op->m_code == OpMinLength ? len < op->m_int : len > op->m_int) {
+					resOut.valid(false);
+					err = resOut.m_msg.assign(_T("string length out of range"));
+					MojErrCheck(err);
+				}
+			}
+			break;
+		case OpEnum:
+			if (!m_enums.at(op->m_begin).contains(val)) {
+				resOut.valid(false);
+				err = resOut.m_msg.assign(_T("invalid enum value"));
+				MojErrCheck(err);
+			}
+			break;
+		case OpDivisibleBy:
+			if (type != MojObject::TypeInt && type != MojObject::TypeDecimal)
+				break;
+			if (op->m_int == 0 ||
+				(val.intValue() % op->m_int) != 0 ||
+				(type == MojObject::TypeDecimal && val.decimalValue().fraction() != 0)) {
+				resOut.valid(false);
+				err = resOut.m_msg.format(_T("value not divisible by %lld"), op->m_int);
+				MojErrCheck(err);
+			}
+			break;
+		}
+		if (!resOut.valid())
+			break;
+	}
+	return MojErrNone;
 }
 
-MojErr MojSchema::AdditionalPropertiesRule::fromObject(const MojObject& obj)
+MojErr MojSchema::Program::validateUnion(const Op& op, const MojObject& val, const MojObject& parent, Result& resOut) const
 {
-	if (obj.type() == MojObject::TypeBool) {
-		m_allowAdditional = obj.boolValue();
-	} else {
-		m_schemaRule.reset(new SchemaRule(m_schema));
-		MojAllocCheck(m_schemaRule.get());
-		MojErr err = m_schemaRule->fromObject(obj);
+	IndexVec::ConstIterator end = m_children.begin() + op.m_begin + op.m_count;
+	for (IndexVec::ConstIterator i = m_children.begin() + op.m_begin; i != end; ++i) {
+		resOut.valid(true);
+		MojErr err = validate(*i, val, parent, resOut);
 		MojErrCheck(err);
+		if (resOut.valid())
+			return MojErrNone;
 	}
+	resOut.valid(false);
+
 	return MojErrNone;
 }
 
-MojErr MojSchema::AdditionalPropertiesRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
+MojErr MojSchema::Program::validateAdditional(const Op& op, const MojObject& val, const MojObject& parent, Result& resOut) const
 {
-	if (!m_allowAdditional) {
+	if (!op.m_allow) {
 		// additionalProps not allowed - fail
 		resOut.valid(false);
 		MojErr err = resOut.m_msg.assign(_T("property not allowed"));
 		MojErrCheck(err);
-	} else if (m_schemaRule.get()) {
+	} else if (op.m_block != NoBlock) {
 		// validate against additional props schema
-		MojErr err = m_schemaRule->validate(val, parent, resOut);
+		MojErr err = validate(op.m_block, val, parent, resOut);
 		MojErrCheck(err);
 	}
 	return MojErrNone;
 }
 
-MojErr MojSchema::PropertiesRule::fromObject(const MojObject& obj)
-{
-	MojObject::ConstIterator end = obj.end();
-	for (MojObject::ConstIterator i = obj.begin(); i != end; ++i) {
-		MojRefCountedPtr<SchemaRule> rule(new SchemaRule(m_schema));
-		MojAllocCheck(rule.get());
-		MojErr err = rule->fromObject(*i);
-		MojErrCheck(err);
-		err = m_props.put(i.key(), rule);
-		MojErrCheck(err);
-		err = m_schema->m_strings.put(i.key());
-		MojErrCheck(err);
-	}
-	return MojErrNone;
-}
-
-MojErr MojSchema::PropertiesRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
+MojErr MojSchema::Program::validateProperties(const Op& op, const MojObject& val, Result& resOut) const
 {
 	MojErr err = MojErrNone;
-	PropMap::ConstIterator iter = m_props.begin();
-	PropMap::ConstIterator end = m_props.end();
+	PropVec::ConstIterator iter = m_props.begin() + op.m_begin;
+	PropVec::ConstIterator end = iter + op.m_count;
 	MojObject::ConstIterator valIter = val.begin();
 	MojObject::ConstIterator valEnd = val.end();
 
@@ -445,36 +639,34 @@ MojErr MojSchema::PropertiesRule::validate(const MojObject& val, const MojObject
 		} else if (valIter == valEnd) {
 			comp = -1;
 		} else {
-			comp = iter.key().compare(valIter.key());
+			comp = iter->m_name.compare(valIter.key());
 		}
 
 		if (comp > 0) {
 			// prop in val and not schema
-			if (m_additionalRule.get()) {
-				err = m_additionalRule->validate(*valIter, val, resOut);
+			err = validateAdditional(op, *valIter, val, resOut);
+			MojErrCheck(err);
+			if (!resOut.valid()) {
+				err = resOut.m_msg.appendFormat(_T(" - '%s'"), valIter.key().data());
 				MojErrCheck(err);
-				if (!resOut.valid()) {
-					err = resOut.m_msg.appendFormat(_T(" - '%s'"), valIter.key().data());
-					MojErrCheck(err);
-					break;
-				}
+				break;
 			}
 			++valIter;
 		} else if (comp < 0) {
 			// prop in schema and not val
-			if (!(*iter)->optional()) {
+			if (!m_blocks.at(iter->m_block).m_optional) {
 				resOut.valid(false);
-				err = resOut.m_msg.format(_T("required property not found - '%s'"), iter.key().data());
+				err = resOut.m_msg.format(_T("required property not found - '%s'"), iter->m_name.data());
 				MojErrCheck(err);
 				break;
 			}
 			++iter;
 		} else {
 			// prop in both val and schema
-			err = (*iter)->validate(*valIter, val, resOut);
+			err = validate(iter->m_block, *valIter, val, resOut);
 			MojErrCheck(err);
 			if (!resOut.valid()) {
-				err = resOut.m_msg.appendFormat(_T(" for property '%s'"), iter.key().data());
+				err = resOut.m_msg.appendFormat(_T(" for property '%s'"), iter->m_name.data());
 				MojErrCheck(err);
 				break;
 			}
@@ -485,41 +677,19 @@ MojErr MojSchema::PropertiesRule::validate(const MojObject& val, const MojObject
 	return MojErrNone;
 }
 
-MojErr MojSchema::SimpleItemsRule::fromObject(const MojObject& obj)
-{
-	m_schemaRule.reset(new SchemaRule(m_schema));
-	MojAllocCheck(m_schemaRule.get());
-	MojErr err = m_schemaRule->fromObject(obj);
-	MojErrCheck(err);
-
-	return MojErrNone;
-}
-
-MojErr MojSchema::SimpleItemsRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
-{
-	MojObject::ConstArrayIterator end = val.arrayEnd();
-	for (MojObject::ConstArrayIterator i = val.arrayBegin(); i != end; ++i) {
-		MojErr err = m_schemaRule->validate(*i, val, resOut);
-		MojErrCheck(err);
-		if (!resOut.valid())
-			break;
-	}
-	return MojErrNone;
-}
-
-MojErr MojSchema::TupleItemsRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
+MojErr MojSchema::Program::validateTuple(const Op& op, const MojObject& val, Result& resOut) const
 {
 	if (val.type() != MojObject::TypeArray)
 		return MojErrNone;
 
 	MojErr err = MojErrNone;
-	RuleVec::ConstIterator iter = m_rules.begin();
-	RuleVec::ConstIterator end = m_rules.end();
+	IndexVec::ConstIterator iter = m_children.begin() + op.m_begin;
+	IndexVec::ConstIterator end = iter + op.m_count;
 	MojObject::ConstArrayIterator valIter = val.arrayBegin();
 	MojObject::ConstArrayIterator valEnd = val.arrayEnd();
 	// validate properties in tuple
 	while (iter != end && valIter != valEnd) {
-		err = (*iter)->validate(*valIter, val, resOut);
+		err = validate(*iter, *valIter, val, resOut);
 		MojErrCheck(err);
 		if (!resOut.valid())
 			return MojErrNone;
@@ -532,187 +702,12 @@ MojErr MojSchema::TupleItemsRule::validate(const MojObject& val, const MojObject
 		MojErrCheck(err);
 	}
 	// validate additional properties
-	if (m_additionalRule.get()) {
-		while (valIter != valEnd) {
-			err = m_additionalRule->validate(*valIter, val, resOut);
-			MojErrCheck(err);
-			if (!resOut.valid())
-				break;
-			++valIter;
-		}
-	}
-	return MojErrNone;
-}
-
-MojErr MojSchema::RequiresRule::fromObject(const MojObject& obj)
-{
-	MojErr err = obj.stringValue(m_requiredProp);
-	MojErrCheck(err);
-
-	return MojErrNone;
-}
-
-MojErr MojSchema::RequiresRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
-{
-	if (!parent.contains(m_requiredProp)) {
-		resOut.valid(false);
-		MojErr err = resOut.m_msg.format(_T("required prop not found - '%s'"), m_requiredProp.data());
-		MojErrCheck(err);
-	}
-	return MojErrNone;
-}
-
-template<class COMP1, class COMP2>
-MojSchema::CompRule<COMP1, COMP2>::CompRule(MojSchema* schema)
-: Rule(schema),
-  m_canEqual(true)
-{
-}
-
-template<class COMP1, class COMP2>
-MojErr MojSchema::CompRule<COMP1, COMP2>::fromObject(const MojObject& obj)
-{
-	m_val = obj.decimalValue();
-
-	return MojErrNone;
-}
-
-template<class COMP1, class COMP2>
-MojErr MojSchema::CompRule<COMP1, COMP2>::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
-{
-	MojObject::Type type = val.type();
-	if (type == MojObject::TypeInt || type == MojObject::TypeDecimal) {
-		MojDecimal decVal = val.decimalValue();
-		bool valid = false;
-		if (m_canEqual) {
-			valid = COMP1()(decVal, m_val);
-		} else {
-			valid = COMP2()(decVal, m_val);
-		}
-		if (!valid) {
-			resOut.valid(valid);
-			MojErr err = resOut.m_msg.assign(_T("value out of range"));
-			MojErrCheck(err);
-		}
-	}
-	return MojErrNone;
-}
-
-template<class COMP>
-MojErr MojSchema::ArrayLenRule<COMP>::fromObject(const MojObject& obj)
-{
-	m_val = obj.intValue();
-
-	return MojErrNone;
-}
-
-template<class COMP>
-MojErr MojSchema::ArrayLenRule<COMP>::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
-{
-	if (val.type() == MojObject::TypeArray && !COMP()(val.size(), m_val)) {
-		resOut.valid(false);
-		MojErr err = resOut.m_msg.assign(_T("array length out of range"));
-		MojErrCheck(err);
-	}
-	return MojErrNone;
-}
-
-MojErr MojSchema::UniqueItemsRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
-{
-	if (val.type() != MojObject::TypeArray)
-		return MojErrNone;
-
-	MojObject::ConstArrayIterator end = val.arrayEnd();
-	for (MojObject::ConstArrayIterator i = val.arrayBegin(); i != end; ++i) {
-		for (MojObject::ConstArrayIterator j = i + 1; j != end; ++j) {
-			if (*i == *j) {
-				resOut.valid(false);
-				MojErr err = resOut.m_msg.assign(_T("duplicate items"));
-				MojErrCheck(err);
-				break;
-			}
-		}
-	}
-	return MojErrNone;
-}
-
-template<class COMP>
-MojErr MojSchema::StringLenRule<COMP>::fromObject(const MojObject& obj)
-{
-	m_val = obj.intValue();
-
-	return MojErrNone;
-}
-
-template<class COMP>
-MojErr MojSchema::StringLenRule<COMP>::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
-{
-	if (val.type() == MojObject::TypeString) {
-		MojString str;
-		MojErr err = val.stringValue(str);
-		MojErrCheck(err);
-		MojInt64 len = (MojInt64) str.length();
-		if (!COMP()(len, m_val)) {
-			resOut.valid(false);
-			MojErr err = resOut.m_msg.assign(_T("string length out of range"));
-			MojErrCheck(err);
-		}
-	}
-	return MojErrNone;
-}
-
-MojSchema::EnumRule::EnumRule(MojSchema* schema)
-: Rule(schema)
-{
-	MojAssert(schema);
-}
-
-MojErr MojSchema::EnumRule::fromObject(const MojObject& obj)
-{
-	MojObject::ConstArrayIterator end = obj.arrayEnd();
-	for (MojObject::ConstArrayIterator i = obj.arrayBegin(); i != end; ++i) {
-		MojErr err = m_vals.put(*i);
-		MojErrCheck(err);
-		if (i->type() == MojObject::TypeString) {
-			MojString str;
-			err = i->stringValue(str);
-			MojErrCheck(err);
-			err = m_schema->m_strings.put(str);
-			MojErrCheck(err);
-		}
-	}
-	return MojErrNone;
-}
-
-MojErr MojSchema::EnumRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
-{
-	if (!m_vals.contains(val)) {
-		resOut.valid(false);
-		MojErr err = resOut.m_msg.assign(_T("invalid enum value"));
-		MojErrCheck(err);
-	}
-	return MojErrNone;
-}
-
-MojErr MojSchema::DivisibleRule::fromObject(const MojObject& obj)
-{
-	m_val = obj.intValue();
-
-	return MojErrNone;
-}
-
-MojErr MojSchema::DivisibleRule::validate(const MojObject& val, const MojObject& parent, Result& resOut) const
-{
-	MojObject::Type type = val.type();
-	if (type != MojObject::TypeInt && type != MojObject::TypeDecimal)
-		return MojErrNone;
-
-	if (m_val == 0 ||
-		(val.intValue() % m_val) != 0 ||
-		(type == MojObject::TypeDecimal && val.decimalValue().fraction() != 0)) {
-		resOut.valid(false);
-		MojErr err = resOut.m_msg.format(_T("value not divisible by %lld"), m_val);
+	while (valIter != valEnd) {
+		err = validateAdditional(op, *valIter, val, resOut);
 		MojErrCheck(err);
+		if (!resOut.valid())
+			break;
+		++valIter;
 	}
 	return MojErrNone;
 }
@@ -136,6 +136,7 @@ MojErr MojService::handleMessage(DispatchMethod method, MojServiceMessage* msg)
 {
 	if (m_dispatcher) {
 		msg->dispatchMethod(method);
+		msg->priority(m_dispatcher->priority(msg->method()));
 		MojErr err = m_dispatcher->schedule(msg);
 		MojErrCheck(err);
 	} else {
@@ -17,3 +17,114 @@
 
 #include "core/MojThread.h"
 
+
+MojThreadEpochLock::MojThreadEpochLock()
+: m_state(StateFree),
+  m_writer(MojInvalidThreadId)
+{
+	for (MojSize i = 0; i < NumSlots; ++i)
+		m_slots[i].m_readers.store(0);
+}
+
+MojThreadEpochLock::~MojThreadEpochLock()
+{
+	MojAssert(readers() == 0 && m_state.load() == StateFree);
+}
+
+void MojThreadEpochLock::readLock()
+{
+	std::atomic<MojInt32>& readers = m_slots[slotIndex()].m_readers;
+	for (;;) {
+		// the count is published before the state is checked, a writer checks
+		// them the other way round, so one of the two always sees the other
+		readers.fetch_add(1);
+		if (m_state.load() != StateHeld)
+			break;
+		leave(readers);
+
+		MojThreadGuard guard(m_mutex);
+		while (m_state.load() == StateHeld) {
+			MojErr err = m_cond.wait(m_mutex);
+			MojAssert(err == MojErrNone);
+			MojUnused(err);
+		}
+	}
+}
+
+void MojThreadEpochLock::writeLock()
+{
+	m_writeMutex.lock();
+	MojThreadGuard guard(m_mutex);
+	m_state.store(StatePending);
+	for (;;) {
+		if (readers() == 0) {
+			m_state.store(StateHeld);
+			// a reader that counted itself in just before the state changed is still in
+			if (readers() == 0)
+				break;
+			m_state.store(StatePending);
+			MojErr err = m_cond.broadcast();
+			MojAssert(err == MojErrNone);
+			MojUnused(err);
+		}
+		// readers leaving while a writer waits signal under m_mutex, so a count
+		// that drops after the check above still wakes us
+		MojErr err = m_writerCond.wait(m_mutex);
+		MojAssert(err == MojErrNone);
+		MojUnused(err);
+	}
+	m_writer = MojThreadCurrentId();
+}
+
+void MojThreadEpochLock::unlock()
+{
+	// readers never see a writer id of their own thread, the writer has no reader count in
+	if (m_writer == MojThreadCurrentId()) {
+		m_writer = MojInvalidThreadId;
+		setState(StateFree);
+		m_writeMutex.unlock();
+	} else {
+		leave(m_slots[slotIndex()].m_readers);
+	}
+}
+
+void MojThreadEpochLock::leave(std::atomic<MojInt32>& readers)
+{
+	// same ordering as in readLock: either this sees the writer, or the writer sees the count drop
+	readers.fetch_sub(1);
+	if (m_state.load() == StateFree)
+		return;
+	MojThreadGuard guard(m_mutex);
+	MojErr err = m_writerCond.signal();
+	MojAssert(err == MojErrNone);
+	MojUnused(err);
+}
+
+MojSize MojThreadEpochLock::slotIndex()
+{
+	// threads take slots round robin on first use and keep them for every lock
+	static std::atomic<MojUInt32> s_nextSlot(0);
+	static thread_local MojSize s_slot = s_nextSlot.fetch_add(1) % NumSlots;
+	return s_slot;
+}
+
+MojInt64 MojThreadEpochLock::readers() const
+{
+	// a read lock released on another thread than it was taken on leaves one
+	// slot above and one below zero, only the sum is meaningful
+	MojInt64 count = 0;
+	for (MojSize i = 0; i < NumSlots; ++i)
+		count += m_slots[i].m_readers.load();
+	return count;
+}
+
+void MojThreadEpochLock::setState(State state)
+{
+	MojThreadGuard guard(m_mutex);
+	m_state.store(state);
+	if (state != StateHeld) {
+		MojErr err = m_cond.broadcast();
+		MojAssert(err == MojErrNone);
+		MojUnused(err);
+	}
+}
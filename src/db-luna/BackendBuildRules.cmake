@@ -108,6 +108,7 @@ foreach (backend ${WEBOS_DB8_BACKEND})
 			src/engine/sandwich/MojDbSandwichIndex.cpp
 			src/engine/sandwich/MojDbSandwichItem.cpp
                         src/engine/sandwich/MojDbSandwichLazyUpdater.cpp
+                        src/engine/sandwich/MojDbSandwichGroupCommit.cpp
 		)
 
 		set (DB_BACKEND_WRAPPER_CFLAGS "${DB_BACKEND_WRAPPER_CFLAGS} -DMOJ_USE_SANDWICH")
@@ -25,6 +25,37 @@
 
 const MojChar* const MojDbLunaServiceApp::VersionString = MOJ_VERSION_STRING;
 
+// dispatcher classes for methods that aren't plain writes
+static const struct {
+    const MojChar* const* m_method;
+    MojMessage::Priority m_priority;
+} s_methodPriorities[] = {
+    {&MojDbServiceDefs::GetMethod, MojMessage::PriorityRead},
+    {&MojDbServiceDefs::FindMethod, MojMessage::PriorityRead},
+    {&MojDbServiceDefs::SearchMethod, MojMessage::PriorityRead},
+    {&MojDbServiceDefs::WatchMethod, MojMessage::PriorityRead},
+    {&MojDbServiceDefs::GetPermissionsMethod, MojMessage::PriorityRead},
+    {&MojDbServiceDefs::GetProfileMethod, MojMessage::PriorityRead},
+    {&MojDbServiceDefs::PurgeStatusMethod, MojMessage::PriorityRead},
+    {&MojDbServiceDefs::ListActiveMediaMethod, MojMessage::PriorityRead},
+    {&MojDbServiceDefs::ShardInfoMethod, MojMessage::PriorityRead},
+    {&MojDbServiceDefs::CompactMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::PurgeMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::ScheduledPurgeMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::DumpMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::LoadMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::StatsMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::QuotaStatsMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::SpaceCheckMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::ScheduledSpaceCheckMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::PreBackupMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::PostBackupMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::PreRestoreMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::PostRestoreMethod, MojMessage::PriorityAdmin},
+    {&MojDbServiceDefs::RemoveAppDataMethod, MojMessage::PriorityAdmin},
+    {NULL, MojMessage::PriorityWrite}
+};
+
 int main(int argc, char** argv)
 {
    MojAutoPtr<MojDbLunaServiceApp> app(new MojDbLunaServiceApp);
@@ -57,6 +88,11 @@ MojErr MojDbLunaServiceApp::init()
     MojDbStorageEngine::createEnv(m_env);
     MojAllocCheck(m_env.get());
 
+    for (int i = 0; s_methodPriorities[i].m_method != NULL; ++i) {
+        err = m_dispatcher.classify(*s_methodPriorities[i].m_method, s_methodPriorities[i].m_priority);
+        MojErrCheck(err);
+    }
+
     m_internalHandler.reset(new MojDbServiceHandlerInternal(m_mainService.db(), m_reactor, m_mainService.service()));
     MojAllocCheck(m_internalHandler.get());
 
@@ -100,6 +136,13 @@ MojErr MojDbLunaServiceApp::configure(const MojObject& conf)
     err = m_mainService.configure(dbConf);
     MojErrCheck(err);
 
+    // thread count, class weights and admin thread cap
+    MojObject dispatcherConf;
+    if (dbConf.get(_T("dispatcher"), dispatcherConf)) {
+        err = m_dispatcher.configure(dispatcherConf);
+        MojErrCheck(err);
+    }
+
 #ifdef WANT_DYNAMIC
     MojUInt32 idleTimeOut = 0;
     bool found = false;
@@ -122,7 +165,7 @@ MojErr MojDbLunaServiceApp::open()
 	MojErrCheck(err);
 
 	// start message queue thread pool
-	err = m_dispatcher.start(NumThreads);
+	err = m_dispatcher.start();
 	MojErrCheck(err);
 
 	// open db env
@@ -23,6 +23,7 @@
 #include "db/MojDbReq.h"
 #include "db/MojDbServiceDefs.h"
 #include "db/MojDbObjectHeader.h"
+#include "db/MojDbTextCollator.h"
 #include "core/MojJson.h"
 #include "core/MojObject.h"
 #include "core/MojObjectBuilder.h"
@@ -80,6 +81,11 @@ MojDb::MojDb()
         }
         DefaultLocaleAlreadyInited = true;
     }
+#ifdef WITH_SEARCH_QUERY_CACHE
+    // one cache shared by all kinds, so the memory budget is global
+    m_searchCache.reset(new MojDbSearchCache);
+    shardStatusChanged.connect(m_searchCache->shardStatusChanged);
+#endif
 }
 
 MojDb::~MojDb()
@@ -92,7 +98,7 @@ MojErr MojDb::configure(const MojObject& conf)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojThreadWriteGuard guard(m_schemaLock);
+	MojThreadEpochWriteGuard guard(m_schemaLock);
 
 	MojErr err = requireNotOpen();
 	MojErrCheck(err);
@@ -129,6 +135,16 @@ MojErr MojDb::configure(const MojObject& conf)
 
 		err = m_profileEngine.configure(dbConf);
 		MojErrCheck(err);
+		err = m_indexBuilder.configure(dbConf);
+		MojErrCheck(err);
+		err = m_queryExecutor.configure(dbConf);
+		MojErrCheck(err);
+		err = MojDbTextCollator::keyCache().configure(dbConf);
+		MojErrCheck(err);
+#ifdef WITH_SEARCH_QUERY_CACHE
+		err = m_searchCache->configure(dbConf);
+		MojErrCheck(err);
+#endif
 #ifdef LMDB_ENGINE_SUPPORT
 		MojObject engineConf;
 		found = conf.get(m_engineName, engineConf);
@@ -161,6 +177,8 @@ MojErr MojDb::drop(const MojChar* path)
 	MojErrCheck(err);
 	err = req.end();
 	MojErrCheck(err);
+	// the kinds are gone with the data
+	m_catalogDir.clear();
 	err = close();
 	MojErrCheck(err);
 
@@ -220,9 +238,15 @@ MojErr MojDb::open(const MojChar* path, MojDbStorageEngine* engine)
 	MojErrCheck(err);
 	MojAssert(m_idSeq.get());
 
+	// index builds interrupted by close are queued again while kinds open
+	err = m_indexBuilder.open(this);
+	MojErrCheck(err);
+	err = m_queryExecutor.open();
+	MojErrCheck(err);
+
 	// kinds
     LOG_DEBUG("[db_mojodb] Open Kind Engine");
-	err = m_kindEngine.open(this, req);
+	err = m_kindEngine.open(this, req, engine ? NULL : path);
     LOG_DEBUG("[db_mojodb] Kind Opened...");
 	MojErrCheck(err);
 
@@ -252,6 +276,12 @@ MojErr MojDb::open(const MojChar* path, MojDbStorageEngine* engine)
     err = m_idGenerator.init();
     MojErrCheck(err);
 
+	// a shared engine may be written to by other dbs, only our own gets a catalog
+	if (engine == NULL) {
+		err = m_catalogDir.assign(path);
+		MojErrCheck(err);
+	}
+
 	closer.release();
 
     LOG_DEBUG("[db_mojodb] open completed");
@@ -262,10 +292,15 @@ MojErr MojDb::open(const MojChar* path, MojDbStorageEngine* engine)
 MojErr MojDb::close()
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
-	MojThreadWriteGuard guard(m_schemaLock);
 
+	// stop the builder before taking the schema lock its chunks wait on
 	MojErr err = MojErrNone;
-	MojErr errClose = MojErrNone;
+	MojErr errClose = m_indexBuilder.close();
+	MojErrAccumulate(err, errClose);
+	errClose = m_queryExecutor.close();
+	MojErrAccumulate(err, errClose);
+
+	MojThreadEpochWriteGuard guard(m_schemaLock);
 
 	if (m_isOpen) {
         LOG_DEBUG("[db_mojodb] closing...");
@@ -273,6 +308,14 @@ MojErr MojDb::close()
 		MojErrAccumulate(err, errClose);
 		errClose = m_permissionEngine.close();
 		MojErrAccumulate(err, errClose);
+		if (!m_catalogDir.empty()) {
+			// the catalog only speeds up the next open, failing to write it is not an error
+			errClose = m_kindEngine.saveCatalog(m_catalogDir);
+			MojErrCatchAll(errClose) {
+				LOG_WARNING(MSGID_MOJ_DB_WARNING, 1, PMLOGKS("path", m_catalogDir.data()), "failed to write kind catalog");
+			}
+			m_catalogDir.clear();
+		}
 		errClose = m_kindEngine.close();
 		MojErrAccumulate(err, errClose);
 		if (m_idSeq.get()) {
@@ -409,19 +452,22 @@ MojErr MojDb::delKind(const MojObject& id, bool& foundOut, MojUInt32 flags, MojD
 	if (item.get())
 	{
 		MojObject deleted;
-		// del objects
-		MojDbQuery query;
-		err = query.from(idStr);
-		MojErrCheck(err);
-		err = query.includeDeleted(true);
-		MojErrCheck(err);
+		// del objects, dropping the kind's index keys in bulk if the engine can
 		MojUInt32 count;
 		req->fixmode(true);
-		err = delImpl(query, count, req, flags | MojDbFlagPurge);
+		err = delKindObjs(idStr, count, req);
+		MojErrCatch(err, MojErrNotImplemented) {
+			MojDbQuery query;
+			err = query.from(idStr);
+			MojErrCheck(err);
+			err = query.includeDeleted(true);
+			MojErrCheck(err);
+			err = delImpl(query, count, req, flags | MojDbFlagPurge);
+		}
 		MojErrCheck(err);
 
 		// del associated permissions
-		query.clear();
+		MojDbQuery query;
 		err = query.from(MojDbKindEngine::PermissionId);
 		MojErrCheck(err);
 		err = query.where(MojDbServiceDefs::ObjectKey, MojDbQuery::OpEq, idStr);
@@ -549,7 +595,9 @@ MojErr MojDb::merge(const MojDbQuery& query, const MojObject& props, MojUInt32&
 		MojErrCheck(err);
 		if (!found)
 			break;
-		err = prevItem->toObject(prev, m_kindEngine);
+		// prev and merged die each round, so the arena recycles its memory
+		prev.clear();
+		err = prevItem->toObject(prev, m_kindEngine, true, &req->arena());
 		MojErrCheck(err);
 		// merge obj into prev
 		MojObject merged;
@@ -1125,6 +1173,198 @@ MojErr MojDb::delImpl(const MojDbQuery& quer, MojUInt32& countOut, MojDbReq& req
 
 
 
+MojErr MojDb::delKindObjs(const MojString& kindId, MojUInt32& countOut, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// Objects are read in _id order, live ones first, then deleted ones. Each batch
+	// takes its contiguous _id key range out with one range delete and the kind's
+	// other indexes are dropped whole, so only super kinds' keys are worked out per
+	// object. MojErrNotImplemented comes back before anything changed, a batch
+	// that can't be served from the _id index once that happened is fatal.
+	countOut = 0;
+	MojDbKind* kind = NULL;
+	MojErr err = m_kindEngine.getKind(kindId.data(), kind);
+	MojErrCheck(err);
+	for (int pass = 0; pass < 2; ++pass) {
+		MojDbQuery query;
+		err = delKindQuery(kindId, pass == 1, MojObject::Undefined, query);
+		MojErrCheck(err);
+		MojDbIndex* index = kind->indexForQuery(query);
+		if (!index || !index->isIdIndex())
+			MojErrThrow(MojErrNotImplemented);
+	}
+
+	bool dropped = false;
+	for (int pass = 0; pass < 2; ++pass) {
+		bool deleted = (pass == 1);
+		MojObject lastId;
+		for (;;) {
+			MojDbQuery query;
+			err = delKindQuery(kindId, deleted, lastId, query);
+			MojErrCheck(err);
+
+			MojVector<MojObject> objs;
+			MojVector<MojSize> sizes;
+			MojDbIndex* idIndex = NULL;
+			err = readBatch(query, objs, sizes, idIndex, req);
+			MojErrCheck(err);
+			if (objs.empty())
+				break;
+			if (!idIndex || !idIndex->isIdIndex()) {
+				if (dropped)
+					MojErrThrowMsg(MojErrDbFatal, _T("db: delKind of %s left the _id index midway"), kindId.data());
+				MojErrThrow(MojErrNotImplemented);
+			}
+
+			err = req.curKind(kind);
+			MojErrCheck(err);
+
+			MojObject firstId;
+			err = objs.begin()->getRequired(IdKey, firstId);
+			MojErrCheck(err);
+			err = objs.back().getRequired(IdKey, lastId);
+			MojErrCheck(err);
+			MojObject lower(MojObject::TypeArray);
+			err = lower.push(deleted);
+			MojErrCheck(err);
+			err = lower.push(firstId);
+			MojErrCheck(err);
+			MojObject upper(MojObject::TypeArray);
+			err = upper.push(deleted);
+			MojErrCheck(err);
+			err = upper.push(lastId);
+			MojErrCheck(err);
+
+			// quota for the range is settled per object in purgeBatch
+			MojSize removed = 0;
+			req.txn()->quotaEnabled(false);
+			err = idIndex->delRange(lower, upper, req.txn(), removed);
+			req.txn()->quotaEnabled(true);
+			MojErrCheck(err);
+
+			if (!dropped) {
+				for (MojDbKind::IndexVec::ConstIterator i = kind->indexes().begin(); i != kind->indexes().end(); ++i) {
+					if (i->get() == idIndex)
+						continue;
+					err = (*i)->drop(req);
+					MojErrCheck(err);
+				}
+				dropped = true;
+			}
+
+			for (MojDbKind::IndexVec::ConstIterator i = kind->indexes().begin(); i != kind->indexes().end(); ++i) {
+				err = req.skipIndex(i->get());
+				MojErrCheck(err);
+			}
+			err = purgeBatch(objs, sizes, idIndex, req);
+			req.clearSkipIndexes();
+			MojErrCheck(err);
+
+			countOut += (MojUInt32) objs.size();
+			if (objs.size() < AutoBatchSize)
+				break;
+		}
+	}
+	return MojErrNone;
+}
+
+MojErr MojDb::delKindQuery(const MojString& kindId, bool deleted, const MojObject& lastId, MojDbQuery& queryOut)
+{
+	queryOut.clear();
+	MojErr err = queryOut.from(kindId);
+	MojErrCheck(err);
+	err = queryOut.where(DelKey, MojDbQuery::OpEq, deleted);
+	MojErrCheck(err);
+	if (!lastId.undefined()) {
+		err = queryOut.where(IdKey, MojDbQuery::OpGreaterThan, lastId);
+		MojErrCheck(err);
+	}
+	queryOut.limit(AutoBatchSize);
+
+	return MojErrNone;
+}
+
+MojErr MojDb::readBatch(const MojDbQuery& query, MojVector<MojObject>& objsOut, MojVector<MojSize>& sizesOut, MojDbIndex*& indexOut, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// the whole batch is read before anything is deleted, so the cursor never
+	// walks keys that are being removed under it
+	objsOut.clear();
+	sizesOut.clear();
+	MojDbCursor cursor;
+	MojErr err = findImpl(query, cursor, NULL, req, OpDelete);
+	MojErrCheck(err);
+	indexOut = cursor.dbIndex();
+
+	MojInt32 warns = 0;
+	for (;;) {
+		MojDbStorageItem* item = NULL;
+		bool found = false;
+		err = cursor.get(item, found);
+		// ghost keys are skipped, a range delete takes them out along with the batch
+		if (err == MojErrInternalIndexOnFind) {
+			warns++;
+			continue;
+		}
+		MojErrCheck(err);
+		if (!found)
+			break;
+		MojObject obj;
+		err = item->toObject(obj, m_kindEngine);
+		MojErrCheck(err);
+		err = objsOut.push(obj);
+		MojErrCheck(err);
+		err = sizesOut.push(item->size());
+		MojErrCheck(err);
+	}
+	if (warns > 0)
+		LOG_DEBUG("[db_mojodb] readBatch index_warnings: %s, count: %d\n", query.from().data(), warns);
+
+	err = cursor.close();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDb::purgeBatch(const MojVector<MojObject>& objs, const MojVector<MojSize>& sizes, const MojDbIndex* rangeIndex, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(objs.size() == sizes.size());
+
+	// same as the purge branch of delObj, except that indexes in req's skip list are
+	// left alone. Keys of rangeIndex were removed with quota off, so each object's
+	// share is charged to its own kind here.
+	MojTokenSet tokenSet;
+	for (MojSize i = 0; i < objs.size(); ++i) {
+		const MojObject& obj = objs.at(i);
+		MojObject id;
+		MojErr err = obj.getRequired(IdKey, id);
+		MojErrCheck(err);
+		MojDbShardId shardId;
+		err = MojDbIdGenerator::extractShard(id, shardId);
+		MojErrCheck(err);
+
+		err = m_kindEngine.update(NULL, &obj, req, OpDelete, tokenSet);
+		MojErrCheck(err);
+		bool found = false;
+		err = m_objDb->del(shardId, id, req.txn(), found);
+		MojErrCheck(err);
+		if (!found)
+			MojErrThrow(MojErrDbCorruptDatabase);
+
+		MojSize keySize = 0;
+		if (rangeIndex) {
+			err = rangeIndex->keySize(obj, keySize);
+			MojErrCheck(err);
+		}
+		err = req.txn()->offsetQuota(-(MojInt64) (sizes.at(i) + keySize));
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
 MojErr MojDb::findImpl(const MojDbQuery& query, MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req, MojDbOp op)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
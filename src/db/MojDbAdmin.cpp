@@ -21,6 +21,78 @@
 #include "core/MojJson.h"
 #include "core/MojTime.h"
 #include "core/MojObjectBuilder.h"
+#include <vector>
+
+// dumps the objects of a range of kinds, each executor slot counts on its own
+class MojDb::DumpJob : public MojDbQueryExecutor::Job
+{
+public:
+	DumpJob(MojDb& db, MojDbDumpWriter& writer, const MojVector<MojString>& kinds, bool incDel, MojDbReq& req)
+	: m_db(db), m_writer(writer), m_kinds(kinds), m_incDel(incDel), m_req(req),
+	  m_counts(db.queryExecutor()->slots(), 0), m_warns(db.queryExecutor()->slots(), 0) {}
+
+	virtual MojErr run(MojSize begin, MojSize end, MojSize slot)
+	{
+		for (MojSize i = begin; i < end; ++i) {
+			MojErr err = m_db.dumpKindObjs(m_writer, m_kinds[i], false, m_counts[slot], m_warns[slot], m_req);
+			MojErrCheck(err);
+			if (m_incDel) {
+				err = m_db.dumpKindObjs(m_writer, m_kinds[i], true, m_counts[slot], m_warns[slot], m_req);
+				MojErrCheck(err);
+			}
+		}
+		return MojErrNone;
+	}
+
+	MojUInt32 count() const
+	{
+		MojUInt32 count = 0;
+		for (std::vector<MojUInt32>::const_iterator i = m_counts.begin(); i != m_counts.end(); ++i)
+			count += *i;
+		return count;
+	}
+
+	MojSize warns() const
+	{
+		MojSize warns = 0;
+		for (std::vector<MojSize>::const_iterator i = m_warns.begin(); i != m_warns.end(); ++i)
+			warns += *i;
+		return warns;
+	}
+
+private:
+	MojDb& m_db;
+	MojDbDumpWriter& m_writer;
+	const MojVector<MojString>& m_kinds;
+	bool m_incDel;
+	MojDbReq& m_req;
+	std::vector<MojUInt32> m_counts;
+	std::vector<MojSize> m_warns;
+};
+
+// decompresses and parses the blocks of a binary dump, one result vector per block
+class MojDb::DecodeJob : public MojDbQueryExecutor::Job
+{
+public:
+	typedef std::vector<MojDbDumpFile::Block> BlockVec;
+	typedef std::vector<MojDbDumpFile::ObjectVec> ObjectSlots;
+
+	DecodeJob(const BlockVec& blocks, ObjectSlots& objs)
+	: m_blocks(blocks), m_objs(objs) {}
+
+	virtual MojErr run(MojSize begin, MojSize end, MojSize)
+	{
+		for (MojSize i = begin; i < end; ++i) {
+			MojErr err = m_blocks[i].decode(m_objs[i]);
+			MojErrCheck(err);
+		}
+		return MojErrNone;
+	}
+
+private:
+	const BlockVec& m_blocks;
+	ObjectSlots& m_objs;
+};
 
 MojErr MojDb::stats(MojObject& objOut, MojDbReqRef req, bool verify, MojString *pKind)
 {
@@ -256,23 +328,8 @@ MojErr MojDb::dump(const MojChar* path, MojUInt32& countOut, bool incDel, MojDbR
 		(void) incrementalKey->get(MojDbServiceDefs::DeletedRevKey, delRevParam);
 	}
 
-    // if 'enableRootKind' flag is true, find subkinds from root
-    if (m_enableRootKind) {
-        err = m_kindEngine.getKinds(kindVec);
-        MojErrCheck(err);
-    }
-    else {
-        err = m_kindEngine.getKind(kindVec, MojDbKindEngine::KindKindId);
-        MojErrCheck(err);
-        err = m_kindEngine.getKind(kindVec, MojDbKindEngine::PermissionId);
-        MojErrCheck(err);
-        err = m_kindEngine.getKind(kindVec, MojDbKindEngine::DbStateId);
-        MojErrCheck(err);
-        err = m_kindEngine.getKind(kindVec, MojDbKindEngine::RevTimestampId);
-        MojErrCheck(err);
-        err = m_kindEngine.getKind(kindVec, MojDbKindEngine::QuotaId);
-        MojErrCheck(err);
-    }
+	err = dumpKinds(kindVec);
+	MojErrCheck(err);
 
 	// write kinds - if incremental, only write the kinds that have changed since the respective revs
 	MojString countStr;
@@ -372,6 +429,101 @@ MojErr MojDb::dump(const MojChar* path, MojUInt32& countOut, bool incDel, MojDbR
 	return MojErrNone;
 }
 
+MojErr MojDb::dumpBinary(const MojChar* path, MojUInt32& countOut, bool incDel, bool compress, MojDbReqRef req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(path);
+
+	MojErr err = beginReq(req);
+	MojErrCheck(err);
+
+	if (!req->admin()) {
+        LOG_ERROR(MSGID_DB_ADMIN_ERROR, 2,
+        		PMLOGKS("data", req->domain().data()),
+        		PMLOGKS("path", path),
+        		"access denied: 'data' cannot dump db to path: 'path'");
+		MojErrThrow(MojErrDbAccessDenied);
+	}
+
+	MojDbDumpWriter writer;
+	err = writer.open(path, compress);
+	MojErrCheck(err);
+
+	MojVector<MojObject> kindVec;
+	err = dumpKinds(kindVec);
+	MojErrCheck(err);
+
+	// kinds go first, load has to register them before any of their objects
+	MojDbDumpFile::Block block;
+	for (MojVector<MojObject>::ConstIterator i = kindVec.begin(); i != kindVec.end(); ++i) {
+		MojObject kind = *i;
+		bool found = false;
+		err = kind.del(RevKey, found);
+		MojErrCheck(err);
+		err = block.append(kind);
+		MojErrCheck(err);
+		if (block.full()) {
+			err = writer.write(block);
+			MojErrCheck(err);
+		}
+		countOut++;
+	}
+	err = writer.write(block);
+	MojErrCheck(err);
+
+	// then every kind is scanned on its own, in parallel on the query executor.
+	// With a root kind the json dump also picks up objects of the builtin kinds.
+	MojVector<MojString> kindIds;
+	for (MojVector<MojObject>::ConstIterator i = kindVec.begin(); i != kindVec.end(); ++i) {
+		MojString id;
+		bool found = false;
+		err = i->get(MojDbServiceDefs::IdKey, id, found);
+		MojErrCheck(err);
+		if (found && id != MojDbKindEngine::KindKindId) {
+			err = kindIds.push(id);
+			MojErrCheck(err);
+		}
+	}
+	if (m_enableRootKind) {
+		const MojChar* const builtins[] = {MojDbKindEngine::PermissionId, MojDbKindEngine::DbStateId,
+			MojDbKindEngine::RevTimestampId, MojDbKindEngine::QuotaId};
+		for (MojSize i = 0; i < sizeof(builtins) / sizeof(builtins[0]); ++i) {
+			MojString id;
+			err = id.assign(builtins[i]);
+			MojErrCheck(err);
+			err = kindIds.push(id);
+			MojErrCheck(err);
+		}
+	}
+
+#ifdef LMDB_ENGINE_SUPPORT
+	// lmdb txns belong to one thread, a single batch keeps every kind on this one
+	MojSize batchSize = kindIds.empty() ? 1 : kindIds.size();
+#else
+	MojSize batchSize = 1;
+#endif
+	DumpJob job(*this, writer, kindIds, incDel, req);
+	err = m_queryExecutor.run(job, kindIds.size(), batchSize);
+	MojErrCheck(err);
+	countOut += job.count();
+
+	err = writer.close();
+	MojErrCheck(err);
+
+	MojSize warns = job.warns();
+	if (warns > 0) {
+		LOG_WARNING(MSGID_MOJ_DB_ADMIN_WARNING, 1,
+			PMLOGKFV("warn", "%d", (int)warns),
+			"Finished dump with 'warn' warnings");
+	}
+	LOG_DEBUG("[db_mojodb] Dumped %u objects to %s, %zu bytes", countOut, path, writer.bytesWritten());
+
+	err = req->end();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDb::load(const MojChar* path, MojUInt32& countOut, MojUInt32 flags, MojDbReqRef req)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -380,6 +532,19 @@ MojErr MojDb::load(const MojChar* path, MojUInt32& countOut, MojUInt32 flags, Mo
 	MojErr err = beginReq(req, true);
 	MojErrCheck(err);
 
+	bool binary = false;
+	err = MojDbDumpFile::isDump(path, binary);
+	MojErrCheck(err);
+	if (binary) {
+		err = loadBinary(path, countOut, flags, req);
+		MojErrCheck(err);
+		err = req->end();
+		MojErrCheck(err);
+		err = req->endBatch();
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
 	MojFile file;
 	err = file.open(path, MOJ_O_RDONLY);
 	MojErrCheck(err);
@@ -709,6 +874,154 @@ MojErr MojDb::dumpImpl(MojFile& file, bool backup, bool incDel, const MojObject&
 	return MojErrNone;
 }
 
+MojErr MojDb::dumpKinds(MojVector<MojObject>& kindVec)
+{
+    // if 'enableRootKind' flag is true, find subkinds from root
+    if (m_enableRootKind) {
+        MojErr err = m_kindEngine.getKinds(kindVec);
+        MojErrCheck(err);
+    }
+    else {
+        MojErr err = m_kindEngine.getKind(kindVec, MojDbKindEngine::KindKindId);
+        MojErrCheck(err);
+        err = m_kindEngine.getKind(kindVec, MojDbKindEngine::PermissionId);
+        MojErrCheck(err);
+        err = m_kindEngine.getKind(kindVec, MojDbKindEngine::DbStateId);
+        MojErrCheck(err);
+        err = m_kindEngine.getKind(kindVec, MojDbKindEngine::RevTimestampId);
+        MojErrCheck(err);
+        err = m_kindEngine.getKind(kindVec, MojDbKindEngine::QuotaId);
+        MojErrCheck(err);
+    }
+    return MojErrNone;
+}
+
+MojErr MojDb::dumpKindObjs(MojDbDumpWriter& writer, const MojString& kindId, bool deleted, MojUInt32& countOut, MojSize& warnsOut, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojDbQuery query;
+	MojErr err = query.from(kindId);
+	MojErrCheck(err);
+	err = query.where(MojDb::DelKey, MojDbQuery::OpEq, deleted);
+	MojErrCheck(err);
+
+	MojDbCursor cursor;
+	err = findImpl(query, cursor, NULL, req, OpRead);
+	MojErrCheck(err);
+
+	MojDbDumpFile::Block block;
+	for (;;) {
+		bool found = false;
+		MojObject obj;
+		err = cursor.get(obj, found);
+		// skip ghost keys, same as the json dump
+		if (err == MojErrInternalIndexOnFind) {
+			warnsOut++;
+			continue;
+		}
+		MojErrCheck(err);
+		if (!found)
+			break;
+
+		// a kind's query also returns its sub-kinds, those are dumped with their own kind
+		MojString kind;
+		err = obj.getRequired(KindKey, kind);
+		MojErrCheck(err);
+		if (kind != kindId)
+			continue;
+
+		err = obj.del(RevKey, found);
+		MojErrCheck(err);
+		err = block.append(obj);
+		MojErrCheck(err);
+		if (block.full()) {
+			err = writer.write(block);
+			MojErrCheck(err);
+		}
+		countOut++;
+	}
+	err = cursor.close();
+	MojErrCheck(err);
+	err = writer.write(block);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDb::loadBinary(const MojChar* path, MojUInt32& countOut, MojUInt32 flags, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojDbDumpReader reader;
+	MojErr err = reader.open(path);
+	MojErrCheck(err);
+
+	struct timeval startTime = {0,0}, stopTime = {0,0};
+	gettimeofday(&startTime, NULL);
+
+	// workers decompress and parse a group of blocks while this thread is the
+	// only writer; each group is applied in one transaction
+	const MojSize groupSize = m_queryExecutor.slots() * LoadBlocksPerSlot;
+	DecodeJob::BlockVec blocks;
+	DecodeJob::ObjectSlots objs;
+	int transactions = 0;
+	bool more = true;
+	while (more) {
+		blocks.clear();
+		while (blocks.size() < groupSize) {
+			bool found = false;
+			blocks.emplace_back();
+			err = reader.read(blocks.back(), found);
+			MojErrCheck(err);
+			if (!found) {
+				blocks.pop_back();
+				more = false;
+				break;
+			}
+		}
+		if (blocks.empty())
+			break;
+
+		objs.assign(blocks.size(), MojDbDumpFile::ObjectVec());
+		DecodeJob job(blocks, objs);
+		err = m_queryExecutor.run(job, blocks.size(), 1);
+		MojErrCheck(err);
+
+		for (DecodeJob::ObjectSlots::iterator i = objs.begin(); i != objs.end(); ++i) {
+			MojDbDumpFile::ObjectVec::Iterator obj;
+			err = i->begin(obj);
+			MojErrCheck(err);
+			for (; obj != i->end(); ++obj) {
+				err = loadImpl(*obj, flags, req);
+				MojErrCheck(err);
+				countOut++;
+			}
+		}
+
+		if (more) {
+			err = req.end();
+			MojErrCheck(err);
+			err = req.endBatch();
+			MojErrCheck(err);
+			req.beginBatch();
+			err = beginReq(req, true);
+			MojErrCheck(err);
+			transactions++;
+		}
+	}
+	err = reader.close();
+	MojErrCheck(err);
+
+	gettimeofday(&stopTime, NULL);
+	long int elapsedTimeMS = (stopTime.tv_sec - startTime.tv_sec) * 1000 +
+				(stopTime.tv_usec - startTime.tv_usec) / 1000;
+	LOG_DEBUG("[db_mojodb] Loaded binary dump %s with %u records in %ldms, %d extra transactions\n",
+		path, countOut, elapsedTimeMS, transactions);
+
+	return MojErrNone;
+}
+
 MojErr MojDb::dumpObj(MojFile& file, MojObject obj, MojSize& bytesWrittenOut, MojUInt32 maxBytes)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -821,46 +1134,112 @@ MojErr MojDb::loadImpl(MojObject& obj, MojUInt32 flags, MojDbReq& req)
 	return MojErrNone;
 }
 
-MojErr MojDb::purgeImpl(MojObject& obj, MojUInt32& countOut, MojDbReq& req)
+MojErr MojDb::purgeQuery(const MojObject& rev, bool sync, MojUInt32 limit, MojUInt32& countOut, MojDbReq& req)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojObject val;
-	MojErr err = obj.getRequired(RevNumKey, val);
+	MojDbQuery objQuery;
+	MojErr err = objQuery.from(MojDbKindEngine::RootKindId);
 	MojErrCheck(err);
-	MojObject timestamp;
-	err = obj.getRequired(TimestampKey, timestamp);
+	err = objQuery.where(DelKey, MojDbQuery::OpEq, true);
+	MojErrCheck(err);
+	err = objQuery.where(SyncKey, MojDbQuery::OpEq, sync);
+	MojErrCheck(err);
+	err = objQuery.where(RevKey, MojDbQuery::OpLessThanEq, rev);
+	MojErrCheck(err);
+	objQuery.limit(limit);
+	err = delImpl(objQuery, countOut, req, MojDbFlagPurge);
 	MojErrCheck(err);
 
-	// purge all objects that were deleted on or prior to this rev num
+	return MojErrNone;
+}
 
-	// query for objects in two passes - once where backup is true and once where backup is false
+MojErr MojDb::purgeRange(const MojObject& rev, bool sync, MojUInt32 limit, MojUInt32& countOut, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// The batch is a prefix of the root [_del, _sync, _rev, _id] index, so its keys
+	// there go in one range delete. The upper bound includes the last _id so keys
+	// of objects past the limit that share the last rev stay put.
+	countOut = 0;
 	MojDbQuery objQuery;
-	err = objQuery.from(MojDbKindEngine::RootKindId);
+	MojErr err = objQuery.from(MojDbKindEngine::RootKindId);
 	MojErrCheck(err);
 	err = objQuery.where(DelKey, MojDbQuery::OpEq, true);
 	MojErrCheck(err);
-	err = objQuery.where(SyncKey, MojDbQuery::OpEq, true);
+	err = objQuery.where(SyncKey, MojDbQuery::OpEq, sync);
 	MojErrCheck(err);
-	err = objQuery.where(RevKey, MojDbQuery::OpLessThanEq, val);
+	err = objQuery.where(RevKey, MojDbQuery::OpLessThanEq, rev);
 	MojErrCheck(err);
+	objQuery.limit(limit);
 
-	MojUInt32 backupCount = 0;
-	req.autobatch(true);
-	req.fixmode(true);
-	objQuery.limit(AutoBatchSize);
-	err = delImpl(objQuery, backupCount, req, MojDbFlagPurge);
+	MojVector<MojObject> objs;
+	MojVector<MojSize> sizes;
+	MojDbIndex* revIndex = NULL;
+	err = readBatch(objQuery, objs, sizes, revIndex, req);
+	MojErrCheck(err);
+	if (objs.empty())
+		return MojErrNone;
+	if (!revIndex || revIndex->props().size() != 4 || revIndex->props().at(0) != DelKey ||
+		revIndex->props().at(1) != SyncKey || revIndex->props().at(2) != RevKey)
+		MojErrThrow(MojErrNotImplemented);
+
+	MojObject lastRev;
+	err = objs.back().getRequired(RevKey, lastRev);
+	MojErrCheck(err);
+	MojObject lastId;
+	err = objs.back().getRequired(IdKey, lastId);
+	MojErrCheck(err);
+	MojObject lower(MojObject::TypeArray);
+	err = lower.push(true);
+	MojErrCheck(err);
+	err = lower.push(sync);
+	MojErrCheck(err);
+	MojObject upper(lower);
+	err = upper.push(lastRev);
+	MojErrCheck(err);
+	err = upper.push(lastId);
+	MojErrCheck(err);
+
+	MojSize removed = 0;
+	req.txn()->quotaEnabled(false);
+	err = revIndex->delRange(lower, upper, req.txn(), removed);
+	req.txn()->quotaEnabled(true);
 	MojErrCheck(err);
 
-	MojDbQuery objQuery2;
-	err = objQuery2.from(MojDbKindEngine::RootKindId);
+	err = req.skipIndex(revIndex);
+	MojErrCheck(err);
+	err = purgeBatch(objs, sizes, revIndex, req);
+	req.clearSkipIndexes();
 	MojErrCheck(err);
-	err = objQuery2.where(DelKey, MojDbQuery::OpEq, true);
+
+	countOut = (MojUInt32) objs.size();
+	return MojErrNone;
+}
+
+MojErr MojDb::purgeImpl(MojObject& obj, MojUInt32& countOut, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojObject val;
+	MojErr err = obj.getRequired(RevNumKey, val);
 	MojErrCheck(err);
-	err = objQuery2.where(SyncKey, MojDbQuery::OpEq, false);
+	MojObject timestamp;
+	err = obj.getRequired(TimestampKey, timestamp);
 	MojErrCheck(err);
-	err = objQuery2.where(RevKey, MojDbQuery::OpLessThanEq, val);
+
+	// purge all objects that were deleted on or prior to this rev num
+
+	// query for objects in two passes - once where backup is true and once where backup is false
+	MojUInt32 backupCount = 0;
+	req.autobatch(true);
+	req.fixmode(true);
+	err = purgeRange(val, true, AutoBatchSize, backupCount, req);
+	MojErrCatch(err, MojErrNotImplemented) {
+		err = purgeQuery(val, true, AutoBatchSize, backupCount, req);
+	}
 	MojErrCheck(err);
+
 	MojUInt32 count = 0;
 	MojUInt32 batchRemain = 0;
 	if (backupCount <= AutoBatchSize)
@@ -869,8 +1248,10 @@ MojErr MojDb::purgeImpl(MojObject& obj, MojUInt32& countOut, MojDbReq& req)
 	req.fixmode(true);		// force deletion of bad entries
 
 	if (batchRemain > 0) {
-		objQuery2.limit(batchRemain);
-		err = delImpl(objQuery2, count, req, MojDbFlagPurge);
+		err = purgeRange(val, false, batchRemain, count, req);
+		MojErrCatch(err, MojErrNotImplemented) {
+			err = purgeQuery(val, false, batchRemain, count, req);
+		}
 		MojErrCheck(err);
 	}
 
@@ -0,0 +1,320 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "db/MojDbCompactScheduler.h"
+#include "core/MojLogDb8.h"
+
+const MojChar* const MojDbCompactScheduler::IntervalKey = _T("compactInterval");
+const MojChar* const MojDbCompactScheduler::IdleKey = _T("compactIdle");
+const MojChar* const MojDbCompactScheduler::BudgetKey = _T("compactBudget");
+const MojChar* const MojDbCompactScheduler::ThresholdKey = _T("compactThreshold");
+
+MojDbCompactScheduler::MojDbCompactScheduler(Compactor& compactor)
+: m_compactor(compactor),
+  m_thread(MojInvalidThread),
+  m_stop(false),
+  m_interval(IntervalDefault),
+  m_idle(IdleDefault),
+  m_budget(BudgetDefault),
+  m_threshold(ThresholdDefault),
+  m_tokens(0),
+  m_steps(0),
+  m_throttled(0),
+  m_errors(0),
+  m_compacted(0)
+{
+}
+
+MojDbCompactScheduler::~MojDbCompactScheduler()
+{
+	MojErr err = stop();
+	MojErrCatchAll(err);
+}
+
+MojErr MojDbCompactScheduler::configure(const MojObject& conf)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojInt64 interval = IntervalDefault;
+	MojInt64 idle = IdleDefault;
+	MojInt64 budget = BudgetDefault;
+	MojInt64 threshold = ThresholdDefault;
+	conf.get(IntervalKey, interval);
+	conf.get(IdleKey, idle);
+	conf.get(BudgetKey, budget);
+	conf.get(ThresholdKey, threshold);
+	if (interval <= 0)
+		MojErrThrowMsg(MojErrInvalidArg, _T("db: %s must be positive"), IntervalKey);
+	if (idle < 0 || budget < 0 || threshold < 0)
+		MojErrThrowMsg(MojErrInvalidArg, _T("db: compaction parameters must not be negative"));
+
+	MojThreadGuard guard(m_mutex);
+	m_interval = interval;
+	m_idle = idle;
+	m_budget = budget;
+	m_threshold = threshold;
+	if (m_tokens > m_budget)
+		m_tokens = m_budget;
+
+	return MojErrNone;
+}
+
+MojErr MojDbCompactScheduler::start()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojThreadGuard guard(m_mutex);
+	if (m_budget == 0 || m_thread != MojInvalidThread)
+		return MojErrNone;
+	m_stop = false;
+	MojErr err = MojGetCurrentTime(m_lastRefill);
+	MojErrCheck(err);
+	m_lastCommit = m_lastRefill;
+	err = MojThreadCreate(m_thread, &threadMain, this);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbCompactScheduler::stop()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// a step in progress runs to its end, compactions can't be interrupted
+	MojThreadGuard guard(m_mutex);
+	MojThreadT thread = m_thread;
+	m_thread = MojInvalidThread;
+	m_stop = true;
+	MojErr err = m_cond.broadcast();
+	MojErrCheck(err);
+	guard.unlock();
+
+	if (thread != MojInvalidThread) {
+		MojErr threadErr = MojErrNone;
+		MojErr errJoin = MojThreadJoin(thread, threadErr);
+		MojErrAccumulate(err, errJoin);
+		MojErrAccumulate(err, threadErr);
+	}
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+bool MojDbCompactScheduler::enabled() const
+{
+	MojThreadGuard guard(m_mutex);
+	return m_budget > 0;
+}
+
+void MojDbCompactScheduler::Range::note(const char* key, MojSize keySize, MojSize written, MojSize deleted)
+{
+	// keys are copied only when they widen the range
+	if (debt() == 0) {
+		m_min.assign(key, keySize);
+		m_max.assign(key, keySize);
+	} else if (m_min.compare(0, std::string::npos, key, keySize) > 0) {
+		m_min.assign(key, keySize);
+	} else if (m_max.compare(0, std::string::npos, key, keySize) < 0) {
+		m_max.assign(key, keySize);
+	}
+	m_written += written;
+	m_deleted += deleted;
+}
+
+void MojDbCompactScheduler::Range::merge(const Range& range)
+{
+	if (range.debt() == 0)
+		return;
+	if (debt() == 0 || range.m_min < m_min)
+		m_min = range.m_min;
+	if (debt() == 0 || range.m_max > m_max)
+		m_max = range.m_max;
+	m_written += range.m_written;
+	m_deleted += range.m_deleted;
+}
+
+void MojDbCompactScheduler::noteCommit(const RangeMap& ranges)
+{
+	if (ranges.empty())
+		return;
+
+	MojTime now;
+	(void) MojGetCurrentTime(now);
+
+	MojThreadGuard guard(m_mutex);
+	m_lastCommit = now;
+	if (m_budget == 0)
+		return;
+	for (RangeMap::const_iterator i = ranges.begin(); i != ranges.end(); ++i)
+		m_ranges[i->first].merge(i->second);
+}
+
+void MojDbCompactScheduler::forget(const std::string& part)
+{
+	MojThreadGuard guard(m_mutex);
+	m_ranges.erase(part);
+}
+
+void MojDbCompactScheduler::forgetPrefix(const std::string& prefix)
+{
+	MojThreadGuard guard(m_mutex);
+	RangeMap::iterator i = m_ranges.lower_bound(prefix);
+	while (i != m_ranges.end() && i->first.compare(0, prefix.size(), prefix) == 0)
+		i = m_ranges.erase(i);
+}
+
+void MojDbCompactScheduler::reset()
+{
+	MojThreadGuard guard(m_mutex);
+	m_ranges.clear();
+}
+
+MojErr MojDbCompactScheduler::step(const MojTime& now, bool& ranOut)
+{
+	ranOut = false;
+
+	MojThreadGuard guard(m_mutex);
+	if (m_budget == 0)
+		return MojErrNone;
+	refill(now);
+	if (now - m_lastCommit < MojMillisecs(m_idle))
+		return MojErrNone;
+
+	// hottest part wins, ties go to the first in key order
+	RangeMap::iterator hot = m_ranges.end();
+	for (RangeMap::iterator i = m_ranges.begin(); i != m_ranges.end(); ++i) {
+		if (i->second.debt() < (MojSize) m_threshold)
+			continue;
+		if (hot == m_ranges.end() || i->second.debt() > hot->second.debt())
+			hot = i;
+	}
+	if (hot == m_ranges.end())
+		return MojErrNone;
+	if (m_tokens <= 0) {
+		++m_throttled;
+		return MojErrNone;
+	}
+
+	// commits during the step start a fresh range for the part
+	std::string part = hot->first;
+	Range range = hot->second;
+	m_ranges.erase(hot);
+	m_tokens -= (MojInt64) range.debt();
+	guard.unlock();
+
+	MojErr err = m_compactor.compactRange(part, range.m_min, range.m_max);
+
+	guard.lock();
+	ranOut = true;
+	if (err != MojErrNone) {
+		// nothing was compacted, the budget is given back
+		m_tokens += (MojInt64) range.debt();
+		++m_errors;
+		MojErrThrow(err);
+	}
+	++m_steps;
+	m_compacted += range.debt();
+
+	return MojErrNone;
+}
+
+MojErr MojDbCompactScheduler::stats(MojObject& objOut) const
+{
+	MojThreadGuard guard(m_mutex);
+
+	MojSize debt = 0;
+	MojSize written = 0;
+	MojSize deleted = 0;
+	MojSize hot = 0;
+	for (RangeMap::const_iterator i = m_ranges.begin(); i != m_ranges.end(); ++i) {
+		debt += i->second.debt();
+		written += i->second.m_written;
+		deleted += i->second.m_deleted;
+		if (i->second.debt() >= (MojSize) m_threshold)
+			++hot;
+	}
+
+	MojErr err = objOut.put(_T("enabled"), m_budget > 0);
+	MojErrCheck(err);
+	err = objOut.put(_T("budget"), m_budget);
+	MojErrCheck(err);
+	err = objOut.put(_T("tokens"), m_tokens);
+	MojErrCheck(err);
+	err = objOut.put(_T("debt"), (MojInt64) debt);
+	MojErrCheck(err);
+	err = objOut.put(_T("written"), (MojInt64) written);
+	MojErrCheck(err);
+	err = objOut.put(_T("deleted"), (MojInt64) deleted);
+	MojErrCheck(err);
+	err = objOut.put(_T("parts"), (MojInt64) m_ranges.size());
+	MojErrCheck(err);
+	err = objOut.put(_T("hotParts"), (MojInt64) hot);
+	MojErrCheck(err);
+	err = objOut.put(_T("steps"), (MojInt64) m_steps);
+	MojErrCheck(err);
+	err = objOut.put(_T("compacted"), (MojInt64) m_compacted);
+	MojErrCheck(err);
+	err = objOut.put(_T("throttled"), (MojInt64) m_throttled);
+	MojErrCheck(err);
+	err = objOut.put(_T("errors"), (MojInt64) m_errors);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbCompactScheduler::threadMain(void* arg)
+{
+	MojDbCompactScheduler* scheduler = static_cast<MojDbCompactScheduler*>(arg);
+	MojAssert(scheduler);
+
+	MojThreadGuard guard(scheduler->m_mutex);
+	while (!scheduler->m_stop) {
+		MojTime deadline;
+		MojErr err = MojGetCurrentTime(deadline);
+		MojErrCheck(err);
+		deadline += MojMillisecs(scheduler->m_interval);
+		err = scheduler->m_cond.timedWait(scheduler->m_mutex, deadline);
+		if (err != MojErrTimedOut)
+			MojErrCheck(err);
+		if (scheduler->m_stop)
+			break;
+		guard.unlock();
+
+		MojTime now;
+		err = MojGetCurrentTime(now);
+		MojErrCheck(err);
+		bool ran = false;
+		err = scheduler->step(now, ran);
+		if (err != MojErrNone)
+			LOG_WARNING(MSGID_MOJ_DB_WARNING, 1, PMLOGKFV("error", "%d", (int) err), "compaction step failed");
+		guard.lock();
+	}
+
+	return MojErrNone;
+}
+
+void MojDbCompactScheduler::refill(const MojTime& now)
+{
+	// at most one second of budget is kept, an idle db doesn't bank a burst
+	if (now > m_lastRefill) {
+		MojInt64 elapsed = (now - m_lastRefill).microsecs();
+		m_tokens += (MojInt64) ((double) m_budget * (double) elapsed / (double) MojTime::UnitsPerSec);
+		if (m_tokens > m_budget)
+			m_tokens = m_budget;
+	}
+	m_lastRefill = now;
+}
@@ -0,0 +1,329 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "db/MojDbDumpFile.h"
+#include "core/MojObjectBuilder.h"
+#include "core/MojObjectSerialization.h"
+#include "core/MojLogDb8.h"
+
+#ifdef WITH_SNAPPY_COMPRESSION
+#include <snappy.h>
+#endif
+
+const MojChar MojDbDumpFile::Magic[8] = {'D', 'B', '8', 'D', 'U', 'M', 'P', '\0'};
+
+namespace {
+
+void putUInt32(MojByte* dest, MojUInt32 val)
+{
+	dest[0] = (MojByte) val;
+	dest[1] = (MojByte) (val >> 8);
+	dest[2] = (MojByte) (val >> 16);
+	dest[3] = (MojByte) (val >> 24);
+}
+
+MojUInt32 getUInt32(const MojByte* src)
+{
+	return (MojUInt32) src[0] | ((MojUInt32) src[1] << 8) |
+		((MojUInt32) src[2] << 16) | ((MojUInt32) src[3] << 24);
+}
+
+}
+
+MojErr MojDbDumpFile::Block::append(const MojObject& obj)
+{
+	MojObjectWriter writer;
+	MojErr err = obj.visit(writer);
+	MojErrCheck(err);
+	const MojByte* data = NULL;
+	MojSize size = 0;
+	err = writer.buf().data(data, size);
+	MojErrCheck(err);
+	if (size > MojUInt32Max)
+		MojErrThrow(MojErrValueOutOfRange);
+
+	MojByte len[4];
+	putUInt32(len, (MojUInt32) size);
+	err = m_data.append(len, len + sizeof(len));
+	MojErrCheck(err);
+	err = m_data.append(data, data + size);
+	MojErrCheck(err);
+	m_rawSize = (MojUInt32) m_data.size();
+	++m_count;
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpFile::Block::decode(ObjectVec& objsOut) const
+{
+	const MojByte* data = m_data.begin();
+	MojSize size = m_data.size();
+#ifdef WITH_SNAPPY_COMPRESSION
+	ByteVec raw;
+#endif
+	if (m_codec == CodecSnappy) {
+#ifdef WITH_SNAPPY_COMPRESSION
+		MojErr err = raw.resize(m_rawSize);
+		MojErrCheck(err);
+		ByteVec::Iterator rawBegin;
+		err = raw.begin(rawBegin);
+		MojErrCheck(err);
+		if (!snappy::RawUncompress((const char*) data, size, (char*) rawBegin))
+			MojErrThrowMsg(MojErrFormat, _T("dump: corrupt compressed block"));
+		data = raw.begin();
+		size = raw.size();
+#else
+		MojErrThrowMsg(MojErrNotImplemented, _T("dump: block is compressed, but snappy is not available"));
+#endif
+	} else if (m_codec != CodecNone) {
+		MojErrThrowMsg(MojErrFormat, _T("dump: unknown block codec %d"), (int) m_codec);
+	}
+
+	MojErr err = objsOut.reserve(objsOut.size() + m_count);
+	MojErrCheck(err);
+	const MojByte* end = data + size;
+	for (MojUInt32 i = 0; i < m_count; ++i) {
+		if (end - data < 4)
+			MojErrThrowMsg(MojErrFormat, _T("dump: truncated block"));
+		MojUInt32 len = getUInt32(data);
+		data += 4;
+		if ((MojSize) (end - data) < len)
+			MojErrThrowMsg(MojErrFormat, _T("dump: truncated record"));
+		MojObjectBuilder builder;
+		err = MojObjectReader::read(builder, data, len);
+		MojErrCheck(err);
+		err = objsOut.push(builder.object());
+		MojErrCheck(err);
+		data += len;
+	}
+	return MojErrNone;
+}
+
+void MojDbDumpFile::Block::clear()
+{
+	m_codec = CodecNone;
+	m_rawSize = 0;
+	m_count = 0;
+	m_data.clear();
+}
+
+bool MojDbDumpFile::compressionSupported()
+{
+#ifdef WITH_SNAPPY_COMPRESSION
+	return true;
+#else
+	return false;
+#endif
+}
+
+MojErr MojDbDumpFile::isDump(const MojChar* path, bool& dumpOut)
+{
+	dumpOut = false;
+	MojFile file;
+	MojErr err = file.open(path, MOJ_O_RDONLY);
+	MojErrCheck(err);
+	MojChar magic[sizeof(Magic)];
+	MojSize read = 0;
+	err = file.read(magic, sizeof(magic), read);
+	MojErrCheck(err);
+	dumpOut = (read == sizeof(magic) && MojMemCmp(magic, Magic, sizeof(Magic)) == 0);
+
+	return MojErrNone;
+}
+
+MojDbDumpWriter::MojDbDumpWriter()
+: m_compress(false),
+  m_bytesWritten(0)
+{
+}
+
+MojDbDumpWriter::~MojDbDumpWriter()
+{
+	MojErr err = close();
+	MojErrCatchAll(err);
+}
+
+MojErr MojDbDumpWriter::open(const MojChar* path, bool compress)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(path);
+
+	MojErr err = m_file.open(path, MOJ_O_WRONLY | MOJ_O_CREAT | MOJ_O_TRUNC, MOJ_S_IRUSR | MOJ_S_IWUSR);
+	MojErrCheck(err);
+	m_compress = compress && compressionSupported();
+	m_bytesWritten = 0;
+
+	MojByte header[HeaderSize];
+	MojMemCpy(header, Magic, sizeof(Magic));
+	putUInt32(header + sizeof(Magic), Version);
+	err = writeBytes(header, sizeof(header));
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpWriter::close()
+{
+	if (!m_file.open())
+		return MojErrNone;
+	MojErr err = m_file.close();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpWriter::write(Block& block)
+{
+	if (block.empty())
+		return MojErrNone;
+
+	const MojByte* data = block.m_data.begin();
+	MojSize size = block.m_data.size();
+	MojUInt8 codec = CodecNone;
+#ifdef WITH_SNAPPY_COMPRESSION
+	// compress outside the lock, it is the expensive part
+	ByteVec compressed;
+	if (m_compress) {
+		MojErr err = compressed.resize(snappy::MaxCompressedLength(size));
+		MojErrCheck(err);
+		ByteVec::Iterator dest;
+		err = compressed.begin(dest);
+		MojErrCheck(err);
+		size_t compressedSize = 0;
+		snappy::RawCompress((const char*) data, size, (char*) dest, &compressedSize);
+		if (compressedSize < size) {
+			data = compressed.begin();
+			size = compressedSize;
+			codec = CodecSnappy;
+		}
+	}
+#endif
+
+	MojByte header[BlockHeaderSize];
+	header[0] = codec;
+	putUInt32(header + 1, (MojUInt32) size);
+	putUInt32(header + 5, block.m_rawSize);
+	putUInt32(header + 9, block.m_count);
+
+	MojThreadGuard guard(m_mutex);
+	MojErr err = writeBytes(header, sizeof(header));
+	MojErrCheck(err);
+	err = writeBytes(data, size);
+	MojErrCheck(err);
+	guard.unlock();
+
+	block.clear();
+
+	return MojErrNone;
+}
+
+MojSize MojDbDumpWriter::bytesWritten() const
+{
+	MojThreadGuard guard(m_mutex);
+	return m_bytesWritten;
+}
+
+MojErr MojDbDumpWriter::writeBytes(const MojByte* data, MojSize size)
+{
+	while (size > 0) {
+		MojSize written = 0;
+		MojErr err = m_file.write(data, size, written);
+		MojErrCheck(err);
+		data += written;
+		size -= written;
+		m_bytesWritten += written;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbDumpReader::open(const MojChar* path)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(path);
+
+	MojErr err = m_file.open(path, MOJ_O_RDONLY);
+	MojErrCheck(err);
+
+	MojByte header[HeaderSize];
+	MojSize read = 0;
+	err = readBytes(header, sizeof(header), read);
+	MojErrCheck(err);
+	if (read != sizeof(header) || MojMemCmp(header, Magic, sizeof(Magic)) != 0)
+		MojErrThrowMsg(MojErrFormat, _T("dump: '%s' is not a binary dump"), path);
+	MojUInt32 version = getUInt32(header + sizeof(Magic));
+	if (version > Version)
+		MojErrThrowMsg(MojErrDbHeaderVersionMismatch, _T("dump: unsupported version %u"), version);
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpReader::close()
+{
+	if (!m_file.open())
+		return MojErrNone;
+	MojErr err = m_file.close();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpReader::read(Block& blockOut, bool& foundOut)
+{
+	foundOut = false;
+	blockOut.clear();
+
+	MojByte header[BlockHeaderSize];
+	MojSize read = 0;
+	MojErr err = readBytes(header, sizeof(header), read);
+	MojErrCheck(err);
+	if (read == 0)
+		return MojErrNone;
+	if (read != sizeof(header))
+		MojErrThrowMsg(MojErrUnexpectedEof, _T("dump: truncated block header"));
+
+	MojUInt32 size = getUInt32(header + 1);
+	err = blockOut.m_data.resize(size);
+	MojErrCheck(err);
+	ByteVec::Iterator data;
+	err = blockOut.m_data.begin(data);
+	MojErrCheck(err);
+	err = readBytes(data, size, read);
+	MojErrCheck(err);
+	if (read != size)
+		MojErrThrowMsg(MojErrUnexpectedEof, _T("dump: truncated block"));
+
+	blockOut.m_codec = header[0];
+	blockOut.m_rawSize = getUInt32(header + 5);
+	blockOut.m_count = getUInt32(header + 9);
+	foundOut = true;
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpReader::readBytes(MojByte* data, MojSize size, MojSize& sizeOut)
+{
+	sizeOut = 0;
+	while (sizeOut < size) {
+		MojSize read = 0;
+		MojErr err = m_file.read(data + sizeOut, size - sizeOut, read);
+		MojErrCheck(err);
+		if (read == 0)
+			break;
+		sizeOut += read;
+	}
+	return MojErrNone;
+}
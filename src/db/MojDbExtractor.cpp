@@ -167,7 +167,17 @@ MojErr MojDbPropExtractor::fromObjectImpl(const MojObject& obj, const MojDbPropE
 	return MojErrNone;
 }
 
-MojErr MojDbPropExtractor::valsImpl(const MojObject& obj, KeySet& valsOut, MojSize idx) const
+bool MojDbPropExtractor::touched(const StringVec& props) const
+{
+	// the rest of the path lives inside the first component
+	MojAssert(!m_prop.empty());
+	const MojString& propKey = m_prop.front();
+	if (propKey == WildcardKey)
+		return !props.empty();
+	return props.find(propKey) != MojInvalidIndex;
+}
+
+MojErr MojDbPropExtractor::valsImpl(const MojObjectView& obj, KeySet& valsOut, MojSize idx) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -177,27 +187,46 @@ MojErr MojDbPropExtractor::valsImpl(const MojObject& obj, KeySet& valsOut, MojSi
 	const MojString& propKey = m_prop[idx];
 	if (propKey == WildcardKey) {
 		// get all prop vals if we have a wildcard
-		for (MojObject::ConstIterator i = obj.begin(); i != obj.end(); ++i) {
-			err = handleVal(*i, valsOut, idx);
+		if (obj.type() != MojObject::TypeObject)
+			return MojErrNone;
+		MojObjectView::ConstIterator i;
+		err = obj.begin(i);
+		MojErrCheck(err);
+		for (;;) {
+			bool found = false;
+			err = i.next(found);
+			MojErrCheck(err);
+			if (!found)
+				break;
+			err = handleVal(i.value(), valsOut, idx);
 			MojErrCheck(err);
 		}
 	} else {
 		// get object corresponding to the current component in the prop path
-		MojObject::ConstIterator i = obj.find(propKey);
-		if (i == obj.end()) {
+		MojObjectView val;
+		bool found = false;
+		err = obj.get(propKey.data(), val, found);
+		MojErrCheck(err);
+		if (!found) {
 			err = valsOut.put(m_default);
 			MojErrCheck(err);
 		} else {
-			if (i->type() == MojObject::TypeArray) {
+			if (val.type() == MojObject::TypeArray) {
 				// if the value is an array, act on its elements rather than the array object itself
-				MojObject::ConstArrayIterator end = i->arrayEnd();
-				for (MojObject::ConstArrayIterator j = i->arrayBegin(); j != end; ++j) {
-					err = handleVal(*j, valsOut, idx);
+				MojObjectView::ConstIterator j;
+				err = val.begin(j);
+				MojErrCheck(err);
+				for (;;) {
+					err = j.next(found);
+					MojErrCheck(err);
+					if (!found)
+						break;
+					err = handleVal(j.value(), valsOut, idx);
 					MojErrCheck(err);
 				}
 			} else {
 				// not an array
-				err = handleVal(*i, valsOut, idx);
+				err = handleVal(val, valsOut, idx);
 				MojErrCheck(err);
 			}
 		}
@@ -205,7 +234,7 @@ MojErr MojDbPropExtractor::valsImpl(const MojObject& obj, KeySet& valsOut, MojSi
 	return MojErrNone;
 }
 
-MojErr MojDbPropExtractor::handleVal(const MojObject& val, KeySet& valsOut, MojSize idx) const
+MojErr MojDbPropExtractor::handleVal(const MojObjectView& val, KeySet& valsOut, MojSize idx) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -223,8 +252,16 @@ MojErr MojDbPropExtractor::handleVal(const MojObject& val, KeySet& valsOut, MojS
 				MojErrCheck(err);
 			}
 		} else {
+			// keys are built from MojObjects, so only the leaf gets materialized
+			MojObject leaf;
+			const MojObject* leafObj = val.object();
+			if (!leafObj) {
+				err = val.toObject(leaf);
+				MojErrCheck(err);
+				leafObj = &leaf;
+			}
 			MojDbKey key;
-			err = key.assign(val, m_collator.get());
+			err = key.assign(*leafObj, m_collator.get());
 			MojErrCheck(err);
 			err = valsOut.put(key);
 			MojErrCheck(err);
@@ -279,7 +316,7 @@ MojErr MojDbMultiExtractor::updateLocale(const MojChar* locale)
 	return MojErrNone;
 }
 
-MojErr MojDbMultiExtractor::vals(const MojObject& obj, KeySet& valsOut) const
+MojErr MojDbMultiExtractor::vals(const MojObjectView& obj, KeySet& valsOut) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -290,3 +327,12 @@ MojErr MojDbMultiExtractor::vals(const MojObject& obj, KeySet& valsOut) const
 	}
 	return MojErrNone;
 }
+
+bool MojDbMultiExtractor::touched(const StringVec& props) const
+{
+	for (ExtractorVec::ConstIterator i = m_extractors.begin(); i != m_extractors.end(); ++i) {
+		if ((*i)->touched(props))
+			return true;
+	}
+	return false;
+}
@@ -23,17 +23,27 @@
 #include "core/MojObject.h"
 #include "core/MojObjectSerialization.h"
 
+const MojChar* const MojDbIndex::BuildingKey = _T("building");
+const MojChar* const MojDbIndex::BuiltKey = _T("built");
 const MojChar* const MojDbIndex::CountKey = _T("count");
 const MojChar* const MojDbIndex::DelMissesKey = _T("delmisses");
 const MojChar* const MojDbIndex::DefaultKey = _T("default");
 const MojChar* const MojDbIndex::IncludeDeletedKey = _T("incDel");
 const MojChar* const MojDbIndex::MultiKey = _T("multi");
 const MojChar* const MojDbIndex::NameKey = _T("name");
+const MojChar* const MojDbIndex::PlanStatsKey = _T("planStats");
 const MojChar* const MojDbIndex::PropsKey = _T("props");
 const MojChar* const MojDbIndex::SizeKey = _T("size");
 const MojChar* const MojDbIndex::TypeKey = _T("type");
 const MojChar* const MojDbIndex::WatchesKey = _T("watches");
 
+// planner cost model: every row visited costs one unit plus a little per key byte
+const MojDouble MojDbIndex::RowCost = 1.0;
+const MojDouble MojDbIndex::KeyByteCost = 1.0 / 64;
+const MojDouble MojDbIndex::DefaultPropSize = 8.0;
+const MojDouble MojDbIndex::DefaultEqSelectivity = 0.1;
+const MojDouble MojDbIndex::RangeSelectivity = 0.33;
+
 //db.index
 
 MojDbIndex::MojDbIndex(MojDbKind* kind, MojDbKindEngine* kindEngine)
@@ -45,6 +55,11 @@ MojDbIndex::MojDbIndex(MojDbKind* kind, MojDbKindEngine* kindEngine)
   m_idIndex(MojInvalidSize),
   m_includeDeleted(false),
   m_ready(false),
+  m_building(false),
+  m_built(0),
+  m_chunkCount(0),
+  m_chunkDone(false),
+  m_chunkPending(false),
   m_delMisses(0)
 {
 }
@@ -61,6 +76,16 @@ MojDbIndex::~MojDbIndex()
         MojErr err = it.key()->unsubscribe(*this);
         MojErrCatchAll(err);
     }
+    for (auto it = m_unkeyedTxns.begin(); it != m_unkeyedTxns.end(); ++it)
+    {
+        MojErr err = (*it)->unsubscribe(*this);
+        MojErrCatchAll(err);
+    }
+    for (auto it = m_pendingStats.begin(); it != m_pendingStats.end(); ++it)
+    {
+        MojErr err = it.key()->unsubscribe(*this);
+        MojErrCatchAll(err);
+    }
 
     MojErr err = abandonWatchers(guard);
     MojErrCatchAll(err);
@@ -153,11 +178,36 @@ MojErr MojDbIndex::open(MojDbStorageExtIndex* index, const MojObject& id, MojDbR
 	err = addBuiltinProps();
 	MojErrCheck(err);
 
+	// a new index starts empty, so the running totals are exact from here on
+	if (created)
+		m_stats.totals(0, 0);
 	if (created && !isIdIndex()) {
-		// if this index was just created, we need to re-index before committing the transaction
+		// if this index was just created, the first chunk is indexed before committing the transaction
+		// and the rest of the kind is left to the index builder
 		MojDbStorageTxn* txn = req.txn();
 		txn->notifyPreCommit(m_preCommitSlot);
 		txn->notifyPostCommit(m_postCommitSlot);
+		MojThreadWriteGuard guard(m_lock);
+		m_building = true;
+	} else if (!isIdIndex() && m_kind) {
+		// resume a build that was interrupted by close
+		bool found = false;
+		MojObject buildId;
+		err = m_kind->state()->indexBuild(m_name, req, buildId, found);
+		MojErrCheck(err);
+		if (found) {
+			MojThreadWriteGuard guard(m_lock);
+			m_buildId = buildId;
+			if (!m_buildId.null()) {
+				err = m_buildKey.assign(m_buildId);
+				MojErrCheck(err);
+			}
+			m_building = true;
+			guard.unlock();
+			req.txn()->notifyPostCommit(m_postCommitSlot);
+		} else {
+			m_ready = true;
+		}
 	} else {
 		// otherwise it's ready
 		m_ready = true;
@@ -201,6 +251,19 @@ MojErr MojDbIndex::stats(MojObject& objOut, MojSize& usageOut, MojDbReq& req)
 
 	MojErrCheck(err);
 	usageOut += size;
+	// replace running planner totals with the exact ones, less what this txn has
+	// written but not committed yet
+	MojThreadReadGuard statsGuard(m_lock);
+	decltype(m_pendingStats)::ConstIterator pending = m_pendingStats.find(req.txn());
+	if (pending == m_pendingStats.end()) {
+		m_stats.totals(count, size);
+	} else if (!pending.value().m_reset) {
+		m_stats.totals(count, size);
+		m_stats.adjust(-pending.value().m_count, -pending.value().m_size);
+	}
+	bool building = m_building;
+	MojInt64 built = m_built;
+	statsGuard.unlock();
 
 	err = objOut.put(SizeKey, (MojInt64) size);
 	MojErrCheck(err);
@@ -208,6 +271,17 @@ MojErr MojDbIndex::stats(MojObject& objOut, MojSize& usageOut, MojDbReq& req)
 	MojErrCheck(err);
 	err = objOut.put(DelMissesKey, (MojInt64) m_delMisses); // cumulative since start
 	MojErrCheck(err);
+	MojObject planStats;
+	err = m_stats.toObject(planStats);
+	MojErrCheck(err);
+	err = objOut.put(PlanStatsKey, planStats);
+	MojErrCheck(err);
+	if (building) {
+		err = objOut.put(BuildingKey, true);
+		MojErrCheck(err);
+		err = objOut.put(BuiltKey, built);
+		MojErrCheck(err);
+	}
 
 	MojThreadReadGuard guard(m_lock);
 	if (!m_watcherMap.empty()) {
@@ -227,8 +301,16 @@ MojErr MojDbIndex::drop(MojDbReq& req)
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(isOpen());
 
+	// queued chunks become no-ops
+	MojThreadWriteGuard guard(m_lock);
+	m_building = false;
+	guard.unlock();
 	MojErr err = m_index->drop(req.txn());
 	MojErrCheck(err);
+	err = addUnkeyedAll(*req.txn());
+	MojErrCheck(err);
+	err = addPendingStats(*req.txn(), 0, 0, true);
+	MojErrCheck(err);
 
 	return MojErrNone;
 }
@@ -249,17 +331,124 @@ MojErr MojDbIndex::updateLocale(const MojChar* locale, MojDbReq& req)
 	}
 	if (haveCollate) {
 		// drop and reindex
+		MojThreadReadGuard guard(m_lock);
+		bool building = m_building;
+		guard.unlock();
 		MojErr err = drop(req);
 		MojErrCheck(err);
-		err = build(req.txn());
-		MojErrCheck(err);
+		if (building) {
+			// start the backfill over with the new collation
+			err = m_kind->state()->updateIndexBuild(m_name, MojObject(), req);
+			MojErrCheck(err);
+			MojThreadWriteGuard writeGuard(m_lock);
+			m_buildId = MojObject();
+			m_buildKey.clear();
+			m_built = 0;
+			m_building = true;
+		} else {
+			err = build(req.txn());
+			MojErrCheck(err);
+		}
 	}
     (void) m_locale.assign(locale);
     
 	return MojErrNone;
 }
 
-MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojDbStorageTxn* txn, bool forcedel)
+bool MojDbIndex::building()
+{
+	MojThreadReadGuard guard(m_lock);
+	return isOpen() && m_building;
+}
+
+MojErr MojDbIndex::buildChunk(MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// index may have been dropped or closed since the chunk was queued
+	if (!building())
+		return MojErrNone;
+
+	req.txn()->notifyPostCommit(m_postCommitSlot);
+	MojErr err = backfill(req);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojDbStorageTxn* txn, bool forcedel,
+		const StringVec* changed)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(isOpen());
+	MojAssert(newObj || oldObj);
+
+	MojThreadReadGuard guard(m_lock);
+	if (m_building) {
+		// objects past the watermark are indexed by the backfill as they are when it gets there
+		MojObject id;
+		MojErr err = (newObj ? newObj : oldObj)->getRequired(MojDb::IdKey, id);
+		MojErrCheck(err);
+		MojDbKey idKey;
+		err = idKey.assign(id);
+		MojErrCheck(err);
+		if (m_buildId.null() || idKey > m_buildKey)
+			return MojErrNone;
+	}
+	guard.unlock();
+	MojErr err = updateImpl(newObj, oldObj, txn, forcedel, changed);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::delRange(const MojObject& lower, const MojObject& upper, MojDbStorageTxn* txn, MojSize& countOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(isOpen());
+	MojAssert(txn);
+
+	// lower and upper hold values for the leading props, both bounds are inclusive
+	MojDbKey from;
+	MojErr err = rangeKey(lower, from);
+	MojErrCheck(err);
+	MojDbKey to;
+	err = rangeKey(upper, to);
+	MojErrCheck(err);
+	err = to.increment();
+	MojErrCheck(err);
+
+	MojSize size = 0;
+	err = m_index->delRange(from, to, txn, countOut, size);
+	MojErrCheck(err);
+	if (countOut > 0) {
+		err = addPendingStats(*txn, -(MojInt64) countOut, -(MojInt64) size);
+		MojErrCheck(err);
+		err = addUnkeyedAll(*txn);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::keySize(const MojObject& obj, MojSize& sizeOut) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	sizeOut = 0;
+	if (!includeObj(&obj))
+		return MojErrNone;
+	KeyVec keys;
+	MojErr err = getKeys(obj, keys);
+	MojErrCheck(err);
+	for (KeyVec::ConstIterator i = keys.begin(); i != keys.end(); ++i)
+		sizeOut += i->size();
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::updateImpl(const MojObject* newObj, const MojObject* oldObj, MojDbStorageTxn* txn, bool forcedel,
+		const StringVec* changed)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(isOpen());
@@ -272,8 +461,8 @@ MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojD
 	if (includeNew && !includeOld) {
 		// we include the new but not the old, so just put all the new keys
 		MojAssert(newObj);
-		KeySet newKeys;
-		MojErr err = getKeys(*newObj, newKeys);
+		KeyVec newKeys;
+		MojErr err = getKeys(*newObj, newKeys, &m_stats);
 		MojErrCheck(err);
 
 		// get shardId
@@ -292,7 +481,7 @@ MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojD
 	} else if (includeOld && !includeNew) {
 		// we include the old but not the new objects, so del all the old keys
 		MojAssert(oldObj);
-		KeySet oldKeys;
+		KeyVec oldKeys;
 		MojErr err = getKeys(*oldObj, oldKeys);
 		MojErrCheck(err);
 
@@ -312,8 +501,32 @@ MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojD
 	} else if (includeNew && includeOld) {
 		// we include old and new objects
 		MojAssert(newObj && oldObj);
-		KeySet newKeys;
-		MojErr err = getKeys(*newObj, newKeys);
+		StringVec changedProps;
+		if (!changed) {
+			MojErr err = MojDbIndex::changedProps(*newObj, *oldObj, changedProps);
+			MojErrCheck(err);
+			changed = &changedProps;
+		}
+		if (!touched(*changed)) {
+			// none of our props changed, so there is nothing to write. watchers still
+			// hear about the update, but the keys are only worth building if there are any
+			bool watched = false;
+			MojErr err = addUnkeyed(*txn, watched);
+			MojErrCheck(err);
+			if (watched) {
+				KeyVec keys;
+				err = getKeys(*newObj, keys);
+				MojErrCheck(err);
+				err = addPendingKeys(keys, *txn);
+				MojErrCheck(err);
+			}
+			LOG_DEBUG("[db_mojodb] IndexMerge: %s; Untouched; watched = %d\n", this->name().data(), (int)watched);
+			return MojErrNone;
+		}
+
+		KeyVec newKeys;
+		KeyVec oldKeys;
+		MojErr err = getKeys(*newObj, *oldObj, *changed, newKeys, oldKeys, &m_stats);
 		MojErrCheck(err);
 
 		// get shardId (old)
@@ -332,16 +545,12 @@ MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojD
 		err = MojDbIdGenerator::extractShard(newObjId, shardId);
 		MojErrCheck(err);
 
-		KeySet oldKeys;
-		err = getKeys(*oldObj, oldKeys);
-		MojErrCheck(err);
-		// we need to put the keys that are in the new set, but not in the old
-		KeySet keysToPut;
-		err = newKeys.diff(oldKeys, keysToPut);
-		MojErrCheck(err);
-		// we need to del the keys that are in the old set, but not in the new
-		KeySet keysToDel;
-		err = oldKeys.diff(newKeys, keysToDel);
+		// put the keys that are only in the new set, del the ones only in the old
+		// and notify on the union of both
+		KeyVec keysToPut;
+		KeyVec keysToDel;
+		KeyVec allKeys;
+		err = diffKeys(newKeys, oldKeys, keysToPut, keysToDel, allKeys);
 		MojErrCheck(err);
 		err = delKeys(oldShardId, keysToDel, txn, forcedel);
 		MojErrCheck(err);
@@ -351,12 +560,8 @@ MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojD
 			this->name().data(), oldKeys.size(), newKeys.size(), keysToDel.size(), keysToPut.size(), (int)err);
 
 		MojErrCheck(err);
-		// notify on union of old and new keys
-		err = newKeys.put(oldKeys);
+		err = addPendingKeys(allKeys, *txn);
 		MojErrCheck(err);
-		err = addPendingKeys(newKeys, *txn);
-		MojErrCheck(err);
-	
 	}
 	return MojErrNone;
 }
@@ -473,6 +678,74 @@ bool MojDbIndex::canAnswer(const MojDbQuery& query) const
 	return false;
 }
 
+MojDouble MojDbIndex::scanCost(const MojDbQuery& query, MojDouble& rowsOut) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(canAnswer(query));
+
+	// Walk the props the same way canAnswer does: a run of equality props narrows
+	// the scan to one key prefix, and an optional trailing inequality narrows it further.
+	const MojDbQuery::WhereMap& map = query.where();
+	MojSize start = 0;
+	if (m_includeDeleted && !map.contains(MojDb::DelKey))
+		start = 1;
+	MojSize depth = start;
+	MojDouble multiplier = 1;
+	for (StringVec::ConstIterator propName = m_propNames.begin() + start;
+		 propName != m_propNames.end(); ++propName) {
+		MojDbQuery::WhereMap::ConstIterator mapIter = map.find(*propName);
+		if (mapIter == map.end())
+			break;
+		if (mapIter->lowerOp() != MojDbQuery::OpEq) {
+			multiplier = RangeSelectivity;
+			break;
+		}
+		// an array value is a set of equality ranges
+		if (mapIter->lowerVal().type() == MojObject::TypeArray)
+			multiplier *= (MojDouble) mapIter->lowerVal().size();
+		++depth;
+	}
+
+	MojDouble rows = (MojDouble) m_stats.keyCount();
+	if (rows < 1)
+		rows = 1;
+	MojDouble lowerDistinct = m_stats.distinct(start);
+	MojDouble upperDistinct = m_stats.distinct(depth);
+	if (depth > start) {
+		if (lowerDistinct > 0 && upperDistinct > 0) {
+			MojDouble selectivity = lowerDistinct / upperDistinct;
+			rows *= (selectivity < 1) ? selectivity : 1;
+		} else {
+			for (MojSize i = start; i < depth; ++i)
+				rows *= DefaultEqSelectivity;
+		}
+	}
+	rows *= multiplier;
+	if (rows < 1)
+		rows = 1;
+
+	MojDouble keySize = m_stats.avgKeySize();
+	if (keySize == 0)
+		keySize = DefaultPropSize * (MojDouble) m_props.size();
+
+	rowsOut = rows;
+	return rows * (RowCost + keySize * KeyByteCost);
+}
+
+MojErr MojDbIndex::sampleStats(const MojObject& obj)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(isOpen());
+
+	if (!includeObj(&obj))
+		return MojErrNone;
+	KeyVec keys;
+	MojErr err = getKeys(obj, keys, &m_stats);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbIndex::cancelWatch(MojDbWatcher* watcher)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -487,6 +760,12 @@ MojErr MojDbIndex::cancelWatch(MojDbWatcher* watcher)
 	MojSize size = m_watcherVec.size();
 	for (idx = 0; idx < size; ++idx) {
 		if (m_watcherVec.at(idx).get() == watcher) {
+			// ranges were handed to the watcher in addWatch and never change
+			for (const MojDbKeyRange& range : watcher->ranges()) {
+				bool found = m_watcherTree.del(range, watcher);
+				MojAssert(found);
+				MojUnused(found);
+			}
 			MojErr err = m_watcherVec.erase(idx);
 			MojErrCheck(err);
 			WatcherMap::Iterator iter;
@@ -592,28 +871,53 @@ MojErr MojDbIndex::addWatch(const MojDbQueryPlan& plan, MojDbCursor& cursor, Moj
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(watcher);
 
-	// TODO: use interval tree instead of vector for watches
 	MojThreadWriteGuard guard(m_lock);
-	MojErr err = m_watcherVec.push(watcher);
-	MojErrCheck(err);
-	// update count map
-	watcher->domain(req.domain());
+	// the count map entry is made first, it is the only step left that can fail
+	// once the watcher is registered
 	WatcherMap::Iterator iter;
-	err = m_watcherMap.find(req.domain(), iter);
+	MojErr err = m_watcherMap.find(req.domain(), iter);
 	MojErrCheck(err);
 	if (iter == m_watcherMap.end()) {
-		err = m_watcherMap.put(req.domain(), 1);
+		err = m_watcherMap.put(req.domain(), 0);
 		MojErrCheck(err);
-	} else {
-		iter.value() += 1;
-		if (iter.value() > WatchWarningThreshold) {
-            LOG_WARNING(MSGID_MOJ_DB_INDEX_WARNING, 4,
-            		PMLOGKS("domain", req.domain().data()),
-            		PMLOGKFV("iter", "%zd", iter.value()),
-            		PMLOGKS("kindId", m_kind->id().data()),
-            		PMLOGKS("name", m_name.data()),
-            		"db:'domain' has 'iter' watches open on index 'kindId - name'");
+		err = m_watcherMap.find(req.domain(), iter);
+		MojErrCheck(err);
+	}
+	// cancelWatch only knows the ranges init hands over below, so ranges put in
+	// the tree before a failure are taken out again here
+	const MojDbQueryPlan::RangeVec& ranges = plan.ranges();
+	MojSize inserted = 0;
+	while (inserted < ranges.size()) {
+		err = m_watcherTree.put(ranges.at(inserted), watcher, plan.desc());
+		if (err != MojErrNone)
+			break;
+		++inserted;
+	}
+	if (err == MojErrNone)
+		err = m_watcherVec.push(watcher);
+	if (err != MojErrNone) {
+		while (inserted > 0) {
+			bool found = m_watcherTree.del(ranges.at(--inserted), watcher);
+			MojAssert(found);
+			MojUnused(found);
+		}
+		if (iter.value() == 0) {
+			bool found = false;
+			MojErr delErr = m_watcherMap.del(iter.key(), found);
+			MojErrCatchAll(delErr);
 		}
+		MojErrThrow(err);
+	}
+	// update count map
+	watcher->domain(req.domain());
+	iter.value() += 1;
+	if (iter.value() > WatchWarningThreshold) {
+        LOG_WARNING(MSGID_MOJ_DB_INDEX_WARNING, 4,
+        		PMLOGKS("domain", req.domain().data()),
+        		PMLOGKFV("iter", "%zd", iter.value()),
+        		PMLOGKS("kindId", m_kind->id().data()),
+        		PMLOGKS("name", m_name.data()),
+        		"db:'domain' has 'iter' watches open on index 'kindId - name'");
 	}
 	LOG_DEBUG("[db_mojodb] DbIndex_addWatch - '%s' on index '%s - %s'",
 		req.domain().data(),  m_kind->id().data(), m_name.data());
@@ -627,7 +931,7 @@ MojErr MojDbIndex::addWatch(const MojDbQueryPlan& plan, MojDbCursor& cursor, Moj
 	return MojErrNone;
 }
 
-MojErr MojDbIndex::addPendingKeys(const KeySet& keys, MojDbStorageTxn& txn)
+MojErr MojDbIndex::addPendingKeys(const KeyVec& keys, MojDbStorageTxn& txn)
 {
     MojThreadWriteGuard guard(m_lock);
     decltype(m_pendingKeys)::Iterator it;
@@ -635,14 +939,78 @@ MojErr MojDbIndex::addPendingKeys(const KeySet& keys, MojDbStorageTxn& txn)
     MojErrCheck(err);
     if (it == m_pendingKeys.end())
     {
-        err = m_pendingKeys.put(&txn, keys);
+        err = m_pendingKeys.put(&txn, KeySet());
+        MojErrCheck(err);
+        err = m_pendingKeys.find(&txn, it);
         MojErrCheck(err);
     }
-    else
+    // a key written twice by the txn is only matched against the watchers once
+    err = it.value().put(keys.begin(), keys.end());
+    MojErrCheck(err);
+    guard.unlock();
+
+    err = txn.subscribe(*this);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+MojErr MojDbIndex::addUnkeyed(MojDbStorageTxn& txn, bool& watchedOut)
+{
+    // checked under the same lock that addWatch takes, so a watch added after
+    // this point is caught by the unkeyed flag in committed()
+    MojThreadWriteGuard guard(m_lock);
+    watchedOut = !m_watcherVec.empty();
+    if (watchedOut)
+        return MojErrNone;
+
+    MojErr err = m_unkeyedTxns.put(&txn);
+    MojErrCheck(err);
+    guard.unlock();
+
+    err = txn.subscribe(*this);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+MojErr MojDbIndex::addUnkeyedAll(MojDbStorageTxn& txn)
+{
+    // keys taken out wholesale by a drop or a range delete aren't known one by
+    // one, so every watcher of the index is fired once the txn commits
+    MojThreadWriteGuard guard(m_lock);
+    MojErr err = m_unkeyedTxns.put(&txn);
+    MojErrCheck(err);
+    guard.unlock();
+
+    err = txn.subscribe(*this);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+MojErr MojDbIndex::addPendingStats(MojDbStorageTxn& txn, MojInt64 count, MojInt64 size, bool reset)
+{
+    // an aborted txn never reaches committed(), so its keys never touch m_stats
+    MojThreadWriteGuard guard(m_lock);
+    decltype(m_pendingStats)::Iterator it;
+    MojErr err = m_pendingStats.find(&txn, it);
+    MojErrCheck(err);
+    if (it == m_pendingStats.end())
     {
-        err = it->put(keys);
+        err = m_pendingStats.put(&txn, StatsDelta());
         MojErrCheck(err);
+        err = m_pendingStats.find(&txn, it);
+        MojErrCheck(err);
+    }
+    StatsDelta& delta = it.value();
+    if (reset)
+    {
+        delta = StatsDelta();
+        delta.m_reset = true;
     }
+    delta.m_count += count;
+    delta.m_size += size;
     guard.unlock();
 
     err = txn.subscribe(*this);
@@ -651,14 +1019,20 @@ MojErr MojDbIndex::addPendingKeys(const KeySet& keys, MojDbStorageTxn& txn)
     return MojErrNone;
 }
 
-MojErr MojDbIndex::delKeys(MojDbShardId shardId, const KeySet& keys, MojDbStorageTxn* txn, bool forcedel)
+MojErr MojDbIndex::delKeys(MojDbShardId shardId, const KeyVec& keys, MojDbStorageTxn* txn, bool forcedel)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
 	int count = 0;
-	for (KeySet::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
+	MojInt64 removed = 0;
+	MojInt64 removedSize = 0;
+	for (KeyVec::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
 
 		MojErr err = m_index->del(shardId, *i, txn);
+		if (err == MojErrNone) {
+			++removed;
+			removedSize += (MojInt64) i->size();
+		}
 #if defined(MOJ_DEBUG_LOGGING)
 		char s[1024];
 		char *s2 = NULL;
@@ -684,16 +1058,21 @@ MojErr MojDbIndex::delKeys(MojDbShardId shardId, const KeySet& keys, MojDbStorag
 		MojErrCheck(err);
 		count++;
 	}
+	if (removed > 0) {
+		MojErr err = addPendingStats(*txn, -removed, -removedSize);
+		MojErrCheck(err);
+	}
 
 	return MojErrNone;
 }
 
-MojErr MojDbIndex::insertKeys(MojDbShardId shardId, const KeySet& keys, MojDbStorageTxn* txn)
+MojErr MojDbIndex::insertKeys(MojDbShardId shardId, const KeyVec& keys, MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
 	int count = 0;
-	for (KeySet::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
+	MojInt64 addedSize = 0;
+	for (KeyVec::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
 
 		MojErr err = m_index->insert(shardId, *i, txn);
 #if defined(MOJ_DEBUG_LOGGING)
@@ -706,13 +1085,18 @@ MojErr MojDbIndex::insertKeys(MojDbShardId shardId, const KeySet& keys, MojDbSto
         LOG_DEBUG("[db_mojodb] insertKey %d for: %s; key= %s ; err= %d\n", count+1, this->m_name.data(), s, err);
 #endif
 		MojErrCheck(err);
+		addedSize += (MojInt64) i->size();
 		count ++;
 	}
+	if (count > 0) {
+		MojErr err = addPendingStats(*txn, count, addedSize);
+		MojErrCheck(err);
+	}
 
 	return MojErrNone;
 }
 
-MojErr MojDbIndex::getKeys(const MojObject& obj, KeySet& keysOut) const
+MojErr MojDbIndex::getKeys(const MojObject& obj, KeyVec& keysOut, MojDbIndexStats* statsOut) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -721,12 +1105,18 @@ MojErr MojDbIndex::getKeys(const MojObject& obj, KeySet& keysOut) const
 	MojErr err = builder.push(m_idSet);
 	MojErrCheck(err);
 	MojSize idx = 0;
+	MojUInt32 prefixHash = 0;
 	for (PropVec::ConstIterator i = m_props.begin();
 		 i != m_props.end();
 		 ++i, ++idx) {
 		KeySet vals;
 		err = (*i)->vals(obj, vals);
 		MojErrCheck(err);
+		// feed distinct-prefix estimates (multi-valued props contribute their first value)
+		if (statsOut && idx < MojDbIndexStats::MaxDepth && !vals.empty()) {
+			prefixHash = MojDbIndexStats::combine(prefixHash, *vals.begin());
+			statsOut->prefix(idx + 1, prefixHash);
+		}
 		err = builder.push(vals);
 		MojErrCheck(err);
 	}
@@ -736,13 +1126,179 @@ MojErr MojDbIndex::getKeys(const MojObject& obj, KeySet& keysOut) const
 	return MojErrNone;
 }
 
-MojErr MojDbIndex::handlePreCommit(MojDbStorageTxn* txn)
+MojErr MojDbIndex::rangeKey(const MojObject& vals, MojDbKey& keyOut) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojErr err = m_kind->kindEngine()->db()->quotaEngine()->curKind(m_kind, txn);
+	// same layout as getKeys: index id followed by one value per prop
+	MojErr err = keyOut.assign(m_id);
+	MojErrCheck(err);
+	MojSize idx = 0;
+	for (MojObject::ConstArrayIterator i = vals.arrayBegin(); i != vals.arrayEnd(); ++i, ++idx) {
+		// collated keys depend on the locale, callers only ever range over plain values
+		if (idx >= m_props.size() || m_props.at(idx)->collation() != MojDbCollationInvalid)
+			MojErrThrow(MojErrNotImplemented);
+		MojDbKey key;
+		err = key.assign(*i);
+		MojErrCheck(err);
+		err = keyOut.byteVec().append(key.data(), key.data() + key.size());
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::getKeys(const MojObject& obj, const MojObject& prevObj, const StringVec& changed,
+		KeyVec& keysOut, KeyVec& prevKeysOut, MojDbIndexStats* statsOut) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// props that didn't change reuse the vals extracted from obj, so unchanged
+	// text is only tokenized once
+	MojDbKeyBuilder builder;
+	MojErr err = builder.push(m_idSet);
+	MojErrCheck(err);
+	MojDbKeyBuilder prevBuilder;
+	err = prevBuilder.push(m_idSet);
+	MojErrCheck(err);
+	MojSize idx = 0;
+	MojUInt32 prefixHash = 0;
+	for (PropVec::ConstIterator i = m_props.begin();
+		 i != m_props.end();
+		 ++i, ++idx) {
+		KeySet vals;
+		err = (*i)->vals(obj, vals);
+		MojErrCheck(err);
+		if (statsOut && idx < MojDbIndexStats::MaxDepth && !vals.empty()) {
+			prefixHash = MojDbIndexStats::combine(prefixHash, *vals.begin());
+			statsOut->prefix(idx + 1, prefixHash);
+		}
+		err = builder.push(vals);
+		MojErrCheck(err);
+		if ((*i)->touched(changed)) {
+			KeySet prevVals;
+			err = (*i)->vals(prevObj, prevVals);
+			MojErrCheck(err);
+			err = prevBuilder.push(prevVals);
+			MojErrCheck(err);
+		} else {
+			err = prevBuilder.push(vals);
+			MojErrCheck(err);
+		}
+	}
+	err = builder.keys(keysOut);
+	MojErrCheck(err);
+	err = prevBuilder.keys(prevKeysOut);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::diffKeys(const KeyVec& keys, const KeyVec& prevKeys, KeyVec& addedOut,
+		KeyVec& removedOut, KeyVec& unionOut)
+{
+	// both inputs are sorted, so one merge pass gives all three outputs
+	addedOut.clear();
+	removedOut.clear();
+	unionOut.clear();
+	MojErr err = unionOut.reserve(keys.size() + prevKeys.size());
 	MojErrCheck(err);
-	err = build(txn);
+	KeyVec::ConstIterator i = keys.begin();
+	KeyVec::ConstIterator prev = prevKeys.begin();
+	while (i != keys.end() || prev != prevKeys.end()) {
+		int comp;
+		if (i == keys.end()) {
+			comp = 1;
+		} else if (prev == prevKeys.end()) {
+			comp = -1;
+		} else {
+			comp = i->compare(*prev);
+		}
+		if (comp < 0) {
+			err = addedOut.push(*i);
+			MojErrCheck(err);
+			err = unionOut.push(*i);
+			MojErrCheck(err);
+			++i;
+		} else if (comp > 0) {
+			err = removedOut.push(*prev);
+			MojErrCheck(err);
+			err = unionOut.push(*prev);
+			MojErrCheck(err);
+			++prev;
+		} else {
+			err = unionOut.push(*i);
+			MojErrCheck(err);
+			++i;
+			++prev;
+		}
+	}
+	return MojErrNone;
+}
+
+bool MojDbIndex::touched(const StringVec& changed) const
+{
+	for (PropVec::ConstIterator i = m_props.begin(); i != m_props.end(); ++i) {
+		if ((*i)->touched(changed))
+			return true;
+	}
+	return false;
+}
+
+MojErr MojDbIndex::changedProps(const MojObject& obj, const MojObject& prevObj, StringVec& propsOut)
+{
+	// props are kept sorted, so walk both objects side by side
+	propsOut.clear();
+	MojObject::ConstIterator objIter = obj.begin();
+	MojObject::ConstIterator prevIter = prevObj.begin();
+	while (objIter != obj.end() || prevIter != prevObj.end()) {
+		int comp;
+		if (objIter == obj.end()) {
+			comp = 1;
+		} else if (prevIter == prevObj.end()) {
+			comp = -1;
+		} else {
+			comp = objIter.key().compare(prevIter.key());
+		}
+		if (comp > 0) {
+			MojErr err = propsOut.push(prevIter.key());
+			MojErrCheck(err);
+			++prevIter;
+		} else if (comp < 0) {
+			MojErr err = propsOut.push(objIter.key());
+			MojErrCheck(err);
+			++objIter;
+		} else {
+			if (objIter.value() != prevIter.value()) {
+				MojErr err = propsOut.push(objIter.key());
+				MojErrCheck(err);
+			}
+			++prevIter;
+			++objIter;
+		}
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::handlePreCommit(MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+#ifdef LMDB_ENGINE_SUPPORT
+	if (!m_kindEngine->db()->isDbAppLockingEnabled()) {
+		// without the schema lock nothing keeps writers away from a background chunk
+		MojThreadWriteGuard guard(m_lock);
+		m_building = false;
+		guard.unlock();
+		MojErr err = m_kind->kindEngine()->db()->quotaEngine()->curKind(m_kind, txn);
+		MojErrCheck(err);
+		err = build(txn);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+#endif
+	MojDbReq adminRequest(true);
+	adminRequest.txn(txn);
+	MojErr err = backfill(adminRequest);
 	MojErrCheck(err);
 
 	return MojErrNone;
@@ -752,57 +1308,107 @@ MojErr MojDbIndex::handlePostCommit(MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	m_ready = true;
+	// still under the lock of the committing request, so writers see the new watermark
+	// together with the keys it covers
+	MojThreadWriteGuard guard(m_lock);
+	if (m_chunkPending) {
+		m_chunkPending = false;
+		if (!m_chunkId.null()) {
+			m_buildId = m_chunkId;
+			MojErr err = m_buildKey.assign(m_buildId);
+			MojErrCheck(err);
+		}
+		m_built += m_chunkCount;
+		if (m_chunkDone)
+			m_building = false;
+	}
+	bool building = m_building;
+	guard.unlock();
+	if (building) {
+		MojErr err = m_kindEngine->db()->indexBuilder()->add(this);
+		MojErrCheck(err);
+	} else {
+		m_ready = true;
+	}
 	return MojErrNone;
 }
 
 MojErr MojDbIndex::committed(MojDbStorageTxn& txn)
 {
-    MojThreadReadGuard guard(m_lock); // for observing m_watcherVec
-
-    auto watchers = m_watcherVec;
+    MojThreadWriteGuard guard(m_lock); // for observing m_watcherTree and dropping the txn's entries
 
     struct TriggerInfo
     {
-        MojDbWatcher* watcher; // Unowning reference since we already hold ref-count in watchers
+        MojRefCountedPtr<MojDbWatcher> watcher; // keeps watcher alive once the lock is dropped
         MojDbKey key;
     };
     MojVector<TriggerInfo> triggers;
+    MojMap<MojDbWatcher*, MojSize> triggerIdx;
+
+    // updates that skipped their keys had no watchers to tell, so anyone watching
+    // now started after them and is fired without a key check
+    WatcherVec unkeyed;
+    if (m_unkeyedTxns.contains(&txn))
+    {
+        unkeyed = m_watcherVec;
+    }
 
-    for (const auto& watcher : watchers)
+    decltype(m_pendingStats)::ConstIterator stats = m_pendingStats.find(&txn);
+    if (stats != m_pendingStats.end())
     {
-        for (const auto& range : watcher->ranges())
+        if (stats.value().m_reset)
+            m_stats.totals(0, 0);
+        m_stats.adjust(stats.value().m_count, stats.value().m_size);
+    }
+
+    MojDbKeyRangeTree::EntryVec matches;
+    decltype(m_pendingKeys)::ConstIterator pending = m_pendingKeys.find(&txn);
+    if (pending != m_pendingKeys.end())
+    {
+        for (const auto& key : pending.value())
         {
-            // TODO: add lower/upper bound to MojSet and improve keys intersections check
-            bool foundMatch = false;
-            for (const auto& keySet : m_pendingKeys)
+            matches.clear();
+            MojErr err = m_watcherTree.find(key, matches);
+            MojErrCheck(err);
+
+            for (const auto& match : matches)
             {
-                for (const auto& key : keySet)
-                {
-                    if (range.contains(key))
-                    {
-                        foundMatch = true;
-                        //MojErr err = watcher->fire(key);
-                        //MojErrCheck(err);
-                        MojErr err = triggers.push({watcher.get(), key});
+                // only one fire per watch, with the key nearest to the start of its scan
+                MojMap<MojDbWatcher*, MojSize>::ConstIterator iter = triggerIdx.find(match.watcher);
+                if (iter == triggerIdx.end()) {
+                    err = triggerIdx.put(match.watcher, triggers.size());
+                    MojErrCheck(err);
+                    err = triggers.push({match.watcher, key});
+                    MojErrCheck(err);
+                } else {
+                    const MojDbKey& fireKey = triggers.at(iter.value()).key;
+                    if (match.desc ? key > fireKey : key < fireKey) {
+                        err = triggers.setAt(iter.value(), {match.watcher, key});
                         MojErrCheck(err);
-                        break;
                     }
                 }
-                // only one fire per keySet
-                if (foundMatch) break;
             }
-
-            // only one fire per watch
-            if (foundMatch) break;
         }
     }
 
+    // the txn is done with, destroy() only has to clean up after an abort
+    bool found;
+    MojErr err = m_pendingKeys.del(&txn, found);
+    MojErrCheck(err);
+    err = m_unkeyedTxns.del(&txn, found);
+    MojErrCheck(err);
+    err = m_pendingStats.del(&txn, found);
+    MojErrCheck(err);
     guard.unlock();
 
-    for (auto trigger : triggers)
+    for (auto& trigger : triggers)
     {
-        MojErr err = trigger.watcher->fire(trigger.key);
+        err = trigger.watcher->fire(trigger.key);
+        MojErrCheck(err);
+    }
+    for (auto& watcher : unkeyed)
+    {
+        err = watcher->abandon();
         MojErrCheck(err);
     }
 
@@ -816,6 +1422,10 @@ MojErr MojDbIndex::destroy(MojDbStorageTxn& txn)
     bool found;
     MojErr err = m_pendingKeys.del(&txn, found);
     MojErrCheck(err);
+    err = m_unkeyedTxns.del(&txn, found);
+    MojErrCheck(err);
+    err = m_pendingStats.del(&txn, found);
+    MojErrCheck(err);
 
     return MojErrNone;
 }
@@ -859,6 +1469,73 @@ MojErr MojDbIndex::build(MojDbStorageTxn* txn)
 	return MojErrNone;
 }
 
+MojErr MojDbIndex::backfill(MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(isOpen());
+	MojAssert(m_kind && m_kindEngine);
+
+	m_chunkPending = false;
+	MojDbStorageTxn* txn = req.txn();
+	MojErr err = m_kindEngine->db()->quotaEngine()->curKind(m_kind, txn);
+	MojErrCheck(err);
+
+	// walk the kind in _id order from the watermark, deleted objects are filtered by includeObj
+	MojThreadReadGuard guard(m_lock);
+	MojObject buildId = m_buildId;
+	guard.unlock();
+	MojDbQuery query;
+	err = query.from(m_kind->id());
+	MojErrCheck(err);
+	err = query.includeDeleted();
+	MojErrCheck(err);
+	err = query.order(MojDb::IdKey);
+	MojErrCheck(err);
+	if (!buildId.null()) {
+		err = query.where(MojDb::IdKey, MojDbQuery::OpGreaterThan, buildId);
+		MojErrCheck(err);
+	}
+	MojSize chunkSize = m_kindEngine->db()->indexBuilder()->chunkSize();
+	query.limit((MojUInt32) chunkSize);
+
+	MojDbCursor cursor;
+	err = m_kindEngine->find(query, cursor, NULL, req, OpRead);
+	MojErrCheck(err);
+
+	MojObject lastId = buildId;
+	MojSize count = 0;
+	for (;;) {
+		MojObject obj;
+		bool found = false;
+		err = cursor.get(obj, found);
+		MojErrCheck(err);
+		if (!found)
+			break;
+		err = obj.getRequired(MojDb::IdKey, lastId);
+		MojErrCheck(err);
+		err = updateImpl(&obj, NULL, txn, false, NULL);
+		MojErrCheck(err);
+		++count;
+	}
+	err = cursor.close();
+	MojErrCheck(err);
+
+	bool done = count < chunkSize;
+	if (done) {
+		err = m_kind->state()->delIndexBuild(m_name, req);
+		MojErrCheck(err);
+	} else {
+		err = m_kind->state()->updateIndexBuild(m_name, lastId, req);
+		MojErrCheck(err);
+	}
+	m_chunkId = lastId;
+	m_chunkCount = (MojInt64) count;
+	m_chunkDone = done;
+	m_chunkPending = true;
+
+	return MojErrNone;
+}
+
 MojErr MojDbIndex::abandonWatchers(MojThreadWriteGuard& guard)
 {
     // watchers will be triggered to notify about index drop
@@ -875,7 +1552,9 @@ MojErr MojDbIndex::abandonWatchers(MojThreadWriteGuard& guard)
 
     guard.lock();
     MojAssert(m_watcherVec.size() == 0);
+    MojAssert(m_watcherTree.empty());
     m_watcherVec.clear();
+    m_watcherTree.clear();
 
     if (accErr != MojErrNone) MojErrThrow(accErr);
 
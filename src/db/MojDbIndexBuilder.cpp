@@ -0,0 +1,288 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+
+#include "db/MojDbIndexBuilder.h"
+#include "db/MojDb.h"
+#include "db/MojDbIndex.h"
+#include "db/MojDbReq.h"
+#include "core/MojLogDb8.h"
+
+const MojChar* const MojDbIndexBuilder::ChunkSizeKey = _T("indexBuildChunk");
+
+MojDbIndexBuilder::MojDbIndexBuilder()
+: m_db(NULL),
+  m_thread(MojInvalidThread),
+  m_running(0),
+  m_chunkSize(ChunkSizeDefault),
+  m_stop(false)
+{
+}
+
+MojDbIndexBuilder::~MojDbIndexBuilder()
+{
+	MojErr err = close();
+	MojErrCatchAll(err);
+}
+
+MojErr MojDbIndexBuilder::configure(const MojObject& conf)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojInt64 chunkSize = 0;
+	if (conf.get(ChunkSizeKey, chunkSize)) {
+		if (chunkSize <= 0)
+			MojErrThrowMsg(MojErrInvalidArg, _T("db: %s must be positive"), ChunkSizeKey);
+		m_chunkSize = (MojSize) chunkSize;
+	} else {
+		m_chunkSize = ChunkSizeDefault;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndexBuilder::open(MojDb* db)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(db);
+
+	MojThreadGuard guard(m_mutex);
+	m_db = db;
+	m_stop = false;
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndexBuilder::close()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// unfinished builds are persisted in kind state and resume on next open
+	MojThreadGuard guard(m_mutex);
+	m_stop = true;
+	MojErr err = m_cond.broadcast();
+	MojErrCheck(err);
+	while (m_running > 0) {
+		err = m_cond.wait(m_mutex);
+		MojErrCheck(err);
+	}
+	m_queue.clear();
+	m_retries.clear();
+	m_failures.clear();
+	MojThreadT thread = m_thread;
+	m_thread = MojInvalidThread;
+	guard.unlock();
+
+	if (thread != MojInvalidThread) {
+		MojErr threadErr = MojErrNone;
+		err = MojThreadJoin(thread, threadErr);
+		MojErrAccumulate(err, threadErr);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndexBuilder::add(MojDbIndex* index)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(index);
+
+	MojThreadGuard guard(m_mutex);
+	if (m_stop || !m_db)
+		return MojErrNone;
+
+	MojRefCountedPtr<MojDbIndex> ref(index);
+	for (RetryVec::ConstIterator i = m_retries.begin(); i != m_retries.end(); ++i) {
+		if (i->m_index.get() == index)
+			return MojErrNone;
+	}
+	if (m_queue.find(ref) == MojInvalidIndex) {
+		MojErr err = m_queue.push(ref);
+		MojErrCheck(err);
+	}
+	// start lazily, most dbs never build an index after they are created
+	if (m_thread == MojInvalidThread) {
+		MojErr err = MojThreadCreate(m_thread, &threadMain, this);
+		MojErrCheck(err);
+	}
+	MojErr err = m_cond.broadcast();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndexBuilder::drain()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// help the worker on the calling thread until every pending build is complete
+	MojRefCountedPtr<MojDbIndex> index;
+	while (next(index, false)) {
+		MojErr err = run(index.get());
+		done(index.get(), err);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojSize MojDbIndexBuilder::pending() const
+{
+	MojThreadGuard guard(m_mutex);
+	return m_queue.size() + m_retries.size() + m_running;
+}
+
+MojErr MojDbIndexBuilder::threadMain(void* arg)
+{
+	MojDbIndexBuilder* builder = (MojDbIndexBuilder*) arg;
+	MojAssert(builder);
+
+	MojRefCountedPtr<MojDbIndex> index;
+	while (builder->next(index, true)) {
+		MojErr err = builder->run(index.get());
+		builder->done(index.get(), err);
+	}
+	return MojErrNone;
+}
+
+bool MojDbIndexBuilder::next(MojRefCountedPtr<MojDbIndex>& indexOut, bool wait)
+{
+	MojThreadGuard guard(m_mutex);
+	for (;;) {
+		if (m_stop)
+			return false;
+		// draining callers don't sit out the backoff of failed builds
+		MojTime nextDue;
+		MojErr err = promote(!wait, nextDue);
+		MojErrCatchAll(err);
+		if (!m_queue.empty()) {
+			indexOut = m_queue.front();
+			err = m_queue.erase(0);
+			MojErrCatchAll(err);
+			++m_running;
+			return true;
+		}
+		// draining callers also wait for chunks the worker is in the middle of
+		if (!wait && m_running == 0)
+			return false;
+		if (nextDue > 0) {
+			err = m_cond.timedWait(m_mutex, nextDue);
+			if (err != MojErrTimedOut)
+				MojErrCatchAll(err);
+		} else {
+			err = m_cond.wait(m_mutex);
+			MojErrCatchAll(err);
+		}
+	}
+}
+
+void MojDbIndexBuilder::done(MojDbIndex* index, MojErr buildErr)
+{
+	MojThreadGuard guard(m_mutex);
+	MojAssert(m_running > 0);
+	--m_running;
+	if (buildErr == MojErrNone) {
+		bool found = false;
+		MojErr err = m_failures.del(index, found);
+		MojErrCatchAll(err);
+	} else if (!m_stop) {
+		MojErr err = retry(index, buildErr);
+		MojErrCatchAll(err);
+	}
+	MojErr err = m_cond.broadcast();
+	MojErrCatchAll(err);
+}
+
+MojErr MojDbIndexBuilder::retry(MojDbIndex* index, MojErr buildErr)
+{
+	// the failed chunk rolled back, so the build picks up again at the persisted watermark
+	MojUInt32 failures = 0;
+	m_failures.get(index, failures);
+	++failures;
+	if (failures > RetryMax) {
+		// leave the index unready, the build resumes from its last chunk on next open
+		LOG_ERROR(MSGID_DB_ERROR, 3,
+			PMLOGKS("index", index->name().data()),
+			PMLOGKFV("error", "%d", (int) buildErr),
+			PMLOGKFV("failures", "%u", failures),
+			"index build given up");
+		bool found = false;
+		MojErr err = m_failures.del(index, found);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	LOG_WARNING(MSGID_MOJ_DB_WARNING, 3,
+		PMLOGKS("index", index->name().data()),
+		PMLOGKFV("error", "%d", (int) buildErr),
+		PMLOGKFV("failures", "%u", failures),
+		"index build chunk failed, retrying");
+	MojErr err = m_failures.put(index, failures);
+	MojErrCheck(err);
+
+	Retry entry;
+	entry.m_index.reset(index);
+	err = MojGetCurrentTime(entry.m_due);
+	MojErrCheck(err);
+	entry.m_due += MojMillisecs(RetryDelayMs << (failures - 1));
+	err = m_retries.push(entry);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndexBuilder::promote(bool all, MojTime& nextDueOut)
+{
+	nextDueOut = 0;
+	if (m_retries.empty())
+		return MojErrNone;
+
+	MojTime now;
+	MojErr err = MojGetCurrentTime(now);
+	MojErrCheck(err);
+	for (MojSize i = 0; i < m_retries.size(); ) {
+		const Retry& entry = m_retries.at(i);
+		if (all || entry.m_due <= now) {
+			if (m_queue.find(entry.m_index) == MojInvalidIndex) {
+				err = m_queue.push(entry.m_index);
+				MojErrCheck(err);
+			}
+			err = m_retries.erase(i);
+			MojErrCheck(err);
+		} else {
+			if (nextDueOut == 0 || entry.m_due < nextDueOut)
+				nextDueOut = entry.m_due;
+			++i;
+		}
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndexBuilder::run(MojDbIndex* index)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(index && m_db);
+
+	// the schema lock keeps writers out while the chunk is built, so nothing
+	// can slip between the objects read and the watermark that covers them
+	MojDbReq req;
+	MojErr err = req.begin(m_db, true);
+	MojErrCheck(err);
+	err = index->buildChunk(req);
+	MojErrCheck(err);
+	err = req.end();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
@@ -0,0 +1,222 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "db/MojDbIndexStats.h"
+#include "core/MojUtil.h"
+#include <cmath>
+
+const MojChar* const MojDbIndexStats::KeysKey = _T("keys");
+const MojChar* const MojDbIndexStats::AvgKeySizeKey = _T("avgKeySize");
+const MojChar* const MojDbIndexStats::DistinctKey = _T("distinct");
+const MojChar* const MojDbIndexStats::BytesKey = _T("bytes");
+const MojChar* const MojDbIndexStats::RegistersKey = _T("registers");
+
+MojDbIndexStats::MojDbIndexStats()
+: m_seeded(false),
+  m_keyCount(0),
+  m_keyBytes(0)
+{
+	reset();
+}
+
+void MojDbIndexStats::reset()
+{
+	for (MojSize depth = 0; depth < MaxDepth; ++depth) {
+		for (MojSize i = 0; i < NumRegisters; ++i)
+			m_registers[depth][i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void MojDbIndexStats::totals(MojSize count, MojSize size)
+{
+	m_keyCount.store((MojInt64) count, std::memory_order_relaxed);
+	m_keyBytes.store((MojInt64) size, std::memory_order_relaxed);
+	m_seeded.store(true, std::memory_order_release);
+}
+
+void MojDbIndexStats::adjust(MojInt64 count, MojInt64 size)
+{
+	add(m_keyCount, count);
+	add(m_keyBytes, size);
+}
+
+void MojDbIndexStats::prefix(MojSize depth, MojUInt32 hash)
+{
+	MojAssert(depth > 0);
+	if (depth > MaxDepth)
+		return;
+
+	// first bits pick the register, the rest give the rank
+	MojSize reg = hash >> (32 - RegisterBits);
+	MojUInt32 rest = hash << RegisterBits;
+	MojByte rank = 1;
+	while (rest && !(rest & 0x80000000)) {
+		rest <<= 1;
+		++rank;
+	}
+	if (!rest)
+		rank = (MojByte) (32 - RegisterBits + 1);
+
+	// registers only grow, once one is high enough no write is needed
+	std::atomic<MojByte>& cur = m_registers[depth - 1][reg];
+	MojByte old = cur.load(std::memory_order_relaxed);
+	while (rank > old && !cur.compare_exchange_weak(old, rank, std::memory_order_relaxed))
+		;
+}
+
+MojSize MojDbIndexStats::keyCount() const
+{
+	return (MojSize) m_keyCount.load(std::memory_order_relaxed);
+}
+
+MojDouble MojDbIndexStats::avgKeySize() const
+{
+	MojInt64 count = m_keyCount.load(std::memory_order_relaxed);
+	if (count == 0)
+		return 0;
+	return (MojDouble) m_keyBytes.load(std::memory_order_relaxed) / (MojDouble) count;
+}
+
+MojDouble MojDbIndexStats::distinct(MojSize depth) const
+{
+	if (depth == 0)
+		return 1;
+	if (depth > MaxDepth)
+		return 0;
+
+	return estimate(depth);
+}
+
+MojErr MojDbIndexStats::toObject(MojObject& objOut) const
+{
+	MojErr err = objOut.put(KeysKey, (MojInt64) keyCount());
+	MojErrCheck(err);
+	err = objOut.putDecimal(AvgKeySizeKey, MojDecimal(avgKeySize()));
+	MojErrCheck(err);
+
+	MojObject distinctArr(MojObject::TypeArray);
+	for (MojSize depth = 1; depth <= MaxDepth; ++depth) {
+		MojDouble val = distinct(depth);
+		if (val == 0)
+			break;
+		err = distinctArr.push((MojInt64) val);
+		MojErrCheck(err);
+	}
+	err = objOut.put(DistinctKey, distinctArr);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndexStats::save(MojObject& objOut) const
+{
+	MojErr err = objOut.put(KeysKey, (MojInt64) keyCount());
+	MojErrCheck(err);
+	err = objOut.put(BytesKey, m_keyBytes.load(std::memory_order_relaxed));
+	MojErrCheck(err);
+
+	// one char per register, ranks never exceed 27 so they stay printable
+	MojObject registers(MojObject::TypeArray);
+	for (MojSize depth = 0; depth < MaxDepth; ++depth) {
+		MojChar regs[NumRegisters];
+		for (MojSize i = 0; i < NumRegisters; ++i)
+			regs[i] = (MojChar) (_T('0') + m_registers[depth][i].load(std::memory_order_relaxed));
+		MojString str;
+		err = str.assign(regs, NumRegisters);
+		MojErrCheck(err);
+		err = registers.pushString(str.data());
+		MojErrCheck(err);
+	}
+	err = objOut.put(RegistersKey, registers);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndexStats::restore(const MojObject& obj)
+{
+	MojInt64 count = 0;
+	MojInt64 bytes = 0;
+	MojObject registers;
+	if (!obj.get(KeysKey, count) || !obj.get(BytesKey, bytes) || count < 0 || bytes < 0 ||
+		!obj.get(RegistersKey, registers) || registers.type() != MojObject::TypeArray ||
+		registers.size() != MaxDepth)
+		MojErrThrowMsg(MojErrDbInvalidIndex, _T("db: malformed index stats"));
+
+	MojSize depth = 0;
+	for (MojObject::ConstArrayIterator i = registers.arrayBegin(); i != registers.arrayEnd(); ++i, ++depth) {
+		MojString str;
+		MojErr err = i->stringValue(str);
+		MojErrCheck(err);
+		if (str.length() != NumRegisters)
+			MojErrThrowMsg(MojErrDbInvalidIndex, _T("db: malformed index stats"));
+		for (MojSize j = 0; j < NumRegisters; ++j) {
+			MojChar c = str.at(j);
+			if (c < _T('0') || c > (MojChar) (_T('0') + 32 - RegisterBits + 1))
+				MojErrThrowMsg(MojErrDbInvalidIndex, _T("db: malformed index stats"));
+			m_registers[depth][j].store((MojByte) (c - _T('0')), std::memory_order_relaxed);
+		}
+	}
+	totals((MojSize) count, (MojSize) bytes);
+
+	return MojErrNone;
+}
+
+MojUInt32 MojDbIndexStats::combine(MojUInt32 prefixHash, const MojDbKey& val)
+{
+	MojUInt32 h = prefixHash * 31 + MojHash(val.data(), val.size());
+	// finalizer to spread bits, MojHash is weak in the high bits for short keys
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+void MojDbIndexStats::add(std::atomic<MojInt64>& val, MojInt64 delta)
+{
+	// totals collected mid-txn may already be missing what a committing txn removes,
+	// so never go negative
+	MojInt64 old = val.load(std::memory_order_relaxed);
+	while (!val.compare_exchange_weak(old, (old + delta > 0) ? old + delta : 0, std::memory_order_relaxed))
+		;
+}
+
+MojDouble MojDbIndexStats::estimate(MojSize depth) const
+{
+	const std::atomic<MojByte>* regs = m_registers[depth - 1];
+	MojDouble sum = 0;
+	MojSize zeros = 0;
+	for (MojSize i = 0; i < NumRegisters; ++i) {
+		MojByte reg = regs[i].load(std::memory_order_relaxed);
+		sum += std::ldexp(1.0, -(int) reg);
+		if (reg == 0)
+			++zeros;
+	}
+	if (zeros == NumRegisters)
+		return 0;
+
+	const MojDouble m = (MojDouble) NumRegisters;
+	const MojDouble alpha = 0.709; // bias correction for 64 registers
+	MojDouble est = alpha * m * m / sum;
+	if (est <= 2.5 * m && zeros > 0) {
+		// small range correction (linear counting)
+		est = m * std::log(m / (MojDouble) zeros);
+	}
+	return est;
+}
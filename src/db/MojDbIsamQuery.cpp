@@ -259,6 +259,13 @@ void MojDbIsamQuery::init()
 }
 
 bool MojDbIsamQuery::match()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	return inRange(m_keyData, m_keySize);
+}
+
+bool MojDbIsamQuery::inRange(const MojByte* keyData, MojSize keySize)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -268,7 +275,7 @@ bool MojDbIsamQuery::match()
 	if (key.empty())
 		return true;
 	// test for >= when descending, < otherwise
-	int comp = compareKey(key);
+	int comp = MojLexicalCompare(keyData, keySize, key.begin(), key.size());
 	return (comp >= 0) == desc;
 }
 
@@ -396,12 +403,19 @@ MojErr MojDbIsamQuery::saveEndKey()
 }
 
 MojErr MojDbIsamQuery::parseId(MojObject& idOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	return parseId(m_keyData, m_keySize, idOut);
+}
+
+MojErr MojDbIsamQuery::parseId(const MojByte* keyData, MojSize keySize, MojObject& idOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
 	// parse id out of key
 	MojObjectEater eater;
-	MojObjectReader reader(m_keyData, m_keySize);
+	MojObjectReader reader(keyData, keySize);
 	for (MojSize i = 0; i < m_plan->idIndex(); ++i) {
 		MojErr err = reader.nextObject(eater);
 		MojErrCheck(err);
@@ -19,6 +19,7 @@
 #include "db/MojDbTextCollator.h"
 #include "core/MojObjectSerialization.h"
 #include "core/MojLogDb8.h"
+#include <algorithm>
 
 MojErr MojDbKey::assign(const MojObject& obj, MojDbTextCollator* coll)
 {
@@ -132,6 +133,20 @@ MojErr MojDbKeyBuilder::push(const KeySet& vals)
 }
 
 MojErr MojDbKeyBuilder::keys(KeySet& keysOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	keysOut.clear();
+	KeyVec vec;
+	MojErr err = keys(vec);
+	MojErrCheck(err);
+	err = keysOut.put(vec.begin(), vec.end());
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKeyBuilder::keys(KeyVec& keysOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -170,8 +185,7 @@ MojErr MojDbKeyBuilder::keys(KeySet& keysOut)
 				err = vec.append(stackVec.begin(), stackVec.end());
 				MojErrCheck(err);
 			}
-			// add key to output set
-			err = keysOut.put(key);
+			err = keysOut.push(key);
 			MojErrCheck(err);
 			// advance iter in current rec
 			++(pos->m_iter);
@@ -180,5 +194,20 @@ MojErr MojDbKeyBuilder::keys(KeySet& keysOut)
 			++pos;
 		}
 	}
+	// combinations come out in order as long as no encoded val is a prefix of
+	// another val of the same prop, so sorting is rarely needed
+	bool sorted = true;
+	for (MojSize i = 1; i < keysOut.size() && sorted; ++i)
+		sorted = keysOut.at(i - 1) < keysOut.at(i);
+	if (!sorted) {
+		KeyVec::Iterator begin;
+		err = keysOut.begin(begin);
+		MojErrCheck(err);
+		KeyVec::Iterator end = begin + keysOut.size();
+		std::sort(begin, end);
+		MojSize numUnique = (MojSize) (std::unique(begin, end) - begin);
+		err = keysOut.resize(numUnique);
+		MojErrCheck(err);
+	}
 	return MojErrNone;
 }
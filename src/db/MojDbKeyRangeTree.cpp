@@ -0,0 +1,230 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "db/MojDbKeyRangeTree.h"
+
+struct MojDbKeyRangeTree::Node
+{
+	Node(const MojDbKeyRange& range, MojDbWatcher* watcher, bool desc, MojUInt32 priority)
+	: m_range(range), m_priority(priority), m_left(NULL), m_right(NULL), m_maxUpper(NULL)
+	{
+		m_entry.watcher = watcher;
+		m_entry.desc = desc;
+	}
+
+	MojDbKeyRange m_range;
+	Entry m_entry;
+	MojUInt32 m_priority;
+	Node* m_left;
+	Node* m_right;
+	const MojDbKey* m_maxUpper; // greatest upper key in subtree, NULL if any range is unbounded
+};
+
+MojDbKeyRangeTree::MojDbKeyRangeTree()
+: m_root(NULL),
+  m_size(0),
+  m_seed(0x9e3779b9)
+{
+}
+
+MojDbKeyRangeTree::~MojDbKeyRangeTree()
+{
+	clear();
+}
+
+void MojDbKeyRangeTree::clear()
+{
+	destroy(m_root);
+	m_root = NULL;
+	m_size = 0;
+}
+
+MojErr MojDbKeyRangeTree::put(const MojDbKeyRange& range, MojDbWatcher* watcher, bool desc)
+{
+	MojAssert(watcher);
+
+	Node* node = new Node(range, watcher, desc, nextPriority());
+	MojAllocCheck(node);
+	update(node);
+	m_root = insert(m_root, node);
+	++m_size;
+
+	return MojErrNone;
+}
+
+bool MojDbKeyRangeTree::del(const MojDbKeyRange& range, MojDbWatcher* watcher)
+{
+	Node* removed = NULL;
+	m_root = remove(m_root, range, watcher, removed);
+	if (removed == NULL)
+		return false;
+	delete removed;
+	--m_size;
+
+	return true;
+}
+
+MojErr MojDbKeyRangeTree::find(const MojDbKey& key, EntryVec& entriesOut) const
+{
+	return find(m_root, key, entriesOut);
+}
+
+MojUInt32 MojDbKeyRangeTree::nextPriority()
+{
+	// xorshift is plenty to keep the treap balanced
+	m_seed ^= m_seed << 13;
+	m_seed ^= m_seed >> 17;
+	m_seed ^= m_seed << 5;
+	return m_seed;
+}
+
+int MojDbKeyRangeTree::compare(const Node* node, const MojDbKeyRange& range, const MojDbWatcher* watcher)
+{
+	int comp = range.lowerKey().compare(node->m_range.lowerKey());
+	if (comp != 0)
+		return comp;
+	const MojDbKey& upper = range.upperKey();
+	const MojDbKey& nodeUpper = node->m_range.upperKey();
+	if (upper.empty() || nodeUpper.empty()) {
+		comp = (int) upper.empty() - (int) nodeUpper.empty();
+	} else {
+		comp = upper.compare(nodeUpper);
+	}
+	if (comp != 0)
+		return comp;
+	if (watcher == node->m_entry.watcher)
+		return 0;
+	return (watcher < node->m_entry.watcher) ? -1 : 1;
+}
+
+void MojDbKeyRangeTree::update(Node* node)
+{
+	const MojDbKey* maxUpper = node->m_range.upperKey().empty() ? NULL : &node->m_range.upperKey();
+	const Node* children[] = {node->m_left, node->m_right};
+	for (const Node* child : children) {
+		if (child == NULL || maxUpper == NULL)
+			continue;
+		if (child->m_maxUpper == NULL || *maxUpper < *child->m_maxUpper)
+			maxUpper = child->m_maxUpper;
+	}
+	node->m_maxUpper = maxUpper;
+}
+
+MojDbKeyRangeTree::Node* MojDbKeyRangeTree::rotateLeft(Node* node)
+{
+	Node* right = node->m_right;
+	node->m_right = right->m_left;
+	right->m_left = node;
+	update(node);
+	update(right);
+	return right;
+}
+
+MojDbKeyRangeTree::Node* MojDbKeyRangeTree::rotateRight(Node* node)
+{
+	Node* left = node->m_left;
+	node->m_left = left->m_right;
+	left->m_right = node;
+	update(node);
+	update(left);
+	return left;
+}
+
+MojDbKeyRangeTree::Node* MojDbKeyRangeTree::insert(Node* root, Node* node)
+{
+	if (root == NULL)
+		return node;
+
+	if (compare(root, node->m_range, node->m_entry.watcher) < 0) {
+		root->m_left = insert(root->m_left, node);
+		if (root->m_left->m_priority > root->m_priority)
+			return rotateRight(root);
+	} else {
+		root->m_right = insert(root->m_right, node);
+		if (root->m_right->m_priority > root->m_priority)
+			return rotateLeft(root);
+	}
+	update(root);
+	return root;
+}
+
+MojDbKeyRangeTree::Node* MojDbKeyRangeTree::merge(Node* left, Node* right)
+{
+	if (left == NULL)
+		return right;
+	if (right == NULL)
+		return left;
+
+	if (left->m_priority > right->m_priority) {
+		left->m_right = merge(left->m_right, right);
+		update(left);
+		return left;
+	}
+	right->m_left = merge(left, right->m_left);
+	update(right);
+	return right;
+}
+
+MojDbKeyRangeTree::Node* MojDbKeyRangeTree::remove(Node* root, const MojDbKeyRange& range, const MojDbWatcher* watcher, Node*& removedOut)
+{
+	if (root == NULL)
+		return NULL;
+
+	int comp = compare(root, range, watcher);
+	if (comp == 0) {
+		removedOut = root;
+		return merge(root->m_left, root->m_right);
+	}
+	if (comp < 0) {
+		root->m_left = remove(root->m_left, range, watcher, removedOut);
+	} else {
+		root->m_right = remove(root->m_right, range, watcher, removedOut);
+	}
+	update(root);
+	return root;
+}
+
+MojErr MojDbKeyRangeTree::find(const Node* node, const MojDbKey& key, EntryVec& entriesOut)
+{
+	// skip subtrees whose ranges all end at or before key
+	if (node == NULL || (node->m_maxUpper && *node->m_maxUpper <= key))
+		return MojErrNone;
+
+	MojErr err = find(node->m_left, key, entriesOut);
+	MojErrCheck(err);
+	// nodes to the right start no earlier than this one, so they only matter if this one does
+	const MojDbKey& lower = node->m_range.lowerKey();
+	if (lower.empty() || lower <= key) {
+		if (node->m_range.contains(key)) {
+			err = entriesOut.push(node->m_entry);
+			MojErrCheck(err);
+		}
+		err = find(node->m_right, key, entriesOut);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+void MojDbKeyRangeTree::destroy(Node* node)
+{
+	if (node == NULL)
+		return;
+	destroy(node->m_left);
+	destroy(node->m_right);
+	delete node;
+}
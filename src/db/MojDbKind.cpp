@@ -29,6 +29,10 @@ const MojChar* const MojDbKind::IndexesKey = _T("indexes");
 const MojChar* const MojDbKind::NameKey = _T("name");
 const MojChar* const MojDbKind::ObjectsKey = _T("objects");
 const MojChar* const MojDbKind::OwnerKey = _T("owner");
+const MojChar* const MojDbKind::PlanCandidatesKey = _T("candidates");
+const MojChar* const MojDbKind::PlanCostKey = _T("cost");
+const MojChar* const MojDbKind::PlanIndexKey = _T("index");
+const MojChar* const MojDbKind::PlanRowsKey = _T("rows");
 const MojChar* const MojDbKind::HashKey = _T("hash");
 const MojChar* const MojDbKind::PrivateKey = _T("private");
 const MojChar* const MojDbKind::RevisionSetsKey = _T("revSets");
@@ -119,6 +123,10 @@ MojErr MojDbKind::stats(MojObject& objOut, MojSize& usageOut, MojDbReq& req, boo
 	MojSize delCount = 0;
 	MojSize delSize = 0;
 	MojSize warnings = 0;
+	// distinct estimates can't forget deleted values, so rebuild them from this scan
+	for (IndexVec::ConstIterator i = m_indexes.begin(); i != m_indexes.end(); ++i) {
+		(*i)->resetStats();
+	}
 	for (;;) {
 		MojDbStorageItem* item = NULL;
 		bool found = false;
@@ -136,6 +144,10 @@ MojErr MojDbKind::stats(MojObject& objOut, MojSize& usageOut, MojDbReq& req, boo
 		err = item->toObject(obj, *m_kindEngine, true);
 		if (err != MojErrNone)
 			break;
+		for (IndexVec::ConstIterator i = m_indexes.begin(); i != m_indexes.end(); ++i) {
+			err = (*i)->sampleStats(obj);
+			MojErrCheck(err);
+		}
 		bool deleted = false;
 		if (obj.get(MojDb::DelKey, deleted) && deleted) {
 			delSize += item->size();
@@ -279,12 +291,18 @@ MojErr MojDbKind::init(const MojString& id)
 	m_id = id;
 
 #ifdef WITH_SEARCH_QUERY_CACHE
-    m_searchCache = new MojDbSearchCache;
-
     // in unit-tests we may create kinds without MojDbKindEngine
     if (m_kindEngine)
     {
-        m_kindEngine->db()->shardStatusChanged.connect(m_searchCache->shardStatusChanged);
+        m_searchCache = m_kindEngine->db()->searchCache();
+        // update revisions restart from zero for a new kind object, so
+        // entries left by a deleted or replaced kind must not survive
+        err = m_searchCache->destroyCache(m_id);
+        MojErrCheck(err);
+    }
+    else
+    {
+        m_searchCache = new MojDbSearchCache;
     }
 #endif
 	return MojErrNone;
@@ -347,6 +365,7 @@ MojErr MojDbKind::configure(const MojObject& obj, const KindMap& map, const MojS
 	// load state
 	m_state.reset(new MojDbKindState(m_id, m_kindEngine));
 	MojAllocCheck(m_state.get());
+	m_kindEngine->preloadState(m_id, *m_state);
 
 	err = m_state->init(m_schema.strings(), req);
 	MojErrCheck(err);
@@ -368,6 +387,7 @@ MojErr MojDbKind::configure(const MojObject& obj, const KindMap& map, const MojS
 
 	// keep a copy of obj
 	m_obj = obj;
+	m_def = obj;
 
     // get hash key
     MojUInt64 hashKey;
@@ -513,10 +533,16 @@ MojErr MojDbKind::update(MojObject* newObj, const MojObject* oldObj, MojDbOp op,
 	// update revSets and validate schema
 	err = preUpdate(newObj, oldObj, req);
 	MojErrCheck(err);
-	// update indexes
+	// update indexes. changed props are worked out once here, so indexes
+	// of this kind and its supers that don't use them can skip the update
+	StringVec changed;
+	if (newObj && oldObj) {
+		err = MojDbIndex::changedProps(*newObj, *oldObj, changed);
+		MojErrCheck(err);
+	}
 	MojVector<MojDbKind*> kindVec;
 	MojInt32 idxcount = 0;
-	err = updateIndexes(newObj, oldObj, req, op, kindVec, idxcount);
+	err = updateIndexes(newObj, oldObj, req, op, kindVec, idxcount, (newObj && oldObj) ? &changed : NULL);
     LOG_DEBUG("[db_mojodb] Kind_UpdateIndexes_End: %s; supers = %zu; indexcount = %zu; updated = %d \n",
               this->id().data(), m_supers.size(), m_indexes.size(), idxcount);
 
@@ -532,7 +558,9 @@ MojErr MojDbKind::find(MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req
 	MojErr err = checkPermission(op, req);
 	MojErrCheck(err);
 	const MojDbQuery& query = cursor.query();
-	MojDbIndex* index = indexForQuery(query);
+	MojDbIndex* index = NULL;
+	err = planQuery(query, index, query.explain() ? &cursor.m_plan : NULL);
+	MojErrCheck(err);
 	if (index == NULL)
 		MojErrThrow(MojErrDbNoIndexForQuery);
 
@@ -541,6 +569,8 @@ MojErr MojDbKind::find(MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req
         query.order().data(), (int)query.limit());
 	err = index->find(cursor, watcher, req);
 	MojErrCheck(err);
+	// nothing is written through a read cursor, so records fetched ahead stay valid
+	cursor.m_storageQuery->batchJoin(op == OpRead);
 
 	return MojErrNone;
 }
@@ -693,7 +723,8 @@ MojErr MojDbKind::deny(MojDbReq& req)
 	return MojErrNone;
 }
 
-MojErr MojDbKind::updateIndexes(const MojObject* newObj, const MojObject* oldObj, const MojDbReq& req, MojDbOp op, MojVector<MojDbKind*>& kindVec, MojInt32& idxcount)
+MojErr MojDbKind::updateIndexes(const MojObject* newObj, const MojObject* oldObj, const MojDbReq& req, MojDbOp op, MojVector<MojDbKind*>& kindVec, MojInt32& idxcount,
+		const StringVec* changed)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -704,17 +735,18 @@ MojErr MojDbKind::updateIndexes(const MojObject* newObj, const MojObject* oldObj
 	for (KindVec::ConstIterator i = m_supers.begin();
 		 i != m_supers.end(); ++i) {
 		if (kindVec.find((*i), 0) == MojInvalidIndex) {
-			err = (*i)->updateIndexes(newObj, oldObj, req, op, kindVec, idxcount);
+			err = (*i)->updateIndexes(newObj, oldObj, req, op, kindVec, idxcount, changed);
 			MojErrCheck(err);
 		}
 	}
-	err = updateOwnIndexes(newObj, oldObj, req, idxcount);
+	err = updateOwnIndexes(newObj, oldObj, req, idxcount, changed);
 	MojErrCheck(err);
 
 	return MojErrNone;
 }
 
-MojErr MojDbKind::updateOwnIndexes(const MojObject* newObj, const MojObject* oldObj, const MojDbReq& req, MojInt32& idxcount)
+MojErr MojDbKind::updateOwnIndexes(const MojObject* newObj, const MojObject* oldObj, const MojDbReq& req, MojInt32& idxcount,
+		const StringVec* changed)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -722,8 +754,10 @@ MojErr MojDbKind::updateOwnIndexes(const MojObject* newObj, const MojObject* old
 
 	for (IndexVec::ConstIterator i = m_indexes.begin();
 		 i != m_indexes.end(); ++i) {
+		if (req.skipsIndex(i->get()))
+			continue;
 		count++;
-		MojErr err = (*i)->update(newObj, oldObj, req.txn(), req.fixmode());
+		MojErr err = (*i)->update(newObj, oldObj, req.txn(), req.fixmode(), changed);
 		MojErrCheck(err);
 	}
     LOG_DEBUG("[db_mojodb] Kind_UpdateOwnIndexes: %s; count: %d \n", this->id().data(), count);
@@ -888,17 +922,86 @@ MojDbIndex* MojDbKind::indexForQuery(const MojDbQuery& query) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	if (query.m_forceIndex)
-		return query.m_forceIndex;			// for stats verify
-	// check our indexes
+	MojDbIndex* index = NULL;
+	MojErr err = planQuery(query, index, NULL);
+	MojErrCatchAll(err);
+
+	return index;
+}
+
+MojErr MojDbKind::planQuery(const MojDbQuery& query, MojDbIndex*& indexOut, MojObject* planOut) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	indexOut = NULL;
+	if (query.m_forceIndex) {
+		indexOut = query.m_forceIndex;		// for stats verify
+		return MojErrNone;
+	}
+
+	// pick the cheapest of the indexes that can answer the query.
+	// on equal cost the first one in sort order wins. costs are only
+	// comparable once every candidate has stats, until then the first
+	// one that can answer is used as before.
+	MojDouble bestCost = 0;
+	MojDouble bestRows = 0;
+	MojDbIndex* first = NULL;
+	MojDouble firstCost = 0;
+	MojDouble firstRows = 0;
+	bool seeded = true;
+	MojObject candidates(MojObject::TypeArray);
 	for (IndexVec::ConstIterator i = m_indexes.begin();
 		 i != m_indexes.end(); ++i) {
-		if ((*i)->canAnswer(query)) {		// will this always find the best index?
-			return i->get();
+		if (!(*i)->canAnswer(query))
+			continue;
+		MojDouble rows = 0;
+		MojDouble cost = (*i)->scanCost(query, rows);
+		if (!(*i)->hasStats())
+			seeded = false;
+		if (first == NULL) {
+			first = i->get();
+			firstCost = cost;
+			firstRows = rows;
+		}
+		if (planOut) {
+			MojObject candidate;
+			MojErr err = candidate.put(PlanIndexKey, (*i)->name());
+			MojErrCheck(err);
+			err = candidate.putDecimal(PlanCostKey, MojDecimal(cost));
+			MojErrCheck(err);
+			err = candidate.putInt(PlanRowsKey, (MojInt64) rows);
+			MojErrCheck(err);
+			err = candidates.push(candidate);
+			MojErrCheck(err);
 		}
+		if (indexOut == NULL || cost < bestCost) {
+			indexOut = i->get();
+			bestCost = cost;
+			bestRows = rows;
+		}
+	}
+	if (!seeded) {
+		indexOut = first;
+		bestCost = firstCost;
+		bestRows = firstRows;
 	}
-	// not found
-	return NULL;
+
+	if (planOut && indexOut) {
+		MojErr err = planOut->put(NameKey, m_id);
+		MojErrCheck(err);
+		err = planOut->put(PlanIndexKey, indexOut->name());
+		MojErrCheck(err);
+		err = planOut->putDecimal(PlanCostKey, MojDecimal(bestCost));
+		MojErrCheck(err);
+		err = planOut->putInt(PlanRowsKey, (MojInt64) bestRows);
+		MojErrCheck(err);
+		err = planOut->put(PlanCandidatesKey, candidates);
+		MojErrCheck(err);
+	}
+    LOG_DEBUG("[db_mojodb] Dbkind_planQuery: Kind: %s, index: %s, cost: %f, rows: %f \n", m_id.data(),
+        indexOut ? indexOut->name().data() : "none", bestCost, bestRows);
+
+	return MojErrNone;
 }
 
 MojErr MojDbKind::updateSupers(const KindMap& map, const StringVec& superIds, bool updating, MojDbReq& req)
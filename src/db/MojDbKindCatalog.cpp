@@ -0,0 +1,204 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "db/MojDbKindCatalog.h"
+#include "core/MojFile.h"
+#include "core/MojOs.h"
+#include "core/MojLogDb8.h"
+#include <boost/crc.hpp>
+
+const MojChar* const MojDbKindCatalog::FileName = _T("_kindCatalog");
+const MojChar* const MojDbKindCatalog::KindsKey = _T("kinds");
+const MojChar* const MojDbKindCatalog::StatesKey = _T("states");
+const MojChar* const MojDbKindCatalog::TokensKey = _T("tokens");
+const MojChar* const MojDbKindCatalog::IdsKey = _T("ids");
+const MojChar* const MojDbKindCatalog::IndexStatsKey = _T("indexStats");
+const MojChar MojDbKindCatalog::Magic[8] = {'D', 'B', '8', 'K', 'I', 'N', 'D', '\0'};
+
+namespace {
+
+void putUInt32(MojByte* dest, MojUInt32 val)
+{
+	dest[0] = (MojByte) val;
+	dest[1] = (MojByte) (val >> 8);
+	dest[2] = (MojByte) (val >> 16);
+	dest[3] = (MojByte) (val >> 24);
+}
+
+MojUInt32 getUInt32(const MojByte* src)
+{
+	return (MojUInt32) src[0] | ((MojUInt32) src[1] << 8) |
+		((MojUInt32) src[2] << 16) | ((MojUInt32) src[3] << 24);
+}
+
+void putUInt64(MojByte* dest, MojUInt64 val)
+{
+	putUInt32(dest, (MojUInt32) val);
+	putUInt32(dest + 4, (MojUInt32) (val >> 32));
+}
+
+MojUInt64 getUInt64(const MojByte* src)
+{
+	return (MojUInt64) getUInt32(src) | ((MojUInt64) getUInt32(src + 4) << 32);
+}
+
+MojUInt32 checksum(const MojByte* data, MojSize size)
+{
+	boost::crc_32_type crc;
+	crc.process_bytes(data, size);
+	return (MojUInt32) crc.checksum();
+}
+
+MojErr readBytes(MojFile& file, MojByte* data, MojSize size, MojSize& sizeOut)
+{
+	sizeOut = 0;
+	while (sizeOut < size) {
+		MojSize read = 0;
+		MojErr err = file.read(data + sizeOut, size - sizeOut, read);
+		MojErrCheck(err);
+		if (read == 0)
+			break;
+		sizeOut += read;
+	}
+	return MojErrNone;
+}
+
+MojErr writeBytes(MojFile& file, const MojByte* data, MojSize size)
+{
+	while (size > 0) {
+		MojSize written = 0;
+		MojErr err = file.write(data, size, written);
+		MojErrCheck(err);
+		data += written;
+		size -= written;
+	}
+	return MojErrNone;
+}
+
+}
+
+MojErr MojDbKindCatalog::read(const MojChar* dir, MojObject& catalogOut, MojInt64& revOut, bool& foundOut)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(dir);
+
+	foundOut = false;
+	revOut = 0;
+	catalogOut.clear();
+
+	MojString path;
+	MojErr err = path.format(_T("%s/%s"), dir, FileName);
+	MojErrCheck(err);
+	MojFile file;
+	err = file.open(path, MOJ_O_RDONLY);
+	MojErrCatch(err, MojErrNotFound) {
+		return MojErrNone;
+	}
+	MojErrCheck(err);
+
+	MojByte header[HeaderSize];
+	MojSize read = 0;
+	err = readBytes(file, header, sizeof(header), read);
+	MojErrCheck(err);
+	if (read != sizeof(header) || MojMemCmp(header, Magic, sizeof(Magic)) != 0)
+		MojErrThrowMsg(MojErrFormat, _T("db: '%s' is not a kind catalog"), path.data());
+	MojUInt32 version = getUInt32(header + sizeof(Magic));
+	if (version != Version)
+		MojErrThrowMsg(MojErrDbHeaderVersionMismatch, _T("db: unsupported kind catalog version %u"), version);
+
+	MojInt64 rev = (MojInt64) getUInt64(header + sizeof(Magic) + 4);
+	MojUInt32 size = getUInt32(header + sizeof(Magic) + 12);
+	MojObject::ByteVec payload;
+	err = payload.resize(size);
+	MojErrCheck(err);
+	MojObject::ByteVec::Iterator data;
+	err = payload.begin(data);
+	MojErrCheck(err);
+	err = readBytes(file, data, size, read);
+	MojErrCheck(err);
+	if (read != size)
+		MojErrThrowMsg(MojErrUnexpectedEof, _T("db: truncated kind catalog"));
+	if (checksum(data, size) != getUInt32(header + sizeof(Magic) + 16))
+		MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: kind catalog checksum mismatch"));
+
+	err = catalogOut.fromBytes(data, size);
+	MojErrCheck(err);
+	revOut = rev;
+	foundOut = true;
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindCatalog::write(const MojChar* dir, const MojObject& catalog, MojInt64 rev)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(dir);
+
+	MojObject::ByteVec payload;
+	MojErr err = catalog.toBytes(payload);
+	MojErrCheck(err);
+
+	MojByte header[HeaderSize];
+	MojMemCpy(header, Magic, sizeof(Magic));
+	putUInt32(header + sizeof(Magic), Version);
+	putUInt64(header + sizeof(Magic) + 4, (MojUInt64) rev);
+	putUInt32(header + sizeof(Magic) + 12, (MojUInt32) payload.size());
+	putUInt32(header + sizeof(Magic) + 16, checksum(payload.begin(), payload.size()));
+
+	// written aside and renamed, so a crash never leaves a partial catalog behind
+	MojChar nameTemplate[] = _T("_tmpKindCatalog_XXXXXX");
+	MojString tmpPath;
+	err = tmpPath.format(_T("%s/%s"), dir, MojMkTemp(nameTemplate));
+	MojErrCheck(err);
+	MojString path;
+	err = path.format(_T("%s/%s"), dir, FileName);
+	MojErrCheck(err);
+
+	MojFile file;
+	err = file.open(tmpPath, MOJ_O_WRONLY | MOJ_O_CREAT | MOJ_O_TRUNC, MOJ_S_IRUSR | MOJ_S_IWUSR);
+	MojErrCheck(err);
+	err = writeBytes(file, header, sizeof(header));
+	if (err == MojErrNone)
+		err = writeBytes(file, payload.begin(), payload.size());
+	if (err == MojErrNone)
+		err = file.sync();
+	MojErr errClose = file.close();
+	MojErrAccumulate(err, errClose);
+	if (err == MojErrNone)
+		err = MojFileRename(tmpPath, path);
+	if (err != MojErrNone) {
+		(void) MojUnlink(tmpPath);
+		MojErrThrow(err);
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindCatalog::remove(const MojChar* dir)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(dir);
+
+	MojString path;
+	MojErr err = path.format(_T("%s/%s"), dir, FileName);
+	MojErrCheck(err);
+	err = MojUnlink(path);
+	MojErrCatch(err, MojErrNotFound);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
@@ -18,8 +18,13 @@
 #include "db/MojDbKindEngine.h"
 #include "db/MojDb.h"
 #include "db/MojDbKind.h"
+#include "db/MojDbKindCatalog.h"
+#include "db/MojDbKindState.h"
 #include "db/MojDbQuery.h"
+#include "db/MojDbQueryExecutor.h"
 #include "db/MojDbServiceDefs.h"
+#include "core/MojSet.h"
+#include <vector>
 
 // prefixes
 const MojChar* const MojDbKindEngine::KindIdPrefix = _T("_kinds/");
@@ -59,10 +64,39 @@ const MojChar* const MojDbKindEngine::QuotaIdPrefix = _T("Quota:");
 const MojChar* const MojDbKindEngine::QuotaJson =
 	_T("{\"id\":\"Quota:1\",\"owner\":\"com.palm.admin\"}");
 
+// reads the kinds.db and indexIds.db records of a range of kinds, one result slot per kind
+class MojDbKindEngine::PrefetchJob : public MojDbQueryExecutor::Job
+{
+public:
+	typedef std::vector<MojString> IdVec;
+	typedef std::vector<std::pair<MojObject, MojObject> > RecordSlots;
+
+	PrefetchJob(MojDbKindEngine& kindEngine, const IdVec& ids, RecordSlots& slots, MojDbStorageTxn* txn)
+	: m_kindEngine(kindEngine), m_ids(ids), m_slots(slots), m_txn(txn) {}
+
+	virtual MojErr run(MojSize begin, MojSize end, MojSize)
+	{
+		for (MojSize i = begin; i < end; ++i) {
+			MojErr err = MojDbKindState::readRecord(m_ids[i], m_kindEngine.kindDb(), m_txn, m_kindEngine, m_slots[i].first);
+			MojErrCheck(err);
+			err = MojDbKindState::readRecord(m_ids[i], m_kindEngine.indexIdDb(), m_txn, m_kindEngine, m_slots[i].second);
+			MojErrCheck(err);
+		}
+		return MojErrNone;
+	}
+
+private:
+	MojDbKindEngine& m_kindEngine;
+	const IdVec& m_ids;
+	RecordSlots& m_slots;
+	MojDbStorageTxn* m_txn;
+};
+
 //db.kindEngine
 
 MojDbKindEngine::MojDbKindEngine()
-: m_db(NULL)
+: m_db(NULL),
+  m_loadFailed(false)
 {
 }
 
@@ -71,7 +105,7 @@ MojDbKindEngine::~MojDbKindEngine()
 	(void) close();
 }
 
-MojErr MojDbKindEngine::open(MojDb* db, MojDbReq& req)
+MojErr MojDbKindEngine::open(MojDb* db, MojDbReq& req, const MojChar* catalogDir)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -94,6 +128,14 @@ MojErr MojDbKindEngine::open(MojDb* db, MojDbReq& req)
 	err = engine->openSequence(IndexIdsSeqName, txn, m_indexIdSeq);
 	MojErrCheck(err);
 
+	// the catalog goes first, built-in kinds take their state from it too
+	MojObject catalogKinds;
+	bool catalogFound = false;
+	if (catalogDir) {
+		err = readCatalog(catalogDir, catalogKinds, catalogFound, req);
+		MojErrCheck(err);
+	}
+
 	// built-in kinds
     if (m_db->isRootKindEnabled()) {
         // add 'Object:1' when flag is true
@@ -118,9 +160,11 @@ MojErr MojDbKindEngine::open(MojDb* db, MojDbReq& req)
 	// locale
 	err = db->getLocale(m_locale, req);
 	MojErrCheck(err);
-	// load kinds from obj db
-	err = loadKinds(req);
+	// load kinds from the catalog or obj db
+	err = loadKinds(req, catalogFound ? &catalogKinds : NULL);
 	MojErrCheck(err);
+	m_states.clear();
+	restoreIndexStats();
 
 	return MojErrNone;
 }
@@ -138,6 +182,9 @@ MojErr MojDbKindEngine::close()
 			MojErrAccumulate(err, errClose);
 		}
 		m_kinds.clear();
+		m_states.clear();
+		m_indexStats.clear();
+		m_loadFailed = false;
 		// close index seq/db
 		MojErr errClose = m_indexIdSeq->close();
 		MojErrAccumulate(err, errClose);
@@ -155,6 +202,87 @@ MojErr MojDbKindEngine::close()
 	return err;
 }
 
+MojErr MojDbKindEngine::saveCatalog(const MojChar* dir)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(dir);
+	MojAssert(isOpen());
+
+	// kinds that failed to load are retried on every open, the catalog would lose them
+	if (m_loadFailed)
+		return MojErrNone;
+
+	// kinds go in _id order, the order loadKinds finds them in
+	MojSet<MojString> ids;
+	for (KindMap::ConstIterator i = m_kinds.begin(); i != m_kinds.end(); ++i) {
+		MojErr err = ids.put((*i)->id());
+		MojErrCheck(err);
+	}
+
+	MojRefCountedPtr<MojDbStorageTxn> txn;
+	MojErr err = m_db->storageEngine()->beginTxn(txn);
+	MojErrCheck(err);
+	MojObject kinds(MojObject::TypeArray);
+	MojObject states;
+	for (MojSet<MojString>::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
+		MojDbKind* kind = NULL;
+		err = getKind(i->data(), kind);
+		MojErrCheck(err);
+		MojObject tokensRec;
+		MojObject idsRec;
+		err = kind->state()->records(txn.get(), tokensRec, idsRec);
+		MojErrCheck(err);
+		MojObject state;
+		err = state.put(MojDbKindCatalog::TokensKey, tokensRec);
+		MojErrCheck(err);
+		err = state.put(MojDbKindCatalog::IdsKey, idsRec);
+		MojErrCheck(err);
+		// index stats are only exact since the index was created or last counted
+		MojObject indexStats;
+		for (MojDbKind::IndexVec::ConstIterator j = kind->indexes().begin(); j != kind->indexes().end(); ++j) {
+			if (!(*j)->hasStats())
+				continue;
+			MojObject stats;
+			err = (*j)->saveStats(stats);
+			MojErrCheck(err);
+			err = indexStats.put((*j)->name(), stats);
+			MojErrCheck(err);
+		}
+		if (!indexStats.empty()) {
+			err = state.put(MojDbKindCatalog::IndexStatsKey, indexStats);
+			MojErrCheck(err);
+		}
+		err = states.put(*i, state);
+		MojErrCheck(err);
+		if (kind->isBuiltin())
+			continue;
+
+		// the stored object, a generated hash in it would be taken as given on load
+		err = kinds.push(kind->definition());
+		MojErrCheck(err);
+	}
+	// the next open must start right after this revision for the catalog to match the db
+	MojInt64 rev = 0;
+#ifdef LMDB_ENGINE_SUPPORT
+	err = m_db->nextId(rev, txn.get());
+#else
+	err = m_db->nextId(rev);
+#endif
+	MojErrCheck(err);
+	err = txn->commit();
+	MojErrCheck(err);
+
+	MojObject catalog;
+	err = catalog.put(MojDbKindCatalog::KindsKey, kinds);
+	MojErrCheck(err);
+	err = catalog.put(MojDbKindCatalog::StatesKey, states);
+	MojErrCheck(err);
+	err = MojDbKindCatalog::write(dir, catalog, rev);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbKindEngine::stats(MojObject& objOut, MojDbReq& req, bool verify, MojString *pKind)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -512,7 +640,7 @@ MojErr MojDbKindEngine::createKind(const MojString& id, const MojObject& obj, Mo
 	return MojErrNone;
 }
 
-MojErr MojDbKindEngine::loadKinds(MojDbReq& req)
+MojErr MojDbKindEngine::loadKinds(MojDbReq& req, const MojObject* catalogKinds)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(isOpen());
@@ -521,23 +649,42 @@ MojErr MojDbKindEngine::loadKinds(MojDbReq& req)
 #else
 	MojAssertWriteLocked(m_db->m_schemaLock);
 #endif
-	MojDbQuery query;
-	MojErr err = query.from(KindKindId);
-	MojErrCheck(err);
-	MojDbCursor cursor;
-	err = m_db->find(query, cursor, req);
-	MojErrCheck(err);
-
-	for (;;) {
-		MojObject obj;
-		bool found = false;
-		err = cursor.get(obj, found);
+	MojVector<MojObject> kinds;
+	MojErr err = MojErrNone;
+	if (catalogKinds) {
+		for (MojObject::ConstArrayIterator i = catalogKinds->arrayBegin(); i != catalogKinds->arrayEnd(); ++i) {
+			err = kinds.push(*i);
+			MojErrCheck(err);
+		}
+	} else {
+		MojDbQuery query;
+		err = query.from(KindKindId);
+		MojErrCheck(err);
+		MojDbCursor cursor;
+		err = m_db->find(query, cursor, req);
 		MojErrCheck(err);
-		if (!found)
-			break;
+		for (;;) {
+			MojObject obj;
+			bool found = false;
+			err = cursor.get(obj, found);
+			MojErrCheck(err);
+			if (!found)
+				break;
+			err = kinds.push(obj);
+			MojErrCheck(err);
+		}
+		err = cursor.close();
+		MojErrCheck(err);
+		err = prefetchStates(kinds, req);
+		MojErrCheck(err);
+	}
+
+	for (MojVector<MojObject>::ConstIterator i = kinds.begin(); i != kinds.end(); ++i) {
+		const MojObject& obj = *i;
 		// load kind
 		MojErr loadErr = err = putKind(obj, req);
 		MojErrCatchAll(err) {
+			m_loadFailed = true;
 			MojString id;
 			bool found = false;
 			MojErr err = obj.get(MojDbServiceDefs::IdKey, id, found);
@@ -550,10 +697,105 @@ MojErr MojDbKindEngine::loadKinds(MojDbReq& req)
             		"error loading kind 'data' - 'error'");
 		}
 	}
-	err = cursor.close();
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindEngine::readCatalog(const MojChar* dir, MojObject& kindsOut, bool& foundOut, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(dir);
+
+	MojObject catalog;
+	MojInt64 catalogRev = 0;
+	MojErr err = MojDbKindCatalog::read(dir, catalog, catalogRev, foundOut);
+	MojErrCatchAll(err) {
+		foundOut = false;
+		LOG_WARNING(MSGID_MOJ_DB_WARNING, 1, PMLOGKS("path", dir), "kind catalog unusable, loading kinds from the db");
+	}
+	// the catalog describes the db as it was closed, the first write makes it stale
+	err = MojDbKindCatalog::remove(dir);
+	MojErrCheck(err);
+	if (!foundOut)
+		return MojErrNone;
+
+	// saveCatalog took the last revision before close, a db that lost writes
+	// since (or was written without us) does not continue right after it
+	MojInt64 rev = 0;
+#ifdef LMDB_ENGINE_SUPPORT
+	err = m_db->nextId(rev, req.txn());
+#else
+	err = m_db->nextId(rev);
+#endif
+	MojErrCheck(err);
+	if (rev != catalogRev + 1) {
+		foundOut = false;
+		LOG_WARNING(MSGID_MOJ_DB_WARNING, 3,
+			PMLOGKS("path", dir),
+			PMLOGKFV("catalogRev", "%lld", (long long) catalogRev),
+			PMLOGKFV("rev", "%lld", (long long) rev),
+			"kind catalog does not match the db revision, loading kinds from the db");
+		return MojErrNone;
+	}
+
+	MojObject states;
+	if (!catalog.get(MojDbKindCatalog::KindsKey, kindsOut) || kindsOut.type() != MojObject::TypeArray ||
+		!catalog.get(MojDbKindCatalog::StatesKey, states) || states.type() != MojObject::TypeObject) {
+		foundOut = false;
+		LOG_WARNING(MSGID_MOJ_DB_WARNING, 1, PMLOGKS("path", dir), "kind catalog incomplete, loading kinds from the db");
+		return MojErrNone;
+	}
+	for (MojObject::ConstIterator i = states.begin(); i != states.end(); ++i) {
+		err = m_states.put(i.key(), i.value());
+		MojErrCheck(err);
+		MojObject indexStats;
+		if (i.value().get(MojDbKindCatalog::IndexStatsKey, indexStats)) {
+			err = m_indexStats.put(i.key(), indexStats);
+			MojErrCheck(err);
+		}
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindEngine::prefetchStates(const MojVector<MojObject>& kinds, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+#ifdef LMDB_ENGINE_SUPPORT
+	// lmdb txns belong to one thread, the state is read in configure as before
+	return MojErrNone;
+#else
+	// the state of every kind is two point reads, independent of other kinds, so
+	// they are spread over the query executor instead of being done one by one in configure
+	PrefetchJob::IdVec ids;
+	ids.reserve(kinds.size());
+	for (MojVector<MojObject>::ConstIterator i = kinds.begin(); i != kinds.end(); ++i) {
+		MojString id;
+		bool found = false;
+		MojErr err = i->get(MojDbServiceDefs::IdKey, id, found);
+		MojErrCheck(err);
+		if (found && !m_kinds.contains(id))
+			ids.push_back(id);
+	}
+
+	PrefetchJob::RecordSlots slots(ids.size());
+	PrefetchJob job(*this, ids, slots, req.txn());
+	MojErr err = m_db->queryExecutor()->run(job, ids.size());
 	MojErrCheck(err);
 
+	for (MojSize i = 0; i < ids.size(); ++i) {
+		MojObject state;
+		err = state.put(MojDbKindCatalog::TokensKey, slots[i].first);
+		MojErrCheck(err);
+		err = state.put(MojDbKindCatalog::IdsKey, slots[i].second);
+		MojErrCheck(err);
+		err = m_states.put(ids[i], state);
+		MojErrCheck(err);
+	}
+
 	return MojErrNone;
+#endif
 }
 
 MojErr MojDbKindEngine::getKind(const MojObject& obj, MojDbKind*& kind)
@@ -607,6 +849,44 @@ MojErr MojDbKindEngine::getByOwner (const MojString& owner, MojVector<MojDbKind*
     return MojErrNone;
 }
 
+void MojDbKindEngine::restoreIndexStats()
+{
+	// stats seed the query planner, an index without them keeps its first-fit plan
+	for (MojObject::ConstIterator i = m_indexStats.begin(); i != m_indexStats.end(); ++i) {
+		KindMap::ConstIterator kind = m_kinds.find(i.key());
+		if (kind == m_kinds.end())
+			continue;
+		const MojDbKind::IndexVec& indexes = kind.value()->indexes();
+		for (MojDbKind::IndexVec::ConstIterator j = indexes.begin(); j != indexes.end(); ++j) {
+			MojObject stats;
+			if (!i.value().get((*j)->name(), stats))
+				continue;
+			MojErr err = (*j)->restoreStats(stats);
+			MojErrCatchAll(err) {
+				LOG_WARNING(MSGID_MOJ_DB_WARNING, 2,
+					PMLOGKS("kind", i.key().data()),
+					PMLOGKS("index", (*j)->name().data()),
+					"index stats in kind catalog unusable");
+			}
+		}
+	}
+	m_indexStats.clear();
+}
+
+void MojDbKindEngine::preloadState(const MojString& id, MojDbKindState& state)
+{
+	// each record is handed out once, a kind configured again reads the db
+	StateMap::ConstIterator i = m_states.find(id);
+	if (i == m_states.end())
+		return;
+	MojObject tokensRec;
+	MojObject idsRec;
+	if (i.value().get(MojDbKindCatalog::TokensKey, tokensRec) && i.value().get(MojDbKindCatalog::IdsKey, idsRec))
+		state.preload(tokensRec, idsRec);
+	bool found = false;
+	(void) m_states.del(id, found);
+}
+
 MojErr MojDbKindEngine::formatKindId(const MojChar* id, MojString& dbIdOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -21,6 +21,7 @@
 #include "core/MojObjectSerialization.h"
 #include "core/MojLogDb8.h"
 
+const MojChar* const MojDbKindState::IndexBuildsKey = _T("indexBuilds");
 const MojChar* const MojDbKindState::IndexIdsKey = _T("indexIds");
 const MojChar* const MojDbKindState::KindTokensKey = _T("kindTokens");
 const MojChar* const MojDbKindState::TokensKey = _T("tokens");
@@ -79,6 +80,54 @@ MojErr MojDbKindState::delIndex(const MojChar* indexName, MojDbReq& req)
 	MojAssert(found);
 	err = writeIds(IndexIdsKey, obj, req, item);
 	MojErrCheck(err);
+	err = delBuild(indexName, req);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindState::indexBuild(const MojChar* indexName, MojDbReq& req, MojObject& lastIdOut, bool& foundOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(indexName);
+	MojThreadGuard guard(m_lock);
+
+	MojObject obj;
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojErr err = readIds(IndexBuildsKey, req, obj, item);
+	MojErrCheck(err);
+	foundOut = obj.get(indexName, lastIdOut);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindState::updateIndexBuild(const MojChar* indexName, const MojObject& lastId, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(indexName);
+	MojThreadGuard guard(m_lock);
+
+	// null lastId means that nothing has been backfilled yet
+	MojObject obj;
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojErr err = readIds(IndexBuildsKey, req, obj, item);
+	MojErrCheck(err);
+	err = obj.put(indexName, lastId);
+	MojErrCheck(err);
+	err = writeIds(IndexBuildsKey, obj, req, item);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindState::delIndexBuild(const MojChar* indexName, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(indexName);
+	MojThreadGuard guard(m_lock);
+
+	MojErr err = delBuild(indexName, req);
+	MojErrCheck(err);
 
 	return MojErrNone;
 }
@@ -109,6 +158,46 @@ MojErr MojDbKindState::addToken(const MojChar* propName, MojUInt8& tokenOut, Tok
 
 	return MojErrNone;
 }
+
+void MojDbKindState::preload(const MojObject& tokensRec, const MojObject& idsRec)
+{
+	MojThreadGuard guard(m_lock);
+
+	m_preloadedTokens = tokensRec;
+	m_preloadedIds = idsRec;
+}
+
+MojErr MojDbKindState::records(MojDbStorageTxn* txn, MojObject& tokensRecOut, MojObject& idsRecOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(m_kindEngine);
+	MojThreadGuard guard(m_lock);
+
+	MojErr err = readRecord(m_kindId, m_kindEngine->kindDb(), txn, *m_kindEngine, tokensRecOut);
+	MojErrCheck(err);
+	err = readRecord(m_kindId, m_kindEngine->indexIdDb(), txn, *m_kindEngine, idsRecOut);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindState::readRecord(const MojString& kindId, MojDbStorageDatabase* db, MojDbStorageTxn* txn,
+		MojDbKindEngine& kindEngine, MojObject& recOut)
+{
+	MojAssert(db);
+
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojErr err = db->get(kindId, txn, false, item);
+	MojErrCheck(err);
+	if (item.get()) {
+		err = item->toObject(recOut, kindEngine, false);
+		MojErrCheck(err);
+	} else {
+		recOut.clear(MojObject::TypeNull);
+	}
+	return MojErrNone;
+}
+
 #ifdef LMDB_ENGINE_SUPPORT
 MojErr MojDbKindState::addPropImpl(const MojChar* propName, bool write, MojDbStorageTxn *txn, MojUInt8& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut)
 #else
@@ -274,6 +363,25 @@ MojErr MojDbKindState::id(const MojChar* name, const MojChar* objKey, MojDbReq&
 	return MojErrNone;
 }
 
+MojErr MojDbKindState::delBuild(const MojChar* indexName, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssertMutexLocked(m_lock);
+
+	MojObject obj;
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojErr err = readIds(IndexBuildsKey, req, obj, item);
+	MojErrCheck(err);
+	bool found = false;
+	err = obj.del(indexName, found);
+	MojErrCheck(err);
+	if (found) {
+		err = writeIds(IndexBuildsKey, obj, req, item);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
 MojErr MojDbKindState::readIds(const MojChar* key, MojDbReq& req, MojObject& objOut, MojRefCountedPtr<MojDbStorageItem>& itemOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -325,6 +433,17 @@ MojErr MojDbKindState::writeObj(const MojChar* key, const MojObject& val, MojDbS
 	MojAssert(key && db && txn);
 	MojAssertMutexLocked(m_lock);
 
+	// a preloaded record came without its item, fetch it once to update in place
+	MojObject& rec = preloaded(db);
+	if (!rec.undefined()) {
+		bool exists = rec.type() != MojObject::TypeNull;
+		rec.clear();
+		if (exists && !oldItem.get()) {
+			MojErr err = db->get(m_kindId, txn, false, oldItem);
+			MojErrCheck(err);
+		}
+	}
+
 	// reconstitute obj
 	MojObject obj;
 	if (oldItem.get()) {
@@ -371,6 +490,13 @@ MojErr MojDbKindState::readObj(const MojChar* key, MojObject& val, MojDbStorageD
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(key && db);
 
+	const MojObject& rec = preloaded(db);
+	if (!rec.undefined()) {
+		oldItem.reset();
+		(void) rec.get(key, val);
+		return MojErrNone;
+	}
+
 	MojErr err = db->get(m_kindId, txn, false, oldItem);
 	MojErrCheck(err);
 	if (oldItem.get()) {
@@ -384,3 +510,8 @@ MojErr MojDbKindState::readObj(const MojChar* key, MojObject& val, MojDbStorageD
 	}
 	return MojErrNone;
 }
+
+MojObject& MojDbKindState::preloaded(MojDbStorageDatabase* db)
+{
+	return (db == m_kindEngine->kindDb()) ? m_preloadedTokens : m_preloadedIds;
+}
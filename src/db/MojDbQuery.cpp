@@ -622,6 +622,7 @@ void MojDbQuery::init()
     m_desc = false;
     m_forceIndex = NULL;
     m_ignoreInactiveShards = true;
+    m_explain = false;
     m_kindEngine = NULL;
 }
 
@@ -0,0 +1,232 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "db/MojDbQueryExecutor.h"
+#include "core/MojLogDb8.h"
+
+const MojChar* const MojDbQueryExecutor::ThreadsKey = _T("queryThreads");
+
+MojDbQueryExecutor::Task::Task(Job& job, MojSize count, MojSize batchSize)
+: m_job(job),
+  m_count(count),
+  m_batchSize(batchSize),
+  m_numBatches((MojInt32) ((count + batchSize - 1) / batchSize)),
+  m_active(0),
+  m_err(MojErrNone)
+{
+}
+
+MojErr MojDbQueryExecutor::Task::runBatches(MojSize slot)
+{
+	for (;;) {
+		// stop handing out batches once any participant has failed
+		if (m_failed.value())
+			return MojErrNone;
+		MojInt32 batch = m_next.increment() - 1;
+		if (batch >= m_numBatches)
+			return MojErrNone;
+
+		MojSize begin = (MojSize) batch * m_batchSize;
+		MojSize end = begin + m_batchSize;
+		if (end > m_count)
+			end = m_count;
+		MojErr err = m_job.run(begin, end, slot);
+		if (err != MojErrNone) {
+			m_failed.increment();
+			return err;
+		}
+	}
+}
+
+MojDbQueryExecutor::MojDbQueryExecutor()
+: m_numThreads(ThreadsDefault),
+  m_slots(0),
+  m_stop(false)
+{
+}
+
+MojDbQueryExecutor::~MojDbQueryExecutor()
+{
+	MojErr err = close();
+	MojErrCatchAll(err);
+}
+
+MojErr MojDbQueryExecutor::configure(const MojObject& conf)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojInt64 numThreads = ThreadsDefault;
+	if (conf.get(ThreadsKey, numThreads) && numThreads < 0)
+		MojErrThrowMsg(MojErrInvalidArg, _T("db: %s must not be negative"), ThreadsKey);
+
+	// slots are handed out when threads start, so running threads keep their count
+	MojThreadGuard guard(m_mutex);
+	if (m_threads.empty())
+		m_numThreads = (MojSize) numThreads;
+
+	return MojErrNone;
+}
+
+MojErr MojDbQueryExecutor::open()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojThreadGuard guard(m_mutex);
+	m_stop = false;
+
+	return MojErrNone;
+}
+
+MojErr MojDbQueryExecutor::close()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// workers finish the task they are on, submitters complete their own jobs
+	MojThreadGuard guard(m_mutex);
+	m_stop = true;
+	MojErr err = m_cond.broadcast();
+	MojErrCheck(err);
+	ThreadVec threads;
+	threads.swap(m_threads);
+	m_slots = 0;
+	guard.unlock();
+
+	for (ThreadVec::ConstIterator i = threads.begin(); i != threads.end(); ++i) {
+		MojErr threadErr = MojErrNone;
+		MojErr errJoin = MojThreadJoin(*i, threadErr);
+		MojErrAccumulate(err, errJoin);
+		MojErrAccumulate(err, threadErr);
+	}
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbQueryExecutor::run(Job& job, MojSize count, MojSize batchSize)
+{
+	MojAssert(batchSize > 0);
+
+	Task task(job, count, batchSize);
+	MojThreadGuard guard(m_mutex);
+	if (m_stop || m_numThreads == 0 || count <= batchSize) {
+		guard.unlock();
+		return task.runBatches(0);
+	}
+	MojErr err = start();
+	MojErrCheck(err);
+	err = m_tasks.push(&task);
+	MojErrCheck(err);
+	err = m_cond.broadcast();
+	MojErrCheck(err);
+	guard.unlock();
+
+	// the submitter works on its own job too, so it finishes even if every worker is busy
+	MojErr errRun = task.runBatches(0);
+
+	guard.lock();
+	remove(&task);
+	if (errRun != MojErrNone && task.m_err == MojErrNone)
+		task.m_err = errRun;
+	while (task.m_active > 0) {
+		err = m_cond.wait(m_mutex);
+		MojErrCheck(err);
+	}
+	MojErrCheck(task.m_err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbQueryExecutor::start()
+{
+	// called with m_mutex held
+	if (!m_threads.empty())
+		return MojErrNone;
+
+	MojErr err = m_threads.reserve(m_numThreads);
+	MojErrCheck(err);
+	for (MojSize i = 0; i < m_numThreads; ++i) {
+		MojThreadT thread = MojInvalidThread;
+		err = MojThreadCreate(thread, &threadMain, this);
+		MojErrCheck(err);
+		err = m_threads.push(thread);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbQueryExecutor::threadMain(void* arg)
+{
+	MojDbQueryExecutor* executor = (MojDbQueryExecutor*) arg;
+	MojAssert(executor);
+
+	MojThreadGuard guard(executor->m_mutex);
+	MojSize slot = ++executor->m_slots;
+	guard.unlock();
+	MojAssert(slot < executor->slots());
+
+	Task* task = NULL;
+	while ((task = executor->next()) != NULL) {
+		MojErr err = task->runBatches(slot);
+		executor->done(task, err);
+	}
+	return MojErrNone;
+}
+
+MojDbQueryExecutor::Task* MojDbQueryExecutor::next()
+{
+	MojThreadGuard guard(m_mutex);
+	for (;;) {
+		if (m_stop)
+			return NULL;
+		while (!m_tasks.empty()) {
+			Task* task = m_tasks.front();
+			if (task->m_next.value() < task->m_numBatches && !task->m_failed.value()) {
+				++task->m_active;
+				return task;
+			}
+			// every batch is claimed, nothing left for another worker to help with
+			MojErr err = m_tasks.erase(0);
+			MojErrCatchAll(err);
+		}
+		MojErr err = m_cond.wait(m_mutex);
+		MojErrCatchAll(err);
+	}
+}
+
+void MojDbQueryExecutor::done(Task* task, MojErr err)
+{
+	MojAssert(task);
+
+	MojThreadGuard guard(m_mutex);
+	MojAssert(task->m_active > 0);
+	if (err != MojErrNone && task->m_err == MojErrNone)
+		task->m_err = err;
+	if (--task->m_active == 0) {
+		MojErr errCond = m_cond.broadcast();
+		MojErrCatchAll(errCond);
+	}
+}
+
+void MojDbQueryExecutor::remove(Task* task)
+{
+	// called with m_mutex held
+	MojSize idx = m_tasks.find(task);
+	if (idx != MojInvalidIndex) {
+		MojErr err = m_tasks.erase(idx);
+		MojErrCatchAll(err);
+	}
+}
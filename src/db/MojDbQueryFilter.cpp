@@ -49,7 +49,7 @@ MojErr MojDbQueryFilter::init(const MojDbQuery& query)
  *   3. Check whether retrieved value from delivered object exists in range.
  * overflows and to report any truncations.
  ***********************************************************************/
-MojErr MojDbQueryFilter::test(const MojObject& obj, bool& isFound) const
+MojErr MojDbQueryFilter::test(const MojObjectView& obj, bool& isFound) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -104,21 +104,33 @@ MojErr MojDbQueryFilter::test(const MojObject& obj, bool& isFound) const
  * by using name vector from filter condition.
  * and contain the result into object array.
  ***********************************************************************/
-MojErr MojDbQueryFilter::findValue(const MojObject obj, const MojString* begin, const MojString* end, MojObject& valOut, bool& ret) const
+MojErr MojDbQueryFilter::findValue(const MojObjectView& obj, const MojString* begin, const MojString* end, MojObject& valOut, bool& ret) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-    MojObject childObj = obj;
+    // walk the view so that only the filtered props get materialized
+    MojObjectView childObj = obj;
     for (const MojString* key = begin; key != end; ++key) {
         if(childObj.type() == MojObject::TypeArray) {
             // if array, find values recursively
-            for (MojObject::ConstArrayIterator childObjIter = childObj.arrayBegin(); childObjIter != childObj.arrayEnd(); ++childObjIter) {
-                findValue(*childObjIter, key, end, valOut, ret);
+            MojObjectView::ConstIterator childObjIter;
+            MojErr err = childObj.begin(childObjIter);
+            MojErrCheck(err);
+            for (;;) {
+                bool hasNext = false;
+                err = childObjIter.next(hasNext);
+                MojErrCheck(err);
+                if (!hasNext)
+                    break;
+                findValue(childObjIter.value(), key, end, valOut, ret);
             }
             ret = !valOut.empty();
             return MojErrNone;
         } else {
-            if(!childObj.get(key->data(), childObj)) {
+            bool found = false;
+            MojErr err = childObj.get(key->data(), childObj, found);
+            MojErrCheck(err);
+            if (!found) {
                 ret = false;
                 return MojErrNone;
             }
@@ -126,20 +138,22 @@ MojErr MojDbQueryFilter::findValue(const MojObject obj, const MojString* begin,
     }
 
     // if found, push result value into object array.
-    if(childObj.type() == MojObject::TypeArray) {
+    MojObject childVal;
+    MojErr err = childObj.toObject(childVal);
+    MojErrCheck(err);
+    if(childVal.type() == MojObject::TypeArray) {
         bool foundOut;
-        MojErr err;
         MojObject::ArrayIterator iter;
-        err = childObj.arrayBegin(iter);
+        err = childVal.arrayBegin(iter);
         MojErrCheck(err);
-        for (; iter != childObj.arrayEnd(); ++iter) {
+        for (; iter != childVal.arrayEnd(); ++iter) {
             // if result set is array, we should remove "_id" for comparison.
             err = iter->del(_T("_id"), foundOut);
             MojErrCheck(err);
             valOut.push(*iter);
         }
     } else {
-        valOut.push(childObj);
+        valOut.push(childVal);
     }
 
     ret = true;
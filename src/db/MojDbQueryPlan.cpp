@@ -309,21 +309,16 @@ MojErr MojDbQueryPlan::pushSearch(MojDbKeyBuilder& lowerBuilder, MojDbKeyBuilder
 	err = tokenizer->tokenize(text, collator, toks);
 	MojErrCheck(err);
 
-	// remove prefixes
-	MojDbKeyBuilder::KeySet::Iterator i;
-	err = toks.begin(i);
-	MojErrCheck(err);
-	MojDbKeyBuilder::KeySet::ConstIterator prev = toks.end();
-	while (i != toks.end()) {
-		if (prev != toks.end() && prev->stringPrefixOf(*i)) {
-			bool found = false;
-			err = toks.del(*prev, found);
+	// remove prefixes, keeping each tok that isn't a prefix of the one after it
+	MojDbKeyBuilder::KeySet words;
+	for (MojDbKeyBuilder::KeySet::ConstIterator i = toks.begin(); i != toks.end(); ++i) {
+		MojDbKeyBuilder::KeySet::ConstIterator next = i + 1;
+		if (next == toks.end() || !i->stringPrefixOf(*next)) {
+			err = words.put(*i);
 			MojErrCheck(err);
-			MojAssert(found);
 		}
-		prev = i;
-		++i;
 	}
+	toks.swap(words);
 
 	// push toks
 	err = lowerBuilder.push(toks);
@@ -19,7 +19,9 @@
 #include "db/MojDb.h"
 #include "db/MojDbKind.h"
 #include "db/MojDbServiceDefs.h"
+#include "core/MojLogDb8.h"
 
+const MojChar* const MojDbQuotaEngine::FlushIntervalKey = _T("quotaFlushInterval");
 const MojChar* const MojDbQuotaEngine::QuotasKey = _T("quotas");
 const MojChar* const MojDbQuotaEngine::UsageDbName = _T("quotaUsage");
 
@@ -37,12 +39,18 @@ public:
 
 MojDbQuotaEngine::MojDbQuotaEngine()
 : MojDbPutHandler(MojDbKindEngine::QuotaId, QuotasKey),
-  m_isOpen(false)
+  m_isOpen(false),
+  m_thread(MojInvalidThread),
+  m_stop(false),
+  m_flushInterval(FlushIntervalDefault),
+  m_epoch(0)
 {
 }
 
 MojDbQuotaEngine::~MojDbQuotaEngine()
 {
+	MojErr err = stopFlush();
+	MojErrCatchAll(err);
 }
 
 MojErr MojDbQuotaEngine::open(const MojObject& conf, MojDb* db, MojDbReq& req)
@@ -50,6 +58,12 @@ MojErr MojDbQuotaEngine::open(const MojObject& conf, MojDb* db, MojDbReq& req)
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(db);
 
+	MojInt64 flushInterval = FlushIntervalDefault;
+	conf.get(FlushIntervalKey, flushInterval);
+	if (flushInterval <= 0)
+		MojErrThrowMsg(MojErrInvalidArg, _T("db: %s must be positive"), FlushIntervalKey);
+	m_flushInterval = flushInterval;
+
 	MojErr err = db->storageEngine()->openDatabase(_T("UsageDbName"), req.txn(), m_usageDb);
 	MojErrCheck(err);
 	err = MojDbPutHandler::open(conf, db, req);
@@ -63,6 +77,8 @@ MojErr MojDbQuotaEngine::open(const MojObject& conf, MojDb* db, MojDbReq& req)
 	}
 	err = refreshImpl(req.txn());
 	MojErrCheck(err);
+	err = startFlush();
+	MojErrCheck(err);
 
 	m_isOpen = true;
 
@@ -73,8 +89,15 @@ MojErr MojDbQuotaEngine::close()
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
+	// a clean close leaves exact records and no markers behind
 	MojErr err = MojErrNone;
-	MojErr errClose = MojDbPutHandler::close();
+	MojErr errClose = stopFlush();
+	MojErrAccumulate(err, errClose);
+	if (m_usageDb.get() && m_db) {
+		errClose = flush();
+		MojErrAccumulate(err, errClose);
+	}
+	errClose = MojDbPutHandler::close();
 	MojErrAccumulate(err, errClose);
 	if (m_usageDb.get()) {
 		errClose = m_usageDb->close();
@@ -82,6 +105,9 @@ MojErr MojDbQuotaEngine::close()
 		m_usageDb.reset();
 	}
 	m_quotas.clear();
+	m_usages.clear();
+	m_epochs[0] = Epoch();
+	m_epochs[1] = Epoch();
 	m_isOpen = false;
 
 	return err;
@@ -164,15 +190,94 @@ MojErr MojDbQuotaEngine::curKind(const MojDbKind* kind, MojDbStorageTxn* txn)
 MojErr MojDbQuotaEngine::applyUsage(MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn && !txn->m_usageApplied);
+
+	if (!m_usageDb.get())
+		return MojErrNone;
 
 	for (OffsetMap::ConstIterator i = txn->m_offsetMap.begin();
 		 i != txn->m_offsetMap.end(); ++i) {
-		MojErr err = applyOffset(i.key(), i.value()->offset(), txn);
-		MojErrCheck(err);
+		if (i.value()->offset() != 0 && !i.value()->m_usage.get()) {
+			MojErr err = usageForKind(i.key(), txn, i.value()->m_usage);
+			MojErrCheck(err);
+		}
+	}
+
+	// the first change to a kind in an epoch marks it dirty in this txn
+	KindSet markers;
+	MojThreadGuard guard(m_mutex);
+	Epoch& epoch = m_epochs[m_epoch & 1];
+	for (OffsetMap::ConstIterator i = txn->m_offsetMap.begin();
+		 i != txn->m_offsetMap.end(); ++i) {
+		if (i.value()->offset() != 0 && !epoch.m_marked.contains(i.key())) {
+			MojErr err = markers.put(i.key());
+			MojErrCheck(err);
+			err = epoch.m_touched.put(i.key());
+			MojErrCheck(err);
+		}
+	}
+	txn->m_usageEpoch = m_epoch;
+	txn->m_usageApplied = true;
+	++epoch.m_inflight;
+	guard.unlock();
+
+	MojErr err = MojErrNone;
+	for (KindSet::ConstIterator i = markers.begin(); i != markers.end(); ++i) {
+		err = writeMarker(*i, txn->m_usageEpoch, txn);
+		if (err != MojErrNone)
+			break;
+	}
+	if (err != MojErrNone) {
+		MojErr errCommit = commitUsage(txn, false);
+		MojErrAccumulate(err, errCommit);
+		MojErrThrow(err);
 	}
 	return MojErrNone;
 }
 
+MojErr MojDbQuotaEngine::commitUsage(MojDbStorageTxn* txn, bool committed)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	if (!txn->m_usageApplied)
+		return MojErrNone;
+	txn->m_usageApplied = false;
+
+	MojErr err = MojErrNone;
+	MojThreadGuard guard(m_mutex);
+	Epoch& epoch = m_epochs[txn->m_usageEpoch & 1];
+	if (committed) {
+		for (OffsetMap::ConstIterator i = txn->m_offsetMap.begin();
+			 i != txn->m_offsetMap.end(); ++i) {
+			MojInt64 offset = i.value()->offset();
+			if (offset == 0 || !i.value()->m_usage.get())
+				continue;
+			i.value()->m_usage->offset(offset);
+
+			DeltaMap::Iterator delta;
+			MojErr errPut = epoch.m_deltas.find(i.key(), delta);
+			if (errPut == MojErrNone) {
+				if (delta != epoch.m_deltas.end())
+					delta.value() += offset;
+				else
+					errPut = epoch.m_deltas.put(i.key(), offset);
+			}
+			MojErrAccumulate(err, errPut);
+			errPut = epoch.m_marked.put(i.key());
+			MojErrAccumulate(err, errPut);
+		}
+	}
+	MojAssert(epoch.m_inflight > 0);
+	if (--epoch.m_inflight == 0) {
+		MojErr errSignal = m_drained.broadcast();
+		MojErrAccumulate(err, errSignal);
+	}
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbQuotaEngine::applyQuota(MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -193,6 +298,16 @@ MojErr MojDbQuotaEngine::kindUsage(const MojChar* kindId, MojInt64& usageOut, Mo
 	MojString kindStr;
 	MojErr err = kindStr.assign(kindId);
 	MojErrCheck(err);
+
+	MojThreadGuard guard(m_mutex);
+	UsageMap::ConstIterator iter = m_usages.find(kindStr);
+	if (iter != m_usages.end()) {
+		usageOut = iter.value()->usage();
+		return MojErrNone;
+	}
+	guard.unlock();
+
+	// kinds nobody wrote to since open only have their record
 	MojRefCountedPtr<MojDbStorageItem> item;
 	err = getUsage(kindStr, txn, false, usageOut, item);
 	MojErrCheck(err);
@@ -235,6 +350,47 @@ MojErr MojDbQuotaEngine::refresh()
 	return MojErrNone;
 }
 
+MojErr MojDbQuotaEngine::flush()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(m_usageDb.get());
+
+	// close the open epoch and wait for the commits still in it
+	MojThreadGuard flushGuard(m_flushMutex);
+	MojThreadGuard guard(m_mutex);
+	Epoch& closing = m_epochs[m_epoch & 1];
+	// markers of txns that failed to commit never made it to disk, they can wait
+	if (closing.m_marked.empty())
+		return MojErrNone;
+	MojUInt64 closedEpoch = m_epoch++;
+	while (closing.m_inflight > 0) {
+		MojErr err = m_drained.wait(m_mutex);
+		MojErrCheck(err);
+	}
+	Epoch closed;
+	closed.m_deltas.swap(closing.m_deltas);
+	closed.m_marked.swap(closing.m_marked);
+	closed.m_touched.swap(closing.m_touched);
+	guard.unlock();
+
+	// commits in the new epoch write markers of the other parity, so the flush
+	// txn can't delete them and commits without holding up writers
+	MojRefCountedPtr<MojDbStorageTxn> txn;
+	MojErr err = flushImpl(closed, closedEpoch, txn);
+	if (err == MojErrNone)
+		err = txn->commit();
+	if (err != MojErrNone) {
+		// the deltas go out with the next flush. the markers of this epoch stay
+		// until a flush of their parity or a rescan on open, which is safe
+		guard.lock();
+		MojErr errMerge = m_epochs[m_epoch & 1].merge(closed);
+		MojErrAccumulate(err, errMerge);
+		MojErrThrow(err);
+	}
+
+	return MojErrNone;
+}
+
 MojErr MojDbQuotaEngine::stats(MojObject& objOut, MojDbReq& req)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -255,6 +411,97 @@ MojErr MojDbQuotaEngine::stats(MojObject& objOut, MojDbReq& req)
 	return MojErrNone;
 }
 
+MojErr MojDbQuotaEngine::startFlush()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojThreadGuard guard(m_mutex);
+	if (m_thread != MojInvalidThread)
+		return MojErrNone;
+	m_stop = false;
+	MojErr err = MojThreadCreate(m_thread, &threadMain, this);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbQuotaEngine::stopFlush()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojThreadGuard guard(m_mutex);
+	MojThreadT thread = m_thread;
+	m_thread = MojInvalidThread;
+	m_stop = true;
+	MojErr err = m_cond.broadcast();
+	MojErrCheck(err);
+	guard.unlock();
+
+	if (thread != MojInvalidThread) {
+		MojErr threadErr = MojErrNone;
+		MojErr errJoin = MojThreadJoin(thread, threadErr);
+		MojErrAccumulate(err, errJoin);
+		MojErrAccumulate(err, threadErr);
+	}
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbQuotaEngine::threadMain(void* arg)
+{
+	MojDbQuotaEngine* engine = static_cast<MojDbQuotaEngine*>(arg);
+	MojAssert(engine);
+
+	MojThreadGuard guard(engine->m_mutex);
+	while (!engine->m_stop) {
+		MojTime deadline;
+		MojErr err = MojGetCurrentTime(deadline);
+		MojErrCheck(err);
+		deadline += MojMillisecs(engine->m_flushInterval);
+		err = engine->m_cond.timedWait(engine->m_mutex, deadline);
+		if (err != MojErrTimedOut)
+			MojErrCheck(err);
+		if (engine->m_stop)
+			break;
+		guard.unlock();
+
+		err = engine->flush();
+		if (err != MojErrNone)
+			LOG_WARNING(MSGID_MOJ_DB_WARNING, 1, PMLOGKFV("error", "%d", (int) err), "quota usage flush failed");
+		guard.lock();
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojDbQuotaEngine::flushImpl(const Epoch& epoch, MojUInt64 epochNum, MojRefCountedPtr<MojDbStorageTxn>& txnOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+#ifdef LMDB_ENGINE_SUPPORT
+	MojErr err = m_db->storageEngine()->beginTxn(txnOut, true);
+#else
+	MojErr err = m_db->storageEngine()->beginTxn(txnOut);
+#endif
+	MojErrCheck(err);
+	for (DeltaMap::ConstIterator i = epoch.m_deltas.begin(); i != epoch.m_deltas.end(); ++i) {
+		if (i.value() != 0) {
+			err = applyOffset(i.key(), i.value(), txnOut.get());
+			MojErrCheck(err);
+		}
+	}
+	for (KindSet::ConstIterator i = epoch.m_touched.begin(); i != epoch.m_touched.end(); ++i) {
+		MojObject key;
+		err = markerKey(*i, epochNum, key);
+		MojErrCheck(err);
+		bool found = false;
+		err = m_usageDb->del(key, txnOut.get(), found);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
 MojErr MojDbQuotaEngine::refreshImpl(MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -326,18 +573,8 @@ MojErr MojDbQuotaEngine::applyOffset(const MojString& kindId, MojInt64 offset, M
 	MojErr err = getUsage(kindId, txn, true, usage, item);
 	MojErrCheck(err);
 	if (item.get()) {
-		MojInt64 newUsage = offset + usage;
-
-		MojAssert(newUsage >= 0);
-		MojObject newVal(newUsage);
-		MojBuffer buf;
-		err = newVal.toBytes(buf);
-		MojErrCheck(err);
-		// insert new record
-		txn->quotaEnabled(false);
-		err = m_usageDb->update(kindId, buf, item.get(), txn);
+		err = updateUsage(kindId, offset + usage, item.get(), txn);
 		MojErrCheck(err);
-		txn->quotaEnabled(true);
 	} else {
 		err = insertUsage(kindId, offset, txn);
 		MojErrCheck(err);
@@ -367,20 +604,140 @@ MojErr MojDbQuotaEngine::initUsage(MojDbKind* kind, MojDbReq& req)
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(kind);
 
+	// a marker of either parity means commits after the last checkpoint may be
+	// missing from the record
+	MojObject keys[2];
+	bool marked = false;
+	for (MojUInt64 parity = 0; parity < 2; ++parity) {
+		MojErr err = markerKey(kind->id(), parity, keys[parity]);
+		MojErrCheck(err);
+		MojRefCountedPtr<MojDbStorageItem> marker;
+		err = m_usageDb->get(keys[parity], req.txn(), false, marker);
+		MojErrCheck(err);
+		if (marker.get())
+			marked = true;
+	}
 	MojRefCountedPtr<MojDbStorageItem> item;
-	MojErr err = m_usageDb->get(kind->id(), req.txn(), false, item);
+	MojInt64 usage = 0;
+	MojErr err = getUsage(kind->id(), req.txn(), marked, usage, item);
 	MojErrCheck(err);
-	if (!item.get()) {
+	if (!item.get() || marked) {
+		if (marked) {
+			LOG_WARNING(MSGID_MOJ_DB_WARNING, 1, PMLOGKS("kind", kind->id().data()),
+					"quota usage not checkpointed, rescanning kind");
+		}
 		MojObject stats;
-		MojSize usage = 0;
-		err = kind->stats(stats, usage, req, false);
+		MojSize size = 0;
+		err = kind->stats(stats, size, req, false);
 		MojErrCheck(err);
-		err = insertUsage(kind->id(), (MojInt64) usage, req.txn());
+		usage = (MojInt64) size;
+		if (item.get()) {
+			err = updateUsage(kind->id(), usage, item.get(), req.txn());
+			MojErrCheck(err);
+		} else {
+			err = insertUsage(kind->id(), usage, req.txn());
+			MojErrCheck(err);
+		}
+		// the record is exact again, markers left in would force another rescan
+		if (marked) {
+			for (MojSize parity = 0; parity < 2; ++parity) {
+				bool found = false;
+				err = m_usageDb->del(keys[parity], req.txn(), found);
+				MojErrCheck(err);
+			}
+		}
+	}
+
+	MojRefCountedPtr<Usage> counter(new Usage(usage));
+	MojAllocCheck(counter.get());
+	MojThreadGuard guard(m_mutex);
+	err = m_usages.put(kind->id(), counter);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbQuotaEngine::usageForKind(const MojString& kindId, MojDbStorageTxn* txn, MojRefCountedPtr<Usage>& usageOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	MojThreadGuard guard(m_mutex);
+	UsageMap::ConstIterator iter = m_usages.find(kindId);
+	if (iter != m_usages.end()) {
+		usageOut = iter.value();
+		return MojErrNone;
+	}
+	guard.unlock();
+
+	// kinds created since open start from their record, if one was left behind
+	MojInt64 usage = 0;
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojErr err = getUsage(kindId, txn, false, usage, item);
+	MojErrCheck(err);
+
+	guard.lock();
+	iter = m_usages.find(kindId);
+	if (iter != m_usages.end()) {
+		usageOut = iter.value();
+		return MojErrNone;
+	}
+	usageOut.reset(new Usage(usage));
+	MojAllocCheck(usageOut.get());
+	err = m_usages.put(kindId, usageOut);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbQuotaEngine::markerKey(const MojString& kindId, MojUInt64 epoch, MojObject& keyOut)
+{
+	// usage records are keyed by kind id strings, markers by an array so they can't collide.
+	// consecutive epochs use different keys, a flush only deletes markers of the epoch it closes
+	keyOut = MojObject(MojObject::TypeArray);
+	MojErr err = keyOut.push(kindId);
+	MojErrCheck(err);
+	err = keyOut.push((MojInt64) (epoch & 1));
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbQuotaEngine::writeMarker(const MojString& kindId, MojUInt64 epoch, MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	MojObject key;
+	MojErr err = markerKey(kindId, epoch, key);
+	MojErrCheck(err);
+	MojRefCountedPtr<MojDbStorageItem> item;
+	err = m_usageDb->get(key, txn, true, item);
+	MojErrCheck(err);
+	if (!item.get()) {
+		err = insertMarker(key, txn);
 		MojErrCheck(err);
 	}
 	return MojErrNone;
 }
 
+MojErr MojDbQuotaEngine::insertMarker(const MojObject& key, MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	MojObject val(true);
+	MojBuffer buf;
+	MojErr err = val.toBytes(buf);
+	MojErrCheck(err);
+	txn->quotaEnabled(false);
+	err = m_usageDb->insert(key, buf, txn);
+	MojErrCheck(err);
+	txn->quotaEnabled(true);
+
+	return MojErrNone;
+}
+
 MojErr MojDbQuotaEngine::insertUsage(const MojString& kindId, MojInt64 usage, MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -401,6 +758,25 @@ MojErr MojDbQuotaEngine::insertUsage(const MojString& kindId, MojInt64 usage, Mo
 	return MojErrNone;
 }
 
+MojErr MojDbQuotaEngine::updateUsage(const MojString& kindId, MojInt64 usage, MojDbStorageItem* item, MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(item && txn);
+	MojAssert(usage >= 0);
+
+	MojObject val(usage);
+	MojBuffer buf;
+	MojErr err = val.toBytes(buf);
+	MojErrCheck(err);
+	// overwrite old record
+	txn->quotaEnabled(false);
+	err = m_usageDb->update(kindId, buf, item, txn);
+	MojErrCheck(err);
+	txn->quotaEnabled(true);
+
+	return MojErrNone;
+}
+
 MojErr MojDbQuotaEngine::commitQuota(const MojString& owner, MojInt64 size)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -433,17 +809,14 @@ MojInt64 MojDbQuotaEngine::Quota::size() const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojThreadGuard guard(m_mutex);
-	MojInt64 size = m_size;
-	return size;
+	return m_size.load();
 }
 
 MojInt64 MojDbQuotaEngine::Quota::available() const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojThreadGuard guard(m_mutex);
-	MojInt64 available = m_size - m_usage;
+	MojInt64 available = m_size.load() - m_usage.load();
 	available = (available < 0) ? 0 : available;
 	return available;
 }
@@ -452,33 +825,49 @@ MojInt64 MojDbQuotaEngine::Quota::usage() const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojThreadGuard guard(m_mutex);
-	MojInt64 usage = m_usage;
-	return usage;
+	return m_usage.load();
 }
 
 void MojDbQuotaEngine::Quota::size(MojInt64 val)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojThreadGuard guard(m_mutex);
-	m_size = val;
+	m_size.store(val);
 }
 
 void MojDbQuotaEngine::Quota::usage(MojInt64 val)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojThreadGuard guard(m_mutex);
-	m_usage = val;
+	m_usage.store(val);
 }
 
 void MojDbQuotaEngine::Quota::offset(MojInt64 off)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojThreadGuard guard(m_mutex);
-	m_usage += off;
+	m_usage.fetch_add(off);
+}
+
+MojErr MojDbQuotaEngine::Epoch::merge(const Epoch& epoch)
+{
+	for (DeltaMap::ConstIterator i = epoch.m_deltas.begin(); i != epoch.m_deltas.end(); ++i) {
+		DeltaMap::Iterator delta;
+		MojErr err = m_deltas.find(i.key(), delta);
+		MojErrCheck(err);
+		if (delta != m_deltas.end()) {
+			delta.value() += i.value();
+		} else {
+			err = m_deltas.put(i.key(), i.value());
+			MojErrCheck(err);
+		}
+	}
+	MojErr err = m_marked.put(epoch.m_marked);
+	MojErrCheck(err);
+	err = m_touched.put(epoch.m_touched);
+	MojErrCheck(err);
+
+	return MojErrNone;
 }
 
 MojDbQuotaEngine::Offset::Offset(const MojString& kindId)
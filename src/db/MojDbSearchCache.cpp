@@ -17,7 +17,16 @@
 #include "db/MojDbKind.h"
 #include "db/MojDbQuery.h"
 #include "db/MojDbSearchCache.h"
-#include <vector>
+#include "core/MojUtil.h"
+
+const MojChar* const MojDbSearchCache::SizeKey = _T("searchCacheSize");
+const MojChar* const MojDbSearchCache::EntriesKey = _T("entries");
+const MojChar* const MojDbSearchCache::BytesKey = _T("bytes");
+const MojChar* const MojDbSearchCache::BudgetKey = _T("budget");
+const MojChar* const MojDbSearchCache::HitsKey = _T("hits");
+const MojChar* const MojDbSearchCache::MissesKey = _T("misses");
+const MojChar* const MojDbSearchCache::EvictionsKey = _T("evictions");
+const MojChar* const MojDbSearchCache::InvalidationsKey = _T("invalidations");
 
 MojErr MojDbSearchCache::QueryKey::setQuery(const MojDbQuery& query)
 {
@@ -42,74 +51,123 @@ MojErr MojDbSearchCache::QueryKey::fromQuery(const MojDbQuery& query, MojUInt32
     return setQuery(query);
 }
 
-bool MojDbSearchCache::contain(const QueryKey& a_key) const
+void MojDbSearchCache::QueryKey::rehash()
 {
-    MojThreadReadGuard guard(m_lock);
-    return (m_container.find(a_key) != m_container.end());
+    m_hash = (MojSize) MojHash(m_kind.data(), m_kind.length()) * 31 + MojHash(m_query.data(), m_query.length());
 }
 
-bool MojDbSearchCache::QueryKey::operator==(const QueryKey& a_rhsKey) const
+bool MojDbSearchCache::QueryKey::sameQuery(const QueryKey& a_rhsKey) const
 {
-    if ((m_rev == a_rhsKey.getRev()) &&
+    return m_hash == a_rhsKey.m_hash &&
             m_query == a_rhsKey.m_query &&
-            m_kind == a_rhsKey.m_kind)
-        return true;
-    return false;
+            m_kind == a_rhsKey.m_kind;
+}
+
+bool MojDbSearchCache::QueryKey::operator==(const QueryKey& a_rhsKey) const
+{
+    return m_rev == a_rhsKey.getRev() && sameQuery(a_rhsKey);
 }
 
 bool MojDbSearchCache::QueryKey::operator<(const QueryKey& a_rhsKey) const
 {
-    int eqKind = m_kind.compare(a_rhsKey.m_kind);
-    if (eqKind < 0)
-        return true;
+    int comp = m_kind.compare(a_rhsKey.m_kind);
+    if (comp == 0)
+        comp = m_query.compare(a_rhsKey.m_query);
+    if (comp == 0)
+        return m_rev < a_rhsKey.getRev();
+    return comp < 0;
+}
+
+MojErr MojDbSearchCache::configure(const MojObject& conf)
+{
+    MojInt64 budget = SizeDefault;
+    if (conf.get(SizeKey, budget) && budget < 0)
+        MojErrThrowMsg(MojErrInvalidArg, _T("db: %s must not be negative"), SizeKey);
+
+    MojThreadGuard guard(m_mutex);
+    m_budget = (MojSize) budget;
+    evict();
+
+    return MojErrNone;
+}
+
+bool MojDbSearchCache::contain(const QueryKey& a_key) const
+{
+    MojThreadGuard guard(m_mutex);
+    Index::const_iterator iter = m_index.find(a_key);
+    return iter != m_index.end() && iter->second->m_key.getRev() == a_key.getRev();
+}
 
-    int eqQuery = strncmp(m_query.data(), a_rhsKey.m_query.data(),
-                m_query.length());
-    if (eqKind == 0 && eqQuery < 0)
-        return true;
+MojSize MojDbSearchCache::size() const
+{
+    MojThreadGuard guard(m_mutex);
+    return m_entries.size();
+}
 
-    if (eqKind == 0 && eqQuery == 0 && m_rev < a_rhsKey.getRev())
-        return true;
+MojSize MojDbSearchCache::bytes() const
+{
+    MojThreadGuard guard(m_mutex);
+    return m_bytes;
+}
 
-    return false;
+MojSize MojDbSearchCache::budget() const
+{
+    MojThreadGuard guard(m_mutex);
+    return m_budget;
 }
 
 MojErr MojDbSearchCache::createCache(const QueryKey& a_key, const IdSet& a_ids)
 {
-    MojThreadWriteGuard guard(m_lock);
-    m_container.insert(Container::value_type(a_key, a_ids));
+    MojSize bytes = entryBytes(a_key, a_ids);
+
+    MojThreadGuard guard(m_mutex);
+    // an older result of the same query is replaced
+    Index::iterator iter = m_index.find(a_key);
+    if (iter != m_index.end())
+        erase(iter);
+    if (bytes > m_budget)
+        return MojErrNone;
+
+    Entry entry;
+    entry.m_key = a_key;
+    entry.m_ids = a_ids;
+    entry.m_bytes = bytes;
+    m_entries.push_front(entry);
+    m_index[a_key] = m_entries.begin();
+    m_bytes += bytes;
+    evict();
+
     return MojErrNone;
 }
 
 MojErr MojDbSearchCache::destroyCache(const QueryKey& a_key)
 {
-    MojThreadWriteGuard guard(m_lock);
-    m_container.erase(a_key);
+    MojThreadGuard guard(m_mutex);
+    Index::iterator iter = m_index.find(a_key);
+    if (iter != m_index.end())
+        erase(iter);
     return MojErrNone;
 }
 
 MojErr MojDbSearchCache::wipeWholeCache()
 {
-    MojThreadWriteGuard guard(m_lock);
-    m_container.clear();
+    MojThreadGuard guard(m_mutex);
+    m_index.clear();
+    m_entries.clear();
+    m_bytes = 0;
     return MojErrNone;
 }
 
 MojErr MojDbSearchCache::destroyCache(const MojString& a_kind)
 {
-    // TODO: Change this to use map::lower_bound or upper_bound.
-    //
-    MojThreadWriteGuard guard(m_lock);
-    std::vector<Container::key_type> keys;
-    for(auto i = m_container.begin(); i != m_container.end(); ++i)
-    {
-        if(i->first.m_kind == a_kind)
-            keys.push_back(i->first);
-    }
-
-    for(const auto& key: keys)
-    {
-        m_container.erase(key);
+    // only needed when a kind is created or replaced, revision changes are caught on lookup
+    MojThreadGuard guard(m_mutex);
+    for (EntryList::iterator i = m_entries.begin(); i != m_entries.end(); ) {
+        EntryList::iterator next = i;
+        ++next;
+        if (i->m_key.m_kind == a_kind)
+            erase(m_index.find(i->m_key));
+        i = next;
     }
 
     return MojErrNone;
@@ -122,14 +180,9 @@ MojErr MojDbSearchCache::updateCache(const QueryKey& a_key, const IdSet& a_ids)
     if (contain(a_key) == true)
         return MojErrNone;
 
-    // Delete any cache for this query/kind here.
-    //
-    MojErr err = destroyCache(a_key.getKind());
-    MojErrCheck(err);
-
-    // Add new cache.
+    // Add new cache, replacing any stale one for this query.
     //
-    err = createCache(a_key, a_ids);
+    MojErr err = createCache(a_key, a_ids);
     MojErrCheck(err);
 
     return MojErrNone;
@@ -137,11 +190,84 @@ MojErr MojDbSearchCache::updateCache(const QueryKey& a_key, const IdSet& a_ids)
 
 MojErr MojDbSearchCache::getIdSet(const QueryKey& a_key, IdSet& a_ids) const
 {
-    MojThreadReadGuard guard(m_lock);
-    Container::const_iterator citer = m_container.find(a_key);
-    if (citer != m_container.end())
-        a_ids = citer->second;
+    MojThreadGuard guard(m_mutex);
+    Index::const_iterator iter = m_index.find(a_key);
+    if (iter != m_index.end() && iter->second->m_key.getRev() == a_key.getRev())
+        a_ids = iter->second->m_ids;
+
+    return MojErrNone;
+}
+
+MojErr MojDbSearchCache::find(const QueryKey& a_key, IdSet& a_ids, bool& foundOut)
+{
+    foundOut = false;
+
+    MojThreadGuard guard(m_mutex);
+    Index::iterator iter = m_index.find(a_key);
+    if (iter == m_index.end()) {
+        ++m_misses;
+        return MojErrNone;
+    }
+    if (iter->second->m_key.getRev() != a_key.getRev()) {
+        // the kind changed since this result was cached
+        erase(iter);
+        ++m_invalidations;
+        ++m_misses;
+        return MojErrNone;
+    }
+    m_entries.splice(m_entries.begin(), m_entries, iter->second);
+    a_ids = iter->second->m_ids;
+    foundOut = true;
+    ++m_hits;
+
+    return MojErrNone;
+}
+
+MojErr MojDbSearchCache::stats(MojObject& objOut) const
+{
+    MojThreadGuard guard(m_mutex);
+    MojErr err = objOut.put(EntriesKey, (MojInt64) m_entries.size());
+    MojErrCheck(err);
+    err = objOut.put(BytesKey, (MojInt64) m_bytes);
+    MojErrCheck(err);
+    err = objOut.put(BudgetKey, (MojInt64) m_budget);
+    MojErrCheck(err);
+    err = objOut.put(HitsKey, m_hits);
+    MojErrCheck(err);
+    err = objOut.put(MissesKey, m_misses);
+    MojErrCheck(err);
+    err = objOut.put(EvictionsKey, m_evictions);
+    MojErrCheck(err);
+    err = objOut.put(InvalidationsKey, m_invalidations);
+    MojErrCheck(err);
 
     return MojErrNone;
 }
 
+MojSize MojDbSearchCache::entryBytes(const QueryKey& key, const IdSet& ids)
+{
+    // the key is held by both the entry and the index. ids generated by the db
+    // are short enough to be stored inside the MojObject itself
+    MojSize bytes = sizeof(Entry) + sizeof(QueryKey) + key.m_kind.length() + key.m_query.length();
+    return bytes + ids.size() * sizeof(MojObject);
+}
+
+void MojDbSearchCache::erase(Index::iterator iter)
+{
+    // called with m_mutex held
+    MojAssert(iter != m_index.end());
+    EntryList::iterator entry = iter->second;
+    MojAssert(m_bytes >= entry->m_bytes);
+    m_bytes -= entry->m_bytes;
+    m_index.erase(iter);
+    m_entries.erase(entry);
+}
+
+void MojDbSearchCache::evict()
+{
+    // called with m_mutex held
+    while (m_bytes > m_budget && !m_entries.empty()) {
+        erase(m_index.find(m_entries.back().m_key));
+        ++m_evictions;
+    }
+}
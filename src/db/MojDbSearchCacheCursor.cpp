@@ -21,6 +21,58 @@
 #include "db/MojDbKind.h"
 #include "db/MojDb.h"
 
+#include "db/MojDbQueryExecutor.h"
+#include <algorithm>
+
+// loads objects for a range of ids on one of the query executor threads
+class MojDbSearchCursor::LoadJob : public MojDbQueryExecutor::Job
+{
+public:
+	typedef std::vector<MojRefCountedPtr<MojDbObjectItem> > ItemSlots;
+
+	LoadJob(MojDbSearchCursor& cursor, const IdVec& ids, ItemSlots& slots)
+	: m_cursor(cursor), m_ids(ids), m_slots(slots) {}
+
+	virtual MojErr run(MojSize begin, MojSize end, MojSize)
+	{
+		for (MojSize i = begin; i < end; ++i) {
+			MojErr err = m_cursor.loadObject(*m_ids[i], m_slots[i]);
+			MojErrCheck(err);
+		}
+		return MojErrNone;
+	}
+
+private:
+	MojDbSearchCursor& m_cursor;
+	const IdVec& m_ids;
+	ItemSlots& m_slots;
+};
+
+// computes the sort key of each id with the extractor owned by the running slot
+class MojDbSearchCursor::KeyJob : public MojDbQueryExecutor::Job
+{
+public:
+	KeyJob(MojDbSearchCursor& cursor, const IdVec& ids, const ExtractorVec& extractors, EntryVec& entries)
+	: m_cursor(cursor), m_ids(ids), m_extractors(extractors), m_entries(entries) {}
+
+	virtual MojErr run(MojSize begin, MojSize end, MojSize slot)
+	{
+		// collators are not shared between threads
+		MojDbPropExtractor* extractor = m_extractors.empty() ? NULL : m_extractors[slot].get();
+		for (MojSize i = begin; i < end; ++i) {
+			MojErr err = m_cursor.loadKey(*m_ids[i], extractor, m_entries[i]);
+			MojErrCheck(err);
+		}
+		return MojErrNone;
+	}
+
+private:
+	MojDbSearchCursor& m_cursor;
+	const IdVec& m_ids;
+	const ExtractorVec& m_extractors;
+	EntryVec& m_entries;
+};
+
 MojDbSearchCursor::MojDbSearchCursor(MojString localeStr)
 : m_limit(0),
  m_pos(nullptr),
@@ -46,7 +98,6 @@ MojErr MojDbSearchCursor::close()
 	m_limitPos = NULL;
         m_cacheQuery.clear();
 	m_items.clear();
-	m_sequencedItems.clear();
 
 	return err;
 }
@@ -229,24 +280,25 @@ MojErr MojDbSearchCursor::begin()
         err = m_queryKey.fromQuery(m_cacheQuery, kind->getUpdateRevision());
         MojErrCheck(err);
 
+        // look up and copy out in one step, the entry may be evicted by another query
         bool fromCache = false;
-        if(cachePtr->contain(m_queryKey)) {
-            fromCache = true;
-        }
+        MojDbSearchCache::IdSet cachedIds;
+        err = cachePtr->find(m_queryKey, cachedIds, fromCache);
+        MojErrCheck(err);
 
-        err = load(cachePtr.get(), fromCache);
+        err = load(cachePtr.get(), fromCache, cachedIds);
         MojErrCheck(err);
     }
 
     return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::load(MojDbSearchCache* a_cache, bool fromCache)
+MojErr MojDbSearchCursor::load(MojDbSearchCache* a_cache, bool fromCache, const MojDbSearchCache::IdSet& cachedIds)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
     MojErr err = MojErrNone;
     if(fromCache) {
-        err = loadFromCache(a_cache);
+        err = loadFromCache(cachedIds);
         MojErrCheck(err);
         // Here we don't need sort(), distinct() and reverse(),
         // because we get the data with same query.
@@ -257,27 +309,10 @@ MojErr MojDbSearchCursor::load(MojDbSearchCache* a_cache, bool fromCache)
         // Here we don't need sort(), distinct() and reverse(),
         // because we get the data with same query.
     } else {
-        // pull unique ids from index
-        ObjectSet ids;
-        err = loadIds(ids);
+        // rank all matches by sort key, then load objects for the returned page only
+        err = loadRanked(a_cache);
         MojErrCheck(err);
-        // load objects into memory
-        err = loadObjects(ids);
-        MojErrCheck(err);
-        // sort results
-        if (!m_orderProp.empty()) {
-            err = sort();
-            MojErrCheck(err);
-        }
-        // distinct
-        if (!m_distinct.empty()) {
-            distinct();
-        }
-        // reverse for desc
-        if (m_query.desc()) {
-            err = m_items.reverse();
-            MojErrCheck(err);
-        }
+        return MojErrNone;
     }
     // next page
     if (!m_page.empty()) {
@@ -326,6 +361,8 @@ MojErr MojDbSearchCursor::loadWithImmediateReturn()
         MojErrCheck(err);
     }
 
+    // one view for the whole page, so the storage query can reuse its buffer
+    MojDbItemView view;
     for(;;) {
         // get current id
         MojObject id;
@@ -335,16 +372,18 @@ MojErr MojDbSearchCursor::loadWithImmediateReturn()
         if (!found) break;
 
         // get item by id
-        err = m_storageQuery->getById(id, obj, found, m_kindEngine);
+        err = m_storageQuery->getViewById(id, view, found, m_kindEngine);
         MojErrCheck(err);
         if (!found) break;
 
-        // filtering
+        // filtering, before the object gets materialized
         if (m_queryFilter.get()) {
-            err = m_queryFilter->test(obj, found);
+            err = m_queryFilter->test(view.view(), found);
             MojErrCheck(err);
             if (!found) continue;
         }
+        err = view.toObject(obj);
+        MojErrCheck(err);
 
         // create object item
         MojRefCountedPtr<MojDbObjectItem> item(new MojDbObjectItem(obj));
@@ -377,7 +416,7 @@ MojErr MojDbSearchCursor::loadIds(ObjectSet& idsOut)
 
 	MojUInt32 groupNum = 0;
 	bool found = false;
-	MojSharedPtr<ObjectSet> group;
+	MojSharedPtr<ObjectVec> group;
 	GroupMap groupMap;
 
 	for(;;) {
@@ -389,24 +428,18 @@ MojErr MojDbSearchCursor::loadIds(ObjectSet& idsOut)
 		if (!found)
 			break;
 
-		// if it is in a new group, create a new set
+		// if it is in a new group, find/create its id list
 		if (!group.get() || idGroupNum != groupNum) {
-			// find/create new group
-			GroupMap::Iterator iter;
-			err = groupMap.find(idGroupNum, iter);
-			MojErrCheck(err);
-			if (iter != groupMap.end()) {
-				group = iter.value();
-			} else {
-				err = group.resetChecked(new ObjectSet);
+			if (!groupMap.get(idGroupNum, group)) {
+				err = group.resetChecked(new ObjectVec);
 				MojErrCheck(err);
 				err = groupMap.put(idGroupNum, group);
 				MojErrCheck(err);
 			}
 			groupNum = idGroupNum;
 		}
-		// add id to current set
-		err = group->put(id);
+		// ids arrive in index order, so collect them and sort each group once below
+		err = group->push(id);
 		MojErrCheck(err);
 	}
 
@@ -418,90 +451,308 @@ MojErr MojDbSearchCursor::loadIds(ObjectSet& idsOut)
 	}
 
 	// find intersection of all groups
+	ObjectSet groupIds;
 	GroupMap::ConstIterator begin = groupMap.begin();
 	for (GroupMap::ConstIterator i = begin; i != groupMap.end(); ++i) {
+		const ObjectVec& ids = *(i.value());
 		if (i == begin) {
 			// special handling for first group
-			idsOut = *(i.value());
+			MojErr err = idsOut.put(ids.begin(), ids.end());
+			MojErrCheck(err);
 		} else {
-			MojErr err = idsOut.intersect(*(i.value()));
+			groupIds.clear();
+			MojErr err = groupIds.put(ids.begin(), ids.end());
+			MojErrCheck(err);
+			err = idsOut.intersect(groupIds);
 			MojErrCheck(err);
 		}
 	}
 	return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::loadObjects(const ObjectSet& ids)
+/***********************************************************************
+ * loadRanked
+ *
+ * Rank matches without materializing them.
+ *   1. Filter every matching id and compute the sort key of its order prop.
+ *   2. Find the page start, then select the next limit+1 entries with a
+ *      bounded heap. The whole order is only needed for distinct, and for
+ *      the first page of a query whose ids go to the search cache.
+ *   3. Load objects for the entries on the returned page.
+ ***********************************************************************/
+MojErr MojDbSearchCursor::loadRanked(MojDbSearchCache* a_cache)
 {
- LOG_TRACE("Entering function %s", __FUNCTION__);
-
-		MojUInt32 seqNum = 0;
-		GThreadPool *tpool = g_thread_pool_new(searchThread_caller, this, N_SEARCH_THREAD, TRUE, NULL);
-		for (ObjectSet::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
-			ObjectInfo* info = new ObjectInfo;
-			MojAllocCheck(info);
-			info->id = &(*i);
-			info->seqNum = seqNum++;
-			g_thread_pool_push(tpool, info, NULL);
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// pull unique ids from index
+	ObjectSet ids;
+	MojErr err = loadIds(ids);
+	MojErrCheck(err);
+	EntryVec entries;
+	err = loadKeys(ids, entries);
+	MojErrCheck(err);
+
+	EntryPtrVec ranked;
+	ranked.reserve(entries.size());
+	for (EntryVec::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+		if (i->found)
+			ranked.push_back(&(*i));
+	}
+
+	bool fillCache = m_page.empty() && ranked.size() > m_limit && !m_query.immediateReturn();
+	MojSize start = 0;
+	err = rank(ranked, start, fillCache || !m_distinct.empty());
+	MojErrCheck(err);
+
+	// the page id is gone or filtered out
+	if (start == MojInvalidIndex) {
+		m_count = 0;
+		return MojErrNone;
+	}
+
+	MojSize end = start + m_limit;
+	if (end >= ranked.size()) {
+		end = ranked.size();
+		m_page.clear();
+	} else {
+		m_page.fromObject(*ranked[end]->id);
+	}
+	m_count = static_cast<MojUInt32>(ranked.size() - start);
+
+	if (fillCache) {
+		MojDbSearchCache::IdSet cacheIds;
+		err = cacheIds.reserve(ranked.size());
+		MojErrCheck(err);
+		for (EntryPtrVec::const_iterator i = ranked.begin(); i != ranked.end(); ++i) {
+			err = cacheIds.push(*(*i)->id);
+			MojErrCheck(err);
 		}
-	g_thread_pool_free(tpool, FALSE /* processes remained tasks for tpool */, TRUE /* waits until all tasks for tpool are over */);
-	for (auto & item : m_sequencedItems)
-	m_items.push(item);
-return MojErrNone;
+		err = a_cache->updateCache(m_queryKey, cacheIds);
+		MojErrCheck(err);
+	}
+
+	// load objects into memory
+	IdVec pageIds;
+	pageIds.reserve(end - start);
+	for (MojSize i = start; i < end; ++i)
+		pageIds.push_back(ranked[i]->id);
+	err = loadObjects(pageIds);
+	MojErrCheck(err);
+
+	m_pos = m_items.begin();
+	m_limitPos = m_items.end();
+
+	return MojErrNone;
 }
 
-void MojDbSearchCursor::searchThread_caller(void *arg, void *user_data)
+MojErr MojDbSearchCursor::loadKeys(const ObjectSet& ids, EntryVec& entriesOut)
 {
-    ObjectInfo* info = reinterpret_cast<ObjectInfo *>(arg);
-    MojDbSearchCursor* thiz = reinterpret_cast<MojDbSearchCursor*>(user_data);
+    LOG_TRACE("Entering function %s", __FUNCTION__);
 
-    if (info)
-    {
-        MojErr err = thiz->searchThread_callee(info);
-        delete info;
-    }
+	MojDbQueryExecutor* executor = m_kindEngine->db()->queryExecutor();
+	ExtractorVec extractors;
+	if (!m_orderProp.empty()) {
+		for (MojSize i = 0; i < executor->slots(); ++i) {
+			MojRefCountedPtr<MojDbPropExtractor> extractor;
+			MojErr err = createExtractor(extractor);
+			MojErrCheck(err);
+			err = extractors.push(extractor);
+			MojErrCheck(err);
+		}
+	}
+
+	IdVec idVec;
+	idVec.reserve(ids.size());
+	for (ObjectSet::ConstIterator i = ids.begin(); i != ids.end(); ++i)
+		idVec.push_back(&(*i));
+
+	entriesOut.resize(idVec.size());
+	KeyJob job(*this, idVec, extractors, entriesOut);
+	MojErr err = executor->run(job, idVec.size());
+	MojErrCheck(err);
+
+	return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::searchThread_callee(const ObjectInfo* a_info)
+MojErr MojDbSearchCursor::loadKey(const MojObject& id, MojDbPropExtractor* extractor, SortEntry& entryOut)
 {
-    MojObject obj;
-    bool found = false;
-    // get item by id
-    MojErr err = m_storageQuery->getById(*a_info->id, obj, found, m_kindEngine);
-    if (err || !found)
-        return err;
-    if(found) {
-    // filter results
-        if (m_queryFilter.get()) {
-            bool isFound;
-            err = m_queryFilter->test(obj, isFound);
-            MojErrCheck(err);
-            if (!isFound) {
-                return MojErrNone;
-            }
-        }
+	entryOut.id = &id;
 
-        // create object item
-        MojRefCountedPtr<MojDbObjectItem> item(new MojDbObjectItem(obj));
-        MojAllocCheck(item.get());
-        // add to vec
-        MojThreadGuard guard(m_items_mutex);
-        err = m_sequencedItems.put(a_info->seqNum, item);
-        MojErrCheck(err);
-    }
+	// get item by id
+	MojDbItemView view;
+	bool found = false;
+	MojErr err = m_storageQuery->getViewById(id, view, found, m_kindEngine);
+	if (err == MojErrInternalIndexOnFind)
+		return MojErrNone;
+	MojErrCheck(err);
+	if (!found)
+		return MojErrNone;
 
-    return MojErrNone;
+	// filter results
+	if (m_queryFilter.get()) {
+		err = m_queryFilter->test(view.view(), found);
+		MojErrCheck(err);
+		if (!found)
+			return MojErrNone;
+	}
+	// sort key straight from the stored record
+	if (extractor) {
+		err = extractor->vals(view.view(), entryOut.keys);
+		MojErrCheck(err);
+	}
+	entryOut.found = true;
+
+	return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::loadFromCache(const MojDbSearchCache* cache)
+/***********************************************************************
+ * rank
+ *
+ * Order entries so that the page starting at startOut is in place.
+ * With fullOrder every entry is sorted, and distinct keeps the first id
+ * of each key. Otherwise only the limit+1 entries from the page start
+ * on are sorted. startOut is MojInvalidIndex if the page id isn't found.
+ ***********************************************************************/
+MojErr MojDbSearchCursor::rank(EntryPtrVec& entries, MojSize& startOut, bool fullOrder)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-    MojInt32 warns = 0;
-    MojDbSearchCache::IdSet ids;
-    MojErr err = cache->getIdSet(m_queryKey, ids);
-    MojErrCheck(err);
+	startOut = 0;
+	MojObject pageKey;
+	const SortEntry* pageEntry = NULL;
+	if (!m_page.empty()) {
+		MojErr err = m_page.toObject(pageKey);
+		MojErrCheck(err);
+		for (EntryPtrVec::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+			if (pageKey.compare(*(*i)->id) == 0) {
+				pageEntry = *i;
+				break;
+			}
+		}
+		if (!pageEntry) {
+			startOut = MojInvalidIndex;
+			return MojErrNone;
+		}
+	}
+
+	EntryComp comp(m_query.desc());
+	if (fullOrder) {
+		if (!m_distinct.empty()) {
+			// keep the first id of every key in ascending order, whatever the direction
+			EntryComp asc(false);
+			std::sort(entries.begin(), entries.end(), asc);
+			EntryPtrVec::iterator last = std::unique(entries.begin(), entries.end(),
+				[](const SortEntry* e1, const SortEntry* e2) { return e1->keys.compare(e2->keys) == 0; });
+			entries.erase(last, entries.end());
+			if (m_query.desc())
+				std::reverse(entries.begin(), entries.end());
+		} else {
+			std::sort(entries.begin(), entries.end(), comp);
+		}
+		if (pageEntry) {
+			EntryPtrVec::const_iterator i = std::find(entries.begin(), entries.end(), pageEntry);
+			startOut = (i == entries.end()) ? MojInvalidIndex : (MojSize) (i - entries.begin());
+		}
+		return MojErrNone;
+	}
+
+	// entries ahead of the page only need counting
+	EntryPtrVec::iterator first = entries.begin();
+	if (pageEntry) {
+		first = std::partition(entries.begin(), entries.end(),
+			[&comp, pageEntry](const SortEntry* e) { return comp(e, pageEntry); });
+		startOut = (MojSize) (first - entries.begin());
+	}
+	MojSize count = std::min<MojSize>((MojSize) (entries.end() - first), (MojSize) m_limit + 1);
+	std::partial_sort(first, first + count, entries.end(), comp);
+
+	return MojErrNone;
+}
+
+MojErr MojDbSearchCursor::createExtractor(MojRefCountedPtr<MojDbPropExtractor>& extractorOut)
+{
+	MojAssert(!m_orderProp.empty());
+
+	// create extractor for sort prop
+	MojRefCountedPtr<MojDbPropExtractor> extractor(new MojDbPropExtractor);
+	MojAllocCheck(extractor.get());
+	MojErr err = extractor->prop(m_orderProp);
+	MojErrCheck(err);
+	if (m_collation != MojDbCollationInvalid) {
+		// set collate
+		MojRefCountedPtr<MojDbTextCollator> collator(new MojDbTextCollator);
+		MojAllocCheck(collator.get());
+		// set locale
+		MojString locale = m_locale;
+		if (m_dbIndex) {
+			locale = m_dbIndex->locale();
+		}
+		err = collator->init(locale, m_collation);
+		MojErrCheck(err);
+		extractor->collator(collator.get());
+	}
+	extractorOut = extractor;
+
+	return MojErrNone;
+}
+
+MojErr MojDbSearchCursor::loadObjects(const IdVec& ids)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// each id has its own result slot, so items come back in order without locking
+	LoadJob::ItemSlots slots(ids.size());
+	LoadJob job(*this, ids, slots);
+	MojErr err = m_kindEngine->db()->queryExecutor()->run(job, ids.size());
+	MojErrCheck(err);
 
+	err = m_items.reserve(m_items.size() + slots.size());
+	MojErrCheck(err);
+	for (LoadJob::ItemSlots::const_iterator i = slots.begin(); i != slots.end(); ++i) {
+		if (i->get()) {
+			err = m_items.push(*i);
+			MojErrCheck(err);
+		}
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbSearchCursor::loadObject(const MojObject& id, MojRefCountedPtr<MojDbObjectItem>& itemOut)
+{
+	// get item by id
+	MojDbItemView view;
+	bool found = false;
+	MojErr err = m_storageQuery->getViewById(id, view, found, m_kindEngine);
+	if (err == MojErrInternalIndexOnFind)
+		return MojErrNone;
+	MojErrCheck(err);
+	if (!found)
+		return MojErrNone;
+
+	// filter results
+	if (m_queryFilter.get()) {
+		err = m_queryFilter->test(view.view(), found);
+		MojErrCheck(err);
+		if (!found)
+			return MojErrNone;
+	}
+	MojObject obj;
+	err = view.toObject(obj);
+	MojErrCheck(err);
+
+	// create object item
+	itemOut.reset(new MojDbObjectItem(obj));
+	MojAllocCheck(itemOut.get());
+
+	return MojErrNone;
+}
+
+MojErr MojDbSearchCursor::loadFromCache(const MojDbSearchCache::IdSet& ids)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    MojInt32 warns = 0;
+    MojErr err = MojErrNone;
     MojDbSearchCache::IdSet::Iterator it;
     MojUInt32 count=0;
 
@@ -582,62 +833,3 @@ MojErr MojDbSearchCursor::getIds(MojDbSearchCache::IdSet& sortedId)
 
     return MojErrNone;
 }
-
-MojErr MojDbSearchCursor::sort()
-{
-    LOG_TRACE("Entering function %s", __FUNCTION__);
-    MojAssert(!m_orderProp.empty());
-
-    // create extractor for sort prop
-    MojDbPropExtractor extractor;
-    MojErr err = extractor.prop(m_orderProp);
-    MojErrCheck(err);
-    if (m_collation != MojDbCollationInvalid) {
-        // set collate
-        MojRefCountedPtr<MojDbTextCollator> collator(new MojDbTextCollator);
-        MojAllocCheck(collator.get());
-        // set locale
-        MojString locale = m_locale;
-        if(m_dbIndex) {
-           locale = m_dbIndex->locale();
-        }
-        err = collator->init(locale, m_collation);
-        MojErrCheck(err);
-        extractor.collator(collator.get());
-    }
-
-    // create sort keys
-    ItemVec::Iterator begin;
-    err = m_items.begin(begin);
-    MojErrCheck(err);
-    for (ItemVec::Iterator i = begin; i != m_items.end(); ++i) {
-        KeySet keys;
-        err = extractor.vals((*i)->obj(), keys);
-        MojErrCheck(err);
-        (*i)->sortKeys(keys);
-    }
-
-	// sort
-	err = m_items.sort();
-	MojErrCheck(err);
-
-	return MojErrNone;
-}
-
-MojErr MojDbSearchCursor::distinct()
-{
-    LOG_TRACE("Entering function %s", __FUNCTION__);
-    MojAssert(!m_items.empty());
-    ItemComp itemComp;
-    MojSize idx = 0;
-    MojSize itemSize = m_items.size();
-    while(idx < itemSize-1) {
-        if(itemComp(m_items[idx],m_items[idx+1]) == 0) {
-            m_items.erase(idx+1);
-            itemSize = m_items.size();
-        } else {
-            idx++;
-        }
-    }
-    return MojErrNone;
-}
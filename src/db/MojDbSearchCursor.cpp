@@ -21,6 +21,33 @@
 #include "db/MojDbKind.h"
 #include "db/MojDb.h"
 
+#include <vector>
+
+// loads objects for a range of ids on one of the query executor threads
+class MojDbSearchCursor::LoadJob : public MojDbQueryExecutor::Job
+{
+public:
+	typedef std::vector<const MojObject*> IdVec;
+	typedef std::vector<MojRefCountedPtr<MojDbObjectItem> > ItemSlots;
+
+	LoadJob(MojDbSearchCursor& cursor, const IdVec& ids, ItemSlots& slots)
+	: m_cursor(cursor), m_ids(ids), m_slots(slots) {}
+
+	virtual MojErr run(MojSize begin, MojSize end, MojSize)
+	{
+		for (MojSize i = begin; i < end; ++i) {
+			MojErr err = m_cursor.loadObject(*m_ids[i], m_slots[i]);
+			MojErrCheck(err);
+		}
+		return MojErrNone;
+	}
+
+private:
+	MojDbSearchCursor& m_cursor;
+	const IdVec& m_ids;
+	ItemSlots& m_slots;
+};
+
 MojDbSearchCursor::MojDbSearchCursor(MojString localeStr)
 : m_limit(0),
   m_pos(nullptr),
@@ -45,7 +72,6 @@ MojErr MojDbSearchCursor::close()
 	m_pos = NULL;
 	m_limitPos = NULL;
 	m_items.clear();
-	m_sequencedItems.clear();
 
 	return err;
 }
@@ -281,6 +307,8 @@ MojErr MojDbSearchCursor::loadWithImmediateReturn()
             MojErrCheck(err);
         }
 
+        // one view for the whole page, so the storage query can reuse its buffer
+        MojDbItemView view;
         for(;;) {
                 // get current id
                 MojObject id;
@@ -290,16 +318,18 @@ MojErr MojDbSearchCursor::loadWithImmediateReturn()
                 if (!found) break;
 
                 // get item by id
-                err = m_storageQuery->getById(id, obj, found, m_kindEngine);
+                err = m_storageQuery->getViewById(id, view, found, m_kindEngine);
                 MojErrCheck(err);
                 if (!found) break;
 
-                // filtering
+                // filtering, before the object gets materialized
                 if (m_queryFilter.get()) {
-                        err = m_queryFilter->test(obj, found);
+                        err = m_queryFilter->test(view.view(), found);
                         MojErrCheck(err);
                         if (!found) continue;
                 }
+                err = view.toObject(obj);
+                MojErrCheck(err);
 
                 // create object item
                 MojRefCountedPtr<MojDbObjectItem> item(new MojDbObjectItem(obj));
@@ -331,7 +361,7 @@ MojErr MojDbSearchCursor::loadIds(ObjectSet& idsOut)
 
 	MojUInt32 groupNum = 0;
 	bool found = false;
-	MojSharedPtr<ObjectSet> group;
+	MojSharedPtr<ObjectVec> group;
 	GroupMap groupMap;
 
 	for(;;) {
@@ -343,24 +373,18 @@ MojErr MojDbSearchCursor::loadIds(ObjectSet& idsOut)
 		if (!found)
 			break;
 
-		// if it is in a new group, create a new set
+		// if it is in a new group, find/create its id list
 		if (!group.get() || idGroupNum != groupNum) {
-			// find/create new group
-			GroupMap::Iterator iter;
-			err = groupMap.find(idGroupNum, iter);
-			MojErrCheck(err);
-			if (iter != groupMap.end()) {
-				group = iter.value();
-			} else {
-				err = group.resetChecked(new ObjectSet);
+			if (!groupMap.get(idGroupNum, group)) {
+				err = group.resetChecked(new ObjectVec);
 				MojErrCheck(err);
 				err = groupMap.put(idGroupNum, group);
 				MojErrCheck(err);
 			}
 			groupNum = idGroupNum;
 		}
-		// add id to current set
-		err = group->put(id);
+		// ids arrive in index order, so collect them and sort each group once below
+		err = group->push(id);
 		MojErrCheck(err);
 	}
 
@@ -372,13 +396,19 @@ MojErr MojDbSearchCursor::loadIds(ObjectSet& idsOut)
 	}
 
 	// find intersection of all groups
+	ObjectSet groupIds;
 	GroupMap::ConstIterator begin = groupMap.begin();
 	for (GroupMap::ConstIterator i = begin; i != groupMap.end(); ++i) {
+		const ObjectVec& ids = *(i.value());
 		if (i == begin) {
 			// special handling for first group
-			idsOut = *(i.value());
+			MojErr err = idsOut.put(ids.begin(), ids.end());
+			MojErrCheck(err);
 		} else {
-			MojErr err = idsOut.intersect(*(i.value()));
+			groupIds.clear();
+			MojErr err = groupIds.put(ids.begin(), ids.end());
+			MojErrCheck(err);
+			err = idsOut.intersect(groupIds);
 			MojErrCheck(err);
 		}
 	}
@@ -387,63 +417,58 @@ MojErr MojDbSearchCursor::loadIds(ObjectSet& idsOut)
 
 MojErr MojDbSearchCursor::loadObjects(const ObjectSet& ids)
 {
- LOG_TRACE("Entering function %s", __FUNCTION__);
-
-		MojUInt32 seqNum = 0;
-		GThreadPool *tpool = g_thread_pool_new(searchThread_caller, this, N_SEARCH_THREAD, TRUE, NULL);
-		for (ObjectSet::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
-			ObjectInfo* info = new ObjectInfo;
-			MojAllocCheck(info);
-			info->id = &(*i);
-			info->seqNum = seqNum++;
-			g_thread_pool_push(tpool, info, NULL);
-		}
-	g_thread_pool_free(tpool, FALSE /* processes remained tasks for tpool */, TRUE /* waits until all tasks for tpool are over */);
-	for (auto & item : m_sequencedItems)
-		m_items.push(item);
-return MojErrNone;
-}
+    LOG_TRACE("Entering function %s", __FUNCTION__);
 
+	LoadJob::IdVec idVec;
+	idVec.reserve(ids.size());
+	for (ObjectSet::ConstIterator i = ids.begin(); i != ids.end(); ++i)
+		idVec.push_back(&(*i));
 
-void MojDbSearchCursor::searchThread_caller(void *arg, void *user_data)
-{
-    ObjectInfo* info = reinterpret_cast<ObjectInfo *>(arg);
-    MojDbSearchCursor* thiz = reinterpret_cast<MojDbSearchCursor*>(user_data);
+	// each id has its own result slot, so items come back in id order without locking
+	LoadJob::ItemSlots slots(idVec.size());
+	LoadJob job(*this, idVec, slots);
+	MojErr err = m_kindEngine->db()->queryExecutor()->run(job, idVec.size());
+	MojErrCheck(err);
 
-    MojErr err = thiz->searchThread_callee(info);
-    if (info)
-        delete info;
+	err = m_items.reserve(m_items.size() + slots.size());
+	MojErrCheck(err);
+	for (LoadJob::ItemSlots::const_iterator i = slots.begin(); i != slots.end(); ++i) {
+		if (i->get()) {
+			err = m_items.push(*i);
+			MojErrCheck(err);
+		}
+	}
+	return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::searchThread_callee(const ObjectInfo* a_info)
+MojErr MojDbSearchCursor::loadObject(const MojObject& id, MojRefCountedPtr<MojDbObjectItem>& itemOut)
 {
-    MojObject obj;
-    bool found = false;
-    // get item by id
-    MojErr err = m_storageQuery->getById(*a_info->id, obj, found, m_kindEngine);
-    if (err || !found)
-        return err;
-    if(found) {
-    // filter results
-        if (m_queryFilter.get() && m_cursorFilter == nullptr) {
-            bool isFound;
-            err = m_queryFilter->test(obj, isFound);
-            MojErrCheck(err);
-            if (!isFound) {
-                return MojErrNone;
-            }
-        }
+	// get item by id
+	MojDbItemView view;
+	bool found = false;
+	MojErr err = m_storageQuery->getViewById(id, view, found, m_kindEngine);
+	if (err == MojErrInternalIndexOnFind)
+		return MojErrNone;
+	MojErrCheck(err);
+	if (!found)
+		return MojErrNone;
 
-        // create object item
-        MojRefCountedPtr<MojDbObjectItem> item(new MojDbObjectItem(obj));
-        MojAllocCheck(item.get());
-        // add to vec
-        MojThreadGuard guard(m_items_mutex);
-        err = m_sequencedItems.put(a_info->seqNum, item);
-        MojErrCheck(err);
-    }
+	// filter results
+	if (m_queryFilter.get() && m_cursorFilter == nullptr) {
+		err = m_queryFilter->test(view.view(), found);
+		MojErrCheck(err);
+		if (!found)
+			return MojErrNone;
+	}
+	MojObject obj;
+	err = view.toObject(obj);
+	MojErrCheck(err);
 
- return MojErrNone;
+	// create object item
+	itemOut.reset(new MojDbObjectItem(obj));
+	MojAllocCheck(itemOut.get());
+
+	return MojErrNone;
 }
 
 MojErr MojDbSearchCursor::sort()
@@ -23,15 +23,20 @@ const MojChar* const MojDbServiceDefs::AssignIdKey = _T("assignId");
 const MojChar* const MojDbServiceDefs::BytesKey = _T("maxTempBytes");
 const MojChar* const MojDbServiceDefs::CallerKey = _T("caller");
 const MojChar* const MojDbServiceDefs::CountKey = _T("count");
+const MojChar* const MojDbServiceDefs::CollationCacheKey = _T("collationCache");
+const MojChar* const MojDbServiceDefs::CompactionKey = _T("compaction");
 const MojChar* const MojDbServiceDefs::CountryCodeKey = _T("countryCode");
 const MojChar* const MojDbServiceDefs::CreateKey = _T("create");
 const MojChar* const MojDbServiceDefs::DeleteKey = _T("delete");
 const MojChar* const MojDbServiceDefs::DeletedRevKey = _T("deletedRev");
 const MojChar* const MojDbServiceDefs::DescriptionKey = _T("description");
 const MojChar* const MojDbServiceDefs::DirKey = _T("tempDir");
+const MojChar* const MojDbServiceDefs::DispatcherKey = _T("dispatcher");
+const MojChar* const MojDbServiceDefs::ExplainKey = _T("explain");
 const MojChar* const MojDbServiceDefs::ExtendKey = _T("extend");
 const MojChar* const MojDbServiceDefs::FilesKey = _T("files");
 const MojChar* const MojDbServiceDefs::FiredKey = _T("fired");
+const MojChar* const MojDbServiceDefs::FormatKey = _T("format");
 const MojChar* const MojDbServiceDefs::FullKey = _T("full");
 const MojChar* const MojDbServiceDefs::HasMoreKey = _T("hasMore");
 const MojChar* const MojDbServiceDefs::IdKey = _T("id");
@@ -69,6 +74,7 @@ const MojChar* const MojDbServiceDefs::ResultsKey = _T("results");
 const MojChar* const MojDbServiceDefs::RevKey = _T("rev");
 const MojChar* const MojDbServiceDefs::ShardIdKey = _T("shardId");
 const MojChar* const MojDbServiceDefs::SizeKey = _T("size");
+const MojChar* const MojDbServiceDefs::SearchCacheKey = _T("searchCache");
 const MojChar* const MojDbServiceDefs::ServiceKey = _T("service");
 const MojChar* const MojDbServiceDefs::SubscribeKey = _T("subscribe");
 const MojChar* const MojDbServiceDefs::TypeKey = _T("type");
@@ -21,7 +21,9 @@
 
 #include "db/MojDbReq.h"
 #include "db/MojDbIndex.h"
+#include "db/MojDbTextCollator.h"
 #include "core/MojJson.h"
+#include "core/MojMessageDispatcher.h"
 #include <list>
 
 #ifndef WITH_SEARCH_QUERY_CACHE
@@ -307,10 +309,21 @@ MojErr MojDbServiceHandler::handleDump(MojServiceMessage* msg, MojObject& payloa
 	bool incDel = true;
 	payload.get(MojDbServiceDefs::IncludeDeletedKey, incDel);
 
-	MojUInt32 count = 0;
-	err = m_db.dump(path, count, incDel, req);
+	// binary dumps are picked up by load automatically
+	MojString format;
+	bool found = false;
+	err = payload.get(MojDbServiceDefs::FormatKey, format, found);
 	MojErrCheck(err);
 
+	MojUInt32 count = 0;
+	if (found && format == _T("binary")) {
+		err = m_db.dumpBinary(path, count, incDel, true, req);
+		MojErrCheck(err);
+	} else {
+		err = m_db.dump(path, count, incDel, req);
+		MojErrCheck(err);
+	}
+
 	err = formatCount(msg, count);
 	MojErrCheck(err);
 
@@ -711,6 +724,33 @@ MojErr MojDbServiceHandler::handleStats(MojServiceMessage* msg, MojObject& paylo
 	MojErrCheck(err);
 	err = writer.objectProp(MojDbServiceDefs::ResultsKey, results);
 	MojErrCheck(err);
+	MojMessageDispatcher* dispatcher = msg->service() ? msg->service()->dispatcher() : NULL;
+	if (dispatcher) {
+		MojObject dispatcherStats;
+		err = dispatcher->stats(dispatcherStats);
+		MojErrCheck(err);
+		err = writer.objectProp(MojDbServiceDefs::DispatcherKey, dispatcherStats);
+		MojErrCheck(err);
+	}
+	MojObject collationStats;
+	err = MojDbTextCollator::keyCache().stats(collationStats);
+	MojErrCheck(err);
+	err = writer.objectProp(MojDbServiceDefs::CollationCacheKey, collationStats);
+	MojErrCheck(err);
+	MojObject compactionStats;
+	err = m_db.storageEngine()->compactionStats(compactionStats);
+	MojErrCheck(err);
+	if (compactionStats.size() > 0) {
+		err = writer.objectProp(MojDbServiceDefs::CompactionKey, compactionStats);
+		MojErrCheck(err);
+	}
+#ifdef WITH_SEARCH_QUERY_CACHE
+	MojObject cacheStats;
+	err = m_db.searchCache()->stats(cacheStats);
+	MojErrCheck(err);
+	err = writer.objectProp(MojDbServiceDefs::SearchCacheKey, cacheStats);
+	MojErrCheck(err);
+#endif
 	err = writer.endObject();
 	MojErrCheck(err);
 
@@ -1108,6 +1148,8 @@ MojErr MojDbServiceHandler::findImpl(MojServiceMessage* msg, MojObject& payload,
 	MojErrCheck(err);
 	bool doWatch = false;
 	payload.get(MojDbServiceDefs::WatchKey, doWatch);
+	bool doExplain = false;
+	payload.get(MojDbServiceDefs::ExplainKey, doExplain);
 
     MojString localeStr;
     err = m_db.getLocale(localeStr, req);
@@ -1118,6 +1160,7 @@ MojErr MojDbServiceHandler::findImpl(MojServiceMessage* msg, MojObject& payload,
     query.locale(localeStr);
 	err = query.fromObject(queryObj);
 	MojErrCheck(err);
+	query.explain(doExplain);
 	MojUInt32 limit = query.limit();
 	if (limit == MojDbQuery::LimitDefault){
 		query.limit(MaxQueryLimit);
@@ -1176,6 +1219,12 @@ MojErr MojDbServiceHandler::findImpl(MojServiceMessage* msg, MojObject& payload,
 		MojErrCheck(err);
 	}
 
+	// append query plan
+	if (doExplain && !cursor.plan().undefined()) {
+		err = writer.objectProp(MojDbServiceDefs::ExplainKey, cursor.plan());
+		MojErrCheck(err);
+	}
+
 	err = writer.endObject();
 	MojErrCheck(err);
 
@@ -1214,7 +1263,7 @@ MojErr MojDbServiceHandler::Watcher::handleWatch()
 	MojRefCountedPtr<MojServiceMessage> msg = m_msg;
 
     LOG_DEBUG("[db_mojodb] Watcher_handleWatch: %s, - sender= %s; appId= %s; subscribed= %d; replies= %zu;\n response= %s\n",
-        msg->method(), msg->senderName(), msg->appId(), (int)msg->subscribed(), msg->numReplies(), ((MojJsonWriter&)(msg->writer())).json().data());
+        msg->method(), msg->senderName(), msg->appId(), (int)msg->subscribed(), msg->numReplies(), msg->replyJson().data());
 
 	m_msg.reset();
 
@@ -182,7 +182,7 @@ MojErr MojDbServiceHandlerBase::invokeCallback(Callback method, MojServiceMessag
 	(void) MojErrToString(err, errStr);
 	(void) payload.toJson(payloadstr);
     LOG_DEBUG("[db_mojodb] db_method: %s, err: (%d) - %s; sender= %s;\n payload=%s; \n response= %s\n",
-        msg->method(), (int)err, errStr.data(), msg->senderName(), payloadstr.data(), ((MojJsonWriter&)(msg->writer())).json().data());
+        msg->method(), (int)err, errStr.data(), msg->senderName(), payloadstr.data(), msg->replyJson().data());
 #endif
 
 
@@ -108,6 +108,7 @@
 	 _T("\"properties\":{") \
 		 _T("\"query\":") MOJ_QUERY_SCHEMA _T(",") \
 		 _T("\"count\":{\"type\":\"boolean\",\"optional\":true},") \
+		 _T("\"explain\":{\"type\":\"boolean\",\"optional\":true},") \
 		 _T("\"watch\":{\"type\":\"boolean\",\"optional\":true},") \
 		 _T("\"subscribe\":{\"type\":\"boolean\",\"optional\":true}},") \
 	 _T("\"additionalProperties\":false}")
@@ -175,7 +176,8 @@ const MojChar* const MojDbServiceHandler::DumpSchema =
 	_T("{\"type\":\"object\",")
 	 _T("\"properties\":{")
 		 _T("\"path\":{\"type\":\"string\"},")
-		 _T("\"incDel\":{\"type\":\"boolean\",\"optional\":true}},")
+		 _T("\"incDel\":{\"type\":\"boolean\",\"optional\":true},")
+		 _T("\"format\":{\"type\":\"string\",\"enum\":[\"json\",\"binary\"],\"optional\":true}},")
 	 _T("\"additionalProperties\":false}");
 
 const MojChar* const MojDbServiceHandler::FindSchema = MOJ_FIND_SCHEMA;
@@ -18,6 +18,7 @@
 #include <cstdlib>
 
 #include "db/MojDbStorageEngine.h"
+#include "db/MojDbKindEngine.h"
 #include "core/MojObjectBuilder.h"
 #include "core/MojJson.h"
 #include "core/MojLogDb8.h"
@@ -25,14 +26,14 @@
 MojDbStorageEngine::Factory MojDbStorageEngine::m_factory;
 MojDbStorageEngine::Factories MojDbStorageEngine::m_factories;
 
-MojErr MojDbStorageItem::toObject(MojObject& objOut, MojDbKindEngine& kindEngine, bool headerExpected) const
+MojErr MojDbStorageItem::toObject(MojObject& objOut, MojDbKindEngine& kindEngine, bool headerExpected, MojObjectArena* arena) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojObjectBuilder builder;
+	MojObjectBuilder builder(arena);
 	MojErr err = visit(builder, kindEngine, headerExpected);
 	MojErrCheck(err);
-	objOut = builder.object();
+	objOut.assign(builder.object(), arena);
 	return MojErrNone;
 }
 
@@ -47,6 +48,67 @@ MojErr MojDbStorageItem::toJson(MojString& strOut, MojDbKindEngine& kindEngine)
 	return MojErrNone;
 }
 
+MojErr MojDbStorageItem::view(MojDbItemView& viewOut, MojDbKindEngine& kindEngine) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojObject obj;
+	MojErr err = toObject(obj, kindEngine);
+	MojErrCheck(err);
+	viewOut.assign(obj);
+	return MojErrNone;
+}
+
+void MojDbItemView::assign(const MojObject& obj)
+{
+	m_item.reset();
+	m_header.clear();
+	m_obj = obj;
+	m_view = MojObjectView(m_obj);
+}
+
+void MojDbItemView::assign(const MojDbStorageItem* item, const MojByte* data, MojSize size)
+{
+	// header and token set must already be filled in by the item,
+	// the ref only keeps the record bytes alive
+	m_item.reset(const_cast<MojDbStorageItem*>(item));
+	m_obj.clear();
+	m_view = MojObjectView(data, size, &m_tokenSet, &m_header);
+}
+
+void MojDbItemView::release()
+{
+	// drops the ref on the record, the token set stays for the next one
+	m_item.reset();
+	m_obj.clear();
+	m_view = MojObjectView(m_obj);
+}
+
+MojErr MojDbItemView::tokenSet(const MojString& kindId, MojDbKindEngine& kindEngine)
+{
+	if (!m_tokenKind.empty() && m_tokenKind == kindId)
+		return MojErrNone;
+
+	m_tokenKind.clear();
+	MojErr err = kindEngine.tokenSet(kindId, m_tokenSet);
+	MojErrCheck(err);
+	m_tokenKind = kindId;
+
+	return MojErrNone;
+}
+
+MojErr MojDbStorageQuery::getViewById(const MojObject& id, MojDbItemView& viewOut, bool& foundOut, MojDbKindEngine* kindEngine)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojObject obj;
+	MojErr err = getById(id, obj, foundOut, kindEngine);
+	MojErrCheck(err);
+	if (foundOut)
+		viewOut.assign(obj);
+	return MojErrNone;
+}
+
 MojErr MojDbStorageEngine::createDefaultEngine(MojRefCountedPtr<MojDbStorageEngine>& engineOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -180,6 +242,8 @@ MojDbStorageTxn::MojDbStorageTxn()
 : m_quotaEnabled(true),
   m_refreshQuotas(false),
   m_quotaEngine(NULL),
+  m_usageEpoch(0),
+  m_usageApplied(false),
   m_preCommit(this),
   m_postCommit(this)
 {
@@ -250,6 +314,10 @@ MojErr MojDbStorageTxn::commit()
 	}
 
 	err = commitImpl();
+	if (m_quotaEngine) {
+		MojErr errUsage = m_quotaEngine->commitUsage(this, err == MojErrNone);
+		MojErrAccumulate(err, errUsage);
+	}
 	MojErrCheck(err);
 
 	err = m_postCommit.fire(this);
@@ -22,6 +22,160 @@
 #include "unicode/ucol.h"
 #include "core/MojLogDb8.h"
 
+const MojChar* const MojDbSortKeyCache::SizeKey = _T("collationCacheSize");
+const MojChar* const MojDbSortKeyCache::EntriesKey = _T("entries");
+const MojChar* const MojDbSortKeyCache::BytesKey = _T("bytes");
+const MojChar* const MojDbSortKeyCache::HitsKey = _T("hits");
+const MojChar* const MojDbSortKeyCache::MissesKey = _T("misses");
+
+MojDbSortKeyCache::MojDbSortKeyCache()
+: m_budget((MojInt32) (SizeDefault / NumShards))
+{
+}
+
+MojErr MojDbSortKeyCache::configure(const MojObject& conf)
+{
+	MojInt64 size = SizeDefault;
+	if (conf.get(SizeKey, size) && (size < 0 || size > MojInt32Max))
+		MojErrThrowMsg(MojErrInvalidArg, _T("db: %s out of range"), SizeKey);
+
+	m_budget = (MojInt32) (size / NumShards);
+	for (MojSize i = 0; i < NumShards; ++i) {
+		MojThreadGuard guard(m_shards[i].m_mutex);
+		evict(m_shards[i], (MojSize) m_budget.value());
+	}
+
+	return MojErrNone;
+}
+
+bool MojDbSortKeyCache::get(const MojString& key, MojDbKey& valOut)
+{
+	Shard& sh = shard(key);
+	MojThreadGuard guard(sh.m_mutex);
+	Index::iterator iter = sh.m_index.find(key);
+	if (iter == sh.m_index.end()) {
+		++sh.m_misses;
+		return false;
+	}
+	sh.m_entries.splice(sh.m_entries.begin(), sh.m_entries, iter->second);
+	valOut = iter->second->m_val;
+	++sh.m_hits;
+
+	return true;
+}
+
+void MojDbSortKeyCache::put(const MojString& key, const MojDbKey& val)
+{
+	// the key is held by both the list entry and the index
+	MojSize bytes = sizeof(Entry) + sizeof(MojString) + key.length() * 2 + val.size();
+	MojSize budget = (MojSize) m_budget.value();
+	if (bytes > budget)
+		return;
+
+	Shard& sh = shard(key);
+	MojThreadGuard guard(sh.m_mutex);
+	// another thread may have computed the same key meanwhile
+	if (sh.m_index.find(key) != sh.m_index.end())
+		return;
+
+	Entry entry;
+	entry.m_key = key;
+	entry.m_val = val;
+	entry.m_bytes = bytes;
+	sh.m_entries.push_front(entry);
+	sh.m_index[key] = sh.m_entries.begin();
+	sh.m_bytes += bytes;
+	evict(sh, budget);
+}
+
+void MojDbSortKeyCache::clear()
+{
+	for (MojSize i = 0; i < NumShards; ++i) {
+		Shard& sh = m_shards[i];
+		MojThreadGuard guard(sh.m_mutex);
+		sh.m_index.clear();
+		sh.m_entries.clear();
+		sh.m_bytes = 0;
+		sh.m_hits = 0;
+		sh.m_misses = 0;
+	}
+}
+
+MojErr MojDbSortKeyCache::stats(MojObject& objOut) const
+{
+	MojInt64 entries = 0;
+	MojInt64 bytes = 0;
+	MojInt64 hits = 0;
+	MojInt64 misses = 0;
+	for (MojSize i = 0; i < NumShards; ++i) {
+		const Shard& sh = m_shards[i];
+		MojThreadGuard guard(sh.m_mutex);
+		entries += (MojInt64) sh.m_entries.size();
+		bytes += (MojInt64) sh.m_bytes;
+		hits += sh.m_hits;
+		misses += sh.m_misses;
+	}
+
+	MojErr err = objOut.put(EntriesKey, entries);
+	MojErrCheck(err);
+	err = objOut.put(BytesKey, bytes);
+	MojErrCheck(err);
+	err = objOut.put(HitsKey, hits);
+	MojErrCheck(err);
+	err = objOut.put(MissesKey, misses);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojSize MojDbSortKeyCache::size() const
+{
+	MojSize size = 0;
+	for (MojSize i = 0; i < NumShards; ++i) {
+		MojThreadGuard guard(m_shards[i].m_mutex);
+		size += m_shards[i].m_entries.size();
+	}
+	return size;
+}
+
+MojInt64 MojDbSortKeyCache::hits() const
+{
+	MojInt64 hits = 0;
+	for (MojSize i = 0; i < NumShards; ++i) {
+		MojThreadGuard guard(m_shards[i].m_mutex);
+		hits += m_shards[i].m_hits;
+	}
+	return hits;
+}
+
+MojInt64 MojDbSortKeyCache::misses() const
+{
+	MojInt64 misses = 0;
+	for (MojSize i = 0; i < NumShards; ++i) {
+		MojThreadGuard guard(m_shards[i].m_mutex);
+		misses += m_shards[i].m_misses;
+	}
+	return misses;
+}
+
+MojDbSortKeyCache::Shard& MojDbSortKeyCache::shard(const MojString& key)
+{
+	// high bits, the index buckets already use the low ones
+	return m_shards[(MojHash(key.data(), key.length()) >> 16) % NumShards];
+}
+
+void MojDbSortKeyCache::evict(Shard& sh, MojSize budget)
+{
+	// called with the shard mutex held
+	while (sh.m_bytes > budget && !sh.m_entries.empty()) {
+		Entry& last = sh.m_entries.back();
+		MojAssert(sh.m_bytes >= last.m_bytes);
+		sh.m_bytes -= last.m_bytes;
+		sh.m_index.erase(last.m_key);
+		sh.m_entries.pop_back();
+	}
+}
+
 MojDbTextCollator::MojDbTextCollator()
 : m_ucol(NULL)
 {
@@ -73,6 +227,10 @@ MojErr MojDbTextCollator::init(const MojChar* locale, MojDbCollationStrength lev
 	MojUnicodeErrCheck(status);
 	ucol_setStrength(m_ucol, strength);
 
+	// collators opened with the same locale and strength produce the same keys
+	MojErr err = m_cacheTag.format(_T("%s/%d:"), locale, (int) level);
+	MojErrCheck(err);
+
 	return MojErrNone;
 }
 
@@ -80,6 +238,48 @@ MojErr MojDbTextCollator::sortKey(const MojString& str, MojDbKey& keyOut) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
+	if (str.length() > MojDbSortKeyCache::MaxStringLen)
+		return sortKeyUncached(str, keyOut);
+
+	MojString cacheKey;
+	MojErr err = cacheKey.reserve(m_cacheTag.length() + str.length());
+	MojErrCheck(err);
+	err = cacheKey.append(m_cacheTag);
+	MojErrCheck(err);
+	err = cacheKey.append(str);
+	MojErrCheck(err);
+
+	MojDbSortKeyCache& cache = keyCache();
+	if (cache.get(cacheKey, keyOut))
+		return MojErrNone;
+
+	err = sortKeyUncached(str, keyOut);
+	MojErrCheck(err);
+	cache.put(cacheKey, keyOut);
+
+	return MojErrNone;
+}
+
+MojDbSortKeyCache& MojDbTextCollator::keyCache()
+{
+	static MojDbSortKeyCache s_cache;
+	return s_cache;
+}
+
+MojErr MojDbTextCollator::sortKeyUncached(const MojString& str, MojDbKey& keyOut) const
+{
+	// ASCII maps one to one onto UTF-16, no need to run the UTF-8 decoder
+	const MojChar* data = str.data();
+	MojSize len = str.length();
+	if (len <= AsciiMax) {
+		UChar chars[AsciiMax];
+		MojSize i = 0;
+		for (; i < len && !(data[i] & 0x80); ++i)
+			chars[i] = (UChar) data[i];
+		if (i == len)
+			return sortKey(chars, len, keyOut);
+	}
+
 	// convert to UChar from utf8
 	MojDbTextUtils::UnicodeVec chars;
 	MojErr err = MojDbTextUtils::strToUnicode(str, chars);
@@ -19,9 +19,37 @@
 #include "db/MojDbTextCollator.h"
 #include "db/MojDbTextUtils.h"
 #include "db/MojDbKey.h"
+#include "core/MojHashMap.h"
 #include "core/MojObject.h"
 #include "core/MojString.h"
+#include "core/MojThread.h"
 #include "core/MojLogDb8.h"
+#include <algorithm>
+
+namespace {
+
+// per-thread tokenizer state, ICU break iterators must not be shared between threads
+struct TokenizerState : private MojNoCopy
+{
+	typedef MojHashMap<MojString, UBreakIterator*, const MojChar*> IterMap;
+
+	~TokenizerState()
+	{
+		for (IterMap::ConstIterator i = m_iters.begin(); i != m_iters.end(); ++i)
+			ubrk_close(*i);
+	}
+
+	IterMap m_iters; // by locale
+	MojDbTextUtils::UnicodeVec m_chars;
+};
+
+MojErr tokenizerState(TokenizerState*& stateOut)
+{
+	static MojThreadLocalValue<TokenizerState> s_state;
+	return s_state.get(stateOut);
+}
+
+}
 
 MojDbTextTokenizer::MojDbTextTokenizer()
 {
@@ -36,10 +64,12 @@ MojErr MojDbTextTokenizer::init(const MojChar* locale)
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(locale);
 
-	UErrorCode status = U_ZERO_ERROR;
-	m_ubrk.reset(ubrk_open(UBRK_WORD, locale, NULL, 0, &status));
-	MojUnicodeErrCheck(status);
-	MojAssert(m_ubrk.get());
+	MojErr err = m_locale.assign(locale);
+	MojErrCheck(err);
+	// open the iterator now so a bad locale fails here rather than on put
+	UBreakIterator* ubrk = NULL;
+	err = breakIter(ubrk);
+	MojErrCheck(err);
 
 	return MojErrNone;
 }
@@ -47,27 +77,42 @@ MojErr MojDbTextTokenizer::init(const MojChar* locale)
 MojErr MojDbTextTokenizer::tokenize(const MojString& text, MojDbTextCollator* collator, KeySet& keysOut) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
-	MojAssert(m_ubrk.get());
 
-	// convert to UChar from str
-	MojDbTextUtils::UnicodeVec unicodeStr;
-	MojErr err = MojDbTextUtils::strToUnicode(text, unicodeStr);
+	KeyVec keys;
+	MojErr err = tokenize(text, collator, keys);
+	MojErrCheck(err);
+	err = keysOut.put(keys.begin(), keys.end());
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbTextTokenizer::tokenize(const MojString& text, MojDbTextCollator* collator, KeyVec& keysOut) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	keysOut.clear();
+
+	TokenizerState* state = NULL;
+	MojErr err = tokenizerState(state);
+	MojErrCheck(err);
+	UBreakIterator* ubrk = NULL;
+	err = breakIter(ubrk);
+	MojErrCheck(err);
+
+	// convert to UChar from str, reusing this thread's buffer
+	MojDbTextUtils::UnicodeVec& unicodeStr = state->m_chars;
+	err = MojDbTextUtils::strToUnicode(text, unicodeStr);
 	MojErrCheck(err);
 
-	// clone break iterator and set text
-	MojByte buf[U_BRK_SAFECLONE_BUFFERSIZE];
 	UErrorCode status = U_ZERO_ERROR;
-	MojInt32 size = sizeof(buf);
-	IterPtr ubrk(ubrk_safeClone(m_ubrk.get(), buf, &size, &status));
-	MojUnicodeErrCheck(status);
-	MojAssert(ubrk.get());
-	ubrk_setText(ubrk.get(), unicodeStr.begin(), (MojInt32) unicodeStr.size(), &status);
+	ubrk_setText(ubrk, unicodeStr.begin(), (MojInt32) unicodeStr.size(), &status);
 	MojUnicodeErrCheck(status);
 
 	MojInt32 tokBegin = -1;
-	MojInt32 pos = ubrk_first(ubrk.get());
+	MojInt32 pos = ubrk_first(ubrk);
 	while (pos != UBRK_DONE) {
-		UWordBreak status = (UWordBreak) ubrk_getRuleStatus(ubrk.get());
+		UWordBreak status = (UWordBreak) ubrk_getRuleStatus(ubrk);
 		if (status != UBRK_WORD_NONE) {
 			MojAssert(tokBegin != -1);
 			MojDbKey key;
@@ -83,11 +128,88 @@ MojErr MojDbTextTokenizer::tokenize(const MojString& text, MojDbTextCollator* co
 				err = key.assign(tok);
 				MojErrCheck(err);
 			}
-			err = keysOut.put(key);
+			err = keysOut.push(key);
 			MojErrCheck(err);
 		}
 		tokBegin = pos;
-		pos = ubrk_next(ubrk.get());
+		pos = ubrk_next(ubrk);
+	}
+
+	// sort and drop repeated words
+	KeyVec::Iterator begin;
+	err = keysOut.begin(begin);
+	MojErrCheck(err);
+	KeyVec::Iterator end = begin + keysOut.size();
+	std::sort(begin, end);
+	MojSize numUnique = (MojSize) (std::unique(begin, end) - begin);
+	err = keysOut.resize(numUnique);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbTextTokenizer::diff(const MojString& oldText, const MojString& newText, MojDbTextCollator* collator,
+		KeyVec& addedOut, KeyVec& removedOut) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	addedOut.clear();
+	removedOut.clear();
+	if (oldText == newText)
+		return MojErrNone;
+
+	KeyVec oldKeys;
+	MojErr err = tokenize(oldText, collator, oldKeys);
+	MojErrCheck(err);
+	KeyVec newKeys;
+	err = tokenize(newText, collator, newKeys);
+	MojErrCheck(err);
+
+	// both are sorted, so one merge pass finds the differences
+	KeyVec::ConstIterator oldIter = oldKeys.begin();
+	KeyVec::ConstIterator newIter = newKeys.begin();
+	while (oldIter != oldKeys.end() || newIter != newKeys.end()) {
+		int comp = 0;
+		if (oldIter == oldKeys.end())
+			comp = 1;
+		else if (newIter == newKeys.end())
+			comp = -1;
+		else
+			comp = oldIter->compare(*newIter);
+
+		if (comp < 0) {
+			err = removedOut.push(*oldIter++);
+			MojErrCheck(err);
+		} else if (comp > 0) {
+			err = addedOut.push(*newIter++);
+			MojErrCheck(err);
+		} else {
+			++oldIter;
+			++newIter;
+		}
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbTextTokenizer::breakIter(UBreakIterator*& iterOut) const
+{
+	MojAssert(!m_locale.empty());
+
+	TokenizerState* state = NULL;
+	MojErr err = tokenizerState(state);
+	MojErrCheck(err);
+	if (state->m_iters.get(m_locale.data(), iterOut))
+		return MojErrNone;
+
+	UErrorCode status = U_ZERO_ERROR;
+	iterOut = ubrk_open(UBRK_WORD, m_locale.data(), NULL, 0, &status);
+	MojUnicodeErrCheck(status);
+	MojAssert(iterOut);
+	err = state->m_iters.put(m_locale, iterOut);
+	if (err != MojErrNone) {
+		ubrk_close(iterOut);
+		iterOut = NULL;
+		MojErrThrow(err);
 	}
 	return MojErrNone;
 }
@@ -144,6 +144,31 @@ MojErr MojDbBerkeleyCursor::delPrefix(const MojDbKey& prefix)
 	return MojErrNone;
 }
 
+MojErr MojDbBerkeleyCursor::delRange(const MojDbKey& from, const MojDbKey& to, MojSize& countOut, MojSize& sizeOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	countOut = 0;
+	sizeOut = 0;
+	MojDbBerkeleyItem val;
+	MojDbBerkeleyItem key;
+	MojErr err = key.fromBytes(from.data(), from.size());
+	MojErrCheck(err);
+
+	bool found = false;
+	err = get(key, val, found, DB_SET_RANGE);
+	MojErrCheck(err);
+	while (found && MojLexicalCompare(key.data(), key.size(), to.data(), to.size()) < 0) {
+		++countOut;
+		sizeOut += key.size();
+		err = del();
+		MojErrCheck(err);
+		err = get(key, val, found, DB_NEXT);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
 MojErr MojDbBerkeleyCursor::get(MojDbBerkeleyItem& key, MojDbBerkeleyItem& val, bool& foundOut, MojUInt32 flags)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -1607,6 +1632,22 @@ MojErr MojDbBerkeleyIndex::del(const MojDbKey& key, MojDbStorageTxn* txn)
 	return MojErrNone;
 }
 
+MojErr MojDbBerkeleyIndex::delRange(const MojDbKey& from, const MojDbKey& to, MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	MojDbBerkeleyCursor cursor;
+	MojErr err = cursor.open(m_db.get(), txn, 0);
+	MojErrCheck(err);
+	err = cursor.delRange(from, to, countOut, sizeOut);
+	MojErrCheck(err);
+	err = cursor.close();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbBerkeleyIndex::find(MojAutoPtr<MojDbQueryPlan> plan, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageQuery>& queryOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
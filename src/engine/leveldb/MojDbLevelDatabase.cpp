@@ -91,6 +91,9 @@ MojErr MojDbLevelDatabase::close()
 
     MojErr err = MojErrNone;
     if (m_db) {
+        std::string part;
+        MojDbLevelEngine::partId(m_db, part);
+        engine()->compactScheduler().forget(part);
         err = closeImpl();
         m_primaryProps.clear();
         engine()->removeDatabase(this);
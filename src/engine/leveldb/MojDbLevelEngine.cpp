@@ -51,7 +51,8 @@ leveldb::Options MojDbLevelEngine::OpenOptions;
 ////////////////////MojDbLevelEngine////////////////////////////////////////////
 
 MojDbLevelEngine::MojDbLevelEngine()
-: m_isOpen(false)
+: m_isOpen(false),
+  m_compactScheduler(*this)
 {
 }
 
@@ -104,6 +105,10 @@ MojErr MojDbLevelEngine::configure(const MojObject& config)
 
     OpenOptions.create_if_missing = true;
 
+    // background compaction of recently written ranges, compactBudget 0 disables
+    MojErr err = m_compactScheduler.configure(config);
+    MojErrCheck(err);
+
     return MojErrNone;
 }
 
@@ -183,6 +188,9 @@ MojErr MojDbLevelEngine::open(const MojChar* path, MojDbEnv* env)
     MojErrCheck(err);
     m_isOpen = true;
 
+    err = m_compactScheduler.start();
+    MojErrCheck(err);
+
     return MojErrNone;
 }
 
@@ -192,6 +200,10 @@ MojErr MojDbLevelEngine::close()
     MojErr err = MojErrNone;
     MojErr errClose = MojErrNone;
 
+    // no compaction steps while the databases go away
+    errClose = m_compactScheduler.stop();
+    MojErrAccumulate(err, errClose);
+
     // close seqs before closing their databases
     m_seqs.clear();
 
@@ -286,6 +298,43 @@ MojErr MojDbLevelEngine::compact()
         MojAssert(db);
         db->compact();
     }
+    m_compactScheduler.reset();
+
+    return MojErrNone;
+}
+
+MojErr MojDbLevelEngine::compactionStats(MojObject& objOut)
+{
+    return m_compactScheduler.stats(objOut);
+}
+
+void MojDbLevelEngine::partId(const leveldb::DB* db, std::string& partOut)
+{
+    partOut.assign(reinterpret_cast<const char*>(&db), sizeof(db));
+}
+
+MojErr MojDbLevelEngine::compactRange(const std::string& part, const std::string& from, const std::string& to)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    // the database may have been closed since, keep it open while compacting
+    MojRefCountedPtr<MojDbLevelDatabase> db;
+    MojThreadGuard guard(m_dbMutex);
+    for (DatabaseVec::ConstIterator i = m_dbs.begin(); i != m_dbs.end(); ++i) {
+        std::string dbPart;
+        partId((*i)->impl(), dbPart);
+        if (dbPart == part) {
+            db = *i;
+            break;
+        }
+    }
+    guard.unlock();
+    if (!db.get() || !db->impl())
+        return MojErrNone;
+
+    leveldb::Slice begin(from);
+    leveldb::Slice end(to);
+    db->impl()->CompactRange(&begin, &end);
 
     return MojErrNone;
 }
@@ -165,6 +165,14 @@ MojErr MojDbLevelTableTxn::commitImpl()
     return MojErrNone;
 }
 
+void MojDbLevelTableTxn::touched(MojDbCompactScheduler::Range& rangeOut) const
+{
+    for (PendingDeletes::const_iterator it = m_pendingDeletes.begin(); it != m_pendingDeletes.end(); ++it)
+        rangeOut.note(it->data(), it->size(), 0, it->size());
+    for (PendingValues::const_iterator it = m_pendingValues.begin(); it != m_pendingValues.end(); ++it)
+        rangeOut.note(it->first.data(), it->first.size(), it->first.size() + it->second.size(), 0);
+}
+
 void MojDbLevelTableTxn::cleanup()
 {
     m_db = NULL;
@@ -185,6 +193,7 @@ MojErr MojDbLevelEnvTxn::begin(MojDbLevelEngine* eng)
 {
     // TODO: mutex and lock-file serialization to implement strongest
     //       isolation level
+    m_engine = eng;
     return MojErrNone;
 }
 
@@ -215,12 +224,26 @@ MojDbLevelTableTxn &MojDbLevelEnvTxn::tableTxn(leveldb::DB &db)
 MojErr MojDbLevelEnvTxn::commitImpl()
 {
     MojErr accErr = MojErrNone;
+    bool track = m_engine && m_engine->compactScheduler().enabled();
+    MojDbCompactScheduler::RangeMap touched;
     for(TableTxns::iterator it = m_tableTxns.begin();
                             it != m_tableTxns.end();
                             ++it)
     {
+        // commit forgets both the writes and the db, so look at them first
+        MojDbCompactScheduler::Range range;
+        std::string part;
+        if (track)
+        {
+            (*it)->touched(range);
+            MojDbLevelEngine::partId((*it)->db(), part);
+        }
         MojErr err = (*it)->commitImpl();
         MojErrAccumulate(accErr, err);
+        if (track && err == MojErrNone && range.debt() > 0)
+            touched[part].merge(range);
     }
+    if (track)
+        m_engine->compactScheduler().noteCommit(touched);
     return accErr;
 }
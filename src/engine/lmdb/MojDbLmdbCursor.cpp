@@ -18,6 +18,7 @@
 #include "engine/lmdb/MojDbLmdbCursor.h"
 #include "engine/lmdb/MojDbLmdbDatabase.h"
 #include "engine/lmdb/MojDbLmdbErr.h"
+#include "core/MojUtil.h"
 
 
 MojDbLmdbCursor::MojDbLmdbCursor()
@@ -93,6 +94,29 @@ MojErr MojDbLmdbCursor::delPrefix(const MojDbKey& prefix)
 	return MojErrNone;
 }
 
+MojErr MojDbLmdbCursor::delRange(const MojDbKey& from, const MojDbKey& to, MojSize& countOut, MojSize& sizeOut)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	countOut = 0;
+	sizeOut = 0;
+	MojDbLmdbItem val, key;
+	MojErr err = key.fromBytes(from.data(), from.size());
+	MojErrCheck(err);
+	bool found = false;
+	err = get(key, val, found, MDB_SET_RANGE);
+	MojErrCheck(err);
+	while (found && MojLexicalCompare(key.data(), key.size(), to.data(), to.size()) < 0) {
+		++countOut;
+		sizeOut += key.size();
+		err = del();
+		MojErrCheck(err);
+		err = get(key, val, found, MDB_NEXT);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
 MojErr MojDbLmdbCursor::get(MojDbLmdbItem& key, MojDbLmdbItem& val, bool& foundOut, MDB_cursor_op flags)
 {
 	LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -107,8 +131,15 @@ MojErr MojDbLmdbCursor::get(MojDbLmdbItem& key, MojDbLmdbItem& val, bool& foundO
 	if (dbErr != MDB_NOTFOUND) {
 		MojLmdbErrCheck(dbErr, _T("m_dbc->get"));
 		foundOut = true;
-		key.fromBytes(keyItem.data(), keyItem.size());
-		val.fromBytes(valItem.data(), valItem.size());
+		if (static_cast<MojDbLmdbTxn*>(m_txn)->zeroCopy()) {
+			key.fromMap(keyItem.data(), keyItem.size());
+			val.fromMap(valItem.data(), valItem.size());
+		} else {
+			MojErr err = key.fromBytes(keyItem.data(), keyItem.size());
+			MojErrCheck(err);
+			err = val.fromBytes(valItem.data(), valItem.size());
+			MojErrCheck(err);
+		}
 		m_recSize = key.size() + val.size();
 	}
 	return MojErrNone;
@@ -214,7 +214,12 @@ MojErr MojDbLmdbDatabase::get(MojDbLmdbItem& key, MojDbStorageTxn* txn, bool for
 	int dbErr = mdb_get(dbTxn, m_db, key.impl(), &mdbVal);
 	if (dbErr != MDB_NOTFOUND) {
 		MojLmdbErrCheck(dbErr, _T("db->get"));
-		valOut.fromBytes((MojByte*) mdbVal.mv_data, mdbVal.mv_size);
+		if (static_cast<MojDbLmdbTxn*>(txn)->zeroCopy()) {
+			valOut.fromMap((MojByte*) mdbVal.mv_data, mdbVal.mv_size);
+		} else {
+			MojErr err = valOut.fromBytes((MojByte*) mdbVal.mv_data, mdbVal.mv_size);
+			MojErrCheck(err);
+		}
 		foundOut = true;
 	}
 #if defined(MOJ_DEBUG)
@@ -252,6 +257,9 @@ MojErr MojDbLmdbDatabase::get(const MojObject& id, MojDbStorageTxn* txn, bool fo
 	MojErrCheck(err);
 
 	if (found) {
+		// the caller may keep the item past the txn, let the txn copy it out then
+		err = static_cast<MojDbLmdbTxn*>(txn)->lend(valItem.get());
+		MojErrCheck(err);
 		valItem->setHeader(id);
 		itemOut = valItem;
 	}
@@ -38,6 +38,8 @@ MojDbLmdbEngine::~MojDbLmdbEngine()
 MojErr MojDbLmdbEngine::configure(const MojObject& conf)
 {
 	LOG_TRACE("Entering function %s", __FUNCTION__);
+	// only used when we create the env ourselves in open(path)
+	m_conf = conf;
 	return MojErrNone;
 }
 
@@ -65,7 +67,9 @@ MojErr MojDbLmdbEngine::open(const MojChar* path)
 	MojAssert(!m_env.get() && !m_isOpen);
 	MojRefCountedPtr<MojDbLmdbEnv> env(new MojDbLmdbEnv);
 	MojAllocCheck(env.get());
-	MojErr err = env->open(path);
+	MojErr err = env->configure(m_conf);
+	MojErrCheck(err);
+	err = env->open(path);
 	MojErrCheck(err);
 	err = open(nullptr, env.get());
 	MojErrCheck(err);
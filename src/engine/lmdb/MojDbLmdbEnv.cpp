@@ -25,7 +25,8 @@ const MojChar* const MojDbLmdbEnv::LockFileName = _T("_lmdblock");
 
 MojDbLmdbEnv::MojDbLmdbEnv()
 : m_lockFile(MojInvalidFile),
-  m_env(nullptr)
+  m_env(nullptr),
+  m_zeroCopyReads(true)
 {
 }
 
@@ -39,6 +40,13 @@ MojErr MojDbLmdbEnv::configure(const MojObject& conf)
 {
 	LOG_TRACE("Entering function %s", __FUNCTION__);
 	m_conf = conf;
+
+	MojUInt32 zeroCopy = 1;
+	bool found = false;
+	MojErr err = m_conf.get("zeroCopyReads", zeroCopy, found);
+	MojErrCheck(err);
+	m_zeroCopyReads = (zeroCopy != 0);
+
 	return MojErrNone;
 }
 MojErr MojDbLmdbEnv::create()
@@ -137,6 +137,21 @@ MojErr MojDbLmdbIndex::del(const MojDbKey& key, MojDbStorageTxn* txn)
 	return MojErrNone;
 }
 
+MojErr MojDbLmdbIndex::delRange(const MojDbKey& from, const MojDbKey& to, MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	MojDbLmdbCursor cursor;
+	MojErr err = cursor.open(m_db.get(), txn);
+	MojErrCheck(err);
+	err = cursor.delRange(from, to, countOut, sizeOut);
+	MojErrCheck(err);
+	cursor.close();
+
+	return MojErrNone;
+}
+
 MojErr MojDbLmdbIndex::find(MojAutoPtr<MojDbQueryPlan> plan, MojDbStorageTxn* txn,
 		MojRefCountedPtr<MojDbStorageQuery>& queryOut)
 {
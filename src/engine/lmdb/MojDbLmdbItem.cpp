@@ -19,7 +19,8 @@
 #include "core/MojObjectBuilder.h"
 
 MojDbLmdbItem::MojDbLmdbItem()
-:m_free(nullptr)
+:m_free(nullptr),
+ m_borrowed(false)
 {
 	MojZero(&m_dbt, sizeof(MDB_val));
 }
@@ -68,6 +69,7 @@ void MojDbLmdbItem::clear()
 	freeData();
 	m_chunk.reset();
 	m_free = nullptr;
+	m_borrowed = false;
 	m_dbt.mv_data = nullptr;
 	m_dbt.mv_size = 0;
 }
@@ -101,6 +103,33 @@ void MojDbLmdbItem::fromBytesNoCopy(const MojByte* bytes, MojSize size)
 		setData(const_cast<MojByte*>(bytes), size, NULL);
 }
 
+void MojDbLmdbItem::fromMap(const MojByte* bytes, MojSize size)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	// bytes live in the lmdb map and stay valid only until the read txn ends
+	fromBytesNoCopy(bytes, size);
+	m_borrowed = (size != 0);
+}
+
+MojErr MojDbLmdbItem::detach()
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	if (!m_borrowed)
+		return MojErrNone;
+
+	// keep the header reader where it was, the header may already be parsed
+	MojDataReader& reader = m_header.reader().dataReader();
+	MojSize offset = 0;
+	if (reader.begin() == data())
+		offset = static_cast<MojSize>(reader.pos() - reader.begin());
+	MojErr err = fromBytes(data(), size());
+	MojErrCheck(err);
+	err = reader.skip(offset);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbLmdbItem::fromBuffer(MojBuffer& buf)
 {
 	LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -159,6 +188,7 @@ void MojDbLmdbItem::setData(MojByte* bytes, MojSize size, void (*free)(void*))
 
 	freeData();
 	m_free = free;
+	m_borrowed = false;
 	m_dbt.mv_size = static_cast<size_t>(size);
 	m_dbt.mv_data = bytes;
 	m_header.reader().data(bytes, size);
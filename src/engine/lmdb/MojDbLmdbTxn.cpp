@@ -20,7 +20,8 @@
 
 MojDbLmdbTxn::MojDbLmdbTxn()
 : m_engine(nullptr),
-  m_txn(nullptr)
+  m_txn(nullptr),
+  m_zeroCopy(false)
 
 {
 }
@@ -39,6 +40,8 @@ MojErr MojDbLmdbTxn::abort()
 	LOG_TRACE("Entering function %s [%d]", __FUNCTION__,mdb_txn_id(m_txn));
 	LOG_WARNING(MSGID_DB_LMDB_TXN_WARNING, 0, "lmdb: transaction aborted");
 
+	MojErr err = detachLent();
+	MojErrCatchAll(err);
 	if (m_txn) {
 		mdb_txn_abort(m_txn);
 		m_txn = nullptr;
@@ -56,6 +59,8 @@ MojErr MojDbLmdbTxn::commitImpl()
 	MojAssert(m_txn);
 	LOG_TRACE("Entering function %s [%d]", __FUNCTION__ ,mdb_txn_id(m_txn));
 
+	MojErr err = detachLent();
+	MojErrCheck(err);
 	if (m_txn) {
 		int dbErr = mdb_txn_commit(m_txn);
 		MojLmdbErrCheck(dbErr, _T("txn->commit"));
@@ -81,6 +86,7 @@ MojErr MojDbLmdbTxn::begin(MojDbLmdbEngine* eng, bool isWriteOp, MojDbStorageTxn
 	LOG_TRACE("Entering function %s [%d] [%d]", __FUNCTION__, mdb_txn_id(txn) ,mdb_txn_id(pTxn));
 	m_txn = txn;
 	m_engine = eng;
+	m_zeroCopy = !isWriteOp && eng->env()->zeroCopyReads();
 
 	return MojErrNone;
 
@@ -89,6 +95,8 @@ MojErr MojDbLmdbTxn::begin(MojDbLmdbEngine* eng, bool isWriteOp, MojDbStorageTxn
 MojErr MojDbLmdbTxn::reset()
 {
 	MojAssert(m_txn);
+	MojErr err = detachLent();
+	MojErrCheck(err);
 	mdb_txn_reset(m_txn);
 
 	return MojErrNone;
@@ -102,3 +110,31 @@ MojErr MojDbLmdbTxn::renew()
 
 	return MojErrNone;
 }
+
+MojErr MojDbLmdbTxn::lend(MojDbLmdbItem* item)
+{
+	MojAssert(item);
+	if (!item->borrowed())
+		return MojErrNone;
+
+	MojErr err = m_lent.push(item);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbLmdbTxn::detachLent()
+{
+	// items still referenced outside the txn get their own copy before the map
+	// pages they point to can be reused
+	MojErr err = MojErrNone;
+	for (ItemVec::ConstIterator i = m_lent.begin(); i != m_lent.end(); ++i) {
+		if ((*i)->refCount() > 1) {
+			MojErr errDetach = (*i)->detach();
+			MojErrAccumulate(err, errDetach);
+		}
+	}
+	m_lent.clear();
+
+	return err;
+}
@@ -14,6 +14,8 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
+
 #include "db/MojDb.h"
 #include "engine/sandwich/MojDbSandwichDatabase.h"
 #include "engine/sandwich/MojDbSandwichEngine.h"
@@ -228,6 +230,8 @@ MojErr MojDbSandwichDatabase::put(MojDbShardId shardId, MojDbSandwichItem& key,
         err = leveldb_txn->useShard(m_cookie, shardId, part);
         MojErrCheck(err);
         s = part.Put(*key.impl(), *val.impl());
+        leveldb_txn->dirty(shardId);
+        leveldb_txn->touched(shardId, m_cookie, *key.impl(), key.size() + val.size(), 0);
     }
     else
     {
@@ -235,6 +239,11 @@ MojErr MojDbSandwichDatabase::put(MojDbShardId shardId, MojDbSandwichItem& key,
         err = m_engine->useShard(m_cookie, shardId, part);
         MojErrCheck(err);
         s = part.Put(*key.impl(), *val.impl());
+        if (s.ok())
+        {
+            err = m_engine->syncShard(shardId);
+            MojErrCheck(err);
+        }
     }
 
 #if defined(MOJ_DEBUG)
@@ -300,6 +309,37 @@ MojErr MojDbSandwichDatabase::get(MojDbShardId shardId, MojDbSandwichItem& key,
 
     return MojErrNone;
 }
+
+MojErr MojDbSandwichDatabase::multiGet(MojDbShardId shardId, std::vector<std::string>& keys, MojDbSandwichEnvTxn& txn,
+                                       std::unordered_map<std::string, std::string>& valsOut,
+                                       std::unordered_set<std::string>& missesOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    mojo::SandwichTxn::Part part;
+    MojErr err = txn.useShard(m_cookie, shardId, part);
+    MojErrCheck(err);
+
+    // resolve all keys with a single forward sweep instead of one random read per key
+    std::sort(keys.begin(), keys.end());
+    auto it = part.NewIterator();
+    for (const std::string& key : keys) {
+        leveldb::Slice target(key);
+        // neighbouring keys often share a block, only seek when the iterator is behind
+        if (!it->Valid() || it->key().compare(target) < 0)
+            it->Seek(target);
+        if (it->Valid() && it->key() == target)
+            valsOut.emplace(key, it->value().ToString());
+        else if (it->status().ok())
+            missesOut.insert(key);
+        else
+            break;
+    }
+    leveldb::Status s = it->status();
+    MojLdbErrCheck(s, _T("db->multiGet"));
+
+    return MojErrNone;
+}
 #ifdef LMDB_ENGINE_SUPPORT
 MojErr MojDbSandwichDatabase::beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut, bool isWriteOp)
 #else
@@ -354,6 +394,8 @@ MojErr MojDbSandwichDatabase::del(MojDbShardId shardId, MojDbSandwichItem& key,
         err = leveldb_txn->useShard(m_cookie, shardId, part);
         MojErrCheck(err);
         part.Delete(*key.impl());
+        leveldb_txn->dirty(shardId);
+        leveldb_txn->touched(shardId, m_cookie, *key.impl(), 0, key.size());
     }
     else
     {
@@ -361,6 +403,11 @@ MojErr MojDbSandwichDatabase::del(MojDbShardId shardId, MojDbSandwichItem& key,
         err = m_engine->useShard(m_cookie, shardId, part);
         MojErrCheck(err);
         st = part.Delete(*key.impl());
+        if (st.ok())
+        {
+            err = m_engine->syncShard(shardId);
+            MojErrCheck(err);
+        }
     }
 
 #if defined(MOJ_DEBUG)
@@ -399,14 +446,48 @@ MojErr MojDbSandwichDatabase::delPrefix(MojDbSandwichEnvTxn &txn, leveldb::Slice
         MojErr err = txn.offsetQuota(-(MojInt64) delSize);
         MojErrCheck(err);
 
+        txn.touched(shardId, m_cookie, key, 0, delSize);
         auto s = part.Delete(key);
         MojLdbErrCheck(s, _T("db->delPrefix"));
+        txn.dirty(shardId);
 
         it->Next(); // skip this ghost record
     }
     return MojErrNone;
 }
 
+MojErr MojDbSandwichDatabase::delRange(MojDbSandwichEnvTxn &txn, leveldb::Slice from, leveldb::Slice to, MojSize& countOut, MojSize& sizeOut)
+{
+    MojDbShardId shardId = MojDbIdGenerator::MainShardId; // FIXME: parameter and loop through all shards
+
+    countOut = 0;
+    sizeOut = 0;
+    mojo::SandwichTxn::Part part;
+    MojErr err = txn.useShard(m_cookie, shardId, part);
+    MojErrCheck(err);
+    auto it = part.NewIterator();
+
+    it->Seek(from);
+    while (it->Valid() && it->key().compare(to) < 0)
+    {
+        auto key = it->key();
+
+        size_t delSize = key.size() + it->value().size();
+        err = txn.offsetQuota(-(MojInt64) delSize);
+        MojErrCheck(err);
+        ++countOut;
+        sizeOut += key.size();
+
+        txn.touched(shardId, m_cookie, key, 0, delSize);
+        auto s = part.Delete(key);
+        MojLdbErrCheck(s, _T("db->delRange"));
+        txn.dirty(shardId);
+
+        it->Next();
+    }
+    return MojErrNone;
+}
+
 MojErr MojDbSandwichDatabase::stats(MojDbSandwichEnvTxn* txn, MojSize &countOut, MojSize &sizeOut, leveldb::Slice prefix)
 {
     MojDbShardId shardId = MojDbIdGenerator::MainShardId; // FIXME: parameter and loop through all shards
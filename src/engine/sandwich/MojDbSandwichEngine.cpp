@@ -20,6 +20,8 @@
 #include <leveldb/ref_db.hpp>
 #include <sys/statvfs.h>
 #include <leveldb/cache.h>
+#include <cstring>
+#include <type_traits>
 
 #include "engine/sandwich/MojDbSandwichEngine.h"
 #include "engine/sandwich/MojDbSandwichFactory.h"
@@ -50,12 +52,13 @@ static const MojChar* const MojEnvSeqDbName = _T("seq.ldb");
 leveldb::ReadOptions MojDbSandwichEngine::ReadOptions;
 leveldb::WriteOptions MojDbSandwichEngine::WriteOptions;
 leveldb::Options MojDbSandwichEngine::OpenOptions;
+MojSize MojDbSandwichEngine::JoinWindow = MojDbSandwichEngine::JoinWindowDefault;
 
 
 ////////////////////MojDbSandwichEngine////////////////////////////////////////////
 
 MojDbSandwichEngine::MojDbSandwichEngine()
-: m_isOpen(false), m_lazySync(false), m_updater(NULL)
+: m_isOpen(false), m_lazySync(false), m_updater(NULL), m_compactScheduler(*this)
 {
     m_updater = new MojDbSandwichLazyUpdater;
 }
@@ -141,6 +144,42 @@ MojErr MojDbSandwichEngine::configure(const MojObject& config)
         OpenOptions.block_cache = leveldb::NewLRUCache(cacheSize);
     }
 
+    // number of primary records fetched ahead of an index scan, 0 disables batching
+    MojInt64 joinWindow = 0;
+    if (!config.get("joinWindow", joinWindow)) {
+        JoinWindow = JoinWindowDefault;
+    } else if (joinWindow < 0) {
+        LOG_ERROR (MSGID_DB_ERROR, 0, "joinWindow parameter is not valid");
+        return MojErrInvalidArg;
+    } else {
+        JoinWindow = (MojSize) joinWindow;
+    }
+
+    // transactions committing together share one fsync, 0 or 1 disables
+    MojInt64 groupCommit = 0;
+    if (!config.get("groupCommit", groupCommit)) {
+        groupCommit = MojDbSandwichGroupCommit::MaxBatchDefault;
+    } else if (groupCommit < 0) {
+        LOG_ERROR (MSGID_DB_ERROR, 0, "groupCommit parameter is not valid");
+        return MojErrInvalidArg;
+    }
+    // how long a group may wait for transactions still writing (microsecs)
+    MojInt64 groupCommitDelay = 0;
+    if (!config.get("groupCommitDelay", groupCommitDelay)) {
+        groupCommitDelay = MojDbSandwichGroupCommit::MaxDelayDefault;
+    } else if (groupCommitDelay < 0) {
+        LOG_ERROR (MSGID_DB_ERROR, 0, "groupCommitDelay parameter is not valid");
+        return MojErrInvalidArg;
+    }
+    // nothing to share when writes don't sync anyway
+    if (!WriteOptions.sync)
+        groupCommit = 0;
+    m_groupCommit.configure((MojSize) groupCommit, groupCommitDelay);
+
+    // background compaction of recently written ranges, compactBudget 0 disables
+    MojErr err = m_compactScheduler.configure(config);
+    MojErrCheck(err);
+
     return MojErrNone;
 }
 
@@ -204,7 +243,7 @@ MojErr MojDbSandwichEngine::open(const MojChar* path, MojDbEnv* env)
 
     // TODO: consider moving to configure
     m_bottom.options = MojDbSandwichEngine::getOpenOptions();
-    m_bottom.writeOptions = MojDbSandwichEngine::getWriteOptions();
+    m_bottom.writeOptions = bottomWriteOptions();
     m_bottom.readOptions = MojDbSandwichEngine::getReadOptions();
 
     if (path)
@@ -235,6 +274,11 @@ MojErr MojDbSandwichEngine::open(const MojChar* path, MojDbEnv* env)
     MojErrCheck(err);
     m_isOpen = true;
 
+    if (path) {
+        err = m_compactScheduler.start();
+        MojErrCheck(err);
+    }
+
     if (lazySync())
         m_updater->start();
 
@@ -247,6 +291,10 @@ MojErr MojDbSandwichEngine::close()
     MojErr err = MojErrNone;
     MojErr errClose = MojErrNone;
 
+    // no compaction steps while the databases go away
+    errClose = m_compactScheduler.stop();
+    MojErrAccumulate(err, errClose);
+
     // close seqs before closing their databases
     m_seqs.clear();
 
@@ -321,7 +369,7 @@ MojErr MojDbSandwichEngine::mountShard(MojDbShardId shardId, const MojString& da
     sandwich.reset(new mojo::Sandwich {});
     auto &bottom = **sandwich;
     bottom.options = MojDbSandwichEngine::getOpenOptions();
-    bottom.writeOptions = MojDbSandwichEngine::getWriteOptions();
+    bottom.writeOptions = bottomWriteOptions();
     bottom.readOptions = MojDbSandwichEngine::getReadOptions();
     leveldb::Status status = bottom.Open(databasePath.data());
 
@@ -334,6 +382,7 @@ MojErr MojDbSandwichEngine::mountShard(MojDbShardId shardId, const MojString& da
 
     MojLdbErrCheck(status, _T("db_create/db_open"));
 
+    MojThreadGuard guard(m_dbMutex);
     auto emplaceInfo = m_sandwiches.emplace(shardId, std::move(sandwich));
     if (!emplaceInfo.second)
     {
@@ -351,6 +400,7 @@ MojErr MojDbSandwichEngine::unMountShard(MojDbShardId shardId)
         MojErrThrowMsg(MojErrDbInvalidShardId, "Can't unmount main shard %s",
                        std::to_string(shardId).c_str());
     }
+    MojThreadGuard guard(m_dbMutex);
     if (m_sandwiches.erase(shardId) == 0)
     {
         MojErrThrowMsg(MojErrDbInvalidShardId, "Shard %s wasn't mounted",
@@ -360,6 +410,31 @@ MojErr MojDbSandwichEngine::unMountShard(MojDbShardId shardId)
 }
 
 
+MojErr MojDbSandwichEngine::syncShard(MojDbShardId shardId)
+{
+    if (!m_groupCommit.enabled())
+        return MojErrNone;
+
+    auto it = m_sandwiches.find(shardId);
+    if (it == m_sandwiches.end())
+    {
+        MojErrThrowMsg(MojErrDbInvalidShardId, "Shard %s not found", std::to_string(shardId).c_str());
+    }
+    MojErr err = m_groupCommit.sync({ (**it->second).get() });
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+leveldb::WriteOptions MojDbSandwichEngine::bottomWriteOptions() const
+{
+    // with group commit the sync is issued once per group by MojDbSandwichGroupCommit
+    leveldb::WriteOptions options = getWriteOptions();
+    if (m_groupCommit.enabled())
+        options.sync = false;
+    return options;
+}
+
 MojErr MojDbSandwichEngine::openSequence(const MojChar* name, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageSeq>& seqOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -386,6 +461,47 @@ MojErr MojDbSandwichEngine::compact()
     MojThreadGuard guard(m_dbMutex);
 
     m_bottom->CompactRange(nullptr, nullptr);
+    m_compactScheduler.reset();
+
+    return MojErrNone;
+}
+
+MojErr MojDbSandwichEngine::compactionStats(MojObject& objOut)
+{
+    return m_compactScheduler.stats(objOut);
+}
+
+void MojDbSandwichEngine::partId(MojDbShardId shardId, const mojo::Sandwich::Cookie &cookie, std::string &partOut)
+{
+    static_assert(std::is_trivially_copyable<mojo::Sandwich::Cookie>::value, "cookie is stored as raw bytes");
+    partOut.assign(reinterpret_cast<const char*>(&shardId), sizeof(shardId));
+    partOut.append(reinterpret_cast<const char*>(&cookie), sizeof(cookie));
+}
+
+MojErr MojDbSandwichEngine::compactRange(const std::string& part, const std::string& from, const std::string& to)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    MojDbShardId shardId;
+    if (part.size() != sizeof(shardId) + sizeof(mojo::Sandwich::Cookie))
+        MojErrThrow(MojErrInvalidArg);
+    memcpy(&shardId, part.data(), sizeof(shardId));
+
+    // the shard may be unmounted meanwhile, keep it alive while compacting
+    mojo::SharedSandwich sandwich;
+    {
+        MojThreadGuard guard(m_dbMutex);
+        auto it = m_sandwiches.find(shardId);
+        if (it == m_sandwiches.end())
+            return MojErrNone;
+        sandwich = it->second;
+    }
+
+    // leveldb-tl has no API that maps a part range to bottom db keys, so the
+    // whole bottom db of the shard is compacted. That covers every other part
+    // of the shard as well, their debt goes with it.
+    (**sandwich)->CompactRange(nullptr, nullptr);
+    m_compactScheduler.forgetPrefix(part.substr(0, sizeof(shardId)));
 
     return MojErrNone;
 }
@@ -0,0 +1,151 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <leveldb/write_batch.h>
+
+#include "engine/sandwich/MojDbSandwichGroupCommit.h"
+#include "engine/sandwich/defs.h"
+#include "core/MojTime.h"
+
+MojDbSandwichGroupCommit::MojDbSandwichGroupCommit()
+: m_maxBatch(0),
+  m_maxDelay(MaxDelayDefault),
+  m_writing(0),
+  m_written(0),
+  m_synced(0),
+  m_leader(false),
+  m_commits(0),
+  m_syncs(0)
+{
+}
+
+void MojDbSandwichGroupCommit::configure(MojSize maxBatch, MojInt64 maxDelay)
+{
+    MojThreadGuard guard(m_mutex);
+    m_maxBatch = maxBatch;
+    m_maxDelay = maxDelay;
+}
+
+void MojDbSandwichGroupCommit::begin()
+{
+    MojThreadGuard guard(m_mutex);
+    ++m_writing;
+}
+
+void MojDbSandwichGroupCommit::end()
+{
+    MojThreadGuard guard(m_mutex);
+    MojAssert(m_writing > 0);
+    --m_writing;
+    // a leader collecting the group may be waiting on us
+    if (m_leader && m_writing == 0)
+        m_cond.broadcast();
+}
+
+MojErr MojDbSandwichGroupCommit::sync(const DbVec& dbs)
+{
+    if (dbs.empty())
+        return MojErrNone;
+
+    MojThreadGuard guard(m_mutex);
+    MojUInt64 ticket = ++m_written;
+    m_pending.insert(dbs.begin(), dbs.end());
+    ++m_commits;
+    if (m_leader && m_written - m_synced >= m_maxBatch)
+        m_cond.broadcast();
+
+    while (m_synced < ticket) {
+        if (m_leader) {
+            MojErr err = m_cond.wait(m_mutex);
+            MojErrCheck(err);
+            continue;
+        }
+
+        m_leader = true;
+        MojErr err = collect();
+        MojUInt64 upTo = m_written;
+        DbSet group;
+        group.swap(m_pending);
+        guard.unlock();
+
+        leveldb::Status s;
+        if (err == MojErrNone)
+            s = syncDbs(group);
+
+        guard.lock();
+        m_leader = false;
+        if (err == MojErrNone && s.ok()) {
+            m_synced = upTo;
+            ++m_syncs;
+        } else {
+            // leave the group to the next leader, its writers are still waiting
+            m_pending.insert(group.begin(), group.end());
+        }
+        m_cond.broadcast();
+        MojErrCheck(err);
+        MojLdbErrCheck(s, _T("group commit sync"));
+    }
+
+    return MojErrNone;
+}
+
+MojSize MojDbSandwichGroupCommit::commits() const
+{
+    MojThreadGuard guard(m_mutex);
+    return m_commits;
+}
+
+MojSize MojDbSandwichGroupCommit::syncs() const
+{
+    MojThreadGuard guard(m_mutex);
+    return m_syncs;
+}
+
+MojErr MojDbSandwichGroupCommit::collect()
+{
+    // only wait when someone is actually about to join, a lone writer syncs at once
+    if (m_writing == 0 || m_maxDelay <= 0)
+        return MojErrNone;
+
+    MojTime deadline;
+    MojErr err = MojGetCurrentTime(deadline);
+    MojErrCheck(err);
+    deadline += MojMicrosecs(m_maxDelay);
+
+    while (m_writing > 0 && m_written - m_synced < m_maxBatch) {
+        err = m_cond.timedWait(m_mutex, deadline);
+        if (err == MojErrTimedOut)
+            break;
+        MojErrCheck(err);
+    }
+    return MojErrNone;
+}
+
+leveldb::Status MojDbSandwichGroupCommit::syncDbs(const DbSet& dbs)
+{
+    // an empty batch still appends a log record, so a synced write of it
+    // flushes every batch written before
+    leveldb::WriteOptions options;
+    options.sync = true;
+    leveldb::Status s;
+    for (DbSet::const_iterator i = dbs.begin(); i != dbs.end(); ++i) {
+        leveldb::WriteBatch batch;
+        s = (*i)->Write(options, &batch);
+        if (!s.ok())
+            break;
+    }
+    return s;
+}
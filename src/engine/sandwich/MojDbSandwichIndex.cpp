@@ -94,6 +94,20 @@ MojErr MojDbSandwichIndex::stats(MojDbStorageTxn* abstractTxn, MojSize& countOut
     return MojErrNone;
 }
 
+MojErr MojDbSandwichIndex::delRange(const MojDbKey& from, const MojDbKey& to, MojDbStorageTxn* abstractTxn, MojSize& countOut, MojSize& sizeOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert( dynamic_cast<MojDbSandwichEnvTxn *>(abstractTxn) );
+
+    auto txn = static_cast<MojDbSandwichEnvTxn *>(abstractTxn);
+
+    MojErr err = m_db->delRange(*txn, { (const char *)from.data(), from.size() }, { (const char *)to.data(), to.size() },
+                                countOut, sizeOut);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
 MojErr MojDbSandwichIndex::insert(MojDbShardId shardId, const MojDbKey& key, MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
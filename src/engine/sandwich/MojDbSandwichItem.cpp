@@ -22,7 +22,7 @@
 ////////////////////MojDbSandwichItem////////////////////////////////////////////
 
 MojDbSandwichItem::MojDbSandwichItem()
-: m_data(NULL), m_free(MojFree)
+: m_data(NULL), m_capacity(0), m_free(MojFree)
 {
 }
 
@@ -59,6 +59,25 @@ MojErr MojDbSandwichItem::visit(MojObjectVisitor& visitor, MojDbKindEngine& kind
     return MojErrNone;
 }
 
+MojErr MojDbSandwichItem::view(MojDbItemView& viewOut, MojDbKindEngine& kindEngine) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    MojErr err = m_header.read(kindEngine);
+    MojErrCheck(err);
+    viewOut.header().clear();
+    err = m_header.addTo(viewOut.header());
+    MojErrCheck(err);
+    err = viewOut.tokenSet(m_header.kindId(), kindEngine);
+    MojErrCheck(err);
+
+    // body starts right after the header, leave the reader where it is for visit
+    const MojObjectReader& reader = m_header.reader();
+    viewOut.assign(this, reader.pos(), reader.end() - reader.pos());
+
+    return MojErrNone;
+}
+
 void MojDbSandwichItem::id(const MojObject& id)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -138,11 +157,18 @@ MojErr MojDbSandwichItem::fromBytes(const MojByte* bytes, MojSize size)
 
     if (size == 0) {
         clear();
+    } else if (m_data && m_free == MojFree && size <= m_capacity) {
+        // an item reused across records keeps its buffer
+        MojMemCpy(m_data, bytes, size);
+        m_header.reset();
+        m_slice = leveldb::Slice((const char *) m_data, size);
+        m_header.reader().data(m_data, size);
     } else {
         MojByte* newBytes = (MojByte*)MojMalloc(size);
         MojAllocCheck(newBytes);
         MojMemCpy(newBytes, bytes, size);
         setData(newBytes, size, MojFree);
+        m_capacity = size;
     }
     return MojErrNone;
 }
@@ -193,6 +219,7 @@ void MojDbSandwichItem::freeData()
         m_data = NULL;
     }
     m_free = MojFree;
+    m_capacity = 0;
 
     // free m_chunk
     m_chunk.reset();
@@ -14,6 +14,9 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <map>
+#include <vector>
+
 #include "engine/sandwich/MojDbSandwichDatabase.h"
 #include "engine/sandwich/MojDbSandwichQuery.h"
 #include "engine/sandwich/MojDbSandwichEngine.h"
@@ -21,7 +24,7 @@
 #include "db/MojDbQueryPlan.h"
 #include "core/MojObjectSerialization.h"
 
-MojDbSandwichQuery::MojDbSandwichQuery(): m_db(nullptr)
+MojDbSandwichQuery::MojDbSandwichQuery(): m_db(nullptr), m_indexDb(nullptr)
 {
 }
 
@@ -47,6 +50,7 @@ MojErr MojDbSandwichQuery::open(MojDbSandwichDatabase* db, MojDbSandwichDatabase
     m_it = txn->use(db->impl().Cookie()).NewIterator();
 
     m_db = joinDb;
+    m_indexDb = db;
 
     return MojErrNone;
 }
@@ -59,13 +63,50 @@ MojErr MojDbSandwichQuery::close()
         MojErr errClose = MojDbIsamQuery::close();
         MojErrAccumulate(err, errClose);
         m_it.reset();
+        m_joinIt.reset();
+        m_joinVals.clear();
+        m_joinMisses.clear();
+        m_viewVal.reset();
         m_db = NULL;
+        m_indexDb = NULL;
         m_isOpen = false;
     }
     return err;
 }
 
 MojErr MojDbSandwichQuery::getById(const MojObject& id, MojObject& itemOut, bool& foundOut, MojDbKindEngine* kindEngine)
+{
+    MojDbSandwichItem primaryVal;
+    MojErr err = lookupById(id, primaryVal, foundOut);
+    MojErrCheck(err);
+    if (foundOut) {
+        err = primaryVal.toObject(itemOut, *kindEngine);
+        MojErrCheck(err);
+    }
+
+    return MojErrNone;
+}
+
+MojErr MojDbSandwichQuery::getViewById(const MojObject& id, MojDbItemView& viewOut, bool& foundOut, MojDbKindEngine* kindEngine)
+{
+    // the view keeps the record alive, so the item is only reused once no view
+    // handed out earlier still holds it
+    viewOut.release();
+    if (!m_viewVal.get() || m_viewVal->refCount() > 1) {
+        m_viewVal.reset(new MojDbSandwichItem);
+        MojAllocCheck(m_viewVal.get());
+    }
+    MojErr err = lookupById(id, *m_viewVal, foundOut);
+    MojErrCheck(err);
+    if (foundOut) {
+        err = m_viewVal->view(viewOut, *kindEngine);
+        MojErrCheck(err);
+    }
+
+    return MojErrNone;
+}
+
+MojErr MojDbSandwichQuery::lookupById(const MojObject& id, MojDbSandwichItem& valOut, bool& foundOut)
 {
     // XXX: re-consider working with this on MojDbIsamQuery level
     MojDbShardId shardId;
@@ -73,17 +114,14 @@ MojErr MojDbSandwichQuery::getById(const MojObject& id, MojObject& itemOut, bool
     MojErrCheck(err);
 
     foundOut = false;
-    err = MojErrNone;
-
     if (!m_db)
         return MojErrNotOpen;
 
     // retrun val from primary db
-    MojDbSandwichItem primaryKey, primaryVal;
-    MojDbStorageItem* item = &primaryVal;
+    MojDbSandwichItem primaryKey;
     err = primaryKey.fromObject(id);
     MojErrCheck(err);
-    err = m_db->get(shardId, primaryKey, m_txn, false, primaryVal, foundOut);
+    err = m_db->get(shardId, primaryKey, m_txn, false, valOut, foundOut);
     MojErrCheck(err);
     if (!foundOut) {
         char s[1024];
@@ -94,23 +132,23 @@ MojErr MojDbSandwichQuery::getById(const MojObject& id, MojObject& itemOut, bool
         //MojErrThrow(MojErrDbInconsistentIndex);
         MojErrThrow(MojErrInternalIndexOnFind);
     }
-    primaryVal.id(id);
+    valOut.id(id);
 
-    foundOut = false;
     // check for exclusions
     bool exclude = false;
-    err = checkExclude(item, exclude);
+    err = checkExclude(&valOut, exclude);
     MojErrCheck(err);
-    if (!exclude) {
-        err=item->toObject(itemOut, *kindEngine);
-        MojErrCheck(err);
-        foundOut = true;
-    }
+    foundOut = !exclude;
 
     return MojErrNone;
 }
 
 MojErr MojDbSandwichQuery::getById(const MojObject& id, MojDbStorageItem*& itemOut, bool& foundOut)
+{
+    return getByIdImpl(id, itemOut, foundOut, false);
+}
+
+MojErr MojDbSandwichQuery::getByIdImpl(const MojObject& id, MojDbStorageItem*& itemOut, bool& foundOut, bool useWindow)
 {
     // XXX: re-consider working with this on MojDbIsamQuery level
     MojDbShardId shardId;
@@ -127,7 +165,7 @@ MojErr MojDbSandwichQuery::getById(const MojObject& id, MojDbStorageItem*& itemO
         MojDbSandwichItem primaryKey;
         err = primaryKey.fromObject(id);
         MojErrCheck(err);
-        err = m_db->get(shardId, primaryKey, m_txn, false, m_primaryVal, foundOut);
+        err = getPrimary(shardId, primaryKey, useWindow, foundOut);
         MojErrCheck(err);
         if (!foundOut) {
             char s[1024];
@@ -213,12 +251,97 @@ MojErr MojDbSandwichQuery::getVal(MojDbStorageItem*& itemOut, bool& foundOut)
     MojObject id;
     MojErr err = parseId(id);
     MojErrCheck(err);
-    err = getById(id, itemOut, foundOut);
+    err = getByIdImpl(id, itemOut, foundOut, batchJoin() && MojDbSandwichEngine::getJoinWindow() > 0);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+MojErr MojDbSandwichQuery::getPrimary(MojDbShardId shardId, MojDbSandwichItem& key, bool useWindow, bool& foundOut)
+{
+    if (useWindow) {
+        std::string keyStr(reinterpret_cast<const char*>(key.data()), key.size());
+        auto val = m_joinVals.find(keyStr);
+        if (val == m_joinVals.end() && !m_joinMisses.count(keyStr)) {
+            // current index entry is past the window, fetch the next batch
+            MojErr err = fillJoinWindow();
+            MojErrCheck(err);
+            val = m_joinVals.find(keyStr);
+        }
+        if (val != m_joinVals.end()) {
+            MojErr err = m_primaryVal.fromBytes(reinterpret_cast<const MojByte*>(val->second.data()), val->second.size());
+            MojErrCheck(err);
+            foundOut = true;
+            return MojErrNone;
+        }
+        if (m_joinMisses.count(keyStr)) {
+            foundOut = false;
+            return MojErrNone;
+        }
+        // entries the window couldn't resolve go through a point lookup
+    }
+
+    MojErr err = m_db->get(shardId, key, m_txn, false, m_primaryVal, foundOut);
     MojErrCheck(err);
 
     return MojErrNone;
 }
 
+MojErr MojDbSandwichQuery::fillJoinWindow()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert(m_it && m_db && m_indexDb);
+
+    m_joinVals.clear();
+    m_joinMisses.clear();
+    if (!m_it->Valid())
+        return MojErrNone;
+
+    auto txn = static_cast<MojDbSandwichEnvTxn *>(m_txn);
+    if (!m_joinIt)
+        m_joinIt = txn->use(m_indexDb->impl().Cookie()).NewIterator();
+
+    // don't read ahead further than the rows the caller can still receive
+    MojSize window = MojDbSandwichEngine::getJoinWindow();
+    MojUInt32 limit = m_plan->limit();
+    if (m_count < limit && limit - m_count < window)
+        window = limit - m_count;
+
+    // walk the index from the current entry to the end of the range, in query order
+    std::map<MojDbShardId, std::vector<std::string>> keys;
+    bool desc = m_plan->desc();
+    m_joinIt->Seek(m_it->key());
+    for (MojSize n = 0; n < window && m_joinIt->Valid(); ++n) {
+        leveldb::Slice indexKey = m_joinIt->key();
+        const MojByte* keyData = reinterpret_cast<const MojByte*>(indexKey.data());
+        if (!inRange(keyData, indexKey.size()))
+            break;
+
+        // entries that fail to parse are left for getVal to report
+        MojObject id;
+        MojDbShardId shardId;
+        MojDbSandwichItem primaryKey;
+        MojErr err = parseId(keyData, indexKey.size(), id);
+        if (err == MojErrNone)
+            err = MojDbIdGenerator::extractShard(id, shardId);
+        if (err == MojErrNone)
+            err = primaryKey.fromObject(id);
+        if (err == MojErrNone)
+            keys[shardId].emplace_back(reinterpret_cast<const char*>(primaryKey.data()), primaryKey.size());
+
+        if (desc) m_joinIt->Prev();
+        else m_joinIt->Next();
+    }
+
+    // one sorted sweep per shard; keys of a shard that can't be swept fall back to point lookups
+    for (auto& shardKeys : keys) {
+        MojErr err = m_db->multiGet(shardKeys.first, shardKeys.second, *txn, m_joinVals, m_joinMisses);
+        MojErrCatchAll(err);
+    }
+
+    return MojErrNone;
+}
+
 MojErr MojDbSandwichQuery::readEntry(bool& foundOut)
 {
     if (m_it->Valid())
@@ -27,12 +27,28 @@ MojErr MojDbSandwichEnvTxn::abort()
     // first we rollback our main shard and then rest of them
     m_txnMain->reset();
     for (auto &shard : m_txn) shard.second->reset();
+    m_dirty.clear();
+    m_touched.clear();
     return MojErrNone;
 }
 
+void MojDbSandwichEnvTxn::touched(MojDbShardId shardId, const mojo::Sandwich::Cookie &cookie, const leveldb::Slice &key,
+                                  MojSize written, MojSize deleted)
+{
+    if (!m_engine.compactScheduler().enabled())
+        return;
+    std::string part;
+    MojDbSandwichEngine::partId(shardId, cookie, part);
+    m_touched[part].note(key.data(), key.size(), written, deleted);
+}
+
 MojErr MojDbSandwichEnvTxn::commitImpl()
 {
     std::vector<leveldb::Status> statuses;
+    MojDbSandwichGroupCommit& group = m_engine.groupCommit();
+    bool grouped = group.enabled() && !m_dirty.empty();
+    if (grouped)
+        group.begin();
 
     // to ensure consistency of main shard we'll commit it in the last turn
     for (auto &shard : m_txn)
@@ -44,13 +60,32 @@ MojErr MojDbSandwichEnvTxn::commitImpl()
     }
     // at this moment all shards except of main are committed
     leveldb::Status s = m_txnMain->commit();
+    if (grouped)
+        group.end();
     MojLdbErrCheck(s, _T("m_txnMain->commit"));
 
     for (auto &status : statuses)
         MojLdbErrCheck(status, _T("shard.second->commit"));
 
+    if (grouped)
+    {
+        // batches above went out unsynced, wait for the group sync covering them
+        MojDbSandwichGroupCommit::DbVec dbs;
+        for (auto shardId : m_dirty)
+        {
+            auto it = m_sandwiches.find(shardId);
+            if (it != m_sandwiches.end()) dbs.push_back((**it->second).get());
+        }
+        m_dirty.clear();
+        MojErr err = group.sync(dbs);
+        MojErrCheck(err);
+    }
+
     if (m_engine.lazySync())
         m_engine.getUpdater()->sendEvent( (*m_engine.impl()).get() );
 
+    m_engine.compactScheduler().noteCommit(m_touched);
+    m_touched.clear();
+
     return MojErrNone;
 }
@@ -114,7 +114,10 @@ MojErr MojLunaMessage::replyImpl()
 {
 	MojAssert(hasData());
 
-	const MojChar* json = m_writer.json();
+	// luna copies the reply itself, so hand it the writer's buffer
+	const MojChar* json = NULL;
+	MojErr err = m_writer.data(json);
+	MojErrCheck(err);
     LOG_DEBUG("[db_lunaService] response sent: %s", json);
 
 	MojLunaErr lserr;
@@ -124,6 +127,13 @@ MojErr MojLunaMessage::replyImpl()
 	return MojErrNone;
 }
 
+MojString MojLunaMessage::replyJson() const
+{
+	MojString json;
+	(void) m_writer.json(json);
+	return json;
+}
+
 void MojLunaMessage::reset(LSMessage* msg)
 {
 	releaseMessage();
@@ -0,0 +1,214 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "MojContainerPerfTest.h"
+#include "core/MojFlatHashMap.h"
+#include "core/MojFlatSet.h"
+#include "core/MojHashMap.h"
+#include "core/MojMap.h"
+#include "core/MojSet.h"
+
+static const MojSize NumKeys = 10000;
+static const MojSize NumRepetitions = 20;
+// index props usually yield a handful of values per object
+static const MojSize SmallSetSize = 4;
+
+MojContainerPerfTest::MojContainerPerfTest()
+: MojTestCase(_T("MojContainerPerf"))
+{
+}
+
+MojErr MojContainerPerfTest::run()
+{
+	MojErr err = MojPrintF("\n -------------------- \n");
+	MojTestErrCheck(err);
+
+	// scattered ints and short kind-like names, both in random order
+	MojVector<MojUInt32> ints;
+	MojVector<MojString> strs;
+	MojUInt32 seed = 12345;
+	for (MojSize i = 0; i < NumKeys; ++i) {
+		seed = seed * 1103515245 + 12345;
+		err = ints.push(seed);
+		MojTestErrCheck(err);
+		MojString str;
+		err = str.format(_T("com.webos.perf.kind%u:1"), seed % 1000000);
+		MojTestErrCheck(err);
+		err = strs.push(str);
+		MojTestErrCheck(err);
+	}
+
+	err = mapTest<MojMap<MojUInt32, MojUInt32>, MojUInt32>(_T("MojMap<int>"), ints);
+	MojTestErrCheck(err);
+	err = mapTest<MojHashMap<MojUInt32, MojUInt32>, MojUInt32>(_T("MojHashMap<int>"), ints);
+	MojTestErrCheck(err);
+	err = mapTest<MojFlatHashMap<MojUInt32, MojUInt32>, MojUInt32>(_T("MojFlatHashMap<int>"), ints);
+	MojTestErrCheck(err);
+	err = mapTest<MojMap<MojString, MojUInt32, const MojChar*>, MojString>(_T("MojMap<str>"), strs);
+	MojTestErrCheck(err);
+	err = mapTest<MojHashMap<MojString, MojUInt32, const MojChar*>, MojString>(_T("MojHashMap<str>"), strs);
+	MojTestErrCheck(err);
+	err = mapTest<MojFlatHashMap<MojString, MojUInt32, const MojChar*>, MojString>(_T("MojFlatHashMap<str>"), strs);
+	MojTestErrCheck(err);
+
+	err = smallSetTest<MojSet<MojString>, MojString>(_T("MojSet<str> x4"), strs);
+	MojTestErrCheck(err);
+	err = smallSetTest<MojFlatSet<MojString>, MojString>(_T("MojFlatSet<str> x4"), strs);
+	MojTestErrCheck(err);
+	err = largeSetTest<MojSet<MojUInt32>, MojUInt32>(_T("MojSet<int>"), ints);
+	MojTestErrCheck(err);
+	err = largeSetTest<MojFlatSet<MojUInt32>, MojUInt32>(_T("MojFlatSet<int>"), ints);
+	MojTestErrCheck(err);
+
+	err = MojPrintF("\n");
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class MAP, class KEY>
+MojErr MojContainerPerfTest::mapTest(const MojChar* name, const MojVector<KEY>& keys)
+{
+	timespec startTime;
+	timespec endTime;
+	MojUInt64 insertTime = 0;
+	MojUInt64 lookupTime = 0;
+	MojUInt64 iterateTime = 0;
+	MojSize sum = 0;
+	for (MojSize rep = 0; rep < NumRepetitions; ++rep) {
+		MAP map;
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		for (MojSize i = 0; i < keys.size(); ++i) {
+			MojErr err = map.put(keys.at(i), (MojUInt32) i);
+			MojTestErrCheck(err);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &endTime);
+		insertTime += MojPerfTimeDiff(startTime, endTime);
+
+		// every key is looked up once in a different order than it went in
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		for (MojSize i = keys.size(); i > 0; --i) {
+			typename MAP::ConstIterator iter = map.find(keys.at(i - 1));
+			MojTestAssert(iter != map.end());
+			sum += iter.value();
+		}
+		clock_gettime(CLOCK_MONOTONIC, &endTime);
+		lookupTime += MojPerfTimeDiff(startTime, endTime);
+
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		for (typename MAP::ConstIterator i = map.begin(); i != map.end(); ++i)
+			sum += i.value();
+		clock_gettime(CLOCK_MONOTONIC, &endTime);
+		iterateTime += MojPerfTimeDiff(startTime, endTime);
+	}
+	MojTestAssert(sum > 0);
+
+	MojUInt64 count = keys.size() * NumRepetitions;
+	MojErr err = report(name, _T("insert"), count, insertTime);
+	MojTestErrCheck(err);
+	err = report(name, _T("lookup"), count, lookupTime);
+	MojTestErrCheck(err);
+	err = report(name, _T("iterate"), count, iterateTime);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class SET, class VAL>
+MojErr MojContainerPerfTest::smallSetTest(const MojChar* name, const MojVector<VAL>& vals)
+{
+	// many short-lived sets of a few values, the way index keys are extracted per object
+	timespec startTime;
+	timespec endTime;
+	MojSize found = 0;
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	for (MojSize rep = 0; rep < NumRepetitions; ++rep) {
+		for (MojSize i = 0; i + SmallSetSize <= vals.size(); i += SmallSetSize) {
+			SET set;
+			for (MojSize j = i; j < i + SmallSetSize; ++j) {
+				MojErr err = set.put(vals.at(j));
+				MojTestErrCheck(err);
+			}
+			for (typename SET::ConstIterator j = set.begin(); j != set.end(); ++j) {
+				if (set.contains(*j))
+					++found;
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	MojTestAssert(found == (vals.size() / SmallSetSize) * SmallSetSize * NumRepetitions);
+
+	MojErr err = report(name, _T("build+scan"), vals.size() * NumRepetitions, MojPerfTimeDiff(startTime, endTime));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class SET, class VAL>
+MojErr MojContainerPerfTest::largeSetTest(const MojChar* name, const MojVector<VAL>& vals)
+{
+	timespec startTime;
+	timespec endTime;
+	MojUInt64 insertTime = 0;
+	MojUInt64 lookupTime = 0;
+	MojUInt64 iterateTime = 0;
+	MojSize sum = 0;
+	for (MojSize rep = 0; rep < NumRepetitions; ++rep) {
+		SET set;
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		for (MojSize i = 0; i < vals.size(); ++i) {
+			MojErr err = set.put(vals.at(i));
+			MojTestErrCheck(err);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &endTime);
+		insertTime += MojPerfTimeDiff(startTime, endTime);
+
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		for (MojSize i = vals.size(); i > 0; --i) {
+			if (set.contains(vals.at(i - 1)))
+				++sum;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &endTime);
+		lookupTime += MojPerfTimeDiff(startTime, endTime);
+
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		for (typename SET::ConstIterator i = set.begin(); i != set.end(); ++i)
+			sum += *i;
+		clock_gettime(CLOCK_MONOTONIC, &endTime);
+		iterateTime += MojPerfTimeDiff(startTime, endTime);
+	}
+	MojTestAssert(sum > 0);
+
+	MojUInt64 count = vals.size() * NumRepetitions;
+	MojErr err = report(name, _T("insert"), count, insertTime);
+	MojTestErrCheck(err);
+	err = report(name, _T("lookup"), count, lookupTime);
+	MojTestErrCheck(err);
+	err = report(name, _T("iterate"), count, iterateTime);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojContainerPerfTest::report(const MojChar* name, const MojChar* op, MojUInt64 count, MojUInt64 time)
+{
+	MojErr err = MojPrintF("   %-20s %-10s %10llu ops in %12llu nanosecs | %8.1f nanosecs/op\n",
+						   name, op, count, time, double(time) / double(count));
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJCONTAINERPERFTEST_H_
+#define MOJCONTAINERPERFTEST_H_
+
+#include "MojCorePerfTestRunner.h"
+#include "core/MojString.h"
+#include "core/MojVector.h"
+
+class MojContainerPerfTest : public MojTestCase
+{
+public:
+	MojContainerPerfTest();
+
+	MojErr run();
+
+private:
+	template<class MAP, class KEY>
+	MojErr mapTest(const MojChar* name, const MojVector<KEY>& keys);
+	template<class SET, class VAL>
+	MojErr smallSetTest(const MojChar* name, const MojVector<VAL>& vals);
+	template<class SET, class VAL>
+	MojErr largeSetTest(const MojChar* name, const MojVector<VAL>& vals);
+	MojErr report(const MojChar* name, const MojChar* op, MojUInt64 count, MojUInt64 time);
+};
+
+#endif /* MOJCONTAINERPERFTEST_H_ */
@@ -0,0 +1,38 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJCOREPERFTESTRUNNER_H_
+#define MOJCOREPERFTESTRUNNER_H_
+
+#include "core/MojCoreDefs.h"
+#include "core/MojTestRunner.h"
+
+#include <time.h>
+
+class MojCorePerfTestRunner : public MojTestRunner
+{
+private:
+	void runTests();
+};
+
+// time between two CLOCK_MONOTONIC samples, in nanoseconds
+inline MojUInt64 MojPerfTimeDiff(const timespec& start, const timespec& end)
+{
+	return (MojUInt64) (end.tv_sec - start.tv_sec) * 1000000000LL + end.tv_nsec - start.tv_nsec;
+}
+
+#endif /* MOJCOREPERFTESTRUNNER_H_ */
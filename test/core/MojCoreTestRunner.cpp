@@ -28,6 +28,8 @@
 #include "MojDataSerializationTest.h"
 #include "MojDecimalTest.h"
 #include "MojErrTest.h"
+#include "MojFlatHashMapTest.h"
+#include "MojFlatSetTest.h"
 #include "MojObjectFilterTest.h"
 #include "MojHashMapTest.h"
 #include "MojJsonTest.h"
@@ -37,6 +39,7 @@
 #include "MojMessageDispatcherTest.h"
 #include "MojObjectTest.h"
 #include "MojObjectSerializationTest.h"
+#include "MojObjectViewTest.h"
 #include "MojReactorTest.h"
 #include "MojRefCountTest.h"
 #include "MojSchemaTest.h"
@@ -68,6 +71,8 @@ void MojCoreTestRunner::runTests()
 	test(MojDataSerializationTest());
 	test(MojDecimalTest());
 	test(MojErrTest());
+	test(MojFlatHashMapTest());
+	test(MojFlatSetTest());
 	test(MojHashMapTest());
 	test(MojJsonTest());
 	test(MojListTest());
@@ -76,6 +81,7 @@ void MojCoreTestRunner::runTests()
 	test(MojObjectTest());
 	test(MojObjectFilterTest());
 	test(MojObjectSerializationTest());
+	test(MojObjectViewTest());
 	test(MojReactorTest());
 	test(MojRefCountTest());
 	test(MojSchemaTest());
@@ -0,0 +1,198 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+****************************************************************************************************
+* Filename              : MojFlatHashMapTest.cpp
+* Description           : Source file for MojFlatHashMap test.
+****************************************************************************************************
+**/
+
+#include "MojFlatHashMapTest.h"
+#include "core/MojFlatHashMap.h"
+#include "core/MojString.h"
+
+// sends every key to one of a few home slots, so puts and dels have to walk
+// and repair long probe runs that wrap around the end of the table
+struct MojFlatHashMapTestHasher
+{
+	MojUInt32 operator()(int i) { return 30 + (MojUInt32) (i % 4) * 8; }
+};
+
+MojFlatHashMapTest::MojFlatHashMapTest()
+: MojTestCase(_T("MojFlatHashMap"))
+{
+}
+
+/**
+****************************************************************************************************
+* @run              MojFlatHashMap keeps its entries inline in one slot array and probes linearly
+                    on collision. Checks put/get/find/del, growth, iteration, deletes from the
+                    middle of probe runs and lookups by a different key type.
+* @param         :  None
+* @retval        :  MojErr
+****************************************************************************************************
+**/
+MojErr MojFlatHashMapTest::run()
+{
+	MojErr err = basicTest();
+	MojTestErrCheck(err);
+	err = collisionTest();
+	MojTestErrCheck(err);
+	err = stringTest();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojFlatHashMapTest::basicTest()
+{
+	MojFlatHashMap<int, int> map1;
+	MojFlatHashMap<int, int>::Iterator iter;
+	int val = 0;
+	bool found = false;
+
+	// empty
+	MojTestAssert(map1.empty());
+	MojTestAssert(map1.size() == 0);
+	MojTestAssert(map1.begin() == map1.end());
+	MojTestAssert(!map1.contains(1));
+	MojTestAssert(!map1.get(1, val));
+	MojTestAssert(map1.find(1) == map1.end());
+	MojErr err = map1.find(1, iter);
+	MojTestErrCheck(err);
+	MojTestAssert(iter == map1.end());
+	err = map1.del(1, found);
+	MojTestErrCheck(err);
+	MojTestAssert(!found);
+
+	// put/get/find with growth
+	for (int i = 0; i < 1000; ++i) {
+		err = map1.put(i, i);
+		MojTestErrCheck(err);
+		MojTestAssert(map1.size() == (MojSize) i + 1);
+	}
+	for (int i = 0; i < 1000; ++i) {
+		MojTestAssert(map1.get(i, val) && val == i);
+		MojFlatHashMap<int, int>::ConstIterator ci = map1.find(i);
+		MojTestAssert(ci != map1.end() && ci.key() == i && ci.value() == i);
+	}
+	MojTestAssert(!map1.contains(1000));
+
+	// overwrite through put and through an iterator
+	err = map1.put(7, -7);
+	MojTestErrCheck(err);
+	MojTestAssert(map1.size() == 1000);
+	err = map1.find(8, iter);
+	MojTestErrCheck(err);
+	MojTestAssert(iter != map1.end());
+	*iter = -8;
+	MojTestAssert(map1.get(7, val) && val == -7);
+	MojTestAssert(map1.get(8, val) && val == -8);
+
+	// iteration visits every entry once
+	MojSize count = 0;
+	MojInt64 sum = 0;
+	for (MojFlatHashMap<int, int>::ConstIterator i = map1.begin(); i != map1.end(); ++i) {
+		++count;
+		sum += i.key();
+	}
+	MojTestAssert(count == 1000 && sum == 999 * 1000 / 2);
+
+	// copy, then del the odd keys from the original
+	MojFlatHashMap<int, int> map2;
+	err = map2.assign(map1);
+	MojTestErrCheck(err);
+	for (int i = 1; i < 1000; i += 2) {
+		err = map1.del(i, found);
+		MojTestErrCheck(err);
+		MojTestAssert(found);
+	}
+	MojTestAssert(map1.size() == 500 && map2.size() == 1000);
+	for (int i = 0; i < 1000; ++i) {
+		MojTestAssert(map1.contains(i) == (i % 2 == 0));
+		MojTestAssert(map2.contains(i));
+	}
+
+	map1.swap(map2);
+	MojTestAssert(map1.size() == 1000 && map2.size() == 500);
+	map1.clear();
+	MojTestAssert(map1.empty() && map1.begin() == map1.end());
+	err = map1.reserve(100);
+	MojTestErrCheck(err);
+	err = map1.put(3, 3);
+	MojTestErrCheck(err);
+	MojTestAssert(map1.size() == 1 && map1.contains(3));
+
+	return MojErrNone;
+}
+
+MojErr MojFlatHashMapTest::collisionTest()
+{
+	typedef MojFlatHashMap<int, int, int, MojFlatHashMapTestHasher> Map;
+	Map map;
+	MojErr err = map.reserve(24);
+	MojTestErrCheck(err);
+	for (int i = 0; i < 24; ++i) {
+		err = map.put(i, i * 10);
+		MojTestErrCheck(err);
+	}
+	// delete from the front, middle and end of the runs, checking the rest stay reachable
+	static const int dels[] = {0, 13, 23, 4, 1, 22, 12, 8};
+	bool found = false;
+	for (MojSize d = 0; d < sizeof(dels) / sizeof(dels[0]); ++d) {
+		err = map.del(dels[d], found);
+		MojTestErrCheck(err);
+		MojTestAssert(found);
+		for (int i = 0; i < 24; ++i) {
+			bool deleted = false;
+			for (MojSize k = 0; k <= d; ++k)
+				deleted = deleted || dels[k] == i;
+			int val = 0;
+			MojTestAssert(map.get(i, val) == !deleted);
+			MojTestAssert(deleted || val == i * 10);
+		}
+	}
+	MojTestAssert(map.size() == 16);
+	for (int i = 100; i < 110; ++i) {
+		err = map.put(i, i);
+		MojTestErrCheck(err);
+	}
+	MojTestAssert(map.size() == 26 && map.contains(105) && map.contains(2));
+
+	return MojErrNone;
+}
+
+MojErr MojFlatHashMapTest::stringTest()
+{
+	MojFlatHashMap<MojString, int, const MojChar*> map;
+	MojString str;
+	for (int i = 0; i < 200; ++i) {
+		MojErr err = str.format(_T("key%d"), i);
+		MojTestErrCheck(err);
+		err = map.put(str, i);
+		MojTestErrCheck(err);
+	}
+	int val = 0;
+	MojTestAssert(map.get(_T("key42"), val) && val == 42);
+	MojTestAssert(!map.contains(_T("key200")));
+	bool found = false;
+	MojErr err = map.del(_T("key42"), found);
+	MojTestErrCheck(err);
+	MojTestAssert(found && !map.contains(_T("key42")) && map.size() == 199);
+
+	return MojErrNone;
+}
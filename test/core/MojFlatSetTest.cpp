@@ -0,0 +1,188 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+****************************************************************************************************
+* Filename              : MojFlatSetTest.cpp
+* Description           : Source file for MojFlatSet test.
+****************************************************************************************************
+**/
+
+#include "MojFlatSetTest.h"
+#include "core/MojFlatSet.h"
+#include "core/MojSet.h"
+
+MojFlatSetTest::MojFlatSetTest()
+: MojTestCase(_T("MojFlatSet"))
+{
+}
+
+/**
+****************************************************************************************************
+* @run              MojFlatSet keeps its values in one sorted array. Puts in and out of order,
+                    dels, range puts and the union/diff/intersect operations are checked
+                    against a MojSet given the same input.
+* @param         :  None
+* @retval        :  MojErr
+****************************************************************************************************
+**/
+MojErr MojFlatSetTest::run()
+{
+	MojErr err = basicTest();
+	MojTestErrCheck(err);
+	err = rangeTest();
+	MojTestErrCheck(err);
+	err = setOpsTest();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojFlatSetTest::basicTest()
+{
+	MojFlatSet<int> set1;
+	bool found = false;
+
+	// empty
+	MojTestAssert(set1.empty());
+	MojTestAssert(set1.size() == 0);
+	MojTestAssert(set1.begin() == set1.end());
+	MojTestAssert(set1.find(1) == set1.end());
+	MojTestAssert(!set1.contains(1));
+	MojErr err = set1.del(1, found);
+	MojTestErrCheck(err);
+	MojTestAssert(!found);
+
+	// scattered puts with repeats, compared against MojSet
+	MojSet<int> expected;
+	for (int i = 0; i < 500; ++i) {
+		int val = (i * 37) % 211;
+		err = set1.put(val);
+		MojTestErrCheck(err);
+		err = expected.put(val);
+		MojTestErrCheck(err);
+		MojTestAssert(set1.contains(val));
+	}
+	MojTestAssert(set1.size() == expected.size());
+	MojFlatSet<int>::ConstIterator i = set1.begin();
+	for (MojSet<int>::ConstIterator j = expected.begin(); j != expected.end(); ++i, ++j) {
+		MojTestAssert(*i == *j);
+	}
+	MojTestAssert(i == set1.end());
+	MojTestAssert(*set1.lowerBound(-1) == 0);
+	MojTestAssert(set1.lowerBound(1000) == set1.end());
+
+	// copies share until written
+	MojFlatSet<int> set2(set1);
+	MojTestAssert(set2 == set1);
+	err = set2.del(5, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	MojTestAssert(set1.contains(5));
+	MojTestAssert(!set2.contains(5));
+	MojTestAssert(set2 != set1);
+	MojTestAssert(set1 < set2);
+
+	// del everything
+	for (int val = 0; val < 211; ++val) {
+		err = set1.del(val, found);
+		MojTestErrCheck(err);
+		MojTestAssert(found);
+		MojTestAssert(!set1.contains(val));
+	}
+	MojTestAssert(set1.empty());
+	set1.swap(set2);
+	MojTestAssert(set2.empty());
+	MojTestAssert(set1.size() == 210);
+	set1.clear();
+	MojTestAssert(set1.empty());
+
+	return MojErrNone;
+}
+
+MojErr MojFlatSetTest::rangeTest()
+{
+	// in order past the back is appended as is
+	MojFlatSet<int> set1;
+	int sorted[] = {1, 2, 3, 5, 8};
+	MojErr err = set1.put(sorted, sorted + 5);
+	MojTestErrCheck(err);
+	int more[] = {13, 21};
+	err = set1.put(more, more + 2);
+	MojTestErrCheck(err);
+	MojTestAssert(set1.size() == 7);
+	MojTestAssert(set1.at(4) == 8 && set1.at(6) == 21);
+
+	// out of order with repeats gets sorted and deduped
+	int scattered[] = {4, 21, 0, 4, 3, 34, 0};
+	err = set1.put(scattered, scattered + 7);
+	MojTestErrCheck(err);
+	int expected[] = {0, 1, 2, 3, 4, 5, 8, 13, 21, 34};
+	MojTestAssert(set1.size() == 10);
+	for (MojSize i = 0; i < set1.size(); ++i) {
+		MojTestAssert(set1.at(i) == expected[i]);
+	}
+	err = set1.put(scattered, scattered);
+	MojTestErrCheck(err);
+	MojTestAssert(set1.size() == 10);
+
+	return MojErrNone;
+}
+
+MojErr MojFlatSetTest::setOpsTest()
+{
+	MojFlatSet<int> evens;
+	MojFlatSet<int> threes;
+	for (int i = 0; i < 60; ++i) {
+		MojErr err = evens.put(i * 2);
+		MojTestErrCheck(err);
+		err = threes.put(i * 3);
+		MojTestErrCheck(err);
+	}
+
+	MojFlatSet<int> both(evens);
+	MojErr err = both.intersect(threes);
+	MojTestErrCheck(err);
+	MojTestAssert(both.size() == 20);
+	for (MojFlatSet<int>::ConstIterator i = both.begin(); i != both.end(); ++i) {
+		MojTestAssert(*i % 6 == 0);
+	}
+
+	MojFlatSet<int> either(evens);
+	err = either.put(threes);
+	MojTestErrCheck(err);
+	MojTestAssert(either.size() == 60 + 60 - 20);
+	for (MojFlatSet<int>::ConstIterator i = either.begin() + 1; i != either.end(); ++i) {
+		MojTestAssert(*(i - 1) < *i);
+	}
+
+	err = either.del(evens);
+	MojTestErrCheck(err);
+	MojTestAssert(either.size() == 40);
+	for (MojFlatSet<int>::ConstIterator i = either.begin(); i != either.end(); ++i) {
+		MojTestAssert(!evens.contains(*i) && *i % 3 == 0);
+	}
+
+	// union with a set entirely past the back appends
+	MojFlatSet<int> high;
+	err = high.put(1000);
+	MojTestErrCheck(err);
+	err = either.put(high);
+	MojTestErrCheck(err);
+	MojTestAssert(either.size() == 41 && either.contains(1000));
+
+	return MojErrNone;
+}
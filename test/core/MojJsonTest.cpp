@@ -22,7 +22,6 @@
 **/
 
 #include "MojJsonTest.h"
-#include "core/MojJson.h"
 
 MojJsonTest::MojJsonTest()
 : MojTestCase("MojJson")
@@ -86,6 +85,10 @@ MojErr MojJsonTest::run()
 	MojTestErrCheck(err);
 	err = test(negativeChars, negativeChars);
 	MojTestErrCheck(err);
+	err = scanTest();
+	MojTestErrCheck(err);
+	err = bufferWriterTest();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -100,6 +103,14 @@ MojErr MojJsonTest::test(const MojChar* str, const MojChar* expected)
 	MojTestErrCheck(err);
 	MojTestAssert(writer.json() == expected);
 
+	MojJsonBufferWriter bufWriter;
+	err = MojJsonParser::parse(bufWriter, str);
+	MojTestErrCheck(err);
+	MojString bufJson;
+	err = bufWriter.json(bufJson);
+	MojTestErrCheck(err);
+	MojTestAssert(bufJson == expected);
+
 	err = obj1.fromJson(str);
 	MojTestErrCheck(err);
 	err = obj2.fromJson(expected);
@@ -108,3 +119,212 @@ MojErr MojJsonTest::test(const MojChar* str, const MojChar* expected)
 
 	return MojErrNone;
 }
+
+MojErr MojJsonTest::bufferWriterTest()
+{
+	// enough output to span many chunks, with escapes and ints at the edges
+	MojObject arr(MojObject::TypeArray);
+	for (MojInt64 i = 0; i < 2000; ++i) {
+		MojObject obj;
+		MojErr err = obj.putInt(_T("i"), (i % 2) ? -i * 1000003 : i);
+		MojTestErrCheck(err);
+		err = obj.putString(_T("s"), _T("tab\there \"quoted\" back\\slash \x01"));
+		MojTestErrCheck(err);
+		err = arr.push(obj);
+		MojTestErrCheck(err);
+	}
+	MojErr err = arr.push(MojObject(MojInt64Max));
+	MojTestErrCheck(err);
+	err = arr.push(MojObject(MojInt64Min));
+	MojTestErrCheck(err);
+
+	MojJsonWriter writer;
+	err = arr.visit(writer);
+	MojTestErrCheck(err);
+	MojJsonBufferWriter bufWriter;
+	MojTestAssert(bufWriter.empty());
+	err = arr.visit(bufWriter);
+	MojTestErrCheck(err);
+	MojTestAssert(!bufWriter.empty());
+
+	MojString json;
+	err = bufWriter.json(json);
+	MojTestErrCheck(err);
+	MojTestAssert(json == writer.json());
+	const MojChar* data = NULL;
+	err = bufWriter.data(data);
+	MojTestErrCheck(err);
+	MojTestAssert(MojStrCmp(data, writer.json()) == 0);
+	err = bufWriter.json(json);
+	MojTestErrCheck(err);
+	MojTestAssert(json.length() == writer.json().length() + 1);
+
+	MojObject parsed;
+	err = parsed.fromJson(data);
+	MojTestErrCheck(err);
+	MojTestAssert(parsed == arr);
+
+	err = bufWriter.reset();
+	MojTestErrCheck(err);
+	MojTestAssert(bufWriter.empty());
+
+	return MojErrNone;
+}
+
+MojErr MojJsonTest::scanTest()
+{
+	// every scanner must see exactly what the scalar one sees, errors included
+	MojJsonParser::Scan savedScan = MojJsonParser::scan();
+	MojUInt32 seed = 12345;
+
+	for (int i = 0; i < 2000; ++i) {
+		MojString doc;
+		MojErr err = genValue(doc, seed, 0);
+		MojTestErrCheck(err);
+		if (i % 2) {
+			err = mutate(doc, seed);
+			MojTestErrCheck(err);
+		}
+		MojSize split = doc.empty() ? 0 : nextRand(seed) % doc.length();
+
+		MojString expected;
+		err = scanParse(MojJsonParser::ScanScalar, doc, split, expected);
+		MojTestErrCheck(err);
+		for (int scan = MojJsonParser::ScanSse2; scan <= MojJsonParser::ScanAvx2; ++scan) {
+			if (!MojJsonParser::supported((MojJsonParser::Scan) scan))
+				continue;
+			MojString result;
+			err = scanParse((MojJsonParser::Scan) scan, doc, split, result);
+			MojTestErrCheck(err);
+			MojTestAssert(result == expected);
+		}
+	}
+	MojErr err = MojJsonParser::scan(savedScan);
+	MojTestErrCheck(err);
+
+	err = MojJsonParser::scan(_T("bogus"));
+	MojTestErrExpected(err, MojErrInvalidArg);
+	err = MojJsonParser::scan(MojJsonParser::ScanScalarName);
+	MojTestErrCheck(err);
+	MojTestAssert(MojJsonParser::scan() == MojJsonParser::ScanScalar);
+	err = MojJsonParser::scan(savedScan);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojJsonTest::scanParse(MojJsonParser::Scan scan, const MojString& doc, MojSize split, MojString& resultOut)
+{
+	// parses doc in two chunks and describes everything the parser did
+	MojErr err = MojJsonParser::scan(scan);
+	MojTestErrCheck(err);
+
+	MojJsonWriter writer;
+	MojJsonParser parser;
+	parser.begin();
+	const MojChar* parseEnd = NULL;
+	MojErr parseErr = parser.parseChunk(writer, doc.data(), split, parseEnd);
+	if (parseErr == MojErrNone)
+		parseErr = parser.parseChunk(writer, doc.data() + split, doc.length() - split, parseEnd);
+	if (parseErr == MojErrNone)
+		parseErr = parser.end(writer);
+
+	err = resultOut.format(_T("%d %u:%u %d "), (int) parseErr, parser.line(), parser.column(), (int) parser.finished());
+	MojTestErrCheck(err);
+	err = resultOut.append(writer.json());
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojJsonTest::genValue(MojString& str, MojUInt32& seed, int depth)
+{
+	static const MojChar* const pieces[] = {
+		_T("a"), _T("hello world, this run is long enough to fill a vector register"),
+		_T("\\\""), _T("\\\\"), _T("\\n"), _T("\\u00e9"), _T("\\u4e2d"), _T("\n"), _T("\t"), _T("/*"), _T("\xc3\xa9")
+	};
+	static const MojChar* const scalars[] = {
+		_T("null"), _T("true"), _T("false"), _T("0"), _T("-17"), _T("3.25"), _T("6.02e23"), _T("123456789012")
+	};
+	static const MojSize numPieces = sizeof(pieces) / sizeof(pieces[0]);
+	static const MojSize numScalars = sizeof(scalars) / sizeof(scalars[0]);
+
+	MojErr err = MojErrNone;
+	MojUInt32 kind = nextRand(seed) % (depth < 4 ? 5 : 3);
+	switch (kind) {
+	case 0:
+		err = str.append(scalars[nextRand(seed) % numScalars]);
+		MojTestErrCheck(err);
+		break;
+	case 1:
+	case 2: {
+		err = str.append(_T('"'));
+		MojTestErrCheck(err);
+		MojUInt32 count = nextRand(seed) % 6;
+		for (MojUInt32 i = 0; i < count; ++i) {
+			err = str.append(pieces[nextRand(seed) % numPieces]);
+			MojTestErrCheck(err);
+		}
+		err = str.append(_T('"'));
+		MojTestErrCheck(err);
+		break;
+	}
+	case 3: {
+		err = str.append(_T("[ "));
+		MojTestErrCheck(err);
+		MojUInt32 count = nextRand(seed) % 5;
+		for (MojUInt32 i = 0; i < count; ++i) {
+			if (i > 0) {
+				err = str.append(_T(",\n"));
+				MojTestErrCheck(err);
+			}
+			err = genValue(str, seed, depth + 1);
+			MojTestErrCheck(err);
+		}
+		err = str.append(_T("]"));
+		MojTestErrCheck(err);
+		break;
+	}
+	default: {
+		err = str.append(_T("{"));
+		MojTestErrCheck(err);
+		MojUInt32 count = nextRand(seed) % 5;
+		for (MojUInt32 i = 0; i < count; ++i) {
+			if (i > 0) {
+				err = str.append(_T(", /* c */ "));
+				MojTestErrCheck(err);
+			}
+			err = str.appendFormat(_T("\"prop%u_with_a_fairly_long_name\" : "), nextRand(seed) % 100);
+			MojTestErrCheck(err);
+			err = genValue(str, seed, depth + 1);
+			MojTestErrCheck(err);
+		}
+		err = str.append(_T("}"));
+		MojTestErrCheck(err);
+		break;
+	}
+	}
+	return MojErrNone;
+}
+
+MojErr MojJsonTest::mutate(MojString& str, MojUInt32& seed)
+{
+	static const MojChar breakers[] = _T("\"\\{}[],:/*\n 0e-x");
+
+	if (str.empty())
+		return MojErrNone;
+	MojUInt32 count = 1 + nextRand(seed) % 3;
+	for (MojUInt32 i = 0; i < count; ++i) {
+		MojSize pos = nextRand(seed) % str.length();
+		MojChar c = breakers[nextRand(seed) % (sizeof(breakers) / sizeof(MojChar) - 1)];
+		MojErr err = str.setAt(pos, c);
+		MojTestErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojUInt32 MojJsonTest::nextRand(MojUInt32& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
@@ -25,6 +25,7 @@
 #define MOJJSONTEST_H_
 
 #include "MojCoreTestRunner.h"
+#include "core/MojJson.h"
 
 class MojJsonTest : public MojTestCase
 {
@@ -35,6 +36,12 @@ public:
 
 private:
 	MojErr test(const MojChar* str, const MojChar* expected);
+	MojErr bufferWriterTest();
+	MojErr scanTest();
+	MojErr scanParse(MojJsonParser::Scan scan, const MojString& doc, MojSize split, MojString& resultOut);
+	MojErr genValue(MojString& str, MojUInt32& seed, int depth);
+	MojErr mutate(MojString& str, MojUInt32& seed);
+	static MojUInt32 nextRand(MojUInt32& seed);
 };
 
 #endif /* MOJJSONTEST_H_ */
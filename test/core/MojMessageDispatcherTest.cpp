@@ -54,6 +54,63 @@ public:
 	int m_i;
 };
 
+class MojTestTimedMessage : public MojMessage
+{
+public:
+	typedef MojVector<MojString> Log;
+
+	MojTestTimedMessage(const MojChar* queue, MojInt64 runTime, Priority pri, Log& log, MojThreadMutex& mutex)
+	: m_queue(queue), m_runTime(runTime), m_log(log), m_mutex(mutex)
+	{
+		priority(pri);
+	}
+
+	virtual const MojChar* queue() const
+	{
+		return m_queue;
+	}
+
+	virtual MojErr dispatch()
+	{
+		MojThreadGuard guard(m_mutex);
+		++s_running;
+		if (s_running > s_maxRunning)
+			s_maxRunning = s_running;
+		guard.unlock();
+
+		if (m_runTime)
+			MojSleep(MojMicrosecs(m_runTime));
+
+		guard.lock();
+		--s_running;
+		MojString name;
+		MojErr err = name.assign(m_queue);
+		MojErrCheck(err);
+		err = m_log.push(name);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+
+	static int s_running;
+	static int s_maxRunning;
+
+private:
+	const MojChar* m_queue;
+	MojInt64 m_runTime;
+	Log& m_log;
+	MojThreadMutex& m_mutex;
+};
+
+int MojTestTimedMessage::s_running = 0;
+int MojTestTimedMessage::s_maxRunning = 0;
+
+static MojInt64 statValue(const MojObject& stats, const MojChar* key)
+{
+	MojInt64 val = -1;
+	(void) stats.get(key, val);
+	return val;
+}
+
 MojMessageDispatcherTest::MojMessageDispatcherTest()
 : MojTestCase(_T("MojMessageQueue"))
 {
@@ -98,5 +155,119 @@ MojErr MojMessageDispatcherTest::run()
 
 	MojTestAssert(s_messageCount == 0);
 
+	err = fairnessTest();
+	MojTestErrCheck(err);
+	err = adminLimitTest();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojMessageDispatcherTest::fairnessTest()
+{
+	// a caller with a backlog of slow admin calls must not hold up quick reads
+	const int numMessages = 10;
+	MojTestTimedMessage::Log log;
+	MojThreadMutex mutex;
+	MojMessageDispatcher dispatcher;
+
+	for (int i = 0; i < numMessages; ++i) {
+		MojRefCountedPtr<MojTestTimedMessage> msg(new MojTestTimedMessage(_T("dump"), 5000, MojMessage::PriorityAdmin, log, mutex));
+		MojAllocCheck(msg.get());
+		MojErr err = dispatcher.schedule(msg.get());
+		MojTestErrCheck(err);
+	}
+	for (int i = 0; i < numMessages; ++i) {
+		MojRefCountedPtr<MojTestTimedMessage> msg(new MojTestTimedMessage(_T("ui"), 0, MojMessage::PriorityRead, log, mutex));
+		MojAllocCheck(msg.get());
+		MojErr err = dispatcher.schedule(msg.get());
+		MojTestErrCheck(err);
+	}
+
+	MojObject stats;
+	MojErr err = dispatcher.stats(stats);
+	MojTestErrCheck(err);
+	MojObject readStats;
+	MojTestAssert(stats.get(_T("read"), readStats));
+	MojTestAssert(statValue(readStats, _T("depth")) == numMessages);
+
+	err = dispatcher.start(1);
+	MojTestErrCheck(err);
+	err = dispatcher.stop();
+	MojTestErrCheck(err);
+	err = dispatcher.wait();
+	MojTestErrCheck(err);
+
+	MojTestAssert(log.size() == numMessages * 2);
+	int dumpsBeforeLastRead = 0;
+	int readsSeen = 0;
+	for (MojSize i = 0; i < log.size() && readsSeen < numMessages; ++i) {
+		if (log[i] == _T("ui"))
+			++readsSeen;
+		else
+			++dumpsBeforeLastRead;
+	}
+	// round robin would interleave all of them
+	MojTestAssert(dumpsBeforeLastRead <= 1);
+
+	err = dispatcher.stats(stats);
+	MojTestErrCheck(err);
+	MojTestAssert(stats.get(_T("read"), readStats));
+	MojTestAssert(statValue(readStats, _T("dispatched")) == numMessages);
+	MojTestAssert(statValue(readStats, _T("depth")) == 0);
+	MojObject adminStats;
+	MojTestAssert(stats.get(_T("admin"), adminStats));
+	MojTestAssert(statValue(adminStats, _T("avgRunUs")) >= 5000);
+
+	return MojErrNone;
+}
+
+MojErr MojMessageDispatcherTest::adminLimitTest()
+{
+	// admin calls from different callers get at most maxAdminThreads threads
+	const int numQueues = 4;
+	const int numMessages = 5;
+	const MojChar* const queues[numQueues] = {_T("a"), _T("b"), _T("c"), _T("d")};
+	MojTestTimedMessage::Log log;
+	MojThreadMutex mutex;
+	MojMessageDispatcher dispatcher;
+
+	MojObject conf;
+	MojErr err = conf.fromJson(_T("{\"threads\":3,\"maxAdminThreads\":1,\"weights\":{\"admin\":2}}"));
+	MojTestErrCheck(err);
+	err = dispatcher.configure(conf);
+	MojTestErrCheck(err);
+	err = dispatcher.classify(_T("compact"), MojMessage::PriorityAdmin);
+	MojTestErrCheck(err);
+	MojTestAssert(dispatcher.priority(_T("compact")) == MojMessage::PriorityAdmin);
+	MojTestAssert(dispatcher.priority(_T("put")) == MojMessage::PriorityWrite);
+	MojTestAssert(dispatcher.priority(NULL) == MojMessage::PriorityWrite);
+
+	MojTestTimedMessage::s_running = 0;
+	MojTestTimedMessage::s_maxRunning = 0;
+	err = dispatcher.start();
+	MojTestErrCheck(err);
+	for (int i = 0; i < numMessages; ++i) {
+		for (int j = 0; j < numQueues; ++j) {
+			MojRefCountedPtr<MojTestTimedMessage> msg(new MojTestTimedMessage(queues[j], 1000, MojMessage::PriorityAdmin, log, mutex));
+			MojAllocCheck(msg.get());
+			err = dispatcher.schedule(msg.get());
+			MojTestErrCheck(err);
+		}
+	}
+	err = dispatcher.stop();
+	MojTestErrCheck(err);
+	err = dispatcher.wait();
+	MojTestErrCheck(err);
+
+	MojTestAssert(log.size() == numQueues * numMessages);
+	MojTestAssert(MojTestTimedMessage::s_maxRunning == 1);
+
+	MojObject badConf;
+	err = badConf.fromJson(_T("{\"threads\":0}"));
+	MojTestErrCheck(err);
+	err = dispatcher.configure(badConf);
+	MojTestErrExpected(err, MojErrInvalidArg);
+
 	return MojErrNone;
 }
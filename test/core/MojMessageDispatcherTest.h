@@ -32,6 +32,10 @@ public:
 	MojMessageDispatcherTest();
 
 	virtual MojErr run();
+
+private:
+	MojErr fairnessTest();
+	MojErr adminLimitTest();
 };
 
 #endif /* MOJMESSAGEDISPATCHERTEST_H_ */
@@ -0,0 +1,279 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "MojObjectPerfTest.h"
+#include "core/MojJson.h"
+#include "core/MojObjectArena.h"
+#include "core/MojObjectBuilder.h"
+
+static const MojUInt64 NumObjects = 1000;
+static const MojUInt64 NumRepetitions = 50;
+
+static const MojChar* const s_names[] = {
+	_T("James"), _T("Mary"), _T("John"), _T("Patricia"), _T("Robert"),
+	_T("Linda"), _T("Michael"), _T("Barbara"), _T("William"), _T("Elizabeth")
+};
+
+// counts values without producing anything, to time traversal alone
+class MojObjectPerfCounter : public MojObjectVisitor
+{
+public:
+	MojObjectPerfCounter() : m_count(0) {}
+
+	virtual MojErr reset() { m_count = 0; return MojErrNone; }
+	virtual MojErr beginObject() { ++m_count; return MojErrNone; }
+	virtual MojErr endObject() { return MojErrNone; }
+	virtual MojErr beginArray() { ++m_count; return MojErrNone; }
+	virtual MojErr endArray() { return MojErrNone; }
+	virtual MojErr propName(const MojChar* name, MojSize len) { m_count += len; return MojErrNone; }
+	virtual MojErr nullValue() { ++m_count; return MojErrNone; }
+	virtual MojErr boolValue(bool val) { ++m_count; return MojErrNone; }
+	virtual MojErr intValue(MojInt64 val) { ++m_count; return MojErrNone; }
+	virtual MojErr decimalValue(const MojDecimal& val) { ++m_count; return MojErrNone; }
+	virtual MojErr stringValue(const MojChar* val, MojSize len) { m_count += len; return MojErrNone; }
+
+	MojSize m_count;
+};
+
+MojObjectPerfTest::MojObjectPerfTest()
+: MojTestCase(_T("MojObjectPerf"))
+{
+}
+
+MojErr MojObjectPerfTest::run()
+{
+	MojErr err = MojPrintF("\n -------------------- \n");
+	MojTestErrCheck(err);
+	err = buildTest(NULL);
+	MojTestErrCheck(err);
+	MojObjectArena arena;
+	err = buildTest(&arena);
+	MojTestErrCheck(err);
+	err = parseTest();
+	MojTestErrCheck(err);
+	err = visitTest();
+	MojTestErrCheck(err);
+	err = compareTest();
+	MojTestErrCheck(err);
+	err = MojPrintF("\n");
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectPerfTest::createObj(MojObject& obj, MojObjectArena* arena, MojUInt64 i)
+{
+	// shaped like a typical record: short ids and names, a few numbers, one nested object and array
+	MojString id;
+	MojErr err = id.format(_T("++Ka%llu"), i);
+	MojTestErrCheck(err);
+	err = obj.putString(_T("_id"), id);
+	MojTestErrCheck(err);
+	err = obj.putString(_T("_kind"), _T("com.webos.perf.contact:1"));
+	MojTestErrCheck(err);
+	err = obj.putInt(_T("_rev"), (MojInt64) i);
+	MojTestErrCheck(err);
+
+	MojObject name(MojObject::TypeObject, arena);
+	err = name.putString(_T("first"), s_names[i % 10]);
+	MojTestErrCheck(err);
+	err = name.putString(_T("last"), s_names[(i / 10) % 10]);
+	MojTestErrCheck(err);
+	err = obj.put(_T("name"), name);
+	MojTestErrCheck(err);
+
+	err = obj.putInt(_T("age"), (MojInt64) (i % 90));
+	MojTestErrCheck(err);
+	err = obj.putDecimal(_T("score"), MojDecimal((MojInt64) i, 250000));
+	MojTestErrCheck(err);
+	err = obj.putBool(_T("favorite"), (i % 3) == 0);
+	MojTestErrCheck(err);
+
+	MojObject tags(MojObject::TypeArray, arena);
+	for (MojUInt64 j = 0; j < 4; ++j) {
+		err = tags.pushString(s_names[(i + j) % 10]);
+		MojTestErrCheck(err);
+	}
+	err = obj.put(_T("tags"), tags);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectPerfTest::buildTest(MojObjectArena* arena)
+{
+	timespec startTime;
+	timespec endTime;
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	for (MojUInt64 rep = 0; rep < NumRepetitions; ++rep) {
+		for (MojUInt64 i = 0; i < NumObjects; ++i) {
+			MojObject obj(MojObject::TypeObject, arena);
+			MojErr err = createObj(obj, arena, i);
+			MojTestErrCheck(err);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+	MojErr err = report(arena ? _T("build (arena)") : _T("build"), NumObjects * NumRepetitions,
+						MojPerfTimeDiff(startTime, endTime));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectPerfTest::parseTest()
+{
+	MojVector<MojString> json;
+	for (MojUInt64 i = 0; i < NumObjects; ++i) {
+		MojObject obj;
+		MojErr err = createObj(obj, NULL, i);
+		MojTestErrCheck(err);
+		MojString str;
+		err = obj.toJson(str);
+		MojTestErrCheck(err);
+		err = json.push(str);
+		MojTestErrCheck(err);
+	}
+
+	static const MojChar* const scanNames[] = {
+		MojJsonParser::ScanAutoName, MojJsonParser::ScanScalarName, MojJsonParser::ScanSse2Name, MojJsonParser::ScanAvx2Name
+	};
+	MojJsonParser::Scan savedScan = MojJsonParser::scan();
+	for (int scan = MojJsonParser::ScanScalar; scan <= MojJsonParser::ScanAvx2; ++scan) {
+		if (!MojJsonParser::supported((MojJsonParser::Scan) scan))
+			continue;
+		MojErr err = MojJsonParser::scan((MojJsonParser::Scan) scan);
+		MojTestErrCheck(err);
+
+		timespec startTime;
+		timespec endTime;
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		for (MojUInt64 rep = 0; rep < NumRepetitions; ++rep) {
+			for (MojVector<MojString>::ConstIterator i = json.begin(); i != json.end(); ++i) {
+				MojObjectBuilder builder;
+				err = MojJsonParser::parse(builder, i->data(), i->length());
+				MojTestErrCheck(err);
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+		MojString op;
+		err = op.format(_T("parse (%s)"), scanNames[scan]);
+		MojTestErrCheck(err);
+		err = report(op, NumObjects * NumRepetitions, MojPerfTimeDiff(startTime, endTime));
+		MojTestErrCheck(err);
+	}
+	MojErr err = MojJsonParser::scan(savedScan);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectPerfTest::visitTest()
+{
+	MojVector<MojObject> objs;
+	for (MojUInt64 i = 0; i < NumObjects; ++i) {
+		MojObject obj;
+		MojErr err = createObj(obj, NULL, i);
+		MojTestErrCheck(err);
+		err = objs.push(obj);
+		MojTestErrCheck(err);
+	}
+
+	MojObjectPerfCounter counter;
+	timespec startTime;
+	timespec endTime;
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	for (MojUInt64 rep = 0; rep < NumRepetitions; ++rep) {
+		for (MojVector<MojObject>::ConstIterator i = objs.begin(); i != objs.end(); ++i) {
+			MojErr err = i->visit(counter);
+			MojTestErrCheck(err);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	MojTestAssert(counter.m_count > 0);
+
+	MojErr err = report(_T("visit"), NumObjects * NumRepetitions, MojPerfTimeDiff(startTime, endTime));
+	MojTestErrCheck(err);
+
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	for (MojUInt64 rep = 0; rep < NumRepetitions; ++rep) {
+		for (MojVector<MojObject>::ConstIterator i = objs.begin(); i != objs.end(); ++i) {
+			MojString str;
+			err = i->toJson(str);
+			MojTestErrCheck(err);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+	err = report(_T("toJson"), NumObjects * NumRepetitions, MojPerfTimeDiff(startTime, endTime));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectPerfTest::compareTest()
+{
+	MojVector<MojObject> objs;
+	for (MojUInt64 i = 0; i < NumObjects; ++i) {
+		MojObject obj;
+		MojErr err = createObj(obj, NULL, i);
+		MojTestErrCheck(err);
+		err = objs.push(obj);
+		MojTestErrCheck(err);
+	}
+
+	// neighbours share most of their props, so compares go deep
+	int sum = 0;
+	timespec startTime;
+	timespec endTime;
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	for (MojUInt64 rep = 0; rep < NumRepetitions; ++rep) {
+		for (MojSize i = 1; i < objs.size(); ++i) {
+			sum += objs.at(i - 1).compare(objs.at(i));
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	(void) sum;
+
+	MojErr err = report(_T("compare"), (NumObjects - 1) * NumRepetitions, MojPerfTimeDiff(startTime, endTime));
+	MojTestErrCheck(err);
+
+	MojSize hash = 0;
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	for (MojUInt64 rep = 0; rep < NumRepetitions; ++rep) {
+		for (MojVector<MojObject>::ConstIterator i = objs.begin(); i != objs.end(); ++i) {
+			hash ^= i->hashCode();
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	(void) hash;
+
+	err = report(_T("hashCode"), NumObjects * NumRepetitions, MojPerfTimeDiff(startTime, endTime));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectPerfTest::report(const MojChar* op, MojUInt64 count, MojUInt64 time)
+{
+	MojErr err = MojPrintF("   %-16s %10llu ops in %12llu nanosecs | %10.1f nanosecs/op\n",
+						   op, count, time, double(time) / double(count));
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
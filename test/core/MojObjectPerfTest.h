@@ -0,0 +1,40 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJOBJECTPERFTEST_H_
+#define MOJOBJECTPERFTEST_H_
+
+#include "MojCorePerfTestRunner.h"
+#include "core/MojObject.h"
+
+class MojObjectPerfTest : public MojTestCase
+{
+public:
+	MojObjectPerfTest();
+
+	MojErr run();
+
+private:
+	MojErr createObj(MojObject& obj, MojObjectArena* arena, MojUInt64 i);
+	MojErr buildTest(MojObjectArena* arena);
+	MojErr parseTest();
+	MojErr visitTest();
+	MojErr compareTest();
+	MojErr report(const MojChar* op, MojUInt64 count, MojUInt64 time);
+};
+
+#endif /* MOJOBJECTPERFTEST_H_ */
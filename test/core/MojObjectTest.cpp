@@ -24,6 +24,7 @@
 #include "MojObjectTest.h"
 #include "core/MojHashMap.h"
 #include "core/MojObject.h"
+#include "core/MojObjectArena.h"
 #include "core/MojObjectBuilder.h"
 #include "core/MojString.h"
 
@@ -139,6 +140,10 @@ MojErr MojObjectTest::run()
 	// types
 	err = typeTest();
 	MojTestErrCheck(err);
+	err = stringTest();
+	MojTestErrCheck(err);
+	err = arenaTest();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -533,3 +538,135 @@ MojErr MojObjectTest::typeTest()
 
 	return MojErrNone;
 }
+
+MojErr MojObjectTest::stringTest()
+{
+	// strings on either side of the inline limit
+	MojString shortStr;
+	MojErr err = shortStr.assign(_T("0123456789abcdef"));
+	MojTestErrCheck(err);
+	MojString longStr;
+	err = longStr.assign(_T("0123456789abcdefg"));
+	MojTestErrCheck(err);
+
+	MojObject shortObj(shortStr);
+	MojObject longObj(longStr);
+	MojTestAssert(shortObj.type() == MojObject::TypeString);
+	MojTestAssert(longObj.type() == MojObject::TypeString);
+	MojTestAssert(shortObj != longObj);
+	MojTestAssert(shortObj < longObj);
+	MojTestAssert(shortObj.hashCode() == MojHash(shortStr));
+	MojTestAssert(longObj.hashCode() == MojHash(longStr));
+
+	MojString str;
+	err = shortObj.stringValue(str);
+	MojTestErrCheck(err);
+	MojTestAssert(str == shortStr);
+	err = longObj.stringValue(str);
+	MojTestErrCheck(err);
+	MojTestAssert(str == longStr);
+
+	MojObject copy = longObj;
+	MojTestAssert(copy == longObj);
+	copy = shortObj;
+	MojTestAssert(copy == shortObj);
+	err = str.assign(_T("10"));
+	MojTestErrCheck(err);
+	MojTestAssert(MojObject(str).intValue() == 10);
+	err = str.assign(_T("123456789012345678"));
+	MojTestErrCheck(err);
+	MojTestAssert(MojObject(str).intValue() == 123456789012345678LL);
+
+	// assigning a value that lives inside the target
+	MojObject obj;
+	err = obj.put(_T("child"), longObj);
+	MojTestErrCheck(err);
+	MojObject::ConstIterator iter = obj.find(_T("child"));
+	MojTestAssert(iter != obj.end());
+	obj = iter.value();
+	MojTestAssert(obj == longObj);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectTest::arenaTest()
+{
+	MojObjectArena arena;
+	{
+		MojObjectBuilder builder(&arena);
+		MojObjectVisitor& visitor = builder;
+		MojErr err = visitor.beginObject();
+		MojTestErrCheck(err);
+		err = visitor.propName(_T("arr"));
+		MojTestErrCheck(err);
+		err = visitor.beginArray();
+		MojTestErrCheck(err);
+		err = visitor.intValue(1);
+		MojTestErrCheck(err);
+		err = visitor.stringValue(_T("a string that does not fit inline"));
+		MojTestErrCheck(err);
+		err = visitor.endArray();
+		MojTestErrCheck(err);
+		err = visitor.endObject();
+		MojTestErrCheck(err);
+		MojTestAssert(arena.nodes() > 0);
+		MojTestAssert(arena.used() > 0);
+
+		MojObject expected;
+		err = expected.fromJson(_T("{\"arr\":[1,\"a string that does not fit inline\"]}"));
+		MojTestErrCheck(err);
+		MojTestAssert(builder.object() == expected);
+
+		MojObject copy = builder.object();
+		MojTestAssert(copy == expected);
+		err = copy.put(_T("int"), 5LL);
+		MojTestErrCheck(err);
+		MojTestAssert(copy != expected);
+
+		MojObject arr(MojObject::TypeArray, &arena);
+		err = arr.push(copy);
+		MojTestErrCheck(err);
+		MojTestAssert(arr.size() == 1);
+	}
+	// everything built from the arena is gone, so its memory gets reused
+	MojTestAssert(arena.nodes() == 0);
+	MojSize reserved = arena.reserved();
+	{
+		MojObject obj(MojObject::TypeObject, &arena);
+		MojTestAssert(arena.nodes() == 1);
+		MojTestAssert(arena.reserved() <= reserved);
+		MojTestAssert(arena.used() < reserved);
+	}
+	arena.clear();
+	MojTestAssert(arena.reserved() == 0);
+
+	// copies of arena-backed objects go to the heap and survive the arena
+	MojObject copy;
+	{
+		MojObject obj(MojObject::TypeObject, &arena);
+		MojObject arr(MojObject::TypeArray, &arena);
+		MojErr err = arr.push(MojObject(MojObject::TypeObject));
+		MojTestErrCheck(err);
+		err = arr.pushString(_T("a string that does not fit inline"));
+		MojTestErrCheck(err);
+		err = obj.put(_T("arr"), arr);
+		MojTestErrCheck(err);
+		MojSize nodes = arena.nodes();
+		copy = obj;
+		MojTestAssert(arena.nodes() == nodes);
+		MojTestAssert(copy == obj);
+	}
+	MojTestAssert(arena.nodes() == 0);
+	arena.clear();
+
+	MojObject expected;
+	MojErr err = expected.fromJson(_T("{\"arr\":[{},\"a string that does not fit inline\"]}"));
+	MojTestErrCheck(err);
+	MojTestAssert(copy == expected);
+	MojString json;
+	err = copy.toJson(json);
+	MojTestErrCheck(err);
+	MojTestAssert(json == _T("{\"arr\":[{},\"a string that does not fit inline\"]}"));
+
+	return MojErrNone;
+}
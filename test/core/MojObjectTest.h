@@ -40,6 +40,8 @@ protected:
 	MojErr putTest(MojObject& obj);
 	MojErr getTest(const MojObject& obj);
 	MojErr typeTest();
+	MojErr stringTest();
+	MojErr arenaTest();
 };
 
 #endif /* MOJOBJECTTEST_H_ */
@@ -0,0 +1,307 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+****************************************************************************************************
+* Filename              : MojObjectViewTest.cpp
+* Description           : Source file for MojObjectView test.
+****************************************************************************************************
+**/
+
+#include "MojObjectViewTest.h"
+#include "core/MojJson.h"
+#include "core/MojObjectSerialization.h"
+#include "core/MojObjectView.h"
+
+static const MojChar* const ViewJson =
+	_T("{\"i1\":-45, \"i2\":65536, \"d1\":3.14, \"s1\":\"hello\", \"b1\":true, \"n1\":null, ")
+	_T("\"o1\":{\"a1\":[1,{\"t\":4},[2,3],\"x\"], \"i1\":42}, \"e1\":{}, \"a2\":[]}");
+
+MojObjectViewTest::MojObjectViewTest()
+: MojTestCase(_T("MojObjectView"))
+{
+}
+
+/**
+****************************************************************************************************
+* @run              Serializes an object with MojObjectWriter and checks that a view over the
+                    buffer finds, iterates and rebuilds the same values as the object itself.
+* @param         :  None
+* @retval        :  MojErr
+****************************************************************************************************
+**/
+MojErr MojObjectViewTest::run()
+{
+	MojErr err = getTest();
+	MojTestErrCheck(err);
+	err = iterTest();
+	MojTestErrCheck(err);
+	err = headerTest();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectViewTest::getTest()
+{
+	MojObject obj;
+	MojErr err = obj.fromJson(ViewJson);
+	MojTestErrCheck(err);
+	MojObjectWriter writer;
+	err = obj.visit(writer);
+	MojTestErrCheck(err);
+	const MojByte* data = NULL;
+	MojSize size = 0;
+	err = writer.buf().data(data, size);
+	MojTestErrCheck(err);
+
+	MojObjectView view(data, size);
+	MojTestAssert(view.serialized());
+	MojTestAssert(view.type() == MojObject::TypeObject);
+
+	MojObjectView val;
+	bool found = false;
+	err = view.get(_T("i1"), val, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found && val.type() == MojObject::TypeInt);
+	MojInt64 intVal = 0;
+	err = val.intValue(intVal);
+	MojTestErrCheck(err);
+	MojTestAssert(intVal == -45);
+
+	err = view.get(_T("i2"), val, found);
+	MojTestErrCheck(err);
+	err = val.intValue(intVal);
+	MojTestErrCheck(err);
+	MojTestAssert(found && intVal == 65536);
+
+	err = view.get(_T("d1"), val, found);
+	MojTestErrCheck(err);
+	MojDecimal decVal;
+	err = val.decimalValue(decVal);
+	MojTestErrCheck(err);
+	MojTestAssert(found && decVal == MojDecimal(3, 140000));
+
+	err = view.get(_T("s1"), val, found);
+	MojTestErrCheck(err);
+	MojString strVal;
+	err = val.stringValue(strVal);
+	MojTestErrCheck(err);
+	MojTestAssert(found && strVal == _T("hello"));
+
+	err = view.get(_T("b1"), val, found);
+	MojTestErrCheck(err);
+	bool boolVal = false;
+	err = val.boolValue(boolVal);
+	MojTestErrCheck(err);
+	MojTestAssert(found && boolVal);
+
+	err = view.get(_T("n1"), val, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found && val.null());
+
+	err = view.get(_T("i"), val, found);
+	MojTestErrCheck(err);
+	MojTestAssert(!found);
+	err = view.get(_T("nope"), val, found);
+	MojTestErrCheck(err);
+	MojTestAssert(!found);
+
+	// nested, past values that have to be skipped
+	MojObjectView o1;
+	err = view.get(_T("o1"), o1, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found && o1.type() == MojObject::TypeObject);
+	err = o1.get(_T("i1"), val, found);
+	MojTestErrCheck(err);
+	err = val.intValue(intVal);
+	MojTestErrCheck(err);
+	MojTestAssert(found && intVal == 42);
+
+	// whole object and a sub-object rebuild to the original
+	MojObject rebuilt;
+	err = view.toObject(rebuilt);
+	MojTestErrCheck(err);
+	MojTestAssert(rebuilt == obj);
+	MojObject expected;
+	MojTestAssert(obj.get(_T("o1"), expected));
+	err = o1.toObject(rebuilt);
+	MojTestErrCheck(err);
+	MojTestAssert(rebuilt == expected);
+
+	// visiting the view produces the same json as visiting the object
+	MojJsonWriter viewWriter;
+	err = view.visit(viewWriter);
+	MojTestErrCheck(err);
+	MojJsonWriter objWriter;
+	err = obj.visit(objWriter);
+	MojTestErrCheck(err);
+	MojTestAssert(viewWriter.json() == objWriter.json());
+
+	// a view over an object gives the same answers
+	MojObjectView objView(obj);
+	MojTestAssert(!objView.serialized());
+	err = objView.get(_T("o1"), o1, found);
+	MojTestErrCheck(err);
+	err = o1.get(_T("i1"), val, found);
+	MojTestErrCheck(err);
+	err = val.intValue(intVal);
+	MojTestErrCheck(err);
+	MojTestAssert(found && intVal == 42);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectViewTest::iterTest()
+{
+	MojObject obj;
+	MojErr err = obj.fromJson(ViewJson);
+	MojTestErrCheck(err);
+	MojObjectWriter writer;
+	err = obj.visit(writer);
+	MojTestErrCheck(err);
+	const MojByte* data = NULL;
+	MojSize size = 0;
+	err = writer.buf().data(data, size);
+	MojTestErrCheck(err);
+	MojObjectView view(data, size);
+
+	// props come back in serialized order with values matching the object
+	MojSize count = 0;
+	MojObjectView::ConstIterator iter;
+	err = view.begin(iter);
+	MojTestErrCheck(err);
+	for (;;) {
+		bool found = false;
+		err = iter.next(found);
+		MojTestErrCheck(err);
+		if (!found)
+			break;
+		MojObject expected;
+		MojTestAssert(obj.get(iter.key(), expected));
+		MojObject val;
+		err = iter.value().toObject(val);
+		MojTestErrCheck(err);
+		MojTestAssert(val == expected);
+		++count;
+	}
+	MojTestAssert(count == obj.size());
+
+	// array elements
+	MojObjectView o1;
+	MojObjectView a1;
+	bool found = false;
+	err = view.get(_T("o1"), o1, found);
+	MojTestErrCheck(err);
+	err = o1.get(_T("a1"), a1, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found && a1.type() == MojObject::TypeArray);
+	MojObject::Type types[] = {MojObject::TypeInt, MojObject::TypeObject, MojObject::TypeArray, MojObject::TypeString};
+	count = 0;
+	err = a1.begin(iter);
+	MojTestErrCheck(err);
+	for (;;) {
+		err = iter.next(found);
+		MojTestErrCheck(err);
+		if (!found)
+			break;
+		MojTestAssert(count < 4);
+		MojTestAssert(iter.key().empty());
+		MojTestAssert(iter.value().type() == types[count]);
+		++count;
+	}
+	MojTestAssert(count == 4);
+
+	// empty containers
+	MojObjectView empty;
+	err = view.get(_T("e1"), empty, found);
+	MojTestErrCheck(err);
+	err = empty.begin(iter);
+	MojTestErrCheck(err);
+	err = iter.next(found);
+	MojTestErrCheck(err);
+	MojTestAssert(!found);
+	err = view.get(_T("a2"), empty, found);
+	MojTestErrCheck(err);
+	err = empty.begin(iter);
+	MojTestErrCheck(err);
+	err = iter.next(found);
+	MojTestErrCheck(err);
+	MojTestAssert(!found);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectViewTest::headerTest()
+{
+	MojObject obj;
+	MojErr err = obj.fromJson(_T("{\"foo\":1,\"bar\":\"baz\"}"));
+	MojTestErrCheck(err);
+	MojObjectWriter writer;
+	err = obj.visit(writer);
+	MojTestErrCheck(err);
+	const MojByte* data = NULL;
+	MojSize size = 0;
+	err = writer.buf().data(data, size);
+	MojTestErrCheck(err);
+
+	MojObject header;
+	err = header.putString(_T("_id"), _T("abc"));
+	MojTestErrCheck(err);
+	err = header.put(_T("_rev"), 7);
+	MojTestErrCheck(err);
+	MojObjectView view(data, size, NULL, &header);
+
+	// header props are found without touching the body
+	MojObjectView val;
+	bool found = false;
+	err = view.get(_T("_rev"), val, found);
+	MojTestErrCheck(err);
+	MojInt64 rev = 0;
+	err = val.intValue(rev);
+	MojTestErrCheck(err);
+	MojTestAssert(found && rev == 7);
+	err = view.get(_T("foo"), val, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+
+	// and show up when the object is rebuilt or iterated
+	MojObject expected = obj;
+	err = expected.putString(_T("_id"), _T("abc"));
+	MojTestErrCheck(err);
+	err = expected.put(_T("_rev"), 7);
+	MojTestErrCheck(err);
+	MojObject rebuilt;
+	err = view.toObject(rebuilt);
+	MojTestErrCheck(err);
+	MojTestAssert(rebuilt == expected);
+
+	MojSize count = 0;
+	MojObjectView::ConstIterator iter;
+	err = view.begin(iter);
+	MojTestErrCheck(err);
+	for (;;) {
+		err = iter.next(found);
+		MojTestErrCheck(err);
+		if (!found)
+			break;
+		++count;
+	}
+	MojTestAssert(count == 4);
+
+	return MojErrNone;
+}
@@ -23,8 +23,11 @@
 **/
 
 #include "MojSchemaTest.h"
+#include "MojCorePerfTestRunner.h"
 #include "core/MojSchema.h"
 
+static const MojUInt64 NumThroughputObjects = 2000;
+
 MojSchemaTest::MojSchemaTest()
 : MojTestCase(_T("MojSchema"))
 {
@@ -45,6 +48,7 @@ MojSchemaTest::MojSchemaTest()
                       8.stringTest
                       9.enumTest
                       10.divisibleTest
+                      11.throughputTest
 * @param            : None
 * @retval           : MojErr
 ***************************************************************************************************
@@ -71,6 +75,8 @@ MojErr MojSchemaTest::run()
 	MojTestErrCheck(err);
 	err = divisibleTest();
 	MojTestErrCheck(err);
+	err = throughputTest();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -991,6 +997,180 @@ MojErr MojSchemaTest::divisibleTest()
 
 	return MojErrNone;
 }
+/**
+***************************************************************************************************
+* @throughputTest               Validates batches of objects against schemas shaped like a kind
+                                schema, a nested record and a service method schema, checks
+                                every result and prints the time spent per object.
+* @param                      : None
+* @retval                     : MojErr
+***************************************************************************************************
+**/
+
+MojErr MojSchemaTest::throughputTest()
+{
+	MojErr err = MojPrintF("\n");
+	MojTestErrCheck(err);
+
+	// flat record with typed, bounded and enumerated properties
+	MojObject flatSchema;
+	err = flatSchema.fromJson(_T("{\"type\":\"object\",\"properties\":{"
+		"\"id\":{\"type\":\"integer\",\"minimum\":0,\"optional\":false},"
+		"\"name\":{\"type\":\"string\",\"minLength\":1,\"maxLength\":32},"
+		"\"email\":{\"type\":\"string\",\"pattern\":\"[a-z0-9]+@[a-z]+\\\\.com\"},"
+		"\"score\":{\"type\":\"number\",\"maximum\":100},"
+		"\"status\":{\"enum\":[\"new\",\"active\",\"closed\"]},"
+		"\"flag\":{\"type\":\"boolean\"},"
+		"\"count\":{\"type\":\"integer\",\"divisibleBy\":2},"
+		"\"note\":{\"type\":[\"null\",\"string\"]}}}"));
+	MojTestErrCheck(err);
+	err = checkThroughput(_T("flat"), flatSchema, &MojSchemaTest::createFlatObj);
+	MojTestErrCheck(err);
+
+	// nested arrays of objects
+	MojObject nestedSchema;
+	err = nestedSchema.fromJson(_T("{\"type\":\"object\",\"properties\":{"
+		"\"id\":{\"type\":\"integer\",\"optional\":false},"
+		"\"items\":{\"type\":\"array\",\"maxItems\":16,\"items\":{\"type\":\"object\",\"properties\":{"
+			"\"key\":{\"type\":\"string\",\"optional\":false},"
+			"\"tags\":{\"type\":\"array\",\"uniqueItems\":true,\"items\":{\"type\":\"string\"}}}}}}}"));
+	MojTestErrCheck(err);
+	err = checkThroughput(_T("nested"), nestedSchema, &MojSchemaTest::createNestedObj);
+	MojTestErrCheck(err);
+
+	// service method params, extra properties are rejected
+	MojObject methodSchema;
+	err = methodSchema.fromJson(_T("{\"type\":\"object\",\"additionalProperties\":false,\"properties\":{"
+		"\"ids\":{\"type\":\"array\",\"minItems\":1,\"items\":{\"type\":\"string\"}},"
+		"\"purge\":{\"type\":\"boolean\"},"
+		"\"query\":{\"type\":\"object\",\"properties\":{\"from\":{\"type\":\"string\",\"optional\":false}}}}}"));
+	MojTestErrCheck(err);
+	err = checkThroughput(_T("method"), methodSchema, &MojSchemaTest::createMethodObj);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojSchemaTest::checkThroughput(const MojChar* name, const MojObject& schemaObj, CreateFn create)
+{
+	MojSchema schema;
+	MojErr err = schema.fromObject(schemaObj);
+	MojTestErrCheck(err);
+
+	// every 10th object is made invalid
+	MojVector<MojObject> objs;
+	for (MojUInt64 i = 0; i < NumThroughputObjects; ++i) {
+		MojObject obj;
+		err = (this->*create)(obj, i, i % 10 == 9);
+		MojTestErrCheck(err);
+		err = objs.push(obj);
+		MojTestErrCheck(err);
+	}
+
+	MojUInt64 numValid = 0;
+	timespec startTime;
+	timespec endTime;
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	for (MojVector<MojObject>::ConstIterator i = objs.begin(); i != objs.end(); ++i) {
+		MojSchema::Result res;
+		err = schema.validate(*i, res);
+		MojTestErrCheck(err);
+		if (res.valid())
+			++numValid;
+		else
+			MojTestAssert(!res.msg().empty());
+	}
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	MojTestAssert(numValid == NumThroughputObjects - NumThroughputObjects / 10);
+
+	MojUInt64 time = MojPerfTimeDiff(startTime, endTime);
+	err = MojPrintF("   schema %-8s %8llu objs in %12llu nanosecs | %10.1f nanosecs/obj\n",
+					name, NumThroughputObjects, time, double(time) / double(NumThroughputObjects));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojSchemaTest::createFlatObj(MojObject& obj, MojUInt64 i, bool invalid)
+{
+	MojErr err = obj.put(_T("id"), (MojInt64) i);
+	MojTestErrCheck(err);
+	MojString str;
+	err = str.format(_T("name%llu"), i);
+	MojTestErrCheck(err);
+	err = obj.put(_T("name"), str);
+	MojTestErrCheck(err);
+	err = str.format(_T("user%llu@example.com"), i);
+	MojTestErrCheck(err);
+	err = obj.put(_T("email"), str);
+	MojTestErrCheck(err);
+	err = obj.putDecimal(_T("score"), MojDecimal((MojInt64) (i % 100), 500000));
+	MojTestErrCheck(err);
+	err = obj.putString(_T("status"), (i % 2) ? _T("active") : _T("new"));
+	MojTestErrCheck(err);
+	err = obj.putBool(_T("flag"), (i % 3) == 0);
+	MojTestErrCheck(err);
+	// the last property checked fails, so invalid objects walk the whole schema
+	err = obj.putInt(_T("count"), invalid ? 3 : 4);
+	MojTestErrCheck(err);
+	err = obj.put(_T("note"), MojObject::Null);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojSchemaTest::createNestedObj(MojObject& obj, MojUInt64 i, bool invalid)
+{
+	MojErr err = obj.putInt(_T("id"), (MojInt64) i);
+	MojTestErrCheck(err);
+	MojObject items(MojObject::TypeArray);
+	for (int j = 0; j < 4; ++j) {
+		MojObject item;
+		MojString key;
+		err = key.format(_T("key%d"), j);
+		MojTestErrCheck(err);
+		err = item.put(_T("key"), key);
+		MojTestErrCheck(err);
+		MojObject tags(MojObject::TypeArray);
+		err = tags.pushString(_T("red"));
+		MojTestErrCheck(err);
+		err = tags.pushString(_T("green"));
+		MojTestErrCheck(err);
+		err = tags.pushString((invalid && j == 3) ? _T("red") : _T("blue"));
+		MojTestErrCheck(err);
+		err = item.put(_T("tags"), tags);
+		MojTestErrCheck(err);
+		err = items.push(item);
+		MojTestErrCheck(err);
+	}
+	err = obj.put(_T("items"), items);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojSchemaTest::createMethodObj(MojObject& obj, MojUInt64 i, bool invalid)
+{
+	MojObject ids(MojObject::TypeArray);
+	for (int j = 0; j < 3; ++j) {
+		MojString id;
+		MojErr err = id.format(_T("++%llu.%d"), i, j);
+		MojTestErrCheck(err);
+		err = ids.push(id);
+		MojTestErrCheck(err);
+	}
+	MojErr err = obj.put(_T("ids"), ids);
+	MojTestErrCheck(err);
+	err = obj.putBool(_T("purge"), (i % 2) == 0);
+	MojTestErrCheck(err);
+	if (invalid) {
+		err = obj.putBool(_T("unknown"), true);
+		MojTestErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
 /**
 ***************************************************************************************************
 * @checkValid                   The CheckValid function takes two parameters as input and validates
@@ -44,6 +44,13 @@ private:
 	MojErr stringTest();
 	MojErr enumTest();
 	MojErr divisibleTest();
+	MojErr throughputTest();
+
+	typedef MojErr (MojSchemaTest::*CreateFn)(MojObject& obj, MojUInt64 i, bool invalid);
+	MojErr checkThroughput(const MojChar* name, const MojObject& schemaObj, CreateFn create);
+	MojErr createFlatObj(MojObject& obj, MojUInt64 i, bool invalid);
+	MojErr createNestedObj(MojObject& obj, MojUInt64 i, bool invalid);
+	MojErr createMethodObj(MojObject& obj, MojUInt64 i, bool invalid);
 
 	MojErr checkValid(const MojChar* schemaJson, const MojChar* instanceJson, bool expected);
 };
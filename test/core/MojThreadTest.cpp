@@ -108,6 +108,40 @@ static MojErr MojThreadTestErrFn(void* arg)
 	return MojErrNotFound;
 }
 
+struct MojThreadEpochTestArgs
+{
+	MojThreadEpochTestArgs() : m_first(0), m_second(0) {}
+
+	MojInt32 m_first;
+	MojInt32 m_second;
+	MojThreadEpochLock m_lock;
+};
+
+static MojErr MojThreadEpochTestFn(void* arg)
+{
+	MojThreadEpochTestArgs* targs = (MojThreadEpochTestArgs*) arg;
+	MojTestAssert(targs);
+
+	for (int i = 0; i < MojTestNumIterations; ++i) {
+		targs->m_lock.readLock();
+		MojInt32 first = targs->m_first;
+		// nested read locks must not wait for a writer
+		targs->m_lock.readLock();
+		MojTestAssert(targs->m_second == first);
+		targs->m_lock.unlock();
+		targs->m_lock.unlock();
+
+		if (i % 10 == 0) {
+			MojThreadEpochWriteGuard guard(targs->m_lock);
+			++(targs->m_first);
+			MojErr err = MojThreadYield();
+			MojTestErrCheck(err);
+			++(targs->m_second);
+		}
+	}
+	return MojErrNone;
+}
+
 MojThreadTest::MojThreadTest()
 : MojTestCase(_T("MojThread"))
 {
@@ -119,6 +153,7 @@ MojThreadTest::MojThreadTest()
                           It includes two tests.
                            1.Basic test
                            2.err Test
+                           3.epoch lock Test
 
 * @param                : None
 * @retval               : MojErr
@@ -130,6 +165,8 @@ MojErr MojThreadTest::run()
 	MojTestErrCheck(err);
 	err = errTest();
 	MojTestErrCheck(err);
+	err = epochLockTest();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -223,3 +260,37 @@ MojErr MojThreadTest::errTest()
 
 	return MojErrNone;
 }
+
+/**
+***************************************************************************************************
+* @epochLockTest          Threads read two counters under a read lock, nested once, and every
+                          tenth iteration bump both under the write lock. Readers must never
+                          see the counters differ and no update may be lost.
+                          eg:MojThreadEpochWriteGuard guard(targs->m_lock);
+
+* @param                : None
+* @retval               : MojErr
+***************************************************************************************************
+**/
+MojErr MojThreadTest::epochLockTest()
+{
+	MojVector<MojThreadT> threads;
+	MojThreadEpochTestArgs args;
+	for (int i = 0; i < MojTestNumThreads; ++i) {
+		MojThreadT thread = MojInvalidThread;
+		MojErr err = MojThreadCreate(thread, MojThreadEpochTestFn, &args);
+		MojTestErrCheck(err);
+		err = threads.push(thread);
+		MojTestErrCheck(err);
+	}
+	for (MojVector<MojThreadT>::ConstIterator i = threads.begin(); i != threads.end(); ++i) {
+		MojErr threadErr = MojErrNone;
+		MojErr err = MojThreadJoin(*i, threadErr);
+		MojTestErrCheck(err);
+		MojTestErrCheck(threadErr);
+	}
+	MojTestAssert(args.m_first == MojTestNumThreads * (MojTestNumIterations / 10));
+	MojTestAssert(args.m_second == args.m_first);
+
+	return MojErrNone;
+}
@@ -36,6 +36,7 @@ public:
 private:
 	MojErr basicTest();
 	MojErr errTest();
+	MojErr epochLockTest();
 };
 
 #endif /* MOJTHREADTEST_H_ */
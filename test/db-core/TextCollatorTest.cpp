@@ -267,3 +267,69 @@ TEST_F(TextCollatorTest, accentsOrder)
     EXPECT_TRUE( keyFr1 < keyFr4 );
     EXPECT_TRUE( keyFr2 < keyFr4 );
 }
+
+/**
+ * Cached keys and the ASCII shortcut must give exactly the bytes ICU gives,
+ * since keys end up in indexes built before and after the cache.
+ */
+TEST_F(TextCollatorTest, sortKeyCache)
+{
+    MojDbSortKeyCache& cache = MojDbTextCollator::keyCache();
+    cache.clear();
+
+    MojDbTextCollator colEn1;
+    MojAssertNoErr( colEn1.init(_T("en_US"), MojDbCollationPrimary) );
+    MojDbTextCollator colEn3;
+    MojAssertNoErr( colEn3.init(_T("en_US"), MojDbCollationTertiary) );
+
+    const MojChar* const strs[] = { _T(""), _T("CotE"), _T("côTe"), _T("Motörhead"), _T("a021") };
+    for (MojSize i = 0; i < sizeof(strs) / sizeof(strs[0]); ++i) {
+        MojString str;
+        MojAssertNoErr( str.assign(strs[i]) );
+        MojDbTextUtils::UnicodeVec chars;
+        MojAssertNoErr( MojDbTextUtils::strToUnicode(str, chars) );
+
+        MojDbKey icuKey1, icuKey3;
+        MojExpectNoErr( colEn1.sortKey(chars.begin(), chars.size(), icuKey1) );
+        MojExpectNoErr( colEn3.sortKey(chars.begin(), chars.size(), icuKey3) );
+
+        // first call fills the cache, second one is served from it
+        for (int pass = 0; pass < 2; ++pass) {
+            MojDbKey key1, key3;
+            MojExpectNoErr( colEn1.sortKey(str, key1) );
+            MojExpectNoErr( colEn3.sortKey(str, key3) );
+            EXPECT_EQ( icuKey1, key1 ) << "string #" << i << " pass " << pass;
+            EXPECT_EQ( icuKey3, key3 ) << "string #" << i << " pass " << pass;
+        }
+    }
+    EXPECT_EQ( 10u, cache.size() );
+    EXPECT_EQ( 10, cache.hits() );
+    EXPECT_EQ( 10, cache.misses() );
+
+    // another collator with the same locale and strength shares the entries
+    MojDbTextCollator colEn1b;
+    MojAssertNoErr( colEn1b.init(_T("en_US"), MojDbCollationPrimary) );
+    MojString cote;
+    MojAssertNoErr( cote.assign(_T("CotE")) );
+    MojDbKey key;
+    MojExpectNoErr( colEn1b.sortKey(cote, key) );
+    EXPECT_EQ( 11, cache.hits() );
+
+    // long strings bypass the cache
+    MojString longStr;
+    for (MojSize i = 0; i <= MojDbSortKeyCache::MaxStringLen; ++i)
+        MojAssertNoErr( longStr.append(_T('x')) );
+    MojExpectNoErr( colEn1.sortKey(longStr, key) );
+    EXPECT_EQ( 10u, cache.size() );
+
+    // zero size disables caching
+    MojObject conf;
+    MojAssertNoErr( conf.put(MojDbSortKeyCache::SizeKey, (MojInt64) 0) );
+    MojAssertNoErr( cache.configure(conf) );
+    EXPECT_EQ( 0u, cache.size() );
+    MojExpectNoErr( colEn1.sortKey(cote, key) );
+    EXPECT_EQ( 0u, cache.size() );
+
+    MojAssertNoErr( cache.configure(MojObject()) );
+    cache.clear();
+}
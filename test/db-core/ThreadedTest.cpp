@@ -17,8 +17,12 @@
 #include "MojDbCoreTest.h"
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 struct ThreadedTest : MojDbCoreTest
 {
@@ -202,3 +206,114 @@ TEST_F(ThreadedTest, watch_cancel_vs_delKind)
         MojAssertNoErr( db.putKind(kindObj) );
     }
 }
+
+TEST_F(ThreadedTest, read_scaling)
+{
+    const size_t maxThreads = 16, nobjects = 100, nreads = 20000;
+
+    std::vector<MojObject> ids;
+    for (size_t n = 0; n < nobjects; ++n)
+    {
+        MojObject obj;
+        MojAssertNoErr( obj.putString(MojDb::KindKey, kindId) );
+        MojAssertNoErr( obj.putInt("x", n) );
+        MojAssertNoErr( db.put(obj) );
+        MojObject id;
+        MojAssertNoErr( obj.getRequired(MojDb::IdKey, id) );
+        ids.push_back(id);
+    }
+
+    // readers only ever take the schema lock shared, so gets should scale with cores
+    std::atomic<size_t> misses(0);
+    const auto f = [&](size_t worker) {
+        MojObject obj;
+        bool found = false;
+        for (size_t n = 0; n < nreads; ++n)
+        {
+            MojExpectNoErr( db.get(ids[(worker + n) % nobjects], obj, found) );
+            if (!found) ++misses;
+        }
+    };
+
+    double baseRate = 0;
+    for (size_t nthreads = 1; nthreads <= maxThreads; nthreads *= 2)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t worker = 0; worker < nthreads; ++worker)
+        {
+            threads.emplace_back(f, worker);
+        }
+        for (auto &thread : threads) thread.join();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const double rate = double(nthreads * nreads) / elapsed.count();
+        if (nthreads == 1) baseRate = rate;
+        printf("   %2zu threads: %10.0f gets/sec (%.2fx)\n", nthreads, rate, rate / baseRate);
+    }
+
+    EXPECT_EQ( 0u, misses.load() );
+}
+
+TEST_F(ThreadedTest, reads_vs_putKind)
+{
+    const size_t nthreads = 8, nkinds = 20;
+    const char * const otherKindDef =
+        "{\"id\":\"Other:1\", \"owner\":\"mojodb.admin\","
+        "\"indexes\":[{\"name\":\"y\",\"props\":[{\"name\":\"y\"}]}]"
+        "}";
+
+    MojObject obj;
+    MojAssertNoErr( obj.putString(MojDb::KindKey, kindId) );
+    MojAssertNoErr( obj.putInt("x", 1) );
+    MojAssertNoErr( db.put(obj) );
+    MojObject id;
+    MojAssertNoErr( obj.getRequired(MojDb::IdKey, id) );
+
+    // readers keep going while kinds come and go, schema changes wait for them to drain
+    std::atomic<bool> done(false);
+    std::atomic<size_t> reads(0), misses(0);
+    const auto f = [&](size_t worker) {
+        MojObject obj;
+        bool found = false;
+        while (!done)
+        {
+            MojExpectNoErr( db.get(id, obj, found) );
+            if (!found) ++misses;
+
+            MojDbQuery query;
+            MojExpectNoErr( query.from(kindId) );
+            MojDbCursor cursor;
+            MojExpectNoErr( db.find(query, cursor) );
+            MojUInt32 count = 0;
+            MojExpectNoErr( cursor.count(count) );
+            if (count != 1) ++misses;
+            MojExpectNoErr( cursor.close() );
+            ++reads;
+        }
+    };
+
+    std::array<std::thread, nthreads> threads;
+    for (size_t worker = 0; worker < threads.size(); ++worker)
+    {
+        threads[worker] = std::thread(f, worker);
+    }
+
+    MojString otherKind;
+    MojAssertNoErr( otherKind.assign("Other:1") );
+    for (size_t n = 0; n < nkinds; ++n)
+    {
+        MojObject kindObj;
+        MojExpectNoErr( kindObj.fromJson(otherKindDef) );
+        MojExpectNoErr( db.putKind(kindObj) );
+        bool foundKind = false;
+        MojExpectNoErr( db.delKind(otherKind, foundKind) );
+        EXPECT_TRUE( foundKind );
+    }
+
+    done = true;
+    for (auto &thread : threads) thread.join();
+
+    EXPECT_LT( 0u, reads.load() );
+    EXPECT_EQ( 0u, misses.load() );
+}
@@ -0,0 +1,254 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "MojDbCompactSchedulerTest.h"
+#include "db/MojDbCompactScheduler.h"
+
+namespace {
+	class TestCompactor : public MojDbCompactScheduler::Compactor
+	{
+	public:
+		TestCompactor() : m_calls(0), m_err(MojErrNone) {}
+		MojErr compactRange(const std::string& part, const std::string& from, const std::string& to) override
+		{
+			++m_calls;
+			m_part = part;
+			m_from = from;
+			m_to = to;
+			return m_err;
+		}
+
+		int m_calls;
+		MojErr m_err;
+		std::string m_part;
+		std::string m_from;
+		std::string m_to;
+	};
+
+	MojErr noteWrite(MojDbCompactScheduler& scheduler, const std::string& part, const std::string& key, MojSize written, MojSize deleted)
+	{
+		MojDbCompactScheduler::RangeMap ranges;
+		ranges[part].note(key.data(), key.size(), written, deleted);
+		scheduler.noteCommit(ranges);
+		return MojErrNone;
+	}
+
+	MojErr configure(MojDbCompactScheduler& scheduler, MojInt64 budget, MojInt64 threshold)
+	{
+		MojObject conf;
+		MojErr err = conf.put(MojDbCompactScheduler::IdleKey, (MojInt64) 0);
+		MojErrCheck(err);
+		err = conf.put(MojDbCompactScheduler::BudgetKey, budget);
+		MojErrCheck(err);
+		err = conf.put(MojDbCompactScheduler::ThresholdKey, threshold);
+		MojErrCheck(err);
+		err = scheduler.configure(conf);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+}
+
+MojDbCompactSchedulerTest::MojDbCompactSchedulerTest()
+: MojTestCase("MojDbCompactScheduler")
+{
+}
+
+MojErr MojDbCompactSchedulerTest::run()
+{
+	MojErr err = rangeTest();
+	MojTestErrCheck(err);
+	err = stepTest();
+	MojTestErrCheck(err);
+	err = budgetTest();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbCompactSchedulerTest::rangeTest()
+{
+	MojDbCompactScheduler::Range range;
+	range.note("m", 1, 10, 0);
+	MojTestAssert(range.m_min == "m" && range.m_max == "m");
+	range.note("c", 1, 0, 5);
+	range.note("x", 1, 10, 0);
+	range.note("d", 1, 10, 0);
+	MojTestAssert(range.m_min == "c" && range.m_max == "x");
+	MojTestAssert(range.m_written == 30 && range.m_deleted == 5);
+	MojTestAssert(range.debt() == 35);
+
+	MojDbCompactScheduler::Range other;
+	other.note("a", 1, 1, 0);
+	range.merge(other);
+	MojTestAssert(range.m_min == "a" && range.m_max == "x");
+	MojTestAssert(range.debt() == 36);
+
+	return MojErrNone;
+}
+
+MojErr MojDbCompactSchedulerTest::stepTest()
+{
+	TestCompactor compactor;
+	MojDbCompactScheduler scheduler(compactor);
+	MojErr err = configure(scheduler, 1000000, 100);
+	MojTestErrCheck(err);
+
+	// below the threshold nothing runs
+	err = noteWrite(scheduler, "cold", "k", 50, 0);
+	MojTestErrCheck(err);
+	MojTime now;
+	err = MojGetCurrentTime(now);
+	MojTestErrCheck(err);
+	now += MojSecs(1);
+	bool ran = true;
+	err = scheduler.step(now, ran);
+	MojTestErrCheck(err);
+	MojTestAssert(!ran);
+	MojTestAssert(compactor.m_calls == 0);
+
+	// the part with the most debt goes first, over the keys it touched
+	err = noteWrite(scheduler, "warm", "b", 150, 0);
+	MojTestErrCheck(err);
+	err = noteWrite(scheduler, "hot", "q", 100, 0);
+	MojTestErrCheck(err);
+	err = noteWrite(scheduler, "hot", "f", 0, 100);
+	MojTestErrCheck(err);
+	now += MojSecs(1);
+	err = scheduler.step(now, ran);
+	MojTestErrCheck(err);
+	MojTestAssert(ran);
+	MojTestAssert(compactor.m_calls == 1);
+	MojTestAssert(compactor.m_part == "hot");
+	MojTestAssert(compactor.m_from == "f" && compactor.m_to == "q");
+
+	now += MojSecs(1);
+	err = scheduler.step(now, ran);
+	MojTestErrCheck(err);
+	MojTestAssert(ran);
+	MojTestAssert(compactor.m_part == "warm");
+	now += MojSecs(1);
+	err = scheduler.step(now, ran);
+	MojTestErrCheck(err);
+	MojTestAssert(!ran);
+
+	MojObject stats;
+	err = scheduler.stats(stats);
+	MojTestErrCheck(err);
+	MojInt64 val = 0;
+	MojTestAssert(stats.get(_T("steps"), val) && val == 2);
+	MojTestAssert(stats.get(_T("compacted"), val) && val == 350);
+	MojTestAssert(stats.get(_T("debt"), val) && val == 50);
+	MojTestAssert(stats.get(_T("hotParts"), val) && val == 0);
+
+	// parts compacted together drop their debt together
+	err = noteWrite(scheduler, "s1/a", "k", 20, 0);
+	MojTestErrCheck(err);
+	err = noteWrite(scheduler, "s1/b", "k", 30, 0);
+	MojTestErrCheck(err);
+	err = noteWrite(scheduler, "s2/a", "k", 40, 0);
+	MojTestErrCheck(err);
+	scheduler.forgetPrefix("s1/");
+	stats.clear();
+	err = scheduler.stats(stats);
+	MojTestErrCheck(err);
+	MojTestAssert(stats.get(_T("debt"), val) && val == 90);
+	MojTestAssert(stats.get(_T("parts"), val) && val == 2);
+
+	// a full compaction clears the debt
+	scheduler.reset();
+	stats.clear();
+	err = scheduler.stats(stats);
+	MojTestErrCheck(err);
+	MojTestAssert(stats.get(_T("debt"), val) && val == 0);
+
+	// the worker stops without waiting out its interval
+	err = scheduler.start();
+	MojTestErrCheck(err);
+	err = scheduler.stop();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbCompactSchedulerTest::budgetTest()
+{
+	TestCompactor compactor;
+	MojDbCompactScheduler scheduler(compactor);
+	// 1000 bytes per sec, every step below overdraws it
+	MojErr err = configure(scheduler, 1000, 1);
+	MojTestErrCheck(err);
+
+	MojTime now;
+	err = MojGetCurrentTime(now);
+	MojTestErrCheck(err);
+	now += MojSecs(1);
+	err = noteWrite(scheduler, "a", "k", 3000, 0);
+	MojTestErrCheck(err);
+	err = noteWrite(scheduler, "b", "k", 3000, 0);
+	MojTestErrCheck(err);
+
+	bool ran = false;
+	err = scheduler.step(now, ran);
+	MojTestErrCheck(err);
+	MojTestAssert(ran);
+
+	// 2000 bytes in debt, two seconds later still not paid off
+	now += MojSecs(2);
+	err = scheduler.step(now, ran);
+	MojTestErrCheck(err);
+	MojTestAssert(!ran);
+	now += MojMillisecs(1500);
+	err = scheduler.step(now, ran);
+	MojTestErrCheck(err);
+	MojTestAssert(ran);
+	MojTestAssert(compactor.m_calls == 2);
+
+	MojObject stats;
+	err = scheduler.stats(stats);
+	MojTestErrCheck(err);
+	MojInt64 throttled = 0;
+	MojTestAssert(stats.get(_T("throttled"), throttled) && throttled == 1);
+
+	// a failed step gives its tokens back
+	now += MojSecs(3);
+	err = noteWrite(scheduler, "c", "k", 500, 0);
+	MojTestErrCheck(err);
+	compactor.m_err = MojErrNotFound;
+	err = scheduler.step(now, ran);
+	MojTestErrExpected(err, MojErrNotFound);
+	MojTestAssert(ran);
+	compactor.m_err = MojErrNone;
+	stats.clear();
+	err = scheduler.stats(stats);
+	MojTestErrCheck(err);
+	MojInt64 val = 0;
+	MojTestAssert(stats.get(_T("tokens"), val) && val == 1000);
+	MojTestAssert(stats.get(_T("errors"), val) && val == 1);
+	MojTestAssert(stats.get(_T("debt"), val) && val == 0);
+
+	// budget 0 turns tracking off
+	err = configure(scheduler, 0, 1);
+	MojTestErrCheck(err);
+	err = noteWrite(scheduler, "a", "k", 3000, 0);
+	MojTestErrCheck(err);
+	now += MojSecs(10);
+	err = scheduler.step(now, ran);
+	MojTestErrCheck(err);
+	MojTestAssert(!ran);
+
+	return MojErrNone;
+}
@@ -19,6 +19,8 @@
 #include "db/MojDb.h"
 #include "db/MojDbQuery.h"
 #include "db/MojDbCursor.h"
+#include "db/MojDbQueryExecutor.h"
+#include <vector>
 
 static const MojChar* const TestKind =
 	_T("{\"id\":\"Test:1\",")
@@ -27,6 +29,9 @@ static const MojChar* const TestKind =
 static const MojChar* const TestJson =
 	_T("{\"_kind\":\"Test:1\",\"foo\":100,\"bar\":5000}");
 static const MojUInt32 TestNumObjects = 10000;
+static const MojSize TestExecutorItems = 1000;
+static const MojSize TestExecutorJobs = 50;
+static const MojSize TestExecutorThreads = 4;
 
 /**
 ****************************************************************************************************
@@ -82,6 +87,56 @@ static MojErr queryThread(void* arg)
 	return MojErrNone;
 }
 
+class MojDbConcurrencyTestJob : public MojDbQueryExecutor::Job
+{
+public:
+	MojDbConcurrencyTestJob(MojSize count, MojSize slots, MojSize failAt = MojInvalidIndex)
+	: m_items(count, 0), m_slots(slots, 0), m_failAt(failAt) {}
+
+	virtual MojErr run(MojSize begin, MojSize end, MojSize slot)
+	{
+		if (slot >= m_slots.size())
+			MojErrThrow(MojErrInvalidArg);
+		for (MojSize i = begin; i < end; ++i) {
+			if (i == m_failAt)
+				MojErrThrow(MojErrNotFound);
+			++m_items[i];
+			++m_slots[slot];
+		}
+		return MojErrNone;
+	}
+
+	std::vector<MojSize> m_items;
+	std::vector<MojSize> m_slots;
+	MojSize m_failAt;
+};
+/**
+****************************************************************************************************
+* @executorThread   Callback function to run jobs on the shared query executor.
+* @param         :  arg
+* @retval        :  MojErr
+****************************************************************************************************
+**/
+static MojErr executorThread(void* arg)
+{
+	MojDbQueryExecutor* executor = (MojDbQueryExecutor*) arg;
+
+	for (MojSize n = 0; n < TestExecutorJobs; ++n) {
+		MojDbConcurrencyTestJob job(TestExecutorItems, executor->slots());
+		MojErr err = executor->run(job, TestExecutorItems, 1 + n % 16);
+		MojTestErrCheck(err);
+
+		// every item is visited exactly once, whichever threads did the work
+		MojSize total = 0;
+		for (MojSize i = 0; i < job.m_items.size(); ++i)
+			MojTestAssert(job.m_items[i] == 1);
+		for (MojSize i = 0; i < job.m_slots.size(); ++i)
+			total += job.m_slots[i];
+		MojTestAssert(total == TestExecutorItems);
+	}
+	return MojErrNone;
+}
+
 MojDbConcurrencyTest::MojDbConcurrencyTest()
 : MojTestCase(_T("MojDbConcurrency"))
 {
@@ -130,11 +185,58 @@ MojErr MojDbConcurrencyTest::run()
 	MojTestAssert(err1 == MojErrNone || err1 == MojErrDbDeadlock);
 	MojTestAssert(err2 == MojErrNone || err2 == MojErrDbDeadlock);
 
+	err = executorTest(db);
+	MojTestErrCheck(err);
+
 	err = db.close();
 	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
+/**
+****************************************************************************************************
+* @executorTest     Submits jobs to the db's query executor from several threads at once and
+                    checks that each item is processed once, errors are returned to the
+                    submitter and jobs still complete on the calling thread after close.
+* @param         :  db
+* @retval        :  MojErr
+****************************************************************************************************
+**/
+MojErr MojDbConcurrencyTest::executorTest(MojDb& db)
+{
+	MojDbQueryExecutor* executor = db.queryExecutor();
+	MojTestAssert(executor->slots() == executor->threads() + 1);
+
+	MojThreadT threads[TestExecutorThreads];
+	for (MojSize i = 0; i < TestExecutorThreads; ++i) {
+		threads[i] = MojInvalidThread;
+		MojErr err = MojThreadCreate(threads[i], executorThread, executor);
+		MojTestErrCheck(err);
+	}
+	for (MojSize i = 0; i < TestExecutorThreads; ++i) {
+		MojErr threadErr = MojErrNone;
+		MojErr err = MojThreadJoin(threads[i], threadErr);
+		MojTestErrCheck(err);
+		MojTestErrCheck(threadErr);
+	}
+
+	// a failing batch fails the whole job
+	MojDbConcurrencyTestJob failJob(TestExecutorItems, executor->slots(), TestExecutorItems / 2);
+	MojErr err = executor->run(failJob, TestExecutorItems, 4);
+	MojTestErrExpected(err, MojErrNotFound);
+
+	// once closed, jobs run entirely on the calling thread
+	err = executor->close();
+	MojTestErrCheck(err);
+	MojDbConcurrencyTestJob job(TestExecutorItems, executor->slots());
+	err = executor->run(job, TestExecutorItems, 4);
+	MojTestErrCheck(err);
+	MojTestAssert(job.m_slots[0] == TestExecutorItems);
+	err = executor->open();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
 
 void MojDbConcurrencyTest::cleanup()
 {
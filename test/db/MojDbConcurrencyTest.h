@@ -33,6 +33,9 @@ public:
 
 	virtual MojErr run();
 	virtual void cleanup();
+
+private:
+	MojErr executorTest(MojDb& db);
 };
 
 #endif /* MOJDBCONCURRENCYTEST_H_ */
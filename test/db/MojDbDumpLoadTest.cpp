@@ -32,6 +32,7 @@ namespace {
 static const MojChar* const MojLoadTestFileName = _T("loadtest.json");
 static const MojChar* const MojDumpTestFileName1 = _T("dumptest_with_config.json");
 static const MojChar* const MojDumpTestFileName2 = _T("dumptest_without_config.json");
+static const MojChar* const MojDumpTestFileName3 = _T("dumptest_binary.db8");
 static const MojChar* const MojTestStr =
 	_T("{\"_id\":\"_kinds/LoadTest:1\",\"_kind\":\"Kind:1\",\"id\":\"LoadTest:1\",\"owner\":\"mojodb.admin\",")
 	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]},{\"name\":\"barfoo\",\"props\":[{\"name\":\"bar\"},{\"name\":\"foo\"}]}]}")
@@ -150,6 +151,10 @@ MojErr MojDbDumpLoadTest::run()
     err = db.stats(analysis);
     MojErrCheck(err);
 
+    // binary dump should round-trip the same objects
+    err = testBinary(db);
+    MojTestErrCheck(err);
+
 	err = db.close();
 	MojTestErrCheck(err);
 
@@ -212,10 +217,46 @@ MojErr MojDbDumpLoadTest::testDump(MojDb& db, bool a_enable) {
     return MojErrNone;
 }
 
+MojErr MojDbDumpLoadTest::testBinary(MojDb& db)
+{
+	MojUInt32 count = 0;
+	MojErr err = db.dumpBinary(sandboxFileName(MojDumpTestFileName3), count, false);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 11);
+
+	bool binary = false;
+	err = MojDbDumpFile::isDump(sandboxFileName(MojDumpTestFileName3), binary);
+	MojTestErrCheck(err);
+	MojTestAssert(binary);
+	err = MojDbDumpFile::isDump(sandboxFileName(MojLoadTestFileName), binary);
+	MojTestErrCheck(err);
+	MojTestAssert(!binary);
+
+	MojString id;
+	err = id.assign(_T("LoadTest:1"));
+	MojTestErrCheck(err);
+	bool found = false;
+	err = db.delKind(id, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	err = db.purge(count, 0);
+	MojTestErrCheck(err);
+
+	count = 0;
+	err = db.load(sandboxFileName(MojDumpTestFileName3), count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 11);
+	err = checkCount(db);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 void MojDbDumpLoadTest::cleanup()
 {
 	(void) MojUnlink(sandboxFileName(MojLoadTestFileName));
 	(void) MojUnlink(sandboxFileName(MojDumpTestFileName1));
     (void) MojUnlink(sandboxFileName(MojDumpTestFileName2));
+	(void) MojUnlink(sandboxFileName(MojDumpTestFileName3));
 	(void) MojRmDirRecursive(MojDbTestDir);
 }
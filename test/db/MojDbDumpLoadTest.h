@@ -31,6 +31,7 @@ public:
 private:
 	MojErr checkCount(MojDb& db);
     MojErr testDump(MojDb& db, bool a_enable);
+	MojErr testBinary(MojDb& db);
 };
 
 #endif /* MOJDBDUMPLOADTEST_H_ */
@@ -126,6 +126,10 @@ MojErr MojDbIndexTest::run()
 	MojTestErrCheck(err);
 	err = tokenizeTest();
 	MojTestErrCheck(err);
+	err = planTest();
+	MojTestErrCheck(err);
+	err = statsTest();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -661,6 +665,9 @@ MojErr MojDbIndexTest::wildcardTest()
 	err = put(index, 1, _T("{\"foo\":{\"2\":{\"bar\":2},\"3\":{\"bar\":3}}}"), _T("{\"foo\":{\"1\":{\"bar\":1},\"2\":{\"bar\":2},\"3\":{\"bar\":3}}}"));
 	MojTestErrCheck(err);
 	MojTestAssert(ti.m_putCount == 3 && ti.m_delCount == 1 && ti.m_set.size() == 2);
+	err = put(index, 1, _T("{\"foo\":{\"2\":{\"bar\":2},\"3\":{\"bar\":3}},\"baz\":1}"), _T("{\"foo\":{\"2\":{\"bar\":2},\"3\":{\"bar\":3}}}"));
+	MojTestErrCheck(err);
+	MojTestAssert(ti.m_putCount == 3 && ti.m_delCount == 1 && ti.m_set.size() == 2);
 	err = assertContains(ti, 1, 2);
 	MojTestErrCheck(err);
 	err = assertContains(ti, 1, 3);
@@ -806,6 +813,14 @@ MojErr MojDbIndexTest::multiTest()
 	err = assertContains(ti, 1, 6);
 	MojTestErrCheck(err);
 	MojTestAssert(ti.m_putCount == 5 && ti.m_delCount == 4 && ti.m_set.size() == 1);
+	// none of the included props changed
+	err = put(index, 1, _T("{\"bar\":6,\"qux\":7}"), _T("{\"bar\":6}"));
+	MojTestErrCheck(err);
+	MojTestAssert(ti.m_putCount == 5 && ti.m_delCount == 4 && ti.m_set.size() == 1);
+	// an included prop removed
+	err = put(index, 1, _T("{\"qux\":7}"), _T("{\"bar\":6,\"qux\":7}"));
+	MojTestErrCheck(err);
+	MojTestAssert(ti.m_putCount == 5 && ti.m_delCount == 5 && ti.m_set.size() == 0);
 
 	err = index.close();
 	MojTestErrCheck(err);
@@ -841,6 +856,163 @@ MojErr MojDbIndexTest::tokenizeTest()
 	err = assertContainsText(ti, 1, _T("fathers"));
 	MojTestErrCheck(err);
 	MojTestAssert(ti.m_putCount == 9 && ti.m_delCount == 6 && ti.m_set.size() == 3);
+	// text untouched, other props changed -> no index writes
+	err = put(index, 1, _T("{\"foo\":\"our fathers put\",\"bar\":1}"), _T("{\"foo\":\"our fathers put\"}"));
+	MojTestErrCheck(err);
+	MojTestAssert(ti.m_putCount == 9 && ti.m_delCount == 6 && ti.m_set.size() == 3);
+	// text changed but tokens didn't
+	err = put(index, 1, _T("{\"foo\":\"Our fathers, put!\"}"), _T("{\"foo\":\"our fathers put\",\"bar\":1}"));
+	MojTestErrCheck(err);
+	MojTestAssert(ti.m_putCount == 9 && ti.m_delCount == 6 && ti.m_set.size() == 3);
+	// one word replaced
+	err = put(index, 1, _T("{\"foo\":\"our mothers put\"}"), _T("{\"foo\":\"Our fathers, put!\"}"));
+	MojTestErrCheck(err);
+	err = assertContainsText(ti, 1, _T("mothers"));
+	MojTestErrCheck(err);
+	MojTestAssert(ti.m_putCount == 10 && ti.m_delCount == 7 && ti.m_set.size() == 3);
+
+	err = index.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndexTest::planTest()
+{
+	MojDbIndex narrow(NULL, NULL);
+	MojRefCountedPtr<TestIndex> narrowStorage(new TestIndex(false));
+	MojAllocCheck(narrowStorage.get());
+	MojDbIndex wide(NULL, NULL);
+	MojRefCountedPtr<TestIndex> wideStorage(new TestIndex(false));
+	MojAllocCheck(wideStorage.get());
+
+	MojErr err = indexFromObject(narrow,
+			_T("{\"name\":\"narrow\",\"props\":[{\"name\":\"foo\"}]}"));
+	MojTestErrCheck(err);
+	err = indexFromObject(wide,
+			_T("{\"name\":\"wide\",\"props\":[{\"name\":\"foo\"},{\"name\":\"bar\"}]}"));
+	MojTestErrCheck(err);
+	MojDbReq req;
+	err = narrow.open(narrowStorage.get(), (MojInt64) 0, req);
+	MojTestErrCheck(err);
+	err = wide.open(wideStorage.get(), (MojInt64) 1, req);
+	MojTestErrCheck(err);
+
+	// 200 objects spread over 4 distinct foo values
+	for (MojInt64 i = 0; i < 200; ++i) {
+		MojString json;
+		err = json.format(_T("{\"foo\":%lld,\"bar\":\"a fairly long value to make keys bigger %lld\"}"), i % 4, i);
+		MojTestErrCheck(err);
+		err = put(narrow, i, json.data(), NULL);
+		MojTestErrCheck(err);
+		err = put(wide, i, json.data(), NULL);
+		MojTestErrCheck(err);
+	}
+
+	MojObject queryObj;
+	err = queryObj.fromJson(_T("{\"from\":\"Test:1\",\"where\":[{\"prop\":\"foo\",\"op\":\"=\",\"val\":1}]}"));
+	MojTestErrCheck(err);
+	MojDbQuery query;
+	err = query.fromObject(queryObj);
+	MojTestErrCheck(err);
+	MojTestAssert(narrow.canAnswer(query) && wide.canAnswer(query));
+
+	// both scan ~50 rows, but the narrow index reads smaller keys
+	MojDouble narrowRows = 0;
+	MojDouble wideRows = 0;
+	MojDouble narrowCost = narrow.scanCost(query, narrowRows);
+	MojDouble wideCost = wide.scanCost(query, wideRows);
+	MojTestAssert(narrowRows > 25 && narrowRows < 100);
+	MojTestAssert(wideRows > 25 && wideRows < 100);
+	MojTestAssert(narrowCost < wideCost);
+
+	// a range on the last prop narrows the estimate further
+	err = queryObj.fromJson(_T("{\"from\":\"Test:1\",\"where\":[{\"prop\":\"foo\",\"op\":\"=\",\"val\":1},{\"prop\":\"bar\",\"op\":\">\",\"val\":\"b\"}]}"));
+	MojTestErrCheck(err);
+	MojDbQuery rangeQuery;
+	err = rangeQuery.fromObject(queryObj);
+	MojTestErrCheck(err);
+	MojTestAssert(!narrow.canAnswer(rangeQuery) && wide.canAnswer(rangeQuery));
+	MojDouble rangeRows = 0;
+	wide.scanCost(rangeQuery, rangeRows);
+	MojTestAssert(rangeRows < wideRows);
+
+	// running counts of an index that wasn't created empty aren't trusted until seeded,
+	// stats saved to the kind catalog seed the index they are restored into
+	MojTestAssert(!narrow.hasStats());
+	MojObject saved;
+	err = narrow.saveStats(saved);
+	MojTestErrCheck(err);
+	MojDbIndex restored(NULL, NULL);
+	MojRefCountedPtr<TestIndex> restoredStorage(new TestIndex(false));
+	MojAllocCheck(restoredStorage.get());
+	err = indexFromObject(restored,
+			_T("{\"name\":\"narrow\",\"props\":[{\"name\":\"foo\"}]}"));
+	MojTestErrCheck(err);
+	err = restored.open(restoredStorage.get(), (MojInt64) 2, req);
+	MojTestErrCheck(err);
+	err = restored.restoreStats(saved);
+	MojTestErrCheck(err);
+	MojTestAssert(restored.hasStats());
+	MojDouble restoredRows = 0;
+	MojDouble restoredCost = restored.scanCost(query, restoredRows);
+	MojTestAssert(restoredRows == narrowRows && restoredCost == narrowCost);
+	MojObject bad;
+	err = bad.fromJson(_T("{\"keys\":1,\"bytes\":10,\"registers\":[\"0\"]}"));
+	MojTestErrCheck(err);
+	err = restored.restoreStats(bad);
+	MojTestErrExpected(err, MojErrDbInvalidIndex);
+	err = restored.close();
+	MojTestErrCheck(err);
+
+	err = narrow.close();
+	MojTestErrCheck(err);
+	err = wide.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndexTest::statsTest()
+{
+	MojDbIndex index(NULL, NULL);
+	MojRefCountedPtr<TestIndex> storageIndex(new TestIndex(false));
+	MojAllocCheck(storageIndex.get());
+	TestIndex& ti = *storageIndex;
+
+	MojErr err = indexFromObject(index, _T("{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}"));
+	MojTestErrCheck(err);
+	MojDbReq req;
+	err = index.open(storageIndex.get(), (MojInt64) 0, req);
+	MojTestErrCheck(err);
+
+	err = put(index, 1, _T("{\"foo\":1}"), NULL);
+	MojTestErrCheck(err);
+	MojObject stats;
+	MojInt64 keys = 0;
+	err = index.saveStats(stats);
+	MojTestErrCheck(err);
+	MojTestAssert(stats.get(MojDbIndexStats::KeysKey, keys) && keys == 1);
+
+	// keys written by a txn that never commits don't count
+	{
+		MojObject obj;
+		err = obj.fromJson(_T("{\"_id\":2,\"foo\":2}"));
+		MojTestErrCheck(err);
+		TestTxn txn;
+		err = index.update(&obj, NULL, &txn, false);
+		MojTestErrCheck(err);
+	}
+	MojTestAssert(ti.m_set.size() == 2);
+	err = index.saveStats(stats);
+	MojTestErrCheck(err);
+	MojTestAssert(stats.get(MojDbIndexStats::KeysKey, keys) && keys == 1);
+
+	err = del(index, 1, _T("{\"foo\":1}"), true);
+	MojTestErrCheck(err);
+	err = index.saveStats(stats);
+	MojTestErrCheck(err);
+	MojTestAssert(stats.get(MojDbIndexStats::KeysKey, keys) && keys == 0);
 
 	err = index.close();
 	MojTestErrCheck(err);
@@ -885,6 +1057,8 @@ MojErr MojDbIndexTest::put(MojDbIndex& index, MojObject id, const MojChar* jsonN
 	TestTxn txn;
 	err = index.update(&newObj, jsonOld ? &oldObj : NULL, &txn, false);
 	MojTestErrCheck(err);
+	err = txn.commit();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -902,6 +1076,8 @@ MojErr MojDbIndexTest::del(MojDbIndex& index, MojObject id, const MojChar* json,
 	MojTestErrCheck(err);
 	err = index.update(purge ? NULL: &newObj, &oldObj, &txn, false);
 	MojTestErrCheck(err);
+	err = txn.commit();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
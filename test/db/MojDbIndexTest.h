@@ -40,6 +40,8 @@ private:
 	MojErr defaultValuesTest();
 	MojErr multiTest();
 	MojErr tokenizeTest();
+	MojErr planTest();
+	MojErr statsTest();
 
 	MojErr checkInvalid(MojErr errExpected, const MojChar* json);
 	MojErr indexFromObject(MojDbIndex& index, const MojChar* json);
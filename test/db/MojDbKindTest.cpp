@@ -18,6 +18,7 @@
 #include "MojDbKindTest.h"
 #include "db/MojDb.h"
 #include "db/MojDbKind.h"
+#include "db/MojDbKindCatalog.h"
 #include "db/MojDbReq.h"
 #include "db/MojDbStorageEngine.h"
 
@@ -33,6 +34,23 @@ namespace {
         assert(err == MojErrNone);
         return path;
     }
+
+    MojErr countCatalogObjs(MojDb& db, MojUInt32& countOut)
+    {
+        MojDbQuery query;
+        MojErr err = query.from(_T("CatalogA:1"));
+        MojErrCheck(err);
+        err = query.where(_T("foo"), MojDbQuery::OpGreaterThan, 0);
+        MojErrCheck(err);
+        MojDbCursor cursor;
+        err = db.find(query, cursor);
+        MojErrCheck(err);
+        err = cursor.count(countOut);
+        MojErrCheck(err);
+        err = cursor.close();
+        MojErrCheck(err);
+        return MojErrNone;
+    }
 }
 
 static const MojChar* const MojKindDumpTestFileName = _T("kind_dumptest.json");
@@ -58,6 +76,15 @@ static const MojChar* const MojTestIndexesFooBarStr =
 	_T("{\"id\":\"KindTest:1\",")
 	_T("\"owner\":\"mojodb.admin\",")
 	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]},{\"name\":\"bar\",\"props\":[{\"name\":\"bar\"}]}]}");
+static const MojChar* const MojTestBuildConfStr =
+	_T("{\"db\":{\"indexBuildChunk\":10}}");
+static const MojChar* const MojTestBuildKindStr =
+	_T("{\"id\":\"BuildTest:1\",")
+	_T("\"owner\":\"mojodb.admin\"}");
+static const MojChar* const MojTestBuildIndexesStr =
+	_T("{\"id\":\"BuildTest:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}");
 static const MojChar* const MojTestIndexesBarFooStr =
 	_T("{\"id\":\"KindTest:1\",")
 	_T("\"owner\":\"mojodb.admin\",")
@@ -196,6 +223,10 @@ MojErr MojDbKindTest::run()
 	MojTestErrCheck(err);*/
 	err = testFindTokenizedIndex();
 	MojTestErrCheck(err);
+	err = testBuildIndexInChunks();
+	MojTestErrCheck(err);
+	err = testCatalog();
+	MojTestErrCheck(err);
 	return MojErrNone;
 }
 
@@ -1933,6 +1964,236 @@ MojErr MojDbKindTest::testFindTokenizedIndex()
 	return MojErrNone;
 }
 
+MojErr MojDbKindTest::testBuildIndexInChunks()
+{
+	const MojInt64 numObjs = 95;
+
+	// small chunks so that most of the kind is left to the index builder
+	MojObject conf;
+	MojErr err = conf.fromJson(MojTestBuildConfStr);
+	MojTestErrCheck(err);
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	MojObject kind;
+	err = kind.fromJson(MojTestBuildKindStr);
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+	MojVector<MojObject> ids;
+	for (MojInt64 i = 0; i < numObjs; ++i) {
+		MojObject obj;
+		err = obj.putString(MojDb::KindKey, _T("BuildTest:1"));
+		MojTestErrCheck(err);
+		err = obj.put(_T("foo"), i);
+		MojTestErrCheck(err);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+		MojObject id;
+		err = obj.getRequired(MojDb::IdKey, id);
+		MojTestErrCheck(err);
+		err = ids.push(id);
+		MojTestErrCheck(err);
+	}
+
+	// add index on foo and keep writing while it is backfilled
+	err = kind.fromJson(MojTestBuildIndexesStr);
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+
+	MojInt64 expectedCount = 0;
+	MojInt64 expectedSum = 0;
+	for (MojInt64 i = 0; i < numObjs; ++i) {
+		if (i % 5 == 0) {
+			bool found = false;
+			err = db.del(ids.at((MojSize) i), found);
+			MojTestErrCheck(err);
+			MojTestAssert(found);
+			continue;
+		}
+		MojInt64 foo = i;
+		if (i % 5 == 1) {
+			foo += 1000;
+			MojObject obj;
+			err = obj.put(MojDb::IdKey, ids.at((MojSize) i));
+			MojTestErrCheck(err);
+			err = obj.put(_T("foo"), foo);
+			MojTestErrCheck(err);
+			err = db.merge(obj);
+			MojTestErrCheck(err);
+		}
+		++expectedCount;
+		expectedSum += foo;
+	}
+	for (MojInt64 i = 0; i < 5; ++i) {
+		MojObject obj;
+		err = obj.putString(MojDb::KindKey, _T("BuildTest:1"));
+		MojTestErrCheck(err);
+		err = obj.put(_T("foo"), 2000 + i);
+		MojTestErrCheck(err);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+		++expectedCount;
+		expectedSum += 2000 + i;
+	}
+
+	err = db.indexBuilder()->drain();
+	MojTestErrCheck(err);
+	MojTestAssert(db.indexBuilder()->pending() == 0);
+
+	// every live object is in the index exactly once, with its latest value
+	for (int pass = 0; pass < 2; ++pass) {
+		MojDbQuery query;
+		err = query.from(_T("BuildTest:1"));
+		MojTestErrCheck(err);
+		err = query.where(_T("foo"), MojDbQuery::OpGreaterThanEq, 0);
+		MojTestErrCheck(err);
+		MojDbCursor cursor;
+		err = db.find(query, cursor);
+		MojTestErrCheck(err);
+		MojInt64 count = 0;
+		MojInt64 sum = 0;
+		MojInt64 prev = -1;
+		for (;;) {
+			bool found = false;
+			MojObject obj;
+			err = cursor.get(obj, found);
+			MojTestErrCheck(err);
+			if (!found)
+				break;
+			MojInt64 foo = 0;
+			err = obj.getRequired(_T("foo"), foo);
+			MojTestErrCheck(err);
+			MojTestAssert(foo > prev);
+			prev = foo;
+			sum += foo;
+			++count;
+		}
+		err = cursor.close();
+		MojTestErrCheck(err);
+		MojTestAssert(count == expectedCount);
+		MojTestAssert(sum == expectedSum);
+
+		// finished builds must not be resumed on next open
+		err = db.close();
+		MojTestErrCheck(err);
+		err = db.configure(conf);
+		MojTestErrCheck(err);
+		err = db.open(MojDbTestDir);
+		MojTestErrCheck(err);
+		MojTestAssert(db.indexBuilder()->pending() == 0);
+	}
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindTest::testCatalog()
+{
+	MojDb db;
+	MojErr err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	// CatalogB extends CatalogA, its objects are found through the index on CatalogA
+	MojObject kind;
+	err = kind.fromJson(_T("{\"id\":\"CatalogA:1\",\"owner\":\"foo\",\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}"));
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+	err = kind.fromJson(_T("{\"id\":\"CatalogB:1\",\"owner\":\"foo\",\"extends\":[\"CatalogA:1\"]}"));
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+	MojObject obj;
+	err = obj.fromJson(_T("{\"_kind\":\"CatalogB:1\",\"foo\":1}"));
+	MojTestErrCheck(err);
+	err = db.put(obj);
+	MojTestErrCheck(err);
+	err = db.close();
+	MojTestErrCheck(err);
+
+	// a clean close leaves a catalog with every stored kind
+	MojObject catalog;
+	MojInt64 catalogRev = 0;
+	bool found = false;
+	err = MojDbKindCatalog::read(MojDbTestDir, catalog, catalogRev, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	MojTestAssert(catalogRev > 0);
+	MojObject kinds;
+	MojTestAssert(catalog.get(MojDbKindCatalog::KindsKey, kinds));
+	bool foundA = false;
+	bool foundB = false;
+	for (MojObject::ConstArrayIterator i = kinds.arrayBegin(); i != kinds.arrayEnd(); ++i) {
+		MojString id;
+		err = i->getRequired(MojDbServiceDefs::IdKey, id);
+		MojTestErrCheck(err);
+		foundA = foundA || id == _T("CatalogA:1");
+		foundB = foundB || id == _T("CatalogB:1");
+		// kinds are stored as given, the hash configure generates stays out
+		MojTestAssert(!i->contains(MojDbKind::HashKey));
+	}
+	MojTestAssert(foundA && foundB);
+
+	// open loads from the catalog and drops it, indexes and supers work as before
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojObject catalogAfterOpen;
+	MojInt64 revAfterOpen = 0;
+	err = MojDbKindCatalog::read(MojDbTestDir, catalogAfterOpen, revAfterOpen, found);
+	MojTestErrCheck(err);
+	MojTestAssert(!found);
+	MojUInt32 count = 0;
+	err = countCatalogObjs(db, count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 1);
+	err = obj.fromJson(_T("{\"_kind\":\"CatalogB:1\",\"foo\":2}"));
+	MojTestErrCheck(err);
+	err = db.put(obj);
+	MojTestErrCheck(err);
+	err = countCatalogObjs(db, count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 2);
+	err = db.close();
+	MojTestErrCheck(err);
+
+	// a catalog from another revision of the db is ignored, even if it reads fine
+	MojObject noKinds(MojObject::TypeArray);
+	err = catalog.put(MojDbKindCatalog::KindsKey, noKinds);
+	MojTestErrCheck(err);
+	err = MojDbKindCatalog::write(MojDbTestDir, catalog, catalogRev);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	err = MojDbKindCatalog::read(MojDbTestDir, catalogAfterOpen, revAfterOpen, found);
+	MojTestErrCheck(err);
+	MojTestAssert(!found);
+	err = countCatalogObjs(db, count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 2);
+	err = db.close();
+	MojTestErrCheck(err);
+
+	// a damaged catalog is ignored
+	err = MojFileFromString(sandboxFileName(MojDbKindCatalog::FileName), _T("DB8KIND garbage"));
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	err = countCatalogObjs(db, count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 2);
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 void MojDbKindTest::cleanup()
 {
 	(void) MojRmDirRecursive(MojDbTestDir);
@@ -43,6 +43,8 @@ private:
 	MojErr testInvalidKinds();
 	MojErr testObjectPermissions();
 	MojErr testFindTokenizedIndex();
+	MojErr testBuildIndexInChunks();
+	MojErr testCatalog();
 };
 
 #endif /* MOJDBKINDTEST_H_ */
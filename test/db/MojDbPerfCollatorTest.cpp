@@ -0,0 +1,132 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "MojDbPerfCollatorTest.h"
+#include "db/MojDbKey.h"
+
+static const MojUInt64 numRepetitions = 200;
+
+// values repeat heavily, like artist and album names in a media library
+static const MojChar* const MojPerfCollatorStrs[] = {
+	_T("The Beatles"), _T("Abbey Road"), _T("Pink Floyd"), _T("The Dark Side of the Moon"),
+	_T("Led Zeppelin"), _T("Queen"), _T("A Night at the Opera"), _T("Radiohead"),
+	_T("OK Computer"), _T("Nirvana"), _T("Nevermind"), _T("David Bowie"),
+	_T("Björk"), _T("Homogenic"), _T("Sigur Rós"), _T("Ágætis byrjun"),
+	_T("Beyoncé"), _T("Motörhead"), _T("Café Tacvba"), _T("Mötley Crüe")
+};
+
+extern MojUInt64 allTestsTime;
+
+MojDbPerfCollatorTest::MojDbPerfCollatorTest()
+: MojDbPerfTest(_T("MojDbPerfCollator"))
+{
+}
+
+MojErr MojDbPerfCollatorTest::run()
+{
+	MojErr err = testStrength(MojDbCollationPrimary, _T("primary"));
+	MojTestErrCheck(err);
+	err = testStrength(MojDbCollationSecondary, _T("secondary"));
+	MojTestErrCheck(err);
+	err = testStrength(MojDbCollationTertiary, _T("tertiary"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfCollatorTest::testStrength(MojDbCollationStrength strength, const MojChar* name)
+{
+	const MojSize numStrs = sizeof(MojPerfCollatorStrs) / sizeof(MojPerfCollatorStrs[0]);
+	MojDbSortKeyCache& cache = MojDbTextCollator::keyCache();
+
+	MojDbTextCollator collator;
+	MojErr err = collator.init(_T("en_US"), strength);
+	MojTestErrCheck(err);
+
+	// every key computed by ICU
+	MojObject conf;
+	err = conf.put(MojDbSortKeyCache::SizeKey, (MojInt64) 0);
+	MojTestErrCheck(err);
+	err = cache.configure(conf);
+	MojTestErrCheck(err);
+	cache.clear();
+
+	MojUInt64 icuTime = 0;
+	MojDbKey icuKey;
+	err = timeSortKeys(collator, MojPerfCollatorStrs, numStrs, icuTime, icuKey);
+	MojTestErrCheck(err);
+
+	// same strings with the cache enabled
+	err = cache.configure(MojObject());
+	MojTestErrCheck(err);
+	cache.clear();
+
+	MojUInt64 cacheTime = 0;
+	MojDbKey cacheKey;
+	err = timeSortKeys(collator, MojPerfCollatorStrs, numStrs, cacheTime, cacheKey);
+	MojTestErrCheck(err);
+	MojTestAssert(icuKey == cacheKey);
+
+	MojUInt64 numCalls = numStrs * numRepetitions;
+	err = MojPrintF("\n -------------------- \n");
+	MojTestErrCheck(err);
+	err = MojPrintF("   %s sortKey without cache: %llu nanosecs per call\n", name, icuTime / numCalls);
+	MojTestErrCheck(err);
+	err = MojPrintF("   %s sortKey with cache: %llu nanosecs per call, %lld hits, %lld misses\n",
+			name, cacheTime / numCalls, cache.hits(), cache.misses());
+	MojTestErrCheck(err);
+
+	allTestsTime += icuTime + cacheTime;
+	cache.clear();
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfCollatorTest::timeSortKeys(MojDbTextCollator& collator, const MojChar* const* strs, MojSize numStrs,
+		MojUInt64& timeOut, MojDbKey& lastKeyOut)
+{
+	MojVector<MojString> vals;
+	for (MojSize i = 0; i < numStrs; ++i) {
+		MojString str;
+		MojErr err = str.assign(strs[i]);
+		MojTestErrCheck(err);
+		err = vals.push(str);
+		MojTestErrCheck(err);
+	}
+
+	timespec startTime;
+	startTime.tv_nsec = 0;
+	startTime.tv_sec = 0;
+	timespec endTime;
+	endTime.tv_nsec = 0;
+	endTime.tv_sec = 0;
+	clock_gettime(CLOCK_REALTIME, &startTime);
+	for (MojUInt64 rep = 0; rep < numRepetitions; ++rep) {
+		for (MojSize i = 0; i < numStrs; ++i) {
+			MojErr err = collator.sortKey(vals.at(i), lastKeyOut);
+			MojTestErrCheck(err);
+		}
+	}
+	clock_gettime(CLOCK_REALTIME, &endTime);
+	timeOut += timeDiff(startTime, endTime);
+
+	return MojErrNone;
+}
+
+void MojDbPerfCollatorTest::cleanup()
+{
+}
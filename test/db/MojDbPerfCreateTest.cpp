@@ -21,6 +21,7 @@
 
 static const MojUInt64 numInsert = 1000;
 static const int numRepetitions = 5;
+static const int numPutThreads = 3;
 
 extern MojUInt64 allTestsTime;
 static MojUInt64 totalTestTime = 0;
@@ -44,6 +45,11 @@ MojErr MojDbPerfCreateTest::run()
 
 	err = testCreate();
 	MojTestErrCheck(err);
+	// group commit only matters when every write syncs
+	if (!lazySync()) {
+		err = testConcurrentInsert(MojPerfSmKindId);
+		MojTestErrCheck(err);
+	}
 	allTestsTime += totalTestTime;
 
 	err = MojPrintF("\n\n TOTAL TEST TIME: %llu nanoseconds. | %10.3f seconds.\n\n", totalTestTime, double(totalTestTime) / 1000000000.0);
@@ -824,6 +830,133 @@ MojErr MojDbPerfCreateTest::batchPutLargeArrayObj(MojDb& db, const MojChar* kind
 	return MojErrNone;
 }
 
+struct MojDbPerfPutThreadArgs
+{
+	MojDbPerfCreateTest* test;
+	MojDb* db;
+	const MojChar* kindId;
+	MojUInt64 first;
+};
+
+static MojErr putThread(void* arg)
+{
+	MojDbPerfPutThreadArgs* args = (MojDbPerfPutThreadArgs*) arg;
+	for (MojUInt64 i = args->first; i < numInsert; i += numPutThreads) {
+		MojObject obj;
+		MojErr err = obj.putString(MojDb::KindKey, args->kindId);
+		MojTestErrCheck(err);
+		err = args->test->createSmallObj(obj, i);
+		MojTestErrCheck(err);
+		err = args->db->put(obj);
+		MojTestErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbPerfCreateTest::testConcurrentInsert(const MojChar* kindId)
+{
+	// same puts from several threads, one fsync per put vs. one per group
+	MojUInt64 singleTime = 0;
+	MojUInt64 groupTime = 0;
+	for (int i = 0; i < numRepetitions; i++) {
+		MojErr err = concurrentPut(0, kindId, singleTime);
+		MojTestErrCheck(err);
+		err = concurrentPut(-1, kindId, groupTime);
+		MojTestErrCheck(err);
+	}
+
+	MojErr err = MojPrintF("\n -------------------- \n");
+	MojTestErrCheck(err);
+	err = MojPrintF("   time to put %llu %s objects from %d threads %d times: %llu nanosecs without group commit, %llu nanosecs with group commit\n",
+			numInsert, kindId, numPutThreads, numRepetitions, singleTime, groupTime);
+	MojTestErrCheck(err);
+	err = MojPrintF("   time per object: %llu nanosecs without group commit, %llu nanosecs with group commit",
+			singleTime / (numInsert * numRepetitions), groupTime / (numInsert * numRepetitions));
+	MojTestErrCheck(err);
+	err = MojPrintF("\n\n");
+	MojTestErrCheck(err);
+	MojString buf;
+	err = buf.format("concurrent put %llu objects %d times (%d threads),%s,%llu,%llu,%llu,\n", numInsert, numRepetitions, numPutThreads, kindId, singleTime, singleTime/numRepetitions, singleTime / (numInsert * numRepetitions));
+	MojTestErrCheck(err);
+	err = fileWrite(file, buf);
+	MojTestErrCheck(err);
+	err = buf.format("concurrent group commit put %llu objects %d times (%d threads),%s,%llu,%llu,%llu,\n", numInsert, numRepetitions, numPutThreads, kindId, groupTime, groupTime/numRepetitions, groupTime / (numInsert * numRepetitions));
+	MojTestErrCheck(err);
+	err = fileWrite(file, buf);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfCreateTest::concurrentPut(MojInt64 groupCommit, const MojChar* kindId, MojUInt64& putTime)
+{
+	// groupCommit < 0 keeps the engine default
+	MojObject conf;
+	MojErr err = conf.fromJson(_T("{\"db\":{\"sync\":1}}"));
+	MojTestErrCheck(err);
+	if (groupCommit >= 0) {
+		MojObject dbConf;
+		conf.get(MojDb::ConfKey, dbConf);
+		err = dbConf.put(_T("groupCommit"), groupCommit);
+		MojTestErrCheck(err);
+		err = conf.put(MojDb::ConfKey, dbConf);
+		MojTestErrCheck(err);
+	}
+
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojUInt64 time = 0;
+	err = putKinds(db, time);
+	MojTestErrCheck(err);
+
+	timespec startTime;
+	startTime.tv_nsec = 0;
+	startTime.tv_sec = 0;
+	timespec endTime;
+	endTime.tv_nsec = 0;
+	endTime.tv_sec = 0;
+
+	MojDbPerfPutThreadArgs args[numPutThreads];
+	MojThreadT threads[numPutThreads];
+	clock_gettime(CLOCK_REALTIME, &startTime);
+	for (int i = 0; i < numPutThreads; i++) {
+		args[i].test = this;
+		args[i].db = &db;
+		args[i].kindId = kindId;
+		args[i].first = i;
+		threads[i] = MojInvalidThread;
+		err = MojThreadCreate(threads[i], putThread, &args[i]);
+		MojTestErrCheck(err);
+	}
+	for (int i = 0; i < numPutThreads; i++) {
+		MojErr threadErr = MojErrNone;
+		err = MojThreadJoin(threads[i], threadErr);
+		MojTestErrCheck(err);
+		MojTestErrCheck(threadErr);
+	}
+	clock_gettime(CLOCK_REALTIME, &endTime);
+	putTime += timeDiff(startTime, endTime);
+	totalTestTime += timeDiff(startTime, endTime);
+
+	MojDbQuery q;
+	err = q.from(kindId);
+	MojTestErrCheck(err);
+	MojUInt32 count = 0;
+	err = db.del(q, count, MojDbFlagPurge);
+	MojTestErrCheck(err);
+	MojTestAssert(count == numInsert);
+
+	err = delKinds(db);
+	MojTestErrCheck(err);
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 void MojDbPerfCreateTest::cleanup()
 {
 	(void) MojRmDirRecursive(MojDbTestDir);
@@ -39,6 +39,8 @@ private:
 	MojErr testBatchInsertLgObj(MojDb& db, const MojChar* kindId);
 	MojErr testBatchInsertLgNestedObj(MojDb& db, const MojChar* kindId);
 	MojErr testBatchInsertLgArrayObj(MojDb& db, const MojChar* kindId);
+	MojErr testConcurrentInsert(const MojChar* kindId);
+	MojErr concurrentPut(MojInt64 groupCommit, const MojChar* kindId, MojUInt64& putTime);
 
 	MojErr putSmallObj(MojDb& db, const MojChar* kindId, MojUInt64& smallObjTime);
 	MojErr putMedObj(MojDb& db, const MojChar* kindId, MojUInt64& medObjTime);
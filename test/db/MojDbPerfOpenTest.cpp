@@ -0,0 +1,170 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "MojDbPerfOpenTest.h"
+#include "db/MojDb.h"
+#include "db/MojDbKindCatalog.h"
+
+static const MojUInt64 numKindsSteps[] = {10, 100, 1000};
+static const MojUInt64 numOpens = 10;
+
+extern MojUInt64 allTestsTime;
+static MojUInt64 totalTestTime = 0;
+static MojFile file;
+const MojChar* const OpenTestFileName = _T("MojDbPerfOpenTest.csv");
+
+MojDbPerfOpenTest::MojDbPerfOpenTest()
+: MojDbPerfTest(_T("MojDbPerfOpen"))
+{
+}
+
+MojErr MojDbPerfOpenTest::run()
+{
+	MojErr err = file.open(OpenTestFileName, MOJ_O_RDWR | MOJ_O_CREAT | MOJ_O_TRUNC, MOJ_S_IRUSR | MOJ_S_IWUSR);
+	MojTestErrCheck(err);
+
+	MojString m_buf;
+	err = m_buf.format("MojoDb Open Performance Test,,,,,\n\nOperation,Kinds,Total Time,Time Per Iteration,Time Per Kind\n");
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	err = testOpen();
+	MojTestErrCheck(err);
+	allTestsTime += totalTestTime;
+
+	err = MojPrintF("\n\n TOTAL TEST TIME: %llu nanoseconds. | %10.3f seconds.\n\n", totalTestTime, double(totalTestTime) / 1000000000.0);
+	MojTestErrCheck(err);
+	err = MojPrintF("\n-------\n");
+	MojTestErrCheck(err);
+
+	err = m_buf.format("\n\nTOTAL TEST TIME,,%llu,,,", totalTestTime);
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	err = file.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfOpenTest::testOpen()
+{
+	MojErr err = MojPrintF("\n--------------\n");
+	MojTestErrCheck(err);
+	err = MojPrintF("  OPEN");
+	MojTestErrCheck(err);
+	err = MojPrintF("\n--------------\n");
+	MojTestErrCheck(err);
+
+	MojString m_buf;
+	err = m_buf.format("\n\nOPEN,,,,,\n");
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	// kinds are added between steps, startup cost should track the number of kinds
+	MojUInt64 numKinds = 0;
+	for (MojSize i = 0; i < sizeof(numKindsSteps) / sizeof(numKindsSteps[0]); ++i) {
+		MojDb db;
+		if (lazySync()) {
+			err = db.configure(lazySyncConfig());
+			MojTestErrCheck(err);
+		}
+		err = db.open(MojDbTestDir);
+		MojTestErrCheck(err);
+		for (; numKinds < numKindsSteps[i]; ++numKinds) {
+			MojString json;
+			err = json.format(_T("{\"id\":\"OpenPerf%llu:1\",\"owner\":\"mojodb.admin\",")
+					_T("\"indexes\":[{\"name\":\"first\",\"props\":[{\"name\":\"first\"}]},")
+					_T("{\"name\":\"first_last\",\"props\":[{\"name\":\"first\"},{\"name\":\"last\"}]}]}"), numKinds);
+			MojTestErrCheck(err);
+			MojObject kind;
+			err = kind.fromJson(json);
+			MojTestErrCheck(err);
+			err = db.putKind(kind);
+			MojTestErrCheck(err);
+		}
+		err = db.close();
+		MojTestErrCheck(err);
+
+		for (int catalog = 0; catalog < 2; ++catalog) {
+			MojUInt64 openTime = 0;
+			err = timeOpens(numKinds, catalog != 0, openTime);
+			MojTestErrCheck(err);
+
+			const MojChar* from = catalog ? _T("catalog") : _T("kind db");
+			err = MojPrintF("\n -------------------- \n");
+			MojTestErrCheck(err);
+			err = MojPrintF("   time to open %llu times with %llu kinds from %s: %llu nanosecs\n", numOpens, numKinds, from, openTime);
+			MojTestErrCheck(err);
+			err = MojPrintF("   time per open: %llu nanosecs", openTime / numOpens);
+			MojTestErrCheck(err);
+			err = MojPrintF("\n\n");
+			MojTestErrCheck(err);
+			err = m_buf.format("Open from %s,%llu,%llu,%llu,%llu,\n", from, numKinds,
+					openTime, openTime/numOpens, openTime/(numOpens*numKinds));
+			MojTestErrCheck(err);
+			err = fileWrite(file, m_buf);
+			MojTestErrCheck(err);
+		}
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfOpenTest::timeOpens(MojUInt64 numKinds, bool useCatalog, MojUInt64& openTime)
+{
+	timespec startTime;
+	startTime.tv_nsec = 0;
+	startTime.tv_sec = 0;
+	timespec endTime;
+	endTime.tv_nsec = 0;
+	endTime.tv_sec = 0;
+
+	for (MojUInt64 i = 0; i < numOpens; ++i) {
+		// every close writes a catalog, without one open goes through Kind:1
+		if (!useCatalog) {
+			MojErr err = MojDbKindCatalog::remove(MojDbTestDir);
+			MojTestErrCheck(err);
+		}
+
+		MojDb db;
+		if (lazySync()) {
+			MojErr err = db.configure(lazySyncConfig());
+			MojTestErrCheck(err);
+		}
+		clock_gettime(CLOCK_REALTIME, &startTime);
+		MojErr err = db.open(MojDbTestDir);
+		MojTestErrCheck(err);
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		openTime += timeDiff(startTime, endTime);
+		totalTestTime += timeDiff(startTime, endTime);
+
+		MojTestAssert(db.kindEngine()->kindMap().size() >= numKinds);
+		err = db.close();
+		MojTestErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+void MojDbPerfOpenTest::cleanup()
+{
+	(void) MojRmDirRecursive(MojDbTestDir);
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MOJDBPERFOPENTEST_H_
+#define MOJDBPERFOPENTEST_H_
+
+#include "MojDbPerfTest.h"
+
+class MojDbPerfOpenTest : public MojDbPerfTest {
+public:
+	MojDbPerfOpenTest();
+
+	virtual MojErr run();
+	virtual void cleanup();
+
+private:
+	MojErr testOpen();
+	MojErr timeOpens(MojUInt64 numKinds, bool useCatalog, MojUInt64& openTime);
+};
+
+#endif /* MOJDBPERFOPENTEST_H_ */
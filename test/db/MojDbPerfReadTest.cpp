@@ -23,6 +23,7 @@ static const MojUInt64 numInsertForGet = 100;
 static const MojUInt64 numInsertForFind = 500;
 static const MojUInt64 numRepetitionsForGet = 100;
 static const MojUInt64 numRepetitionsForFind = 20;
+static const MojInt64 joinWindowForFind = 64;
 
 extern MojUInt64 allTestsTime;
 static MojUInt64 totalTestTime = 0;
@@ -61,6 +62,12 @@ MojErr MojDbPerfReadTest::run()
 	MojTestErrCheck(err);
 	err = testFindPaged(db);
 	MojTestErrCheck(err);
+
+	// join test reopens the database with its own engine config
+	err = db.close();
+	MojTestErrCheck(err);
+	err = testFindJoin();
+	MojTestErrCheck(err);
 	allTestsTime += totalTestTime;
 
 	err = MojPrintF("\n\n TOTAL TEST TIME: %llu nanoseconds. | %10.3f seconds.\n\n", totalTestTime, double(totalTestTime) / 1000000000.0);
@@ -73,9 +80,6 @@ MojErr MojDbPerfReadTest::run()
 	err = fileWrite(file, m_buf);
 	MojTestErrCheck(err);
 
-	err = db.close();
-	MojTestErrCheck(err);
-
 	err = file.close();
 	MojTestErrCheck(err);
 
@@ -298,6 +302,55 @@ MojErr MojDbPerfReadTest::testFindAll(MojDb& db)
 	return MojErrNone;
 }
 
+MojErr MojDbPerfReadTest::testFindJoin()
+{
+	MojErr err = MojPrintF("\n--------------\n");
+	MojTestErrCheck(err);
+	err = MojPrintF("  FIND WITH INDEX JOIN");
+	MojTestErrCheck(err);
+	err = MojPrintF("\n--------------\n");
+	MojTestErrCheck(err);
+
+	MojString m_buf;
+	err = m_buf.format("\n\nFIND WITH INDEX JOIN,,,,,\n");
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	// ordering by a secondary index makes every row a primary lookup
+	MojUInt64 pointTime = 0;
+	MojUInt32 count = 0;
+	err = findObjsJoin(0, pointTime, count);
+	MojTestErrCheck(err);
+	MojUInt64 batchTime = 0;
+	err = findObjsJoin(joinWindowForFind, batchTime, count);
+	MojTestErrCheck(err);
+	MojTestAssert(count > 0);
+
+	err = MojPrintF("\n -------------------- \n");
+	MojTestErrCheck(err);
+	err = MojPrintF("   time to find %d objects of kind %s %llu times (point lookups): %llu nanosecs\n", count, MojPerfSmKindId, numRepetitionsForFind, pointTime);
+	MojTestErrCheck(err);
+	err = MojPrintF("   time to find %d objects of kind %s %llu times (join window %lld): %llu nanosecs\n", count, MojPerfSmKindId, numRepetitionsForFind, joinWindowForFind, batchTime);
+	MojTestErrCheck(err);
+	err = MojPrintF("   time per object: %llu vs %llu nanosecs", pointTime / (count * numRepetitionsForFind), batchTime / (count * numRepetitionsForFind));
+	MojTestErrCheck(err);
+	err = MojPrintF("\n\n");
+	MojTestErrCheck(err);
+	err = m_buf.format("Find %d objects by index %llu times (point lookups),%s,%llu,%llu,%llu,\n", count, numRepetitionsForFind, MojPerfSmKindId,
+			pointTime, pointTime/numRepetitionsForFind, pointTime/(count*numRepetitionsForFind));
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+	err = m_buf.format("Find %d objects by index %llu times (join window %lld),%s,%llu,%llu,%llu,\n", count, numRepetitionsForFind, joinWindowForFind, MojPerfSmKindId,
+			batchTime, batchTime/numRepetitionsForFind, batchTime/(count*numRepetitionsForFind));
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbPerfReadTest::testGet(MojDb& db)
 {
 	MojString m_buf;
@@ -829,6 +882,59 @@ MojErr MojDbPerfReadTest::getObjs(MojDb& db, const MojChar* kindId, MojErr (MojD
 	return MojErrNone;
 }
 
+MojErr MojDbPerfReadTest::findObjsJoin(MojInt64 joinWindow, MojUInt64& findTime, MojUInt32& countOut)
+{
+	MojObject dbConf;
+	MojErr err = dbConf.put(_T("joinWindow"), joinWindow);
+	MojTestErrCheck(err);
+	if (lazySync()) {
+		err = dbConf.putInt(_T("sync"), 2);
+		MojTestErrCheck(err);
+	}
+	MojObject conf;
+	err = conf.put(_T("db"), dbConf);
+	MojTestErrCheck(err);
+
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	MojDbQuery query;
+	err = query.from(MojPerfSmKindId);
+	MojTestErrCheck(err);
+	err = query.order(_T("first"));
+	MojTestErrCheck(err);
+	query.limit((MojUInt32) numInsertForFind);
+
+	MojDbQuery::Page nextPage;
+	MojUInt64 countTime = 0;
+	err = timeFind(db, query, findTime, false, nextPage, false, countOut, countTime);
+	MojTestErrCheck(err);
+
+	// timeFind only counts on request, so take the page size from a plain find
+	MojDbCursor cursor;
+	err = db.find(query, cursor);
+	MojTestErrCheck(err);
+	countOut = 0;
+	bool found = true;
+	while (found) {
+		MojObject obj;
+		err = cursor.get(obj, found);
+		MojTestErrCheck(err);
+		if (found)
+			++countOut;
+	}
+	err = cursor.close();
+	MojTestErrCheck(err);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbPerfReadTest::timeFind(MojDb& db, MojDbQuery& query, MojUInt64& findTime, bool useWriter, MojDbQuery::Page& nextPage, bool doCount, MojUInt32& count, MojUInt64& countTime)
 {
 	timespec startTime;
@@ -32,10 +32,12 @@ private:
 	MojErr testGet(MojDb& db);
 	MojErr testFindAll(MojDb& db);
 	MojErr testFindPaged(MojDb& db);
+	MojErr testFindJoin();
 
 	MojErr getObjs(MojDb& db, const MojChar* kindId, MojErr (MojDbPerfTest::*createFn)(MojObject&, MojUInt64));
 	MojErr findObjs(MojDb& db, const MojChar* kindId, MojErr (MojDbPerfTest::*createFn)(MojObject&, MojUInt64), MojDbQuery& q);
 	MojErr findObjsPaged(MojDb& db, const MojChar* kindId, MojErr (MojDbPerfTest::*createFn)(MojObject&, MojUInt64), MojDbQuery& query);
+	MojErr findObjsJoin(MojInt64 joinWindow, MojUInt64& findTime, MojUInt32& countOut);
 
 	MojErr timeGet(MojDb& db, MojObject& id, MojUInt64& getTime);
 	MojErr timeBatchGet(MojDb& db, const MojObject* begin, const MojObject* end, MojUInt64& batchGetTime, bool useWriter);
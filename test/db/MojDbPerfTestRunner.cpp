@@ -22,6 +22,9 @@
 #include "MojDbPerfDeleteTest.h"
 #include "MojDbPerfIndexTest.h"
 #include "MojDbPerfCacheReadTest.h"
+#include "MojDbPerfCollatorTest.h"
+#include "MojDbPerfWatchTest.h"
+#include "MojDbPerfOpenTest.h"
 
 
 MojString getTestDir()
@@ -52,6 +55,9 @@ void MojDbPerfTestRunner::runTests()
 	test(MojDbPerfReadTest());
 	test(MojDbPerfUpdateTest());
 	test(MojDbPerfDeleteTest());
+	test(MojDbPerfWatchTest());
+	test(MojDbPerfOpenTest());
+	test(MojDbPerfCollatorTest());
 	MojDouble res = double(allTestsTime) / 1000000000.0;
 	(void) MojPrintF("\n\n ALL TESTS FINISHED. TIME ELAPSED: %10.3f seconds.\n\n", res);
 }
@@ -0,0 +1,198 @@
+// Copyright (c) 2009-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "MojDbPerfWatchTest.h"
+#include "db/MojDb.h"
+
+static const MojUInt64 numWatchersSteps[] = {10, 100, 1000, 10000};
+static const MojUInt64 numCommits = 200;
+
+extern MojUInt64 allTestsTime;
+static MojUInt64 totalTestTime = 0;
+static MojFile file;
+const MojChar* const WatchTestFileName = _T("MojDbPerfWatchTest.csv");
+
+static const MojChar* const MojPerfWatchKindId = _T("WatchPerf:1");
+static const MojChar* const MojPerfWatchKindStr =
+	_T("{\"id\":\"WatchPerf:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}");
+
+class PerfWatcher : public MojSignalHandler
+{
+public:
+	PerfWatcher() : m_slot(this, &PerfWatcher::handleChange), m_count(0) {}
+
+	MojErr handleChange()
+	{
+		++m_count;
+		return MojErrNone;
+	}
+
+	MojDb::WatchSignal::Slot<PerfWatcher> m_slot;
+	int m_count;
+};
+
+MojDbPerfWatchTest::MojDbPerfWatchTest()
+: MojDbPerfTest(_T("MojDbPerfWatch"))
+{
+}
+
+MojErr MojDbPerfWatchTest::run()
+{
+	MojErr err = file.open(WatchTestFileName, MOJ_O_RDWR | MOJ_O_CREAT | MOJ_O_TRUNC, MOJ_S_IRUSR | MOJ_S_IWUSR);
+	MojTestErrCheck(err);
+
+	MojString m_buf;
+	err = m_buf.format("MojoDb Watch Performance Test,,,,,\n\nOperation,Kind,Total Time,Time Per Iteration,Time Per Object\n");
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	MojDb db;
+	if (lazySync())
+	{
+		err = db.configure(lazySyncConfig());
+		MojTestErrCheck(err);
+	}
+
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	err = testWatchStorm(db);
+	MojTestErrCheck(err);
+	allTestsTime += totalTestTime;
+
+	err = MojPrintF("\n\n TOTAL TEST TIME: %llu nanoseconds. | %10.3f seconds.\n\n", totalTestTime, double(totalTestTime) / 1000000000.0);
+	MojTestErrCheck(err);
+	err = MojPrintF("\n-------\n");
+	MojTestErrCheck(err);
+
+	err = m_buf.format("\n\nTOTAL TEST TIME,,%llu,,,", totalTestTime);
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	err = file.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfWatchTest::testWatchStorm(MojDb& db)
+{
+	MojErr err = MojPrintF("\n--------------\n");
+	MojTestErrCheck(err);
+	err = MojPrintF("  WATCH STORM");
+	MojTestErrCheck(err);
+	err = MojPrintF("\n--------------\n");
+	MojTestErrCheck(err);
+
+	MojString m_buf;
+	err = m_buf.format("\n\nWATCH STORM,,,,,\n");
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	MojObject kind;
+	err = kind.fromJson(MojPerfWatchKindStr);
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+
+	// commit latency should stay flat while the number of watchers grows
+	for (MojSize i = 0; i < sizeof(numWatchersSteps) / sizeof(numWatchersSteps[0]); ++i) {
+		MojUInt64 numWatchers = numWatchersSteps[i];
+		MojUInt64 commitTime = 0;
+		err = timeCommits(db, numWatchers, commitTime);
+		MojTestErrCheck(err);
+
+		err = MojPrintF("\n -------------------- \n");
+		MojTestErrCheck(err);
+		err = MojPrintF("   time to commit %llu puts with %llu watchers on kind %s: %llu nanosecs\n", numCommits, numWatchers, MojPerfWatchKindId, commitTime);
+		MojTestErrCheck(err);
+		err = MojPrintF("   time per commit: %llu nanosecs", commitTime / numCommits);
+		MojTestErrCheck(err);
+		err = MojPrintF("\n\n");
+		MojTestErrCheck(err);
+		err = m_buf.format("Commit %llu puts with %llu watchers,%s,%llu,%llu,%llu,\n", numCommits, numWatchers, MojPerfWatchKindId,
+				commitTime, commitTime/numCommits, commitTime/numCommits);
+		MojTestErrCheck(err);
+		err = fileWrite(file, m_buf);
+		MojTestErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfWatchTest::timeCommits(MojDb& db, MojUInt64 numWatchers, MojUInt64& commitTime)
+{
+	// one eq watch per value, none of which the timed puts touch
+	MojVector<MojRefCountedPtr<PerfWatcher> > watchers;
+	for (MojUInt64 i = 0; i < numWatchers; ++i) {
+		MojDbQuery query;
+		MojErr err = query.from(MojPerfWatchKindId);
+		MojTestErrCheck(err);
+		err = query.where(_T("foo"), MojDbQuery::OpEq, (MojInt64) i);
+		MojTestErrCheck(err);
+		MojRefCountedPtr<PerfWatcher> watcher(new PerfWatcher);
+		MojTestAssert(watcher.get());
+		MojDbCursor cursor;
+		err = db.find(query, cursor, watcher->m_slot);
+		MojTestErrCheck(err);
+		err = cursor.close();
+		MojTestErrCheck(err);
+		err = watchers.push(watcher);
+		MojTestErrCheck(err);
+	}
+
+	timespec startTime;
+	startTime.tv_nsec = 0;
+	startTime.tv_sec = 0;
+	timespec endTime;
+	endTime.tv_nsec = 0;
+	endTime.tv_sec = 0;
+
+	for (MojUInt64 i = 0; i < numCommits; ++i) {
+		MojObject obj;
+		MojErr err = obj.putString(MojDb::KindKey, MojPerfWatchKindId);
+		MojTestErrCheck(err);
+		err = obj.put(_T("foo"), -1 - (MojInt64) i);
+		MojTestErrCheck(err);
+
+		clock_gettime(CLOCK_REALTIME, &startTime);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		commitTime += timeDiff(startTime, endTime);
+		totalTestTime += timeDiff(startTime, endTime);
+	}
+
+	for (MojSize i = 0; i < watchers.size(); ++i) {
+		MojTestAssert(watchers.at(i)->m_count == 0);
+	}
+
+	return MojErrNone;
+}
+
+void MojDbPerfWatchTest::cleanup()
+{
+	(void) MojRmDirRecursive(MojDbTestDir);
+}
@@ -32,6 +32,101 @@ static const MojChar* const MojTestObjStr1 =
 	_T("{\"_kind\":\"PurgeTest:1\",\"foo\":1,\"bar\":2}");
 static const MojChar* const MojTestObjStr2 =
     _T("{\"_kind\":\"DelTest:1\", \"foo\":11,\"bar\":22}");
+static const MojChar* const MojRangeKindStr =
+	_T("{\"id\":\"RangeTest:1\",")
+	_T("\"owner\":\"com.range.test\",")
+	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}],\"incDel\":true},")
+	_T("{\"name\":\"barFoo\",\"props\":[{\"name\":\"bar\"},{\"name\":\"foo\"}],\"incDel\":true}]}");
+static const MojChar* const MojRangeQuotaStr =
+	_T("{\"owner\":\"com.range.test\",\"size\":10000000}");
+static const MojChar* const MojRangeKindId = _T("RangeTest:1");
+static const MojChar* const MojRangeOwner = _T("com.range.test");
+static const int MojRangeObjCount = 20;
+
+namespace {
+	class TestWatcher : public MojSignalHandler
+	{
+	public:
+		TestWatcher() : m_slot(this, &TestWatcher::handleChange), m_count(0) {}
+
+		MojErr handleChange()
+		{
+			++m_count;
+			return MojErrNone;
+		}
+
+		MojDb::WatchSignal::Slot<TestWatcher> m_slot;
+		int m_count;
+	};
+
+	MojErr watch(MojDb& db, const MojDbQuery& query, TestWatcher& watcher)
+	{
+		MojDbCursor cursor;
+		MojErr err = db.find(query, cursor, watcher.m_slot);
+		MojErrCheck(err);
+		err = cursor.close();
+		MojErrCheck(err);
+
+		return MojErrNone;
+	}
+
+	// number of keys, live and deleted, in the index on prop
+	MojErr countIndex(MojDb& db, const MojChar* prop, MojUInt32& countOut)
+	{
+		MojDbQuery query;
+		MojErr err = query.from(MojRangeKindId);
+		MojErrCheck(err);
+		err = query.where(prop, MojDbQuery::OpGreaterThanEq, 0);
+		MojErrCheck(err);
+		err = query.includeDeleted(true);
+		MojErrCheck(err);
+		MojDbCursor cursor;
+		err = db.find(query, cursor);
+		MojErrCheck(err);
+		err = cursor.count(countOut);
+		MojErrCheck(err);
+		err = cursor.close();
+		MojErrCheck(err);
+
+		return MojErrNone;
+	}
+
+	MojErr quotaUsage(MojDb& db, MojInt64& usageOut)
+	{
+		MojInt64 size = 0;
+		MojErr err = db.quotaEngine()->quotaUsage(MojRangeOwner, size, usageOut);
+		MojErrCheck(err);
+
+		return MojErrNone;
+	}
+
+	MojErr kindUsage(MojDb& db, MojInt64& usageOut)
+	{
+		MojRefCountedPtr<MojDbStorageTxn> txn;
+		MojErr err = db.storageEngine()->beginTxn(txn);
+		MojErrCheck(err);
+		err = db.quotaEngine()->kindUsage(MojRangeKindId, usageOut, txn.get());
+		MojErrCheck(err);
+
+		return MojErrNone;
+	}
+
+	MojErr putRangeObjs(MojDb& db)
+	{
+		for (int i = 0; i < MojRangeObjCount; ++i) {
+			MojObject obj;
+			MojErr err = obj.putString(MojDb::KindKey, MojRangeKindId);
+			MojErrCheck(err);
+			err = obj.put(_T("foo"), i);
+			MojErrCheck(err);
+			err = obj.put(_T("bar"), i % 3);
+			MojErrCheck(err);
+			err = db.put(obj);
+			MojErrCheck(err);
+		}
+		return MojErrNone;
+	}
+}
 
 MojDbPurgeTest::MojDbPurgeTest()
 : MojTestCase(_T("MojDbPurge"))
@@ -199,6 +294,21 @@ MojErr MojDbPurgeTest::run()
 
     cleanup();
 
+    // range deletes of purge and delKind
+    err = setFlags(db, true, true);
+    MojTestErrCheck(err);
+
+    err = db.open(MojDbTestDir);
+    MojTestErrCheck(err);
+
+    err = rangeTest(db);
+    MojTestErrCheck(err);
+
+    err = db.close();
+    MojTestErrCheck(err);
+
+    cleanup();
+
     err = setFlags(db, true, false);
     MojTestErrCheck(err);
 
@@ -418,6 +528,142 @@ MojErr MojDbPurgeTest::delTest(MojDb& db)
     return MojErrNone;
 }
 
+MojErr MojDbPurgeTest::rangeTest(MojDb& db)
+{
+	MojObject obj;
+	MojErr err = obj.fromJson(MojRangeQuotaStr);
+	MojTestErrCheck(err);
+	err = db.putQuotas(&obj, &obj + 1);
+	MojTestErrCheck(err);
+	err = obj.fromJson(MojRangeKindStr);
+	MojTestErrCheck(err);
+	err = db.putKind(obj);
+	MojTestErrCheck(err);
+
+	MojInt64 kindUsage0 = 0;
+	err = kindUsage(db, kindUsage0);
+	MojTestErrCheck(err);
+	MojInt64 quotaUsage0 = 0;
+	err = quotaUsage(db, quotaUsage0);
+	MojTestErrCheck(err);
+
+	// purge: the root [_del, _sync, _rev, _id] keys go in one range delete,
+	// the kind's own indexes lose their keys one by one
+	err = putRangeObjs(db);
+	MojTestErrCheck(err);
+	MojDbQuery query;
+	err = query.from(MojRangeKindId);
+	MojTestErrCheck(err);
+	MojUInt32 count = 0;
+	err = db.del(query, count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == MojRangeObjCount);
+
+	MojRefCountedPtr<TestWatcher> fooWatcher(new TestWatcher);
+	MojTestAssert(fooWatcher.get());
+	query.clear();
+	err = query.from(MojRangeKindId);
+	MojTestErrCheck(err);
+	err = query.where(_T("foo"), MojDbQuery::OpGreaterThanEq, 0);
+	MojTestErrCheck(err);
+	err = query.includeDeleted(true);
+	MojTestErrCheck(err);
+	err = watch(db, query, *fooWatcher);
+	MojTestErrCheck(err);
+	MojRefCountedPtr<TestWatcher> revWatcher(new TestWatcher);
+	MojTestAssert(revWatcher.get());
+	query.clear();
+	err = query.from(MojDbKindEngine::RootKindId);
+	MojTestErrCheck(err);
+	err = query.where(MojDb::DelKey, MojDbQuery::OpEq, true);
+	MojTestErrCheck(err);
+	err = query.where(MojDb::SyncKey, MojDbQuery::OpEq, false);
+	MojTestErrCheck(err);
+	err = watch(db, query, *revWatcher);
+	MojTestErrCheck(err);
+
+	err = db.purge(count, 0);
+	MojTestErrCheck(err);
+	MojTestAssert(count == MojRangeObjCount);
+	MojTestAssert(fooWatcher->m_count == 1);
+	MojTestAssert(revWatcher->m_count == 1);
+
+	MojUInt32 keys = 0;
+	err = countIndex(db, _T("foo"), keys);
+	MojTestErrCheck(err);
+	MojTestAssert(keys == 0);
+	err = countIndex(db, _T("bar"), keys);
+	MojTestErrCheck(err);
+	MojTestAssert(keys == 0);
+	MojInt64 usage = 0;
+	err = kindUsage(db, usage);
+	MojTestErrCheck(err);
+	MojTestAssert(usage == kindUsage0);
+	err = quotaUsage(db, usage);
+	MojTestErrCheck(err);
+	MojTestAssert(usage == quotaUsage0);
+
+	// delKind: the _id keys go in range deletes, the other indexes are dropped whole
+	err = putRangeObjs(db);
+	MojTestErrCheck(err);
+	MojRefCountedPtr<TestWatcher> idWatcher(new TestWatcher);
+	MojTestAssert(idWatcher.get());
+	query.clear();
+	err = query.from(MojRangeKindId);
+	MojTestErrCheck(err);
+	err = watch(db, query, *idWatcher);
+	MojTestErrCheck(err);
+	MojRefCountedPtr<TestWatcher> barWatcher(new TestWatcher);
+	MojTestAssert(barWatcher.get());
+	query.clear();
+	err = query.from(MojRangeKindId);
+	MojTestErrCheck(err);
+	err = query.where(_T("bar"), MojDbQuery::OpEq, 1);
+	MojTestErrCheck(err);
+	err = watch(db, query, *barWatcher);
+	MojTestErrCheck(err);
+
+	MojString kindId;
+	err = kindId.assign(MojRangeKindId);
+	MojTestErrCheck(err);
+	bool found = false;
+	err = db.delKind(kindId, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	MojTestAssert(idWatcher->m_count == 1);
+	MojTestAssert(barWatcher->m_count == 1);
+	err = quotaUsage(db, usage);
+	MojTestErrCheck(err);
+	MojTestAssert(usage == quotaUsage0);
+
+	// a kind put again under the same id starts out with empty indexes
+	err = obj.fromJson(MojRangeKindStr);
+	MojTestErrCheck(err);
+	err = db.putKind(obj);
+	MojTestErrCheck(err);
+	err = countIndex(db, _T("foo"), keys);
+	MojTestErrCheck(err);
+	MojTestAssert(keys == 0);
+	err = countIndex(db, _T("bar"), keys);
+	MojTestErrCheck(err);
+	MojTestAssert(keys == 0);
+	query.clear();
+	err = query.from(MojRangeKindId);
+	MojTestErrCheck(err);
+	err = query.includeDeleted(true);
+	MojTestErrCheck(err);
+	MojDbCursor cursor;
+	err = db.find(query, cursor);
+	MojTestErrCheck(err);
+	err = cursor.count(keys);
+	MojTestErrCheck(err);
+	err = cursor.close();
+	MojTestErrCheck(err);
+	MojTestAssert(keys == 0);
+
+	return MojErrNone;
+}
+
 MojErr MojDbPurgeTest::checkObjectsPurged(MojDb& db, const MojUInt32& count, const MojSize& expectedCount,
 		const MojSize& expectedNumObjects, const MojSize& expectedNumRevTimestampObjects, const MojObject& expectedLastPurgeRevNum)
 {
@@ -35,6 +35,7 @@ private:
 	MojErr createRevTimestamp(MojDb& db, MojObject& revNum, MojInt64 timestamp);
     MojErr setFlags(MojDb& db, bool enableRootKind, bool enablePurge);
     MojErr delTest(MojDb& db);
+	MojErr rangeTest(MojDb& db);
 };
 
 #endif /* MOJDBPURGETEST_H_ */
@@ -100,12 +100,16 @@ MojErr MojDbQuotaTest::run()
 	MojTestErrCheck(err);
 	err = testEnforce(db);
 	MojTestErrCheck(err);
+	err = testCheckpoint(db);
+	MojTestErrCheck(err);
 
 	err = db.close();
 	MojErrCheck(err);
 
 	err = testErrors();
 	MojTestErrCheck(err);
+	err = testRecovery();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -350,6 +354,46 @@ MojErr MojDbQuotaTest::testEnforce(MojDb& db)
 	return MojErrNone;
 }
 
+MojErr MojDbQuotaTest::testCheckpoint(MojDb& db)
+{
+	MojInt64 kindUsage1 = 0;
+	MojErr err = getKindUsage(db, _T("Test:1"), kindUsage1);
+	MojTestErrCheck(err);
+	MojTestAssert(kindUsage1 > 0);
+	MojInt64 quotaUsage1 = 0;
+	err = getQuotaUsage(db, _T("com.foo.bar"), quotaUsage1);
+	MojTestErrCheck(err);
+
+	// usage lives in memory until a flush, which leaves nothing for the next one
+	err = db.quotaEngine()->flush();
+	MojTestErrCheck(err);
+	err = db.quotaEngine()->flush();
+	MojTestErrCheck(err);
+	MojInt64 kindUsage2 = 0;
+	err = getKindUsage(db, _T("Test:1"), kindUsage2);
+	MojTestErrCheck(err);
+	MojTestAssert(kindUsage2 == kindUsage1);
+
+	// records written by the flushes restore the same usage on open
+	err = db.close();
+	MojTestErrCheck(err);
+	MojDb db2;
+	err = db2.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojInt64 kindUsage3 = 0;
+	err = getKindUsage(db2, _T("Test:1"), kindUsage3);
+	MojTestErrCheck(err);
+	MojTestAssert(kindUsage3 == kindUsage1);
+	MojInt64 quotaUsage3 = 0;
+	err = getQuotaUsage(db2, _T("com.foo.bar"), quotaUsage3);
+	MojTestErrCheck(err);
+	MojTestAssert(quotaUsage3 == quotaUsage1);
+	err = db2.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbQuotaTest::testErrors()
 {
 	MojErr err;
@@ -408,6 +452,80 @@ MojErr MojDbQuotaTest::testErrors()
 	return MojErrNone;
 }
 
+MojErr MojDbQuotaTest::testRecovery()
+{
+	MojErr err;
+	MojRefCountedPtr<MojDbStorageEngine> engine;
+	err = MojDbStorageEngine::createDefaultEngine(engine);
+	MojTestErrCheck(err);
+	MojAllocCheck(engine.get());
+	MojRefCountedPtr<MojDbTestStorageEngine> testEngine(new MojDbTestStorageEngine(engine.get()));
+	MojAllocCheck(testEngine.get());
+	err = testEngine->open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	// no flush runs on its own while the test writes
+	MojObject conf;
+	err = conf.fromJson(_T("{\"db\":{\"quotaFlushInterval\":3600000}}"));
+	MojTestErrCheck(err);
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir, testEngine.get());
+	MojTestErrCheck(err);
+	MojInt64 kindUsage1 = 0;
+	err = getKindUsage(db, _T("Test3:1"), kindUsage1);
+	MojTestErrCheck(err);
+	MojInt64 quotaUsage1 = 0;
+	err = getQuotaUsage(db, _T("com.foo.*"), quotaUsage1);
+	MojTestErrCheck(err);
+	err = put(db, _T("{\"_id\":13,\"_kind\":\"Test3:1\",\"foo\":\"crash\"}"));
+	MojTestErrCheck(err);
+	MojInt64 kindUsage2 = 0;
+	err = getKindUsage(db, _T("Test3:1"), kindUsage2);
+	MojTestErrCheck(err);
+	MojTestAssert(kindUsage2 > kindUsage1);
+	MojInt64 quotaUsage2 = 0;
+	err = getQuotaUsage(db, _T("com.foo.*"), quotaUsage2);
+	MojTestErrCheck(err);
+	MojTestAssert(quotaUsage2 > quotaUsage1);
+
+	// the flush on close fails like a crash before it: the record keeps the
+	// usage of the last checkpoint and the marker of the put stays
+	err = testEngine->setNextError(_T("txn.commit"), MojErrDbDeadlock);
+	MojTestErrCheck(err);
+	err = db.close();
+	MojTestErrExpected(err, MojErrDbDeadlock);
+
+	// open rescans the marked kind
+	MojDb db2;
+	err = db2.open(MojDbTestDir, testEngine.get());
+	MojTestErrCheck(err);
+	MojInt64 kindUsage3 = 0;
+	err = getKindUsage(db2, _T("Test3:1"), kindUsage3);
+	MojTestErrCheck(err);
+	MojTestAssert(kindUsage3 == kindUsage2);
+	MojInt64 quotaUsage3 = 0;
+	err = getQuotaUsage(db2, _T("com.foo.*"), quotaUsage3);
+	MojTestErrCheck(err);
+	MojTestAssert(quotaUsage3 == quotaUsage2);
+	err = db2.close();
+	MojTestErrCheck(err);
+
+	// the rescan left an exact record and no marker behind
+	MojDb db3;
+	err = db3.open(MojDbTestDir, testEngine.get());
+	MojTestErrCheck(err);
+	MojInt64 kindUsage4 = 0;
+	err = getKindUsage(db3, _T("Test3:1"), kindUsage4);
+	MojTestErrCheck(err);
+	MojTestAssert(kindUsage4 == kindUsage2);
+	err = db3.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbQuotaTest::put(MojDb& db, const MojChar* objJson)
 {
 	MojObject obj;
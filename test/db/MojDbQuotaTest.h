@@ -32,7 +32,9 @@ private:
 	MojErr testUsage(MojDb& db);
 	MojErr testMultipleQuotas(MojDb& db);
 	MojErr testEnforce(MojDb& db);
+	MojErr testCheckpoint(MojDb& db);
 	MojErr testErrors();
+	MojErr testRecovery();
 	MojErr put(MojDb& db, const MojChar* objJson);
 	MojErr getKindUsage(MojDb& db, const MojChar* kindId, MojInt64& usageOut);
 	MojErr getQuotaUsage(MojDb& db, const MojChar* owner, MojInt64& usageOut);
@@ -82,6 +82,9 @@ MojErr MojDbSearchCacheTest::run()
     err = operatorTest(db);
     MojTestErrCheck(err);
 
+    err = lruTest();
+    MojTestErrCheck(err);
+
     err = delKindTest(db);
     MojTestErrCheck(err);
 
@@ -207,14 +210,16 @@ MojErr MojDbSearchCacheTest::testCache()
     MojTestErrCheck(err);
 
     // Update the cache with ID Set2.
-    // Then, it should replace IdSet1, since it's on same kind.
+    // Then, it should replace IdSet1, since it's the same query.
     //
     err=cache.updateCache(key2, idSet2);
     MojTestErrCheck(err);
+    MojTestAssert(cache.size() == 1);
 
     MojDbSearchCache::IdSet resultIds2;
     MojTestAssert(true == cache.contain(key2));
-    err=cache.getIdSet(key1, resultIds2);
+    MojTestAssert(false == cache.contain(key1));
+    err=cache.getIdSet(key2, resultIds2);
     MojTestErrCheck(err);
 
     MojTestAssert(idSet1 != resultIds2);
@@ -263,30 +268,14 @@ MojErr MojDbSearchCacheTest::operatorTest(MojDb& db)
     err = cache->createCache(key2, ids2);
     MojTestErrCheck(err);
 
-    /*** :: For debug ::
-    for(MojDbSearchCache::Container::const_iterator i = cache->container().begin(); i != cache->container().end(); ++i) {
-        MojString str1, str2;
-        MojObject obj;
-        MojUInt32 rev = i->first.getRev();
-        str1 = i->first.getQuery();
-        for(MojDbSearchCache::IdSet::ConstIterator it = i->second.begin(); it != i->second.end(); ++it) {
-            err = it->toJson(str2);
-            MojTestErrCheck(err);
-        }
-
-        printf("key(rev, query) : (%d, %s), ids : %s\n", rev, str1.data(), str2.data());
-    }
-    ***/
-
-    MojTestAssert(cache->container().count(key1) == 1);
-    MojTestAssert(cache->container().size() == 1);
+    // same query and revision -> second create replaces the first
+    MojTestAssert(cache->size() == 1);
     MojTestAssert(cache->contain(key1) == true);
 
     // nothing to update -> no-op
     err = cache->updateCache(key1, ids1);
     MojTestErrCheck(err);
-    MojTestAssert(cache->container().count(key1) == 1);
-    MojTestAssert(cache->container().size() == 1);
+    MojTestAssert(cache->size() == 1);
     MojTestAssert(cache->contain(key1) == true);
 
     err = query1.from(_T("test.cache:1"));
@@ -296,10 +285,11 @@ MojErr MojDbSearchCacheTest::operatorTest(MojDb& db)
     key3.setRev(rev);
     key3.setQuery(query1);
 
-    // key is changed, but kind is same --> update cache
+    // key is changed, but kind is same --> both queries are cached
     err = cache->updateCache(key3, ids1);
-    MojTestAssert(cache->container().count(key3) == 1);
-    MojTestAssert(cache->container().size() == 1);
+    MojTestErrCheck(err);
+    MojTestAssert(cache->size() == 2);
+    MojTestAssert(cache->contain(key1) == true);
     MojTestAssert(cache->contain(key3) == true);
 
     err = query2.from(_T("test.update:1"));
@@ -313,21 +303,122 @@ MojErr MojDbSearchCacheTest::operatorTest(MojDb& db)
     // key is changed -> update cache(add new cache because it is owned by different kind)
     err = cache->updateCache(key4, ids1);
     MojTestErrCheck(err);
-    MojTestAssert(cache->container().count(key4) == 1);
-    MojTestAssert(cache->container().size() == 2);
+    MojTestAssert(cache->size() == 3);
     MojTestAssert(cache->contain(key4) == true);
 
     //delete the cache added
     err = cache->destroyCache(key4);
     MojTestErrCheck(err);
-    MojTestAssert(cache->container().count(key4) == 0);
-    MojTestAssert(cache->container().size() == 1);
+    MojTestAssert(cache->size() == 2);
     MojTestAssert(cache->contain(key4) == false);
 
+    // drop everything cached for a kind
+    err = cache->destroyCache(key1.getKind());
+    MojTestErrCheck(err);
+    MojTestAssert(cache->size() == 0);
+    MojTestAssert(cache->bytes() == 0);
+
     return MojErrNone;
 }
 
 
+// entries are evicted least recently used first once the byte budget is exceeded
+MojErr MojDbSearchCacheTest::lruTest()
+{
+    MojRefCountedPtr<MojDbSearchCache> cache(new MojDbSearchCache());
+    MojAllocCheck(cache.get());
+
+    MojDbSearchCache::IdSet ids;
+    const char* names[] = { "id1", "id2", "id3", "id4", "id5", "id6", "id7", "id8" };
+    MojErr err = prepareIdSet(ids, names, sizeof(names) / sizeof(names[0]));
+    MojTestErrCheck(err);
+
+    // three queries on one kind, keys of equal size
+    MojDbSearchCache::QueryKey keys[3];
+    for (int i = 0; i < 3; ++i) {
+        MojDbQuery query;
+        err = query.from(_T("test.cache:1"));
+        MojTestErrCheck(err);
+        err = query.where(_T("attr1"), MojDbQuery::OpGreaterThan, i + 1);
+        MojTestErrCheck(err);
+        err = keys[i].fromQuery(query, 7);
+        MojTestErrCheck(err);
+    }
+
+    err = cache->createCache(keys[0], ids);
+    MojTestErrCheck(err);
+    MojSize entryBytes = cache->bytes();
+    MojTestAssert(entryBytes > 0);
+
+    // room for two entries
+    MojObject conf;
+    err = conf.put(MojDbSearchCache::SizeKey, (MojInt64) (entryBytes * 2 + entryBytes / 2));
+    MojTestErrCheck(err);
+    err = cache->configure(conf);
+    MojTestErrCheck(err);
+    MojTestAssert(cache->budget() == entryBytes * 2 + entryBytes / 2);
+
+    err = cache->createCache(keys[1], ids);
+    MojTestErrCheck(err);
+    MojTestAssert(cache->size() == 2);
+    MojTestAssert(cache->bytes() == entryBytes * 2);
+
+    // touch keys[0] so keys[1] becomes the oldest
+    bool found = false;
+    MojDbSearchCache::IdSet result;
+    err = cache->find(keys[0], result, found);
+    MojTestErrCheck(err);
+    MojTestAssert(found);
+    MojTestAssert(result == ids);
+
+    err = cache->createCache(keys[2], ids);
+    MojTestErrCheck(err);
+    MojTestAssert(cache->size() == 2);
+    MojTestAssert(cache->contain(keys[0]));
+    MojTestAssert(!cache->contain(keys[1]));
+    MojTestAssert(cache->contain(keys[2]));
+
+    err = cache->find(keys[1], result, found);
+    MojTestErrCheck(err);
+    MojTestAssert(!found);
+
+    // kind was updated after keys[2] got cached -> entry dropped on lookup
+    MojDbSearchCache::QueryKey newer = keys[2];
+    newer.setRev(8);
+    err = cache->find(newer, result, found);
+    MojTestErrCheck(err);
+    MojTestAssert(!found);
+    MojTestAssert(cache->size() == 1);
+    MojTestAssert(cache->bytes() == entryBytes);
+
+    MojObject stats;
+    err = cache->stats(stats);
+    MojTestErrCheck(err);
+    MojInt64 val = 0;
+    MojTestAssert(stats.get(MojDbSearchCache::HitsKey, val) && val == 1);
+    MojTestAssert(stats.get(MojDbSearchCache::MissesKey, val) && val == 2);
+    MojTestAssert(stats.get(MojDbSearchCache::EvictionsKey, val) && val == 1);
+    MojTestAssert(stats.get(MojDbSearchCache::InvalidationsKey, val) && val == 1);
+    MojTestAssert(stats.get(MojDbSearchCache::EntriesKey, val) && val == 1);
+
+    // zero budget turns caching off
+    err = conf.put(MojDbSearchCache::SizeKey, (MojInt64) 0);
+    MojTestErrCheck(err);
+    err = cache->configure(conf);
+    MojTestErrCheck(err);
+    MojTestAssert(cache->size() == 0);
+    err = cache->createCache(keys[0], ids);
+    MojTestErrCheck(err);
+    MojTestAssert(!cache->contain(keys[0]));
+
+    err = conf.put(MojDbSearchCache::SizeKey, (MojInt64) -1);
+    MojTestErrCheck(err);
+    err = cache->configure(conf);
+    MojTestErrExpected(err, MojErrInvalidArg);
+
+    return MojErrNone;
+}
+
 //Test for BHV-15663 "No result returns, when delkind, pukind, put, search apis are performed repeatedly"
 MojErr MojDbSearchCacheTest::delKindTest(MojDb& db)
 {
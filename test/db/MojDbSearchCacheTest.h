@@ -34,6 +34,7 @@ public:
 private:
     MojErr operatorTest(MojDb& db);
     MojErr delKindTest(MojDb& db);
+    MojErr lruTest();
 
     MojErr testQueryKey();
     MojErr testCache();
@@ -67,6 +67,13 @@ static const MojChar* const MojSearchTestObjects2[] = {
     _T("{\"_id\":\"++IWp1fmm1ggMvpb\",\"_kind\":\"SearchTest:2\",\"foo\":\"carap\"}")
 };
 
+static const MojChar* const MojSearchKindStr3 =
+	_T("{\"id\":\"SearchTest:3\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"indexes\":[{\"name\":\"bar\",\"props\":[{\"name\":\"bar\"}]}]}");
+static const MojInt64 MojSearchTestRankObjects = 100;
+static const MojInt64 MojSearchTestRankValues = 10;
+
 namespace {
     MojDbShardId MojSearchTestObjects2ShardId = 319956;
 } // anonymous namespace
@@ -127,6 +134,8 @@ MojErr MojDbSearchTest::run()
     }
     err = pageTest(db);
     MojTestErrCheck(err);
+	err = rankTest(db);
+	MojTestErrCheck(err);
 
 	err = db.close();
 	MojTestErrCheck(err);
@@ -261,6 +270,105 @@ MojErr MojDbSearchTest::pageTest(MojDb& db)
     return MojErrNone;
 }
 
+MojErr MojDbSearchTest::rankTest(MojDb& db)
+{
+	MojObject kindObj;
+	MojErr err = kindObj.fromJson(MojSearchKindStr3);
+	MojTestErrCheck(err);
+	err = db.putKind(kindObj);
+	MojTestErrCheck(err);
+	for (MojInt64 i = 1; i <= MojSearchTestRankObjects; ++i) {
+		MojObject obj;
+		err = obj.putString(MojDb::KindKey, _T("SearchTest:3"));
+		MojTestErrCheck(err);
+		err = obj.put(MojDb::IdKey, i);
+		MojTestErrCheck(err);
+		err = obj.put(_T("bar"), (i * 7) % MojSearchTestRankValues);
+		MojTestErrCheck(err);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+	}
+
+	// pages of a small limit add up to the full order, ties broken by id
+	for (int desc = 0; desc < 2; ++desc) {
+		MojDbQuery query;
+		err = query.from(_T("SearchTest:3"));
+		MojTestErrCheck(err);
+		err = query.order(_T("bar"));
+		MojTestErrCheck(err);
+		query.desc(desc != 0);
+		query.limit(7);
+		MojObject ids;
+		err = collectPages(db, query, ids);
+		MojTestErrCheck(err);
+		MojTestAssert(ids.size() == (MojSize) MojSearchTestRankObjects);
+
+		MojInt64 prevBar = desc ? MojSearchTestRankValues : -1;
+		MojInt64 prevId = desc ? MojSearchTestRankObjects + 1 : 0;
+		for (MojObject::ConstArrayIterator i = ids.arrayBegin(); i != ids.arrayEnd(); ++i) {
+			MojInt64 id = i->intValue();
+			MojInt64 bar = (id * 7) % MojSearchTestRankValues;
+			if (bar == prevBar)
+				MojTestAssert(desc ? id < prevId : id > prevId);
+			else
+				MojTestAssert(desc ? bar < prevBar : bar > prevBar);
+			prevBar = bar;
+			prevId = id;
+		}
+	}
+
+	// distinct returns one object per value, in value order
+	MojDbQuery query;
+	err = query.from(_T("SearchTest:3"));
+	MojTestErrCheck(err);
+	err = query.distinct(_T("bar"));
+	MojTestErrCheck(err);
+	query.limit(3);
+	MojObject ids;
+	err = collectPages(db, query, ids);
+	MojTestErrCheck(err);
+	MojTestAssert(ids.size() == (MojSize) MojSearchTestRankValues);
+	MojInt64 expectedBar = 0;
+	for (MojObject::ConstArrayIterator i = ids.arrayBegin(); i != ids.arrayEnd(); ++i) {
+		MojTestAssert((i->intValue() * 7) % MojSearchTestRankValues == expectedBar);
+		++expectedBar;
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojDbSearchTest::collectPages(MojDb& db, MojDbQuery& query, MojObject& idsOut)
+{
+	idsOut = MojObject(MojObject::TypeArray);
+	for (;;) {
+		MojString str;
+		MojDbSearchCursor cursor(str);
+		MojErr err = db.find(query, cursor);
+		MojTestErrCheck(err);
+		MojSize pageSize = 0;
+		for (;;) {
+			MojDbStorageItem* item = NULL;
+			bool found = false;
+			err = cursor.get(item, found);
+			MojTestErrCheck(err);
+			if (!found)
+				break;
+			err = idsOut.push(item->id());
+			MojTestErrCheck(err);
+			++pageSize;
+		}
+		MojTestAssert(pageSize <= query.limit());
+		MojDbQuery::Page page;
+		err = cursor.nextPage(page);
+		MojTestErrCheck(err);
+		err = cursor.close();
+		MojTestErrCheck(err);
+		if (page.empty())
+			break;
+		query.page(page);
+	}
+	return MojErrNone;
+}
 
 MojErr MojDbSearchTest::initQuery(MojDbQuery& query, const MojChar* queryStr, const MojChar* orderBy, const MojObject& barVal, bool desc)
 {
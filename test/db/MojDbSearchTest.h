@@ -32,6 +32,8 @@ private:
 	MojErr simpleTest(MojDb& db);
 	MojErr filterTest(MojDb& db);
     MojErr pageTest(MojDb& db);
+	MojErr rankTest(MojDb& db);
+	MojErr collectPages(MojDb& db, MojDbQuery& query, MojObject& idsOut);
 
 	MojErr initQuery(MojDbQuery& query, const MojChar* queryStr,
 			const MojChar* orderBy = NULL, const MojObject& barVal = MojObject::Undefined, bool desc = false);
@@ -21,6 +21,7 @@
 #include "MojDbTestRunner.h"
 #include "MojDbWhereTest.h"
 #include "MojDbBulkTest.h"
+#include "MojDbCompactSchedulerTest.h"
 #include "MojDbConcurrencyTest.h"
 #include "MojDbCrudTest.h"
 #include "MojDbDumpLoadTest.h"
@@ -74,6 +75,7 @@ void MojDbTestRunner::runTests()
 	test(MojDbProfileTest());
 	test(MojDbShardManagerTest());
 	test(MojDbBulkTest());
+	test(MojDbCompactSchedulerTest());
 	test(MojDbConcurrencyTest());
 	test(MojDbCrudTest());
 	test(MojDbDumpLoadTest());
@@ -28,6 +28,12 @@ MojErr MojDbTextTokenizerTest::run()
 {
 	MojErr err = englishTest();
 	MojErrCheck(err);
+	err = sortedTest();
+	MojErrCheck(err);
+	err = diffTest();
+	MojErrCheck(err);
+	err = threadTest();
+	MojErrCheck(err);
 
 	return MojErrNone;
 }
@@ -57,13 +63,138 @@ MojErr MojDbTextTokenizerTest::englishTest()
 	return MojErrNone;
 }
 
+MojErr MojDbTextTokenizerTest::sortedTest()
+{
+	MojString text;
+	MojErr err = text.assign(_T("to be or not to be, that is the question"));
+	MojTestErrCheck(err);
+	MojRefCountedPtr<MojDbTextTokenizer> tokenizer(new MojDbTextTokenizer);
+	MojAllocCheck(tokenizer.get());
+	err = tokenizer->init(_T("en_US"));
+	MojTestErrCheck(err);
+
+	// repeated words show up once, in key order
+	MojDbTextTokenizer::KeyVec vec;
+	err = tokenizer->tokenize(text, NULL, vec);
+	MojTestErrCheck(err);
+	err = checkVec(vec, _T("[\"be\",\"is\",\"not\",\"or\",\"question\",\"that\",\"the\",\"to\"]"));
+	MojTestErrCheck(err);
+
+	// the vector is reset, not appended to
+	err = text.assign(_T("hello"));
+	MojTestErrCheck(err);
+	err = tokenizer->tokenize(text, NULL, vec);
+	MojTestErrCheck(err);
+	err = checkVec(vec, _T("[\"hello\"]"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbTextTokenizerTest::diffTest()
+{
+	MojErr err = checkDiff(_T("hello world"), _T("hello world"), _T("[]"), _T("[]"));
+	MojTestErrCheck(err);
+	err = checkDiff(_T("hello world"), _T("Hello, world!"), _T("[\"Hello\"]"), _T("[\"hello\"]"));
+	MojTestErrCheck(err);
+	err = checkDiff(_T("the quick brown fox"), _T("the slow brown fox fox"), _T("[\"slow\"]"), _T("[\"quick\"]"));
+	MojTestErrCheck(err);
+	err = checkDiff(_T(""), _T("a b"), _T("[\"a\",\"b\"]"), _T("[]"));
+	MojTestErrCheck(err);
+	err = checkDiff(_T("a b"), _T(""), _T("[]"), _T("[\"a\",\"b\"]"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbTextTokenizerTest::threadProc(void* arg)
+{
+	MojDbTextTokenizer* tokenizer = static_cast<MojDbTextTokenizer*>(arg);
+	MojString text;
+	MojErr err = text.assign(_T("the quick brown fox jumped over the lazy yellow dog."));
+	MojErrCheck(err);
+	for (int i = 0; i < 200; ++i) {
+		MojDbTextTokenizer::KeyVec vec;
+		err = tokenizer->tokenize(text, NULL, vec);
+		MojErrCheck(err);
+		if (vec.size() != 9)
+			MojErrThrow(MojErrInternal);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbTextTokenizerTest::threadTest()
+{
+	// one tokenizer shared by several threads, each uses its own break iterator
+	MojRefCountedPtr<MojDbTextTokenizer> tokenizer(new MojDbTextTokenizer);
+	MojAllocCheck(tokenizer.get());
+	MojErr err = tokenizer->init(_T("en_US"));
+	MojTestErrCheck(err);
+
+	const int numThreads = 4;
+	MojThreadT threads[numThreads];
+	for (int i = 0; i < numThreads; ++i) {
+		err = MojThreadCreate(threads[i], threadProc, tokenizer.get());
+		MojTestErrCheck(err);
+	}
+	for (int i = 0; i < numThreads; ++i) {
+		MojErr threadErr = MojErrNone;
+		err = MojThreadJoin(threads[i], threadErr);
+		MojTestErrCheck(err);
+		MojTestErrCheck(threadErr);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbTextTokenizerTest::checkDiff(const MojChar* oldText, const MojChar* newText,
+		const MojChar* added, const MojChar* removed)
+{
+	MojString oldStr;
+	MojErr err = oldStr.assign(oldText);
+	MojTestErrCheck(err);
+	MojString newStr;
+	err = newStr.assign(newText);
+	MojTestErrCheck(err);
+	MojRefCountedPtr<MojDbTextTokenizer> tokenizer(new MojDbTextTokenizer);
+	MojAllocCheck(tokenizer.get());
+	err = tokenizer->init(_T("en_US"));
+	MojTestErrCheck(err);
+
+	MojDbTextTokenizer::KeyVec addedVec;
+	MojDbTextTokenizer::KeyVec removedVec;
+	err = tokenizer->diff(oldStr, newStr, NULL, addedVec, removedVec);
+	MojTestErrCheck(err);
+	err = checkVec(addedVec, added);
+	MojTestErrCheck(err);
+	err = checkVec(removedVec, removed);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbTextTokenizerTest::checkVec(const MojDbTextTokenizer::KeyVec& vec, const MojChar* tokens)
+{
+	MojObject obj;
+	MojErr err = obj.fromJson(tokens);
+	MojTestErrCheck(err);
+	MojTestAssert(obj.size() == vec.size());
+	MojDbTextTokenizer::KeyVec::ConstIterator iter = vec.begin();
+	for (MojObject::ConstArrayIterator i = obj.arrayBegin(); i != obj.arrayEnd() && iter != vec.end(); ++i, ++iter) {
+		MojDbKey key;
+		err = key.assign(*i);
+		MojTestErrCheck(err);
+		MojTestAssert(key == *iter);
+	}
+	return MojErrNone;
+}
+
 MojErr MojDbTextTokenizerTest::check(const MojChar* text, const MojChar* tokens)
 {
 	// tokenize string
 	MojString textStr;
 	MojErr err = textStr.assign(text);
 	MojTestErrCheck(err);
-	MojSet<MojDbKey> set;
+	MojDbTextTokenizer::KeySet set;
 	MojRefCountedPtr<MojDbTextTokenizer> tokenizer(new MojDbTextTokenizer);
 	MojAllocCheck(tokenizer.get());
 	err = tokenizer->init(_T("en_US"));
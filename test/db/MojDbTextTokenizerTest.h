@@ -19,6 +19,7 @@
 #define MOJDBTEXTTOKENIZERTEST_H_
 
 #include "MojDbTestRunner.h"
+#include "db/MojDbTextTokenizer.h"
 
 class MojDbTextTokenizerTest : public MojTestCase
 {
@@ -29,7 +30,14 @@ public:
 
 private:
 	MojErr englishTest();
+	MojErr sortedTest();
+	MojErr diffTest();
+	MojErr threadTest();
 	MojErr check(const MojChar* text, const MojChar* tokens);
+	MojErr checkDiff(const MojChar* oldText, const MojChar* newText, const MojChar* added, const MojChar* removed);
+	MojErr checkVec(const MojDbTextTokenizer::KeyVec& vec, const MojChar* tokens);
+
+	static MojErr threadProc(void* arg);
 };
 
 #endif /* MOJDBTEXTTOKENIZERTEST_H_ */
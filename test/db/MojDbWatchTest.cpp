@@ -78,6 +78,14 @@ MojErr MojDbWatchTest::run()
 	// pages
 	err = pageTest(db);
 	MojTestErrCheck(err);
+	// many overlapping watches
+	err = manyTest(db);
+	MojTestErrCheck(err);
+#ifndef LMDB_ENGINE_SUPPORT
+	// overlapping txns, lmdb only has one writer at a time
+	err = txnTest(db);
+	MojTestErrCheck(err);
+#endif
 
 	// make sure we're not hanging onto watcher references
 	MojTestAssert(TestWatcher::s_instanceCount == 0);
@@ -372,6 +380,116 @@ MojErr MojDbWatchTest::rangeTest(MojDb& db)
 	return MojErrNone;
 }
 
+MojErr MojDbWatchTest::manyTest(MojDb& db)
+{
+	// eq watches on 1000..1099 and range watches on [1050, 1051 + i)
+	const int numWatchers = 100;
+	MojVector<MojRefCountedPtr<TestWatcher> > eqWatchers;
+	MojVector<MojRefCountedPtr<TestWatcher> > rangeWatchers;
+	for (int i = 0; i < numWatchers; ++i) {
+		MojDbQuery query;
+		MojErr err = query.from(_T("WatchTest:1"));
+		MojTestErrCheck(err);
+		err = query.where(_T("foo"), MojDbQuery::OpEq, 1000 + i);
+		MojTestErrCheck(err);
+		MojRefCountedPtr<TestWatcher> watcher(new TestWatcher);
+		MojTestAssert(watcher.get());
+		MojDbCursor cursor;
+		err = db.find(query, cursor, watcher->m_slot);
+		MojTestErrCheck(err);
+		err = cursor.close();
+		MojTestErrCheck(err);
+		err = eqWatchers.push(watcher);
+		MojTestErrCheck(err);
+
+		MojDbQuery rangeQuery;
+		err = rangeQuery.from(_T("WatchTest:1"));
+		MojTestErrCheck(err);
+		err = rangeQuery.where(_T("foo"), MojDbQuery::OpGreaterThanEq, 1050);
+		MojTestErrCheck(err);
+		err = rangeQuery.where(_T("foo"), MojDbQuery::OpLessThan, 1051 + i);
+		MojTestErrCheck(err);
+		watcher.reset(new TestWatcher);
+		MojTestAssert(watcher.get());
+		err = db.find(rangeQuery, cursor, watcher->m_slot);
+		MojTestErrCheck(err);
+		err = cursor.close();
+		MojTestErrCheck(err);
+		err = rangeWatchers.push(watcher);
+		MojTestErrCheck(err);
+	}
+
+	// cancelled watches must drop out of the index
+	for (int i = 0; i < numWatchers; i += 2) {
+		eqWatchers.at(i)->m_slot.cancel();
+	}
+
+	MojObject id;
+	MojInt64 rev;
+	MojErr err = put(db, 1010, 1010, id, rev);
+	MojTestErrCheck(err);
+	err = put(db, 1011, 1011, id, rev);
+	MojTestErrCheck(err);
+	err = put(db, 1060, 1060, id, rev);
+	MojTestErrCheck(err);
+	for (int i = 0; i < numWatchers; ++i) {
+		int eqCount = eqWatchers.at(i)->m_count;
+		MojTestAssert(eqCount == ((i == 11) ? 1 : 0));
+		// 1060 falls in [1050, 1051 + i) once i >= 10
+		int rangeCount = rangeWatchers.at(i)->m_count;
+		MojTestAssert(rangeCount == ((i >= 10) ? 1 : 0));
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojDbWatchTest::txnTest(MojDb& db)
+{
+	MojDbQuery query;
+	MojErr err = query.from(_T("WatchTest:1"));
+	MojTestErrCheck(err);
+	err = query.where(_T("foo"), MojDbQuery::OpEq, 2000);
+	MojTestErrCheck(err);
+	MojRefCountedPtr<TestWatcher> watcher(new TestWatcher);
+	MojTestAssert(watcher.get());
+	MojDbCursor cursor;
+	err = db.find(query, cursor, watcher->m_slot);
+	MojTestErrCheck(err);
+	err = cursor.close();
+	MojTestErrCheck(err);
+
+	// a txn still open when another one commits doesn't fire the watch
+	MojDbReq req;
+	err = req.begin(&db, false);
+	MojTestErrCheck(err);
+	MojObject obj;
+	err = obj.putString(_T("_kind"), _T("WatchTest:1"));
+	MojTestErrCheck(err);
+	err = obj.put(_T("foo"), 2000);
+	MojTestErrCheck(err);
+	err = db.put(obj, MojDbFlagNone, req);
+	MojTestErrCheck(err);
+	MojObject id;
+	MojInt64 rev;
+	err = put(db, 2001, 2001, id, rev);
+	MojTestErrCheck(err);
+	MojTestAssert(watcher->m_count == 0);
+
+	// nor does it once aborted
+	err = req.abort();
+	MojTestErrCheck(err);
+	MojTestAssert(watcher->m_count == 0);
+	err = put(db, 2002, 2002, id, rev);
+	MojTestErrCheck(err);
+	MojTestAssert(watcher->m_count == 0);
+
+	err = put(db, 2000, 2000, id, rev);
+	MojTestErrCheck(err);
+	MojTestAssert(watcher->m_count == 1);
+
+	return MojErrNone;
+}
+
 MojErr MojDbWatchTest::pageTest(MojDb& db)
 {
 	MojObject id;
@@ -35,6 +35,8 @@ private:
 	MojErr cancelTest(MojDb& db);
 	MojErr rangeTest(MojDb& db);
 	MojErr pageTest(MojDb& db);
+	MojErr manyTest(MojDb& db);
+	MojErr txnTest(MojDb& db);
 	MojErr limitTest(MojDb& db);
 
 	MojErr put(MojDb& db, const MojObject& fooVal, const MojObject& barVal, MojObject& idOut, MojInt64& revOut);
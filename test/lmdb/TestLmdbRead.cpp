@@ -0,0 +1,91 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/****************************************************************
+*  @file TestLmdbRead.cpp
+****************************************************************/
+
+#include <cstdio>
+
+#include "TestLmdbRead.h"
+
+TEST_F(TestRead, sameResults) {
+	initDatabase();
+	MojSize copyCount = 0, zeroCount = 0;
+
+	zeroCopy(false);
+	MojUInt32 copySum = readAll(copyCount);
+	zeroCopy(true);
+	MojUInt32 zeroSum = readAll(zeroCount);
+
+	EXPECT_EQ(static_cast<MojSize>(RecordCount), copyCount);
+	EXPECT_EQ(copyCount, zeroCount);
+	EXPECT_EQ(copySum, zeroSum);
+}
+
+TEST_F(TestRead, writeTxnCopies) {
+	initDatabase();
+	zeroCopy(true);
+	MojDbLmdbTxn ttxn;
+	MojExpectNoErr(ttxn.begin(engine.get(), true));
+	EXPECT_FALSE(ttxn.zeroCopy());
+
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojExpectNoErr(database->get(MojObject((MojInt64) 7), &ttxn, false, item));
+	ASSERT_TRUE(item.get());
+	EXPECT_FALSE(static_cast<MojDbLmdbItem*>(item.get())->borrowed());
+	MojExpectNoErr(ttxn.abort());
+}
+
+TEST_F(TestRead, itemOutlivesTxn) {
+	initDatabase();
+	zeroCopy(true);
+	MojRefCountedPtr<MojDbStorageItem> item;
+	{
+		MojDbLmdbTxn ttxn;
+		MojExpectNoErr(ttxn.begin(engine.get(), false));
+		EXPECT_TRUE(ttxn.zeroCopy());
+		MojExpectNoErr(database->get(MojObject((MojInt64) 42), &ttxn, false, item));
+		ASSERT_TRUE(item.get());
+		EXPECT_TRUE(static_cast<MojDbLmdbItem*>(item.get())->borrowed());
+		MojExpectNoErr(ttxn.commit());
+	}
+	// the txn handed us our own copy when it ended
+	MojDbLmdbItem* lmdbItem = static_cast<MojDbLmdbItem*>(item.get());
+	EXPECT_FALSE(lmdbItem->borrowed());
+
+	MojObject obj;
+	MojExpectNoErr(lmdbItem->toObject(obj));
+	MojInt64 idx = -1;
+	EXPECT_TRUE(obj.get(_T("idx"), idx));
+	EXPECT_EQ(42, idx);
+}
+
+TEST_F(TestRead, benchmark) {
+	initDatabase();
+	const int passes = 20;
+	// warm the page cache so the first mode doesn't pay for it
+	(void) timeReads(false, 1);
+
+	double copyMs = timeReads(false, passes);
+	double zeroMs = timeReads(true, passes);
+
+	printf("lmdb read %d x %d records: copy %.2f ms, zero-copy %.2f ms\n",
+		passes, RecordCount, copyMs, zeroMs);
+	RecordProperty("copyMs", static_cast<int>(copyMs));
+	RecordProperty("zeroCopyMs", static_cast<int>(zeroMs));
+}
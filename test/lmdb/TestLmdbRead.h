@@ -0,0 +1,93 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/****************************************************************
+*  @file TestLmdbRead.h
+****************************************************************/
+
+#ifndef __TestLmdbRead_H__
+#define __TestLmdbRead_H__
+
+#include <chrono>
+
+#include "core/MojObjectSerialization.h"
+#include "engine/lmdb/MojDbLmdbCursor.h"
+#include "TestLmdb.h"
+
+struct TestRead: public TestLmdb
+{
+	static const int RecordCount = 2000;
+
+	void zeroCopy(bool enable)
+	{
+		MojObject modeConf = conf;
+		MojExpectNoErr(modeConf.put(_T("zeroCopyReads"), (MojInt64) (enable ? 1 : 0)));
+		MojExpectNoErr(env->configure(modeConf));
+	}
+
+	void initDatabase()
+	{
+		MojDbLmdbTxn ttxn;
+		MojExpectNoErr(ttxn.begin(engine.get(), true));
+		for (int i = 0; i < RecordCount; ++i) {
+			MojObject obj;
+			MojExpectNoErr(obj.put(_T("idx"), (MojInt64) i));
+			MojExpectNoErr(obj.putString(_T("text"), _T("the quick brown fox jumps over the lazy dog")));
+			MojObjectWriter writer;
+			MojExpectNoErr(obj.visit(writer));
+			MojExpectNoErr(database->put(MojObject((MojInt64) i), writer.buf(), &ttxn, true));
+		}
+		MojExpectNoErr(ttxn.commit());
+	}
+
+	// walks the whole database in one read txn and folds every value into a checksum
+	MojUInt32 readAll(MojSize& countOut)
+	{
+		MojUInt32 sum = 0;
+		countOut = 0;
+		MojDbLmdbTxn ttxn;
+		MojDbLmdbCursor cursor;
+		MojDbLmdbItem key, val;
+		bool found = false;
+		MojExpectNoErr(ttxn.begin(engine.get(), false));
+		MojExpectNoErr(cursor.open(database.get(), &ttxn));
+		MojExpectNoErr(cursor.get(key, val, found, MDB_FIRST));
+		while (found) {
+			MojObject obj;
+			MojExpectNoErr(val.toObject(obj));
+			sum = sum * 31 + (MojUInt32) obj.size() + (MojUInt32) val.size();
+			++countOut;
+			MojExpectNoErr(cursor.get(key, val, found, MDB_NEXT));
+		}
+		cursor.close();
+		MojExpectNoErr(ttxn.commit());
+		return sum;
+	}
+
+	double timeReads(bool enable, int passes)
+	{
+		zeroCopy(enable);
+		MojSize count = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < passes; ++i)
+			(void) readAll(count);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+};
+
+#endif
@@ -480,6 +480,46 @@ struct SearchComplexPrefix : public SearchBase
         }
 };
 
+// reads a page of records so per-record copy cost shows up next to the seek
+class FindScan
+{
+public:
+	static const MojUInt32 PageSize = 100;
+
+	MojErr init(MojDb* db)
+	{
+		MojErr err = m_query.from(_T("com.foo.bar:1"));
+		MojErrCheck(err);
+
+		m_query.limit(PageSize);
+
+		return MojErrNone;
+	}
+
+	MojErr run(MojDb* db) noexcept
+	{
+		bool found = false;
+		MojErr err;
+
+		MojDbCursor cursor;
+		err = db->find(m_query, cursor);
+		MojErrCheck(err);
+
+		for (;;) {
+			err = cursor.get(m_resultObj, found);
+			MojErrCheck(err);
+			if (!found)
+				break;
+		}
+
+		return MojErrNone;
+	}
+
+private:
+	MojObject m_resultObj;
+	MojDbQuery m_query;
+};
+
 static const Suite Suites[]
 {
 	std::make_tuple("getBegin",  [](MojDb* db, size_t threads, size_t trepeats, Durations* diffs) { return sampleThreadedAccumulate<GetBegin>    (db, threads, trepeats, diffs); }, RegexpAllDatabases),
@@ -503,5 +543,6 @@ static const Suite Suites[]
         std::make_tuple("SearchComplexEqualEqual",   [](MojDb* db, size_t threads, size_t trepeats, Durations* diffs) { return sampleThreadedAccumulate<SearchComplexEqualEqual>     (db, threads, trepeats, diffs); }, RegexpOnlyAllIndexDb),
         std::make_tuple("SearchComplexGreaterEqual",   [](MojDb* db, size_t threads, size_t trepeats, Durations* diffs) { return sampleThreadedAccumulate<SearchComplexGreaterEqual>     (db, threads, trepeats, diffs); }, RegexpOnlyAllIndexDb),
         std::make_tuple("SearchComplexLessEqual",   [](MojDb* db, size_t threads, size_t trepeats, Durations* diffs) { return sampleThreadedAccumulate<SearchComplexLessEqual>     (db, threads, trepeats, diffs); }, RegexpOnlyAllIndexDb),
-        std::make_tuple("SearchComplexPrefix",   [](MojDb* db, size_t threads, size_t trepeats, Durations* diffs) { return sampleThreadedAccumulate<SearchComplexPrefix>     (db, threads, trepeats, diffs); }, RegexpOnlyAllIndexDb)
+        std::make_tuple("SearchComplexPrefix",   [](MojDb* db, size_t threads, size_t trepeats, Durations* diffs) { return sampleThreadedAccumulate<SearchComplexPrefix>     (db, threads, trepeats, diffs); }, RegexpOnlyAllIndexDb),
+	std::make_tuple("findScan",  [](MojDb* db, size_t threads, size_t trepeats, Durations* diffs) { return sampleThreadedAccumulate<FindScan>    (db, threads, trepeats, diffs); }, RegexpAllDatabases)
 };
@@ -33,11 +33,22 @@
 
 namespace po = boost::program_options;
 
-MojErr metric_ProcessNObjects(const Suite& suite, const boost::filesystem::path& dbpath, size_t repeats, size_t sampleIterations, size_t threads, std::map<MojUInt32, Durations>* results)
+MojErr metric_ProcessNObjects(const Suite& suite, const boost::filesystem::path& dbpath, size_t repeats, size_t sampleIterations, size_t threads, bool zeroCopy, std::map<MojUInt32, Durations>* results)
 {
 	MojErr err;
 
 	std::unique_ptr<MojDb> db(new MojDb);
+
+	// engines that map their files can hand out reads without copying them
+	MojObject dbConf;
+	err = dbConf.put(_T("zeroCopyReads"), (MojInt64) (zeroCopy ? 1 : 0));
+	MojErrCheck(err);
+	MojObject conf;
+	err = conf.put(MojDb::ConfKey, dbConf);
+	MojErrCheck(err);
+	err = db->configure(conf);
+	MojErrCheck(err);
+
 	err = db->open(dbpath.c_str());
 	MojErrCheck(err);
 
@@ -83,6 +94,7 @@ int main (int argc, const char** argv)
 	size_t repeats;
 	size_t samples;
 	size_t clientCount;
+	bool zeroCopy = true;
 
 	// Declare the supported options.
 	po::options_description desc("Allowed options");
@@ -92,7 +104,8 @@ int main (int argc, const char** argv)
 	("report",  po::value<std::string>()->default_value("reports"),  "Path to report file (if not set, will print to stdout")
 	("repeats", po::value<size_t>()->default_value(100),             "How many repeats make in case of one sample")
 	("samples", po::value<size_t>()->default_value(1000),            "How many samples do (independent tests)")
-	("clientcount", po::value<size_t>()->default_value(1),      "No of  clients to database");
+	("clientcount", po::value<size_t>()->default_value(1),      "No of  clients to database")
+	("zerocopy", po::value<bool>()->default_value(true),          "Read records in place instead of copying them (reports get a -copy suffix when off)");
 
 	po::variables_map vm;
 	po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -131,6 +144,9 @@ int main (int argc, const char** argv)
 	if (vm.count("clientcount")) {
 		clientCount = vm["clientcount"].as<size_t>();
 	}
+	if (vm.count("zerocopy")) {
+		zeroCopy = vm["zerocopy"].as<bool>();
+	}
 
 	boost::filesystem::directory_iterator end;
 
@@ -158,11 +174,14 @@ int main (int argc, const char** argv)
 			{
 				for (boost::filesystem::directory_iterator dbsIter(suiteDirectoryName); dbsIter != end; ++dbsIter)
 				{
-					err = metric_ProcessNObjects(suite, *dbsIter, samples, repeats, nThreads, &times);
+					err = metric_ProcessNObjects(suite, *dbsIter, samples, repeats, nThreads, zeroCopy, &times);
 					MojErrCheck(err);
 				}
 				boost::filesystem::path reportPath;
-					err = getReportPath(reportsPath, std::get<0>(suite), suiteDirectoryName.filename().string(), &reportPath, std::to_string(nThreads));
+				std::string suiteName = std::get<0>(suite);
+				if (!zeroCopy)
+					suiteName += "-copy";
+				err = getReportPath(reportsPath, suiteName, suiteDirectoryName.filename().string(), &reportPath, std::to_string(nThreads));
 				MojErrCheck(err);
 
 				err = writeNumbers2Report(reportPath, times);
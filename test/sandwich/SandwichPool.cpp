@@ -15,7 +15,9 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <array>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include <leveldb/memory_db.hpp>
 #include <leveldb/txn_db.hpp>
@@ -28,6 +30,7 @@
 
 #include "engine/sandwich/pool.hpp"
 #include "engine/sandwich/MojDbSandwichItem.h"
+#include "engine/sandwich/MojDbSandwichEngine.h"
 
 using ::testing::PrintToString;
 
@@ -330,6 +333,63 @@ TEST_F(UnmountTest, unmount_shard_in_txn)
     EXPECT_EQ( "43", itemData() );
 }
 
+struct CompactTest : TestPath {};
+
+TEST_F(CompactTest, compact_step_covers_whole_shard)
+{
+    MojRefCountedPtr<MojDbStorageEngine> engine;
+    MojAssertNoErr( MojDbStorageEngine::createEngine("sandwich", engine) );
+    MojAssertNoErr( engine->configure({}) );
+    MojAssertNoErr( engine->open(test_path.c_str()) );
+    auto &sandwichEngine = static_cast<MojDbSandwichEngine &>(*engine);
+
+    mojo::Sandwich::Cookie foo, bar;
+    MojAssertNoErr( sandwichEngine.cook("foo", foo) );
+    MojAssertNoErr( sandwichEngine.cook("bar", bar) );
+    auto fooPart = mojo::use(sandwichEngine.impl(), foo);
+    auto barPart = mojo::use(sandwichEngine.impl(), bar);
+    for (std::string key : { "a", "b", "c", "d" })
+    {
+        ASSERT_OK( fooPart.Put(key, "foo-" + key) );
+        ASSERT_OK( barPart.Put(key, "bar-" + key) );
+    }
+
+    MojAssertNoErr( sandwichEngine.compactScheduler().configure(obj({
+        { MojDbCompactScheduler::IdleKey, MojObject(0) },
+        { MojDbCompactScheduler::ThresholdKey, MojObject(1) },
+    })) );
+    std::string fooId, barId;
+    MojDbSandwichEngine::partId(MojDbIdGenerator::MainShardId, foo, fooId);
+    MojDbSandwichEngine::partId(MojDbIdGenerator::MainShardId, bar, barId);
+    MojDbCompactScheduler::RangeMap ranges;
+    ranges[fooId].note("b", 1, 200, 0);
+    ranges[fooId].note("c", 1, 200, 0);
+    ranges[barId].note("a", 1, 100, 0);
+    sandwichEngine.compactScheduler().noteCommit(ranges);
+
+    // one step compacts the whole shard, the debt of bar goes with foo's
+    MojTime now;
+    MojAssertNoErr( MojGetCurrentTime(now) );
+    now += MojSecs(1);
+    bool ran = false;
+    MojAssertNoErr( sandwichEngine.compactScheduler().step(now, ran) );
+    EXPECT_TRUE( ran );
+
+    MojObject stats;
+    MojAssertNoErr( sandwichEngine.compactScheduler().stats(stats) );
+    MojInt64 val = 0;
+    EXPECT_TRUE( stats.get(_T("steps"), val) && val == 1 );
+    EXPECT_TRUE( stats.get(_T("errors"), val) && val == 0 );
+    EXPECT_TRUE( stats.get(_T("parts"), val) && val == 0 );
+
+    // and leaves both parts as they were
+    std::string v;
+    ASSERT_OK( fooPart.Get("c", v) );
+    EXPECT_EQ( "foo-c", v );
+    ASSERT_OK( barPart.Get("c", v) );
+    EXPECT_EQ( "bar-c", v );
+}
+
 struct SandwichTest : TestPath
 {
     MojDb db;